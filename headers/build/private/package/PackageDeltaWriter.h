@@ -0,0 +1 @@
+#include <../private/package/PackageDeltaWriter.h>
@@ -0,0 +1 @@
+#include <../private/package/hpkg/RepositoryIndex.h>
@@ -0,0 +1 @@
+#include <../private/shared/ThreadSpareBuffers.h>
@@ -0,0 +1 @@
+#include <../private/storage/sniffer/DisjList.h>
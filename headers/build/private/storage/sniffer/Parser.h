@@ -0,0 +1 @@
+#include <../private/storage/sniffer/Parser.h>
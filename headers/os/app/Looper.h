@@ -135,7 +135,7 @@ private:
 								bigtime_t timeout);
 			void			_InitData(const char* name, int32 priority, int32 capacity);
 			void			AddMessage(BMessage* msg);
-			void			_AddMessagePriv(BMessage* msg);
+			bool			_AddMessagePriv(BMessage* msg);
 	static	status_t		_task0_(void* arg);
 
 			void*			ReadRawFromPort(int32* code,
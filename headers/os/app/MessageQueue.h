@@ -16,7 +16,7 @@ class BMessageQueue {
 		BMessageQueue();
 		virtual ~BMessageQueue();
 
-		void AddMessage(BMessage* message);
+		bool AddMessage(BMessage* message);
 		void RemoveMessage(BMessage* message);
 
 		int32 CountMessages() const;
@@ -45,13 +45,21 @@ class BMessageQueue {
 			// this needs to be exported for R5 compatibility and should
 			// be dropped as soon as possible
 
+		void _CollectIncoming();
+
 	private:	
 		BMessage* fHead;
 		BMessage* fTail;
 		int32 fMessageCount;
 		mutable BLocker fLock;
+		union {
+			BMessage* fIncoming;
+				// messages that have been added without holding the lock,
+				// the most recent one first
+			uint32 _reservedIncoming[2];
+		};
 
-		uint32 _reserved[3];
+		uint32 _reserved[1];
 };
 
 #endif	// _MESSAGE_QUEUE_H
@@ -19,6 +19,8 @@ namespace BPrivate {
 }
 
 
+// Jobs ask for decisions from the worker threads of their request, so a
+// decision provider may be called by several threads at once.
 struct BDecisionProvider {
 	virtual						~BDecisionProvider();
 
@@ -84,6 +84,13 @@ private:
 			void				_SetTicketNumber(uint32 ticketNumber);
 			void				_ClearTicketNumber();
 
+								// the steps of Run(), allowing the job queue
+								// to execute jobs in worker threads while
+								// notifying the listeners in its own thread
+			status_t			_Start();
+			void				_Execute();
+			void				_Finish();
+
 private:
 			status_t			fInitStatus;
 			BString				fTitle;
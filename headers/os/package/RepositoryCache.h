@@ -8,6 +8,7 @@
 
 #include <Entry.h>
 #include <String.h>
+#include <StringList.h>
 
 #include <package/PackageInfoSet.h>
 #include <package/RepositoryInfo.h>
@@ -16,6 +17,13 @@
 namespace BPackageKit {
 
 
+namespace BHPKG {
+	namespace BPrivate {
+		class RepositoryIndex;
+	}
+}
+
+
 class BRepositoryCache {
 public:
 			typedef BPackageInfoSet::Iterator Iterator;
@@ -34,17 +42,36 @@ public:
 
 			uint32				CountPackages() const;
 			Iterator			GetIterator() const;
+			status_t			GetIterator(Iterator& _iterator) const;
+
+			bool				HasIndex() const;
+			status_t			GetPackagesProviding(
+									const BString& resolvableName,
+									BStringList& _packageNames) const;
+			status_t			GetPackagesRequiring(
+									const BString& resolvableName,
+									BStringList& _packageNames) const;
 
 private:
 			struct RepositoryContentHandler;
 			struct StandardErrorOutput;
 
+			typedef BHPKG::BPrivate::RepositoryIndex RepositoryIndex;
+
+private:
+								BRepositoryCache(const BRepositoryCache&);
+			BRepositoryCache&	operator=(const BRepositoryCache&);
+
+			status_t			_LoadPackages() const;
+
 private:
 			BEntry				fEntry;
 			BRepositoryInfo		fInfo;
 			bool				fIsUserSpecific;
 
-			BPackageInfoSet		fPackages;
+			RepositoryIndex*	fIndex;
+	mutable	BPackageInfoSet		fPackages;
+	mutable	bool				fPackagesLoaded;
 };
 
 
@@ -31,6 +31,8 @@ public:
 	virtual	status_t			CreateInitialJobs() = 0;
 
 			BJob*				PopRunnableJob();
+			status_t			Process(int32 maxParallelJobs = 0);
+									// runs all jobs, 0 means one job per CPU
 
 protected:
 			status_t			QueueJob(BJob* job);
@@ -166,6 +166,9 @@ enum {
 		// when updating a pre-existing entry, don't fail, but replace the
 		// entry, if possible (directories will be merged, but won't replace a
 		// non-directory)
+	B_HPKG_WRITER_TOC_INDEX			= 0x04,
+		// add a TOC index, allowing readers to access the TOC entries of
+		// a directory without reading the complete TOC
 };
 
 
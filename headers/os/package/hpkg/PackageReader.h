@@ -36,6 +36,12 @@ public:
 									BPackageContentHandler* contentHandler);
 			status_t			ParseContent(BLowLevelPackageContentHandler*
 										contentHandler);
+			status_t			ParseContent(
+									BPackageContentHandler* contentHandler,
+									const char* subPath);
+									// Parses (at least) the entries in the
+									// given subdirectory. Uses the package's
+									// TOC index, if available.
 
 			int					PackageFileFD();
 private:
@@ -11,6 +11,10 @@
 
 namespace BPackageKit {
 
+
+class BRepositoryInfo;
+
+
 namespace BHPKG {
 
 
@@ -29,6 +33,8 @@ public:
 								~BRepositoryReader();
 
 			status_t			Init(const char* fileName);
+			status_t			GetRepositoryInfo(
+									BRepositoryInfo* _repositoryInfo) const;
 			status_t			ParseContent(
 									BRepositoryContentHandler* contentHandler);
 
@@ -45,10 +45,14 @@ class BFile : public BNode, public BPositionIO {
 
 		BFile &operator=(const BFile &file);
 
+		virtual ssize_t ReadAtV(off_t location, const iovec *vecs,
+			size_t count);
+		virtual ssize_t WriteAtV(off_t location, const iovec *vecs,
+			size_t count);
+		virtual status_t ReadAtAsync(off_t location, void *buffer,
+			size_t size, io_completion_hook hook, void *cookie);
+
 	private:
-		virtual void _PhiloFile1();
-		virtual void _PhiloFile2();
-		virtual void _PhiloFile3();
 		virtual void _PhiloFile4();
 		virtual void _PhiloFile5();
 		virtual void _PhiloFile6();
@@ -28,6 +28,8 @@ public:
 	// BDataIO interface
 	virtual	ssize_t				Read(void* buffer, size_t size);
 	virtual	ssize_t				Write(const void* buffer, size_t size);
+	virtual	status_t			ReadAsync(void* buffer, size_t size,
+									io_completion_hook hook, void* cookie);
 
 private:
 								BBufferedDataIO(const BBufferedDataIO& other);
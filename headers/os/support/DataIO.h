@@ -9,6 +9,11 @@
 #include <SupportDefs.h>
 
 
+struct iovec;
+
+typedef void (*io_completion_hook)(void* cookie, ssize_t result);
+
+
 class BDataIO {
 public:
 								BDataIO();
@@ -17,11 +22,13 @@ public:
 	virtual	ssize_t				Read(void* buffer, size_t size) = 0;
 	virtual	ssize_t				Write(const void* buffer, size_t size) = 0;
 
+	virtual	status_t			ReadAsync(void* buffer, size_t size,
+									io_completion_hook hook, void* cookie);
+
 private:
 								BDataIO(const BDataIO&);
 			BDataIO&			operator=(const BDataIO&);
 
-	virtual	void				_ReservedDataIO1();
 	virtual	void				_ReservedDataIO2();
 	virtual	void				_ReservedDataIO3();
 	virtual	void				_ReservedDataIO4();
@@ -60,10 +67,15 @@ public:
 	virtual	status_t			SetSize(off_t size);
 	virtual	status_t			GetSize(off_t* size) const;
 
+	virtual	ssize_t				ReadAtV(off_t position, const iovec* vecs,
+									size_t count);
+	virtual	ssize_t				WriteAtV(off_t position, const iovec* vecs,
+									size_t count);
+	virtual	status_t			ReadAtAsync(off_t position, void* buffer,
+									size_t size, io_completion_hook hook,
+									void* cookie);
+
 private:
-	virtual	void				_ReservedPositionIO2();
-	virtual	void				_ReservedPositionIO3();
-	virtual	void				_ReservedPositionIO4();
 	virtual	void				_ReservedPositionIO5();
 	virtual	void				_ReservedPositionIO6();
 	virtual	void				_ReservedPositionIO7();
@@ -89,6 +101,11 @@ public:
 	virtual	ssize_t				WriteAt(off_t position, const void* buffer,
 									size_t size);
 
+	virtual	ssize_t				ReadAtV(off_t position, const iovec* vecs,
+									size_t count);
+	virtual	ssize_t				WriteAtV(off_t position, const iovec* vecs,
+									size_t count);
+
 	virtual	off_t				Seek(off_t position, uint32 seekMode);
 	virtual off_t				Position() const;
 
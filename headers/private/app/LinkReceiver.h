@@ -21,6 +21,8 @@ class BRegion;
 
 namespace BPrivate {
 
+class LinkRing;
+
 class LinkReceiver {
 	public:
 		LinkReceiver(port_id port);
@@ -29,8 +31,11 @@ class LinkReceiver {
 		void SetPort(port_id port);
 		port_id	Port(void) const { return fReceivePort; }
 
+		area_id CreateRing(const char* name);
+
 		status_t GetNextMessage(int32& code, bigtime_t timeout = B_INFINITE_TIMEOUT);
 		bool HasMessages() const;
+		bool HasBufferedMessages() const;
 		bool NeedsReply() const;
 		int32 Code() const;
 
@@ -47,6 +52,8 @@ class LinkReceiver {
 	protected:
 		virtual status_t ReadFromPort(bigtime_t timeout);
 		virtual status_t AdjustReplyBuffer(bigtime_t timeout);
+		status_t ReadFromRing();
+		void SetRing(LinkRing* ring);
 		void ResetBuffer();
 
 		port_id fReceivePort;
@@ -60,6 +67,9 @@ class LinkReceiver {
 		int32	fReplySize;	//size of current reply message
 
 		status_t fReadError;	//Read failed for current message
+
+		LinkRing* fRing;
+		int32	fPendingPortMessages;	//overflow messages to read from the port
 };
 
 }	// namespace BPrivate
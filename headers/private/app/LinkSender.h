@@ -15,7 +15,9 @@
 
 
 namespace BPrivate {
-	
+
+class LinkRing;
+
 class LinkSender {
 	public:
 		LinkSender(port_id sendport);
@@ -24,6 +26,8 @@ class LinkSender {
 		void SetPort(port_id port);
 		port_id	Port() const { return fPort; }
 
+		status_t SetRing(area_id area);
+
 		team_id TargetTeam() const;
 		void SetTargetTeam(team_id team);
 
@@ -33,6 +37,13 @@ class LinkSender {
 
 		status_t Flush(bigtime_t timeout = B_INFINITE_TIMEOUT, bool needsReply = false);
 
+		// while batching, messages are only sent when flushed explicitly,
+		// or when the buffer reached its maximum size
+		void SetBatching(bool batching) { fBatching = batching; }
+		bool IsBatching() const { return fBatching; }
+
+		static void GetStatistics(int32* _flushCount, int32* _replyCount);
+
 		status_t Attach(const void *data, size_t size);
 		status_t AttachString(const char *string, int32 maxLength = -1);
 		template <class Type> status_t Attach(const Type& data)
@@ -46,6 +57,11 @@ class LinkSender {
 
 		status_t AdjustBuffer(size_t newBufferSize, char **_oldBuffer = NULL);
 		status_t FlushCompleted(size_t newBufferSize);
+		status_t GrowBuffer(size_t minSize);
+
+		status_t WriteToPort(int32 code, const void* buffer, size_t size,
+			bigtime_t timeout);
+		status_t WriteToRing(bigtime_t timeout);
 
 		port_id	fPort;
 		team_id fTargetTeam;
@@ -57,6 +73,8 @@ class LinkSender {
 		uint32	fCurrentStart;		// start of current message
 
 		status_t fCurrentStatus;
+		bool	fBatching;
+		LinkRing* fRing;
 };
 
 
@@ -17,6 +17,8 @@
 #define MESSAGE_BODY_HASH_TABLE_SIZE	5
 #define MAX_DATA_PREALLOCATION			B_PAGE_SIZE * 10
 #define MAX_FIELD_PREALLOCATION			50
+#define MIN_DATA_PREALLOCATION			128
+#define MIN_FIELD_PREALLOCATION			4
 
 
 static const int32 kPortMessageCode = 'pjpp';
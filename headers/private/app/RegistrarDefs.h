@@ -67,6 +67,7 @@ enum {
 	B_REG_CLEAR_RECENT_APPS					= 'rgxa',
 	B_REG_LOAD_RECENT_LISTS					= 'rglr',
 	B_REG_SAVE_RECENT_LISTS					= 'rgsr',
+	B_REG_FIND_APP							= 'rgfa',
 
 	// MIME requests
 	B_REG_MIME_SET_PARAM					= 'rgsp',
@@ -83,6 +84,7 @@ enum {
 	B_REG_MIME_UPDATE_MIME_INFO				= 'rgup',
 	B_REG_MIME_CREATE_APP_META_MIME			= 'rgca',
 	B_REG_MIME_UPDATE_THREAD_FINISHED		= 'rgtf',
+	B_REG_MIME_UPDATE_PROGRESS				= 'rgpu',
 
 	// message runner requests
 	B_REG_REGISTER_MESSAGE_RUNNER			= 'rgrr',
@@ -94,6 +96,7 @@ enum {
 	B_REG_ROSTER_SANITY_EVENT				= 'rgir',
 	B_REG_SHUTDOWN_FINISHED					= 'rgsf',
 	B_REG_ROSTER_DEVICE_RESCAN				= 'rgrs',
+	B_REG_MIME_UPDATE_SNAPSHOT				= 'rgdu',
 
 	// clipboard handler requests
 	B_REG_ADD_CLIPBOARD						= 'rgCa',
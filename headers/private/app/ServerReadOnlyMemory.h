@@ -17,6 +17,8 @@ static const int32 kNumColors = 32;
 
 struct server_read_only_memory {
 	rgb_color	colors[kNumColors];
+	int32		font_metrics_revision;
+		// changed whenever string widths might have changed
 };
 
 
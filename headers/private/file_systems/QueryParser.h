@@ -241,6 +241,8 @@ public:
 			status_t	ParseQuotedString(char** _start, char** _end);
 			char*		CopyString(char* start, char* end);
 
+			const char*	Attribute() const { return fAttribute; }
+
 	virtual	status_t	Match(Entry* entry, Node* node,
 							const char* attribute = NULL, int32 type = 0,
 							const uint8* key = NULL, size_t size = 0);
@@ -0,0 +1,33 @@
+/*
+ * Copyright 2011, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _PACKAGE_FS_IOCTL_H
+#define _PACKAGE_FS_IOCTL_H
+
+
+#include <Drivers.h>
+
+
+#define PACKAGE_FS_IOCTL_BASE	(B_DEVICE_OP_CODES_END + 20001)
+
+enum {
+	PACKAGE_FS_IOCTL_GET_MEMORY_USAGE	= PACKAGE_FS_IOCTL_BASE,
+		// packagefs_memory_usage*
+};
+
+
+struct packagefs_memory_usage {
+	uint32	package_count;
+	uint32	toc_entry_count;				// entries in the packages' TOC
+											// indices
+	uint64	toc_size;						// bytes used by the TOC indices
+	uint32	package_node_count;				// package nodes created so far
+	uint32	package_node_attribute_count;	// their attributes
+	uint64	package_nodes_size;				// bytes used by package nodes and
+											// attributes (estimated)
+	uint32	node_count;						// nodes of the volume
+};
+
+
+#endif	// _PACKAGE_FS_IOCTL_H
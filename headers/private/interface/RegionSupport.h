@@ -104,6 +104,9 @@ class BRegion::Support {
 	static	int					miSubtractNonO1(BRegion* pReg,
 									clipping_rect* r, clipping_rect* rEnd,
 									int top, int bottom);
+	static	clipping_rect*		miCopyBands(BRegion* pReg,
+									clipping_rect* r, clipping_rect* rEnd,
+									int limit);
 
 
 
@@ -0,0 +1,47 @@
+/*
+ * Copyright 2011, Haiku, Inc.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _PACKAGE__PRIVATE__APPLY_PACKAGE_DELTA_JOB_H_
+#define _PACKAGE__PRIVATE__APPLY_PACKAGE_DELTA_JOB_H_
+
+
+#include <Entry.h>
+#include <String.h>
+
+#include <package/Job.h>
+
+
+namespace BPackageKit {
+
+namespace BPrivate {
+
+
+class ApplyPackageDeltaJob : public BJob {
+	typedef	BJob				inherited;
+
+public:
+								ApplyPackageDeltaJob(const BContext& context,
+									const BString& title,
+									const BEntry& oldPackageEntry,
+									const BEntry& deltaEntry,
+									const BEntry& targetEntry);
+	virtual						~ApplyPackageDeltaJob();
+
+protected:
+	virtual	status_t			Execute();
+	virtual	void				Cleanup(status_t jobResult);
+
+private:
+			BEntry				fOldPackageEntry;
+			BEntry				fDeltaEntry;
+			BEntry				fTargetEntry;
+};
+
+
+}	// namespace BPrivate
+
+}	// namespace BPackageKit
+
+
+#endif // _PACKAGE__PRIVATE__APPLY_PACKAGE_DELTA_JOB_H_
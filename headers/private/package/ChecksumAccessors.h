@@ -49,6 +49,28 @@ private:
 };
 
 
+class PackageDeltaChecksumAccessor : public ChecksumAccessor {
+public:
+								PackageDeltaChecksumAccessor(
+									const BEntry& deltaFileEntry,
+									bool newPackage);
+									// newPackage: the checksum of the package
+									// the delta produces, otherwise the one
+									// of the package it applies to
+
+	virtual	status_t			GetChecksum(BString& checksum) const;
+
+private:
+			BEntry				fDeltaFileEntry;
+			bool				fNewPackage;
+};
+
+
+status_t	checksum_to_string(const uint8* checksum, size_t size,
+				BString& string);
+				// lower case hex digits, as used in checksum files
+
+
 }	// namespace BPrivate
 
 }	// namespace BPackageKit
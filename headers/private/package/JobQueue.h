@@ -7,6 +7,7 @@
 
 
 #include <Locker.h>
+#include <OS.h>
 #include <SupportDefs.h>
 
 #include <package/Job.h>
@@ -32,20 +33,29 @@ public:
 			BJob*				Pop();
 									// caller owns job
 
+			status_t			RunJobs(int32 maxParallelJobs = 0);
+									// runs and deletes all jobs, 0 means
+									// one job per CPU
+
 			void				Close();
 
 private:
 								// BJobStateListener
 	virtual	void				JobSucceeded(BJob* job);
 	virtual	void				JobFailed(BJob* job);
+	virtual	void				JobAborted(BJob* job);
 
 private:
 			struct JobPriorityLess;
 			class JobPriorityQueue;
+			class WorkerPool;
 
 private:
 			status_t			_Init();
 
+			void				_CancelJobs(WorkerPool& workers);
+			BJob*				_PopRunnableJob();
+
 			void				_RequeueDependantJobsOf(BJob* job);
 			void				_RemoveDependantJobsOf(BJob* job);
 
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2011, Haiku, Inc.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _PACKAGE__PRIVATE__PACKAGE_DELTA_READER_H_
+#define _PACKAGE__PRIVATE__PACKAGE_DELTA_READER_H_
+
+
+#include <String.h>
+#include <SupportDefs.h>
+
+
+namespace BPackageKit {
+
+namespace BHPKG {
+	namespace BPrivate {
+		struct hpkg_delta_command;
+	}
+}
+
+
+namespace BPrivate {
+
+
+class PackageDeltaReader {
+public:
+								PackageDeltaReader();
+								~PackageDeltaReader();
+
+			status_t			Init(const char* fileName);
+			status_t			Init(int fd, bool keepFD);
+
+			uint64				OldPackageSize() const
+									{ return fOldPackageSize; }
+			uint64				NewPackageSize() const
+									{ return fNewPackageSize; }
+			status_t			GetOldPackageChecksum(BString& checksum) const;
+			status_t			GetNewPackageChecksum(BString& checksum) const;
+
+			status_t			Apply(int oldPackageFD, int targetFD);
+									// writes the new package to targetFD
+
+private:
+			status_t			_Init(int fd, bool keepFD);
+			status_t			_Copy(int sourceFD, off_t sourceOffset,
+									int targetFD, off_t targetOffset,
+									uint64 size, uint8* buffer);
+
+private:
+			int					fFD;
+			bool				fOwnsFD;
+			uint64				fOldPackageSize;
+			uint64				fNewPackageSize;
+			uint8				fOldPackageChecksum[32];
+			uint8				fNewPackageChecksum[32];
+			BHPKG::BPrivate::hpkg_delta_command* fCommands;
+			uint32				fCommandCount;
+			status_t			fInitStatus;
+};
+
+
+}	// namespace BPrivate
+
+}	// namespace BPackageKit
+
+
+#endif // _PACKAGE__PRIVATE__PACKAGE_DELTA_READER_H_
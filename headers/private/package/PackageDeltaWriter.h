@@ -0,0 +1,93 @@
+/*
+ * Copyright 2011, Haiku, Inc.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _PACKAGE__PRIVATE__PACKAGE_DELTA_WRITER_H_
+#define _PACKAGE__PRIVATE__PACKAGE_DELTA_WRITER_H_
+
+
+#include <Array.h>
+#include <SupportDefs.h>
+
+
+namespace BPackageKit {
+
+namespace BHPKG {
+	class BErrorOutput;
+}
+
+
+namespace BPrivate {
+
+
+class PackageDeltaWriter {
+public:
+								PackageDeltaWriter(
+									BHPKG::BErrorOutput* errorOutput);
+								~PackageDeltaWriter();
+
+			status_t			Write(const char* oldPackageFileName,
+									const char* newPackageFileName,
+									const char* deltaFileName);
+
+			uint64				CopiedSize() const	{ return fCopiedSize; }
+			uint64				DataSize() const	{ return fDataSize; }
+
+private:
+			struct Segment {
+				uint64			offset;
+				uint64			size;
+				uint64			hash;
+			};
+
+			struct Command {
+				uint32			type;
+				uint64			offset;
+				uint64			size;
+			};
+
+private:
+			struct SegmentCollector;
+			struct SegmentHashLess;
+			struct SegmentOffsetLess;
+
+private:
+			status_t			_CollectSegments(const char* fileName, int fd,
+									Array<Segment>& segments);
+			status_t			_HashSegments(int fd,
+									Array<Segment>& segments);
+			status_t			_CreateCommands(int oldFD, int newFD,
+									off_t newSize);
+			const Segment*		_FindMatchingSegment(int oldFD,
+									const Segment& segment,
+									const uint8* data);
+			status_t			_AddCommand(uint32 type, uint64 offset,
+									uint64 size);
+			status_t			_WriteDelta(int oldFD, int newFD,
+									off_t oldSize, off_t newSize,
+									int deltaFD);
+			status_t			_ComputeChecksum(int fd, off_t size,
+									uint8* checksum);
+			status_t			_Read(int fd, off_t offset, void* buffer,
+									size_t size);
+			status_t			_Write(int fd, off_t offset,
+									const void* buffer, size_t size);
+
+private:
+			BHPKG::BErrorOutput* fErrorOutput;
+			Array<Segment>		fOldSegments;
+			Array<Segment>		fNewSegments;
+			Array<Command>		fCommands;
+			uint8*				fBuffer;
+			uint8*				fCompareBuffer;
+			uint64				fCopiedSize;
+			uint64				fDataSize;
+};
+
+
+}	// namespace BPrivate
+
+}	// namespace BPackageKit
+
+
+#endif // _PACKAGE__PRIVATE__PACKAGE_DELTA_WRITER_H_
@@ -41,6 +41,55 @@ struct hpkg_header {
 };
 
 
+// optional TOC index header extension
+// If the header size of a package file is big enough to contain it, the
+// hpkg_header is immediately followed by this structure. It describes a TOC
+// index section, which is located at the end of the heap (i.e. readers not
+// aware of it simply consider it part of the heap). The section consists of
+// an array of hpkg_toc_index_block structures, followed by an array of
+// hpkg_toc_index_directory structures (sorted by path), followed by the
+// null-terminated paths of the directories.
+struct hpkg_toc_index_header {
+	uint32	magic;							// "hpti"
+	uint16	version;
+	uint16	reserved;
+	uint64	offset;							// file offset of the section
+	uint32	block_count;
+	uint32	directory_count;
+	uint32	paths_length;
+	uint32	reserved2;
+};
+
+
+// A block of the TOC section. For a zlib compressed TOC the compressor's state
+// is flushed at the start of each block, so that the stream can be decoded
+// starting at any block (as raw deflate stream, save for the first one).
+struct hpkg_toc_index_block {
+	uint64	uncompressed_offset;			// relative to TOC start
+	uint64	compressed_offset;				// relative to TOC start
+};
+
+
+// A directory entry in the TOC. The offsets refer to the uncompressed TOC and
+// delimit the complete attribute subtree of the entry.
+struct hpkg_toc_index_directory {
+	uint64	toc_offset;
+	uint64	toc_end_offset;
+	uint32	path_offset;					// relative to the paths start
+	uint32	reserved;
+};
+
+
+enum {
+	B_HPKG_TOC_INDEX_MAGIC		= 'hpti',
+	B_HPKG_TOC_INDEX_VERSION	= 1
+};
+
+
+// uncompressed size after which the TOC compressor's state is flushed
+static const size_t kHPKGTOCIndexBlockSize = 64 * 1024;
+
+
 // header
 struct hpkg_repo_header {
 	uint32	magic;							// "hpkr"
@@ -62,6 +111,103 @@ struct hpkg_repo_header {
 };
 
 
+// repository index header
+// Optionally follows hpkg_repo_header (included in its header_size). It
+// refers to an uncompressed section located between the headers and the
+// repository info section, which allows looking up packages and resolvables
+// in a mapped repository file without parsing the package attributes section.
+// The section contains the package, provides, and requires tables, each sorted
+// by name, followed by the strings all names and versions refer to. All
+// values are big endian, strings are referred to by their offset in the
+// strings table (which starts with an empty string).
+struct hpkg_repo_index_header {
+	uint64	index_offset;
+	uint64	index_length;
+	uint32	package_count;
+	uint32	provides_count;
+	uint32	requires_count;
+	uint32	strings_length;
+};
+
+
+struct hpkg_repo_index_version {
+	uint32	major;
+	uint32	minor;
+	uint32	micro;
+	uint32	pre_release;
+	uint32	release;
+};
+
+
+struct hpkg_repo_index_package {
+	uint32	name;
+	uint32	checksum;
+	uint32	architecture;
+	hpkg_repo_index_version	version;
+};
+
+
+struct hpkg_repo_index_provides {
+	uint32	name;
+	uint32	package;						// index in the package table
+	uint32	type;
+	hpkg_repo_index_version	version;
+	hpkg_repo_index_version	compatible_version;
+};
+
+
+struct hpkg_repo_index_requires {
+	uint32	name;
+	uint32	package;						// index in the package table
+	uint32	op;
+	hpkg_repo_index_version	version;
+};
+
+
+// delta package file header
+// A delta package describes how to reconstruct a package file from another
+// one. The header is followed by an array of hpkg_delta_command structures,
+// which in turn is followed by the data the commands refer to. Executing the
+// commands in order yields the complete new package file.
+struct hpkg_delta_header {
+	uint32	magic;							// "hpkd"
+	uint16	header_size;
+	uint16	version;
+	uint64	total_size;
+
+	// the package the delta applies to and the one it produces
+	uint64	old_package_size;
+	uint64	new_package_size;
+	uint8	old_package_checksum[32];		// SHA256
+	uint8	new_package_checksum[32];		// SHA256
+
+	uint32	command_count;
+	uint32	reserved;
+};
+
+
+struct hpkg_delta_command {
+	uint32	type;
+	uint32	reserved;
+	uint64	offset;							// copy: offset in old package
+											// data: offset in delta file
+	uint64	size;
+};
+
+
+enum {
+	B_HPKG_DELTA_MAGIC			= 'hpkd',
+	B_HPKG_DELTA_VERSION		= 1
+};
+
+
+// delta command types
+enum {
+	B_HPKG_DELTA_COMMAND_COPY	= 0,	// copy range from the old package
+	B_HPKG_DELTA_COMMAND_DATA	= 1		// copy range from the delta file
+};
+
+
 // attribute tag arithmetics
 // (using 6 bits for id, 3 for type, 1 for hasChildren and 2 for encoding)
 #define HPKG_ATTRIBUTE_TAG_COMPOSE(id, type, encoding, hasChildren) 	\
@@ -22,6 +22,10 @@ class BPackageEntryAttribute;
 namespace BPrivate {
 
 
+struct hpkg_toc_index_block;
+struct hpkg_toc_index_directory;
+
+
 class PackageReaderImpl : public ReaderImplBase {
 	typedef	ReaderImplBase		inherited;
 public:
@@ -35,9 +39,14 @@ public:
 									BPackageContentHandler* contentHandler);
 			status_t			ParseContent(BLowLevelPackageContentHandler*
 										contentHandler);
+			status_t			ParseContent(
+									BPackageContentHandler* contentHandler,
+									const char* subPath);
 
 			int					PackageFileFD() const;
 
+			bool				HasTOCIndex() const;
+
 			uint64				HeapOffset() const;
 			uint64				HeapSize() const;
 
@@ -53,8 +62,20 @@ private:
 			struct RootAttributeHandler;
 
 private:
+			status_t			_ReadTOC();
+			status_t			_ReadTOCIndex();
+			status_t			_ReadTOCRange(uint64 offset, size_t size,
+									uint8* buffer);
+			const hpkg_toc_index_directory* _FindTOCIndexDirectory(
+									const char* path, size_t length) const;
+
 			status_t			_ParseTOC(AttributeHandlerContext* context,
-									AttributeHandler* rootAttributeHandler);
+									AttributeHandler* rootAttributeHandler,
+									SectionInfo& section);
+			status_t			_ParseTOCSubtree(
+									AttributeHandlerContext* context,
+									SectionInfo& section, char* ancestorPath,
+									BPackageEntry* parentEntry);
 
 			status_t			_GetTOCBuffer(size_t size,
 									const void*& _buffer);
@@ -64,6 +85,15 @@ private:
 			uint64				fHeapSize;
 
 			SectionInfo			fTOCSection;
+			bool				fTOCRead;
+
+			uint64				fTOCIndexOffset;
+			hpkg_toc_index_block* fTOCIndexBlocks;
+			uint32				fTOCIndexBlockCount;
+			hpkg_toc_index_directory* fTOCIndexDirectories;
+			uint32				fTOCIndexDirectoryCount;
+			char*				fTOCIndexPaths;
+			uint32				fTOCIndexPathsLength;
 };
 
 
@@ -74,6 +104,13 @@ PackageReaderImpl::PackageFileFD() const
 }
 
 
+inline bool
+PackageReaderImpl::HasTOCIndex() const
+{
+	return fTOCIndexOffset != 0;
+}
+
+
 inline uint64
 PackageReaderImpl::HeapOffset() const
 {
@@ -10,6 +10,7 @@
 #include <util/DoublyLinkedList.h>
 #include <util/OpenHashTable.h>
 
+#include <Array.h>
 #include <String.h>
 
 #include <package/hpkg/PackageWriter.h>
@@ -56,6 +57,18 @@ private:
 			struct Entry;
 			struct SubPathAdder;
 			struct HeapAttributeOffsetter;
+			struct TOCIndexDirectoryLess;
+
+			struct TOCIndexBlock {
+				uint64			uncompressedOffset;
+				uint64			compressedOffset;
+			};
+
+			struct TOCIndexDirectory {
+				uint64			tocOffset;
+				uint64			tocEndOffset;
+				uint32			pathOffset;
+			};
 
 			typedef DoublyLinkedList<Entry> EntryList;
 
@@ -95,6 +108,11 @@ private:
 									uint64& _mainSize);
 			void				_WriteAttributeChildren(Attribute* attribute);
 
+			bool				_HasTOCIndexSpace() const;
+			void				_AddTOCIndexBlock();
+			void				_WriteTOCIndex(off_t tocStartOffset,
+									off_t tocEndOffset);
+
 			void				_WritePackageAttributes(hpkg_header& header);
 			uint32				_WritePackageAttributesCompressed(
 									uint32& _stringsLengthUncompressed,
@@ -153,6 +171,17 @@ private:
 			BPackageInfo		fPackageInfo;
 			BString				fInstallPath;
 			bool				fCheckLicenses;
+
+			// TOC index
+			bool				fWriteTOCIndex;
+			off_t				fTOCIndexOffset;
+			AbstractDataWriter*	fTOCIndexFileWriter;
+			ZlibDataWriter*		fTOCIndexZlibWriter;
+			uint64				fTOCIndexNextBlockOffset;
+			Array<TOCIndexBlock> fTOCIndexBlocks;
+			Array<TOCIndexDirectory> fTOCIndexDirectories;
+			Array<char>			fTOCIndexPaths;
+			BString				fTOCIndexPath;
 };
 
 
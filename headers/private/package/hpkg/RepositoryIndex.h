@@ -0,0 +1,95 @@
+/*
+ * Copyright 2011, Haiku, Inc.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _PACKAGE__HPKG__PRIVATE__REPOSITORY_INDEX_H_
+#define _PACKAGE__HPKG__PRIVATE__REPOSITORY_INDEX_H_
+
+
+#include <package/PackageArchitecture.h>
+#include <package/PackageResolvable.h>
+#include <package/PackageResolvableExpression.h>
+#include <package/PackageVersion.h>
+
+
+namespace BPackageKit {
+
+namespace BHPKG {
+
+namespace BPrivate {
+
+
+struct hpkg_repo_index_package;
+struct hpkg_repo_index_provides;
+struct hpkg_repo_index_requires;
+struct hpkg_repo_index_version;
+
+
+/*!	Provides access to the index of a repository file (cf.
+	hpkg_repo_index_header). The file is mapped, so no more than the entries
+	actually looked at are ever read.
+*/
+class RepositoryIndex {
+public:
+								RepositoryIndex();
+								~RepositoryIndex();
+
+			status_t			Init(const char* fileName);
+									// B_ENTRY_NOT_FOUND, if the repository
+									// file has no index
+
+			uint32				CountPackages() const
+									{ return fPackageCount; }
+			int32				FindPackage(const char* name) const;
+									// returns the package index or -1
+			const char*			PackageNameAt(uint32 index) const;
+			const char*			PackageChecksumAt(uint32 index) const;
+			BPackageArchitecture PackageArchitectureAt(uint32 index) const;
+			void				GetPackageVersionAt(uint32 index,
+									BPackageVersion& _version) const;
+
+			uint32				FindProvides(const char* name,
+									uint32& _count) const;
+									// returns the index of the first of the
+									// _count provides entries with the name
+			status_t			GetProvidesAt(uint32 index,
+									BPackageResolvable& _resolvable,
+									uint32& _packageIndex) const;
+
+			uint32				FindRequires(const char* name,
+									uint32& _count) const;
+			status_t			GetRequiresAt(uint32 index,
+									BPackageResolvableExpression& _expression,
+									uint32& _packageIndex) const;
+
+private:
+			template<typename Entry>
+			uint32				_FindRange(const Entry* entries, uint32 count,
+									const char* name, uint32& _count) const;
+			const char*			_StringAt(uint32 offset) const;
+			void				_GetVersion(
+									const hpkg_repo_index_version& indexVersion,
+									BPackageVersion& _version) const;
+
+private:
+			void*				fMappedAddress;
+			size_t				fMappedSize;
+			const hpkg_repo_index_package* fPackages;
+			const hpkg_repo_index_provides* fProvides;
+			const hpkg_repo_index_requires* fRequires;
+			const char*			fStrings;
+			uint32				fPackageCount;
+			uint32				fProvidesCount;
+			uint32				fRequiresCount;
+			uint32				fStringsLength;
+};
+
+
+}	// namespace BPrivate
+
+}	// namespace BHPKG
+
+}	// namespace BPackageKit
+
+
+#endif	// _PACKAGE__HPKG__PRIVATE__REPOSITORY_INDEX_H_
@@ -41,6 +41,9 @@ public:
 private:
 			struct RootAttributeHandler;
 
+private:
+			status_t			_ReadPackageAttributesSection();
+
 private:
 			SectionInfo			fRepositoryInfoSection;
 			BRepositoryInfo		fRepositoryInfo;
@@ -29,6 +29,7 @@ namespace BPrivate {
 
 
 struct hpkg_header;
+struct hpkg_repo_index_header;
 
 class RepositoryWriterImpl : public WriterImplBase {
 	typedef	WriterImplBase		inherited;
@@ -49,13 +50,18 @@ private:
 			status_t			_Finish();
 
 			status_t			_RegisterCurrentPackageInfo();
+			off_t				_WriteIndex(
+									hpkg_repo_index_header& indexHeader,
+									off_t startOffset);
 			status_t			_WriteRepositoryInfo(hpkg_repo_header& header,
+									off_t startOffset,
 									ssize_t& _infoLengthCompressed);
 			off_t				_WritePackageAttributes(
 									hpkg_repo_header& header, off_t startOffset,
 									ssize_t& _packagesLengthCompressed);
 
 			struct PackageNameSet;
+			struct IndexBuilder;
 
 private:
 			BRepositoryWriterListener*	fListener;
@@ -65,6 +71,7 @@ private:
 			BPackageInfo		fPackageInfo;
 			uint32				fPackageCount;
 			PackageNameSet*		fPackageNames;
+			IndexBuilder*		fIndexBuilder;
 };
 
 
@@ -129,6 +129,7 @@ protected:
 
 				void Init();
 
+				void Flush();
 				void Finish();
 
 				virtual status_t WriteDataNoThrow(const void* buffer,
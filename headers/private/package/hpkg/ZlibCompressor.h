@@ -30,6 +30,7 @@ public:
 			status_t			Init();
 			status_t			CompressNext(const void* input,
 									size_t inputSize);
+			status_t			Flush();
 			status_t			Finish();
 
 	static	status_t			CompressSingleBuffer(const void* input,
@@ -27,7 +27,9 @@ public:
 								ZlibDecompressor(BDataOutput* output);
 								~ZlibDecompressor();
 
-			status_t			Init();
+			status_t			Init(bool rawDeflate = false);
+									// rawDeflate: the stream has no zlib
+									// header and trailer
 			status_t			DecompressNext(const void* input,
 									size_t inputSize);
 			status_t			Finish();
@@ -0,0 +1,133 @@
+/*
+ * Copyright 2011, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _THREAD_SPARE_BUFFERS_H
+#define _THREAD_SPARE_BUFFERS_H
+
+
+#include <pthread.h>
+#include <stdlib.h>
+
+#include <SupportDefs.h>
+
+
+namespace BPrivate {
+
+
+/*!	Keeps the last released buffer of each of \a kSlotCount slots around per
+	thread, so that the next allocation of that thread can use it instead of
+	calling malloc(). The buffers are ordinary malloc() buffers, and are freed
+	when the thread exits.
+
+	\a Owner only serves to give each user its own set of slots, usually it is
+	the class the buffers are allocated for.
+*/
+template<typename Owner, int32 kSlotCount>
+class ThreadSpareBuffers {
+public:
+	/*!	Returns a buffer for at least \a size bytes, and sets \a size to its
+		actual size.
+	*/
+	static void* Allocate(int32 slot, size_t& size)
+	{
+		spare_buffers* spare = _Get(false);
+		if (spare != NULL && spare->buffers[slot] != NULL
+			&& spare->sizes[slot] >= size) {
+			void* buffer = spare->buffers[slot];
+			size = spare->sizes[slot];
+			spare->buffers[slot] = NULL;
+			return buffer;
+		}
+
+		return malloc(size);
+	}
+
+	/*!	Frees the \a buffer, or keeps it for reuse if it isn't larger than
+		\a maxSize. \a size may be less than the actual size of the buffer,
+		but must not be more.
+	*/
+	static void Release(int32 slot, void* buffer, size_t size, size_t maxSize)
+	{
+		if (buffer == NULL)
+			return;
+
+		if (size > 0 && size <= maxSize) {
+			spare_buffers* spare = _Get(true);
+			if (spare != NULL && (spare->buffers[slot] == NULL
+					|| spare->sizes[slot] < size)) {
+				free(spare->buffers[slot]);
+				spare->buffers[slot] = buffer;
+				spare->sizes[slot] = size;
+				return;
+			}
+		}
+
+		free(buffer);
+	}
+
+private:
+	struct spare_buffers {
+		void*	buffers[kSlotCount];
+		size_t	sizes[kSlotCount];
+	};
+
+	static void _Free(void* _spare)
+	{
+		spare_buffers* spare = (spare_buffers*)_spare;
+		for (int32 i = 0; i < kSlotCount; i++)
+			free(spare->buffers[i]);
+		free(spare);
+	}
+
+	static void _InitKey()
+	{
+		sKeyValid = pthread_key_create(&sKey, &_Free) == 0;
+	}
+
+	static spare_buffers* _Get(bool create)
+	{
+		pthread_once(&sKeyInitOnce, &_InitKey);
+		if (!sKeyValid)
+			return NULL;
+
+		spare_buffers* spare = (spare_buffers*)pthread_getspecific(sKey);
+		if (spare == NULL && create) {
+			spare = (spare_buffers*)calloc(1, sizeof(spare_buffers));
+			if (spare == NULL)
+				return NULL;
+
+			if (pthread_setspecific(sKey, spare) != 0) {
+				free(spare);
+				return NULL;
+			}
+		}
+
+		return spare;
+	}
+
+private:
+	static pthread_key_t	sKey;
+	static pthread_once_t	sKeyInitOnce;
+	static bool				sKeyValid;
+};
+
+
+template<typename Owner, int32 kSlotCount>
+pthread_key_t ThreadSpareBuffers<Owner, kSlotCount>::sKey;
+
+template<typename Owner, int32 kSlotCount>
+pthread_once_t ThreadSpareBuffers<Owner, kSlotCount>::sKeyInitOnce
+	= PTHREAD_ONCE_INIT;
+
+template<typename Owner, int32 kSlotCount>
+bool ThreadSpareBuffers<Owner, kSlotCount>::sKeyValid = false;
+
+
+}	// namespace BPrivate
+
+
+using BPrivate::ThreadSpareBuffers;
+
+
+#endif	// _THREAD_SPARE_BUFFERS_H
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2011, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _MIME_DATABASE_SNAPSHOT_H
+#define _MIME_DATABASE_SNAPSHOT_H
+
+
+#include <OS.h>
+
+class BMessage;
+class BString;
+
+
+namespace BPrivate {
+namespace Storage {
+namespace Mime {
+
+
+// The registrar publishes a read-only snapshot of the MIME database in an
+// area. Clients find it through the (small) control area, whose generation
+// counter changes whenever the database is modified.
+
+#define MIME_SNAPSHOT_CONTROL_AREA_NAME	"mime database snapshot control"
+#define MIME_SNAPSHOT_AREA_NAME			"mime database snapshot"
+
+enum {
+	MIME_SNAPSHOT_MAGIC		= 'MDbS',
+	MIME_SNAPSHOT_VERSION	= 1
+};
+
+struct mime_snapshot_control {
+	uint32			magic;
+	vint32			generation;
+	area_id			snapshot;		// -1 while there is no valid snapshot
+};
+
+// All offsets are relative to the start of the snapshot area.
+
+struct mime_snapshot_header {
+	uint32			magic;
+	uint32			version;
+	int32			generation;
+	uint32			size;
+	uint32			type_count;
+	uint32			types;			// offset of mime_snapshot_type[]
+	uint32			app_list_count;
+	uint32			app_lists;		// offset of mime_snapshot_app_list[]
+};
+
+// a type of the database, sorted by name
+struct mime_snapshot_type {
+	uint32			name;			// offset of the lower case type name
+	uint32			attributes;		// offset of mime_snapshot_attribute[]
+	uint32			attribute_count;
+};
+
+// an attribute of a type's database file
+struct mime_snapshot_attribute {
+	uint32			name;
+	type_code		type;
+	uint32			size;
+	uint32			data;			// 0, if the data is not in the snapshot
+};
+
+// the apps supporting a type, sorted by type
+struct mime_snapshot_app_list {
+	uint32			type;			// offset of the type, as the apps spell it
+	uint32			apps;			// offset of uint32[], the signatures
+	uint32			app_count;
+};
+
+
+// Error code: the snapshot can't answer the request, the database has to be
+// asked instead.
+extern const status_t kMimeSnapshotMissError;
+
+ssize_t read_snapshot_attr(const char *type, const char *attr, void *data,
+	size_t length);
+status_t read_snapshot_attr_message(const char *type, const char *attr,
+	BMessage *message);
+status_t read_snapshot_attr_string(const char *type, const char *attr,
+	BString *string);
+status_t snapshot_is_installed(const char *type, bool *installed);
+status_t get_snapshot_supporting_apps(const char *type, BMessage *apps);
+
+} // namespace Mime
+} // namespace Storage
+} // namespace BPrivate
+
+#endif	// _MIME_DATABASE_SNAPSHOT_H
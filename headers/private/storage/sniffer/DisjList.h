@@ -17,6 +17,8 @@ namespace BPrivate {
 namespace Storage {
 namespace Sniffer {
 
+class RuleSet;
+
 //! Abstract class defining methods acting on a list of ORed patterns
 class DisjList {
 public:
@@ -25,6 +27,7 @@ public:
 
 	virtual bool Sniff(BPositionIO *data) const = 0;
 	virtual ssize_t BytesNeeded() const = 0;
+	virtual void Compile(RuleSet *set) const = 0;
 	
 	void SetCaseInsensitive(bool how);
 	bool IsCaseInsensitive();
@@ -20,6 +20,7 @@ namespace Storage {
 namespace Sniffer {
 
 class Err;
+class RuleSet;
 
 //! A byte string and optional mask to be compared against a data stream.
 /*! The byte string and mask (if supplied) must be of the same length. */
@@ -34,6 +35,7 @@ public:
 	
 	bool Sniff(Range range, BPositionIO *data, bool caseInsensitive) const;
 	ssize_t BytesNeeded() const;
+	void Compile(Range range, RuleSet *set, bool caseInsensitive) const;
 	
 	status_t SetTo(const std::string &string, const std::string &mask);
 private:
@@ -19,6 +19,7 @@ namespace Sniffer {
 
 class Err;
 class Pattern;
+class RuleSet;
 
 //! A Pattern and a Range, bundled into one.
 class RPattern {
@@ -31,6 +32,7 @@ public:
 	
 	bool Sniff(BPositionIO *data, bool caseInsensitive) const;
 	ssize_t BytesNeeded() const;
+	void Compile(RuleSet *set, bool caseInsensitive) const;
 private:
 	Range fRange;
 	Pattern *fPattern;
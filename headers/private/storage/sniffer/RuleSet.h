@@ -0,0 +1,88 @@
+/*
+ * Copyright 2011, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+/*!
+	\file sniffer/RuleSet.h
+	MIME sniffer compiled rule set declarations
+*/
+#ifndef _SNIFFER_RULE_SET_H
+#define _SNIFFER_RULE_SET_H
+
+#include <SupportDefs.h>
+
+#include <string>
+#include <vector>
+
+namespace BPrivate {
+namespace Storage {
+namespace Sniffer {
+
+class Range;
+class Rule;
+
+/*! \brief A list of Rules, compiled into a form that can quickly be matched
+	against a buffer of data.
+*/
+class RuleSet {
+public:
+	RuleSet();
+	~RuleSet();
+
+	void MakeEmpty();
+	status_t AddRule(const Rule *rule);
+	int32 CountRules() const;
+
+	int32 Match(const void *data, size_t length,
+		double minPriority = -1.0) const;
+
+	// used by the DisjList implementations while a rule is added
+	void AddPattern(Range range, const std::string &string,
+		const std::string &mask, bool caseInsensitive);
+
+private:
+	struct pattern_entry {
+		int32	start;
+		int32	end;
+		uint32	offset;		// into fBytes
+		uint32	length;
+	};
+
+	struct conjunct_entry {
+		uint32	first_pattern;
+		uint32	pattern_count;
+	};
+
+	struct rule_entry {
+		double	priority;
+		uint32	first_conjunct;
+		uint32	conjunct_count;
+	};
+
+	enum {
+		EMPTY_DATA_SLOT	= 256,
+		SLOT_COUNT		= 257
+	};
+
+	bool _MatchRule(const rule_entry &rule, const uint8 *data,
+		size_t length) const;
+	bool _MatchPattern(const pattern_entry &pattern, const uint8 *data,
+		size_t length) const;
+
+	// For each pattern, its bytes, its alternative bytes (for case
+	// insensitive patterns), and its mask, each already masked.
+	std::vector<uint8>				fBytes;
+	std::vector<pattern_entry>		fPatterns;
+	std::vector<conjunct_entry>		fConjuncts;
+	std::vector<rule_entry>			fRules;
+
+	// For each possible first byte of the data (and for empty data), the
+	// indices of the rules that may match, in the order they were added.
+	std::vector<int32>				fCandidates[SLOT_COUNT];
+};
+
+};	// namespace Sniffer
+};	// namespace Storage
+};	// namespace BPrivate
+
+#endif	// _SNIFFER_RULE_SET_H
@@ -0,0 +1,35 @@
+/*
+ * Copyright 2011, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _ASYNC_IO_QUEUE_H
+#define _ASYNC_IO_QUEUE_H
+
+
+#include <DataIO.h>
+
+
+namespace BPrivate {
+
+
+// Runs reads for the asynchronous BDataIO methods on a small pool of
+// worker threads that is shared by the whole team. The threads are spawned
+// on demand, and go away again after a while without work.
+class AsyncIOQueue {
+public:
+	static	status_t			QueueRead(BDataIO* io, void* buffer,
+									size_t size, io_completion_hook hook,
+									void* cookie);
+	static	status_t			QueueReadAt(BPositionIO* io, off_t position,
+									void* buffer, size_t size,
+									io_completion_hook hook, void* cookie);
+};
+
+
+}	// namespace BPrivate
+
+
+using BPrivate::AsyncIOQueue;
+
+
+#endif	// _ASYNC_IO_QUEUE_H
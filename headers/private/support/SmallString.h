@@ -0,0 +1,243 @@
+/*
+ * Copyright 2011, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _SUPPORT_SMALL_STRING_H_
+#define _SUPPORT_SMALL_STRING_H_
+
+
+#include <string.h>
+
+#include <String.h>
+
+
+namespace BPrivate {
+
+
+class SmallString;
+
+
+/*!	A non-owning reference to a range of characters, which need not be null
+	terminated. Taking a substring of a view or trimming it never copies
+	anything. A view of a BString or SmallString is only valid as long as that
+	string isn't changed.
+*/
+class StringView {
+public:
+								StringView();
+								StringView(const char* string);
+								StringView(const char* string, int32 length);
+								StringView(const BString& string);
+								StringView(const SmallString& string);
+
+			const char*			Data() const	{ return fData; }
+			int32				Length() const	{ return fLength; }
+			bool				IsEmpty() const	{ return fLength == 0; }
+
+			char				operator[](int32 index) const
+									{ return fData[index]; }
+
+			StringView			Substring(int32 fromOffset,
+									int32 length = -1) const;
+									// length < 0 means up to the end
+			StringView&			Trim();
+
+			int32				FindFirst(char c, int32 fromOffset = 0) const;
+			int32				FindFirst(const StringView& string,
+									int32 fromOffset = 0) const;
+
+			int					Compare(const StringView& string) const;
+			int					ICompare(const StringView& string) const;
+
+			bool				operator==(const StringView& string) const;
+			bool				operator!=(const StringView& string) const;
+			bool				operator<(const StringView& string) const;
+
+private:
+			const char*			fData;
+			int32				fLength;
+};
+
+
+/*!	A string with the BString methods commonly used for short strings, which
+	keeps strings of up to kInlineCapacity bytes in the object itself, and
+	only allocates for longer ones. Unlike BString, it never shares its buffer,
+	and it keeps its buffer when it gets shorter, so a string that is cut back
+	and extended repeatedly allocates at most once.
+	This is meant for strings that live on the stack or in short lived
+	objects; use BString for anything that is passed around or stored.
+*/
+class SmallString {
+public:
+	static	const int32			kInlineCapacity = 23;
+
+public:
+								SmallString();
+								SmallString(const char* string);
+								SmallString(const char* string,
+									int32 maxLength);
+								SmallString(const SmallString& string);
+								SmallString(const BString& string);
+								SmallString(const StringView& string);
+								~SmallString();
+
+			const char*			String() const	{ return fData; }
+			int32				Length() const	{ return fLength; }
+			bool				IsEmpty() const	{ return fLength == 0; }
+			bool				IsInline() const
+									{ return fData == fInlineData; }
+
+			char				operator[](int32 index) const
+									{ return fData[index]; }
+
+			StringView			View() const
+									{ return StringView(fData, fLength); }
+			StringView			Substring(int32 fromOffset,
+									int32 length = -1) const
+									{ return View().Substring(fromOffset,
+										length); }
+
+			SmallString&		operator=(const SmallString& string);
+			SmallString&		operator=(const char* string);
+			SmallString&		operator=(const BString& string);
+			SmallString&		operator=(const StringView& string);
+
+			SmallString&		SetTo(const char* string);
+			SmallString&		SetTo(const char* string, int32 maxLength);
+			SmallString&		SetTo(const StringView& string);
+			SmallString&		Adopt(SmallString& from);
+
+			SmallString&		CopyInto(SmallString& into, int32 fromOffset,
+									int32 length) const;
+
+			SmallString&		Append(const char* string, int32 length);
+			SmallString&		Append(const StringView& string);
+			SmallString&		Append(char c, int32 count);
+
+			SmallString&		operator+=(const StringView& string)
+									{ return Append(string); }
+			SmallString&		operator+=(char c)
+									{ return Append(c, 1); }
+
+			SmallString&		operator<<(const char* string);
+			SmallString&		operator<<(const StringView& string)
+									{ return Append(string); }
+			SmallString&		operator<<(char c)
+									{ return Append(c, 1); }
+
+			SmallString&		Truncate(int32 newLength);
+			SmallString&		Trim();
+
+			int32				FindFirst(char c, int32 fromOffset = 0) const
+									{ return View().FindFirst(c,
+										fromOffset); }
+			int32				FindFirst(const StringView& string,
+									int32 fromOffset = 0) const
+									{ return View().FindFirst(string,
+										fromOffset); }
+
+			int					Compare(const StringView& string) const
+									{ return View().Compare(string); }
+			int					ICompare(const StringView& string) const
+									{ return View().ICompare(string); }
+
+			bool				operator==(const StringView& string) const
+									{ return View() == string; }
+			bool				operator!=(const StringView& string) const
+									{ return View() != string; }
+			bool				operator<(const StringView& string) const
+									{ return View() < string; }
+
+			char*				LockBuffer(int32 maxLength);
+			SmallString&		UnlockBuffer(int32 length = -1);
+
+private:
+			bool				_Reserve(int32 length);
+			void				_Free();
+
+private:
+			char*				fData;
+			int32				fLength;
+			int32				fCapacity;
+			char				fInlineData[kInlineCapacity + 1];
+};
+
+
+// #pragma mark - StringView inlines
+
+
+inline
+StringView::StringView()
+	:
+	fData(""),
+	fLength(0)
+{
+}
+
+
+inline
+StringView::StringView(const char* string)
+	:
+	fData(string != NULL ? string : ""),
+	fLength(string != NULL ? strlen(string) : 0)
+{
+}
+
+
+inline
+StringView::StringView(const char* string, int32 length)
+	:
+	fData(string != NULL ? string : ""),
+	fLength(string != NULL && length > 0 ? length : 0)
+{
+}
+
+
+inline
+StringView::StringView(const BString& string)
+	:
+	fData(string.String()),
+	fLength(string.Length())
+{
+}
+
+
+inline
+StringView::StringView(const SmallString& string)
+	:
+	fData(string.String()),
+	fLength(string.Length())
+{
+}
+
+
+inline bool
+StringView::operator==(const StringView& string) const
+{
+	return fLength == string.fLength
+		&& memcmp(fData, string.fData, fLength) == 0;
+}
+
+
+inline bool
+StringView::operator!=(const StringView& string) const
+{
+	return !(*this == string);
+}
+
+
+inline bool
+StringView::operator<(const StringView& string) const
+{
+	return Compare(string) < 0;
+}
+
+
+}	// namespace BPrivate
+
+
+using BPrivate::SmallString;
+using BPrivate::StringView;
+
+
+#endif	// _SUPPORT_SMALL_STRING_H_
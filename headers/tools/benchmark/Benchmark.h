@@ -0,0 +1,167 @@
+/*
+ * Copyright 2011, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _BENCHMARK_H
+#define _BENCHMARK_H
+
+
+/*!	The command line and timing loop shared by the micro benchmarks in
+	src/tests.
+
+	Each test is a function that is called for a number of iterations, which
+	can be scaled with "-n <scale>"; the remaining arguments select the tests
+	to run by name. The values returned by a test are folded into a checksum
+	that is printed along with the time per iteration. As the input data of
+	the tests is fixed, the checksum only changes when the results do, which
+	allows to verify that another implementation of the tested code still
+	computes the same. A benchmark can add a counter, like the number of
+	allocations, which is then printed per iteration as an extra column.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <OS.h>
+
+
+struct benchmark_test {
+	const char*	name;
+	uint32		(*function)(int32 iteration);
+	int32		iterations;
+};
+
+
+class Benchmark {
+public:
+	/*!	Parses the command line, and exits with a usage message if it is
+		invalid. \a tests must be terminated by an entry with a \c NULL name.
+	*/
+	Benchmark(const char* programName, const benchmark_test* tests, int argc,
+		char** argv)
+		:
+		fTests(tests),
+		fArgumentCount(argc),
+		fArguments(argv),
+		fScale(1.0f),
+		fFirstTestArgument(1),
+		fChecksumIterations(-1),
+		fPrepareHook(NULL),
+		fCounterName(NULL),
+		fCounter(NULL)
+	{
+		if (argc > 2 && !strcmp(argv[1], "-n")) {
+			fScale = atof(argv[2]);
+			fFirstTestArgument = 3;
+		}
+		if (fScale <= 0 || (argc > 1 && argv[1][0] == '-'
+				&& fFirstTestArgument == 1)) {
+			_Usage(programName);
+		}
+	}
+
+	/*!	Only the results of the first \a count iterations go into the
+		checksum, for tests that cycle through a fixed set of inputs.
+	*/
+	void SetChecksumIterations(int32 count)
+	{
+		fChecksumIterations = count;
+	}
+
+	//!	\a hook is called before each test, outside of the measured time.
+	void SetPrepareHook(void (*hook)())
+	{
+		fPrepareHook = hook;
+	}
+
+	/*!	\a counter is read before and after each test, and the difference
+		is printed per iteration, labeled with \a name.
+	*/
+	void SetCounter(const char* name, int64 (*counter)())
+	{
+		fCounterName = name;
+		fCounter = counter;
+	}
+
+	void Run()
+	{
+		bigtime_t totalTime = 0;
+
+		for (int32 i = 0; fTests[i].name != NULL; i++) {
+			const benchmark_test& test = fTests[i];
+			if (!_IsSelected(test.name))
+				continue;
+
+			int32 iterations = (int32)(test.iterations * fScale);
+			if (iterations < 1)
+				iterations = 1;
+
+			if (fPrepareHook != NULL)
+				fPrepareHook();
+
+			uint32 sum = 0;
+			int64 count = fCounter != NULL ? fCounter() : 0;
+
+			bigtime_t start = system_time();
+			for (int32 iteration = 0; iteration < iterations; iteration++) {
+				uint32 result = test.function(iteration);
+				if (fChecksumIterations < 0
+					|| iteration < fChecksumIterations)
+					sum = sum * 7 + result;
+			}
+			bigtime_t time = system_time() - start;
+			if (fCounter != NULL)
+				count = fCounter() - count;
+
+			totalTime += time;
+			printf("%-20s %8.2f usecs/iteration", test.name,
+				(double)time / iterations);
+			if (fCounter != NULL) {
+				printf("  %8.2f %s/iteration", (double)count / iterations,
+					fCounterName);
+			}
+			printf("  (checksum %08lx)\n", (unsigned long)sum);
+		}
+
+		printf("%-20s %8.2f msecs\n", "total", totalTime / 1000.0);
+	}
+
+private:
+	bool _IsSelected(const char* name) const
+	{
+		if (fArgumentCount <= fFirstTestArgument)
+			return true;
+
+		for (int32 i = fFirstTestArgument; i < fArgumentCount; i++) {
+			if (!strcmp(fArguments[i], name))
+				return true;
+		}
+		return false;
+	}
+
+	void _Usage(const char* programName)
+	{
+		fprintf(stderr, "usage: %s [-n <scale>] [test name ...]\n"
+			"Tests:\n", programName);
+		for (int32 i = 0; fTests[i].name != NULL; i++)
+			fprintf(stderr, "  %s\n", fTests[i].name);
+
+		exit(1);
+	}
+
+private:
+	const benchmark_test*	fTests;
+	int32					fArgumentCount;
+	char**					fArguments;
+	float					fScale;
+	int32					fFirstTestArgument;
+	int32					fChecksumIterations;
+	void					(*fPrepareHook)();
+	const char*				fCounterName;
+	int64					(*fCounter)();
+};
+
+
+#endif	// _BENCHMARK_H
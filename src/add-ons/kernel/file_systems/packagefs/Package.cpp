@@ -12,10 +12,15 @@
 #include <string.h>
 #include <unistd.h>
 
+#include <new>
+
 #include <util/AutoLock.h>
 
 #include "DebugSupport.h"
+#include "PackageDirectory.h"
 #include "PackageDomain.h"
+#include "PackageFile.h"
+#include "PackageSymlink.h"
 #include "Version.h"
 
 
@@ -38,7 +43,10 @@ Package::Package(PackageDomain* domain, dev_t deviceID, ino_t nodeID)
 	fFD(-1),
 	fOpenCount(0),
 	fNodeID(nodeID),
-	fDeviceID(deviceID)
+	fDeviceID(deviceID),
+	fLoadedNodeCount(0),
+	fLoadedAttributeCount(0),
+	fLoadedNodesSize(0)
 {
 	mutex_init(&fLock, "packagefs package");
 }
@@ -133,6 +141,169 @@ Package::AddNode(PackageNode* node)
 }
 
 
+/*!	Creates the package node for the given TOC index entry, including its
+	attributes. The node is neither added to \a parent nor to the package;
+	the caller gets a reference.
+	Directory nodes are created without children. Their children are created
+	by LoadChildren() when needed.
+*/
+status_t
+Package::CreateNode(uint32 tocEntry, PackageDirectory* parent,
+	PackageNode*& _node)
+{
+	const PackageTOCIndex::Entry& entry = fTOCIndex.EntryAt(tocEntry);
+	mode_t mode = entry.mode;
+	size_t nodeSize;
+
+	status_t error;
+	PackageNode* node;
+	if (S_ISREG(mode)) {
+		// file
+		node = new(std::nothrow) PackageFile(this, mode, entry.data);
+		nodeSize = sizeof(PackageFile);
+	} else if (S_ISLNK(mode)) {
+		// symlink
+		PackageSymlink* symlink = new(std::nothrow) PackageSymlink(this, mode);
+		if (symlink == NULL)
+			RETURN_ERROR(B_NO_MEMORY);
+
+		const char* symlinkPath = entry.symlinkPath != PackageTOCIndex::kNoEntry
+			? fTOCIndex.StringAt(entry.symlinkPath) : NULL;
+		error = symlink->SetSymlinkPath(symlinkPath);
+		if (error != B_OK) {
+			delete symlink;
+			return error;
+		}
+
+		node = symlink;
+		nodeSize = sizeof(PackageSymlink)
+			+ (symlinkPath != NULL ? strlen(symlinkPath) + 1 : 0);
+	} else if (S_ISDIR(mode)) {
+		// directory
+		PackageDirectory* directory
+			= new(std::nothrow) PackageDirectory(this, mode);
+		if (directory != NULL) {
+			directory->SetTOCEntry(tocEntry);
+			directory->SetChildrenLoaded(
+				entry.firstChild == PackageTOCIndex::kNoEntry);
+		}
+		node = directory;
+		nodeSize = sizeof(PackageDirectory);
+	} else
+		RETURN_ERROR(B_BAD_DATA);
+
+	if (node == NULL)
+		RETURN_ERROR(B_NO_MEMORY);
+	BReference<PackageNode> nodeReference(node, true);
+
+	const char* name = fTOCIndex.StringAt(entry.name);
+	error = node->Init(parent, name);
+	if (error != B_OK)
+		RETURN_ERROR(error);
+
+	node->SetModifiedTime(entry.modifiedTime);
+	nodeSize += strlen(name) + 1;
+
+	// create the attributes
+	uint32 attributeCount = 0;
+	for (uint32 index = entry.firstAttribute;
+			index != PackageTOCIndex::kNoEntry;) {
+		const PackageTOCIndex::Attribute& attribute
+			= fTOCIndex.AttributeAt(index);
+		index = attribute.next;
+
+		PackageNodeAttribute* nodeAttribute = new(std::nothrow)
+			PackageNodeAttribute(attribute.type, attribute.data);
+		if (nodeAttribute == NULL)
+			RETURN_ERROR(B_NO_MEMORY)
+
+		const char* attributeName = fTOCIndex.StringAt(attribute.name);
+		error = nodeAttribute->Init(attributeName);
+		if (error != B_OK) {
+			delete nodeAttribute;
+			RETURN_ERROR(error);
+		}
+
+		node->AddAttribute(nodeAttribute);
+		attributeCount++;
+		nodeSize += sizeof(PackageNodeAttribute) + strlen(attributeName) + 1;
+	}
+
+	fLoadedNodeCount++;
+	fLoadedAttributeCount += attributeCount;
+	fLoadedNodesSize += nodeSize;
+
+	_node = nodeReference.Detach();
+	return B_OK;
+}
+
+
+/*!	Creates the package nodes for the top level entries of the package and
+	adds them to the package.
+*/
+status_t
+Package::CreateRootNodes()
+{
+	for (uint32 index = fTOCIndex.FirstRootEntry();
+			index != PackageTOCIndex::kNoEntry;
+			index = fTOCIndex.EntryAt(index).nextSibling) {
+		PackageNode* node;
+		status_t error = CreateNode(index, NULL, node);
+		if (error != B_OK)
+			RETURN_ERROR(error);
+
+		AddNode(node);
+		node->ReleaseReference();
+	}
+
+	return B_OK;
+}
+
+
+/*!	Creates the package nodes for the children of the given directory, unless
+	already done.
+*/
+status_t
+Package::LoadChildren(PackageDirectory* directory)
+{
+	if (directory->ChildrenLoaded())
+		return B_OK;
+
+	for (uint32 index = fTOCIndex.EntryAt(directory->TOCEntry()).firstChild;
+			index != PackageTOCIndex::kNoEntry;
+			index = fTOCIndex.EntryAt(index).nextSibling) {
+		PackageNode* node;
+		status_t error = CreateNode(index, directory, node);
+		if (error != B_OK) {
+			directory->RemoveAllChildren();
+			RETURN_ERROR(error);
+		}
+
+		directory->AddChild(node);
+		node->ReleaseReference();
+	}
+
+	directory->SetChildrenLoaded(true);
+	return B_OK;
+}
+
+
+/*!	Reverts LoadChildren(). The caller is responsible for having removed the
+	child nodes from the node tree.
+*/
+void
+Package::UnloadChildren(PackageDirectory* directory)
+{
+	if (fTOCIndex.EntryAt(directory->TOCEntry()).firstChild
+			== PackageTOCIndex::kNoEntry) {
+		return;
+	}
+
+	directory->RemoveAllChildren();
+	directory->SetChildrenLoaded(false);
+}
+
+
 void
 Package::AddResolvable(Resolvable* resolvable)
 {
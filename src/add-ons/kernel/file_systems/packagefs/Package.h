@@ -18,12 +18,14 @@
 
 #include "Dependency.h"
 #include "PackageNode.h"
+#include "PackageTOCIndex.h"
 #include "Resolvable.h"
 
 
 using BPackageKit::BPackageArchitecture;
 
 
+class PackageDirectory;
 class PackageDomain;
 class PackageLinkDirectory;
 class Version;
@@ -69,6 +71,23 @@ public:
 									{ return fFileNameHashTableNext; }
 
 			void				AddNode(PackageNode* node);
+
+			// lazy node creation -- volume must be write-locked
+			PackageTOCIndex&	TOCIndex()			{ return fTOCIndex; }
+			status_t			CreateNode(uint32 tocEntry,
+									PackageDirectory* parent,
+									PackageNode*& _node);
+									// returns a reference
+			status_t			CreateRootNodes();
+			status_t			LoadChildren(PackageDirectory* directory);
+			void				UnloadChildren(PackageDirectory* directory);
+
+			uint32				LoadedNodeCount() const
+									{ return fLoadedNodeCount; }
+			uint32				LoadedAttributeCount() const
+									{ return fLoadedAttributeCount; }
+			size_t				LoadedNodesSize() const
+									{ return fLoadedNodesSize; }
 			void				AddResolvable(Resolvable* resolvable);
 			void				AddDependency(Dependency* dependency);
 
@@ -98,6 +117,10 @@ private:
 			PackageNodeList		fNodes;
 			ResolvableList		fResolvables;
 			DependencyList		fDependencies;
+			PackageTOCIndex		fTOCIndex;
+			uint32				fLoadedNodeCount;
+			uint32				fLoadedAttributeCount;
+			size_t				fLoadedNodesSize;
 };
 
 
@@ -6,18 +6,21 @@
 
 #include "PackageDirectory.h"
 
+#include "PackageTOCIndex.h"
+
 
 PackageDirectory::PackageDirectory(Package* package, mode_t mode)
 	:
-	PackageNode(package, mode)
+	PackageNode(package, mode),
+	fTOCEntry(PackageTOCIndex::kNoEntry),
+	fChildrenLoaded(true)
 {
 }
 
 
 PackageDirectory::~PackageDirectory()
 {
-	while (PackageNode* child = fChildren.RemoveHead())
-		child->ReleaseReference();
+	RemoveAllChildren();
 }
 
 
@@ -35,3 +38,11 @@ PackageDirectory::RemoveChild(PackageNode* node)
 	fChildren.Remove(node);
 	node->ReleaseReference();
 }
+
+
+void
+PackageDirectory::RemoveAllChildren()
+{
+	while (PackageNode* child = fChildren.RemoveHead())
+		child->ReleaseReference();
+}
@@ -26,8 +26,20 @@ public:
 			const PackageNodeList& Children() const
 									{ return fChildren; }
 
+			// lazy loading of the children from the package's TOC index
+			uint32				TOCEntry() const	{ return fTOCEntry; }
+			void				SetTOCEntry(uint32 entry)
+									{ fTOCEntry = entry; }
+			bool				ChildrenLoaded() const
+									{ return fChildrenLoaded; }
+			void				SetChildrenLoaded(bool loaded)
+									{ fChildrenLoaded = loaded; }
+			void				RemoveAllChildren();
+
 private:
 			PackageNodeList		fChildren;
+			uint32				fTOCEntry;
+			bool				fChildrenLoaded;
 };
 
 
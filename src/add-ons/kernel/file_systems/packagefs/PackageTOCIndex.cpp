@@ -0,0 +1,236 @@
+/*
+ * Copyright 2011, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include "PackageTOCIndex.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "DebugSupport.h"
+
+
+static const uint32 kInitialEntryCapacity = 64;
+static const uint32 kInitialAttributeCapacity = 32;
+static const uint32 kInitialStringsCapacity = 1024;
+
+
+template<typename Element>
+static status_t
+ensure_capacity(Element*& array, uint32 count, uint32& capacity,
+	uint32 initialCapacity)
+{
+	if (count < capacity)
+		return B_OK;
+
+	uint32 newCapacity = capacity == 0 ? initialCapacity : capacity * 2;
+	if (newCapacity <= capacity)
+		return B_NO_MEMORY;
+
+	Element* newArray = (Element*)realloc(array,
+		(size_t)newCapacity * sizeof(Element));
+	if (newArray == NULL)
+		return B_NO_MEMORY;
+
+	array = newArray;
+	capacity = newCapacity;
+	return B_OK;
+}
+
+
+template<typename Element>
+static void
+trim_capacity(Element*& array, uint32 count, uint32& capacity)
+{
+	if (count == capacity || count == 0)
+		return;
+
+	Element* newArray = (Element*)realloc(array,
+		(size_t)count * sizeof(Element));
+	if (newArray != NULL) {
+		array = newArray;
+		capacity = count;
+	}
+}
+
+
+PackageTOCIndex::PackageTOCIndex()
+	:
+	fEntries(NULL),
+	fEntryCount(0),
+	fEntryCapacity(0),
+	fAttributes(NULL),
+	fAttributeCount(0),
+	fAttributeCapacity(0),
+	fStrings(NULL),
+	fStringsSize(0),
+	fStringsCapacity(0),
+	fFirstRootEntry(kNoEntry)
+{
+}
+
+
+PackageTOCIndex::~PackageTOCIndex()
+{
+	free(fEntries);
+	free(fAttributes);
+	free(fStrings);
+}
+
+
+status_t
+PackageTOCIndex::AddEntry(uint32 parent, const char* name, mode_t mode,
+	const timespec& modifiedTime, const BPackageData& data,
+	const char* symlinkPath, uint32& _index)
+{
+	if (parent != kNoEntry && parent >= fEntryCount)
+		RETURN_ERROR(B_BAD_VALUE);
+
+	status_t error = ensure_capacity(fEntries, fEntryCount, fEntryCapacity,
+		kInitialEntryCapacity);
+	if (error != B_OK)
+		RETURN_ERROR(error);
+
+	uint32 nameOffset;
+	error = _AddString(name, nameOffset);
+	if (error != B_OK)
+		RETURN_ERROR(error);
+
+	uint32 symlinkPathOffset = kNoEntry;
+	if (symlinkPath != NULL) {
+		error = _AddString(symlinkPath, symlinkPathOffset);
+		if (error != B_OK)
+			RETURN_ERROR(error);
+	}
+
+	uint32 index = fEntryCount++;
+	Entry& entry = fEntries[index];
+	entry.parent = parent;
+	entry.firstChild = kNoEntry;
+	entry.firstAttribute = kNoEntry;
+	entry.name = nameOffset;
+	entry.symlinkPath = symlinkPathOffset;
+	entry.mode = mode;
+	entry.modifiedTime = modifiedTime;
+	entry.data = data;
+
+	// Prepend the entry to its siblings. Finish() restores the original
+	// order.
+	uint32& firstSibling = parent != kNoEntry
+		? fEntries[parent].firstChild : fFirstRootEntry;
+	entry.nextSibling = firstSibling;
+	firstSibling = index;
+
+	_index = index;
+	return B_OK;
+}
+
+
+status_t
+PackageTOCIndex::AddAttribute(uint32 entry, const char* name, uint32 type,
+	const BPackageData& data)
+{
+	if (entry >= fEntryCount)
+		RETURN_ERROR(B_BAD_VALUE);
+
+	status_t error = ensure_capacity(fAttributes, fAttributeCount,
+		fAttributeCapacity, kInitialAttributeCapacity);
+	if (error != B_OK)
+		RETURN_ERROR(error);
+
+	uint32 nameOffset;
+	error = _AddString(name, nameOffset);
+	if (error != B_OK)
+		RETURN_ERROR(error);
+
+	uint32 index = fAttributeCount++;
+	Attribute& attribute = fAttributes[index];
+	attribute.name = nameOffset;
+	attribute.type = type;
+	attribute.data = data;
+	attribute.next = fEntries[entry].firstAttribute;
+	fEntries[entry].firstAttribute = index;
+
+	return B_OK;
+}
+
+
+void
+PackageTOCIndex::Finish()
+{
+	// reverse the sibling and attribute lists
+	for (uint32 i = 0; i <= fEntryCount; i++) {
+		uint32& head = i < fEntryCount
+			? fEntries[i].firstChild : fFirstRootEntry;
+		uint32 reversed = kNoEntry;
+		uint32 index = head;
+		while (index != kNoEntry) {
+			uint32 next = fEntries[index].nextSibling;
+			fEntries[index].nextSibling = reversed;
+			reversed = index;
+			index = next;
+		}
+		head = reversed;
+
+		if (i == fEntryCount)
+			break;
+
+		reversed = kNoEntry;
+		index = fEntries[i].firstAttribute;
+		while (index != kNoEntry) {
+			uint32 next = fAttributes[index].next;
+			fAttributes[index].next = reversed;
+			reversed = index;
+			index = next;
+		}
+		fEntries[i].firstAttribute = reversed;
+	}
+
+	trim_capacity(fEntries, fEntryCount, fEntryCapacity);
+	trim_capacity(fAttributes, fAttributeCount, fAttributeCapacity);
+	trim_capacity(fStrings, fStringsSize, fStringsCapacity);
+}
+
+
+bool
+PackageTOCIndex::HasAttribute(uint32 entry, const char* name) const
+{
+	for (uint32 index = fEntries[entry].firstAttribute; index != kNoEntry;
+			index = fAttributes[index].next) {
+		if (strcmp(StringAt(fAttributes[index].name), name) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+
+size_t
+PackageTOCIndex::MemoryUsage() const
+{
+	return sizeof(*this) + (size_t)fEntryCapacity * sizeof(Entry)
+		+ (size_t)fAttributeCapacity * sizeof(Attribute) + fStringsCapacity;
+}
+
+
+status_t
+PackageTOCIndex::_AddString(const char* string, uint32& _offset)
+{
+	size_t length = strlen(string) + 1;
+	if (length > kNoEntry - fStringsSize)
+		RETURN_ERROR(B_NO_MEMORY);
+
+	while (fStringsSize + length > fStringsCapacity) {
+		status_t error = ensure_capacity(fStrings, fStringsCapacity,
+			fStringsCapacity, kInitialStringsCapacity);
+		if (error != B_OK)
+			RETURN_ERROR(error);
+	}
+
+	memcpy(fStrings + fStringsSize, string, length);
+	_offset = fStringsSize;
+	fStringsSize += length;
+	return B_OK;
+}
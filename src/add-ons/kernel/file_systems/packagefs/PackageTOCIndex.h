@@ -0,0 +1,100 @@
+/*
+ * Copyright 2011, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef PACKAGE_TOC_INDEX_H
+#define PACKAGE_TOC_INDEX_H
+
+
+#include <sys/stat.h>
+
+#include <SupportDefs.h>
+
+#include <package/hpkg/PackageData.h>
+
+
+using BPackageKit::BHPKG::BPackageData;
+
+
+/*!	A compact, flat representation of a package's table of contents.
+
+	While loading a package the entries and their attributes are recorded in
+	a few plain arrays and a string pool instead of creating a PackageNode
+	object (plus name and attributes) for each of them. The package nodes are
+	created from the index on demand, when the directory containing them is
+	accessed for the first time.
+*/
+class PackageTOCIndex {
+public:
+	static	const uint32		kNoEntry = 0xffffffff;
+
+			struct Entry {
+				uint32			parent;
+				uint32			firstChild;
+				uint32			nextSibling;
+				uint32			firstAttribute;
+				uint32			name;
+				uint32			symlinkPath;
+				mode_t			mode;
+				timespec		modifiedTime;
+				BPackageData	data;
+			};
+
+			struct Attribute {
+				uint32			next;
+				uint32			name;
+				uint32			type;
+				BPackageData	data;
+			};
+
+public:
+								PackageTOCIndex();
+								~PackageTOCIndex();
+
+			status_t			AddEntry(uint32 parent, const char* name,
+									mode_t mode, const timespec& modifiedTime,
+									const BPackageData& data,
+									const char* symlinkPath, uint32& _index);
+			status_t			AddAttribute(uint32 entry, const char* name,
+									uint32 type, const BPackageData& data);
+
+			void				Finish();
+									// restores the package order of children
+									// and attributes and trims the arrays
+
+			uint32				CountEntries() const
+									{ return fEntryCount; }
+			uint32				FirstRootEntry() const
+									{ return fFirstRootEntry; }
+
+			const Entry&		EntryAt(uint32 index) const
+									{ return fEntries[index]; }
+			const Attribute&	AttributeAt(uint32 index) const
+									{ return fAttributes[index]; }
+			const char*			StringAt(uint32 offset) const
+									{ return fStrings + offset; }
+
+			bool				HasAttribute(uint32 entry,
+									const char* name) const;
+
+			size_t				MemoryUsage() const;
+
+private:
+			status_t			_AddString(const char* string,
+									uint32& _offset);
+
+private:
+			Entry*				fEntries;
+			uint32				fEntryCount;
+			uint32				fEntryCapacity;
+			Attribute*			fAttributes;
+			uint32				fAttributeCount;
+			uint32				fAttributeCapacity;
+			char*				fStrings;
+			uint32				fStringsSize;
+			uint32				fStringsCapacity;
+			uint32				fFirstRootEntry;
+};
+
+
+#endif	// PACKAGE_TOC_INDEX_H
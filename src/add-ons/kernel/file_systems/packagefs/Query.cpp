@@ -9,6 +9,7 @@
 #include <file_systems/QueryParser.h>
 
 #include "AttributeCookie.h"
+#include "AutoPackageAttributes.h"
 #include "Directory.h"
 #include "Index.h"
 #include "Node.h"
@@ -261,6 +262,26 @@ Query::Create(Volume* volume, const char* queryString, uint32 flags,
 }
 
 
+/*!	Loads the nodes \a queryString can match, as far as they haven't been
+	loaded yet. Nodes only get into the indices when they are loaded, and
+	queries find nodes only through the indices. Only when all matching
+	nodes have a certain package attribute, the other nodes can be left
+	alone, though; e.g. a query on "name" loads all directories.
+	The volume must not be locked.
+*/
+/*static*/ status_t
+Query::LoadCandidateNodes(Volume* volume, const char* queryString)
+{
+	QueryParser::Expression<QueryPolicy> expression((char*)queryString);
+	if (expression.InitCheck() != B_OK) {
+		// Create() will fail
+		return B_OK;
+	}
+
+	return _LoadCandidateNodes(volume, expression.Root());
+}
+
+
 status_t
 Query::Rewind()
 {
@@ -297,3 +318,69 @@ Query::_Init(const char* queryString, uint32 flags, port_id port, uint32 token)
 
 	return B_OK;
 }
+
+
+/*!	Returns whether only nodes that have a certain package attribute can
+	match \a term, so that only the nodes with that attribute need to be
+	loaded for it.
+*/
+/*static*/ bool
+Query::_IsSelective(TermImpl* term)
+{
+	using namespace QueryParser;
+
+	if (term->Op() == OP_AND || term->Op() == OP_OR) {
+		Operator<QueryPolicy>* op = (Operator<QueryPolicy>*)term;
+		if (op->Op() == OP_AND) {
+			return _IsSelective(op->Left())
+				|| _IsSelective(op->Right());
+		}
+		return _IsSelective(op->Left())
+			&& _IsSelective(op->Right());
+	}
+
+	// All nodes have the special and the automatic package attributes.
+	Equation<QueryPolicy>* equation = (Equation<QueryPolicy>*)term;
+	const char* attribute = equation->Attribute();
+	AutoPackageAttribute autoAttribute;
+	if (strcmp(attribute, "name") == 0 || strcmp(attribute, "size") == 0
+		|| strcmp(attribute, "last_modified") == 0
+		|| AutoPackageAttributes::AttributeForName(attribute, autoAttribute)) {
+		return false;
+	}
+
+	// A missing attribute is matched like an empty string -- this is a
+	// temporary expression, so it doesn't matter that the call converts
+	// the equation's value.
+	return equation->Match(NULL, NULL, attribute, B_STRING_TYPE, NULL, 0)
+		!= MATCH_OK;
+}
+
+
+/*static*/ status_t
+Query::_LoadCandidateNodes(Volume* volume, TermImpl* term)
+{
+	using namespace QueryParser;
+
+	if (term->Op() == OP_AND || term->Op() == OP_OR) {
+		Operator<QueryPolicy>* op = (Operator<QueryPolicy>*)term;
+		if (op->Op() == OP_OR) {
+			status_t error = _LoadCandidateNodes(volume, op->Left());
+			if (error != B_OK)
+				return error;
+			return _LoadCandidateNodes(volume, op->Right());
+		}
+
+		// A node matching both terms is a candidate for either of them, and
+		// it gets into all indices when it is loaded. So loading the
+		// candidates of one of them suffices.
+		return _LoadCandidateNodes(volume,
+			_IsSelective(op->Left()) ? op->Left() : op->Right());
+	}
+
+	if (!_IsSelective(term))
+		return volume->LoadAllDirectoryContents();
+
+	return volume->LoadAttributeDirectoryContents(
+		((Equation<QueryPolicy>*)term)->Attribute());
+}
@@ -15,6 +15,7 @@ struct dirent;
 
 namespace QueryParser {
 	template<typename QueryPolicy> class Query;
+	template<typename QueryPolicy> class Term;
 };
 
 class Node;
@@ -28,6 +29,8 @@ public:
 	static	status_t		Create(Volume* volume, const char* queryString,
 								uint32 flags, port_id port, uint32 token,
 								Query*& _query);
+	static	status_t		LoadCandidateNodes(Volume* volume,
+								const char* queryString);
 
 			status_t		Rewind();
 			status_t		GetNextEntry(struct dirent* entry, size_t size);
@@ -41,6 +44,7 @@ private:
 			struct QueryPolicy;
 			friend struct QueryPolicy;
 			typedef QueryParser::Query<QueryPolicy> QueryImpl;
+			typedef QueryParser::Term<QueryPolicy> TermImpl;
 
 private:
 							Query(Volume* volume);
@@ -48,6 +52,10 @@ private:
 			status_t		_Init(const char* queryString, uint32 flags,
 								port_id port, uint32 token);
 
+	static	bool			_IsSelective(TermImpl* term);
+	static	status_t		_LoadCandidateNodes(Volume* volume,
+								TermImpl* term);
+
 private:
 			Volume*			fVolume;
 			QueryImpl*		fImpl;
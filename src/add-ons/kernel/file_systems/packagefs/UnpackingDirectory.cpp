@@ -17,7 +17,8 @@
 
 UnpackingDirectory::UnpackingDirectory(ino_t id)
 	:
-	Directory(id)
+	Directory(id),
+	fContentsLoaded(false)
 {
 }
 
@@ -203,6 +204,8 @@ RootDirectory::RootDirectory(ino_t id, const timespec& modifiedTime)
 	UnpackingDirectory(id),
 	fModifiedTime(modifiedTime)
 {
+	// the package root nodes are always added right away
+	SetContentsLoaded(true);
 }
 
 
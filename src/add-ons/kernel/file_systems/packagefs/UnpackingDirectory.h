@@ -42,8 +42,19 @@ public:
 	virtual	status_t			IndexAttribute(AttributeIndexer* indexer);
 	virtual	void*				IndexCookieForAttribute(const char* name) const;
 
+			const PackageDirectoryList& PackageDirectories() const
+									{ return fPackageDirectories; }
+
+			bool				ContentsLoaded() const
+									{ return fContentsLoaded; }
+			void				SetContentsLoaded(bool loaded)
+									{ fContentsLoaded = loaded; }
+									// true, when the children of all package
+									// directories have been added
+
 private:
 			PackageDirectoryList fPackageDirectories;
+			bool				fContentsLoaded;
 };
 
 
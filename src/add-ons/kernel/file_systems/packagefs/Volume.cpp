@@ -9,6 +9,7 @@
 #include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
 
@@ -197,61 +198,28 @@ struct Volume::PackageLoaderContentHandler : BPackageContentHandler {
 		if (fErrorOccurred)
 			return B_OK;
 
-		PackageDirectory* parentDir = NULL;
+		uint32 parentIndex = PackageTOCIndex::kNoEntry;
 		if (entry->Parent() != NULL) {
-			parentDir = dynamic_cast<PackageDirectory*>(
-				(PackageNode*)entry->Parent()->UserToken());
-			if (parentDir == NULL)
+			parentIndex = (uint32)(addr_t)entry->Parent()->UserToken();
+			if (!S_ISDIR(fPackage->TOCIndex().EntryAt(parentIndex).mode))
 				RETURN_ERROR(B_BAD_DATA);
 		}
 
-		status_t error;
-
 		// get the file mode -- filter out write permissions
 		mode_t mode = entry->Mode() & ~(mode_t)(S_IWUSR | S_IWGRP | S_IWOTH);
-
-		// create the package node
-		PackageNode* node;
-		if (S_ISREG(mode)) {
-			// file
-			node = new(std::nothrow) PackageFile(fPackage, mode, entry->Data());
-		} else if (S_ISLNK(mode)) {
-			// symlink
-			PackageSymlink* symlink = new(std::nothrow) PackageSymlink(
-				fPackage, mode);
-			if (symlink == NULL)
-				RETURN_ERROR(B_NO_MEMORY);
-
-			error = symlink->SetSymlinkPath(entry->SymlinkPath());
-			if (error != B_OK) {
-				delete symlink;
-				return error;
-			}
-
-			node = symlink;
-		} else if (S_ISDIR(mode)) {
-			// directory
-			node = new(std::nothrow) PackageDirectory(fPackage, mode);
-		} else
+		if (!S_ISREG(mode) && !S_ISLNK(mode) && !S_ISDIR(mode))
 			RETURN_ERROR(B_BAD_DATA);
 
-		if (node == NULL)
-			RETURN_ERROR(B_NO_MEMORY);
-		BReference<PackageNode> nodeReference(node, true);
-
-		error = node->Init(parentDir, entry->Name());
+		// Only record the entry in the package's TOC index. The package node
+		// is created when it is needed.
+		uint32 index;
+		status_t error = fPackage->TOCIndex().AddEntry(parentIndex,
+			entry->Name(), mode, entry->ModifiedTime(), entry->Data(),
+			S_ISLNK(mode) ? entry->SymlinkPath() : NULL, index);
 		if (error != B_OK)
 			RETURN_ERROR(error);
 
-		node->SetModifiedTime(entry->ModifiedTime());
-
-		// add it to the parent directory
-		if (parentDir != NULL)
-			parentDir->AddChild(node);
-		else
-			fPackage->AddNode(node);
-
-		entry->SetUserToken(node);
+		entry->SetUserToken((void*)(addr_t)index);
 
 		return B_OK;
 	}
@@ -262,22 +230,9 @@ struct Volume::PackageLoaderContentHandler : BPackageContentHandler {
 		if (fErrorOccurred)
 			return B_OK;
 
-		PackageNode* node = (PackageNode*)entry->UserToken();
-
-		PackageNodeAttribute* nodeAttribute = new(std::nothrow)
-			PackageNodeAttribute(attribute->Type(), attribute->Data());
-		if (nodeAttribute == NULL)
-			RETURN_ERROR(B_NO_MEMORY)
-
-		status_t error = nodeAttribute->Init(attribute->Name());
-		if (error != B_OK) {
-			delete nodeAttribute;
-			RETURN_ERROR(error);
-		}
-
-		node->AddAttribute(nodeAttribute);
-
-		return B_OK;
+		RETURN_ERROR(fPackage->TOCIndex().AddAttribute(
+			(uint32)(addr_t)entry->UserToken(), attribute->Name(),
+			attribute->Type(), attribute->Data()));
 	}
 
 	virtual status_t HandleEntryDone(BPackageEntry* entry)
@@ -1044,7 +999,9 @@ Volume::_LoadPackage(Package* package)
 	if (error != B_OK)
 		RETURN_ERROR(error);
 
-	return B_OK;
+	// create the top level package nodes -- everything else is created lazily
+	package->TOCIndex().Finish();
+	RETURN_ERROR(package->CreateRootNodes());
 }
 
 
@@ -1128,6 +1085,31 @@ Volume::_AddPackageContentRootNode(Package* package,
 		if (node != NULL) {
 			if (PackageDirectory* packageDirectory
 					= dynamic_cast<PackageDirectory*>(packageNode)) {
+				// If the directory's contents have already been loaded, we
+				// need to add the package directory's children right away.
+				// Otherwise that happens when the directory is accessed.
+				UnpackingDirectory* unpackingDirectory
+					= dynamic_cast<UnpackingDirectory*>(node);
+				if (unpackingDirectory != NULL
+					&& unpackingDirectory->ContentsLoaded()) {
+					error = package->LoadChildren(packageDirectory);
+					if (error != B_OK) {
+						_RemovePackageNode(directory, packageNode, node,
+							notify);
+
+						// unlock all directories
+						while (directory != NULL) {
+							directory->WriteUnlock();
+							directory = directory->Parent();
+						}
+
+						// remove the added package nodes
+						_RemovePackageContentRootNode(package, rootPackageNode,
+							packageNode, notify);
+						RETURN_ERROR(error);
+					}
+				}
+
 				if (packageDirectory->FirstChild() != NULL) {
 					directory = dynamic_cast<Directory*>(node);
 					packageNode = packageDirectory->FirstChild();
@@ -1425,6 +1407,260 @@ Volume::_RemovePackageNode(Directory* directory, PackageNode* packageNode,
 }
 
 
+/*!	Adds the child nodes of all package directories merged into the given
+	directory, which haven't been loaded yet. Must be called before looking up
+	or iterating through the directory's entries. The volume must not be
+	locked.
+*/
+status_t
+Volume::LoadDirectoryContents(Directory* directory)
+{
+	UnpackingDirectory* unpackingDirectory
+		= dynamic_cast<UnpackingDirectory*>(directory);
+	if (unpackingDirectory == NULL)
+		return B_OK;
+
+	// check without the volume lock first -- the common case
+	{
+		NodeReadLocker directoryLocker(directory);
+		if (unpackingDirectory->ContentsLoaded())
+			return B_OK;
+	}
+
+	VolumeWriteLocker volumeLocker(this);
+	NodeWriteLocker directoryLocker(directory);
+	if (unpackingDirectory->ContentsLoaded())
+		return B_OK;
+
+	// the directory might have been removed in the meantime
+	if (fNodes.Lookup(directory->ID()) != directory)
+		return B_OK;
+
+	for (PackageDirectoryList::ConstIterator it
+				= unpackingDirectory->PackageDirectories().GetIterator();
+			PackageDirectory* packageDirectory = it.Next();) {
+		if (packageDirectory->ChildrenLoaded())
+			continue;
+
+		Package* package = packageDirectory->GetPackage();
+		status_t error = package->LoadChildren(packageDirectory);
+		if (error != B_OK)
+			RETURN_ERROR(error);
+
+		// Add the nodes to the directory. Nobody can have seen the entries
+		// yet, so we don't send out entry notifications.
+		for (PackageNode* packageNode = packageDirectory->FirstChild();
+				packageNode != NULL;
+				packageNode = packageDirectory->NextChild(packageNode)) {
+			Node* node;
+			error = _AddPackageNode(directory, packageNode, false, node);
+			if (error == B_OK)
+				continue;
+
+			// remove the nodes we've added so far
+			for (PackageNode* addedNode = packageDirectory->FirstChild();
+					addedNode != packageNode;
+					addedNode = packageDirectory->NextChild(addedNode)) {
+				_RemovePackageNode(directory, addedNode,
+					directory->FindChild(addedNode->Name()), false);
+			}
+
+			package->UnloadChildren(packageDirectory);
+			RETURN_ERROR(error);
+		}
+	}
+
+	unpackingDirectory->SetContentsLoaded(true);
+	return B_OK;
+}
+
+
+/*!	Loads the contents of all directories that haven't been loaded yet.
+	The volume must not be locked.
+*/
+status_t
+Volume::LoadAllDirectoryContents()
+{
+	return _LoadPackageDirectories(NULL);
+}
+
+
+/*!	Loads the directories containing package entries that have the attribute
+	\a name, as well as the directories on their paths, so that the nodes for
+	these entries get into the indices. Other directories are left alone.
+	The volume must not be locked.
+*/
+status_t
+Volume::LoadAttributeDirectoryContents(const char* name)
+{
+	return _LoadPackageDirectories(name);
+}
+
+
+void
+Volume::GetMemoryUsage(packagefs_memory_usage& _usage) const
+{
+	memset(&_usage, 0, sizeof(_usage));
+
+	for (PackageDomainList::ConstIterator domainIt
+				= fPackageDomains.GetIterator();
+			PackageDomain* domain = domainIt.Next();) {
+		for (PackageFileNameHashTable::Iterator it
+					= domain->Packages().GetIterator();
+				Package* package = it.Next();) {
+			_usage.package_count++;
+			_usage.toc_entry_count += package->TOCIndex().CountEntries();
+			_usage.toc_size += package->TOCIndex().MemoryUsage();
+			_usage.package_node_count += package->LoadedNodeCount();
+			_usage.package_node_attribute_count
+				+= package->LoadedAttributeCount();
+			_usage.package_nodes_size += package->LoadedNodesSize();
+		}
+	}
+
+	_usage.node_count = fNodes.CountElements();
+}
+
+
+/*!	Loads the directories for the TOC entries of all packages, which contain
+	an entry with the attribute \a attribute, or for all TOC entries with
+	children, if \a attribute is \c NULL.
+	The volume must not be locked.
+*/
+status_t
+Volume::_LoadPackageDirectories(const char* attribute)
+{
+	struct DirectoryEntry {
+		Package*	package;
+		uint32		entry;
+	};
+
+	DirectoryEntry* directories = NULL;
+	int32 count = 0;
+	int32 capacity = 0;
+	status_t error = B_OK;
+
+	// Collect the TOC entries of the directories. The TOC indices don't change
+	// once the packages have been loaded, so their paths can be resolved
+	// without the volume lock, as long as we keep the packages referenced.
+	VolumeReadLocker volumeLocker(this);
+
+	for (PackageDomainList::Iterator domainIt
+				= fPackageDomains.GetIterator();
+			PackageDomain* domain = domainIt.Next();) {
+		for (PackageFileNameHashTable::Iterator it
+					= domain->Packages().GetIterator();
+				Package* package = it.Next();) {
+			const PackageTOCIndex& tocIndex = package->TOCIndex();
+			uint32 lastEntry = PackageTOCIndex::kNoEntry;
+
+			for (uint32 i = 0; i < tocIndex.CountEntries(); i++) {
+				const PackageTOCIndex::Entry& entry = tocIndex.EntryAt(i);
+				uint32 directoryEntry;
+				if (attribute == NULL) {
+					if (entry.firstChild == PackageTOCIndex::kNoEntry)
+						continue;
+					directoryEntry = i;
+				} else {
+					// the top level nodes are always loaded
+					if (entry.parent == PackageTOCIndex::kNoEntry
+						|| entry.parent == lastEntry
+						|| !tocIndex.HasAttribute(i, attribute)) {
+						continue;
+					}
+					directoryEntry = entry.parent;
+				}
+
+				if (count == capacity) {
+					int32 newCapacity = capacity == 0 ? 32 : capacity * 2;
+					DirectoryEntry* newDirectories = (DirectoryEntry*)realloc(
+						directories, newCapacity * sizeof(DirectoryEntry));
+					if (newDirectories == NULL) {
+						error = B_NO_MEMORY;
+						break;
+					}
+					directories = newDirectories;
+					capacity = newCapacity;
+				}
+
+				package->AcquireReference();
+				directories[count].package = package;
+				directories[count].entry = directoryEntry;
+				count++;
+				lastEntry = directoryEntry;
+			}
+		}
+	}
+
+	volumeLocker.Unlock();
+
+	// Load the directories. The entries are in TOC order, so a directory's
+	// ancestors have usually been loaded already.
+	for (int32 i = 0; i < count; i++) {
+		if (error == B_OK) {
+			error = _LoadPackageDirectory(directories[i].package,
+				directories[i].entry);
+		}
+		directories[i].package->ReleaseReference();
+	}
+
+	free(directories);
+	RETURN_ERROR(error);
+}
+
+
+/*!	Looks up the directory node for the TOC entry \a entry of \a package by
+	its path and loads its contents, as well as the contents of the
+	directories on the way. Stops silently, if a node on the path isn't a
+	directory, since then the entry is shadowed by another package.
+	The volume must not be locked.
+*/
+status_t
+Volume::_LoadPackageDirectory(Package* package, uint32 entry)
+{
+	const PackageTOCIndex& tocIndex = package->TOCIndex();
+
+	uint32 depth = 0;
+	for (uint32 index = entry; index != PackageTOCIndex::kNoEntry;
+			index = tocIndex.EntryAt(index).parent) {
+		depth++;
+	}
+
+	Directory* directory = fRootDirectory;
+	directory->AcquireReference();
+
+	// walk down the path -- the package's top level entry first
+	for (uint32 level = depth; level > 0; level--) {
+		uint32 index = entry;
+		for (uint32 i = 1; i < level; i++)
+			index = tocIndex.EntryAt(index).parent;
+
+		status_t error = LoadDirectoryContents(directory);
+		if (error != B_OK) {
+			directory->ReleaseReference();
+			RETURN_ERROR(error);
+		}
+
+		NodeReadLocker directoryLocker(directory);
+		Directory* childDirectory = dynamic_cast<Directory*>(
+			directory->FindChild(
+				tocIndex.StringAt(tocIndex.EntryAt(index).name)));
+		if (childDirectory != NULL)
+			childDirectory->AcquireReference();
+		directoryLocker.Unlock();
+
+		directory->ReleaseReference();
+		directory = childDirectory;
+		if (directory == NULL)
+			return B_OK;
+	}
+
+	status_t error = LoadDirectoryContents(directory);
+	directory->ReleaseReference();
+	RETURN_ERROR(error);
+}
+
+
 status_t
 Volume::_CreateUnpackingNode(mode_t mode, Directory* parent, const char* name,
 	UnpackingNode*& _node)
@@ -14,6 +14,8 @@
 #include <util/DoublyLinkedList.h>
 #include <util/KMessage.h>
 
+#include <file_systems/packagefs_ioctl.h>
+
 #include "Index.h"
 #include "Node.h"
 #include "NodeListener.h"
@@ -96,6 +98,18 @@ public:
 
 			status_t			AddPackageDomain(const char* path);
 
+			status_t			LoadDirectoryContents(Directory* directory);
+									// volume must not be locked
+			status_t			LoadAllDirectoryContents();
+									// volume must not be locked
+			status_t			LoadAttributeDirectoryContents(
+									const char* name);
+									// volume must not be locked
+
+			void				GetMemoryUsage(
+									packagefs_memory_usage& _usage) const;
+									// volume must be read-locked
+
 private:
 	// PackageLinksListener
 	virtual	void				PackageLinkNodeAdded(Node* node);
@@ -191,6 +205,11 @@ private:
 
 	inline	Volume*				_SystemVolumeIfNotSelf() const;
 
+			status_t			_LoadPackageDirectories(
+									const char* attribute);
+			status_t			_LoadPackageDirectory(Package* package,
+									uint32 entry);
+
 			void				_NotifyNodeAdded(Node* node);
 			void				_NotifyNodeRemoved(Node* node);
 			void				_NotifyNodeChanged(Node* node,
@@ -179,7 +179,13 @@ packagefs_lookup(fs_volume* fsVolume, fs_vnode* fsDir, const char* entryName,
 		return volume->GetVNode(*_vnid, node);
 	}
 
-	// resolve normal entries -- look up the node
+	// resolve normal entries -- make sure the directory's entries have been
+	// added and look up the node
+	status_t error = volume->LoadDirectoryContents(
+		dynamic_cast<Directory*>(dir));
+	if (error != B_OK)
+		RETURN_ERROR(error);
+
 	NodeReadLocker dirLocker(dir);
 	Node* node = dynamic_cast<Directory*>(dir)->FindChild(entryName);
 	if (node == NULL)
@@ -281,6 +287,32 @@ packagefs_io(fs_volume* fsVolume, fs_vnode* fsNode, void* cookie,
 }
 
 
+static status_t
+packagefs_ioctl(fs_volume* fsVolume, fs_vnode* fsNode, void* cookie,
+	uint32 operation, void* buffer, size_t size)
+{
+	Volume* volume = (Volume*)fsVolume->private_volume;
+
+	FUNCTION("volume: %p, node: %p, cookie: %p, operation: %" B_PRIu32 "\n",
+		volume, fsNode->private_node, cookie, operation);
+
+	switch (operation) {
+		case PACKAGE_FS_IOCTL_GET_MEMORY_USAGE:
+		{
+			if (buffer == NULL || size < sizeof(packagefs_memory_usage))
+				RETURN_ERROR(B_BAD_VALUE);
+
+			VolumeReadLocker volumeLocker(volume);
+			volume->GetMemoryUsage(*(packagefs_memory_usage*)buffer);
+			return B_OK;
+		}
+
+		default:
+			return B_DEV_INVALID_IOCTL;
+	}
+}
+
+
 // #pragma mark - Nodes
 
 
@@ -531,7 +563,6 @@ packagefs_open_dir(fs_volume* fsVolume, fs_vnode* fsNode, void** _cookie)
 	Node* node = (Node*)fsNode->private_node;
 
 	FUNCTION("volume: %p, node: %p (%lld)\n", volume, node, node->ID());
-	TOUCH(volume);
 
 	if (!S_ISDIR(node->Mode()))
 		return B_NOT_A_DIRECTORY;
@@ -542,6 +573,11 @@ packagefs_open_dir(fs_volume* fsVolume, fs_vnode* fsNode, void** _cookie)
 	if (error != B_OK)
 		return error;
 
+	// make sure the directory's entries have been added
+	error = volume->LoadDirectoryContents(dir);
+	if (error != B_OK)
+		RETURN_ERROR(error);
+
 	// create a cookie
 	NodeWriteLocker dirLocker(dir);
 	DirectoryCookie* cookie = new(std::nothrow) DirectoryCookie(dir);
@@ -991,10 +1027,15 @@ packagefs_open_query(fs_volume* fsVolume, const char* queryString, uint32 flags,
 		B_PRId32 ", token: %" B_PRIu32 "\n", volume, queryString, flags, port,
 		token);
 
+	// only nodes that have been loaded are in the indices
+	status_t error = Query::LoadCandidateNodes(volume, queryString);
+	if (error != B_OK)
+		return error;
+
 	VolumeWriteLocker volumeWriteLocker(volume);
 
 	Query* query;
-	status_t error = Query::Create(volume, queryString, flags, port, token,
+	error = Query::Create(volume, queryString, flags, port, token,
 		query);
 	if (error != B_OK)
 		return error;
@@ -1179,7 +1220,7 @@ fs_vnode_ops gPackageFSVnodeOps = {
 
 	NULL,	// get_file_map,
 
-	NULL,	// ioctl,
+	&packagefs_ioctl,
 	NULL,	// set_flags,
 	NULL,	// select,
 	NULL,	// deselect,
@@ -24,6 +24,7 @@
 
 #include <new>
 #include <stdio.h>
+#include <string.h>
 
 
 static const uint8 kCursorData[] = { 16 /* size, 16x16 */,
@@ -72,6 +73,9 @@ RemoteView::RemoteView(BRect frame, uint16 listenPort)
 	fCursorBitmap(NULL),
 	fCursorVisible(false)
 {
+	memset(fCachedBitmaps, 0, sizeof(fCachedBitmaps));
+	memset(fCachedBitmapChecksums, 0, sizeof(fCachedBitmapChecksums));
+
 	fReceiveBuffer = new(std::nothrow) StreamingRingBuffer(16 * 1024);
 	if (fReceiveBuffer == NULL) {
 		fInitStatus = B_NO_MEMORY;
@@ -167,6 +171,8 @@ RemoteView::~RemoteView()
 
 	int32 result;
 	wait_for_thread(fDrawThread, &result);
+
+	_EmptyBitmapCache();
 }
 
 
@@ -481,6 +487,9 @@ RemoteView::_DrawThread()
 					continue;
 				}
 
+				// the server starts out with an empty bitmap cache as well
+				_EmptyBitmapCache();
+
 				BRect bounds = fOffscreenBitmap->Bounds();
 				reply.Start(RP_UPDATE_DISPLAY_MODE);
 				reply.Add(bounds.IntegerWidth() + 1);
@@ -773,6 +782,52 @@ RemoteView::_DrawThread()
 				break;
 			}
 
+			case RP_DRAW_CACHED_BITMAP:
+			{
+				BRect bitmapRect, viewRect;
+				uint32 options, slot;
+				uint64 checksum;
+				bool cached;
+
+				message.Read(bitmapRect);
+				message.Read(viewRect);
+				message.Read(options);
+				message.Read(slot);
+				message.Read(checksum);
+				if (message.Read(cached) != B_OK
+					|| slot >= RemoteBitmapCache::SLOT_COUNT) {
+					continue;
+				}
+
+				if (!cached) {
+					// the server has assigned the slot to the new bitmap
+					delete fCachedBitmaps[slot];
+					fCachedBitmaps[slot] = NULL;
+					fCachedBitmapChecksums[slot] = 0;
+
+					BBitmap *bitmap;
+					if (message.ReadBitmap(&bitmap) == B_OK && bitmap != NULL) {
+						fCachedBitmaps[slot] = bitmap;
+						fCachedBitmapChecksums[slot] = checksum;
+					}
+				}
+
+				BBitmap *bitmap = fCachedBitmaps[slot];
+				if (bitmap == NULL || fCachedBitmapChecksums[slot] != checksum) {
+					// have the server send the bitmap again next time
+					TRACE_ERROR("bitmap missing in cache slot %lu\n", slot);
+					reply.Start(RP_DROP_CACHED_BITMAP);
+					reply.Add(slot);
+					reply.Add(checksum);
+					reply.Flush();
+					continue;
+				}
+
+				offscreen->DrawBitmap(bitmap, bitmapRect, viewRect, options);
+				invalidRegion.Include(viewRect);
+				break;
+			}
+
 			case RP_DRAW_BITMAP_RECTS:
 			{
 				color_space colorSpace;
@@ -1315,6 +1370,17 @@ RemoteView::_DrawThread()
 }
 
 
+void
+RemoteView::_EmptyBitmapCache()
+{
+	for (int32 i = 0; i < RemoteBitmapCache::SLOT_COUNT; i++) {
+		delete fCachedBitmaps[i];
+		fCachedBitmaps[i] = NULL;
+		fCachedBitmapChecksums[i] = 0;
+	}
+}
+
+
 BRect
 RemoteView::_BuildInvalidateRect(BPoint *points, int32 pointCount)
 {
@@ -8,6 +8,8 @@
 #ifndef REMOTE_VIEW_H
 #define REMOTE_VIEW_H
 
+#include "RemoteBitmapCache.h"
+
 #include <Cursor.h>
 #include <NetEndpoint.h>
 #include <ObjectList.h>
@@ -59,6 +61,8 @@ static	int32						_DrawEntry(void *data);
 		BRect						_BuildInvalidateRect(BPoint *points,
 										int32 pointCount);
 
+		void						_EmptyBitmapCache();
+
 		status_t					fInitStatus;
 		bool						fIsConnected;
 
@@ -81,6 +85,11 @@ static	int32						_DrawEntry(void *data);
 		bool						fCursorVisible;
 
 		BObjectList<engine_state>	fStates;
+
+		BBitmap *					fCachedBitmaps[
+										RemoteBitmapCache::SLOT_COUNT];
+		uint64						fCachedBitmapChecksums[
+										RemoteBitmapCache::SLOT_COUNT];
 };
 
 #endif // REMOTE_VIEW_H
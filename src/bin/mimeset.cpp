@@ -1,5 +1,6 @@
 /*
  * Copyright 2005-2006, Axel Dörfler, axeld@pinc-software.de. All rights reserved.
+ * Copyright 2011, Haiku, Inc. All rights reserved.
  * Distributed under the terms of the MIT License.
  */
 
@@ -7,6 +8,21 @@
 #include <Application.h>
 #include <Mime.h>
 
+#ifdef HAIKU_TARGET_PLATFORM_HAIKU
+#	include <Entry.h>
+#	include <Locker.h>
+#	include <Looper.h>
+#	include <Message.h>
+#	include <Messenger.h>
+#	include <Path.h>
+
+#	include <RegistrarDefs.h>
+#	include <RosterPrivate.h>
+
+#	include <map>
+#	include <string>
+#endif
+
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -19,10 +35,16 @@ extern const char *__progname;
 static const char *sProgramName = __progname;
 #endif
 
+static const int32 kDefaultJobs = 4;
+static const int32 kMaxJobs = 8;
+	// each job occupies one of the registrar's few MIME update threads
+
 // options
 bool gFiles = true;
 bool gApps = false;
 int gForce = 0; // B_UPDATE_MIME_INFO_NO_FORCE;
+int32 gJobs = kDefaultJobs;
+bool gProgress = false;
 
 
 void
@@ -35,14 +57,155 @@ usage(int status)
 		"  	\t  (will not overwrite the 'type' of a file)\n"
 		"  -F\t\tforce updating, even if previously updated\n"
 		"  	\t  (will overwrite the 'type' of a file)\n"
+		"  -j <count>\tupdate up to <count> PATHs at the same time (default\n"
+		"  	\t  %ld, at most %ld)\n"
+		"  -p\t\tshow the number of entries processed so far\n"
 		"  --help\tdisplay this help information\n"
 		"When PATH is @, file names are read from stdin\n\n",
-		sProgramName);
+		sProgramName, kDefaultJobs, kMaxJobs);
 
 	exit(status);
 }
 
 
+#ifdef HAIKU_TARGET_PLATFORM_HAIKU
+
+
+using namespace BPrivate;
+
+static const uint32 kMsgUpdateDone = 'updn';
+static const int32 kQueueSize = 64;
+static const bigtime_t kProgressInterval = 200000;
+
+
+class ProgressReporter : public BLooper {
+public:
+	ProgressReporter()
+		:
+		BLooper("progress reporter"),
+		fFinishedEntries(0),
+		fLastUpdate(0)
+	{
+	}
+
+	virtual void MessageReceived(BMessage* message)
+	{
+		switch (message->what) {
+			case B_REG_MIME_UPDATE_PROGRESS:
+			case kMsgUpdateDone:
+			{
+				entry_ref ref;
+				int64 entries;
+				if (message->FindRef("entry", &ref) != B_OK
+					|| message->FindInt64("entries", &entries) != B_OK) {
+					break;
+				}
+
+				BPath path(&ref);
+				std::string key = path.InitCheck() == B_OK ? path.Path() : "";
+
+				if (message->what == kMsgUpdateDone) {
+					fRunning.erase(key);
+					fFinishedEntries += entries;
+				} else
+					fRunning[key] = entries;
+
+				bigtime_t now = system_time();
+				if (now - fLastUpdate >= kProgressInterval) {
+					fLastUpdate = now;
+					Print("");
+				}
+				break;
+			}
+
+			default:
+				BLooper::MessageReceived(message);
+				break;
+		}
+	}
+
+	void Print(const char* end)
+	{
+		int64 entries = fFinishedEntries;
+		std::map<std::string, int64>::iterator it = fRunning.begin();
+		for (; it != fRunning.end(); it++)
+			entries += it->second;
+
+		fprintf(stderr, "\r%lld entries processed%s", entries, end);
+	}
+
+private:
+	std::map<std::string, int64>	fRunning;
+	int64							fFinishedEntries;
+	bigtime_t						fLastUpdate;
+};
+
+
+static ProgressReporter* sProgressReporter = NULL;
+
+// the queue of paths waiting for a job
+static char* sQueue[kQueueSize];
+static int32 sQueueHead = 0;
+static int32 sQueueCount = 0;
+static BLocker sQueueLock("path queue");
+static sem_id sQueueFreeSem = -1;
+static sem_id sQueueUsedSem = -1;
+static thread_id sJobThreads[kMaxJobs];
+static int32 sJobCount = 0;
+static volatile bool sFailed = false;
+
+
+/*!	Does the same as update_mime_info() or create_app_meta_mime(), but asks
+	the registrar to send its progress to the progress reporter.
+*/
+static status_t
+update_with_progress(uint32 what, const char* path)
+{
+	BEntry entry;
+	entry_ref ref;
+	status_t status = entry.SetTo(path);
+	if (status == B_OK)
+		status = entry.GetRef(&ref);
+	if (status != B_OK)
+		return status;
+
+	BMessage request(what);
+	if (request.AddRef("entry", &ref) != B_OK
+		|| request.AddBool("recursive", true) != B_OK
+		|| request.AddBool("synchronous", true) != B_OK
+		|| request.AddInt32("force", gForce) != B_OK
+		|| request.AddMessenger("progress target",
+			BMessenger(sProgressReporter)) != B_OK) {
+		return B_NO_MEMORY;
+	}
+
+	BMessage reply;
+	status = BRoster::Private().SendTo(&request, &reply, true);
+	if (status == B_OK && reply.what != B_REG_RESULT)
+		status = B_BAD_VALUE;
+
+	int32 result;
+	if (status == B_OK)
+		status = reply.FindInt32("result", &result);
+	if (status == B_OK)
+		status = result;
+
+	int64 entries;
+	if (reply.FindInt64("entries", &entries) != B_OK)
+		entries = status == B_OK ? 1 : 0;
+
+	BMessage done(kMsgUpdateDone);
+	done.AddRef("entry", &ref);
+	done.AddInt64("entries", entries);
+	sProgressReporter->PostMessage(&done);
+
+	return status;
+}
+
+
+#endif	// HAIKU_TARGET_PLATFORM_HAIKU
+
+
 status_t
 process_file(const char *path)
 {
@@ -52,10 +215,22 @@ process_file(const char *path)
 	if (!entry.Exists())
 		status = B_ENTRY_NOT_FOUND;
 
-	if (gFiles && status >= B_OK)
-		status = update_mime_info(path, true, true, gForce);
-	if (gApps && status >= B_OK)
-		status = create_app_meta_mime(path, true, true, gForce);
+#ifdef HAIKU_TARGET_PLATFORM_HAIKU
+	if (sProgressReporter != NULL) {
+		if (gFiles && status >= B_OK)
+			status = update_with_progress(B_REG_MIME_UPDATE_MIME_INFO, path);
+		if (gApps && status >= B_OK) {
+			status = update_with_progress(B_REG_MIME_CREATE_APP_META_MIME,
+				path);
+		}
+	} else
+#endif
+	{
+		if (gFiles && status >= B_OK)
+			status = update_mime_info(path, true, true, gForce);
+		if (gApps && status >= B_OK)
+			status = create_app_meta_mime(path, true, true, gForce);
+	}
 
 	if (status < B_OK) {
 		fprintf(stderr, "%s: \"%s\": %s\n",
@@ -65,6 +240,157 @@ process_file(const char *path)
 }
 
 
+#ifdef HAIKU_TARGET_PLATFORM_HAIKU
+
+
+/*!	Removes the next path from the queue, waiting for one if necessary.
+	Returns \c NULL when the jobs shall stop.
+*/
+static char*
+dequeue_path()
+{
+	while (acquire_sem(sQueueUsedSem) == B_INTERRUPTED)
+		;
+
+	sQueueLock.Lock();
+	char* path = sQueue[sQueueHead];
+	sQueueHead = (sQueueHead + 1) % kQueueSize;
+	sQueueCount--;
+	sQueueLock.Unlock();
+
+	release_sem(sQueueFreeSem);
+	return path;
+}
+
+
+/*!	Adds a path to the queue, waiting for a free slot if necessary.
+	\a path is freed by the job that processes it.
+*/
+static void
+queue_path(char* path)
+{
+	while (acquire_sem(sQueueFreeSem) == B_INTERRUPTED)
+		;
+
+	sQueueLock.Lock();
+	sQueue[(sQueueHead + sQueueCount) % kQueueSize] = path;
+	sQueueCount++;
+	sQueueLock.Unlock();
+
+	release_sem(sQueueUsedSem);
+}
+
+
+static status_t
+job_thread(void* /*data*/)
+{
+	while (char* path = dequeue_path()) {
+		// after a failure, the remaining paths are dropped
+		if (!sFailed && process_file(path) != B_OK)
+			sFailed = true;
+		free(path);
+	}
+
+	return B_OK;
+}
+
+
+/*!	Starts the jobs processing the paths. If that fails, the paths are
+	processed one after the other.
+*/
+static void
+start_jobs()
+{
+	if (gJobs < 2)
+		return;
+
+	sQueueFreeSem = create_sem(kQueueSize, "free path slots");
+	sQueueUsedSem = create_sem(0, "queued paths");
+	if (sQueueFreeSem < 0 || sQueueUsedSem < 0)
+		return;
+
+	for (int32 i = 0; i < gJobs; i++) {
+		thread_id thread = spawn_thread(&job_thread, "mimeset job",
+			B_NORMAL_PRIORITY, NULL);
+		if (thread < 0 || resume_thread(thread) != B_OK)
+			break;
+		sJobThreads[sJobCount++] = thread;
+	}
+}
+
+
+/*!	Lets the jobs process the remaining paths, and waits for them to quit.
+*/
+static void
+stop_jobs()
+{
+	for (int32 i = 0; i < sJobCount; i++)
+		queue_path(NULL);
+
+	for (int32 i = 0; i < sJobCount; i++) {
+		status_t result;
+		wait_for_thread(sJobThreads[i], &result);
+	}
+	sJobCount = 0;
+}
+
+
+#endif	// HAIKU_TARGET_PLATFORM_HAIKU
+
+
+/*!	Processes the given path, or hands it to a job, if there are any.
+	Returns \c false, if processing a path failed, and no more paths shall
+	be processed.
+*/
+static bool
+process_path(const char* path)
+{
+#ifdef HAIKU_TARGET_PLATFORM_HAIKU
+	if (sJobCount > 0) {
+		if (sFailed)
+			return false;
+
+		char* copy = strdup(path);
+		if (copy == NULL) {
+			fprintf(stderr, "%s: \"%s\": %s\n", sProgramName, path,
+				strerror(B_NO_MEMORY));
+			sFailed = true;
+			return false;
+		}
+
+		queue_path(copy);
+		return true;
+	}
+#endif
+
+	return process_file(path) == B_OK;
+}
+
+
+/*!	Waits until all paths have been processed. Returns \c false, if any of
+	them failed.
+*/
+static bool
+finish_processing()
+{
+#ifdef HAIKU_TARGET_PLATFORM_HAIKU
+	stop_jobs();
+
+	if (sProgressReporter != NULL) {
+		if (sProgressReporter->Lock()) {
+			sProgressReporter->Print("\n");
+			sProgressReporter->Quit();
+		}
+		sProgressReporter = NULL;
+	}
+
+	return !sFailed;
+#else
+	return true;
+#endif
+}
+
+
 int
 main(int argc, char **argv)
 {
@@ -87,6 +413,16 @@ main(int argc, char **argv)
 			gForce = 1; // B_UPDATE_MIME_INFO_FORCE_KEEP_TYPE;
 		else if (!strcmp(arg, "-F"))
 			gForce = 2; // B_UPDATE_MIME_INFO_FORCE_UPDATE_ALL;
+		else if (!strcmp(arg, "-j")) {
+			if (argv[1] == NULL)
+				usage(1);
+			gJobs = atol(*++argv);
+			if (gJobs < 1 || gJobs > kMaxJobs) {
+				fprintf(stderr, "invalid job count \"%s\"\n", *argv);
+				usage(1);
+			}
+		} else if (!strcmp(arg, "-p"))
+			gProgress = true;
 		else if (!strcmp(arg, "--help"))
 			usage(0);
 		else {
@@ -99,24 +435,33 @@ main(int argc, char **argv)
 
 	BApplication app("application/x-vnd.haiku.mimeset");
 
-	while (*argv) {
+#ifdef HAIKU_TARGET_PLATFORM_HAIKU
+	if (gProgress) {
+		sProgressReporter = new ProgressReporter;
+		sProgressReporter->Run();
+	}
+
+	start_jobs();
+#endif
+
+	bool success = true;
+	while (success && *argv) {
 		char *arg = *argv++;
 
 		if (!strcmp(arg, "@")) {
 			// read file names from stdin
 			char name[B_PATH_NAME_LENGTH];
-			while (fgets(name, sizeof(name), stdin) != NULL) {
+			while (success && fgets(name, sizeof(name), stdin) != NULL) {
 				name[strlen(name) - 1] = '\0';
 					// remove trailing '\n'
-				if (process_file(name) != B_OK)
-					exit(1);
+				success = process_path(name);
 			}
-		} else {
-			if (process_file(arg) != B_OK)
-				exit(1);
-		}
+		} else
+			success = process_path(arg);
 	}
 
+	if (!finish_processing() || !success)
+		exit(1);
+
 	return 0;
 }
-
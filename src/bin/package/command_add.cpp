@@ -36,6 +36,7 @@ command_add(int argc, const char* const* argv)
 	bool quiet = false;
 	bool verbose = false;
 	bool force = false;
+	bool writeTOCIndex = false;
 
 	while (true) {
 		static struct option sLongOptions[] = {
@@ -46,7 +47,7 @@ command_add(int argc, const char* const* argv)
 		};
 
 		opterr = 0; // don't print errors
-		int c = getopt_long(argc, (char**)argv, "+C:fhi:qv", sLongOptions,
+		int c = getopt_long(argc, (char**)argv, "+C:fhi:qtv", sLongOptions,
 			NULL);
 		if (c == -1)
 			break;
@@ -72,6 +73,10 @@ command_add(int argc, const char* const* argv)
 				quiet = true;
 				break;
 
+			case 't':
+				writeTOCIndex = true;
+				break;
+
 			case 'v':
 				verbose = true;
 				break;
@@ -100,7 +105,8 @@ command_add(int argc, const char* const* argv)
 	PackageWriterListener listener(verbose, quiet);
 	BPackageWriter packageWriter(&listener);
 	status_t result = packageWriter.Init(packageFileName,
-		B_HPKG_WRITER_UPDATE_PACKAGE | (force ? B_HPKG_WRITER_FORCE_ADD : 0));
+		B_HPKG_WRITER_UPDATE_PACKAGE | (force ? B_HPKG_WRITER_FORCE_ADD : 0)
+			| (writeTOCIndex ? B_HPKG_WRITER_TOC_INDEX : 0));
 	if (result != B_OK)
 		return 1;
 
@@ -27,6 +27,7 @@
 
 using BPackageKit::BHPKG::BPackageWriterListener;
 using BPackageKit::BHPKG::BPackageWriter;
+using BPackageKit::BHPKG::B_HPKG_WRITER_TOC_INDEX;
 
 
 int
@@ -36,6 +37,7 @@ command_create(int argc, const char* const* argv)
 	const char* packageInfoFileName = NULL;
 	const char* installPath = NULL;
 	bool isBuildPackage = false;
+	bool writeTOCIndex = false;
 	bool quiet = false;
 	bool verbose = false;
 
@@ -48,7 +50,7 @@ command_create(int argc, const char* const* argv)
 		};
 
 		opterr = 0; // don't print errors
-		int c = getopt_long(argc, (char**)argv, "+bC:hi:I:qv", sLongOptions,
+		int c = getopt_long(argc, (char**)argv, "+bC:hi:I:qtv", sLongOptions,
 			NULL);
 		if (c == -1)
 			break;
@@ -78,6 +80,10 @@ command_create(int argc, const char* const* argv)
 				quiet = true;
 				break;
 
+			case 't':
+				writeTOCIndex = true;
+				break;
+
 			case 'v':
 				verbose = true;
 				break;
@@ -104,7 +110,8 @@ command_create(int argc, const char* const* argv)
 	// create package
 	PackageWriterListener listener(verbose, quiet);
 	BPackageWriter packageWriter(&listener);
-	status_t result = packageWriter.Init(packageFileName);
+	status_t result = packageWriter.Init(packageFileName,
+		writeTOCIndex ? B_HPKG_WRITER_TOC_INDEX : 0);
 	if (result != B_OK)
 		return 1;
 
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2011, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <package/PackageDeltaWriter.h>
+
+#include "package.h"
+#include "StandardErrorOutput.h"
+
+
+using BPackageKit::BPrivate::PackageDeltaWriter;
+
+
+int
+command_delta(int argc, const char* const* argv)
+{
+	bool quiet = false;
+
+	while (true) {
+		static struct option sLongOptions[] = {
+			{ "help", no_argument, 0, 'h' },
+			{ 0, 0, 0, 0 }
+		};
+
+		opterr = 0; // don't print errors
+		int c = getopt_long(argc, (char**)argv, "+hq", sLongOptions, NULL);
+		if (c == -1)
+			break;
+
+		switch (c) {
+			case 'h':
+				print_usage_and_exit(false);
+				break;
+
+			case 'q':
+				quiet = true;
+				break;
+
+			default:
+				print_usage_and_exit(true);
+				break;
+		}
+	}
+
+	// Three arguments should remain -- the old and new package file names and
+	// the delta file name.
+	if (optind + 3 != argc)
+		print_usage_and_exit(true);
+
+	const char* oldPackageFileName = argv[optind++];
+	const char* newPackageFileName = argv[optind++];
+	const char* deltaFileName = argv[optind++];
+
+	StandardErrorOutput errorOutput;
+	PackageDeltaWriter deltaWriter(&errorOutput);
+	status_t error = deltaWriter.Write(oldPackageFileName, newPackageFileName,
+		deltaFileName);
+	if (error != B_OK)
+		return 1;
+
+	if (!quiet) {
+		printf("delta %s: %llu bytes copied from %s, %llu bytes of new data\n",
+			deltaFileName, (unsigned long long)deltaWriter.CopiedSize(),
+			oldPackageFileName, (unsigned long long)deltaWriter.DataSize());
+	}
+
+	return 0;
+}
@@ -734,8 +734,13 @@ command_extract(int argc, const char* const* argv)
 	if (packageInfoFileName != NULL)
 		handler.SetPackageInfoFile(packageInfoFileName);
 
-	// extract
-	error = packageReader.ParseContent(&handler);
+	// extract -- if only a single entry shall be extracted, let the reader
+	// skip the rest of the package, if it can
+	if (argc - explicitEntriesIndex == 1) {
+		error = packageReader.ParseContent(&handler,
+			argv[explicitEntriesIndex]);
+	} else
+		error = packageReader.ParseContent(&handler);
 	if (error != B_OK)
 		return 1;
 
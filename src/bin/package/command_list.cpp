@@ -12,6 +12,10 @@
 #include <string.h>
 #include <time.h>
 
+#include <algorithm>
+
+#include <StorageDefs.h>
+
 #include <package/hpkg/PackageContentHandler.h>
 #include <package/hpkg/PackageEntry.h>
 #include <package/hpkg/PackageEntryAttribute.h>
@@ -29,10 +33,11 @@ using namespace BPackageKit;
 
 
 struct PackageContentListHandler : BPackageContentHandler {
-	PackageContentListHandler(bool listAttributes)
+	PackageContentListHandler(bool listAttributes, const char* subPath)
 		:
 		fLevel(0),
-		fListAttribute(listAttributes)
+		fListAttribute(listAttributes),
+		fSubPath(subPath)
 	{
 	}
 
@@ -40,6 +45,9 @@ struct PackageContentListHandler : BPackageContentHandler {
 	{
 		fLevel++;
 
+		if (!_IsListed(entry))
+			return B_OK;
+
 		int indentation = (fLevel - 1) * 2;
 		printf("%*s", indentation, "");
 
@@ -83,7 +91,7 @@ struct PackageContentListHandler : BPackageContentHandler {
 	virtual status_t HandleEntryAttribute(BPackageEntry* entry,
 		BPackageEntryAttribute* attribute)
 	{
-		if (!fListAttribute)
+		if (!fListAttribute || !_IsListed(entry))
 			return B_OK;
 
 		int indentation = fLevel * 2;
@@ -249,6 +257,41 @@ struct PackageContentListHandler : BPackageContentHandler {
 	}
 
 private:
+	bool _IsListed(const BPackageEntry* entry) const
+	{
+		if (fSubPath == NULL)
+			return true;
+
+		// get the entry's path
+		char path[B_PATH_NAME_LENGTH];
+		if (!_GetPath(entry, path, sizeof(path)))
+			return false;
+
+		// list the entry, if it is an ancestor or a descendant of the sub path
+		size_t pathLength = strlen(path);
+		size_t subPathLength = strlen(fSubPath);
+		size_t length = std::min(pathLength, subPathLength);
+		if (strncmp(path, fSubPath, length) != 0)
+			return false;
+
+		return pathLength == subPathLength
+			|| (pathLength < subPathLength ? fSubPath : path)[length] == '/';
+	}
+
+	static bool _GetPath(const BPackageEntry* entry, char* buffer,
+		size_t bufferSize)
+	{
+		if (entry->Parent() != NULL) {
+			if (!_GetPath(entry->Parent(), buffer, bufferSize))
+				return false;
+			if (strlcat(buffer, "/", bufferSize) >= bufferSize)
+				return false;
+		} else
+			buffer[0] = '\0';
+
+		return strlcat(buffer, entry->Name(), bufferSize) < bufferSize;
+	}
+
 	static const char* _PermissionString(char* buffer, uint32 mode, bool sticky)
 	{
 		buffer[0] = (mode & 0x4) != 0 ? 'r' : '-';
@@ -277,11 +320,51 @@ private:
 	}
 
 private:
-	int		fLevel;
-	bool	fListAttribute;
+	int			fLevel;
+	bool		fListAttribute;
+	const char*	fSubPath;
 };
 
 
+/*!	Copies \a path to \a buffer without leading and trailing slashes and
+	with each sequence of slashes reduced to a single one, so that it can be
+	compared with the paths of the package entries. Returns \c NULL, if
+	nothing is left, i.e. the whole package shall be listed.
+*/
+static const char*
+normalize_sub_path(const char* path, char* buffer, size_t bufferSize)
+{
+	size_t length = 0;
+	while (*path != '\0') {
+		if (*path == '/') {
+			path++;
+			continue;
+		}
+
+		if (length > 0) {
+			if (length < bufferSize)
+				buffer[length] = '/';
+			length++;
+		}
+
+		while (*path != '\0' && *path != '/') {
+			if (length < bufferSize)
+				buffer[length] = *path;
+			length++;
+			path++;
+		}
+	}
+
+	if (length >= bufferSize) {
+		fprintf(stderr, "Error: Path too long\n");
+		exit(1);
+	}
+
+	buffer[length] = '\0';
+	return length > 0 ? buffer : NULL;
+}
+
+
 int
 command_list(int argc, const char* const* argv)
 {
@@ -313,12 +396,20 @@ command_list(int argc, const char* const* argv)
 		}
 	}
 
-	// One argument should remain -- the package file name.
-	if (optind + 1 != argc)
+	// The package file name and optionally a path inside the package should
+	// remain.
+	if (optind + 1 != argc && optind + 2 != argc)
 		print_usage_and_exit(true);
 
 	const char* packageFileName = argv[optind++];
 
+	char subPathBuffer[B_PATH_NAME_LENGTH];
+	const char* subPath = NULL;
+	if (optind < argc) {
+		subPath = normalize_sub_path(argv[optind++], subPathBuffer,
+			sizeof(subPathBuffer));
+	}
+
 	// open package
 	StandardErrorOutput errorOutput;
 	BPackageReader packageReader(&errorOutput);
@@ -327,8 +418,10 @@ command_list(int argc, const char* const* argv)
 		return 1;
 
 	// list
-	PackageContentListHandler handler(listAttributes);
-	error = packageReader.ParseContent(&handler);
+	PackageContentListHandler handler(listAttributes, subPath);
+	error = subPath != NULL
+		? packageReader.ParseContent(&handler, subPath)
+		: packageReader.ParseContent(&handler);
 	if (error != B_OK)
 		return 1;
 
@@ -0,0 +1,141 @@
+/*
+ * Copyright 2011, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <Entry.h>
+
+#include <package/ApplyPackageDeltaJob.h>
+#include <package/ChecksumAccessors.h>
+#include <package/Context.h>
+#include <package/Job.h>
+#include <package/ValidateChecksumJob.h>
+
+#include "package.h"
+
+
+using namespace BPackageKit;
+using namespace BPackageKit::BPrivate;
+
+
+namespace {
+
+
+struct DecisionProvider : BDecisionProvider {
+	virtual bool YesNoDecisionNeeded(const BString& description,
+		const BString& question, const BString& yes, const BString& no,
+		const BString& defaultChoice)
+	{
+		return false;
+	}
+};
+
+
+struct JobStateListener : BJobStateListener {
+	JobStateListener(bool quiet)
+		:
+		fQuiet(quiet)
+	{
+	}
+
+	virtual void JobStarted(BJob* job)
+	{
+		if (!fQuiet)
+			printf("%s ...\n", job->Title().String());
+	}
+
+	virtual void JobFailed(BJob* job)
+	{
+		BString error = job->ErrorString();
+		if (error.Length() > 0)
+			fprintf(stderr, "Error: %s\n", error.String());
+		fprintf(stderr, "%s failed: %s\n", job->Title().String(),
+			strerror(job->Result()));
+	}
+
+private:
+	bool	fQuiet;
+};
+
+
+}	// unnamed namespace
+
+
+int
+command_patch(int argc, const char* const* argv)
+{
+	bool quiet = false;
+
+	while (true) {
+		static struct option sLongOptions[] = {
+			{ "help", no_argument, 0, 'h' },
+			{ 0, 0, 0, 0 }
+		};
+
+		opterr = 0; // don't print errors
+		int c = getopt_long(argc, (char**)argv, "+hq", sLongOptions, NULL);
+		if (c == -1)
+			break;
+
+		switch (c) {
+			case 'h':
+				print_usage_and_exit(false);
+				break;
+
+			case 'q':
+				quiet = true;
+				break;
+
+			default:
+				print_usage_and_exit(true);
+				break;
+		}
+	}
+
+	// Three arguments should remain -- the old package file name, the delta
+	// file name, and the name of the package file to create.
+	if (optind + 3 != argc)
+		print_usage_and_exit(true);
+
+	BEntry oldPackageEntry(argv[optind++]);
+	BEntry deltaEntry(argv[optind++]);
+	BEntry newPackageEntry(argv[optind++]);
+
+	DecisionProvider decisionProvider;
+	JobStateListener jobStateListener(quiet);
+	BContext context(decisionProvider, jobStateListener);
+	if (context.InitCheck() != B_OK) {
+		fprintf(stderr, "Error: failed to initialize context: %s\n",
+			strerror(context.InitCheck()));
+		return 1;
+	}
+
+	// make sure the delta applies to the given package, apply it, and check
+	// that the result is what the delta was created from
+	ValidateChecksumJob validateOldJob(context,
+		"Validating checksum of the old package",
+		new PackageDeltaChecksumAccessor(deltaEntry, false),
+		new GeneralFileChecksumAccessor(oldPackageEntry));
+	ApplyPackageDeltaJob applyJob(context, "Applying package delta",
+		oldPackageEntry, deltaEntry, newPackageEntry);
+	ValidateChecksumJob validateNewJob(context,
+		"Validating checksum of the new package",
+		new PackageDeltaChecksumAccessor(deltaEntry, true),
+		new GeneralFileChecksumAccessor(newPackageEntry));
+
+	if (validateOldJob.Run() != B_OK || applyJob.Run() != B_OK)
+		return 1;
+
+	if (validateNewJob.Run() != B_OK) {
+		newPackageEntry.Remove();
+		return 1;
+	}
+
+	return 0;
+}
@@ -36,6 +36,9 @@ static const char* kUsage =
 	"                 \".PackageInfo\", overriding a \".PackageInfo\" file,\n"
 	"                 existing.\n"
 	"    -q         - Be quiet (don't show any output except for errors).\n"
+	"    -t         - Write a TOC index, if the package file has room for "
+		"it\n"
+	"                 (i.e. it has been created with -t).\n"
 	"    -v         - Be verbose (show more info about created package).\n"
 	"\n"
 	"  create [ <options> ] <package>\n"
@@ -55,8 +58,17 @@ static const char* kUsage =
 		"useful\n"
 	"                 to redirect a \"make install\". Only allowed with -b.\n"
 	"    -q         - Be quiet (don't show any output except for errors).\n"
+	"    -t         - Write a TOC index, allowing readers to access single\n"
+	"                 directories without reading the complete TOC.\n"
 	"    -v         - Be verbose (show more info about created package).\n"
 	"\n"
+	"  delta [ <options> ] <old package> <new package> <delta>\n"
+	"    Creates the delta file <delta>, which allows recreating <new package>\n"
+	"    from <old package>. Data shared by both packages is referenced, only\n"
+	"    the changed heap chunks are stored in the delta.\n"
+	"\n"
+	"    -q         - Be quiet (don't show any output except for errors).\n"
+	"\n"
 	"  dump [ <options> ] <package>\n"
 	"    Dumps the TOC section of package file <package>. For debugging only.\n"
 	"\n"
@@ -70,11 +82,20 @@ static const char* kUsage =
 	"                  of the archive.\n"
 	"    -i <info>  - Extract the .PackageInfo file to <info> instead.\n"
 	"\n"
-	"  list [ <options> ] <package>\n"
-	"    Lists the contents of package file <package>.\n"
+	"  list [ <options> ] <package> [ <path> ]\n"
+	"    Lists the contents of package file <package>. If <path> is "
+		"specified,\n"
+	"    only the entries in (and leading to) <path> are listed.\n"
 	"\n"
 	"    -a         - Also list the file attributes.\n"
 	"\n"
+	"  patch [ <options> ] <old package> <delta> <new package>\n"
+	"    Creates package file <new package> by applying the delta file "
+		"<delta>\n"
+	"    to <old package>. The checksums of both packages are verified.\n"
+	"\n"
+	"    -q         - Be quiet (don't show any output except for errors).\n"
+	"\n"
 	"Common Options:\n"
 	"  -h, --help   - Print this usage info.\n"
 ;
@@ -101,6 +122,9 @@ main(int argc, const char* const* argv)
 	if (strcmp(command, "create") == 0)
 		return command_create(argc - 1, argv + 1);
 
+	if (strcmp(command, "delta") == 0)
+		return command_delta(argc - 1, argv + 1);
+
 	if (strcmp(command, "dump") == 0)
 		return command_dump(argc - 1, argv + 1);
 
@@ -110,6 +134,9 @@ main(int argc, const char* const* argv)
 	if (strcmp(command, "list") == 0)
 		return command_list(argc - 1, argv + 1);
 
+	if (strcmp(command, "patch") == 0)
+		return command_patch(argc - 1, argv + 1);
+
 	if (strcmp(command, "help") == 0)
 		print_usage_and_exit(false);
 	else
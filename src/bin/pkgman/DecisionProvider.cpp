@@ -7,14 +7,28 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <Autolock.h>
+
 #include "DecisionProvider.h"
 
 
+/*!	Jobs running concurrently may ask at the same time, so the questions are
+	serialized, to keep each prompt together with its answer.
+*/
+DecisionProvider::DecisionProvider()
+	:
+	fLock("decision provider")
+{
+}
+
+
 bool
 DecisionProvider::YesNoDecisionNeeded(const BString& description,
 	const BString& question, const BString& yes, const BString& no,
 	const BString& defaultChoice)
 {
+	BAutolock locker(fLock);
+
 	if (description.Length() > 0)
 		printf("%s\n", description.String());
 
@@ -6,13 +6,20 @@
 #define DECISION_PROVIDER_H
 
 
+#include <Locker.h>
+
 #include <package/Context.h>
 
 
 struct DecisionProvider : public BPackageKit::BDecisionProvider {
+	DecisionProvider();
+
 	virtual bool YesNoDecisionNeeded(const BString& description,
 		const BString& question, const BString& yes, const BString& no,
 		const BString& defaultChoice);
+
+private:
+	BLocker	fLock;
 };
 
 
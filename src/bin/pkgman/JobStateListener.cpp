@@ -6,6 +6,8 @@
 
 #include <stdio.h>
 
+#include <Autolock.h>
+
 #include "JobStateListener.h"
 #include "pkgman.h"
 
@@ -13,9 +15,22 @@
 using BPackageKit::BJob;
 
 
+/*!	The listener may be shared by requests that are processed concurrently,
+	so all notifications are serialized. Without \c EXIT_ON_ERROR, failures
+	are only reported, and the caller has to check the results of the jobs.
+*/
+JobStateListener::JobStateListener(uint32 flags)
+	:
+	fLock("job state listener"),
+	fFlags(flags)
+{
+}
+
+
 void
 JobStateListener::JobStarted(BJob* job)
 {
+	BAutolock locker(fLock);
 	printf("%s ...\n", job->Title().String());
 }
 
@@ -29,17 +44,26 @@ JobStateListener::JobSucceeded(BJob* job)
 void
 JobStateListener::JobFailed(BJob* job)
 {
+	BAutolock locker(fLock);
+
 	BString error = job->ErrorString();
 	if (error.Length() > 0) {
 		error.ReplaceAll("\n", "\n*** ");
 		fprintf(stderr, "%s", error.String());
 	}
-	DIE(job->Result(), "failed!");
+
+	if ((fFlags & EXIT_ON_ERROR) != 0)
+		DIE(job->Result(), "failed!");
+	ERROR(job->Result(), "failed!");
 }
 
 
 void
 JobStateListener::JobAborted(BJob* job)
 {
-	DIE(job->Result(), "aborted");
+	BAutolock locker(fLock);
+
+	if ((fFlags & EXIT_ON_ERROR) != 0)
+		DIE(job->Result(), "aborted");
+	ERROR(job->Result(), "aborted");
 }
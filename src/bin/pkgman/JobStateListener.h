@@ -6,14 +6,29 @@
 #define JOB_STATE_LISTENER_H
 
 
+#include <Locker.h>
+
 #include <package/Job.h>
 
 
-struct JobStateListener : public BPackageKit::BJobStateListener {
-	virtual	void JobStarted(BPackageKit::BJob* job);
-	virtual	void JobSucceeded(BPackageKit::BJob* job);
-	virtual	void JobFailed(BPackageKit::BJob* job);
-	virtual	void JobAborted(BPackageKit::BJob* job);
+class JobStateListener : public BPackageKit::BJobStateListener {
+public:
+			enum {
+				EXIT_ON_ERROR	= 0x01
+			};
+
+public:
+								JobStateListener(
+									uint32 flags = EXIT_ON_ERROR);
+
+	virtual	void				JobStarted(BPackageKit::BJob* job);
+	virtual	void				JobSucceeded(BPackageKit::BJob* job);
+	virtual	void				JobFailed(BPackageKit::BJob* job);
+	virtual	void				JobAborted(BPackageKit::BJob* job);
+
+private:
+			BLocker				fLock;
+			uint32				fFlags;
 };
 
 
@@ -95,12 +95,9 @@ command_add_repo(int argc, const char* const* argv)
 		if (result != B_OK)
 			DIE(result, "unable to create necessary jobs");
 
-		while (BJob* job = addRequest.PopRunnableJob()) {
-			result = job->Run();
-			delete job;
-			if (result == B_CANCELED)
-				return 1;
-		}
+		result = addRequest.Process();
+		if (result == B_CANCELED)
+			return 1;
 
 		// now refresh the repo-cache of the new repository
 		BString repoName = addRequest.RepositoryName();
@@ -115,12 +112,9 @@ command_add_repo(int argc, const char* const* argv)
 		if (result != B_OK)
 			DIE(result, "unable to create necessary jobs");
 
-		while (BJob* job = refreshRequest.PopRunnableJob()) {
-			result = job->Run();
-			delete job;
-			if (result == B_CANCELED)
-				return 1;
-		}
+		result = refreshRequest.Process();
+		if (result == B_CANCELED)
+			return 1;
 	}
 
 	return 0;
@@ -93,12 +93,9 @@ command_drop_repo(int argc, const char* const* argv)
 	if (result != B_OK)
 		DIE(result, "unable to create necessary jobs");
 
-	while (BJob* job = dropRequest.PopRunnableJob()) {
-		result = job->Run();
-		delete job;
-		if (result == B_CANCELED)
-			return 1;
-	}
+	result = dropRequest.Process();
+	if (result == B_CANCELED)
+		return 1;
 
 	return 0;
 }
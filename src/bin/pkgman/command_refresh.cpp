@@ -8,7 +8,11 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <new>
+
 #include <Errors.h>
+#include <ObjectList.h>
+#include <OS.h>
 #include <StringList.h>
 
 #include <package/Context.h>
@@ -41,6 +45,38 @@ print_command_usage_and_exit(bool error)
 }
 
 
+typedef BObjectList<BRefreshRepositoryRequest> RequestList;
+
+
+/*!	The requests are shared by a fixed number of threads, each processing
+	one request at a time, and the jobs of a request one after the other.
+	The results are left for the main thread to report.
+*/
+struct RefreshPool {
+	RequestList*	requests;
+	status_t*		results;
+	int32			nextRequest;
+};
+
+
+static status_t
+process_refresh_requests(void* data)
+{
+	RefreshPool* pool = (RefreshPool*)data;
+	int32 requestCount = pool->requests->CountItems();
+
+	while (true) {
+		int32 index = atomic_add(&pool->nextRequest, 1);
+		if (index >= requestCount)
+			break;
+
+		pool->results[index] = pool->requests->ItemAt(index)->Process(1);
+	}
+
+	return B_OK;
+}
+
+
 int
 command_refresh(int argc, const char* const* argv)
 {
@@ -70,8 +106,9 @@ command_refresh(int argc, const char* const* argv)
 	const char* const* repoArgs = argv + optind;
 	int nameCount = argc - optind;
 
+	// the requests are processed concurrently, so failures must not exit
 	DecisionProvider decisionProvider;
-	JobStateListener listener;
+	JobStateListener listener(0);
 	BContext context(decisionProvider, listener);
 
 	BStringList repositoryNames(20);
@@ -88,6 +125,10 @@ command_refresh(int argc, const char* const* argv)
 		}
 	}
 
+	// create the requests for all repositories first, so they can be
+	// processed concurrently
+	RequestList requests(20, true);
+	BStringList requestNames(20);
 	status_t result;
 	for (int i = 0; i < repositoryNames.CountStrings(); ++i) {
 		const BString& repoName = repositoryNames.StringAt(i);
@@ -99,21 +140,78 @@ command_refresh(int argc, const char* const* argv)
 			WARN(result, "skipping repository-config '%s'", path.Path());
 			continue;
 		}
-		BRefreshRepositoryRequest refreshRequest(context, repoConfig);
-		result = refreshRequest.InitCheck();
+		BRefreshRepositoryRequest* refreshRequest
+			= new(std::nothrow) BRefreshRepositoryRequest(context, repoConfig);
+		if (refreshRequest == NULL || !requests.AddItem(refreshRequest)) {
+			delete refreshRequest;
+			DIE(B_NO_MEMORY, "unable to create request for refreshing "
+				"repository");
+		}
+		if (!requestNames.Add(repoName)) {
+			DIE(B_NO_MEMORY, "unable to create request for refreshing "
+				"repository");
+		}
+		result = refreshRequest->InitCheck();
 		if (result != B_OK)
 			DIE(result, "unable to create request for refreshing repository");
-		result = refreshRequest.CreateInitialJobs();
+		result = refreshRequest->CreateInitialJobs();
 		if (result != B_OK)
 			DIE(result, "unable to create necessary jobs");
+	}
 
-		while (BJob* job = refreshRequest.PopRunnableJob()) {
-			result = job->Run();
-			delete job;
-			if (result != B_OK)
-				return 1;
+	int32 requestCount = requests.CountItems();
+	if (requestCount == 0)
+		return 0;
+
+	status_t* results = new(std::nothrow) status_t[requestCount];
+	if (results == NULL)
+		DIE(B_NO_MEMORY, "unable to allocate request results");
+
+	RefreshPool pool;
+	pool.requests = &requests;
+	pool.results = results;
+	pool.nextRequest = 0;
+
+	// use one thread per CPU, including this one
+	int32 threadCount = 1;
+	system_info info;
+	if (get_system_info(&info) == B_OK)
+		threadCount = min_c((int32)info.cpu_count, requestCount);
+
+	thread_id* threads = new(std::nothrow) thread_id[threadCount];
+	if (threads == NULL)
+		DIE(B_NO_MEMORY, "unable to allocate threads");
+
+	int32 spawnedCount = 0;
+	for (int32 i = 1; i < threadCount; i++) {
+		thread_id thread = spawn_thread(&process_refresh_requests,
+			"refresh repositories", B_NORMAL_PRIORITY, &pool);
+		if (thread < 0) {
+			// the others will do the work then
+			WARN(thread, "unable to spawn thread for refreshing repositories");
+			break;
+		}
+		threads[spawnedCount++] = thread;
+		resume_thread(thread);
+	}
+
+	process_refresh_requests(&pool);
+
+	for (int32 i = 0; i < spawnedCount; i++) {
+		status_t threadResult;
+		wait_for_thread(threads[i], &threadResult);
+	}
+	delete[] threads;
+
+	int exitCode = 0;
+	for (int32 i = 0; i < requestCount; i++) {
+		if (results[i] != B_OK) {
+			ERROR(results[i], "failed to refresh repository '%s'",
+				requestNames.StringAt(i).String());
+			exitCode = 5;
 		}
 	}
+	delete[] results;
 
-	return 0;
+	return exitCode;
 }
@@ -0,0 +1,117 @@
+/*
+ * Copyright 2011, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <Errors.h>
+#include <StringList.h>
+
+#include <package/PackageRoster.h>
+#include <package/RepositoryCache.h>
+
+#include "pkgman.h"
+
+
+// TODO: internationalization!
+
+
+using namespace BPackageKit;
+
+
+static const char* kCommandUsage =
+	"Usage: %s search [ <options> ] <resolvable-name>\n"
+	"Lists the packages of all repositories which provide the given\n"
+	"resolvable.\n"
+	"\n"
+	"Options:\n"
+	"  -r, --requires\n"
+	"    List the packages requiring the resolvable instead.\n"
+	"\n"
+;
+
+
+static void
+print_command_usage_and_exit(bool error)
+{
+    fprintf(error ? stderr : stdout, kCommandUsage, kProgramName);
+    exit(error ? 1 : 0);
+}
+
+
+int
+command_search(int argc, const char* const* argv)
+{
+	bool listRequiring = false;
+
+	while (true) {
+		static struct option sLongOptions[] = {
+			{ "help", no_argument, 0, 'h' },
+			{ "requires", no_argument, 0, 'r' },
+			{ 0, 0, 0, 0 }
+		};
+
+		opterr = 0; // don't print errors
+		int c = getopt_long(argc, (char**)argv, "hr", sLongOptions, NULL);
+		if (c == -1)
+			break;
+
+		switch (c) {
+			case 'h':
+				print_command_usage_and_exit(false);
+				break;
+
+			case 'r':
+				listRequiring = true;
+				break;
+
+			default:
+				print_command_usage_and_exit(true);
+				break;
+		}
+	}
+
+	// The remaining argument is the resolvable name.
+	if (argc != optind + 1)
+		print_command_usage_and_exit(true);
+
+	BString resolvableName = argv[optind];
+
+	BPackageRoster roster;
+	BStringList repositoryNames(20);
+	status_t result = roster.GetRepositoryNames(repositoryNames);
+	if (result != B_OK)
+		DIE(result, "can't collect repository names");
+
+	for (int i = 0; i < repositoryNames.CountStrings(); ++i) {
+		const BString& repoName = repositoryNames.StringAt(i);
+		BRepositoryCache repoCache;
+		result = roster.GetRepositoryCache(repoName, &repoCache);
+		if (result != B_OK) {
+			WARN(result, "skipping repository '%s'", repoName.String());
+			continue;
+		}
+
+		// looking up a resolvable doesn't need to read all packages, if the
+		// repository cache has an index
+		BStringList packageNames;
+		result = listRequiring
+			? repoCache.GetPackagesRequiring(resolvableName, packageNames)
+			: repoCache.GetPackagesProviding(resolvableName, packageNames);
+		if (result != B_OK) {
+			WARN(result, "failed to search repository '%s'", repoName.String());
+			continue;
+		}
+
+		for (int32 k = 0; k < packageNames.CountStrings(); k++) {
+			printf("%s: %s\n", repoName.String(),
+				packageNames.StringAt(k).String());
+		}
+	}
+
+	return 0;
+}
@@ -33,6 +33,10 @@ static const char* kUsage =
 	"  refresh [<repo-name> ...]\n"
 	"    Refreshes all or just the given repositories.\n"
 	"\n"
+	"  search [ -r ] <resolvable-name>\n"
+	"    Lists the packages providing (or with -r: requiring) the given\n"
+	"    resolvable.\n"
+	"\n"
 	"Common Options:\n"
 	"  -h, --help   - Print this usage info.\n"
 ;
@@ -65,8 +69,8 @@ main(int argc, const char* const* argv)
 	if (strncmp(command, "refr", 4) == 0)
 		return command_refresh(argc - 1, argv + 1);
 
-//	if (strcmp(command, "search") == 0)
-//		return command_search(argc - 1, argv + 1);
+	if (strcmp(command, "search") == 0)
+		return command_search(argc - 1, argv + 1);
 
 	if (strcmp(command, "help") == 0)
 		print_usage_and_exit(false);
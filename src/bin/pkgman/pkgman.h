@@ -39,6 +39,7 @@ int		command_add_repo(int argc, const char* const* argv);
 int		command_drop_repo(int argc, const char* const* argv);
 int		command_list_repos(int argc, const char* const* argv);
 int		command_refresh(int argc, const char* const* argv);
+int		command_search(int argc, const char* const* argv);
 
 
 #endif	// PKGMAN_H
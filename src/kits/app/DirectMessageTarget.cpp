@@ -26,6 +26,9 @@ BDirectMessageTarget::~BDirectMessageTarget()
 }
 
 
+/*!	Adds \a message to the queue, or deletes it if the target has been
+	closed already. Returns \c true if the looper has to be woken up.
+*/
 bool
 BDirectMessageTarget::AddMessage(BMessage* message)
 {
@@ -34,8 +37,7 @@ BDirectMessageTarget::AddMessage(BMessage* message)
 		return false;
 	}
 
-	fQueue.AddMessage(message);
-	return true;
+	return fQueue.AddMessage(message);
 }
 
 
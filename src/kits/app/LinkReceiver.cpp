@@ -29,6 +29,7 @@
 #include <GradientConic.h>
 
 #include "link_message.h"
+#include "LinkRing.h"
 
 //#define DEBUG_BPORTLINK
 #ifdef DEBUG_BPORTLINK
@@ -54,7 +55,7 @@ LinkReceiver::LinkReceiver(port_id port)
 	:
 	fReceivePort(port), fRecvBuffer(NULL), fRecvPosition(0), fRecvStart(0),
 	fRecvBufferSize(0), fDataSize(0),
-	fReplySize(0), fReadError(B_OK)
+	fReplySize(0), fReadError(B_OK), fRing(NULL), fPendingPortMessages(0)
 {
 }
 
@@ -62,6 +63,7 @@ LinkReceiver::LinkReceiver(port_id port)
 LinkReceiver::~LinkReceiver()
 {
 	free(fRecvBuffer);
+	delete fRing;
 }
 
 
@@ -72,6 +74,38 @@ LinkReceiver::SetPort(port_id port)
 }
 
 
+/*!	Creates a shared ring buffer through which a LinkSender can send its
+	messages instead of the port, see LinkSender::SetRing(). Messages sent
+	through the port are still accepted as well.
+	Returns the area of the ring that has to be passed to the sender.
+*/
+area_id
+LinkReceiver::CreateRing(const char* name)
+{
+	LinkRing* ring = new(std::nothrow) LinkRing;
+	if (ring == NULL)
+		return B_NO_MEMORY;
+
+	status_t status = ring->Create(name, kLinkRingSize);
+	if (status != B_OK) {
+		delete ring;
+		return status;
+	}
+
+	SetRing(ring);
+	return ring->Area();
+}
+
+
+void
+LinkReceiver::SetRing(LinkRing* ring)
+{
+	delete fRing;
+	fRing = ring;
+	fPendingPortMessages = 0;
+}
+
+
 status_t
 LinkReceiver::GetNextMessage(int32 &code, bigtime_t timeout)
 {
@@ -123,10 +157,21 @@ bool
 LinkReceiver::HasMessages() const
 {
 	return fDataSize - (fRecvStart + fReplySize) > 0
+		|| (fRing != NULL && !fRing->IsEmpty())
 		|| port_count(fReceivePort) > 0;
 }
 
 
+/*!	Returns whether there are messages left from the last port message read,
+	ie. that the sender has flushed together with the current one.
+*/
+bool
+LinkReceiver::HasBufferedMessages() const
+{
+	return fDataSize - (fRecvStart + fReplySize) > 0;
+}
+
+
 bool
 LinkReceiver::NeedsReply() const
 {
@@ -220,15 +265,27 @@ LinkReceiver::ReadFromPort(bigtime_t timeout)
 	// we are here so it means we finished reading the buffer contents
 	ResetBuffer();
 
-	status_t err = AdjustReplyBuffer(timeout);
-	if (err < B_OK)
-		return err;
+	while (true) {
+		if (fRing != NULL && fPendingPortMessages <= 0) {
+			status_t status = ReadFromRing();
+			if (status != B_WOULD_BLOCK)
+				return status;
+
+			if (fRing != NULL && fPendingPortMessages <= 0
+				&& !fRing->PrepareToWait()) {
+				// the sender was faster
+				continue;
+			}
+		}
 
-	int32 code;
-	ssize_t bytesRead;
+		status_t err = AdjustReplyBuffer(timeout);
+		if (err < B_OK)
+			return err;
 
-	STRACE(("info: LinkReceiver reading port %ld.\n", fReceivePort));
-	while (true) {
+		int32 code;
+		ssize_t bytesRead;
+
+		STRACE(("info: LinkReceiver reading port %ld.\n", fReceivePort));
 		if (timeout != B_INFINITE_TIMEOUT) {
 			do {
 				bytesRead = read_port_etc(fReceivePort, &code, fRecvBuffer,
@@ -245,18 +302,64 @@ LinkReceiver::ReadFromPort(bigtime_t timeout)
 		if (bytesRead < B_OK)
 			return bytesRead;
 
-		// we just ignore incorrect messages, and don't bother our caller
+		// we just ignore incorrect messages, and don't bother our caller;
+		// wake up messages only make us look at the ring again
 
-		if (code != kLinkCode) {
+		// The sender writes the marker for an overflow message only after
+		// it sent the message, so we may get the message first if we ran
+		// out of records; the count then goes below zero until we read the
+		// marker.
+		if (code == kLinkRingOverflowCode)
+			fPendingPortMessages--;
+		else if (code != kLinkCode) {
 			STRACE(("wrong port message %lx received.\n", code));
 			continue;
 		}
 
 		// port read seems to be valid
-		break;
+		fDataSize = bytesRead;
+		return B_OK;
+	}
+}
+
+
+/*!	Reads the next record from the ring into the receive buffer. Returns
+	\c B_WOULD_BLOCK if the next messages have to be read from the port
+	instead, ie. the ring is empty, or it contained an overflow marker.
+*/
+status_t
+LinkReceiver::ReadFromRing()
+{
+	size_t size;
+	status_t status = fRing->PeekRecord(size);
+	if (status == B_BAD_DATA) {
+		// we cannot trust the sender anymore, only use our port from now on
+		SetRing(NULL);
+		return B_WOULD_BLOCK;
+	}
+	if (status != B_OK)
+		return status;
+
+	if (size == 0) {
+		// the next messages have been sent through the port
+		fRing->ReadRecord(NULL, 0);
+		fPendingPortMessages++;
+		return B_WOULD_BLOCK;
+	}
+
+	if ((int32)size > fRecvBufferSize) {
+		int32 bufferSize = (size + B_PAGE_SIZE - 1) & ~(B_PAGE_SIZE - 1);
+		char *buffer = (char *)malloc(bufferSize);
+		if (buffer == NULL)
+			return B_NO_MEMORY;
+
+		free(fRecvBuffer);
+		fRecvBuffer = buffer;
+		fRecvBufferSize = bufferSize;
 	}
 
-	fDataSize = bytesRead;
+	fRing->ReadRecord(fRecvBuffer, size);
+	fDataSize = size;
 	return B_OK;
 }
 
@@ -0,0 +1,271 @@
+/*
+ * Copyright 2011, Haiku.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include "LinkRing.h"
+
+#include <string.h>
+
+
+namespace BPrivate {
+
+
+static inline uint32
+record_size(size_t size)
+{
+	return sizeof(int32) + ((size + 3) & ~3);
+}
+
+
+LinkRing::LinkRing()
+	:
+	fArea(-1),
+	fHeader(NULL),
+	fData(NULL),
+	fSize(0)
+{
+}
+
+
+LinkRing::~LinkRing()
+{
+	if (fArea >= B_OK)
+		delete_area(fArea);
+}
+
+
+/*!	Creates a new ring of \a size bytes, which must be a power of two.
+	This is done by the receiving side, the sender then clones the area.
+*/
+status_t
+LinkRing::Create(const char* name, size_t size)
+{
+	if (size < B_PAGE_SIZE || (size & (size - 1)) != 0)
+		return B_BAD_VALUE;
+
+	size_t areaSize = (sizeof(ring_header) + size + B_PAGE_SIZE - 1)
+		& ~(B_PAGE_SIZE - 1);
+
+	void* address;
+	area_id area = create_area(name, &address, B_ANY_ADDRESS, areaSize,
+		B_NO_LOCK, B_READ_AREA | B_WRITE_AREA);
+	if (area < B_OK)
+		return area;
+
+	ring_header* header = (ring_header*)address;
+	header->read = 0;
+	header->write = 0;
+	header->reader_waiting = 0;
+	header->size = size;
+
+	return _Init(area, address);
+}
+
+
+status_t
+LinkRing::Clone(area_id sourceArea)
+{
+	void* address;
+	area_id area = clone_area("link ring", &address, B_ANY_ADDRESS,
+		B_READ_AREA | B_WRITE_AREA, sourceArea);
+	if (area < B_OK)
+		return area;
+
+	return _Init(area, address);
+}
+
+
+/*!	Writes \a size bytes of \a data as a new record. Returns \c B_WOULD_BLOCK
+	if there is currently not enough space in the ring for it.
+	If the receiver is waiting for messages, \a _wakeUpReader is set to
+	\c true, and the caller needs to notify it via the port.
+*/
+status_t
+LinkRing::Write(const void* data, size_t size, bool& _wakeUpReader)
+{
+	if (data == NULL || size == 0)
+		return B_BAD_VALUE;
+
+	return _Write(data, size, _wakeUpReader);
+}
+
+
+/*!	Writes an empty record, telling the receiver that the next record has
+	been sent through the port instead.
+*/
+status_t
+LinkRing::WriteMarker(bool& _wakeUpReader)
+{
+	return _Write(NULL, 0, _wakeUpReader);
+}
+
+
+/*!	Returns whether a record of \a size bytes would currently fit into the
+	ring. Since there is only one writer, the space can only grow until the
+	writer uses it.
+*/
+bool
+LinkRing::HasSpaceFor(size_t size) const
+{
+	uint32 used = (uint32)atomic_get(&fHeader->write)
+		- (uint32)atomic_get(&fHeader->read);
+
+	// a corrupted ring is left for _Write() to report
+	return used > fSize || fSize - used >= record_size(size);
+}
+
+
+/*!	Asks for the receiver to be woken up again with the next write. The
+	writer must call this when it failed to send the wake up message it
+	has been asked for, or the receiver might wait forever.
+*/
+void
+LinkRing::SetReaderWaiting()
+{
+	atomic_or(&fHeader->reader_waiting, 1);
+}
+
+
+bool
+LinkRing::IsEmpty() const
+{
+	return atomic_get(&fHeader->write) == atomic_get(&fHeader->read);
+}
+
+
+/*!	Retrieves the size of the next record. Returns \c B_WOULD_BLOCK if the
+	ring is empty, and \c B_BAD_DATA if the ring has been corrupted - the
+	receiver must not trust the contents of the shared area.
+*/
+status_t
+LinkRing::PeekRecord(size_t& _size)
+{
+	uint32 read = (uint32)atomic_get(&fHeader->read);
+	uint32 used = (uint32)atomic_get(&fHeader->write) - read;
+	if (used == 0)
+		return B_WOULD_BLOCK;
+	if (used > fSize || used < sizeof(int32) || (used & 3) != 0)
+		return B_BAD_DATA;
+
+	int32 size;
+	_CopyOut(read, &size, sizeof(int32));
+	if (size < 0 || size > (int32)fSize || record_size(size) > used)
+		return B_BAD_DATA;
+
+	_size = size;
+	return B_OK;
+}
+
+
+/*!	Copies the next record that must have been checked with PeekRecord()
+	into \a buffer, and removes it from the ring.
+*/
+void
+LinkRing::ReadRecord(void* buffer, size_t size)
+{
+	uint32 read = (uint32)atomic_get(&fHeader->read);
+	if (size > 0)
+		_CopyOut(read + sizeof(int32), buffer, size);
+
+	atomic_add(&fHeader->read, record_size(size));
+}
+
+
+/*!	Announces that the receiver is going to wait on the port. Returns
+	\c false if the ring is not empty (anymore), in which case the receiver
+	must not wait.
+*/
+bool
+LinkRing::PrepareToWait()
+{
+	atomic_or(&fHeader->reader_waiting, 1);
+
+	if (!IsEmpty()) {
+		atomic_and(&fHeader->reader_waiting, 0);
+		return false;
+	}
+
+	return true;
+}
+
+
+status_t
+LinkRing::_Init(area_id area, void* address)
+{
+	area_info info;
+	status_t status = get_area_info(area, &info);
+	if (status != B_OK) {
+		delete_area(area);
+		return status;
+	}
+
+	ring_header* header = (ring_header*)address;
+	uint32 size = header->size;
+	if (size == 0 || (size & (size - 1)) != 0
+		|| sizeof(ring_header) + size > info.size) {
+		delete_area(area);
+		return B_BAD_DATA;
+	}
+
+	if (fArea >= B_OK)
+		delete_area(fArea);
+
+	fArea = area;
+	fHeader = header;
+	fData = (uint8*)address + sizeof(ring_header);
+	fSize = size;
+	return B_OK;
+}
+
+
+status_t
+LinkRing::_Write(const void* data, size_t size, bool& _wakeUpReader)
+{
+	uint32 recordSize = record_size(size);
+	uint32 write = (uint32)atomic_get(&fHeader->write);
+	uint32 used = write - (uint32)atomic_get(&fHeader->read);
+	if (used > fSize)
+		return B_BAD_DATA;
+	if (fSize - used < recordSize)
+		return B_WOULD_BLOCK;
+
+	int32 sizeField = size;
+	_Copy(write, &sizeField, sizeof(int32));
+	if (size > 0)
+		_Copy(write + sizeof(int32), data, size);
+
+	// publish the record, and only then check if the reader is waiting;
+	// see PrepareToWait()
+	atomic_add(&fHeader->write, recordSize);
+	_wakeUpReader = atomic_and(&fHeader->reader_waiting, 0) != 0;
+	return B_OK;
+}
+
+
+void
+LinkRing::_Copy(uint32 position, const void* data, size_t size)
+{
+	uint32 offset = position & (fSize - 1);
+	size_t first = min_c(size, fSize - offset);
+
+	memcpy(fData + offset, data, first);
+	if (first < size)
+		memcpy(fData, (const uint8*)data + first, size - first);
+}
+
+
+void
+LinkRing::_CopyOut(uint32 position, void* buffer, size_t size) const
+{
+	uint32 offset = position & (fSize - 1);
+	size_t first = min_c(size, fSize - offset);
+
+	memcpy(buffer, fData + offset, first);
+	if (first < size)
+		memcpy((uint8*)buffer + first, fData, size - first);
+}
+
+
+}	// namespace BPrivate
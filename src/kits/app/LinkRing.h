@@ -0,0 +1,70 @@
+/*
+ * Copyright 2011, Haiku.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _LINK_RING_H
+#define _LINK_RING_H
+
+
+#include <OS.h>
+
+
+namespace BPrivate {
+
+
+// A single producer, single consumer ring buffer in an area shared between
+// a LinkSender and a LinkReceiver. The link port is then only used to wake
+// up the receiver when it is waiting for messages.
+//
+// Every flush of the sender is stored as one record, an int32 size followed
+// by the data padded to a multiple of 4 bytes. A record of size 0 is a marker
+// telling the receiver that the next record has been sent through the port
+// as a kLinkRingOverflowCode message, because it didn't fit into the ring.
+class LinkRing {
+public:
+								LinkRing();
+								~LinkRing();
+
+			status_t			Create(const char* name, size_t size);
+			status_t			Clone(area_id area);
+
+			area_id				Area() const { return fArea; }
+
+			status_t			Write(const void* data, size_t size,
+									bool& _wakeUpReader);
+			status_t			WriteMarker(bool& _wakeUpReader);
+			bool				HasSpaceFor(size_t size) const;
+			void				SetReaderWaiting();
+
+			bool				IsEmpty() const;
+			status_t			PeekRecord(size_t& _size);
+			void				ReadRecord(void* buffer, size_t size);
+			bool				PrepareToWait();
+
+private:
+	struct ring_header {
+		vint32					read;
+		vint32					write;
+		vint32					reader_waiting;
+		uint32					size;
+	};
+
+			status_t			_Init(area_id area, void* address);
+			status_t			_Write(const void* data, size_t size,
+									bool& _wakeUpReader);
+			void				_Copy(uint32 position, const void* data,
+									size_t size);
+			void				_CopyOut(uint32 position, void* buffer,
+									size_t size) const;
+
+			area_id				fArea;
+			ring_header*		fHeader;
+			uint8*				fData;
+			uint32				fSize;
+};
+
+
+}	// namespace BPrivate
+
+
+#endif	// _LINK_RING_H
@@ -18,6 +18,7 @@
 #include <LinkSender.h>
 
 #include "link_message.h"
+#include "LinkRing.h"
 #include "syscalls.h"
 
 //#define DEBUG_BPORTLINK
@@ -32,6 +33,10 @@ static const size_t kMaxStringSize = 4096;
 static const size_t kWatermark = kInitialBufferSize - 24;
 	// if a message is started after this mark, the buffer is flushed automatically
 
+static int32 sFlushCount = 0;
+static int32 sReplyCount = 0;
+	// all port writes of this team, and those expecting a reply
+
 namespace BPrivate {
 
 LinkSender::LinkSender(port_id port)
@@ -43,7 +48,9 @@ LinkSender::LinkSender(port_id port)
 
 	fCurrentEnd(0),
 	fCurrentStart(0),
-	fCurrentStatus(B_OK)
+	fCurrentStatus(B_OK),
+	fBatching(false),
+	fRing(NULL)
 {
 }
 
@@ -51,6 +58,7 @@ LinkSender::LinkSender(port_id port)
 LinkSender::~LinkSender()
 {
 	free(fBuffer);
+	delete fRing;
 }
 
 
@@ -61,6 +69,35 @@ LinkSender::SetPort(port_id port)
 }
 
 
+/*!	Lets the sender write its messages into the ring buffer in \a area, as
+	created by LinkReceiver::CreateRing(), instead of into the port. The port
+	is then only used to wake up the receiver, and for messages that do not
+	fit into the ring. Passing an invalid area returns to using the port only.
+*/
+status_t
+LinkSender::SetRing(area_id area)
+{
+	delete fRing;
+	fRing = NULL;
+
+	if (area < B_OK)
+		return B_OK;
+
+	LinkRing* ring = new(std::nothrow) LinkRing;
+	if (ring == NULL)
+		return B_NO_MEMORY;
+
+	status_t status = ring->Clone(area);
+	if (status != B_OK) {
+		delete ring;
+		return status;
+	}
+
+	fRing = ring;
+	return B_OK;
+}
+
+
 status_t
 LinkSender::StartMessage(int32 code, size_t minSize)
 {
@@ -75,10 +112,15 @@ LinkSender::StartMessage(int32 code, size_t minSize)
 
 	minSize += sizeof(message_header);
 
+	// When batching, rather let the buffer grow than send the messages
+	if (fBatching && fBufferSize > 0 && minSize > SpaceLeft())
+		GrowBuffer(fCurrentEnd + minSize);
+
 	// Eventually flush buffer to make space for the new message.
 	// Note, we do not take the actual buffer size into account to not
 	// delay the time between buffer flushes too much.
-	if (fBufferSize > 0 && (minSize > SpaceLeft() || fCurrentStart >= kWatermark)) {
+	if (fBufferSize > 0 && (minSize > SpaceLeft()
+			|| (!fBatching && fCurrentStart >= kWatermark))) {
 		status_t status = Flush();
 		if (status < B_OK)
 			return status;
@@ -152,6 +194,9 @@ LinkSender::Attach(const void *passedData, size_t passedSize)
 		size = sizeof(area_id);
 	}
 
+	if (fBatching && SpaceLeft() < size)
+		GrowBuffer(fCurrentEnd + size);
+
 	if (SpaceLeft() < size) {
 		// we have to make space for the data
 
@@ -261,6 +306,31 @@ LinkSender::AdjustBuffer(size_t newSize, char **_oldBuffer)
 }
 
 
+/*!	Enlarges the buffer to at least \a minSize bytes, keeping its contents.
+*/
+status_t
+LinkSender::GrowBuffer(size_t minSize)
+{
+	if (minSize > kMaxBufferSize)
+		return B_BUFFER_OVERFLOW;
+
+	size_t newSize = fBufferSize * 2;
+	if (newSize < minSize)
+		newSize = minSize;
+	if (newSize > kMaxBufferSize)
+		newSize = kMaxBufferSize;
+	newSize = (newSize + B_PAGE_SIZE - 1) & ~(B_PAGE_SIZE - 1);
+
+	char *buffer = (char *)realloc(fBuffer, newSize);
+	if (buffer == NULL)
+		return B_NO_MEMORY;
+
+	fBuffer = buffer;
+	fBufferSize = newSize;
+	return B_OK;
+}
+
+
 status_t
 LinkSender::FlushCompleted(size_t newBufferSize)
 {
@@ -306,16 +376,10 @@ LinkSender::Flush(bigtime_t timeout, bool needsReply)
 		fCurrentEnd, fPort));
 
 	status_t err;
-	if (timeout != B_INFINITE_TIMEOUT) {
-		do {
-			err = write_port_etc(fPort, kLinkCode, fBuffer,
-				fCurrentEnd, B_RELATIVE_TIMEOUT, timeout);
-		} while (err == B_INTERRUPTED);
-	} else {
-		do {
-			err = write_port(fPort, kLinkCode, fBuffer, fCurrentEnd);
-		} while (err == B_INTERRUPTED);
-	}
+	if (fRing != NULL)
+		err = WriteToRing(timeout);
+	else
+		err = WriteToPort(kLinkCode, fBuffer, fCurrentEnd, timeout);
 
 	if (err < B_OK) {
 		STRACE(("error info: LinkSender Flush() failed for %ld bytes (%s) on port %ld.\n",
@@ -326,10 +390,96 @@ LinkSender::Flush(bigtime_t timeout, bool needsReply)
 	STRACE(("info: LinkSender Flush() messages total of %ld bytes on port %ld.\n",
 		fCurrentEnd, fPort));
 
+	atomic_add(&sFlushCount, 1);
+	if (needsReply)
+		atomic_add(&sReplyCount, 1);
+
 	fCurrentEnd = 0;
 	fCurrentStart = 0;
 
 	return B_OK;
 }
 
+
+status_t
+LinkSender::WriteToPort(int32 code, const void* buffer, size_t size,
+	bigtime_t timeout)
+{
+	status_t err;
+	if (timeout != B_INFINITE_TIMEOUT) {
+		do {
+			err = write_port_etc(fPort, code, buffer, size,
+				B_RELATIVE_TIMEOUT, timeout);
+		} while (err == B_INTERRUPTED);
+	} else {
+		do {
+			err = write_port(fPort, code, buffer, size);
+		} while (err == B_INTERRUPTED);
+	}
+
+	return err;
+}
+
+
+status_t
+LinkSender::WriteToRing(bigtime_t timeout)
+{
+	bool wakeUp = false;
+	status_t status = fRing->Write(fBuffer, fCurrentEnd, wakeUp);
+	if (status == B_WOULD_BLOCK) {
+		// The messages don't fit, so they are sent through the port, and a
+		// marker in the ring tells the receiver where they belong. The
+		// marker is only written after the messages have been sent, so that
+		// the receiver never waits for messages that didn't make it. That
+		// means we must not fail to write the marker then, so we wait for
+		// space for it first.
+		bigtime_t end = timeout != B_INFINITE_TIMEOUT
+			? system_time() + timeout : B_INFINITE_TIMEOUT;
+		while (!fRing->HasSpaceFor(0)) {
+			// the ring is completely full
+			if (system_time() >= end)
+				return B_TIMED_OUT;
+			snooze(1000);
+		}
+
+		status = WriteToPort(kLinkRingOverflowCode, fBuffer, fCurrentEnd,
+			timeout);
+		if (status != B_OK)
+			return status;
+
+		status = fRing->WriteMarker(wakeUp);
+	}
+	if (status != B_OK)
+		return status;
+
+	if (wakeUp) {
+		status = WriteToPort(kLinkRingWakeUpCode, NULL, 0, timeout);
+		if (status != B_OK) {
+			// Let the next flush try again. The messages are in the ring
+			// already, and must not be sent again, so this is not an error
+			// unless the receiver is gone: the wake up message can only
+			// time out if the port is full, and the receiver looks at the
+			// ring again after reading any of the messages in the port.
+			fRing->SetReaderWaiting();
+			if (status == B_BAD_PORT_ID)
+				return status;
+		}
+	}
+
+	return B_OK;
+}
+
+
+/*!	Returns how many times the links of this team have been flushed, and
+	how many of these flushes expected a reply, ie. were round-trips.
+*/
+/*static*/ void
+LinkSender::GetStatistics(int32* _flushCount, int32* _replyCount)
+{
+	if (_flushCount != NULL)
+		*_flushCount = atomic_get(&sFlushCount);
+	if (_replyCount != NULL)
+		*_replyCount = atomic_get(&sReplyCount);
+}
+
 }	// namespace BPrivate
@@ -818,6 +818,9 @@ BLooper::BLooper(int32 priority, port_id port, const char* name)
 status_t
 BLooper::_PostMessage(BMessage *msg, BHandler *handler, BHandler *replyTo)
 {
+	if (msg == NULL)
+		return B_BAD_VALUE;
+
 	AutoLocker<BLooperList> listLocker(gLooperList);
 	if (!listLocker.IsLocked())
 		return B_ERROR;
@@ -829,13 +832,17 @@ BLooper::_PostMessage(BMessage *msg, BHandler *handler, BHandler *replyTo)
 	if (handler && handler->Looper() != this)
 		return B_MISMATCHED_VALUES;
 
-	status_t status;
-	BMessenger messenger(handler, this, &status);
+	// Resolve the target while we have the looper list locked anyway; this
+	// is what a BMessenger would do, too. The message is then delivered
+	// directly into our message queue, as we always live in the sender's
+	// team.
+	int32 token = handler != NULL
+		? _get_object_token_(handler) : B_PREFERRED_TOKEN;
+	BMessenger replyMessenger(replyTo);
 	listLocker.Unlock();
-	if (status == B_OK)
-		status = messenger.SendMessage(msg, replyTo, 0);
 
-	return status;
+	return BMessage::Private(msg).SendMessage(fMsgPort, Team(), token, 0,
+		false, replyMessenger);
 }
 
 
@@ -969,11 +976,10 @@ BLooper::_InitData(const char *name, int32 priority, int32 portCapacity)
 void
 BLooper::AddMessage(BMessage* message)
 {
-	_AddMessagePriv(message);
+	bool wasEmpty = _AddMessagePriv(message);
 
 	// wakeup looper when being called from other threads if necessary
-	if (find_thread(NULL) != Thread()
-		&& fDirectTarget->Queue()->IsNextMessage(message)
+	if (wasEmpty && find_thread(NULL) != Thread()
 		&& port_count(fMsgPort) <= 0) {
 		// there is currently no message waiting, and we need to wakeup the
 		// looper
@@ -982,14 +988,14 @@ BLooper::AddMessage(BMessage* message)
 }
 
 
-void
+bool
 BLooper::_AddMessagePriv(BMessage* message)
 {
 	// ToDo: if no target token is specified, set to preferred handler
 	// Others may want to peek into our message queue, so the preferred
 	// handler must be set correctly already if no token was given
 
-	fDirectTarget->Queue()->AddMessage(message);
+	return fDirectTarget->Queue()->AddMessage(message);
 }
 
 
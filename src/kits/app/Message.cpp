@@ -12,8 +12,11 @@
 #include <MessagePrivate.h>
 #include <MessageUtils.h>
 
+#include <AutoLocker.h>
 #include <DirectMessageTarget.h>
+#include <LooperList.h>
 #include <MessengerPrivate.h>
+#include <ThreadSpareBuffers.h>
 #include <TokenSpace.h>
 #include <util/KMessage.h>
 
@@ -22,6 +25,7 @@
 #include <AppMisc.h>
 #include <BlockCache.h>
 #include <Entry.h>
+#include <Looper.h>
 #include <MessageQueue.h>
 #include <Messenger.h>
 #include <Path.h>
@@ -34,6 +38,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/uio.h>
 
 #include "tracing_config.h"
 	// kernel tracing configuration
@@ -73,6 +78,10 @@ extern "C" {
 	// private os function to set the owning team of an area
 	status_t _kern_transfer_area(area_id area, void **_address,
 		uint32 addressSpec, team_id target);
+	// private os function to write a port message from several buffers
+	status_t _kern_writev_port_etc(port_id id, int32 msgCode,
+		const struct iovec *msgVecs, size_t vecCount, size_t bufferSize,
+		uint32 flags, bigtime_t timeout);
 }
 
 
@@ -81,6 +90,96 @@ port_id BMessage::sReplyPorts[sNumReplyPorts];
 int32 BMessage::sReplyPortInUse[sNumReplyPorts];
 
 
+// Most messages are small and short-lived: they are built, sent, and deleted
+// right away, or read from a port and deleted once they have been handled.
+// Each thread keeps the header, and the field and data buffers of the last
+// such message it deleted around, so that the next message it creates can
+// use them instead of going through malloc() and realloc() again.
+
+enum {
+	SPARE_HEADER = 0,
+	SPARE_FIELDS,
+	SPARE_DATA,
+	SPARE_BUFFER_COUNT
+};
+
+static const size_t kMaxSpareBufferSize[SPARE_BUFFER_COUNT] = {
+	sizeof(BMessage::message_header),
+	32 * sizeof(BMessage::field_header),
+	4096
+};
+	// larger buffers are not kept for reuse
+
+typedef ThreadSpareBuffers<BMessage, SPARE_BUFFER_COUNT> SpareBuffers;
+
+
+static BMessage::message_header *
+allocate_header()
+{
+	size_t size = sizeof(BMessage::message_header);
+	return (BMessage::message_header *)SpareBuffers::Allocate(SPARE_HEADER,
+		size);
+}
+
+
+static void
+release_header(BMessage::message_header *header)
+{
+	SpareBuffers::Release(SPARE_HEADER, header,
+		sizeof(BMessage::message_header), kMaxSpareBufferSize[SPARE_HEADER]);
+}
+
+
+/*!	Returns a buffer of the given \a type for at least \a size bytes, and
+	sets \a size to its actual size. The buffer can be passed to realloc()
+	and free() as usual.
+*/
+static void *
+allocate_buffer(int32 type, size_t &size)
+{
+	return SpareBuffers::Allocate(type, size);
+}
+
+
+/*!	Frees the \a buffer, or keeps it for reuse. \a size may be less than the
+	actual size of the buffer, but must not be more.
+*/
+static void
+release_buffer(int32 type, void *buffer, size_t size)
+{
+	SpareBuffers::Release(type, buffer, size, kMaxSpareBufferSize[type]);
+}
+
+
+/*!	Returns the direct message target of the local handler with the given
+	\a token, with a reference acquired for the caller. Messages to the
+	preferred handler use the target of the looper listening to \a port.
+*/
+static BPrivate::BDirectMessageTarget *
+acquire_direct_target(port_id port, int32 token)
+{
+	BPrivate::BDirectMessageTarget *direct = NULL;
+
+	if (token == B_PREFERRED_TOKEN) {
+		// the looper is a handler, too, and shares its target
+		AutoLocker<BPrivate::BLooperList> listLocker(BPrivate::gLooperList);
+		if (!listLocker.IsLocked())
+			return NULL;
+
+		BLooper *looper = BPrivate::gLooperList.LooperForPort(port);
+		if (looper == NULL)
+			return NULL;
+
+		BPrivate::gDefaultTokens.AcquireHandlerTarget(
+			_get_object_token_(looper), &direct);
+		return direct;
+	}
+
+	BPrivate::gDefaultTokens.AcquireHandlerTarget(token, &direct);
+	return direct;
+}
+
+
 template<typename Type>
 static void
 print_to_stream_type(uint8 *pointer)
@@ -121,22 +220,29 @@ handle_reply(port_id replyPort, int32 *_code, bigtime_t timeout,
 	if (size < 0)
 		return size;
 
+	// small replies are read onto the stack, as they are copied by
+	// Unflatten() anyway
 	status_t result;
-	char *buffer = (char *)malloc(size);
-	if (buffer == NULL)
-		return B_NO_MEMORY;
+	char stackBuffer[1024];
+	char *buffer = stackBuffer;
+	if (size > (ssize_t)sizeof(stackBuffer)) {
+		buffer = (char *)malloc(size);
+		if (buffer == NULL)
+			return B_NO_MEMORY;
+	}
 
 	do {
 		result = read_port(replyPort, _code, buffer, size);
 	} while (result == B_INTERRUPTED);
 
-	if (result < 0 || *_code != kPortMessageCode) {
+	if (result >= 0 && *_code == kPortMessageCode)
+		result = reply->Unflatten(buffer);
+	else if (result >= 0)
+		result = B_ERROR;
+
+	if (buffer != stackBuffer)
 		free(buffer);
-		return result < 0 ? result : B_ERROR;
-	}
 
-	result = reply->Unflatten(buffer);
-	free(buffer);
 	return result;
 }
 
@@ -192,7 +298,7 @@ BMessage::operator=(const BMessage &other)
 
 	_Clear();
 
-	fHeader = (message_header *)malloc(sizeof(message_header));
+	fHeader = allocate_header();
 	if (fHeader == NULL)
 		return *this;
 
@@ -208,34 +314,46 @@ BMessage::operator=(const BMessage &other)
 		| MESSAGE_FLAG_PASS_BY_AREA);
 	// Note, that BeOS R5 seems to keep the reply info.
 
+	size_t fieldsSize = 0;
 	if (fHeader->field_count > 0) {
-		size_t fieldsSize = fHeader->field_count * sizeof(field_header);
-		if (other.fFields != NULL)
-			fFields = (field_header *)malloc(fieldsSize);
+		fieldsSize = fHeader->field_count * sizeof(field_header);
+		if (other.fFields != NULL) {
+			fFields = (field_header *)allocate_buffer(SPARE_FIELDS,
+				fieldsSize);
+		}
 
 		if (fFields == NULL) {
 			fHeader->field_count = 0;
 			fHeader->data_size = 0;
-		} else
-			memcpy(fFields, other.fFields, fieldsSize);
+			fieldsSize = 0;
+		} else {
+			memcpy(fFields, other.fFields,
+				fHeader->field_count * sizeof(field_header));
+		}
 	}
 
+	size_t dataSize = 0;
 	if (fHeader->data_size > 0) {
+		dataSize = fHeader->data_size;
 		if (other.fData != NULL)
-			fData = (uint8 *)malloc(fHeader->data_size);
+			fData = (uint8 *)allocate_buffer(SPARE_DATA, dataSize);
 
 		if (fData == NULL) {
 			fHeader->field_count = 0;
+			fHeader->data_size = 0;
 			free(fFields);
 			fFields = NULL;
+			fieldsSize = 0;
+			dataSize = 0;
 		} else
 			memcpy(fData, other.fData, fHeader->data_size);
 	}
 
 	fHeader->what = what = other.what;
 	fHeader->message_area = -1;
-	fFieldsAvailable = 0;
-	fDataAvailable = 0;
+	fFieldsAvailable = fieldsSize / sizeof(field_header)
+		- fHeader->field_count;
+	fDataAvailable = dataSize - fHeader->data_size;
 
 	return *this;
 }
@@ -362,7 +480,7 @@ BMessage::_InitHeader()
 {
 	DEBUG_FUNCTION_ENTER;
 	if (fHeader == NULL) {
-		fHeader = (message_header *)malloc(sizeof(message_header));
+		fHeader = allocate_header();
 		if (fHeader == NULL)
 			return B_NO_MEMORY;
 	}
@@ -401,13 +519,19 @@ BMessage::_Clear()
 		if (fHeader->message_area >= 0)
 			_Dereference();
 
-		free(fHeader);
+		release_buffer(SPARE_FIELDS, fFields,
+			(fHeader->field_count + fFieldsAvailable) * sizeof(field_header));
+		release_buffer(SPARE_DATA, fData,
+			fHeader->data_size + fDataAvailable);
+
+		release_header(fHeader);
 		fHeader = NULL;
+	} else {
+		free(fFields);
+		free(fData);
 	}
 
-	free(fFields);
 	fFields = NULL;
-	free(fData);
 	fData = NULL;
 
 	fArchivingPointer = NULL;
@@ -1264,7 +1388,7 @@ BMessage::Unflatten(const char *flatBuffer)
 
 	_Clear();
 
-	fHeader = (message_header *)malloc(sizeof(message_header));
+	fHeader = allocate_header();
 	if (fHeader == NULL)
 		return B_NO_MEMORY;
 
@@ -1289,7 +1413,9 @@ BMessage::Unflatten(const char *flatBuffer)
 
 		if (fHeader->field_count > 0) {
 			size_t fieldsSize = fHeader->field_count * sizeof(field_header);
-			fFields = (field_header *)malloc(fieldsSize);
+			size_t allocatedSize = fieldsSize;
+			fFields = (field_header *)allocate_buffer(SPARE_FIELDS,
+				allocatedSize);
 			if (fFields == NULL) {
 				_InitHeader();
 				return B_NO_MEMORY;
@@ -1297,18 +1423,23 @@ BMessage::Unflatten(const char *flatBuffer)
 
 			memcpy(fFields, flatBuffer, fieldsSize);
 			flatBuffer += fieldsSize;
+			fFieldsAvailable = allocatedSize / sizeof(field_header)
+				- fHeader->field_count;
 		}
 
 		if (fHeader->data_size > 0) {
-			fData = (uint8 *)malloc(fHeader->data_size);
+			size_t allocatedSize = fHeader->data_size;
+			fData = (uint8 *)allocate_buffer(SPARE_DATA, allocatedSize);
 			if (fData == NULL) {
 				free(fFields);
 				fFields = NULL;
+				fFieldsAvailable = 0;
 				_InitHeader();
 				return B_NO_MEMORY;
 			}
 
 			memcpy(fData, flatBuffer, fHeader->data_size);
+			fDataAvailable = allocatedSize - fHeader->data_size;
 		}
 	}
 
@@ -1332,7 +1463,7 @@ BMessage::Unflatten(BDataIO *stream)
 
 	_Clear();
 
-	fHeader = (message_header *)malloc(sizeof(message_header));
+	fHeader = allocate_header();
 	if (fHeader == NULL)
 		return B_NO_MEMORY;
 
@@ -1578,7 +1709,13 @@ BMessage::_ResizeData(uint32 offset, int32 change)
 		size = min_c(size, fHeader->data_size + MAX_DATA_PREALLOCATION);
 		size = max_c(size, fHeader->data_size + change);
 
-		uint8 *newData = (uint8 *)realloc(fData, size);
+		uint8 *newData;
+		if (fData == NULL) {
+			// start out with some room to spare
+			size = max_c(size, MIN_DATA_PREALLOCATION);
+			newData = (uint8 *)allocate_buffer(SPARE_DATA, size);
+		} else
+			newData = (uint8 *)realloc(fData, size);
 		if (size > 0 && newData == NULL)
 			return B_NO_MEMORY;
 
@@ -1681,8 +1818,17 @@ BMessage::_AddField(const char *name, type_code type, bool isFixedSize,
 		uint32 count = fHeader->field_count * 2 + 1;
 		count = min_c(count, fHeader->field_count + MAX_FIELD_PREALLOCATION);
 
-		field_header *newFields = (field_header *)realloc(fFields,
-			count * sizeof(field_header));
+		field_header *newFields;
+		if (fFields == NULL) {
+			// start out with room for a few fields
+			size_t size = max_c(count, MIN_FIELD_PREALLOCATION)
+				* sizeof(field_header);
+			newFields = (field_header *)allocate_buffer(SPARE_FIELDS, size);
+			count = size / sizeof(field_header);
+		} else {
+			newFields = (field_header *)realloc(fFields,
+				count * sizeof(field_header));
+		}
 		if (count > 0 && newFields == NULL)
 			return B_NO_MEMORY;
 
@@ -2103,11 +2249,14 @@ BMessage::_SendMessage(port_id port, team_id portOwner, int32 token,
 	char *buffer = NULL;
 	message_header *header = NULL;
 	status_t result = B_OK;
+#ifndef HAIKU_TARGET_PLATFORM_LIBBE_TEST
+	message_header headerCopy;
+#endif
 
 	BPrivate::BDirectMessageTarget* direct = NULL;
 	BMessage *copy = NULL;
 	if (portOwner == BPrivate::current_team())
-		BPrivate::gDefaultTokens.AcquireHandlerTarget(token, &direct);
+		direct = acquire_direct_target(port, token);
 
 	if (direct != NULL) {
 		// We have a direct local message target - we can just enqueue the
@@ -2155,7 +2304,15 @@ BMessage::_SendMessage(port_id port, team_id portOwner, int32 token,
 
 			header->message_area = transfered;
 		}
-#endif
+	} else {
+		// the message is written to the port directly from its buffers,
+		// only the header needs to be adjusted for the target
+		fHeader->what = what;
+		headerCopy = *fHeader;
+		header = &headerCopy;
+		size = FlattenedSize();
+	}
+#else
 	} else {
 		size = FlattenedSize();
 		buffer = (char *)malloc(size);
@@ -2170,6 +2327,7 @@ BMessage::_SendMessage(port_id port, team_id portOwner, int32 token,
 
 		header = (message_header *)buffer;
 	}
+#endif
 
 	if (!replyTo.IsValid()) {
 		BMessenger::Private(replyTo).SetTo(fHeader->reply_team,
@@ -2197,10 +2355,34 @@ BMessage::_SendMessage(port_id port, team_id portOwner, int32 token,
 			"message: '%c%c%c%c'", portOwner, port, token,
 			char(what >> 24), char(what >> 16), char(what >> 8), (char)what);
 
-		do {
-			result = write_port_etc(port, kPortMessageCode, (void *)buffer,
-				size, B_RELATIVE_TIMEOUT, timeout);
-		} while (result == B_INTERRUPTED);
+#ifndef HAIKU_TARGET_PLATFORM_LIBBE_TEST
+		if (header == &headerCopy) {
+			iovec vecs[3];
+			size_t vecCount = 0;
+			vecs[vecCount].iov_base = header;
+			vecs[vecCount++].iov_len = sizeof(message_header);
+			if (header->field_count > 0) {
+				vecs[vecCount].iov_base = fFields;
+				vecs[vecCount++].iov_len
+					= header->field_count * sizeof(field_header);
+			}
+			if (header->data_size > 0) {
+				vecs[vecCount].iov_base = fData;
+				vecs[vecCount++].iov_len = header->data_size;
+			}
+
+			do {
+				result = _kern_writev_port_etc(port, kPortMessageCode, vecs,
+					vecCount, size, B_RELATIVE_TIMEOUT, timeout);
+			} while (result == B_INTERRUPTED);
+		} else
+#endif
+		{
+			do {
+				result = write_port_etc(port, kPortMessageCode,
+					(void *)buffer, size, B_RELATIVE_TIMEOUT, timeout);
+			} while (result == B_INTERRUPTED);
+		}
 	}
 
 	if (result == B_OK && IsSourceWaiting()) {
@@ -2219,8 +2401,7 @@ BMessage::_SendMessage(port_id port, team_id portOwner, int32 token,
 			char(what >> 24), char(what >> 16), char(what >> 8), (char)what);
 
 		// this is a local message transmission
-		direct->AddMessage(copy);
-		if (direct->Queue()->IsNextMessage(copy) && port_count(port) <= 0) {
+		if (direct->AddMessage(copy) && port_count(port) <= 0) {
 			// there is currently no message waiting, and we need to wakeup the
 			// looper
 			write_port_etc(port, 0, NULL, 0, B_RELATIVE_TIMEOUT, 0);
@@ -2317,9 +2498,9 @@ BMessage::_SendMessage(port_id port, team_id portOwner, int32 token,
 		BMessenger replyTarget;
 		BMessenger::Private(replyTarget).SetTo(team, replyPort,
 			B_PREFERRED_TOKEN);
-		// TODO: replying could also use a BDirectMessageTarget like mechanism
-		// for local targets
-		result = _SendMessage(port, -1, token, sendTimeout, true,
+		// local targets get the message directly, like with asynchronous
+		// messages; only the reply goes through the reply port
+		result = _SendMessage(port, portOwner, token, sendTimeout, true,
 			replyTarget);
 	}
 
@@ -9,18 +9,33 @@
 
 /**	Queue for holding BMessages */
 
+/*	AddMessage() does not need the queue lock: new messages are pushed onto
+	the fIncoming list with an atomic operation, so that any number of
+	threads can post messages without ever blocking each other, or the
+	looper. Everything that looks at the messages locks the queue, and first
+	moves the incoming messages over to the ordered list at fHead. Since the
+	looper is usually the only one to do that, the lock is rarely contended.
+
+	The message count is only increased after a message has been pushed, so
+	that it never counts a message that cannot be found yet. The poster that
+	increases it from zero is the one that has to wake up the looper.
+*/
+
 
 #include <MessageQueue.h>
 #include <Autolock.h>
 #include <Message.h>
 
+#include <util/atomic.h>
+
 
 BMessageQueue::BMessageQueue()
 	:
 	fHead(NULL),
  	fTail(NULL),
  	fMessageCount(0),
- 	fLock("BMessageQueue Lock")
+ 	fLock("BMessageQueue Lock"),
+	fIncoming(NULL)
 {
 }
 
@@ -30,6 +45,8 @@ BMessageQueue::~BMessageQueue()
 	if (!Lock())
 		return;
 
+	_CollectIncoming();
+
 	BMessage* message = fHead;
 	while (message != NULL) {
 		BMessage *next = message->fQueueLink;
@@ -40,30 +57,27 @@ BMessageQueue::~BMessageQueue()
 }
 
 
-void
+/*!	Adds \a message to the end of the queue.
+
+	Returns \c true if the queue was empty before, ie. if whoever is waiting
+	for messages on this queue needs to be woken up.
+*/
+bool
 BMessageQueue::AddMessage(BMessage* message)
 {
 	if (message == NULL)
-		return;
-
-	BAutolock _(fLock);
-	if (!IsLocked())
-		return;
-
-	// The message passed in will be the last message on the queue so its
-	// link member should be set to null.
-	message->fQueueLink = NULL;
-
-	fMessageCount++;
-
-	if (fTail == NULL) {
-		// there are no messages in the queue yet
-		fHead = fTail = message;
-	} else {
-		// just add it after the tail
-		fTail->fQueueLink = message;
-		fTail = message;
-	}
+		return false;
+
+	BMessage* incoming;
+	do {
+		incoming = atomic_pointer_get(&fIncoming);
+		message->fQueueLink = incoming;
+	} while (atomic_pointer_test_and_set(&fIncoming, message, incoming)
+		!= incoming);
+
+	// NextMessage() might already have taken out the message, and decreased
+	// the count below zero in the meantime
+	return atomic_add(&fMessageCount, 1) <= 0;
 }
 
 
@@ -77,6 +91,8 @@ BMessageQueue::RemoveMessage(BMessage* message)
 	if (!IsLocked())
 		return;
 
+	_CollectIncoming();
+
 	BMessage* last = NULL;
 	for (BMessage* entry = fHead; entry != NULL; entry = entry->fQueueLink) {
 		if (entry == message) {
@@ -89,7 +105,7 @@ BMessageQueue::RemoveMessage(BMessage* message)
 			if (entry == fTail)
 				fTail = last;
 
-			fMessageCount--;
+			atomic_add(&fMessageCount, -1);
 			return;
 		}
 		last = entry;
@@ -100,14 +116,15 @@ BMessageQueue::RemoveMessage(BMessage* message)
 int32
 BMessageQueue::CountMessages() const
 {
-    return fMessageCount;
+	int32 count = fMessageCount;
+	return count > 0 ? count : 0;
 }
 
 
 bool
 BMessageQueue::IsEmpty() const
 {
-    return fMessageCount == 0;
+    return fMessageCount <= 0;
 }
 
 
@@ -120,7 +137,9 @@ BMessageQueue::FindMessage(int32 index) const
 
 	if (index < 0 || index >= fMessageCount)
 		return NULL;
-	
+
+	const_cast<BMessageQueue*>(this)->_CollectIncoming();
+
 	for (BMessage* message = fHead; message != NULL; message = message->fQueueLink) {
 		// If the index reaches zero, then we have found a match.
 		if (index == 0)
@@ -143,6 +162,8 @@ BMessageQueue::FindMessage(uint32 what, int32 index) const
 	if (index < 0 || index >= fMessageCount)
 		return NULL;
 
+	const_cast<BMessageQueue*>(this)->_CollectIncoming();
+
 	for (BMessage* message = fHead; message != NULL; message = message->fQueueLink) {
 		if (message->what == what) {
 			// If the index reaches zero, then we have found a match.
@@ -181,17 +202,22 @@ BMessageQueue::IsLocked() const
 BMessage *
 BMessageQueue::NextMessage()
 {
+	if (atomic_get(&fMessageCount) <= 0)
+		return NULL;
+
 	BAutolock _(fLock);
 	if (!IsLocked())
 		return NULL;
 
 	// remove the head of the queue, if any, and return it
 
+	if (fHead == NULL)
+		_CollectIncoming();
+
 	BMessage* head = fHead;
 	if (head == NULL)
 		return NULL;
 
-	fMessageCount--;
 	fHead = head->fQueueLink;
 
 	if (fHead == NULL) {
@@ -201,6 +227,7 @@ BMessageQueue::NextMessage()
 		fTail = NULL;
 	}
 
+	atomic_add(&fMessageCount, -1);
     return head;
 }
 
@@ -209,6 +236,10 @@ bool
 BMessageQueue::IsNextMessage(const BMessage* message) const
 {
 	BAutolock _(fLock);
+	if (!IsLocked())
+		return false;
+
+	const_cast<BMessageQueue*>(this)->_CollectIncoming();
 	return fHead == message;
 }
 
@@ -224,6 +255,35 @@ BMessageQueue::IsLocked()
 }
 
 
+/*!	Appends the messages added since the last call to the list at fHead,
+	in the order they were added. The queue must be locked.
+*/
+void
+BMessageQueue::_CollectIncoming()
+{
+	BMessage* incoming = atomic_pointer_set(&fIncoming, (BMessage*)NULL);
+	if (incoming == NULL)
+		return;
+
+	// the incoming list is in reverse order
+	BMessage* last = incoming;
+	BMessage* first = NULL;
+	while (incoming != NULL) {
+		BMessage* next = incoming->fQueueLink;
+		incoming->fQueueLink = first;
+		first = incoming;
+		incoming = next;
+	}
+
+	if (fTail == NULL)
+		fHead = first;
+	else
+		fTail->fQueueLink = first;
+
+	fTail = last;
+}
+
+
 void BMessageQueue::_ReservedMessageQueue1() {}
 void BMessageQueue::_ReservedMessageQueue2() {}
 void BMessageQueue::_ReservedMessageQueue3() {}
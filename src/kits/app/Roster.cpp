@@ -42,6 +42,7 @@
 #include <Query.h>
 #include <RegistrarDefs.h>
 #include <String.h>
+#include <TLS.h>
 #include <Volume.h>
 #include <VolumeRoster.h>
 
@@ -388,6 +389,198 @@ query_for_app(const char* signature, entry_ref* appRef)
 }
 
 
+/*!	\brief Asks the registrar for the executable of an application.
+
+	The registrar remembers the executables of the applications that
+	registered with it, which saves us from querying for them.
+
+	\param roster The messenger of the registrar.
+	\param signature The application signature.
+	\param appRef A pointer to a pre-allocated entry_ref to be filled with
+		   a reference to the found application's executable.
+	\return
+	- \c B_OK: Everything went fine.
+	- \c B_ENTRY_NOT_FOUND: The registrar doesn't know the application, or
+	  the executable doesn't exist anymore.
+	- other error codes
+*/
+static status_t
+find_app_in_roster_index(const BMessenger& roster, const char* signature,
+	entry_ref* appRef)
+{
+	// compose the request message
+	BMessage request(B_REG_FIND_APP);
+	status_t error = request.AddString("signature", signature);
+
+	// send the request
+	BMessage reply;
+	if (error == B_OK)
+		error = roster.SendMessage(&request, &reply);
+
+	// evaluate the reply
+	if (error == B_OK) {
+		if (reply.what == B_REG_SUCCESS)
+			error = reply.FindRef("ref", appRef);
+		else if (reply.FindInt32("error", &error) != B_OK)
+			error = B_ERROR;
+	}
+
+	// resolve symbolic links, if necessary
+	if (error == B_OK) {
+		BEntry entry;
+		if (entry.SetTo(appRef, true) != B_OK || !entry.IsFile()
+			|| entry.GetRef(appRef) != B_OK) {
+			error = B_ENTRY_NOT_FOUND;
+		}
+	}
+
+	return error;
+}
+
+
+//	#pragma mark - launch timing
+
+
+/*!	\brief Measures how long the steps of a launch take.
+
+	This is only enabled if the ROSTER_LAUNCH_TIMING environment variable is
+	set. The steps and their durations are printed to stderr once the launch
+	is done. Methods called during the launch can add steps via
+	CurrentStep().
+
+	Each step is measured from the end of the previous one; steps with the
+	same name are added up.
+*/
+class LaunchTiming {
+public:
+								LaunchTiming(const char* mimeType,
+									const entry_ref* ref);
+								~LaunchTiming();
+
+			void				Step(const char* name);
+			void				SetResult(status_t result)
+									{ fResult = result; }
+
+	static	void				CurrentStep(const char* name);
+
+private:
+	static	status_t			_Init(void*);
+
+private:
+	enum {
+		kMaxSteps = 16
+	};
+
+	struct step {
+		const char*				name;
+		bigtime_t				duration;
+	};
+
+			bool				fEnabled;
+			LaunchTiming*		fPrevious;
+			const char*			fMimeType;
+			const entry_ref*	fRef;
+			status_t			fResult;
+			bigtime_t			fStartTime;
+			bigtime_t			fLastTime;
+			step				fSteps[kMaxSteps];
+			int32				fStepCount;
+
+	static	vint32				sInitOnce;
+	static	int32				sTLSIndex;
+};
+
+
+vint32 LaunchTiming::sInitOnce = INIT_ONCE_UNINITIALIZED;
+int32 LaunchTiming::sTLSIndex = -1;
+
+
+LaunchTiming::LaunchTiming(const char* mimeType, const entry_ref* ref)
+	:
+	fEnabled(false),
+	fPrevious(NULL),
+	fMimeType(mimeType),
+	fRef(ref),
+	fResult(B_OK),
+	fStepCount(0)
+{
+	__init_once(&sInitOnce, &_Init, NULL);
+	if (sTLSIndex < 0)
+		return;
+
+	fEnabled = true;
+	fPrevious = (LaunchTiming*)tls_get(sTLSIndex);
+	tls_set(sTLSIndex, this);
+
+	fStartTime = fLastTime = system_time();
+}
+
+
+LaunchTiming::~LaunchTiming()
+{
+	if (!fEnabled)
+		return;
+
+	tls_set(sTLSIndex, fPrevious);
+
+	fprintf(stderr, "launch %s: %s, %lld us\n",
+		fMimeType != NULL ? fMimeType
+			: fRef != NULL && fRef->name != NULL ? fRef->name : "(unknown)",
+		strerror(fResult), system_time() - fStartTime);
+	for (int32 i = 0; i < fStepCount; i++) {
+		fprintf(stderr, "  %-16s %10lld us\n", fSteps[i].name,
+			fSteps[i].duration);
+	}
+}
+
+
+void
+LaunchTiming::Step(const char* name)
+{
+	if (!fEnabled)
+		return;
+
+	bigtime_t now = system_time();
+	bigtime_t duration = now - fLastTime;
+	fLastTime = now;
+
+	for (int32 i = 0; i < fStepCount; i++) {
+		if (!strcmp(fSteps[i].name, name)) {
+			fSteps[i].duration += duration;
+			return;
+		}
+	}
+
+	if (fStepCount < kMaxSteps) {
+		fSteps[fStepCount].name = name;
+		fSteps[fStepCount].duration = duration;
+		fStepCount++;
+	}
+}
+
+
+/*static*/ void
+LaunchTiming::CurrentStep(const char* name)
+{
+	if (sTLSIndex < 0)
+		return;
+
+	LaunchTiming* timing = (LaunchTiming*)tls_get(sTLSIndex);
+	if (timing != NULL)
+		timing->Step(name);
+}
+
+
+/*static*/ status_t
+LaunchTiming::_Init(void*)
+{
+	if (getenv("ROSTER_LAUNCH_TIMING") != NULL)
+		sTLSIndex = tls_allocate();
+
+	return B_OK;
+}
+
+
 //	#pragma mark - app_info
 
 
@@ -2180,6 +2373,7 @@ BRoster::_LaunchApp(const char* mimeType, const entry_ref* ref,
 	status_t error = B_OK;
 	ArgVector argVector;
 	team_id team = -1;
+	LaunchTiming timing(mimeType, ref);
 
 	do {
 		// find the app
@@ -2187,16 +2381,22 @@ BRoster::_LaunchApp(const char* mimeType, const entry_ref* ref,
 		char signature[B_MIME_TYPE_LENGTH];
 		error = _ResolveApp(mimeType, docRef, &appRef, signature,
 			&appFlags, &wasDocument);
+		timing.Step("resolve app");
 		DBG(OUT("  find app: %s (%lx)\n", strerror(error), error));
-		if (error != B_OK)
+		if (error != B_OK) {
+			timing.SetResult(error);
 			return error;
+		}
 
 		// build an argument vector
 		error = argVector.Init(argc, args, &appRef,
 			wasDocument ? docRef : NULL);
+		timing.Step("build argv");
 		DBG(OUT("  build argv: %s (%lx)\n", strerror(error), error));
-		if (error != B_OK)
+		if (error != B_OK) {
+			timing.SetResult(error);
 			return error;
+		}
 
 		// pre-register the app (but ignore scipts)
 		uint32 appToken = 0;
@@ -2216,6 +2416,7 @@ BRoster::_LaunchApp(const char* mimeType, const entry_ref* ref,
 					team = appInfo.team;
 				}
 			}
+			timing.Step("pre-register");
 			DBG(OUT("  pre-register: %s (%lx)\n", strerror(error), error));
 		}
 
@@ -2226,6 +2427,7 @@ BRoster::_LaunchApp(const char* mimeType, const entry_ref* ref,
 			thread_id appThread = load_image(argVector.Count(),
 				const_cast<const char**>(argVector.Args()),
 				const_cast<const char**>(environ));
+			timing.Step("load image");
 
 			// get the app team
 			if (appThread >= 0) {
@@ -2242,11 +2444,13 @@ BRoster::_LaunchApp(const char* mimeType, const entry_ref* ref,
 			// finish the registration
 			if (error == B_OK && !isScript)
 				error = _SetThreadAndTeam(appToken, appThread, team);
+			timing.Step("register team");
 
 			DBG(OUT("  set thread and team: %s (%lx)\n", strerror(error), error));
 			// resume the launched team
 			if (error == B_OK)
 				error = resume_thread(appThread);
+			timing.Step("resume");
 
 			DBG(OUT("  resume thread: %s (%lx)\n", strerror(error), error));
 			// on error: kill the launched team and unregister the app
@@ -2295,6 +2499,7 @@ BRoster::_LaunchApp(const char* mimeType, const entry_ref* ref,
 		if (!(argvOnly && alreadyRunning)) {
 			_SendToRunning(team, argVector.Count(), argVector.Args(),
 				_messageList, _ref, alreadyRunning);
+			timing.Step("send messages");
 		}
 	}
 
@@ -2306,6 +2511,7 @@ BRoster::_LaunchApp(const char* mimeType, const entry_ref* ref,
 			*_appTeam = team;
 	}
 
+	timing.SetResult(error);
 	DBG(OUT("BRoster::_LaunchApp() done: %s (%lx)\n",
 		strerror(error), error));
 	return error;
@@ -2568,6 +2774,7 @@ BRoster::_TranslateRef(entry_ref* ref, BMimeType* appMeta,
 	// get the type from the file
 	char fileType[B_MIME_TYPE_LENGTH];
 	error = _GetFileType(ref, &nodeInfo, fileType);
+	LaunchTiming::CurrentStep("file type");
 	if (error != B_OK)
 		return error;
 
@@ -2719,6 +2926,8 @@ BRoster::_TranslateType(const char* mimeType, BMimeType* appMeta,
 	if (error != B_OK)
 		return error;
 
+	LaunchTiming::CurrentStep("supporting apps");
+
 	// Set an error in case we can't resolve a single supporting app.
 	error = B_LAUNCH_FAILED_NO_PREFERRED_APP;
 
@@ -2745,15 +2954,27 @@ BRoster::_TranslateType(const char* mimeType, BMimeType* appMeta,
 			}
 		}
 
-		// In case there is no app hint or it is invalid, we need to query for
-		// the app.
-		if (error == B_OK && !appFound)
+		LaunchTiming::CurrentStep("app hint");
+
+		// In case there is no app hint or it is invalid, ask the registrar,
+		// and only if it doesn't know the app either, or knows one that can't
+		// be used (like one in the Trash), we need to query for it.
+		if (error == B_OK && !appFound) {
+			appFound = find_app_in_roster_index(fMessenger, appMeta->Type(),
+					appRef) == B_OK
+				&& can_app_be_used(appRef) == B_OK;
+			LaunchTiming::CurrentStep("roster index");
+		}
+		if (error == B_OK && !appFound) {
 			error = query_for_app(appMeta->Type(), appRef);
+			LaunchTiming::CurrentStep("query");
+		}
 		if (error == B_OK)
 			error = appFile->SetTo(appRef, B_READ_ONLY);
 		// check, whether the app can be used
 		if (error == B_OK)
 			error = can_app_be_used(appRef);
+		LaunchTiming::CurrentStep("check app");
 
 		if (error == B_OK)
 			break;
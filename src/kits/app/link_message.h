@@ -13,10 +13,15 @@
 
 
 static const int32 kLinkCode = '_PTL';
+static const int32 kLinkRingWakeUpCode = '_PTW';
+	// sent to a receiver waiting for messages in its LinkRing
+static const int32 kLinkRingOverflowCode = '_PTO';
+	// messages that did not fit into the LinkRing
 
 static const size_t kInitialBufferSize = 2048;
 static const size_t kMaxBufferSize = 65536;
 	// anything beyond that should be sent with a different mechanism
+static const size_t kLinkRingSize = 65536;
 
 struct message_header {
 	int32	size;
@@ -12,9 +12,11 @@
 
 
 #include <AppServerLink.h>
+#include <ApplicationPrivate.h>
 #include <FontPrivate.h>
 #include <ObjectList.h>
 #include <ServerProtocol.h>
+#include <ServerReadOnlyMemory.h>
 #include <truncate_string.h>
 #include <utf8_functions.h>
 
@@ -30,6 +32,7 @@
 #include <new>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 using namespace std;
 
@@ -95,6 +98,70 @@ class FontList : public BLocker {
 pthread_once_t FontList::sDefaultInitOnce = PTHREAD_ONCE_INIT;
 FontList* FontList::sDefaultInstance = NULL;
 
+
+// Remembers the string widths and font heights the app_server reported, so
+// that measuring the same string over and over again, like most views do in
+// their Draw() method, doesn't need a round-trip to the server each time.
+class FontMetricsCache : public BLocker {
+	public:
+		FontMetricsCache();
+
+		static FontMetricsCache* Default();
+
+		bool LookupWidth(uint16 familyID, uint16 styleID, float size,
+					uint8 spacing, const char* string, int32 length,
+					float& width);
+		void InsertWidth(uint16 familyID, uint16 styleID, float size,
+					uint8 spacing, const char* string, int32 length,
+					float width);
+
+		bool LookupHeight(uint16 familyID, uint16 styleID, float size,
+					font_height& height);
+		void InsertHeight(uint16 familyID, uint16 styleID, float size,
+					const font_height& height);
+
+	private:
+		enum {
+			kWidthEntryCount	= 512,
+			kHeightEntryCount	= 32,
+			kMaxStringLength	= 48
+		};
+
+		struct width_entry {
+			uint16	family_id;
+			uint16	style_id;
+			float	size;
+			uint8	spacing;
+			uint8	length;
+				// 0 marks an unused entry
+			char	string[kMaxStringLength];
+			float	width;
+		};
+
+		struct height_entry {
+			uint16	family_id;
+			uint16	style_id;
+			float	size;
+				// 0 marks an unused entry
+			font_height height;
+		};
+
+		bool _CheckRevision();
+		static uint32 _Hash(uint16 familyID, uint16 styleID, float size,
+					uint8 spacing, const char* string, int32 length);
+		static void _InitSingleton();
+
+		width_entry		fWidths[kWidthEntryCount];
+		height_entry	fHeights[kHeightEntryCount];
+		int32			fRevision;
+
+		static pthread_once_t		sDefaultInitOnce;
+		static FontMetricsCache*	sDefaultInstance;
+};
+
+pthread_once_t FontMetricsCache::sDefaultInitOnce = PTHREAD_ONCE_INIT;
+FontMetricsCache* FontMetricsCache::sDefaultInstance = NULL;
+
 }	// unnamed namespace
 
 
@@ -325,6 +392,166 @@ FontList::_InitSingleton()
 	sDefaultInstance = new FontList;
 }
 
+
+//	#pragma mark -
+
+
+FontMetricsCache::FontMetricsCache()
+	: BLocker("font metrics cache"),
+	fRevision(0)
+{
+	memset(fWidths, 0, sizeof(fWidths));
+	memset(fHeights, 0, sizeof(fHeights));
+}
+
+
+/*static*/ FontMetricsCache*
+FontMetricsCache::Default()
+{
+	if (be_app == NULL)
+		return NULL;
+
+	if (sDefaultInstance == NULL)
+		pthread_once(&sDefaultInitOnce, &_InitSingleton);
+
+	return sDefaultInstance;
+}
+
+
+bool
+FontMetricsCache::LookupWidth(uint16 familyID, uint16 styleID, float size,
+	uint8 spacing, const char* string, int32 length, float& width)
+{
+	if (string == NULL || length <= 0)
+		return false;
+
+	// the server doesn't measure beyond the end of the string either
+	length = strnlen(string, length);
+	if (length == 0 || length > kMaxStringLength)
+		return false;
+
+	BAutolock locker(this);
+
+	if (!_CheckRevision())
+		return false;
+
+	const width_entry& entry = fWidths[_Hash(familyID, styleID, size, spacing,
+		string, length) % kWidthEntryCount];
+	if (entry.length != length || entry.family_id != familyID
+		|| entry.style_id != styleID || entry.size != size
+		|| entry.spacing != spacing || memcmp(entry.string, string, length))
+		return false;
+
+	width = entry.width;
+	return true;
+}
+
+
+void
+FontMetricsCache::InsertWidth(uint16 familyID, uint16 styleID, float size,
+	uint8 spacing, const char* string, int32 length, float width)
+{
+	if (string == NULL || length <= 0)
+		return;
+
+	length = strnlen(string, length);
+	if (length == 0 || length > kMaxStringLength)
+		return;
+
+	BAutolock locker(this);
+
+	_CheckRevision();
+
+	// a newer entry simply replaces an older one with the same hash
+	width_entry& entry = fWidths[_Hash(familyID, styleID, size, spacing,
+		string, length) % kWidthEntryCount];
+	entry.family_id = familyID;
+	entry.style_id = styleID;
+	entry.size = size;
+	entry.spacing = spacing;
+	entry.length = length;
+	memcpy(entry.string, string, length);
+	entry.width = width;
+}
+
+
+bool
+FontMetricsCache::LookupHeight(uint16 familyID, uint16 styleID, float size,
+	font_height& height)
+{
+	BAutolock locker(this);
+
+	if (!_CheckRevision())
+		return false;
+
+	const height_entry& entry = fHeights[_Hash(familyID, styleID, size, 0,
+		NULL, 0) % kHeightEntryCount];
+	if (entry.size == 0 || entry.family_id != familyID
+		|| entry.style_id != styleID || entry.size != size)
+		return false;
+
+	height = entry.height;
+	return true;
+}
+
+
+void
+FontMetricsCache::InsertHeight(uint16 familyID, uint16 styleID, float size,
+	const font_height& height)
+{
+	if (size <= 0)
+		return;
+
+	BAutolock locker(this);
+
+	_CheckRevision();
+
+	height_entry& entry = fHeights[_Hash(familyID, styleID, size, 0, NULL, 0)
+		% kHeightEntryCount];
+	entry.family_id = familyID;
+	entry.style_id = styleID;
+	entry.size = size;
+	entry.height = height;
+}
+
+
+/*!	Empties the cache if the font settings on the server changed since it
+	was filled. Returns \c false in this case.
+*/
+bool
+FontMetricsCache::_CheckRevision()
+{
+	int32 revision = BApplication::Private::ServerReadOnlyMemory()
+		->font_metrics_revision;
+	if (revision == fRevision)
+		return true;
+
+	memset(fWidths, 0, sizeof(fWidths));
+	memset(fHeights, 0, sizeof(fHeights));
+	fRevision = revision;
+	return false;
+}
+
+
+/*static*/ uint32
+FontMetricsCache::_Hash(uint16 familyID, uint16 styleID, float size,
+	uint8 spacing, const char* string, int32 length)
+{
+	uint32 hash = ((uint32)familyID << 16) ^ styleID;
+	hash = hash * 31 + (uint32)(size * 64) + spacing;
+	for (int32 i = 0; i < length; i++)
+		hash = (hash << 5) - hash + (uint8)string[i];
+
+	return hash;
+}
+
+
+/*static*/ void
+FontMetricsCache::_InitSingleton()
+{
+	sDefaultInstance = new FontMetricsCache;
+}
+
 }	// unnamed namespace
 
 
@@ -1044,6 +1271,19 @@ BFont::GetStringWidths(const char *stringArray[], const int32 lengthArray[],
 	if (!stringArray || !lengthArray || numStrings < 1 || !widthArray)
 		return;
 
+	// only ask the server if any of the widths is unknown
+	FontMetricsCache* cache = FontMetricsCache::Default();
+	if (cache != NULL) {
+		int32 index = 0;
+		while (index < numStrings && cache->LookupWidth(fFamilyID, fStyleID,
+				fSize, fSpacing, stringArray[index], lengthArray[index],
+				widthArray[index])) {
+			index++;
+		}
+		if (index == numStrings)
+			return;
+	}
+
 	BPrivate::AppServerLink link;
 	link.StartMessage(AS_GET_STRING_WIDTHS);
 	link.Attach<uint16>(fFamilyID);
@@ -1065,6 +1305,13 @@ BFont::GetStringWidths(const char *stringArray[], const int32 lengthArray[],
 		return;
 
 	link.Read(widthArray, sizeof(float) * numStrings);
+
+	if (cache != NULL) {
+		for (int32 i = 0; i < numStrings; i++) {
+			cache->InsertWidth(fFamilyID, fStyleID, fSize, fSpacing,
+				stringArray[i], lengthArray[i], widthArray[i]);
+		}
+	}
 }
 
 
@@ -1189,6 +1436,10 @@ BFont::GetHeight(font_height *_height) const
 	if (_height == NULL)
 		return;
 
+	FontMetricsCache* cache = FontMetricsCache::Default();
+	if (fHeight.ascent == kUninitializedAscent && cache != NULL)
+		cache->LookupHeight(fFamilyID, fStyleID, fSize, fHeight);
+
 	if (fHeight.ascent == kUninitializedAscent) {
 		// we don't have the font height cached yet
 		BPrivate::AppServerLink link;
@@ -1207,6 +1458,9 @@ BFont::GetHeight(font_height *_height) const
 		// We made fHeight mutable for this, but we should drop the "const"
 		// when we can
 		link.Read<font_height>(&fHeight);
+
+		if (cache != NULL)
+			cache->InsertHeight(fFamilyID, fStyleID, fSize, fHeight);
 	}
 
 	*_height = fHeight;
@@ -14,12 +14,53 @@
 #include <string.h>
 
 #include <Debug.h>
+#include <ThreadSpareBuffers.h>
 
 #include "clipping.h"
 #include "RegionSupport.h"
 
 
 const static int32 kDataBlockSize = 8;
+const static int32 kMaxSpareDataSize = 256;
+	// larger rect arrays are not kept for reuse
+
+
+// Every region operation builds its result in a new rect array, and then
+// releases the previous array of the region. Each thread keeps the last
+// released array around, so that the next operation can use it instead of
+// allocating a new one.
+typedef ThreadSpareBuffers<BRegion, 1> SpareData;
+
+
+/*!	Returns an array for at least \a size rects, and sets \a size to the
+	actual number of rects it can hold.
+*/
+static clipping_rect*
+allocate_data(long& size)
+{
+	size_t bytes = size * sizeof(clipping_rect);
+	clipping_rect* data = (clipping_rect*)SpareData::Allocate(0, bytes);
+	size = bytes / sizeof(clipping_rect);
+	return data;
+}
+
+
+static void
+release_data(clipping_rect* data, long size)
+{
+	SpareData::Release(0, data, size * sizeof(clipping_rect),
+		kMaxSpareDataSize * sizeof(clipping_rect));
+}
+
+
+/*!	Checks if two rects in internal format overlap.
+*/
+static inline bool
+extents_intersect(const clipping_rect& a, const clipping_rect& b)
+{
+	return a.right > b.left && a.left < b.right && a.bottom > b.top
+		&& a.top < b.bottom;
+}
 
 
 /*! \brief Initializes a region. The region will have no rects,
@@ -86,7 +127,7 @@ BRegion::BRegion(const clipping_rect& rect)
 BRegion::~BRegion()
 {
 	if (fData != &fBounds)
-		free(fData);
+		release_data(fData, fDataSize);
 }
 
 
@@ -406,6 +447,17 @@ BRegion::Include(clipping_rect rect)
 	rect.right ++;
 	rect.bottom ++;
 
+	if (fCount == 0 || rect_contains(rect, fBounds)) {
+		_SetSize(1);
+		if (fData != NULL) {
+			fData[0] = fBounds = rect;
+			fCount = 1;
+		}
+		return;
+	}
+	if (fCount == 1 && rect_contains(fBounds, rect))
+		return;
+
 	// use private clipping_rect constructor which avoids malloc()
 	BRegion t(rect);
 
@@ -422,6 +474,13 @@ BRegion::Include(clipping_rect rect)
 void
 BRegion::Include(const BRegion* region)
 {
+	if (region->fCount == 0)
+		return;
+	if (fCount == 0) {
+		*this = *region;
+		return;
+	}
+
 	BRegion result;
 	Support::XUnionRegion(this, region, &result);
 
@@ -455,6 +514,13 @@ BRegion::Exclude(clipping_rect rect)
 	rect.right ++;
 	rect.bottom ++;
 
+	if (fCount == 0 || !extents_intersect(fBounds, rect))
+		return;
+	if (rect_contains(rect, fBounds)) {
+		MakeEmpty();
+		return;
+	}
+
 	// use private clipping_rect constructor which avoids malloc()
 	BRegion t(rect);
 
@@ -472,6 +538,11 @@ BRegion::Exclude(clipping_rect rect)
 void
 BRegion::Exclude(const BRegion* region)
 {
+	if (fCount == 0 || region->fCount == 0
+		|| !extents_intersect(fBounds, region->fBounds)) {
+		return;
+	}
+
 	BRegion result;
 	Support::XSubtractRegion(this, region, &result);
 
@@ -489,6 +560,18 @@ BRegion::Exclude(const BRegion* region)
 void
 BRegion::IntersectWith(const BRegion* region)
 {
+	if (fCount == 0 || region->fCount == 0
+		|| !extents_intersect(fBounds, region->fBounds)) {
+		MakeEmpty();
+		return;
+	}
+	if (region->fCount == 1 && rect_contains(region->fBounds, fBounds))
+		return;
+	if (fCount == 1 && rect_contains(fBounds, region->fBounds)) {
+		*this = *region;
+		return;
+	}
+
 	BRegion result;
 	Support::XIntersectRegion(this, region, &result);
 
@@ -522,11 +605,12 @@ BRegion::ExclusiveInclude(const BRegion* region)
 void
 BRegion::_AdoptRegionData(BRegion& region)
 {
+	if (fData != &fBounds)
+		release_data(fData, fDataSize);
+
 	fCount = region.fCount;
 	fDataSize = region.fDataSize;
 	fBounds = region.fBounds;
-	if (fData != &fBounds)
-		free(fData);
 	if (region.fData != &region.fBounds)
 		fData = region.fData;
 	else
@@ -557,8 +641,9 @@ BRegion::_SetSize(long newSize)
 
 	if (newSize > 0) {
 		if (fData == &fBounds) {
-			fData = (clipping_rect*)malloc(newSize * sizeof(clipping_rect));
-			fData[0] = fBounds;
+			fData = allocate_data(newSize);
+			if (fData != NULL)
+				fData[0] = fBounds;
 		} else if (fData) {
 			clipping_rect* resizedData = (clipping_rect*)realloc(fData,
 				newSize * sizeof(clipping_rect));
@@ -570,7 +655,7 @@ BRegion::_SetSize(long newSize)
 			} else
 				fData = resizedData;
 		} else
-			fData = (clipping_rect*)malloc(newSize * sizeof(clipping_rect));
+			fData = allocate_data(newSize);
 	} else {
 		// just an empty region, but no error
 		MakeEmpty();
@@ -75,6 +75,7 @@ SOFTWARE.
 #include "RegionSupport.h"
 
 #include <stdlib.h>
+#include <string.h>
 #include <new>
 
 using std::nothrow;
@@ -664,6 +665,8 @@ BRegion::Support::miCoalesce(
     int	    	  	prevNumRects;	/* Number of rectangles in previous
 					 * band */
     int	    	  	bandY1;	    	/* Y1 coordinate for current band */
+    int	    	  	removedRects;	/* Number of rectangles removed by
+					 * coalescing */
 
     pRegEnd = &pReg->fData[pReg->fCount];
 
@@ -733,6 +736,7 @@ BRegion::Support::miCoalesce(
 	    pReg->fCount -= curNumRects;
 	    pCurBox -= curNumRects;
 	    pPrevBox -= curNumRects;
+	    removedRects = curNumRects;
 
 	    /*
 	     * The bands may be merged, so set the bottom y of each box
@@ -755,7 +759,7 @@ BRegion::Support::miCoalesce(
 	     * other bands down. The assumption here is that the other bands
 	     * came from the same region as the current one and no further
 	     * coalescing can be done on them since it's all been done
-	     * already... curStart is already in the right place.
+	     * already... curStart just moves down with the last band.
 	     */
 	    if (pCurBox == pRegEnd)
 	    {
@@ -763,6 +767,7 @@ BRegion::Support::miCoalesce(
 	    }
 	    else
 	    {
+		curStart -= removedRects;
 		do
 		{
 		    *pPrevBox++ = *pCurBox++;
@@ -774,6 +779,47 @@ BRegion::Support::miCoalesce(
     return (curStart);
 }
 
+/*-
+ *-----------------------------------------------------------------------
+ * miCopyBands --
+ *	Copy all complete bands starting at r whose bottom is not below
+ *	limit to the region, as the non-overlapping functions would do band
+ *	by band. Used only by miRegionOp.
+ *
+ * Results:
+ *	The first rectangle that was not copied, or NULL if we ran out of
+ *	memory.
+ *
+ * Side Effects:
+ *	pReg->fCount is incremented. The copied bands are not coalesced with
+ *	each other, as they already were in the source region; only the first
+ *	one may still need to be coalesced with the previous band in pReg.
+ *
+ *-----------------------------------------------------------------------
+ */
+clipping_rect*
+BRegion::Support::miCopyBands(
+    register BRegion*	pReg,
+    register clipping_rect*	r,
+    clipping_rect*  	  	rEnd,
+    int  	  	limit)
+{
+    register clipping_rect*	pEnd = r;
+    int	    	  	count;
+
+    while ((pEnd != rEnd) && (pEnd->bottom <= limit))
+	pEnd++;
+
+    count = pEnd - r;
+    if (pReg->fCount + count > pReg->fDataSize
+	&& !pReg->_SetSize(pReg->fCount + count))
+	return NULL;
+
+    memcpy(&pReg->fData[pReg->fCount], r, count * sizeof(clipping_rect));
+    pReg->fCount += count;
+    return pEnd;
+}
+
 /*-
  *-----------------------------------------------------------------------
  * miRegionOp --
@@ -927,6 +973,32 @@ BRegion::Support::miRegionOp(
 	{
 	    r2BandEnd++;
 	}
+
+	/*
+	 * Bands that lie completely above the other region's current band
+	 * are copied unchanged by both non-overlapping functions, so all of
+	 * them can be copied at once.
+	 */
+	if ((nonOverlap1Func != NULL) && (r1->top >= ybot)
+	    && (r1->bottom <= r2->top))
+	{
+	    r1 = miCopyBands(newReg, r1, r1End, r2->top);
+	    if (r1 == NULL)
+		return;
+	    ybot = r1[-1].bottom;
+	    prevBand = miCoalesce (newReg, prevBand, curBand);
+	    continue;
+	}
+	if ((nonOverlap2Func != NULL) && (r2->top >= ybot)
+	    && (r2->bottom <= r1->top))
+	{
+	    r2 = miCopyBands(newReg, r2, r2End, r1->top);
+	    if (r2 == NULL)
+		return;
+	    ybot = r2[-1].bottom;
+	    prevBand = miCoalesce (newReg, prevBand, curBand);
+	    continue;
+	}
 	
 	/*
 	 * First handle the band that doesn't intersect, if any.
@@ -1015,32 +1087,33 @@ BRegion::Support::miRegionOp(
     {
 	if (nonOverlap1Func != NULL)
 	{
-	    do
+	    /*
+	     * Only the first band may have to be clipped, the others can be
+	     * copied unchanged.
+	     */
+	    r1BandEnd = r1;
+	    while ((r1BandEnd < r1End) && (r1BandEnd->top == r1->top))
 	    {
-		r1BandEnd = r1;
-		while ((r1BandEnd < r1End) && (r1BandEnd->top == r1->top))
-		{
-		    r1BandEnd++;
-		}
-		(* nonOverlap1Func) (newReg, r1, r1BandEnd,
-				     max_c(r1->top,ybot), r1->bottom);
-		r1 = r1BandEnd;
-	    } while (r1 != r1End);
+		r1BandEnd++;
+	    }
+	    (* nonOverlap1Func) (newReg, r1, r1BandEnd,
+				 max_c(r1->top,ybot), r1->bottom);
+	    if (miCopyBands(newReg, r1BandEnd, r1End, r1End[-1].bottom)
+		== NULL)
+		return;
 	}
     }
     else if ((r2 != r2End) && (nonOverlap2Func != NULL))
     {
-	do
+	r2BandEnd = r2;
+	while ((r2BandEnd < r2End) && (r2BandEnd->top == r2->top))
 	{
-	    r2BandEnd = r2;
-	    while ((r2BandEnd < r2End) && (r2BandEnd->top == r2->top))
-	    {
-		 r2BandEnd++;
-	    }
-	    (* nonOverlap2Func) (newReg, r2, r2BandEnd,
-				max_c(r2->top,ybot), r2->bottom);
-	    r2 = r2BandEnd;
-	} while (r2 != r2End);
+	     r2BandEnd++;
+	}
+	(* nonOverlap2Func) (newReg, r2, r2BandEnd,
+			    max_c(r2->top,ybot), r2->bottom);
+	if (miCopyBands(newReg, r2BandEnd, r2End, r2End[-1].bottom) == NULL)
+	    return;
     }
 
     if (newReg->fCount != curBand)
@@ -1538,21 +1611,47 @@ BRegion::Support::XXorRegion(const BRegion* sra, const BRegion* srb,
 }
 
 
+/*
+ * Returns the first rectangle whose bottom is below y, that is the first
+ * rectangle of the band containing y, or of the band after it. Since the
+ * bands are sorted from top to bottom, it can be found by a binary search.
+ */
+static clipping_rect*
+FindBand(clipping_rect* rects, int count, int y)
+{
+    int lower = 0;
+    int upper = count;
+
+    while (lower < upper)
+    {
+	int middle = (lower + upper) / 2;
+	if (rects[middle].bottom <= y)
+	    lower = middle + 1;
+	else
+	    upper = middle;
+    }
+    return rects + lower;
+}
+
 int 
 BRegion::Support::XPointInRegion(
     const BRegion* pRegion,
     int x, int y)
 {
-	// TODO: binary search by "y"!
-    int i;
+    register clipping_rect* pbox;
+    register clipping_rect* pboxEnd;
 
     if (pRegion->fCount == 0)
         return false;
     if (!INBOX(pRegion->fBounds, x, y))
         return false;
-    for (i=0; i<pRegion->fCount; i++)
+
+    pboxEnd = pRegion->fData + pRegion->fCount;
+    for (pbox = FindBand(pRegion->fData, pRegion->fCount, y);
+	 pbox < pboxEnd && pbox->top <= y;
+	 pbox++)
     {
-        if (INBOX (pRegion->fData[i], x, y))
+        if (INBOX (*pbox, x, y))
 	    return true;
     }
     return false;
@@ -1579,7 +1678,8 @@ BRegion::Support::XRectInRegion(
     partIn = false;
 
     /* can stop when both partOut and partIn are true, or we reach prect->bottom */
-    for (pbox = region->fData, pboxEnd = pbox + region->fCount;
+    for (pbox = FindBand(region->fData, region->fCount, ry),
+	 pboxEnd = region->fData + region->fCount;
 	 pbox < pboxEnd;
 	 pbox++)
     {
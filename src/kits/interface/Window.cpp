@@ -746,6 +746,7 @@ BWindow::MessageReceived(BMessage* msg)
 			fLink->AttachString(fTitle);
 
 			port_id sendPort;
+			area_id ringArea = -1;
 			int32 code;
 			if (fLink->FlushWithReply(code) == B_OK
 				&& code == B_OK
@@ -758,6 +759,7 @@ BWindow::MessageReceived(BMessage* msg)
 				fLink->Read<float>(&fMaxWidth);
 				fLink->Read<float>(&fMinHeight);
 				fLink->Read<float>(&fMaxHeight);
+				fLink->Read<area_id>(&ringArea);
 
 				fMaxZoomWidth = fMaxWidth;
 				fMaxZoomHeight = fMaxHeight;
@@ -766,6 +768,7 @@ BWindow::MessageReceived(BMessage* msg)
 
 			// Redirect our link to the new window connection
 			fLink->SetSenderPort(sendPort);
+			fLink->Sender().SetRing(ringArea);
 
 			// connect all views to the server again
 			fTopView->_CreateSelf();
@@ -1424,7 +1427,10 @@ FrameMoved(origin);
 					if (error < B_OK)
 						break;
 				}
-				// draw
+				// draw - the drawing commands of all views are sent to
+				// the server in one go with AS_END_UPDATE (unless a view
+				// needs a reply from the server in between)
+				fLink->Sender().SetBatching(true);
 				int32 count = infos.CountItems();
 				for (int32 i = 0; i < count; i++) {
 //bigtime_t drawStart = system_time();
@@ -1454,6 +1460,7 @@ FrameMoved(origin);
 
 			fLink->StartMessage(AS_END_UPDATE);
 			fLink->Flush();
+			fLink->Sender().SetBatching(false);
 			fInTransaction = false;
 			fUpdateRequested = false;
 
@@ -2935,6 +2942,7 @@ BWindow::_InitData(BRect frame, const char* title, window_look look,
 		fLink->AttachString(title);
 
 		port_id sendPort;
+		area_id ringArea = -1;
 		int32 code;
 		if (fLink->FlushWithReply(code) == B_OK
 			&& code == B_OK
@@ -2947,6 +2955,7 @@ BWindow::_InitData(BRect frame, const char* title, window_look look,
 			fLink->Read<float>(&fMaxWidth);
 			fLink->Read<float>(&fMinHeight);
 			fLink->Read<float>(&fMaxHeight);
+			fLink->Read<area_id>(&ringArea);
 
 			fMaxZoomWidth = fMaxWidth;
 			fMaxZoomHeight = fMaxHeight;
@@ -2955,6 +2964,7 @@ BWindow::_InitData(BRect frame, const char* title, window_look look,
 
 		// Redirect our link to the new window connection
 		fLink->SetSenderPort(sendPort);
+		fLink->Sender().SetRing(ringArea);
 	}
 
 	STRACE(("Server says that our send port is %ld\n", sendPort));
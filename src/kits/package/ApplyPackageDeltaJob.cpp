@@ -0,0 +1,103 @@
+/*
+ * Copyright 2011, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include <package/ApplyPackageDeltaJob.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <Path.h>
+
+#include <package/PackageDeltaReader.h>
+
+
+namespace BPackageKit {
+
+namespace BPrivate {
+
+
+ApplyPackageDeltaJob::ApplyPackageDeltaJob(const BContext& context,
+	const BString& title, const BEntry& oldPackageEntry,
+	const BEntry& deltaEntry, const BEntry& targetEntry)
+	:
+	inherited(context, title),
+	fOldPackageEntry(oldPackageEntry),
+	fDeltaEntry(deltaEntry),
+	fTargetEntry(targetEntry)
+{
+}
+
+
+ApplyPackageDeltaJob::~ApplyPackageDeltaJob()
+{
+}
+
+
+status_t
+ApplyPackageDeltaJob::Execute()
+{
+	BPath oldPackagePath;
+	status_t result = fOldPackageEntry.GetPath(&oldPackagePath);
+	if (result != B_OK)
+		return result;
+
+	BPath deltaPath;
+	if ((result = fDeltaEntry.GetPath(&deltaPath)) != B_OK)
+		return result;
+
+	BPath targetPath;
+	if ((result = fTargetEntry.GetPath(&targetPath)) != B_OK)
+		return result;
+
+	PackageDeltaReader deltaReader;
+	if ((result = deltaReader.Init(deltaPath.Path())) != B_OK) {
+		SetErrorString(BString("failed to read package delta ")
+			<< deltaPath.Path());
+		return result;
+	}
+
+	int oldPackageFD = open(oldPackagePath.Path(), O_RDONLY);
+	if (oldPackageFD < 0) {
+		SetErrorString(BString("failed to open package ")
+			<< oldPackagePath.Path());
+		return errno;
+	}
+
+	int targetFD = open(targetPath.Path(), O_WRONLY | O_CREAT | O_TRUNC,
+		S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+	if (targetFD < 0) {
+		result = errno;
+		close(oldPackageFD);
+		SetErrorString(BString("failed to create package ")
+			<< targetPath.Path());
+		return result;
+	}
+
+	result = deltaReader.Apply(oldPackageFD, targetFD);
+	if (result == B_MISMATCHED_VALUES) {
+		SetErrorString(BString("package delta ") << deltaPath.Path()
+			<< " does not apply to " << oldPackagePath.Path());
+	}
+
+	close(targetFD);
+	close(oldPackageFD);
+
+	return result;
+}
+
+
+void
+ApplyPackageDeltaJob::Cleanup(status_t jobResult)
+{
+	if (jobResult != B_OK)
+		fTargetEntry.Remove();
+}
+
+
+}	// namespace BPrivate
+
+}	// namespace BPackageKit
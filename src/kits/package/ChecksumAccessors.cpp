@@ -8,11 +8,13 @@
 
 
 #include <File.h>
+#include <Path.h>
 
 #include <AutoDeleter.h>
 #include <SHA256.h>
 
 #include <package/ChecksumAccessors.h>
+#include <package/PackageDeltaReader.h>
 
 
 namespace BPackageKit {
@@ -20,10 +22,6 @@ namespace BPackageKit {
 namespace BPrivate {
 
 
-#define NIBBLE_AS_HEX(nibble) \
-	(nibble >= 10 ? 'a' + nibble - 10 : '0' + nibble)
-
-
 ChecksumAccessor::~ChecksumAccessor()
 {
 }
@@ -109,19 +107,55 @@ GeneralFileChecksumAccessor::GetChecksum(BString& checksum) const
 		}
 	}
 
-	const int kSHA256ChecksumSize = sha.DigestLength();
-	char* buffer = checksum.LockBuffer(2 * kSHA256ChecksumSize);
+	return checksum_to_string(sha.Digest(), sha.DigestLength(), checksum);
+}
+
+
+PackageDeltaChecksumAccessor::PackageDeltaChecksumAccessor(
+	const BEntry& deltaFileEntry, bool newPackage)
+	:
+	fDeltaFileEntry(deltaFileEntry),
+	fNewPackage(newPackage)
+{
+}
+
+
+status_t
+PackageDeltaChecksumAccessor::GetChecksum(BString& checksum) const
+{
+	BPath deltaFilePath;
+	status_t result = fDeltaFileEntry.GetPath(&deltaFilePath);
+	if (result != B_OK)
+		return result;
+
+	PackageDeltaReader deltaReader;
+	if ((result = deltaReader.Init(deltaFilePath.Path())) != B_OK)
+		return result;
+
+	return fNewPackage
+		? deltaReader.GetNewPackageChecksum(checksum)
+		: deltaReader.GetOldPackageChecksum(checksum);
+}
+
+
+// #pragma mark -
+
+
+status_t
+checksum_to_string(const uint8* checksum, size_t size, BString& string)
+{
+	static const char* const kHexDigits = "0123456789abcdef";
+
+	char* buffer = string.LockBuffer(2 * size);
 	if (buffer == NULL)
 		return B_NO_MEMORY;
-	const uint8* digest = sha.Digest();
-	for (int i = 0; i < kSHA256ChecksumSize; ++i) {
-		uint8 highNibble = (digest[i] & 0xF0) >> 4;
-		buffer[i * 2] = NIBBLE_AS_HEX(highNibble);
-		uint8 lowNibble = digest[i] & 0x0F;
-		buffer[1 + i * 2] = NIBBLE_AS_HEX(lowNibble);
+
+	for (size_t i = 0; i < size; i++) {
+		buffer[i * 2] = kHexDigits[checksum[i] >> 4];
+		buffer[i * 2 + 1] = kHexDigits[checksum[i] & 0x0f];
 	}
-	buffer[2 * kSHA256ChecksumSize] = '\0';
-	checksum.UnlockBuffer(2 * kSHA256ChecksumSize);
+	buffer[2 * size] = '\0';
+	string.UnlockBuffer(2 * size);
 
 	return B_OK;
 }
@@ -62,6 +62,11 @@ BJob::BJob(const BContext& context, const BString& title)
 
 BJob::~BJob()
 {
+	// detach from the jobs we depend on and from the ones depending on us
+	for (int32 i = 0; BJob* job = fDependencies.ItemAt(i); i++)
+		job->fDependantJobs.RemoveItem(this);
+	for (int32 i = 0; BJob* job = fDependantJobs.ItemAt(i); i++)
+		job->fDependencies.RemoveItem(this);
 }
 
 
@@ -121,15 +126,8 @@ BJob::_ClearTicketNumber()
 }
 
 
-void
-BJob::SetErrorString(const BString& error)
-{
-	fErrorString = error;
-}
-
-
 status_t
-BJob::Run()
+BJob::_Start()
 {
 	if (fState != JOB_STATE_WAITING_TO_RUN)
 		return B_NOT_ALLOWED;
@@ -137,15 +135,46 @@ BJob::Run()
 	fState = JOB_STATE_RUNNING;
 	NotifyStateListeners();
 
+	return B_OK;
+}
+
+
+void
+BJob::_Execute()
+{
 	fResult = Execute();
 	Cleanup(fResult);
+}
 
+
+void
+BJob::_Finish()
+{
 	fState = fResult == B_OK
 		? JOB_STATE_SUCCEEDED
 		: fResult == B_CANCELED
 			? JOB_STATE_ABORTED
 			: JOB_STATE_FAILED;
 	NotifyStateListeners();
+}
+
+
+void
+BJob::SetErrorString(const BString& error)
+{
+	fErrorString = error;
+}
+
+
+status_t
+BJob::Run()
+{
+	status_t result = _Start();
+	if (result != B_OK)
+		return result;
+
+	_Execute();
+	_Finish();
 
 	return fResult;
 }
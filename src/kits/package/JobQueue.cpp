@@ -9,9 +9,11 @@
 
 #include <package/JobQueue.h>
 
+#include <new>
 #include <set>
 
 #include <Autolock.h>
+#include <ObjectList.h>
 
 #include <package/Job.h>
 
@@ -49,10 +51,232 @@ class JobQueue::JobPriorityQueue
 };
 
 
+// #pragma mark - WorkerPool
+
+
+/*!	A fixed number of threads executing the jobs handed to them. Only the
+	Execute() part of a job is run by the workers, starting and finishing the
+	job (and thus notifying its listeners) is left to the thread owning the
+	pool. Without any workers, jobs are executed synchronously.
+	Shutdown() lets the workers complete the jobs they are executing, and
+	leaves the ones they haven't picked up yet to RemovePendingJob().
+*/
+class JobQueue::WorkerPool {
+public:
+								WorkerPool();
+								~WorkerPool();
+
+			status_t			Init(int32 workerCount);
+
+			status_t			Execute(BJob* job);
+			status_t			WaitForFinishedJob(BJob*& _job);
+
+			void				Shutdown();
+			BJob*				RemovePendingJob();
+			BJob*				RemoveFinishedJob();
+
+private:
+	static	status_t			_WorkerEntry(void* data);
+			void				_Work();
+
+private:
+	typedef	BObjectList<BJob>	JobList;
+
+			BLocker				fLock;
+			JobList				fPendingJobs;
+			JobList				fFinishedJobs;
+			sem_id				fPendingJobSem;
+			sem_id				fFinishedJobSem;
+			thread_id*			fWorkers;
+			int32				fWorkerCount;
+};
+
+
+JobQueue::WorkerPool::WorkerPool()
+	:
+	fLock("job queue workers"),
+	fPendingJobs(20, false),
+	fFinishedJobs(20, false),
+	fPendingJobSem(-1),
+	fFinishedJobSem(-1),
+	fWorkers(NULL),
+	fWorkerCount(0)
+{
+}
+
+
+JobQueue::WorkerPool::~WorkerPool()
+{
+	Shutdown();
+
+	if (fFinishedJobSem >= 0)
+		delete_sem(fFinishedJobSem);
+}
+
+
+status_t
+JobQueue::WorkerPool::Init(int32 workerCount)
+{
+	status_t result = fLock.InitCheck();
+	if (result != B_OK)
+		return result;
+
+	fFinishedJobSem = create_sem(0, "finished jobs");
+	if (fFinishedJobSem < 0)
+		return fFinishedJobSem;
+
+	if (workerCount == 0)
+		return B_OK;
+
+	fPendingJobSem = create_sem(0, "pending jobs");
+	if (fPendingJobSem < 0)
+		return fPendingJobSem;
+
+	fWorkers = new(std::nothrow) thread_id[workerCount];
+	if (fWorkers == NULL)
+		return B_NO_MEMORY;
+
+	for (int32 i = 0; i < workerCount; i++) {
+		thread_id worker = spawn_thread(&_WorkerEntry, "job queue worker",
+			B_NORMAL_PRIORITY, this);
+		if (worker < 0)
+			return worker;
+
+		fWorkers[fWorkerCount++] = worker;
+		resume_thread(worker);
+	}
+
+	return B_OK;
+}
+
+
+status_t
+JobQueue::WorkerPool::Execute(BJob* job)
+{
+	if (fWorkerCount == 0) {
+		job->_Execute();
+
+		BAutolock lock(&fLock);
+		if (!fFinishedJobs.AddItem(job))
+			return B_NO_MEMORY;
+
+		status_t result = release_sem(fFinishedJobSem);
+		if (result != B_OK)
+			fFinishedJobs.RemoveItem(job);
+		return result;
+	}
+
+	BAutolock lock(&fLock);
+	if (!fPendingJobs.AddItem(job))
+		return B_NO_MEMORY;
+
+	status_t result = release_sem(fPendingJobSem);
+	if (result != B_OK)
+		fPendingJobs.RemoveItem(job);
+
+	return result;
+}
+
+
+status_t
+JobQueue::WorkerPool::WaitForFinishedJob(BJob*& _job)
+{
+	status_t result;
+	do {
+		result = acquire_sem(fFinishedJobSem);
+	} while (result == B_INTERRUPTED);
+	if (result != B_OK)
+		return result;
+
+	_job = RemoveFinishedJob();
+	return _job != NULL ? B_OK : B_ERROR;
+}
+
+
+void
+JobQueue::WorkerPool::Shutdown()
+{
+	// deleting the semaphore makes the workers quit once they are done with
+	// their current job
+	if (fPendingJobSem >= 0) {
+		delete_sem(fPendingJobSem);
+		fPendingJobSem = -1;
+	}
+
+	for (int32 i = 0; i < fWorkerCount; i++) {
+		status_t result;
+		wait_for_thread(fWorkers[i], &result);
+	}
+	delete[] fWorkers;
+	fWorkers = NULL;
+	fWorkerCount = 0;
+}
+
+
+BJob*
+JobQueue::WorkerPool::RemovePendingJob()
+{
+	BAutolock lock(&fLock);
+	return fPendingJobs.RemoveItemAt(0);
+}
+
+
+BJob*
+JobQueue::WorkerPool::RemoveFinishedJob()
+{
+	BAutolock lock(&fLock);
+	return fFinishedJobs.RemoveItemAt(0);
+}
+
+
+/*static*/ status_t
+JobQueue::WorkerPool::_WorkerEntry(void* data)
+{
+	((WorkerPool*)data)->_Work();
+	return B_OK;
+}
+
+
+void
+JobQueue::WorkerPool::_Work()
+{
+	while (true) {
+		status_t result = acquire_sem(fPendingJobSem);
+		if (result == B_INTERRUPTED)
+			continue;
+		if (result != B_OK)
+			return;
+
+		BAutolock lock(&fLock);
+		BJob* job = fPendingJobs.RemoveItemAt(0);
+		lock.Unlock();
+		if (job == NULL)
+			continue;
+
+		job->_Execute();
+
+		lock.Lock();
+		bool added = fFinishedJobs.AddItem(job);
+		lock.Unlock();
+		if (!added) {
+			debugger("JobQueue: failed to add finished job");
+			continue;
+		}
+
+		release_sem(fFinishedJobSem);
+	}
+}
+
+
+// #pragma mark - JobQueue
+
+
 JobQueue::JobQueue()
 	:
 	fLock("job queue"),
-	fNextTicketNumber(1)
+	fNextTicketNumber(1),
+	fQueuedJobs(NULL),
+	fHaveRunnableJobSem(-1)
 {
 	fInitStatus = _Init();
 }
@@ -60,6 +284,8 @@ JobQueue::JobQueue()
 
 JobQueue::~JobQueue()
 {
+	Close();
+	delete fQueuedJobs;
 }
 
 
@@ -134,6 +360,15 @@ JobQueue::JobFailed(BJob* job)
 }
 
 
+void
+JobQueue::JobAborted(BJob* job)
+{
+	BAutolock lock(&fLock);
+	if (lock.IsLocked())
+		_RemoveDependantJobsOf(job);
+}
+
+
 BJob*
 JobQueue::Pop()
 {
@@ -159,14 +394,97 @@ JobQueue::Pop()
 			if (head == fQueuedJobs->end())
 				return NULL;
 		}
+		BJob* job = *head;
 		fQueuedJobs->erase(head);
-		return *head;
+		return job;
 	}
 
 	return NULL;
 }
 
 
+/*!	Runs all queued jobs, including the ones that are added while running,
+	until the queue is empty or a job didn't succeed. Up to \a maxParallelJobs
+	jobs whose dependencies have been met are executed concurrently. The jobs
+	are started and finished in the calling thread, so all state listeners
+	are notified there, and dependant jobs are requeued before any further job
+	is started. Jobs are deleted once they are done.
+
+	Since BJob::Execute() runs in the worker threads, anything a job calls
+	from there, like the context's BDecisionProvider, may be called by several
+	threads at once. The same goes for listeners shared by requests that are
+	processed in different threads.
+
+	If waiting for the workers fails, the jobs they haven't started yet are
+	aborted, and the running ones are waited for before returning.
+	Returns the result of the first job that didn't succeed, or \c B_OK.
+*/
+status_t
+JobQueue::RunJobs(int32 maxParallelJobs)
+{
+	if (fQueuedJobs == NULL)
+		return B_NO_INIT;
+
+#ifdef HAIKU_TARGET_PLATFORM_HAIKU
+	if (maxParallelJobs <= 0) {
+		system_info info;
+		maxParallelJobs = get_system_info(&info) == B_OK ? info.cpu_count : 1;
+	}
+#else
+	// the build platform emulation doesn't support threads
+	maxParallelJobs = 1;
+#endif
+
+	WorkerPool workers;
+	status_t result = workers.Init(maxParallelJobs > 1 ? maxParallelJobs : 0);
+	if (result != B_OK)
+		return result;
+
+	int32 runningJobs = 0;
+	status_t jobResult = B_OK;
+	while (true) {
+		// start as many runnable jobs as allowed, but none after a failure
+		while (jobResult == B_OK && runningJobs < maxParallelJobs) {
+			BJob* job = _PopRunnableJob();
+			if (job == NULL)
+				break;
+
+			if (job->_Start() != B_OK) {
+				delete job;
+				continue;
+			}
+
+			if ((result = workers.Execute(job)) != B_OK) {
+				job->fResult = result;
+				job->_Finish();
+				delete job;
+				jobResult = result;
+				break;
+			}
+			runningJobs++;
+		}
+
+		if (runningJobs == 0)
+			break;
+
+		BJob* job;
+		result = workers.WaitForFinishedJob(job);
+		if (result != B_OK) {
+			_CancelJobs(workers);
+			return jobResult != B_OK ? jobResult : result;
+		}
+		runningJobs--;
+
+		job->_Finish();
+		if (job->Result() != B_OK && jobResult == B_OK)
+			jobResult = job->Result();
+		delete job;
+	}
+
+	return jobResult;
+}
+
+
 void
 JobQueue::Close()
 {
@@ -190,6 +508,44 @@ JobQueue::Close()
 }
 
 
+/*!	Stops the workers, and finishes the jobs handed to them: the ones that
+	were executed normally, the ones the workers didn't get to as aborted.
+*/
+void
+JobQueue::_CancelJobs(WorkerPool& workers)
+{
+	workers.Shutdown();
+
+	while (BJob* job = workers.RemoveFinishedJob()) {
+		job->_Finish();
+		delete job;
+	}
+
+	while (BJob* job = workers.RemovePendingJob()) {
+		job->fResult = B_CANCELED;
+		job->_Finish();
+		delete job;
+	}
+}
+
+
+BJob*
+JobQueue::_PopRunnableJob()
+{
+	BAutolock lock(&fLock);
+	if (!lock.IsLocked())
+		return NULL;
+
+	JobPriorityQueue::iterator head = fQueuedJobs->begin();
+	if (head == fQueuedJobs->end() || !(*head)->IsRunnable())
+		return NULL;
+
+	BJob* job = *head;
+	fQueuedJobs->erase(head);
+	return job;
+}
+
+
 status_t
 JobQueue::_Init()
 {
@@ -222,6 +578,8 @@ JobQueue::_RequeueDependantJobsOf(BJob* job)
 			fQueuedJobs->insert(dependantJob);
 		} catch (...) {
 		}
+		if (dependantJob->IsRunnable() && fHaveRunnableJobSem >= 0)
+			release_sem(fHaveRunnableJobSem);
 	}
 }
 
@@ -235,7 +593,8 @@ JobQueue::_RemoveDependantJobsOf(BJob* job)
 		} catch (...) {
 		}
 		_RemoveDependantJobsOf(dependantJob);
-		delete job;
+		delete dependantJob;
+			// detaches it from job and its other dependencies
 	}
 }
 
@@ -0,0 +1,267 @@
+/*
+ * Copyright 2011, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include <package/PackageDeltaReader.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <new>
+
+#include <ByteOrder.h>
+
+#include <package/ChecksumAccessors.h>
+#include <package/hpkg/HPKGDefsPrivate.h>
+
+
+namespace BPackageKit {
+
+namespace BPrivate {
+
+
+using namespace BHPKG::BPrivate;
+
+
+static const size_t kCopyBufferSize = 64 * 1024;
+
+
+PackageDeltaReader::PackageDeltaReader()
+	:
+	fFD(-1),
+	fOwnsFD(false),
+	fOldPackageSize(0),
+	fNewPackageSize(0),
+	fCommands(NULL),
+	fCommandCount(0),
+	fInitStatus(B_NO_INIT)
+{
+}
+
+
+PackageDeltaReader::~PackageDeltaReader()
+{
+	if (fOwnsFD && fFD >= 0)
+		close(fFD);
+
+	delete[] fCommands;
+}
+
+
+status_t
+PackageDeltaReader::Init(const char* fileName)
+{
+	int fd = open(fileName, O_RDONLY);
+	if (fd < 0)
+		return fInitStatus = errno;
+
+	return Init(fd, true);
+}
+
+
+status_t
+PackageDeltaReader::Init(int fd, bool keepFD)
+{
+	fInitStatus = _Init(fd, keepFD);
+	return fInitStatus;
+}
+
+
+status_t
+PackageDeltaReader::GetOldPackageChecksum(BString& checksum) const
+{
+	if (fInitStatus != B_OK)
+		return fInitStatus;
+
+	return checksum_to_string(fOldPackageChecksum,
+		sizeof(fOldPackageChecksum), checksum);
+}
+
+
+status_t
+PackageDeltaReader::GetNewPackageChecksum(BString& checksum) const
+{
+	if (fInitStatus != B_OK)
+		return fInitStatus;
+
+	return checksum_to_string(fNewPackageChecksum,
+		sizeof(fNewPackageChecksum), checksum);
+}
+
+
+/*!	Reconstructs the new package from \a oldPackageFD and the delta and writes
+	it to \a targetFD. The caller is responsible for validating the checksums
+	of the old and the resulting package.
+*/
+status_t
+PackageDeltaReader::Apply(int oldPackageFD, int targetFD)
+{
+	if (fInitStatus != B_OK)
+		return fInitStatus;
+
+	struct stat st;
+	if (fstat(oldPackageFD, &st) < 0)
+		return errno;
+	if ((uint64)st.st_size != fOldPackageSize)
+		return B_MISMATCHED_VALUES;
+
+	uint8* buffer = (uint8*)malloc(kCopyBufferSize);
+	if (buffer == NULL)
+		return B_NO_MEMORY;
+
+	status_t error = B_OK;
+	off_t targetOffset = 0;
+	for (uint32 i = 0; i < fCommandCount && error == B_OK; i++) {
+		const hpkg_delta_command& command = fCommands[i];
+		int sourceFD = command.type == B_HPKG_DELTA_COMMAND_COPY
+			? oldPackageFD : fFD;
+		error = _Copy(sourceFD, command.offset, targetFD, targetOffset,
+			command.size, buffer);
+		targetOffset += command.size;
+	}
+
+	free(buffer);
+
+	if (error == B_OK && ftruncate(targetFD, targetOffset) < 0)
+		error = errno;
+
+	return error;
+}
+
+
+status_t
+PackageDeltaReader::_Init(int fd, bool keepFD)
+{
+	if (fOwnsFD && fFD >= 0)
+		close(fFD);
+	delete[] fCommands;
+	fCommands = NULL;
+	fCommandCount = 0;
+
+	fFD = fd;
+	fOwnsFD = keepFD;
+
+	struct stat st;
+	if (fstat(fFD, &st) < 0)
+		return errno;
+
+	// read and check the header
+	hpkg_delta_header header;
+	ssize_t bytesRead = pread(fFD, &header, sizeof(header), 0);
+	if (bytesRead < 0)
+		return errno;
+	if ((size_t)bytesRead != sizeof(header))
+		return B_BAD_DATA;
+
+	if (B_BENDIAN_TO_HOST_INT32(header.magic) != B_HPKG_DELTA_MAGIC
+		|| B_BENDIAN_TO_HOST_INT16(header.version) != B_HPKG_DELTA_VERSION
+		|| B_BENDIAN_TO_HOST_INT16(header.header_size) < sizeof(header)
+		|| B_BENDIAN_TO_HOST_INT64(header.total_size) != (uint64)st.st_size) {
+		return B_BAD_DATA;
+	}
+
+	uint64 headerSize = B_BENDIAN_TO_HOST_INT16(header.header_size);
+	fOldPackageSize = B_BENDIAN_TO_HOST_INT64(header.old_package_size);
+	fNewPackageSize = B_BENDIAN_TO_HOST_INT64(header.new_package_size);
+	memcpy(fOldPackageChecksum, header.old_package_checksum,
+		sizeof(fOldPackageChecksum));
+	memcpy(fNewPackageChecksum, header.new_package_checksum,
+		sizeof(fNewPackageChecksum));
+
+	// read the commands
+	uint32 commandCount = B_BENDIAN_TO_HOST_INT32(header.command_count);
+	uint64 commandsSize = (uint64)commandCount * sizeof(hpkg_delta_command);
+	if (headerSize > (uint64)st.st_size
+		|| commandsSize > (uint64)st.st_size - headerSize) {
+		return B_BAD_DATA;
+	}
+
+	fCommands = new(std::nothrow) hpkg_delta_command[commandCount];
+	if (fCommands == NULL)
+		return B_NO_MEMORY;
+
+	bytesRead = pread(fFD, fCommands, commandsSize, headerSize);
+	if (bytesRead < 0)
+		return errno;
+	if ((uint64)bytesRead != commandsSize)
+		return B_BAD_DATA;
+
+	fCommandCount = commandCount;
+
+	// swap and check the commands
+	uint64 dataOffset = headerSize + commandsSize;
+	uint64 newSize = 0;
+	for (uint32 i = 0; i < commandCount; i++) {
+		hpkg_delta_command& command = fCommands[i];
+		command.type = B_BENDIAN_TO_HOST_INT32(command.type);
+		command.offset = B_BENDIAN_TO_HOST_INT64(command.offset);
+		command.size = B_BENDIAN_TO_HOST_INT64(command.size);
+
+		uint64 sourceSize;
+		uint64 sourceStart = 0;
+		switch (command.type) {
+			case B_HPKG_DELTA_COMMAND_COPY:
+				sourceSize = fOldPackageSize;
+				break;
+			case B_HPKG_DELTA_COMMAND_DATA:
+				sourceSize = st.st_size;
+				sourceStart = dataOffset;
+				break;
+			default:
+				return B_BAD_DATA;
+		}
+
+		if (command.offset < sourceStart || command.offset > sourceSize
+			|| command.size > sourceSize - command.offset
+			|| command.size > fNewPackageSize - newSize) {
+			return B_BAD_DATA;
+		}
+
+		newSize += command.size;
+	}
+
+	if (newSize != fNewPackageSize)
+		return B_BAD_DATA;
+
+	return B_OK;
+}
+
+
+status_t
+PackageDeltaReader::_Copy(int sourceFD, off_t sourceOffset, int targetFD,
+	off_t targetOffset, uint64 size, uint8* buffer)
+{
+	while (size > 0) {
+		size_t toCopy = std::min(size, (uint64)kCopyBufferSize);
+
+		ssize_t bytesRead = pread(sourceFD, buffer, toCopy, sourceOffset);
+		if (bytesRead < 0)
+			return errno;
+		if ((size_t)bytesRead != toCopy)
+			return B_IO_ERROR;
+
+		ssize_t bytesWritten = pwrite(targetFD, buffer, toCopy, targetOffset);
+		if (bytesWritten < 0)
+			return errno;
+		if ((size_t)bytesWritten != toCopy)
+			return B_IO_ERROR;
+
+		sourceOffset += toCopy;
+		targetOffset += toCopy;
+		size -= toCopy;
+	}
+
+	return B_OK;
+}
+
+
+}	// namespace BPrivate
+
+}	// namespace BPackageKit
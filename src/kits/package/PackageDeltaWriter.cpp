@@ -0,0 +1,618 @@
+/*
+ * Copyright 2011, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include <package/PackageDeltaWriter.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <new>
+
+#include <ByteOrder.h>
+
+#include <AutoDeleter.h>
+#include <SHA256.h>
+
+#include <package/hpkg/ErrorOutput.h>
+#include <package/hpkg/HPKGDefs.h>
+#include <package/hpkg/PackageContentHandler.h>
+#include <package/hpkg/PackageData.h>
+#include <package/hpkg/PackageEntry.h>
+#include <package/hpkg/PackageEntryAttribute.h>
+#include <package/hpkg/PackageReader.h>
+
+#include <package/hpkg/HPKGDefsPrivate.h>
+
+
+namespace BPackageKit {
+
+namespace BPrivate {
+
+
+using namespace BHPKG;
+using namespace BHPKG::BPrivate;
+
+
+// Maximum segment size. Larger data are split into segments of this size.
+// This is also the zlib chunk size, so compressed chunks always fit.
+static const size_t kMaxSegmentSize = B_HPKG_DEFAULT_DATA_CHUNK_SIZE_ZLIB;
+
+
+static uint64
+hash_data(const uint8* data, size_t size)
+{
+	// FNV-1a
+	uint64 hash = 0xcbf29ce484222325ULL;
+	for (size_t i = 0; i < size; i++) {
+		hash ^= data[i];
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+
+struct FDCloser {
+	FDCloser(int fd)
+		:
+		fFD(fd)
+	{
+	}
+
+	~FDCloser()
+	{
+		if (fFD >= 0)
+			close(fFD);
+	}
+
+private:
+	int	fFD;
+};
+
+
+// #pragma mark - SegmentCollector
+
+
+/*!	Collects the heap data ranges of all entries and entry attributes of a
+	package as segments, the units the delta is built from.
+*/
+struct PackageDeltaWriter::SegmentCollector : BPackageContentHandler {
+	SegmentCollector(int fd, Array<Segment>& segments)
+		:
+		fFD(fd),
+		fSegments(segments)
+	{
+	}
+
+	virtual status_t HandleEntry(BPackageEntry* entry)
+	{
+		return _AddData(entry->Data());
+	}
+
+	virtual status_t HandleEntryAttribute(BPackageEntry* entry,
+		BPackageEntryAttribute* attribute)
+	{
+		return _AddData(attribute->Data());
+	}
+
+	virtual status_t HandleEntryDone(BPackageEntry* entry)
+	{
+		return B_OK;
+	}
+
+	virtual status_t HandlePackageAttribute(
+		const BPackageInfoAttributeValue& value)
+	{
+		return B_OK;
+	}
+
+	virtual void HandleErrorOccurred()
+	{
+	}
+
+private:
+	status_t _AddData(const BPackageData& data)
+	{
+		if (data.IsEncodedInline() || data.CompressedSize() == 0)
+			return B_OK;
+
+		uint64 offset = data.Offset();
+		uint64 size = data.CompressedSize();
+
+		// Zlib compressed data consist of a chunk offset table followed by
+		// independently compressed chunks. Make each chunk a segment of its
+		// own, so that the unchanged chunks of a changed file can be reused.
+		if (data.Compression() == B_HPKG_COMPRESSION_ZLIB) {
+			uint64 chunkSize = data.ChunkSize() != 0
+				? data.ChunkSize() : B_HPKG_DEFAULT_DATA_CHUNK_SIZE_ZLIB;
+			uint64 chunkCount
+				= (data.UncompressedSize() + chunkSize - 1) / chunkSize;
+			if (chunkCount > 1)
+				return _AddChunkedData(offset, size, chunkCount);
+		}
+
+		return _AddSegment(offset, size);
+	}
+
+	status_t _AddChunkedData(uint64 offset, uint64 size, uint64 chunkCount)
+	{
+		size_t tableSize = (chunkCount - 1) * sizeof(uint64);
+		if (tableSize >= size)
+			return B_BAD_DATA;
+
+		uint64* table = new(std::nothrow) uint64[chunkCount - 1];
+		if (table == NULL)
+			return B_NO_MEMORY;
+		ArrayDeleter<uint64> tableDeleter(table);
+
+		ssize_t bytesRead = pread(fFD, table, tableSize, offset);
+		if (bytesRead < 0)
+			return errno;
+		if ((size_t)bytesRead != tableSize)
+			return B_IO_ERROR;
+
+		status_t error = _AddSegment(offset, tableSize);
+		if (error != B_OK)
+			return error;
+
+		// the table contains the offsets of all but the first chunk
+		uint64 dataOffset = offset + tableSize;
+		uint64 dataSize = size - tableSize;
+		uint64 chunkOffset = 0;
+		for (uint64 i = 0; i < chunkCount; i++) {
+			uint64 chunkEnd = i + 1 < chunkCount ? table[i] : dataSize;
+			if (chunkEnd < chunkOffset || chunkEnd > dataSize)
+				return B_BAD_DATA;
+
+			error = _AddSegment(dataOffset + chunkOffset,
+				chunkEnd - chunkOffset);
+			if (error != B_OK)
+				return error;
+
+			chunkOffset = chunkEnd;
+		}
+
+		return B_OK;
+	}
+
+	status_t _AddSegment(uint64 offset, uint64 size)
+	{
+		while (size > 0) {
+			Segment segment;
+			segment.offset = offset;
+			segment.size = std::min(size, (uint64)kMaxSegmentSize);
+			segment.hash = 0;
+			if (!fSegments.Add(segment))
+				return B_NO_MEMORY;
+
+			offset += segment.size;
+			size -= segment.size;
+		}
+
+		return B_OK;
+	}
+
+private:
+	int				fFD;
+	Array<Segment>&	fSegments;
+};
+
+
+// #pragma mark - SegmentHashLess
+
+
+struct PackageDeltaWriter::SegmentHashLess {
+	bool operator()(const Segment& a, const Segment& b) const
+	{
+		if (a.hash != b.hash)
+			return a.hash < b.hash;
+		return a.size < b.size;
+	}
+};
+
+
+// #pragma mark - SegmentOffsetLess
+
+
+struct PackageDeltaWriter::SegmentOffsetLess {
+	bool operator()(const Segment& a, const Segment& b) const
+	{
+		return a.offset < b.offset;
+	}
+};
+
+
+// #pragma mark - PackageDeltaWriter
+
+
+PackageDeltaWriter::PackageDeltaWriter(BErrorOutput* errorOutput)
+	:
+	fErrorOutput(errorOutput),
+	fBuffer(NULL),
+	fCompareBuffer(NULL),
+	fCopiedSize(0),
+	fDataSize(0)
+{
+}
+
+
+PackageDeltaWriter::~PackageDeltaWriter()
+{
+	free(fBuffer);
+	free(fCompareBuffer);
+}
+
+
+/*!	Writes a delta file which allows to reconstruct the package
+	\a newPackageFileName from \a oldPackageFileName.
+
+	The heap data of both packages are split into segments -- the chunks of
+	zlib compressed data, or pieces of at most 64 KB of uncompressed data.
+	Segments of the new package that also exist in the old one are referred to
+	by copy commands, everything else is stored in the delta file.
+*/
+status_t
+PackageDeltaWriter::Write(const char* oldPackageFileName,
+	const char* newPackageFileName, const char* deltaFileName)
+{
+	fOldSegments.MakeEmpty();
+	fNewSegments.MakeEmpty();
+	fCommands.MakeEmpty();
+	fCopiedSize = 0;
+	fDataSize = 0;
+
+	if (fBuffer == NULL) {
+		fBuffer = (uint8*)malloc(kMaxSegmentSize);
+		fCompareBuffer = (uint8*)malloc(kMaxSegmentSize);
+		if (fBuffer == NULL || fCompareBuffer == NULL) {
+			fErrorOutput->PrintError("Error: Out of memory!\n");
+			return B_NO_MEMORY;
+		}
+	}
+
+	// open the packages
+	int oldFD = open(oldPackageFileName, O_RDONLY);
+	if (oldFD < 0) {
+		fErrorOutput->PrintError("Error: Failed to open package file \"%s\": "
+			"%s\n", oldPackageFileName, strerror(errno));
+		return errno;
+	}
+	FDCloser oldFDCloser(oldFD);
+
+	int newFD = open(newPackageFileName, O_RDONLY);
+	if (newFD < 0) {
+		fErrorOutput->PrintError("Error: Failed to open package file \"%s\": "
+			"%s\n", newPackageFileName, strerror(errno));
+		return errno;
+	}
+	FDCloser newFDCloser(newFD);
+
+	struct stat oldStat;
+	struct stat newStat;
+	if (fstat(oldFD, &oldStat) < 0 || fstat(newFD, &newStat) < 0) {
+		fErrorOutput->PrintError("Error: Failed to stat package file: %s\n",
+			strerror(errno));
+		return errno;
+	}
+
+	// collect the segments
+	status_t error = _CollectSegments(oldPackageFileName, oldFD, fOldSegments);
+	if (error == B_OK)
+		error = _CollectSegments(newPackageFileName, newFD, fNewSegments);
+	if (error == B_OK)
+		error = _HashSegments(oldFD, fOldSegments);
+	if (error != B_OK)
+		return error;
+
+	std::sort(fOldSegments.Elements(),
+		fOldSegments.Elements() + fOldSegments.Count(), SegmentHashLess());
+	std::sort(fNewSegments.Elements(),
+		fNewSegments.Elements() + fNewSegments.Count(), SegmentOffsetLess());
+
+	// create the commands
+	error = _CreateCommands(oldFD, newFD, newStat.st_size);
+	if (error != B_OK)
+		return error;
+
+	// write the delta file
+	int deltaFD = open(deltaFileName, O_WRONLY | O_CREAT | O_TRUNC,
+		S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+	if (deltaFD < 0) {
+		fErrorOutput->PrintError("Error: Failed to create delta file \"%s\": "
+			"%s\n", deltaFileName, strerror(errno));
+		return errno;
+	}
+	FDCloser deltaFDCloser(deltaFD);
+
+	return _WriteDelta(oldFD, newFD, oldStat.st_size, newStat.st_size,
+		deltaFD);
+}
+
+
+status_t
+PackageDeltaWriter::_CollectSegments(const char* fileName, int fd,
+	Array<Segment>& segments)
+{
+	BPackageReader packageReader(fErrorOutput);
+	status_t error = packageReader.Init(fd, false);
+	if (error != B_OK)
+		return error;
+
+	SegmentCollector collector(fd, segments);
+	error = packageReader.ParseContent(&collector);
+	if (error != B_OK) {
+		fErrorOutput->PrintError("Error: Failed to collect data of package "
+			"\"%s\": %s\n", fileName, strerror(error));
+	}
+
+	return error;
+}
+
+
+status_t
+PackageDeltaWriter::_HashSegments(int fd, Array<Segment>& segments)
+{
+	for (int32 i = 0; i < segments.Count(); i++) {
+		Segment& segment = segments[i];
+		status_t error = _Read(fd, segment.offset, fBuffer, segment.size);
+		if (error != B_OK)
+			return error;
+
+		segment.hash = hash_data(fBuffer, segment.size);
+	}
+
+	return B_OK;
+}
+
+
+status_t
+PackageDeltaWriter::_CreateCommands(int oldFD, int newFD, off_t newSize)
+{
+	uint64 position = 0;
+	for (int32 i = 0; i < fNewSegments.Count(); i++) {
+		Segment& segment = fNewSegments[i];
+		if (segment.offset < position)
+			continue;
+		if (segment.offset + segment.size > (uint64)newSize)
+			return B_BAD_DATA;
+
+		// anything before the segment (header, gaps) is stored as is
+		status_t error;
+		if (segment.offset > position) {
+			error = _AddCommand(B_HPKG_DELTA_COMMAND_DATA, position,
+				segment.offset - position);
+			if (error != B_OK)
+				return error;
+		}
+
+		error = _Read(newFD, segment.offset, fBuffer, segment.size);
+		if (error != B_OK)
+			return error;
+		segment.hash = hash_data(fBuffer, segment.size);
+
+		const Segment* match = _FindMatchingSegment(oldFD, segment, fBuffer);
+		if (match != NULL) {
+			error = _AddCommand(B_HPKG_DELTA_COMMAND_COPY, match->offset,
+				segment.size);
+		} else {
+			error = _AddCommand(B_HPKG_DELTA_COMMAND_DATA, segment.offset,
+				segment.size);
+		}
+		if (error != B_OK)
+			return error;
+
+		position = segment.offset + segment.size;
+	}
+
+	// the rest -- TOC and package attributes
+	if (position < (uint64)newSize) {
+		return _AddCommand(B_HPKG_DELTA_COMMAND_DATA, position,
+			newSize - position);
+	}
+
+	return B_OK;
+}
+
+
+const PackageDeltaWriter::Segment*
+PackageDeltaWriter::_FindMatchingSegment(int oldFD, const Segment& segment,
+	const uint8* data)
+{
+	const Segment* begin = fOldSegments.Elements();
+	const Segment* end = begin + fOldSegments.Count();
+	const Segment* candidate = std::lower_bound(begin, end, segment,
+		SegmentHashLess());
+
+	for (; candidate != end && candidate->hash == segment.hash
+			&& candidate->size == segment.size; candidate++) {
+		// compare the actual data, the hash might collide
+		if (_Read(oldFD, candidate->offset, fCompareBuffer, candidate->size)
+				== B_OK
+			&& memcmp(fCompareBuffer, data, segment.size) == 0) {
+			return candidate;
+		}
+	}
+
+	return NULL;
+}
+
+
+status_t
+PackageDeltaWriter::_AddCommand(uint32 type, uint64 offset, uint64 size)
+{
+	if (type == B_HPKG_DELTA_COMMAND_COPY)
+		fCopiedSize += size;
+	else
+		fDataSize += size;
+
+	// join with the previous command, if contiguous
+	int32 count = fCommands.Count();
+	if (count > 0) {
+		Command& previous = fCommands[count - 1];
+		if (previous.type == type && previous.offset + previous.size == offset) {
+			previous.size += size;
+			return B_OK;
+		}
+	}
+
+	Command command;
+	command.type = type;
+	command.offset = offset;
+	command.size = size;
+	return fCommands.Add(command) ? B_OK : B_NO_MEMORY;
+}
+
+
+status_t
+PackageDeltaWriter::_WriteDelta(int oldFD, int newFD, off_t oldSize,
+	off_t newSize, int deltaFD)
+{
+	int32 commandCount = fCommands.Count();
+	hpkg_delta_command* commands
+		= new(std::nothrow) hpkg_delta_command[commandCount];
+	if (commands == NULL) {
+		fErrorOutput->PrintError("Error: Out of memory!\n");
+		return B_NO_MEMORY;
+	}
+	ArrayDeleter<hpkg_delta_command> commandsDeleter(commands);
+
+	// prepare the commands -- the data follow the command table
+	uint64 dataOffset = sizeof(hpkg_delta_header)
+		+ (uint64)commandCount * sizeof(hpkg_delta_command);
+	uint64 offset = dataOffset;
+	for (int32 i = 0; i < commandCount; i++) {
+		const Command& command = fCommands[i];
+		commands[i].type = B_HOST_TO_BENDIAN_INT32(command.type);
+		commands[i].reserved = 0;
+		commands[i].size = B_HOST_TO_BENDIAN_INT64(command.size);
+		if (command.type == B_HPKG_DELTA_COMMAND_DATA) {
+			commands[i].offset = B_HOST_TO_BENDIAN_INT64(offset);
+			offset += command.size;
+		} else
+			commands[i].offset = B_HOST_TO_BENDIAN_INT64(command.offset);
+	}
+
+	// prepare the header
+	hpkg_delta_header header;
+	memset(&header, 0, sizeof(header));
+	header.magic = B_HOST_TO_BENDIAN_INT32(B_HPKG_DELTA_MAGIC);
+	header.header_size = B_HOST_TO_BENDIAN_INT16(sizeof(hpkg_delta_header));
+	header.version = B_HOST_TO_BENDIAN_INT16(B_HPKG_DELTA_VERSION);
+	header.total_size = B_HOST_TO_BENDIAN_INT64(offset);
+	header.old_package_size = B_HOST_TO_BENDIAN_INT64(oldSize);
+	header.new_package_size = B_HOST_TO_BENDIAN_INT64(newSize);
+	header.command_count = B_HOST_TO_BENDIAN_INT32(commandCount);
+
+	status_t error = _ComputeChecksum(oldFD, oldSize,
+		header.old_package_checksum);
+	if (error == B_OK) {
+		error = _ComputeChecksum(newFD, newSize,
+			header.new_package_checksum);
+	}
+	if (error != B_OK)
+		return error;
+
+	// write header and commands
+	error = _Write(deltaFD, 0, &header, sizeof(header));
+	if (error == B_OK) {
+		error = _Write(deltaFD, sizeof(header), commands,
+			commandCount * sizeof(hpkg_delta_command));
+	}
+	if (error != B_OK)
+		return error;
+
+	// write the data
+	offset = dataOffset;
+	for (int32 i = 0; i < commandCount; i++) {
+		const Command& command = fCommands[i];
+		if (command.type != B_HPKG_DELTA_COMMAND_DATA)
+			continue;
+
+		uint64 remaining = command.size;
+		uint64 readOffset = command.offset;
+		while (remaining > 0) {
+			size_t toCopy = std::min(remaining, (uint64)kMaxSegmentSize);
+			error = _Read(newFD, readOffset, fBuffer, toCopy);
+			if (error == B_OK)
+				error = _Write(deltaFD, offset, fBuffer, toCopy);
+			if (error != B_OK)
+				return error;
+
+			readOffset += toCopy;
+			offset += toCopy;
+			remaining -= toCopy;
+		}
+	}
+
+	return B_OK;
+}
+
+
+status_t
+PackageDeltaWriter::_ComputeChecksum(int fd, off_t size, uint8* checksum)
+{
+	SHA256 sha;
+
+	off_t offset = 0;
+	while (offset < size) {
+		size_t toRead = std::min(size - offset, (off_t)kMaxSegmentSize);
+		status_t error = _Read(fd, offset, fBuffer, toRead);
+		if (error != B_OK)
+			return error;
+
+		sha.Update(fBuffer, toRead);
+		offset += toRead;
+	}
+
+	memcpy(checksum, sha.Digest(), sha.DigestLength());
+	return B_OK;
+}
+
+
+status_t
+PackageDeltaWriter::_Read(int fd, off_t offset, void* buffer, size_t size)
+{
+	ssize_t bytesRead = pread(fd, buffer, size, offset);
+	if (bytesRead < 0) {
+		fErrorOutput->PrintError("Error: Failed to read data: %s\n",
+			strerror(errno));
+		return errno;
+	}
+	if ((size_t)bytesRead != size) {
+		fErrorOutput->PrintError("Error: Failed to read all data\n");
+		return B_IO_ERROR;
+	}
+
+	return B_OK;
+}
+
+
+status_t
+PackageDeltaWriter::_Write(int fd, off_t offset, const void* buffer,
+	size_t size)
+{
+	ssize_t bytesWritten = pwrite(fd, buffer, size, offset);
+	if (bytesWritten < 0) {
+		fErrorOutput->PrintError("Error: Failed to write data: %s\n",
+			strerror(errno));
+		return errno;
+	}
+	if ((size_t)bytesWritten != size) {
+		fErrorOutput->PrintError("Error: Failed to write all data\n");
+		return B_IO_ERROR;
+	}
+
+	return B_OK;
+}
+
+
+}	// namespace BPrivate
+
+}	// namespace BPackageKit
@@ -21,6 +21,7 @@
 #include <package/hpkg/ErrorOutput.h>
 #include <package/hpkg/PackageInfoAttributeValue.h>
 #include <package/hpkg/RepositoryContentHandler.h>
+#include <package/hpkg/RepositoryIndex.h>
 #include <package/hpkg/RepositoryReader.h>
 #include <package/PackageInfo.h>
 #include <package/RepositoryInfo.h>
@@ -165,7 +166,8 @@ struct BRepositoryCache::RepositoryContentHandler : BRepositoryContentHandler {
 
 	virtual status_t HandleRepositoryInfo(const BRepositoryInfo& repositoryInfo)
 	{
-		*fRepositoryInfo = repositoryInfo;
+		if (fRepositoryInfo != NULL)
+			*fRepositoryInfo = repositoryInfo;
 
 		return B_OK;
 	}
@@ -192,19 +194,38 @@ class BRepositoryCache::StandardErrorOutput : public BErrorOutput {
 };
 
 
+/*!	Adds \a name to \a names, unless it is among the names from index
+	\a firstName on already -- a package may provide or require a resolvable
+	more than once, e.g. with different versions.
+*/
+static bool
+add_package_name(BStringList& names, int32 firstName, const BString& name)
+{
+	for (int32 i = firstName; i < names.CountStrings(); i++) {
+		if (names.StringAt(i) == name)
+			return true;
+	}
+
+	return names.Add(name);
+}
+
+
 // #pragma mark - BRepositoryCache
 
 
 BRepositoryCache::BRepositoryCache()
 	:
 	fIsUserSpecific(false),
-	fPackages()
+	fIndex(NULL),
+	fPackages(),
+	fPackagesLoaded(false)
 {
 }
 
 
 BRepositoryCache::~BRepositoryCache()
 {
+	delete fIndex;
 }
 
 
@@ -241,7 +262,10 @@ BRepositoryCache::SetTo(const BEntry& entry)
 {
 	// unset
 	fPackages.MakeEmpty();
+	fPackagesLoaded = false;
 	fEntry.Unset();
+	delete fIndex;
+	fIndex = NULL;
 
 	// init package info set
 	status_t result = fPackages.Init();
@@ -255,16 +279,31 @@ BRepositoryCache::SetTo(const BEntry& entry)
 	if ((result = entry.GetPath(&repositoryCachePath)) != B_OK)
 		return result;
 
-	// read repository cache
+	// read the repository info
 	StandardErrorOutput errorOutput;
 	BRepositoryReader repositoryReader(&errorOutput);
 	if ((result = repositoryReader.Init(repositoryCachePath.Path())) != B_OK)
 		return result;
 
-	RepositoryContentHandler handler(&fInfo, fPackages);
-	if ((result = repositoryReader.ParseContent(&handler)) != B_OK)
+	if ((result = repositoryReader.GetRepositoryInfo(&fInfo)) != B_OK)
 		return result;
 
+	// Use the index, if the cache has one. The packages will only be read,
+	// when they are iterated through.
+	fIndex = new(std::nothrow) RepositoryIndex;
+	if (fIndex == NULL)
+		return B_NO_MEMORY;
+
+	if (fIndex->Init(repositoryCachePath.Path()) != B_OK) {
+		delete fIndex;
+		fIndex = NULL;
+
+		RepositoryContentHandler handler(NULL, fPackages);
+		if ((result = repositoryReader.ParseContent(&handler)) != B_OK)
+			return result;
+		fPackagesLoaded = true;
+	}
+
 	BPath userSettingsPath;
 	if (find_directory(B_USER_SETTINGS_DIRECTORY, &userSettingsPath) == B_OK) {
 		BDirectory userSettingsDir(userSettingsPath.Path());
@@ -279,15 +318,160 @@ BRepositoryCache::SetTo(const BEntry& entry)
 uint32
 BRepositoryCache::CountPackages() const
 {
+	if (fIndex != NULL)
+		return fIndex->CountPackages();
+
 	return fPackages.CountInfos();
 }
 
 
+/*!	Returns an iterator over the packages, which is empty, if the packages
+	couldn't be loaded. Use the other version to learn about the error.
+*/
 BRepositoryCache::Iterator
 BRepositoryCache::GetIterator() const
 {
+	_LoadPackages();
 	return fPackages.GetIterator();
 }
 
 
+status_t
+BRepositoryCache::GetIterator(Iterator& _iterator) const
+{
+	status_t result = _LoadPackages();
+	if (result != B_OK)
+		return result;
+
+	_iterator = fPackages.GetIterator();
+	return B_OK;
+}
+
+
+bool
+BRepositoryCache::HasIndex() const
+{
+	return fIndex != NULL;
+}
+
+
+status_t
+BRepositoryCache::GetPackagesProviding(const BString& resolvableName,
+	BStringList& _packageNames) const
+{
+	if (fIndex != NULL) {
+		uint32 count;
+		uint32 index = fIndex->FindProvides(resolvableName, count);
+		int32 firstName = _packageNames.CountStrings();
+		for (uint32 i = index; i < index + count; i++) {
+			BPackageResolvable resolvable;
+			uint32 packageIndex;
+			status_t result = fIndex->GetProvidesAt(i, resolvable,
+				packageIndex);
+			if (result != B_OK)
+				return result;
+
+			if (!add_package_name(_packageNames, firstName,
+					fIndex->PackageNameAt(packageIndex))) {
+				return B_NO_MEMORY;
+			}
+		}
+		return B_OK;
+	}
+
+	Iterator it;
+	status_t result = GetIterator(it);
+	if (result != B_OK)
+		return result;
+
+	while (it.HasNext()) {
+		const BPackageInfo* info = it.Next();
+		const BObjectList<BPackageResolvable>& providesList
+			= info->ProvidesList();
+		for (int32 i = 0; i < providesList.CountItems(); i++) {
+			if (providesList.ItemAt(i)->Name() == resolvableName) {
+				if (!_packageNames.Add(info->Name()))
+					return B_NO_MEMORY;
+				break;
+			}
+		}
+	}
+
+	return B_OK;
+}
+
+
+status_t
+BRepositoryCache::GetPackagesRequiring(const BString& resolvableName,
+	BStringList& _packageNames) const
+{
+	if (fIndex != NULL) {
+		uint32 count;
+		uint32 index = fIndex->FindRequires(resolvableName, count);
+		int32 firstName = _packageNames.CountStrings();
+		for (uint32 i = index; i < index + count; i++) {
+			BPackageResolvableExpression expression;
+			uint32 packageIndex;
+			status_t result = fIndex->GetRequiresAt(i, expression,
+				packageIndex);
+			if (result != B_OK)
+				return result;
+
+			if (!add_package_name(_packageNames, firstName,
+					fIndex->PackageNameAt(packageIndex))) {
+				return B_NO_MEMORY;
+			}
+		}
+		return B_OK;
+	}
+
+	Iterator it;
+	status_t result = GetIterator(it);
+	if (result != B_OK)
+		return result;
+
+	while (it.HasNext()) {
+		const BPackageInfo* info = it.Next();
+		const BObjectList<BPackageResolvableExpression>& requiresList
+			= info->RequiresList();
+		for (int32 i = 0; i < requiresList.CountItems(); i++) {
+			if (requiresList.ItemAt(i)->Name() == resolvableName) {
+				if (!_packageNames.Add(info->Name()))
+					return B_NO_MEMORY;
+				break;
+			}
+		}
+	}
+
+	return B_OK;
+}
+
+
+status_t
+BRepositoryCache::_LoadPackages() const
+{
+	if (fPackagesLoaded)
+		return B_OK;
+
+	BPath repositoryCachePath;
+	status_t result = fEntry.GetPath(&repositoryCachePath);
+	if (result != B_OK)
+		return result;
+
+	StandardErrorOutput errorOutput;
+	BRepositoryReader repositoryReader(&errorOutput);
+	if ((result = repositoryReader.Init(repositoryCachePath.Path())) != B_OK)
+		return result;
+
+	RepositoryContentHandler handler(NULL, fPackages);
+	if ((result = repositoryReader.ParseContent(&handler)) != B_OK) {
+		fPackages.MakeEmpty();
+		return result;
+	}
+
+	fPackagesLoaded = true;
+	return B_OK;
+}
+
+
 }	// namespace BPackageKit
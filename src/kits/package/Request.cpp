@@ -29,6 +29,7 @@ BRequest::BRequest(const BContext& context)
 
 BRequest::~BRequest()
 {
+	delete fJobQueue;
 }
 
 
@@ -49,6 +50,16 @@ BRequest::PopRunnableJob()
 }
 
 
+status_t
+BRequest::Process(int32 maxParallelJobs)
+{
+	if (fJobQueue == NULL)
+		return B_NO_INIT;
+
+	return fJobQueue->RunJobs(maxParallelJobs);
+}
+
+
 status_t
 BRequest::QueueJob(BJob* job)
 {
@@ -70,6 +70,17 @@ BPackageReader::ParseContent(BLowLevelPackageContentHandler* contentHandler)
 }
 
 
+status_t
+BPackageReader::ParseContent(BPackageContentHandler* contentHandler,
+	const char* subPath)
+{
+	if (fImpl == NULL)
+		return B_NO_INIT;
+
+	return fImpl->ParseContent(contentHandler, subPath);
+}
+
+
 int
 BPackageReader::PackageFileFD()
 {
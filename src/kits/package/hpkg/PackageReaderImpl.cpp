@@ -47,6 +47,54 @@ static const size_t kMaxTOCSize					= 64 * 1024 * 1024;
 // maximum package attributes size we support reading
 static const size_t kMaxPackageAttributesSize	= 1 * 1024 * 1024;
 
+// size of the buffer used for reading compressed TOC ranges
+static const size_t kTOCRangeReadBufferSize		= 16 * 1024;
+
+
+// #pragma mark - TOCRangeDataOutput
+
+
+/*!	Writes only a given range of the data written to it into a buffer. The
+	data before the range are skipped, the data after it are dropped.
+*/
+class TOCRangeDataOutput : public BDataOutput {
+public:
+	TOCRangeDataOutput(void* buffer, uint64 skip, size_t size)
+		:
+		fBuffer((uint8*)buffer),
+		fSkip(skip),
+		fSize(size),
+		fBytesWritten(0)
+	{
+	}
+
+	size_t BytesWritten() const
+	{
+		return fBytesWritten;
+	}
+
+	virtual status_t WriteData(const void* buffer, size_t size)
+	{
+		if (fSkip > 0) {
+			size_t toSkip = std::min((uint64)size, fSkip);
+			buffer = (const uint8*)buffer + toSkip;
+			size -= toSkip;
+			fSkip -= toSkip;
+		}
+
+		size_t toCopy = std::min(size, fSize - fBytesWritten);
+		memcpy(fBuffer + fBytesWritten, buffer, toCopy);
+		fBytesWritten += toCopy;
+		return B_OK;
+	}
+
+private:
+	uint8*	fBuffer;
+	uint64	fSkip;
+	size_t	fSize;
+	size_t	fBytesWritten;
+};
+
 
 // #pragma mark - DataAttributeHandler
 
@@ -357,12 +405,18 @@ private:
 struct PackageReaderImpl::RootAttributeHandler : PackageAttributeHandler {
 	typedef PackageAttributeHandler inherited;
 
+	RootAttributeHandler(BPackageEntry* parentEntry = NULL)
+		:
+		fParentEntry(parentEntry)
+	{
+	}
+
 	virtual status_t HandleAttribute(AttributeHandlerContext* context,
 		uint8 id, const AttributeValue& value, AttributeHandler** _handler)
 	{
 		if (id == B_HPKG_ATTRIBUTE_ID_DIRECTORY_ENTRY) {
 			if (_handler != NULL) {
-				return EntryAttributeHandler::Create(context, NULL,
+				return EntryAttributeHandler::Create(context, fParentEntry,
 					value.string, *_handler);
 			}
 			return B_OK;
@@ -370,6 +424,9 @@ struct PackageReaderImpl::RootAttributeHandler : PackageAttributeHandler {
 
 		return inherited::HandleAttribute(context, id, value, _handler);
 	}
+
+private:
+	BPackageEntry*	fParentEntry;
 };
 
 
@@ -379,13 +436,24 @@ struct PackageReaderImpl::RootAttributeHandler : PackageAttributeHandler {
 PackageReaderImpl::PackageReaderImpl(BErrorOutput* errorOutput)
 	:
 	inherited(errorOutput),
-	fTOCSection("TOC")
+	fTOCSection("TOC"),
+	fTOCRead(false),
+	fTOCIndexOffset(0),
+	fTOCIndexBlocks(NULL),
+	fTOCIndexBlockCount(0),
+	fTOCIndexDirectories(NULL),
+	fTOCIndexDirectoryCount(0),
+	fTOCIndexPaths(NULL),
+	fTOCIndexPathsLength(0)
 {
 }
 
 
 PackageReaderImpl::~PackageReaderImpl()
 {
+	delete[] fTOCIndexBlocks;
+	delete[] fTOCIndexDirectories;
+	delete[] fTOCIndexPaths;
 }
 
 
@@ -538,14 +606,8 @@ PackageReaderImpl::Init(int fd, bool keepFD)
 		return B_UNSUPPORTED;
 	}
 
-	// read in the complete TOC
-	fTOCSection.data
-		= new(std::nothrow) uint8[fTOCSection.uncompressedLength];
-	if (fTOCSection.data == NULL) {
-		ErrorOutput()->PrintError("Error: Out of memory!\n");
-		return B_NO_MEMORY;
-	}
-	error = ReadCompressedBuffer(fTOCSection);
+	// read the TOC index, if any -- the complete TOC is only read when needed
+	error = _ReadTOCIndex();
 	if (error != B_OK)
 		return error;
 
@@ -560,15 +622,6 @@ PackageReaderImpl::Init(int fd, bool keepFD)
 	if (error != B_OK)
 		return error;
 
-	// start parsing the TOC
-	fTOCSection.currentOffset = 0;
-	SetCurrentSection(&fTOCSection);
-
-	// strings
-	error = ParseStrings();
-	if (error != B_OK)
-		return error;
-
 	// parse strings from package attributes section
 	fPackageAttributesSection.currentOffset = 0;
 	SetCurrentSection(&fPackageAttributesSection);
@@ -594,9 +647,12 @@ PackageReaderImpl::ParseContent(BPackageContentHandler* contentHandler)
 	status_t error
 		= ParsePackageAttributesSection(&context, &rootAttributeHandler);
 
+	if (error == B_OK)
+		error = _ReadTOC();
+
 	if (error == B_OK) {
 		context.section = B_HPKG_SECTION_PACKAGE_TOC;
-		error = _ParseTOC(&context, &rootAttributeHandler);
+		error = _ParseTOC(&context, &rootAttributeHandler, fTOCSection);
 	}
 
 	return error;
@@ -613,22 +669,425 @@ PackageReaderImpl::ParseContent(BLowLevelPackageContentHandler* contentHandler)
 	status_t error
 		= ParsePackageAttributesSection(&context, &rootAttributeHandler);
 
+	if (error == B_OK)
+		error = _ReadTOC();
+
 	if (error == B_OK) {
 		context.section = B_HPKG_SECTION_PACKAGE_TOC;
-		error = _ParseTOC(&context, &rootAttributeHandler);
+		error = _ParseTOC(&context, &rootAttributeHandler, fTOCSection);
 	}
 
 	return error;
 }
 
 
+/*!	Parses the package attributes and the TOC entries in the directory
+	\a subPath. If the package has a TOC index, only the part of the TOC
+	containing the deepest directory on \a subPath is read and parsed. The
+	directory's ancestors are reported to the handler with default attributes.
+	Without an index (or if \a subPath cannot be found in it) the complete
+	TOC is parsed, so the handler has to be prepared for entries outside of
+	\a subPath either way.
+*/
+status_t
+PackageReaderImpl::ParseContent(BPackageContentHandler* contentHandler,
+	const char* subPath)
+{
+	if (fTOCIndexOffset == 0 || subPath == NULL)
+		return ParseContent(contentHandler);
+
+	// find the deepest indexed directory on the path
+	while (*subPath == '/')
+		subPath++;
+	size_t length = strlen(subPath);
+
+	const hpkg_toc_index_directory* directory = NULL;
+	while (length > 0) {
+		while (length > 0 && subPath[length - 1] == '/')
+			length--;
+		if (length == 0)
+			break;
+
+		directory = _FindTOCIndexDirectory(subPath, length);
+		if (directory != NULL)
+			break;
+
+		while (length > 0 && subPath[length - 1] != '/')
+			length--;
+	}
+
+	if (directory == NULL)
+		return ParseContent(contentHandler);
+
+	// parse the package attributes
+	AttributeHandlerContext context(ErrorOutput(), contentHandler,
+		B_HPKG_SECTION_PACKAGE_ATTRIBUTES);
+	RootAttributeHandler rootAttributeHandler;
+
+	status_t error
+		= ParsePackageAttributesSection(&context, &rootAttributeHandler);
+	if (error != B_OK)
+		return error;
+
+	// Read the TOC strings and the directory's subtree into a section of
+	// their own. A final 0 terminates the (only) top level entry.
+	uint64 subtreeSize = directory->toc_end_offset - directory->toc_offset;
+
+	SectionInfo section("TOC");
+	section.compression = fTOCSection.compression;
+	section.uncompressedLength = fTOCSection.stringsLength + subtreeSize + 1;
+	section.stringsLength = fTOCSection.stringsLength;
+	section.stringsCount = fTOCSection.stringsCount;
+	section.data = new(std::nothrow) uint8[section.uncompressedLength];
+	if (section.data == NULL) {
+		ErrorOutput()->PrintError("Error: Out of memory!\n");
+		return B_NO_MEMORY;
+	}
+
+	error = _ReadTOCRange(0, section.stringsLength, section.data);
+	if (error == B_OK) {
+		error = _ReadTOCRange(directory->toc_offset, subtreeSize,
+			section.data + section.stringsLength);
+	}
+	if (error != B_OK)
+		return error;
+	section.data[section.uncompressedLength - 1] = 0;
+
+	section.currentOffset = 0;
+	SetCurrentSection(&section);
+	error = ParseStrings();
+	SetCurrentSection(NULL);
+	if (error != B_OK)
+		return error;
+
+	// get the path of the directory's parent
+	const char* path = fTOCIndexPaths + directory->path_offset;
+	const char* lastSlash = strrchr(path, '/');
+	char* ancestorPath = NULL;
+	if (lastSlash != NULL) {
+		size_t ancestorPathLength = lastSlash - path;
+		ancestorPath = (char*)malloc(ancestorPathLength + 1);
+		if (ancestorPath == NULL) {
+			ErrorOutput()->PrintError("Error: Out of memory!\n");
+			return B_NO_MEMORY;
+		}
+		memcpy(ancestorPath, path, ancestorPathLength);
+		ancestorPath[ancestorPathLength] = '\0';
+	}
+
+	context.section = B_HPKG_SECTION_PACKAGE_TOC;
+	error = _ParseTOCSubtree(&context, section, ancestorPath, NULL);
+
+	free(ancestorPath);
+	return error;
+}
+
+
+status_t
+PackageReaderImpl::_ReadTOC()
+{
+	if (fTOCRead)
+		return B_OK;
+
+	// read in the complete TOC -- the buffers of a previous failed attempt
+	// are reused or freed
+	if (fTOCSection.data == NULL) {
+		fTOCSection.data
+			= new(std::nothrow) uint8[fTOCSection.uncompressedLength];
+		if (fTOCSection.data == NULL) {
+			ErrorOutput()->PrintError("Error: Out of memory!\n");
+			return B_NO_MEMORY;
+		}
+	}
+	status_t error = ReadCompressedBuffer(fTOCSection);
+	if (error != B_OK)
+		return error;
+
+	// strings
+	delete[] fTOCSection.strings;
+	fTOCSection.strings = NULL;
+	fTOCSection.currentOffset = 0;
+	SetCurrentSection(&fTOCSection);
+	error = ParseStrings();
+	SetCurrentSection(NULL);
+	if (error != B_OK)
+		return error;
+
+	fTOCRead = true;
+	return B_OK;
+}
+
+
+status_t
+PackageReaderImpl::_ReadTOCIndex()
+{
+	if (fHeapOffset < sizeof(hpkg_header) + sizeof(hpkg_toc_index_header))
+		return B_OK;
+
+	hpkg_toc_index_header header;
+	status_t error = ReadBuffer(sizeof(hpkg_header), &header, sizeof(header));
+	if (error != B_OK)
+		return error;
+
+	// Ignore the header, if it doesn't describe an index we understand. The
+	// section is part of the heap as far as the rest of the reader is
+	// concerned.
+	if (B_BENDIAN_TO_HOST_INT32(header.magic) != B_HPKG_TOC_INDEX_MAGIC
+		|| B_BENDIAN_TO_HOST_INT16(header.version)
+			!= B_HPKG_TOC_INDEX_VERSION) {
+		return B_OK;
+	}
+
+	uint64 offset = B_BENDIAN_TO_HOST_INT64(header.offset);
+	uint32 blockCount = B_BENDIAN_TO_HOST_INT32(header.block_count);
+	uint32 directoryCount = B_BENDIAN_TO_HOST_INT32(header.directory_count);
+	uint32 pathsLength = B_BENDIAN_TO_HOST_INT32(header.paths_length);
+
+	uint64 blocksSize = (uint64)blockCount * sizeof(hpkg_toc_index_block);
+	uint64 directoriesSize
+		= (uint64)directoryCount * sizeof(hpkg_toc_index_directory);
+	if (offset < fHeapOffset || offset > fTOCSection.offset
+		|| blocksSize + directoriesSize + pathsLength
+			!= fTOCSection.offset - offset
+		|| (fTOCSection.compression != B_HPKG_COMPRESSION_NONE
+			&& blockCount == 0)
+		|| (pathsLength == 0) != (directoryCount == 0)) {
+		ErrorOutput()->PrintError("Error: Invalid package file: Invalid TOC "
+			"index section\n");
+		return B_BAD_DATA;
+	}
+
+	if (blocksSize + directoriesSize + pathsLength > kMaxTOCSize) {
+		ErrorOutput()->PrintError("Error: Package file TOC index section size "
+			"is %llu bytes. This is beyond the reader's sanity limit\n",
+			blocksSize + directoriesSize + pathsLength);
+		return B_UNSUPPORTED;
+	}
+
+	// read the section
+	fTOCIndexBlocks = new(std::nothrow) hpkg_toc_index_block[blockCount];
+	fTOCIndexDirectories
+		= new(std::nothrow) hpkg_toc_index_directory[directoryCount];
+	fTOCIndexPaths = new(std::nothrow) char[pathsLength];
+	if (fTOCIndexBlocks == NULL || fTOCIndexDirectories == NULL
+		|| fTOCIndexPaths == NULL) {
+		ErrorOutput()->PrintError("Error: Out of memory!\n");
+		return B_NO_MEMORY;
+	}
+
+	if ((error = ReadBuffer(offset, fTOCIndexBlocks, blocksSize)) != B_OK
+		|| (error = ReadBuffer(offset + blocksSize, fTOCIndexDirectories,
+			directoriesSize)) != B_OK
+		|| (error = ReadBuffer(offset + blocksSize + directoriesSize,
+			fTOCIndexPaths, pathsLength)) != B_OK) {
+		return error;
+	}
+
+	fTOCIndexBlockCount = blockCount;
+	fTOCIndexDirectoryCount = directoryCount;
+	fTOCIndexPathsLength = pathsLength;
+
+	// swap and check the blocks and directories
+	for (uint32 i = 0; i < blockCount; i++) {
+		hpkg_toc_index_block& block = fTOCIndexBlocks[i];
+		block.uncompressed_offset
+			= B_BENDIAN_TO_HOST_INT64(block.uncompressed_offset);
+		block.compressed_offset
+			= B_BENDIAN_TO_HOST_INT64(block.compressed_offset);
+
+		if ((i == 0 && block.uncompressed_offset != 0)
+			|| (i > 0 && (block.uncompressed_offset
+					<= fTOCIndexBlocks[i - 1].uncompressed_offset
+				|| block.compressed_offset
+					<= fTOCIndexBlocks[i - 1].compressed_offset))
+			|| block.uncompressed_offset > fTOCSection.uncompressedLength
+			|| block.compressed_offset > fTOCSection.compressedLength) {
+			ErrorOutput()->PrintError("Error: Invalid package file: Invalid "
+				"TOC index block\n");
+			return B_BAD_DATA;
+		}
+	}
+
+	if (pathsLength > 0 && fTOCIndexPaths[pathsLength - 1] != '\0') {
+		ErrorOutput()->PrintError("Error: Invalid package file: Invalid TOC "
+			"index paths\n");
+		return B_BAD_DATA;
+	}
+
+	for (uint32 i = 0; i < directoryCount; i++) {
+		hpkg_toc_index_directory& directory = fTOCIndexDirectories[i];
+		directory.toc_offset = B_BENDIAN_TO_HOST_INT64(directory.toc_offset);
+		directory.toc_end_offset
+			= B_BENDIAN_TO_HOST_INT64(directory.toc_end_offset);
+		directory.path_offset = B_BENDIAN_TO_HOST_INT32(directory.path_offset);
+
+		if (directory.toc_offset < fTOCSection.stringsLength
+			|| directory.toc_offset >= directory.toc_end_offset
+			|| directory.toc_end_offset > fTOCSection.uncompressedLength
+			|| directory.path_offset >= pathsLength) {
+			ErrorOutput()->PrintError("Error: Invalid package file: Invalid "
+				"TOC index directory\n");
+			return B_BAD_DATA;
+		}
+	}
+
+	fTOCIndexOffset = offset;
+	fHeapSize = offset - fHeapOffset;
+	return B_OK;
+}
+
+
+/*!	Reads the given range of the uncompressed TOC into \a buffer. For a
+	compressed TOC decompression starts at the TOC index block containing the
+	start of the range and ends at the block following its end.
+*/
+status_t
+PackageReaderImpl::_ReadTOCRange(uint64 offset, size_t size, uint8* buffer)
+{
+	if (size == 0)
+		return B_OK;
+
+	if (fTOCSection.compression == B_HPKG_COMPRESSION_NONE)
+		return ReadBuffer(fTOCSection.offset + offset, buffer, size);
+
+	// find the blocks
+	uint32 startBlock = 0;
+	while (startBlock + 1 < fTOCIndexBlockCount
+		&& fTOCIndexBlocks[startBlock + 1].uncompressed_offset <= offset) {
+		startBlock++;
+	}
+
+	uint32 endBlock = startBlock + 1;
+	while (endBlock < fTOCIndexBlockCount
+		&& fTOCIndexBlocks[endBlock].uncompressed_offset < offset + size) {
+		endBlock++;
+	}
+
+	// All blocks but the first one start in the middle of the zlib stream, so
+	// they have to be decoded as raw deflate data, which must not include the
+	// stream's trailing checksum.
+	const hpkg_toc_index_block& block = fTOCIndexBlocks[startBlock];
+	bool rawDeflate = block.compressed_offset != 0;
+	uint64 compressedOffset = block.compressed_offset;
+	uint64 compressedEnd;
+	if (endBlock < fTOCIndexBlockCount) {
+		compressedEnd = fTOCIndexBlocks[endBlock].compressed_offset;
+	} else {
+		compressedEnd = fTOCSection.compressedLength;
+		if (rawDeflate) {
+			if (compressedEnd < compressedOffset + 4)
+				return B_BAD_DATA;
+			compressedEnd -= 4;
+		}
+	}
+
+	TOCRangeDataOutput output(buffer, offset - block.uncompressed_offset,
+		size);
+	ZlibDecompressor decompressor(&output);
+	status_t error = decompressor.Init(rawDeflate);
+	if (error != B_OK)
+		return error;
+
+	uint8* readBuffer = (uint8*)malloc(kTOCRangeReadBufferSize);
+	if (readBuffer == NULL)
+		return B_NO_MEMORY;
+
+	while (compressedOffset < compressedEnd) {
+		size_t toRead = std::min((uint64)kTOCRangeReadBufferSize,
+			compressedEnd - compressedOffset);
+		error = ReadBuffer(fTOCSection.offset + compressedOffset, readBuffer,
+			toRead);
+		if (error == B_OK)
+			error = decompressor.DecompressNext(readBuffer, toRead);
+		if (error != B_OK)
+			break;
+
+		compressedOffset += toRead;
+	}
+
+	free(readBuffer);
+
+	if (error != B_OK)
+		return error;
+
+	// Let the decompressor flush pending output. Unless we've read up to the
+	// end of the stream, it fails, since the stream is incomplete.
+	decompressor.Finish();
+
+	if (output.BytesWritten() != size) {
+		ErrorOutput()->PrintError("Error: Missing bytes in uncompressed TOC "
+			"range!\n");
+		return B_BAD_DATA;
+	}
+
+	return B_OK;
+}
+
+
+const hpkg_toc_index_directory*
+PackageReaderImpl::_FindTOCIndexDirectory(const char* path, size_t length)
+	const
+{
+	// the directories are sorted by path
+	int32 lower = 0;
+	int32 upper = (int32)fTOCIndexDirectoryCount - 1;
+	while (lower <= upper) {
+		int32 mid = (lower + upper) / 2;
+		const char* midPath
+			= fTOCIndexPaths + fTOCIndexDirectories[mid].path_offset;
+		int compare = strncmp(midPath, path, length);
+		if (compare == 0 && midPath[length] != '\0')
+			compare = 1;
+
+		if (compare == 0)
+			return &fTOCIndexDirectories[mid];
+		if (compare < 0)
+			lower = mid + 1;
+		else
+			upper = mid - 1;
+	}
+
+	return NULL;
+}
+
+
+/*!	Reports the directories on \a ancestorPath to the content handler and
+	parses the given TOC section below the last one.
+*/
+status_t
+PackageReaderImpl::_ParseTOCSubtree(AttributeHandlerContext* context,
+	SectionInfo& section, char* ancestorPath, BPackageEntry* parentEntry)
+{
+	if (ancestorPath == NULL) {
+		RootAttributeHandler rootAttributeHandler(parentEntry);
+		return _ParseTOC(context, &rootAttributeHandler, section);
+	}
+
+	char* remainingPath = strchr(ancestorPath, '/');
+	if (remainingPath != NULL)
+		*remainingPath++ = '\0';
+
+	BPackageEntry entry(parentEntry, ancestorPath);
+	entry.SetType(S_IFDIR);
+	entry.SetPermissions(B_HPKG_DEFAULT_DIRECTORY_PERMISSIONS);
+
+	status_t error = context->packageContentHandler->HandleEntry(&entry);
+	if (error == B_OK)
+		error = _ParseTOCSubtree(context, section, remainingPath, &entry);
+
+	status_t doneError = context->packageContentHandler->HandleEntryDone(
+		&entry);
+	return error != B_OK ? error : doneError;
+}
+
+
 status_t
 PackageReaderImpl::_ParseTOC(AttributeHandlerContext* context,
-	AttributeHandler* rootAttributeHandler)
+	AttributeHandler* rootAttributeHandler, SectionInfo& section)
 {
 	// parse the TOC
-	fTOCSection.currentOffset = fTOCSection.stringsLength;
-	SetCurrentSection(&fTOCSection);
+	section.currentOffset = section.stringsLength;
+	SetCurrentSection(&section);
 
 	// prepare attribute handler context
 	context->heapOffset = fHeapOffset;
@@ -642,10 +1101,10 @@ PackageReaderImpl::_ParseTOC(AttributeHandlerContext* context,
 	bool sectionHandled;
 	status_t error = ParseAttributeTree(context, sectionHandled);
 	if (error == B_OK && sectionHandled) {
-		if (fTOCSection.currentOffset < fTOCSection.uncompressedLength) {
+		if (section.currentOffset < section.uncompressedLength) {
 			ErrorOutput()->PrintError("Error: %llu excess byte(s) in TOC "
 				"section\n",
-				fTOCSection.uncompressedLength - fTOCSection.currentOffset);
+				section.uncompressedLength - section.currentOffset);
 			error = B_BAD_DATA;
 		}
 	}
@@ -719,14 +1178,15 @@ PackageReaderImpl::ReadAttributeValue(uint8 type, uint8 encoding,
 status_t
 PackageReaderImpl::_GetTOCBuffer(size_t size, const void*& _buffer)
 {
-	if (size > fTOCSection.uncompressedLength - fTOCSection.currentOffset) {
+	SectionInfo* section = CurrentSection();
+	if (size > section->uncompressedLength - section->currentOffset) {
 		ErrorOutput()->PrintError("_GetTOCBuffer(%lu): read beyond TOC end\n",
 			size);
 		return B_BAD_DATA;
 	}
 
-	_buffer = fTOCSection.data + fTOCSection.currentOffset;
-	fTOCSection.currentOffset += size;
+	_buffer = section->data + section->currentOffset;
+	section->currentOffset += size;
 	return B_OK;
 }
 
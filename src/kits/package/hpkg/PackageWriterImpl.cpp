@@ -451,7 +451,12 @@ PackageWriterImpl::PackageWriterImpl(BPackageWriterListener* listener)
 	fRootEntry(NULL),
 	fRootAttribute(NULL),
 	fTopAttribute(NULL),
-	fCheckLicenses(true)
+	fCheckLicenses(true),
+	fWriteTOCIndex(false),
+	fTOCIndexOffset(0),
+	fTOCIndexFileWriter(NULL),
+	fTOCIndexZlibWriter(NULL),
+	fTOCIndexNextBlockOffset(0)
 {
 }
 
@@ -628,6 +633,11 @@ PackageWriterImpl::_Init(const char* fileName, uint32 flags)
 	fHeapOffset = fHeapEnd = sizeof(hpkg_header);
 	fTopAttribute = fRootAttribute;
 
+	// reserve space for the TOC index header, if requested
+	fWriteTOCIndex = (flags & B_HPKG_WRITER_TOC_INDEX) != 0;
+	if (fWriteTOCIndex)
+		fHeapOffset = fHeapEnd += sizeof(hpkg_toc_index_header);
+
 	// in update mode, parse the TOC
 	if ((Flags() & B_HPKG_WRITER_UPDATE_PACKAGE) != 0) {
 		PackageReaderImpl packageReader(fListener);
@@ -649,6 +659,10 @@ PackageWriterImpl::_Init(const char* fileName, uint32 flags)
 			fListener->PrintError("Unexpected heap offset in package file.\n");
 			return B_BAD_DATA;
 		}
+
+		// We can only write a TOC index, if the package has been created with
+		// space for its header.
+		fWriteTOCIndex = fWriteTOCIndex && _HasTOCIndexSpace();
 	}
 
 	return B_OK;
@@ -1250,6 +1264,28 @@ PackageWriterImpl::_Finish()
 	// write the header
 	WriteBuffer(&header, sizeof(hpkg_header), 0);
 
+	// write the TOC index header -- if there's space for it, but we don't write
+	// an index, we write an invalid one to override a previous one
+	if (_HasTOCIndexSpace()) {
+		hpkg_toc_index_header indexHeader;
+		memset(&indexHeader, 0, sizeof(indexHeader));
+
+		if (fWriteTOCIndex) {
+			indexHeader.magic = B_HOST_TO_BENDIAN_INT32(B_HPKG_TOC_INDEX_MAGIC);
+			indexHeader.version
+				= B_HOST_TO_BENDIAN_INT16(B_HPKG_TOC_INDEX_VERSION);
+			indexHeader.offset = B_HOST_TO_BENDIAN_INT64(fTOCIndexOffset);
+			indexHeader.block_count
+				= B_HOST_TO_BENDIAN_INT32(fTOCIndexBlocks.Count());
+			indexHeader.directory_count
+				= B_HOST_TO_BENDIAN_INT32(fTOCIndexDirectories.Count());
+			indexHeader.paths_length
+				= B_HOST_TO_BENDIAN_INT32(fTOCIndexPaths.Count());
+		}
+
+		WriteBuffer(&indexHeader, sizeof(indexHeader), sizeof(hpkg_header));
+	}
+
 	SetFinished(true);
 	return B_OK;
 }
@@ -1358,6 +1394,10 @@ PackageWriterImpl::_WriteTOC(hpkg_header& header)
 	fListener->OnTOCSizeInfo(uncompressedStringsSize, uncompressedMainSize,
 		tocUncompressedSize);
 
+	// insert the TOC index section before the TOC
+	if (fWriteTOCIndex)
+		_WriteTOCIndex(startOffset, endOffset);
+
 	// update the header
 
 	// TOC
@@ -1383,6 +1423,11 @@ PackageWriterImpl::_WriteTOCCompressed(uint64& _uncompressedStringsSize,
 	SetDataWriter(&zlibWriter);
 	zlibWriter.Init();
 
+	if (fWriteTOCIndex) {
+		fTOCIndexFileWriter = &realWriter;
+		fTOCIndexZlibWriter = &zlibWriter;
+	}
+
 	// write the sections
 	int32 cachedStringsWritten
 		= _WriteTOCSections(_uncompressedStringsSize, _uncompressedMainSize);
@@ -1392,6 +1437,9 @@ PackageWriterImpl::_WriteTOCCompressed(uint64& _uncompressedStringsSize,
 	fHeapEnd = realWriter.Offset();
 	SetDataWriter(NULL);
 
+	fTOCIndexFileWriter = NULL;
+	fTOCIndexZlibWriter = NULL;
+
 	_tocUncompressedSize = zlibWriter.BytesWritten();
 	return cachedStringsWritten;
 }
@@ -1419,10 +1467,29 @@ PackageWriterImpl::_WriteTOCUncompressed(uint64& _uncompressedStringsSize,
 int32
 PackageWriterImpl::_WriteTOCSections(uint64& _stringsSize, uint64& _mainSize)
 {
+	// reset the TOC index -- the first block starts with the TOC
+	if (fWriteTOCIndex) {
+		fTOCIndexBlocks.MakeEmpty();
+		fTOCIndexDirectories.MakeEmpty();
+		fTOCIndexPaths.MakeEmpty();
+		fTOCIndexPath.Truncate(0);
+
+		if (fTOCIndexZlibWriter != NULL) {
+			TOCIndexBlock block = { 0, 0 };
+			if (!fTOCIndexBlocks.Add(block))
+				throw std::bad_alloc();
+		}
+	}
+
 	// write the cached strings
 	uint64 cachedStringsOffset = DataWriter()->BytesWritten();
 	int32 cachedStringsWritten = WriteCachedStrings(fStringCache, 2);
 
+	// Start a new TOC index block with the main TOC section, so the strings
+	// can be read without reading any entries.
+	if (fTOCIndexZlibWriter != NULL)
+		_AddTOCIndexBlock();
+
 	// write the main TOC section
 	uint64 mainOffset = DataWriter()->BytesWritten();
 	_WriteAttributeChildren(fRootAttribute);
@@ -1440,6 +1507,41 @@ PackageWriterImpl::_WriteAttributeChildren(Attribute* attribute)
 	DoublyLinkedList<Attribute>::Iterator it
 		= attribute->children.GetIterator();
 	while (Attribute* child = it.Next()) {
+		// start a new TOC index block, if the current one is full
+		if (fTOCIndexZlibWriter != NULL
+			&& DataWriter()->BytesWritten() >= fTOCIndexNextBlockOffset) {
+			_AddTOCIndexBlock();
+		}
+
+		// If this is a directory entry and we're writing a TOC index, remember
+		// the path and the offset of the entry.
+		int32 directoryIndex = -1;
+		int32 parentPathLength = fTOCIndexPath.Length();
+		if (fWriteTOCIndex && child->id == B_HPKG_ATTRIBUTE_ID_DIRECTORY_ENTRY
+			&& child->value.type == B_HPKG_ATTRIBUTE_TYPE_STRING) {
+			Attribute* fileType = child->ChildWithID(
+				B_HPKG_ATTRIBUTE_ID_FILE_TYPE);
+			if (fileType != NULL
+				&& fileType->value.unsignedInt == B_HPKG_FILE_TYPE_DIRECTORY) {
+				if (parentPathLength > 0)
+					fTOCIndexPath << '/';
+				fTOCIndexPath << child->value.string->string;
+
+				TOCIndexDirectory directory;
+				directory.tocOffset = DataWriter()->BytesWritten();
+				directory.tocEndOffset = directory.tocOffset;
+				directory.pathOffset = fTOCIndexPaths.Count();
+				directoryIndex = fTOCIndexDirectories.Count();
+				if (!fTOCIndexDirectories.Add(directory)
+					|| !fTOCIndexPaths.AddUninitialized(
+						fTOCIndexPath.Length() + 1)) {
+					throw std::bad_alloc();
+				}
+				memcpy(&fTOCIndexPaths[directory.pathOffset],
+					fTOCIndexPath.String(), fTOCIndexPath.Length() + 1);
+			}
+		}
+
 		// write tag
 		uint8 encoding = child->value.ApplicableEncoding();
 		WriteUnsignedLEB128(HPKG_ATTRIBUTE_TAG_COMPOSE(child->id,
@@ -1450,12 +1552,136 @@ PackageWriterImpl::_WriteAttributeChildren(Attribute* attribute)
 
 		if (!child->children.IsEmpty())
 			_WriteAttributeChildren(child);
+
+		if (directoryIndex >= 0) {
+			fTOCIndexDirectories[directoryIndex].tocEndOffset
+				= DataWriter()->BytesWritten();
+			fTOCIndexPath.Truncate(parentPathLength);
+		}
 	}
 
 	WriteUnsignedLEB128(0);
 }
 
 
+bool
+PackageWriterImpl::_HasTOCIndexSpace() const
+{
+	return (size_t)fHeapOffset
+		>= sizeof(hpkg_header) + sizeof(hpkg_toc_index_header);
+}
+
+
+/*!	Flushes the TOC compressor and starts a new TOC index block.
+*/
+void
+PackageWriterImpl::_AddTOCIndexBlock()
+{
+	fTOCIndexZlibWriter->Flush();
+
+	TOCIndexBlock block;
+	block.uncompressedOffset = fTOCIndexZlibWriter->BytesWritten();
+	block.compressedOffset = fTOCIndexFileWriter->BytesWritten();
+
+	// replace the previous block, if empty
+	int32 count = fTOCIndexBlocks.Count();
+	if (count > 0 && fTOCIndexBlocks[count - 1].uncompressedOffset
+			== block.uncompressedOffset) {
+		fTOCIndexBlocks[count - 1] = block;
+	} else if (!fTOCIndexBlocks.Add(block))
+		throw std::bad_alloc();
+
+	fTOCIndexNextBlockOffset = block.uncompressedOffset
+		+ kHPKGTOCIndexBlockSize;
+}
+
+
+struct PackageWriterImpl::TOCIndexDirectoryLess {
+	TOCIndexDirectoryLess(const char* paths)
+		:
+		fPaths(paths)
+	{
+	}
+
+	bool operator()(const TOCIndexDirectory& a, const TOCIndexDirectory& b)
+		const
+	{
+		return strcmp(fPaths + a.pathOffset, fPaths + b.pathOffset) < 0;
+	}
+
+private:
+	const char*	fPaths;
+};
+
+
+/*!	Moves the TOC, which has been written to the given file range, back and
+	writes the TOC index section in front of it.
+*/
+void
+PackageWriterImpl::_WriteTOCIndex(off_t tocStartOffset, off_t tocEndOffset)
+{
+	// read the TOC back in
+	size_t tocSize = tocEndOffset - tocStartOffset;
+	void* tocBuffer = malloc(tocSize);
+	if (tocBuffer == NULL)
+		throw std::bad_alloc();
+	MemoryDeleter tocBufferDeleter(tocBuffer);
+
+	ssize_t bytesRead = pread(FD(), tocBuffer, tocSize, tocStartOffset);
+	if (bytesRead < 0 || (size_t)bytesRead != tocSize) {
+		fListener->PrintError("Failed to read back TOC: %s\n",
+			bytesRead < 0 ? strerror(errno) : "short read");
+		throw status_t(bytesRead < 0 ? errno : B_ERROR);
+	}
+
+	// the readers do a binary search on the directories
+	if (!fTOCIndexDirectories.IsEmpty()) {
+		std::sort(fTOCIndexDirectories.Elements(),
+			fTOCIndexDirectories.Elements() + fTOCIndexDirectories.Count(),
+			TOCIndexDirectoryLess(fTOCIndexPaths.Elements()));
+	}
+
+	// write the TOC index section
+	FDDataWriter indexWriter(FD(), tocStartOffset, fListener);
+	SetDataWriter(&indexWriter);
+
+	for (int32 i = 0; i < fTOCIndexBlocks.Count(); i++) {
+		hpkg_toc_index_block block;
+		block.uncompressed_offset = B_HOST_TO_BENDIAN_INT64(
+			fTOCIndexBlocks[i].uncompressedOffset);
+		block.compressed_offset = B_HOST_TO_BENDIAN_INT64(
+			fTOCIndexBlocks[i].compressedOffset);
+		Write(block);
+	}
+
+	for (int32 i = 0; i < fTOCIndexDirectories.Count(); i++) {
+		const TOCIndexDirectory& directory = fTOCIndexDirectories[i];
+		hpkg_toc_index_directory indexDirectory;
+		indexDirectory.toc_offset = B_HOST_TO_BENDIAN_INT64(
+			directory.tocOffset);
+		indexDirectory.toc_end_offset = B_HOST_TO_BENDIAN_INT64(
+			directory.tocEndOffset);
+		indexDirectory.path_offset = B_HOST_TO_BENDIAN_INT32(
+			directory.pathOffset);
+		indexDirectory.reserved = 0;
+		Write(indexDirectory);
+	}
+
+	if (!fTOCIndexPaths.IsEmpty())
+		WriteBuffer(fTOCIndexPaths.Elements(), fTOCIndexPaths.Count(),
+			indexWriter.Offset());
+	off_t newTOCOffset = indexWriter.Offset() + fTOCIndexPaths.Count();
+
+	SetDataWriter(NULL);
+
+	// write the TOC after the index section
+	WriteBuffer(tocBuffer, tocSize, newTOCOffset);
+
+	fTOCIndexOffset = tocStartOffset;
+	fHeapEnd = newTOCOffset + tocSize;
+}
+
+
 void
 PackageWriterImpl::_WritePackageAttributes(hpkg_header& header)
 {
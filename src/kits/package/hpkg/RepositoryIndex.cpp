@@ -0,0 +1,327 @@
+/*
+ * Copyright 2011, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include <package/hpkg/RepositoryIndex.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <ByteOrder.h>
+
+#include <package/hpkg/HPKGDefs.h>
+#include <package/hpkg/HPKGDefsPrivate.h>
+
+
+namespace BPackageKit {
+
+namespace BHPKG {
+
+namespace BPrivate {
+
+
+RepositoryIndex::RepositoryIndex()
+	:
+	fMappedAddress(NULL),
+	fMappedSize(0),
+	fPackages(NULL),
+	fProvides(NULL),
+	fRequires(NULL),
+	fStrings(NULL),
+	fPackageCount(0),
+	fProvidesCount(0),
+	fRequiresCount(0),
+	fStringsLength(0)
+{
+}
+
+
+RepositoryIndex::~RepositoryIndex()
+{
+	if (fMappedAddress != NULL)
+		munmap(fMappedAddress, fMappedSize);
+}
+
+
+status_t
+RepositoryIndex::Init(const char* fileName)
+{
+	int fd = open(fileName, O_RDONLY);
+	if (fd < 0)
+		return errno;
+
+	struct stat st;
+	if (fstat(fd, &st) < 0) {
+		close(fd);
+		return errno;
+	}
+
+	// read the headers
+	hpkg_repo_header header;
+	hpkg_repo_index_header indexHeader;
+	if (pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header)
+		|| B_BENDIAN_TO_HOST_INT32(header.magic) != B_HPKG_REPO_MAGIC
+		|| B_BENDIAN_TO_HOST_INT16(header.version) != B_HPKG_REPO_VERSION) {
+		close(fd);
+		return B_BAD_DATA;
+	}
+
+	uint64 headerSize = B_BENDIAN_TO_HOST_INT16(header.header_size);
+	if (headerSize < sizeof(header) + sizeof(indexHeader)) {
+		close(fd);
+		return B_ENTRY_NOT_FOUND;
+	}
+
+	if (pread(fd, &indexHeader, sizeof(indexHeader), sizeof(header))
+			!= (ssize_t)sizeof(indexHeader)) {
+		close(fd);
+		return B_BAD_DATA;
+	}
+
+	uint64 indexOffset = B_BENDIAN_TO_HOST_INT64(indexHeader.index_offset);
+	uint64 indexLength = B_BENDIAN_TO_HOST_INT64(indexHeader.index_length);
+	uint32 packageCount = B_BENDIAN_TO_HOST_INT32(indexHeader.package_count);
+	uint32 providesCount = B_BENDIAN_TO_HOST_INT32(indexHeader.provides_count);
+	uint32 requiresCount = B_BENDIAN_TO_HOST_INT32(indexHeader.requires_count);
+	uint32 stringsLength = B_BENDIAN_TO_HOST_INT32(indexHeader.strings_length);
+	if (indexLength == 0) {
+		close(fd);
+		return B_ENTRY_NOT_FOUND;
+	}
+
+	// check whether the tables fit the index and the index fits the file
+	uint64 stringsOffset
+		= (uint64)packageCount * sizeof(hpkg_repo_index_package)
+			+ (uint64)providesCount * sizeof(hpkg_repo_index_provides)
+			+ (uint64)requiresCount * sizeof(hpkg_repo_index_requires);
+	if (indexOffset < headerSize || indexOffset > (uint64)st.st_size
+		|| indexLength > (uint64)st.st_size - indexOffset
+		|| stringsLength == 0 || stringsOffset + stringsLength != indexLength
+		|| indexOffset % sizeof(uint32) != 0) {
+		close(fd);
+		return B_BAD_DATA;
+	}
+
+	// map the file up to the end of the index
+	fMappedSize = indexOffset + indexLength;
+	fMappedAddress = mmap(NULL, fMappedSize, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (fMappedAddress == MAP_FAILED) {
+		fMappedAddress = NULL;
+		return errno;
+	}
+
+	const uint8* index = (const uint8*)fMappedAddress + indexOffset;
+	fPackages = (const hpkg_repo_index_package*)index;
+	fProvides = (const hpkg_repo_index_provides*)(fPackages + packageCount);
+	fRequires = (const hpkg_repo_index_requires*)(fProvides + providesCount);
+	fStrings = (const char*)(fRequires + requiresCount);
+
+	// the strings table must be terminated, so that _StringAt() can return
+	// any offset within it
+	if (fStrings[stringsLength - 1] != '\0')
+		return B_BAD_DATA;
+
+	fPackageCount = packageCount;
+	fProvidesCount = providesCount;
+	fRequiresCount = requiresCount;
+	fStringsLength = stringsLength;
+
+	return B_OK;
+}
+
+
+int32
+RepositoryIndex::FindPackage(const char* name) const
+{
+	uint32 count;
+	uint32 index = _FindRange(fPackages, fPackageCount, name, count);
+	return count > 0 ? (int32)index : -1;
+}
+
+
+const char*
+RepositoryIndex::PackageNameAt(uint32 index) const
+{
+	if (index >= fPackageCount)
+		return NULL;
+
+	return _StringAt(B_BENDIAN_TO_HOST_INT32(fPackages[index].name));
+}
+
+
+const char*
+RepositoryIndex::PackageChecksumAt(uint32 index) const
+{
+	if (index >= fPackageCount)
+		return NULL;
+
+	return _StringAt(B_BENDIAN_TO_HOST_INT32(fPackages[index].checksum));
+}
+
+
+BPackageArchitecture
+RepositoryIndex::PackageArchitectureAt(uint32 index) const
+{
+	if (index >= fPackageCount)
+		return B_PACKAGE_ARCHITECTURE_ANY;
+
+	uint32 architecture
+		= B_BENDIAN_TO_HOST_INT32(fPackages[index].architecture);
+	return architecture < B_PACKAGE_ARCHITECTURE_ENUM_COUNT
+		? (BPackageArchitecture)architecture : B_PACKAGE_ARCHITECTURE_ANY;
+}
+
+
+void
+RepositoryIndex::GetPackageVersionAt(uint32 index,
+	BPackageVersion& _version) const
+{
+	if (index >= fPackageCount) {
+		_version.Clear();
+		return;
+	}
+
+	_GetVersion(fPackages[index].version, _version);
+}
+
+
+uint32
+RepositoryIndex::FindProvides(const char* name, uint32& _count) const
+{
+	return _FindRange(fProvides, fProvidesCount, name, _count);
+}
+
+
+status_t
+RepositoryIndex::GetProvidesAt(uint32 index, BPackageResolvable& _resolvable,
+	uint32& _packageIndex) const
+{
+	if (index >= fProvidesCount)
+		return B_BAD_INDEX;
+
+	const hpkg_repo_index_provides& provides = fProvides[index];
+	_packageIndex = B_BENDIAN_TO_HOST_INT32(provides.package);
+	uint32 type = B_BENDIAN_TO_HOST_INT32(provides.type);
+	if (_packageIndex >= fPackageCount
+		|| type >= B_PACKAGE_RESOLVABLE_TYPE_ENUM_COUNT) {
+		return B_BAD_DATA;
+	}
+
+	BPackageVersion version;
+	BPackageVersion compatibleVersion;
+	_GetVersion(provides.version, version);
+	_GetVersion(provides.compatible_version, compatibleVersion);
+	_resolvable.SetTo(_StringAt(B_BENDIAN_TO_HOST_INT32(provides.name)),
+		(BPackageResolvableType)type, version, compatibleVersion);
+
+	return B_OK;
+}
+
+
+uint32
+RepositoryIndex::FindRequires(const char* name, uint32& _count) const
+{
+	return _FindRange(fRequires, fRequiresCount, name, _count);
+}
+
+
+status_t
+RepositoryIndex::GetRequiresAt(uint32 index,
+	BPackageResolvableExpression& _expression, uint32& _packageIndex) const
+{
+	if (index >= fRequiresCount)
+		return B_BAD_INDEX;
+
+	const hpkg_repo_index_requires& requirement = fRequires[index];
+	_packageIndex = B_BENDIAN_TO_HOST_INT32(requirement.package);
+	uint32 op = B_BENDIAN_TO_HOST_INT32(requirement.op);
+	if (_packageIndex >= fPackageCount
+		|| op >= B_PACKAGE_RESOLVABLE_OP_ENUM_COUNT) {
+		return B_BAD_DATA;
+	}
+
+	BPackageVersion version;
+	_GetVersion(requirement.version, version);
+	_expression.SetTo(_StringAt(B_BENDIAN_TO_HOST_INT32(requirement.name)),
+		(BPackageResolvableOperator)op, version);
+
+	return B_OK;
+}
+
+
+/*!	Binary searches the name sorted \a entries for \a name. Returns the index
+	of the first matching entry and the number of matching entries in
+	\a _count.
+*/
+template<typename Entry>
+uint32
+RepositoryIndex::_FindRange(const Entry* entries, uint32 count,
+	const char* name, uint32& _count) const
+{
+	// find the first entry not less than name
+	uint32 lower = 0;
+	uint32 upper = count;
+	while (lower < upper) {
+		uint32 mid = lower + (upper - lower) / 2;
+		if (strcmp(_StringAt(B_BENDIAN_TO_HOST_INT32(entries[mid].name)),
+				name) < 0) {
+			lower = mid + 1;
+		} else
+			upper = mid;
+	}
+
+	// find the first entry greater than name
+	uint32 first = lower;
+	upper = count;
+	while (lower < upper) {
+		uint32 mid = lower + (upper - lower) / 2;
+		if (strcmp(_StringAt(B_BENDIAN_TO_HOST_INT32(entries[mid].name)),
+				name) <= 0) {
+			lower = mid + 1;
+		} else
+			upper = mid;
+	}
+
+	_count = lower - first;
+	return first;
+}
+
+
+const char*
+RepositoryIndex::_StringAt(uint32 offset) const
+{
+	// offset 0 is the empty string
+	return offset < fStringsLength ? fStrings + offset : fStrings;
+}
+
+
+void
+RepositoryIndex::_GetVersion(const hpkg_repo_index_version& indexVersion,
+	BPackageVersion& _version) const
+{
+	const char* major = _StringAt(B_BENDIAN_TO_HOST_INT32(indexVersion.major));
+	if (major[0] == '\0') {
+		_version.Clear();
+		return;
+	}
+
+	_version.SetTo(major,
+		_StringAt(B_BENDIAN_TO_HOST_INT32(indexVersion.minor)),
+		_StringAt(B_BENDIAN_TO_HOST_INT32(indexVersion.micro)),
+		_StringAt(B_BENDIAN_TO_HOST_INT32(indexVersion.pre_release)),
+		(uint8)B_BENDIAN_TO_HOST_INT32(indexVersion.release));
+}
+
+
+}	// namespace BPrivate
+
+}	// namespace BHPKG
+
+}	// namespace BPackageKit
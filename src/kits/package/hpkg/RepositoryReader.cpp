@@ -41,6 +41,16 @@ BRepositoryReader::Init(const char* fileName)
 }
 
 
+status_t
+BRepositoryReader::GetRepositoryInfo(BRepositoryInfo* _repositoryInfo) const
+{
+	if (fImpl == NULL)
+		return B_NO_INIT;
+
+	return fImpl->GetRepositoryInfo(_repositoryInfo);
+}
+
+
 status_t
 BRepositoryReader::ParseContent(BRepositoryContentHandler* contentHandler)
 {
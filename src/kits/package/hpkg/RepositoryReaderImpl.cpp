@@ -199,17 +199,6 @@ RepositoryReaderImpl::Init(int fd, bool keepFD)
 	if (error != B_OK)
 		return error;
 
-	// read in the complete package attributes section
-	fPackageAttributesSection.data
-		= new(std::nothrow) uint8[fPackageAttributesSection.uncompressedLength];
-	if (fPackageAttributesSection.data == NULL) {
-		ErrorOutput()->PrintError("Error: Out of memory!\n");
-		return B_NO_MEMORY;
-	}
-	error = ReadCompressedBuffer(fPackageAttributesSection);
-	if (error != B_OK)
-		return error;
-
 	// unarchive repository info
 	BMessage repositoryInfoArchive;
 	error = repositoryInfoArchive.Unflatten((char*)fRepositoryInfoSection.data);
@@ -225,16 +214,7 @@ RepositoryReaderImpl::Init(int fd, bool keepFD)
 		return error;
 	}
 
-	// parse strings from package attributes section
-	fPackageAttributesSection.currentOffset = 0;
-	SetCurrentSection(&fPackageAttributesSection);
-
-	// strings
-	error = ParseStrings();
-	if (error != B_OK)
-		return error;
-
-	SetCurrentSection(NULL);
+	// the package attributes section is only read when needed
 
 	return B_OK;
 }
@@ -254,7 +234,9 @@ RepositoryReaderImpl::GetRepositoryInfo(BRepositoryInfo* _repositoryInfo) const
 status_t
 RepositoryReaderImpl::ParseContent(BRepositoryContentHandler* contentHandler)
 {
-	status_t result = contentHandler->HandleRepositoryInfo(fRepositoryInfo);
+	status_t result = _ReadPackageAttributesSection();
+	if (result == B_OK)
+		result = contentHandler->HandleRepositoryInfo(fRepositoryInfo);
 	if (result == B_OK) {
 		AttributeHandlerContext context(ErrorOutput(), contentHandler,
 			B_HPKG_SECTION_PACKAGE_ATTRIBUTES);
@@ -265,6 +247,44 @@ RepositoryReaderImpl::ParseContent(BRepositoryContentHandler* contentHandler)
 }
 
 
+status_t
+RepositoryReaderImpl::_ReadPackageAttributesSection()
+{
+	if (fPackageAttributesSection.data != NULL)
+		return B_OK;
+
+	// read in the complete package attributes section
+	fPackageAttributesSection.data
+		= new(std::nothrow) uint8[fPackageAttributesSection.uncompressedLength];
+	if (fPackageAttributesSection.data == NULL) {
+		ErrorOutput()->PrintError("Error: Out of memory!\n");
+		return B_NO_MEMORY;
+	}
+	status_t error = ReadCompressedBuffer(fPackageAttributesSection);
+	if (error != B_OK) {
+		delete[] fPackageAttributesSection.data;
+		fPackageAttributesSection.data = NULL;
+		return error;
+	}
+
+	// parse strings from package attributes section
+	fPackageAttributesSection.currentOffset = 0;
+	SetCurrentSection(&fPackageAttributesSection);
+
+	// strings
+	error = ParseStrings();
+
+	SetCurrentSection(NULL);
+
+	if (error != B_OK) {
+		delete[] fPackageAttributesSection.data;
+		fPackageAttributesSection.data = NULL;
+	}
+
+	return error;
+}
+
+
 }	// namespace BPrivate
 
 }	// namespace BHPKG
@@ -6,13 +6,18 @@
 
 #include <package/hpkg/RepositoryWriterImpl.h>
 
+#include <stdlib.h>
+#include <string.h>
+
 #include <algorithm>
+#include <map>
 #include <new>
 
 #include <ByteOrder.h>
 #include <Message.h>
 #include <Path.h>
 
+#include <Array.h>
 #include <AutoDeleter.h>
 #include <HashSet.h>
 
@@ -179,6 +184,257 @@ struct RepositoryWriterImpl::PackageNameSet
 };
 
 
+// #pragma mark - IndexBuilder
+
+
+/*!	Collects the index tables (see hpkg_repo_index_header) while packages are
+	added. The table entries are kept in host endianess until Write().
+*/
+struct RepositoryWriterImpl::IndexBuilder {
+	IndexBuilder()
+	{
+		// the empty string (used for unset version components) comes first
+		_AddString("");
+	}
+
+	// throws std::bad_alloc
+	void AddPackage(const BPackageInfo& packageInfo)
+	{
+		uint32 packageIndex = fPackages.Count();
+
+		hpkg_repo_index_package package;
+		package.name = _AddString(packageInfo.Name());
+		package.checksum = _AddString(packageInfo.Checksum());
+		package.architecture = packageInfo.Architecture();
+		_SetVersion(package.version, packageInfo.Version());
+		if (!fPackages.Add(package))
+			throw std::bad_alloc();
+
+		const BObjectList<BPackageResolvable>& providesList
+			= packageInfo.ProvidesList();
+		for (int32 i = 0; i < providesList.CountItems(); i++) {
+			const BPackageResolvable* resolvable = providesList.ItemAt(i);
+			hpkg_repo_index_provides provides;
+			provides.name = _AddString(resolvable->Name());
+			provides.package = packageIndex;
+			provides.type = resolvable->Type();
+			_SetVersion(provides.version, resolvable->Version());
+			_SetVersion(provides.compatible_version,
+				resolvable->CompatibleVersion());
+			if (!fProvides.Add(provides))
+				throw std::bad_alloc();
+		}
+
+		const BObjectList<BPackageResolvableExpression>& requiresList
+			= packageInfo.RequiresList();
+		for (int32 i = 0; i < requiresList.CountItems(); i++) {
+			const BPackageResolvableExpression* expression
+				= requiresList.ItemAt(i);
+			hpkg_repo_index_requires requirement;
+			requirement.name = _AddString(expression->Name());
+			requirement.package = packageIndex;
+			requirement.op = expression->Operator();
+			_SetVersion(requirement.version, expression->Version());
+			if (!fRequires.Add(requirement))
+				throw std::bad_alloc();
+		}
+	}
+
+	size_t Size() const
+	{
+		return fPackages.Count() * sizeof(hpkg_repo_index_package)
+			+ fProvides.Count() * sizeof(hpkg_repo_index_provides)
+			+ fRequires.Count() * sizeof(hpkg_repo_index_requires)
+			+ fStrings.Count();
+	}
+
+	// throws std::bad_alloc
+	void Sort()
+	{
+		// sort the packages by name and update the references to them
+		int32 packageCount = fPackages.Count();
+		uint32* order = new uint32[packageCount];
+		ArrayDeleter<uint32> orderDeleter(order);
+		for (int32 i = 0; i < packageCount; i++)
+			order[i] = i;
+		std::sort(order, order + packageCount, PackageLess(this));
+
+		Array<hpkg_repo_index_package> sortedPackages;
+		if (!sortedPackages.AddUninitialized(packageCount))
+			throw std::bad_alloc();
+		uint32* newIndices = new uint32[packageCount];
+		ArrayDeleter<uint32> newIndicesDeleter(newIndices);
+		for (int32 i = 0; i < packageCount; i++) {
+			sortedPackages[i] = fPackages[order[i]];
+			newIndices[order[i]] = i;
+		}
+		fPackages = sortedPackages;
+
+		for (int32 i = 0; i < fProvides.Count(); i++)
+			fProvides[i].package = newIndices[fProvides[i].package];
+		for (int32 i = 0; i < fRequires.Count(); i++)
+			fRequires[i].package = newIndices[fRequires[i].package];
+
+		// sort provides and requires by name and package
+		if (!fProvides.IsEmpty()) {
+			std::sort(fProvides.Elements(),
+				fProvides.Elements() + fProvides.Count(),
+				ResolvableLess<hpkg_repo_index_provides>(this));
+		}
+		if (!fRequires.IsEmpty()) {
+			std::sort(fRequires.Elements(),
+				fRequires.Elements() + fRequires.Count(),
+				ResolvableLess<hpkg_repo_index_requires>(this));
+		}
+	}
+
+	// throws std::bad_alloc
+	void Write(RepositoryWriterImpl* writer, off_t offset,
+		hpkg_repo_index_header& header)
+	{
+		size_t size = Size();
+		uint8* buffer = (uint8*)malloc(size);
+		if (buffer == NULL)
+			throw std::bad_alloc();
+		MemoryDeleter bufferDeleter(buffer);
+
+		uint8* position = buffer;
+		for (int32 i = 0; i < fPackages.Count(); i++) {
+			hpkg_repo_index_package package = fPackages[i];
+			package.name = B_HOST_TO_BENDIAN_INT32(package.name);
+			package.checksum = B_HOST_TO_BENDIAN_INT32(package.checksum);
+			package.architecture
+				= B_HOST_TO_BENDIAN_INT32(package.architecture);
+			_SwapVersion(package.version);
+			memcpy(position, &package, sizeof(package));
+			position += sizeof(package);
+		}
+
+		for (int32 i = 0; i < fProvides.Count(); i++) {
+			hpkg_repo_index_provides provides = fProvides[i];
+			provides.name = B_HOST_TO_BENDIAN_INT32(provides.name);
+			provides.package = B_HOST_TO_BENDIAN_INT32(provides.package);
+			provides.type = B_HOST_TO_BENDIAN_INT32(provides.type);
+			_SwapVersion(provides.version);
+			_SwapVersion(provides.compatible_version);
+			memcpy(position, &provides, sizeof(provides));
+			position += sizeof(provides);
+		}
+
+		for (int32 i = 0; i < fRequires.Count(); i++) {
+			hpkg_repo_index_requires requirement = fRequires[i];
+			requirement.name = B_HOST_TO_BENDIAN_INT32(requirement.name);
+			requirement.package = B_HOST_TO_BENDIAN_INT32(requirement.package);
+			requirement.op = B_HOST_TO_BENDIAN_INT32(requirement.op);
+			_SwapVersion(requirement.version);
+			memcpy(position, &requirement, sizeof(requirement));
+			position += sizeof(requirement);
+		}
+
+		memcpy(position, fStrings.Elements(), fStrings.Count());
+
+		writer->WriteBuffer(buffer, size, offset);
+
+		header.index_offset = B_HOST_TO_BENDIAN_INT64(offset);
+		header.index_length = B_HOST_TO_BENDIAN_INT64(size);
+		header.package_count = B_HOST_TO_BENDIAN_INT32(fPackages.Count());
+		header.provides_count = B_HOST_TO_BENDIAN_INT32(fProvides.Count());
+		header.requires_count = B_HOST_TO_BENDIAN_INT32(fRequires.Count());
+		header.strings_length = B_HOST_TO_BENDIAN_INT32(fStrings.Count());
+	}
+
+private:
+	struct PackageLess {
+		PackageLess(IndexBuilder* builder)
+			:
+			fBuilder(builder)
+		{
+		}
+
+		bool operator()(uint32 a, uint32 b) const
+		{
+			return strcmp(fBuilder->_StringAt(fBuilder->fPackages[a].name),
+				fBuilder->_StringAt(fBuilder->fPackages[b].name)) < 0;
+		}
+
+		IndexBuilder*	fBuilder;
+	};
+
+	template<typename Entry>
+	struct ResolvableLess {
+		ResolvableLess(IndexBuilder* builder)
+			:
+			fBuilder(builder)
+		{
+		}
+
+		bool operator()(const Entry& a, const Entry& b) const
+		{
+			int compare = strcmp(fBuilder->_StringAt(a.name),
+				fBuilder->_StringAt(b.name));
+			if (compare != 0)
+				return compare < 0;
+			return a.package < b.package;
+		}
+
+		IndexBuilder*	fBuilder;
+	};
+
+	typedef std::map<BString, uint32> StringMap;
+
+private:
+	const char* _StringAt(uint32 offset) const
+	{
+		return fStrings.Elements() + offset;
+	}
+
+	uint32 _AddString(const BString& string)
+	{
+		StringMap::iterator it = fStringOffsets.find(string);
+		if (it != fStringOffsets.end())
+			return it->second;
+
+		uint32 offset = fStrings.Count();
+		int32 length = string.Length() + 1;
+		if (!fStrings.AddUninitialized(length))
+			throw std::bad_alloc();
+		memcpy(fStrings.Elements() + offset, string.String(), length);
+
+		fStringOffsets[string] = offset;
+		return offset;
+	}
+
+	void _SetVersion(hpkg_repo_index_version& indexVersion,
+		const BPackageVersion& version)
+	{
+		indexVersion.major = _AddString(version.Major());
+		indexVersion.minor = _AddString(version.Minor());
+		indexVersion.micro = _AddString(version.Micro());
+		indexVersion.pre_release = _AddString(version.PreRelease());
+		indexVersion.release = version.Release();
+	}
+
+	static void _SwapVersion(hpkg_repo_index_version& version)
+	{
+		version.major = B_HOST_TO_BENDIAN_INT32(version.major);
+		version.minor = B_HOST_TO_BENDIAN_INT32(version.minor);
+		version.micro = B_HOST_TO_BENDIAN_INT32(version.micro);
+		version.pre_release = B_HOST_TO_BENDIAN_INT32(version.pre_release);
+		version.release = B_HOST_TO_BENDIAN_INT32(version.release);
+	}
+
+private:
+	Array<hpkg_repo_index_package>	fPackages;
+	Array<hpkg_repo_index_provides>	fProvides;
+	Array<hpkg_repo_index_requires>	fRequires;
+	Array<char>						fStrings;
+	StringMap						fStringOffsets;
+};
+
+
+// #pragma mark - RepositoryWriterImpl
+
+
 RepositoryWriterImpl::RepositoryWriterImpl(BRepositoryWriterListener* listener,
 	BRepositoryInfo* repositoryInfo)
 	:
@@ -186,13 +442,15 @@ RepositoryWriterImpl::RepositoryWriterImpl(BRepositoryWriterListener* listener,
 	fListener(listener),
 	fRepositoryInfo(repositoryInfo),
 	fPackageCount(0),
-	fPackageNames(NULL)
+	fPackageNames(NULL),
+	fIndexBuilder(NULL)
 {
 }
 
 
 RepositoryWriterImpl::~RepositoryWriterImpl()
 {
+	delete fIndexBuilder;
 	delete fPackageNames;
 }
 
@@ -205,6 +463,7 @@ RepositoryWriterImpl::Init(const char* fileName)
 		status_t result = fPackageNames->InitCheck();
 		if (result != B_OK)
 			return result;
+		fIndexBuilder = new IndexBuilder();
 		return _Init(fileName);
 	} catch (status_t error) {
 		return error;
@@ -254,30 +513,37 @@ status_t
 RepositoryWriterImpl::_Finish()
 {
 	hpkg_repo_header header;
+	hpkg_repo_index_header indexHeader;
+	off_t headerSize = sizeof(header) + sizeof(indexHeader);
+
+	// write the index
+	off_t infoOffset = _WriteIndex(indexHeader, headerSize);
 
 	// write repository header
 	ssize_t infoLengthCompressed;
-	status_t result = _WriteRepositoryInfo(header, infoLengthCompressed);
+	status_t result = _WriteRepositoryInfo(header, infoOffset,
+		infoLengthCompressed);
 	if (result != B_OK)
 		return result;
 
 	// write package attributes
 	ssize_t packagesLengthCompressed;
 	off_t totalSize = _WritePackageAttributes(header,
-		sizeof(header) + infoLengthCompressed, packagesLengthCompressed);
+		infoOffset + infoLengthCompressed, packagesLengthCompressed);
 
-	fListener->OnRepositoryDone(sizeof(header), infoLengthCompressed,
+	fListener->OnRepositoryDone(headerSize, infoLengthCompressed,
 		fRepositoryInfo->LicenseNames().CountStrings(), fPackageCount,
 		packagesLengthCompressed, totalSize);
 
 	// general
 	header.magic = B_HOST_TO_BENDIAN_INT32(B_HPKG_REPO_MAGIC);
-	header.header_size = B_HOST_TO_BENDIAN_INT16((uint16)sizeof(header));
+	header.header_size = B_HOST_TO_BENDIAN_INT16((uint16)headerSize);
 	header.version = B_HOST_TO_BENDIAN_INT16(B_HPKG_REPO_VERSION);
 	header.total_size = B_HOST_TO_BENDIAN_INT64(totalSize);
 
-	// write the header
+	// write the headers
 	WriteBuffer(&header, sizeof(header), 0);
+	WriteBuffer(&indexHeader, sizeof(indexHeader), sizeof(header));
 
 	SetFinished(true);
 	return B_OK;
@@ -375,6 +641,7 @@ RepositoryWriterImpl::_RegisterCurrentPackageInfo()
 		return result;
 
 	RegisterPackageInfo(PackageAttributes(), fPackageInfo);
+	fIndexBuilder->AddPackage(fPackageInfo);
 	fPackageCount++;
 	fListener->OnPackageAdded(fPackageInfo);
 
@@ -382,9 +649,20 @@ RepositoryWriterImpl::_RegisterCurrentPackageInfo()
 }
 
 
+off_t
+RepositoryWriterImpl::_WriteIndex(hpkg_repo_index_header& indexHeader,
+	off_t startOffset)
+{
+	fIndexBuilder->Sort();
+	fIndexBuilder->Write(this, startOffset, indexHeader);
+
+	return startOffset + fIndexBuilder->Size();
+}
+
+
 status_t
 RepositoryWriterImpl::_WriteRepositoryInfo(hpkg_repo_header& header,
-	ssize_t& _infoLengthCompressed)
+	off_t startOffset, ssize_t& _infoLengthCompressed)
 {
 	BMessage archive;
 	status_t result = fRepositoryInfo->Archive(&archive);
@@ -400,9 +678,7 @@ RepositoryWriterImpl::_WriteRepositoryInfo(hpkg_repo_header& header,
 		return result;
 	}
 
-	off_t startOffset = sizeof(hpkg_repo_header);
-
-	// write the package attributes (zlib writer on top of a file writer)
+	// write the repository info (zlib writer on top of a file writer)
 	FDDataWriter realWriter(FD(), startOffset, fListener);
 	ZlibDataWriter zlibWriter(&realWriter);
 	SetDataWriter(&zlibWriter);
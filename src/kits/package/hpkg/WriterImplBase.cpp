@@ -247,6 +247,15 @@ WriterImplBase::ZlibDataWriter::Init()
 }
 
 
+void
+WriterImplBase::ZlibDataWriter::Flush()
+{
+	status_t error = fCompressor.Flush();
+	if (error != B_OK)
+		throw status_t(error);
+}
+
+
 void
 WriterImplBase::ZlibDataWriter::Finish()
 {
@@ -93,6 +93,40 @@ ZlibCompressor::CompressNext(const void* input, size_t inputSize)
 }
 
 
+/*!	Flushes all pending output and resets the compression state, so that
+	decompression can be started at the current output position.
+*/
+status_t
+ZlibCompressor::Flush()
+{
+	fStream.next_in = (Bytef*)NULL;
+	fStream.avail_in = 0;
+
+	while (true) {
+		uint8 outputBuffer[kOutputBufferSize];
+		fStream.next_out = (Bytef*)outputBuffer;
+		fStream.avail_out = sizeof(outputBuffer);
+
+		int zlibError = deflate(&fStream, Z_FULL_FLUSH);
+		if (zlibError != Z_OK && zlibError != Z_BUF_ERROR)
+			return TranslateZlibError(zlibError);
+
+		if (fStream.avail_out < sizeof(outputBuffer)) {
+			status_t error = fOutput->WriteData(outputBuffer,
+				sizeof(outputBuffer) - fStream.avail_out);
+			if (error != B_OK)
+				return error;
+		}
+
+		// the flush is complete, when deflate() didn't fill the buffer
+		if (fStream.avail_out > 0)
+			break;
+	}
+
+	return B_OK;
+}
+
+
 status_t
 ZlibCompressor::Finish()
 {
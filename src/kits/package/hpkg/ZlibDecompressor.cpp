@@ -40,7 +40,7 @@ ZlibDecompressor::~ZlibDecompressor()
 
 
 status_t
-ZlibDecompressor::Init()
+ZlibDecompressor::Init(bool rawDeflate)
 {
 	// initialize the stream
 	fStream.next_in = NULL;
@@ -58,7 +58,8 @@ ZlibDecompressor::Init()
 	fStream.adler = 0;
 	fStream.reserved = 0;
 
-	int zlibError = inflateInit(&fStream);
+	int zlibError = rawDeflate
+		? inflateInit2(&fStream, -MAX_WBITS) : inflateInit(&fStream);
 	if (zlibError != Z_OK)
 		return TranslateZlibError(zlibError);
 
@@ -18,6 +18,8 @@
 #include <NodeMonitor.h>
 #include "storage_support.h"
 
+#include <AsyncIOQueue.h>
+
 #include <syscalls.h>
 #include <umask.h>
 
@@ -461,6 +463,75 @@ BFile::GetSize(off_t* size) const
 }
 
 
+/*!	\brief Reads from a certain position within the file into several
+		   buffers at once.
+	\param location the position (in bytes) within the file from which the
+		   data shall be read
+	\param vecs the buffers the data shall be written to
+	\param count the number of buffers in \a vecs
+	\return the number of bytes actually read or an error code
+*/
+ssize_t
+BFile::ReadAtV(off_t location, const iovec* vecs, size_t count)
+{
+	if (InitCheck() != B_OK)
+		return InitCheck();
+	if (location < 0)
+		return B_BAD_VALUE;
+
+	return _kern_readv(get_fd(), location, vecs, count);
+}
+
+
+/*!	\brief Writes several buffers at once to a certain position within the
+		   file.
+	\param location the position (in bytes) within the file at which the data
+		   shall be written
+	\param vecs the buffers containing the data to be written
+	\param count the number of buffers in \a vecs
+	\return the number of bytes actually written or an error code
+*/
+ssize_t
+BFile::WriteAtV(off_t location, const iovec* vecs, size_t count)
+{
+	if (InitCheck() != B_OK)
+		return InitCheck();
+	if (location < 0)
+		return B_BAD_VALUE;
+
+	return _kern_writev(get_fd(), location, vecs, count);
+}
+
+
+/*!	\brief Reads from a certain position within the file in the background.
+	The read is done by a worker thread; \a hook is called from that thread
+	with the result of ReadAt() once it is done. The buffer must stay valid,
+	and the file open, until then.
+	\param location the position (in bytes) within the file from which the
+		   data shall be read
+	\param buffer the buffer the data from the file shall be written to
+	\param size the number of bytes that shall be read
+	\param hook the function to be called when the read is done
+	\param cookie passed on to \a hook
+	\return
+	- \c B_OK, if the read has been started; only then \a hook is called
+	- \c B_BAD_VALUE, if \a location is negative or \a hook is \c NULL
+	- another error code, if the read could not be started
+*/
+status_t
+BFile::ReadAtAsync(off_t location, void* buffer, size_t size,
+	io_completion_hook hook, void* cookie)
+{
+	if (InitCheck() != B_OK)
+		return InitCheck();
+	if (location < 0 || hook == NULL)
+		return B_BAD_VALUE;
+
+	return AsyncIOQueue::QueueReadAt(this, location, buffer, size, hook,
+		cookie);
+}
+
+
 /*!	\brief Assigns another BFile to this BFile.
 	If the other BFile is uninitialized, this one will be too. Otherwise it
 	will refer to the same file using the same mode, unless an error occurs.
@@ -489,9 +560,9 @@ BFile::operator=(const BFile &file)
 
 
 // FBC
-void BFile::_PhiloFile1() {}
-void BFile::_PhiloFile2() {}
-void BFile::_PhiloFile3() {}
+extern "C" void _PhiloFile1__5BFile() {}
+extern "C" void _PhiloFile2__5BFile() {}
+extern "C" void _PhiloFile3__5BFile() {}
 void BFile::_PhiloFile4() {}
 void BFile::_PhiloFile5() {}
 void BFile::_PhiloFile6() {}
@@ -13,6 +13,7 @@
 
 #include <Bitmap.h>
 #include <mime/database_access.h>	
+#include <mime/database_snapshot.h>
 #include <sniffer/Rule.h>
 #include <sniffer/Parser.h>
 
@@ -398,10 +399,18 @@ BMimeType::GetSupportingApps(BMessage *signatures) const
 	if (signatures == NULL)
 		return B_BAD_VALUE;
 
+	status_t err = InitCheck();
+	if (!err) {
+		// the registrar's snapshot of the database saves us the round trip
+		err = get_snapshot_supporting_apps(Type(), signatures);
+		if (err != kMimeSnapshotMissError)
+			return err;
+		err = B_OK;
+	}
+
 	BMessage msg(B_REG_MIME_GET_SUPPORTING_APPS);
 	status_t result;
 
-	status_t err = InitCheck();
 	if (!err)
 		err = msg.AddString("type", Type());
 	if (!err)
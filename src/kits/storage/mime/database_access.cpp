@@ -17,6 +17,7 @@
 #include <Directory.h>
 #include <IconUtils.h>
 #include <Message.h>
+#include <mime/database_snapshot.h>
 #include <mime/database_support.h>
 #include <Node.h>
 #include <Path.h>
@@ -499,6 +500,10 @@ get_supported_types(const char *type, BMessage *types)
 bool
 is_installed(const char *type)
 {
+	bool installed;
+	if (snapshot_is_installed(type, &installed) == B_OK)
+		return installed;
+
 	BNode node;
 	return open_type(type, &node) == B_OK;
 }
@@ -0,0 +1,510 @@
+/*
+ * Copyright 2011, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+/*!
+	\file database_snapshot.cpp
+	Lookups in the registrar's MIME database snapshot
+*/
+
+#include <mime/database_snapshot.h>
+
+#include <ctype.h>
+#include <pthread.h>
+#include <string.h>
+
+#include <locks.h>
+#include <Message.h>
+#include <mime/database_support.h>
+#include <RegistrarDefs.h>
+#include <String.h>
+
+
+namespace BPrivate {
+namespace Storage {
+namespace Mime {
+
+
+/*!	\var kMimeSnapshotMissError
+	\brief Returned by the snapshot lookup functions, if the snapshot can't
+	answer the request.
+
+	That is the case when there is no current snapshot (for instance, while
+	the registrar is updating it after the database has changed), or when
+	the requested data was too large to be included. The caller has to ask
+	the database itself then.
+*/
+const status_t kMimeSnapshotMissError = B_ERRORS_END + 2;
+
+
+static pthread_once_t sControlInitOnce = PTHREAD_ONCE_INIT;
+static const mime_snapshot_control *sControl = NULL;
+
+// guards the mapping of the snapshot, not the snapshot itself, which is
+// never changed
+static rw_lock sSnapshotLock = RW_LOCK_INITIALIZER("mime database snapshot");
+static const mime_snapshot_header *sSnapshot = NULL;
+static area_id sSnapshotArea = -1;
+static int32 sSnapshotGeneration = -1;
+
+
+static void
+init_control()
+{
+	area_id source = find_area(MIME_SNAPSHOT_CONTROL_AREA_NAME);
+	if (source < 0)
+		return;
+
+	void *address;
+	area_id area = clone_area("mime database snapshot control clone",
+		&address, B_ANY_ADDRESS, B_READ_AREA, source);
+	if (area < 0)
+		return;
+
+	const mime_snapshot_control *control
+		= (const mime_snapshot_control*)address;
+	if (control->magic != MIME_SNAPSHOT_MAGIC) {
+		delete_area(area);
+		return;
+	}
+
+	sControl = control;
+}
+
+
+/*!	\brief Maps the snapshot of the given generation, if it is still current.
+
+	The caller must hold the write lock.
+*/
+static void
+map_snapshot(int32 generation)
+{
+	if (sSnapshotArea >= 0) {
+		delete_area(sSnapshotArea);
+		sSnapshotArea = -1;
+		sSnapshot = NULL;
+	}
+
+	// even if there's no snapshot, we don't need to look again before the
+	// generation changes
+	sSnapshotGeneration = generation;
+
+	area_id source = sControl->snapshot;
+	if (source < 0)
+		return;
+
+	void *address;
+	area_id area = clone_area("mime database snapshot clone", &address,
+		B_ANY_ADDRESS, B_READ_AREA, source);
+	if (area < 0)
+		return;
+
+	// The registrar may have replaced the snapshot in the meantime.
+	area_info info;
+	const mime_snapshot_header *snapshot = (const mime_snapshot_header*)address;
+	if (get_area_info(area, &info) != B_OK
+		|| info.size < sizeof(mime_snapshot_header)
+		|| snapshot->magic != MIME_SNAPSHOT_MAGIC
+		|| snapshot->version != MIME_SNAPSHOT_VERSION
+		|| snapshot->generation != generation
+		|| snapshot->size > info.size) {
+		delete_area(area);
+		return;
+	}
+
+	sSnapshot = snapshot;
+	sSnapshotArea = area;
+}
+
+
+/*!	\brief Returns the current snapshot, or \c NULL, if there is none.
+
+	\a locker must hold the read lock; it does so again on return. The
+	snapshot may only be accessed while it is held.
+*/
+static const mime_snapshot_header *
+current_snapshot(ReadLocker &locker)
+{
+	pthread_once(&sControlInitOnce, &init_control);
+	if (sControl == NULL || !locker.IsLocked())
+		return NULL;
+
+	int32 generation = sControl->generation;
+	if (sSnapshotGeneration != generation) {
+		locker.Unlock();
+		{
+			WriteLocker writeLocker(sSnapshotLock);
+			if (sSnapshotGeneration != generation)
+				map_snapshot(generation);
+		}
+		if (!locker.Lock())
+			return NULL;
+	}
+
+	if (sSnapshot == NULL || sSnapshotGeneration != sControl->generation)
+		return NULL;
+
+	return sSnapshot;
+}
+
+
+static inline const char *
+snapshot_string(const mime_snapshot_header *snapshot, uint32 offset)
+{
+	return (const char*)snapshot + offset;
+}
+
+
+//! Compares \a type case-insensitively with the lower case \a name.
+static int
+compare_type(const char *type, const char *name)
+{
+	while (true) {
+		int c1 = tolower((uint8)*type++);
+		int c2 = (uint8)*name++;
+		if (c1 != c2 || c1 == '\0')
+			return c1 - c2;
+	}
+}
+
+
+/*!	\brief Returns whether the snapshot can tell about the given type.
+
+	The database stores types as files of a two level directory hierarchy,
+	the snapshot only knows about those. Anything else is left to the file
+	system to answer.
+*/
+static bool
+is_snapshot_type(const char *type)
+{
+	if (type == NULL || type[0] == '\0' || type[0] == '/')
+		return false;
+
+	const char *slash = strchr(type, '/');
+	return slash == NULL
+		|| (slash[1] != '\0' && strchr(slash + 1, '/') == NULL);
+}
+
+
+static const mime_snapshot_type *
+find_type(const mime_snapshot_header *snapshot, const char *type)
+{
+	const mime_snapshot_type *types = (const mime_snapshot_type*)
+		((const uint8*)snapshot + snapshot->types);
+
+	int32 lower = 0;
+	int32 upper = (int32)snapshot->type_count - 1;
+	while (lower <= upper) {
+		int32 middle = (lower + upper) / 2;
+		int compare = compare_type(type,
+			snapshot_string(snapshot, types[middle].name));
+		if (compare == 0)
+			return &types[middle];
+		if (compare < 0)
+			upper = middle - 1;
+		else
+			lower = middle + 1;
+	}
+
+	return NULL;
+}
+
+
+/*!	\brief Looks up an attribute of a type.
+
+	\return
+	- \c B_OK: The attribute was found and its data is in the snapshot.
+	- \c B_ENTRY_NOT_FOUND: The type is not installed, or doesn't have the
+	  attribute.
+	- \c kMimeSnapshotMissError: The snapshot can't tell.
+*/
+static status_t
+find_attribute(const mime_snapshot_header *snapshot, const char *type,
+	const char *attr, const mime_snapshot_attribute **_attribute)
+{
+	if (!is_snapshot_type(type))
+		return kMimeSnapshotMissError;
+
+	const mime_snapshot_type *snapshotType = find_type(snapshot, type);
+	if (snapshotType == NULL)
+		return B_ENTRY_NOT_FOUND;
+
+	const mime_snapshot_attribute *attributes
+		= (const mime_snapshot_attribute*)
+			((const uint8*)snapshot + snapshotType->attributes);
+	for (uint32 i = 0; i < snapshotType->attribute_count; i++) {
+		if (strcmp(snapshot_string(snapshot, attributes[i].name), attr) != 0)
+			continue;
+
+		if (attributes[i].data == 0)
+			return kMimeSnapshotMissError;
+
+		*_attribute = &attributes[i];
+		return B_OK;
+	}
+
+	return B_ENTRY_NOT_FOUND;
+}
+
+
+/*!	\brief Returns the list of apps supporting the given type.
+
+	Unlike the types, the lists are keyed by the type strings exactly as the
+	apps spelled them, like the registrar's table is.
+*/
+static const mime_snapshot_app_list *
+find_app_list(const mime_snapshot_header *snapshot, const char *type)
+{
+	const mime_snapshot_app_list *lists = (const mime_snapshot_app_list*)
+		((const uint8*)snapshot + snapshot->app_lists);
+
+	int32 lower = 0;
+	int32 upper = (int32)snapshot->app_list_count - 1;
+	while (lower <= upper) {
+		int32 middle = (lower + upper) / 2;
+		int compare = strcmp(type,
+			snapshot_string(snapshot, lists[middle].type));
+		if (compare == 0)
+			return &lists[middle];
+		if (compare < 0)
+			upper = middle - 1;
+		else
+			lower = middle + 1;
+	}
+
+	return NULL;
+}
+
+
+//! Returns whether the sorted list contains the given app signature.
+static bool
+app_list_contains(const mime_snapshot_header *snapshot,
+	const mime_snapshot_app_list *list, const char *signature)
+{
+	const uint32 *signatures
+		= (const uint32*)((const uint8*)snapshot + list->apps);
+
+	int32 lower = 0;
+	int32 upper = (int32)list->app_count - 1;
+	while (lower <= upper) {
+		int32 middle = (lower + upper) / 2;
+		int compare = strcmp(signature,
+			snapshot_string(snapshot, signatures[middle]));
+		if (compare == 0)
+			return true;
+		if (compare < 0)
+			upper = middle - 1;
+		else
+			lower = middle + 1;
+	}
+
+	return false;
+}
+
+
+// #pragma mark -
+
+
+/*!	\brief Reads up to \a length bytes of an attribute of a type from the
+	snapshot.
+
+	Works like read_mime_attr().
+
+	\return The number of bytes read, an error code, or
+		\c kMimeSnapshotMissError, if the snapshot can't tell.
+*/
+ssize_t
+read_snapshot_attr(const char *type, const char *attr, void *data,
+	size_t length)
+{
+	if (type == NULL || attr == NULL || data == NULL)
+		return B_BAD_VALUE;
+
+	ReadLocker locker(sSnapshotLock);
+	const mime_snapshot_header *snapshot = current_snapshot(locker);
+	if (snapshot == NULL)
+		return kMimeSnapshotMissError;
+
+	const mime_snapshot_attribute *attribute;
+	status_t status = find_attribute(snapshot, type, attr, &attribute);
+	if (status != B_OK)
+		return status;
+
+	if (length > attribute->size)
+		length = attribute->size;
+	memcpy(data, (const uint8*)snapshot + attribute->data, length);
+
+	return length;
+}
+
+
+/*!	\brief Unflattens a message stored in an attribute of a type from the
+	snapshot.
+
+	Works like read_mime_attr_message().
+*/
+status_t
+read_snapshot_attr_message(const char *type, const char *attr,
+	BMessage *message)
+{
+	if (type == NULL || attr == NULL || message == NULL)
+		return B_BAD_VALUE;
+
+	ReadLocker locker(sSnapshotLock);
+	const mime_snapshot_header *snapshot = current_snapshot(locker);
+	if (snapshot == NULL)
+		return kMimeSnapshotMissError;
+
+	const mime_snapshot_attribute *attribute;
+	status_t status = find_attribute(snapshot, type, attr, &attribute);
+	if (status != B_OK)
+		return status;
+
+	if (attribute->type != B_MESSAGE_TYPE)
+		return B_BAD_VALUE;
+
+	return message->Unflatten((const char*)snapshot + attribute->data);
+}
+
+
+/*!	\brief Reads a string stored in an attribute of a type from the
+	snapshot.
+
+	Works like read_mime_attr_string().
+*/
+status_t
+read_snapshot_attr_string(const char *type, const char *attr,
+	BString *string)
+{
+	if (type == NULL || attr == NULL || string == NULL)
+		return B_BAD_VALUE;
+
+	ReadLocker locker(sSnapshotLock);
+	const mime_snapshot_header *snapshot = current_snapshot(locker);
+	if (snapshot == NULL)
+		return kMimeSnapshotMissError;
+
+	const mime_snapshot_attribute *attribute;
+	status_t status = find_attribute(snapshot, type, attr, &attribute);
+	if (status != B_OK)
+		return status;
+
+	// like BNode::ReadAttrString(), the data need not be null terminated
+	const char *data = (const char*)snapshot + attribute->data;
+	string->SetTo(data, strnlen(data, attribute->size));
+
+	return B_OK;
+}
+
+
+/*!	\brief Finds out whether the given type is installed, according to the
+	snapshot.
+
+	\return \c B_OK, if \a installed was set, or \c kMimeSnapshotMissError,
+		if the snapshot can't tell.
+*/
+status_t
+snapshot_is_installed(const char *type, bool *installed)
+{
+	if (!is_snapshot_type(type))
+		return kMimeSnapshotMissError;
+
+	ReadLocker locker(sSnapshotLock);
+	const mime_snapshot_header *snapshot = current_snapshot(locker);
+	if (snapshot == NULL)
+		return kMimeSnapshotMissError;
+
+	*installed = find_type(snapshot, type) != NULL;
+	return B_OK;
+}
+
+
+/*!	\brief Composes the list of apps supporting the given type from the
+	snapshot.
+
+	\a apps is filled in exactly like the registrar replies to a
+	\c B_REG_MIME_GET_SUPPORTING_APPS request; see
+	BMimeType::GetSupportingApps() for the format.
+
+	\return \c B_OK, an error code, or \c kMimeSnapshotMissError, if the
+		snapshot can't tell.
+*/
+status_t
+get_snapshot_supporting_apps(const char *type, BMessage *apps)
+{
+	if (type == NULL || apps == NULL)
+		return B_BAD_VALUE;
+
+	ReadLocker locker(sSnapshotLock);
+	const mime_snapshot_header *snapshot = current_snapshot(locker);
+	if (snapshot == NULL)
+		return kMimeSnapshotMissError;
+
+	char superType[B_MIME_TYPE_LENGTH];
+	const char *slash = strchr(type, '/');
+	bool isSupertype = slash == NULL;
+	if (!isSupertype) {
+		size_t length = slash - type;
+		if (length >= sizeof(superType))
+			return B_BAD_VALUE;
+		memcpy(superType, type, length);
+		superType[length] = '\0';
+	}
+
+	const mime_snapshot_app_list *typeList = find_app_list(snapshot, type);
+	const mime_snapshot_app_list *superList
+		= isSupertype ? NULL : find_app_list(snapshot, superType);
+
+	apps->MakeEmpty();
+	apps->what = B_REG_RESULT;
+
+	status_t status = B_OK;
+	int32 count = 0;
+	if (typeList != NULL) {
+		const uint32 *signatures
+			= (const uint32*)((const uint8*)snapshot + typeList->apps);
+		for (; count < (int32)typeList->app_count && status == B_OK; count++) {
+			status = apps->AddString(kApplicationsField,
+				snapshot_string(snapshot, signatures[count]));
+		}
+	}
+
+	if (isSupertype) {
+		if (status == B_OK)
+			status = apps->AddInt32(kSupportingAppsSuperCountField, count);
+	} else {
+		if (status == B_OK)
+			status = apps->AddInt32(kSupportingAppsSubCountField, count);
+
+		// add the apps supporting the supertype, but not the type itself
+		count = 0;
+		if (superList != NULL) {
+			const uint32 *signatures
+				= (const uint32*)((const uint8*)snapshot + superList->apps);
+			for (uint32 i = 0; i < superList->app_count && status == B_OK;
+					i++) {
+				const char *signature
+					= snapshot_string(snapshot, signatures[i]);
+				if (typeList != NULL
+					&& app_list_contains(snapshot, typeList, signature)) {
+					continue;
+				}
+				status = apps->AddString(kApplicationsField, signature);
+				count++;
+			}
+		}
+		if (status == B_OK)
+			status = apps->AddInt32(kSupportingAppsSuperCountField, count);
+	}
+
+	if (status == B_OK)
+		status = apps->AddInt32("result", B_OK);
+
+	return status;
+}
+
+
+} // namespace Mime
+} // namespace Storage
+} // namespace BPrivate
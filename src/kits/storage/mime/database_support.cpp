@@ -27,6 +27,7 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "mime/database_snapshot.h"
 #include "mime/database_support.h"
 
 //#define DBG(x) x
@@ -241,6 +242,12 @@ read_mime_attr(const char *type, const char *attr, void *data,
 {
 	BNode node;
 	ssize_t err = (type && attr && data ? B_OK : B_BAD_VALUE);
+	if (!err) {
+		// try the registrar's snapshot of the database first
+		ssize_t bytes = read_snapshot_attr(type, attr, data, len);
+		if (bytes != kMimeSnapshotMissError)
+			return bytes;
+	}
 	if (!err)
 		err = open_type(type, &node);
 	if (!err)
@@ -268,6 +275,11 @@ read_mime_attr_message(const char *type, const char *attr, BMessage *msg)
 	attr_info info;
 	char *buffer = NULL;
 	ssize_t err = (type && attr && msg ? B_OK : B_BAD_VALUE);
+	if (!err) {
+		status_t status = read_snapshot_attr_message(type, attr, msg);
+		if (status != kMimeSnapshotMissError)
+			return status;
+	}
 	if (!err)
 		err = open_type(type, &node);
 	if (!err)
@@ -306,6 +318,11 @@ read_mime_attr_string(const char *type, const char *attr, BString *str)
 {
 	BNode node;
 	status_t err = (type && attr && str ? B_OK : B_BAD_VALUE);
+	if (!err) {
+		status_t status = read_snapshot_attr_string(type, attr, str);
+		if (status != kMimeSnapshotMissError)
+			return status;
+	}
 	if (!err)
 		err = open_type(type, &node);
 	if (!err)
@@ -9,6 +9,7 @@
 
 #include <sniffer/Err.h>
 #include <sniffer/Pattern.h>
+#include <sniffer/RuleSet.h>
 #include <DataIO.h>
 #include <stdio.h>	// for SEEK_* defines
 #include <new>
@@ -110,6 +111,14 @@ Pattern::BytesNeeded() const
 	return result;
 }
 
+//! Adds the pattern, to be searched over the given range, to a rule set
+void
+Pattern::Compile(Range range, RuleSet *set, bool caseInsensitive) const
+{
+	if (InitCheck() == B_OK)
+		set->AddPattern(range, fString, fMask, caseInsensitive);
+}
+
 //#define OPTIMIZATION_IS_FOR_CHUMPS
 #if OPTIMIZATION_IS_FOR_CHUMPS
 bool
@@ -10,6 +10,7 @@
 #include <sniffer/Err.h>
 #include <sniffer/Pattern.h>
 #include <sniffer/PatternList.h>
+#include <sniffer/RuleSet.h>
 #include <DataIO.h>
 #include <stdio.h>
 
@@ -91,6 +92,20 @@ PatternList::BytesNeeded() const
 	return result;	
 }
 
+//! Adds the list's patterns to the rule set currently compiling a rule
+void
+PatternList::Compile(RuleSet *set) const
+{
+	if (InitCheck() != B_OK)
+		return;
+
+	std::vector<Pattern*>::const_iterator i;
+	for (i = fList.begin(); i != fList.end(); i++) {
+		if (*i)
+			(*i)->Compile(fRange, set, fCaseInsensitive);
+	}
+}
+
 void
 PatternList::Add(Pattern *pattern) {
 	if (pattern)
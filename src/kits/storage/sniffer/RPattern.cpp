@@ -11,6 +11,7 @@
 #include <sniffer/Pattern.h>
 #include <sniffer/Range.h>
 #include <sniffer/RPattern.h>
+#include <sniffer/RuleSet.h>
 #include <DataIO.h>
 
 using namespace BPrivate::Storage::Sniffer;
@@ -71,4 +72,10 @@ RPattern::BytesNeeded() const
 	return result;	
 }
 
-
+//! Adds the pattern with the object's range to the given rule set
+void
+RPattern::Compile(RuleSet *set, bool caseInsensitive) const
+{
+	if (InitCheck() == B_OK)
+		fPattern->Compile(fRange, set, caseInsensitive);
+}
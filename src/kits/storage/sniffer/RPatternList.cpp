@@ -10,6 +10,7 @@
 #include <sniffer/Err.h>
 #include <sniffer/RPattern.h>
 #include <sniffer/RPatternList.h>
+#include <sniffer/RuleSet.h>
 #include <DataIO.h>
 #include <stdio.h>
 
@@ -84,6 +85,17 @@ RPatternList::BytesNeeded() const
 	return result;
 }
 	
+//! Adds the list's patterns to the rule set currently compiling a rule
+void
+RPatternList::Compile(RuleSet *set) const
+{
+	std::vector<RPattern*>::const_iterator i;
+	for (i = fList.begin(); i != fList.end(); i++) {
+		if (*i)
+			(*i)->Compile(set, fCaseInsensitive);
+	}
+}
+
 void
 RPatternList::Add(RPattern *rpattern) {
 	if (rpattern)
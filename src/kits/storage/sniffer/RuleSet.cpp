@@ -0,0 +1,317 @@
+/*
+ * Copyright 2011, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+/*!
+	\file RuleSet.cpp
+	MIME sniffer compiled rule set implementation
+*/
+
+#include <sniffer/DisjList.h>
+#include <sniffer/Range.h>
+#include <sniffer/Rule.h>
+#include <sniffer/RuleSet.h>
+
+#include <new>
+#include <string.h>
+
+using namespace BPrivate::Storage::Sniffer;
+
+/*!	\class RuleSet
+	\brief A list of Rules, compiled into a form that can quickly be matched
+	against a buffer of data.
+
+	Rule::Sniff() walks the parsed rule for every file, reading each
+	candidate offset of each pattern through a BPositionIO. When guessing the
+	type of a file, all rules have to be tried in order of priority until one
+	matches, and most of them don't.
+
+	A RuleSet instead flattens the patterns of all its rules into a few
+	arrays that are compared with the data directly. Additionally, the first
+	byte of the data is used as an index: most rules contain at least one
+	pattern list that is anchored at offset 0 (like "[0] 'GIF8'"), and such a
+	rule can only match, if the first byte of the data matches the first byte
+	of one of the patterns of that list. For each of the 256 possible first
+	bytes, the set keeps the list of the rules that may match, so only those
+	are tried at all.
+
+	Rules are identified by their index, ie. the order in which they were
+	added.
+*/
+
+//! Creates an empty rule set
+RuleSet::RuleSet()
+{
+}
+
+RuleSet::~RuleSet()
+{
+}
+
+//! Removes all rules from the set
+void
+RuleSet::MakeEmpty()
+{
+	fBytes.clear();
+	fPatterns.clear();
+	fConjuncts.clear();
+	fRules.clear();
+	for (int32 i = 0; i < SLOT_COUNT; i++)
+		fCandidates[i].clear();
+}
+
+/*! \brief Compiles the given rule and adds it to the end of the set.
+
+	Rules must be added in order of decreasing priority, for Match() to
+	return the right one. A \c NULL or uninitialized \a rule is added as
+	well, so that the indices stay in sync with the caller's list, but it
+	never matches.
+
+	\return
+	- \c B_OK: success
+	- \c B_NO_MEMORY: insufficient memory; the set is left unchanged
+*/
+status_t
+RuleSet::AddRule(const Rule *rule)
+{
+	size_t byteCount = fBytes.size();
+	size_t patternCount = fPatterns.size();
+	size_t conjunctCount = fConjuncts.size();
+	size_t ruleCount = fRules.size();
+
+	try {
+		rule_entry entry;
+		entry.priority = rule != NULL ? rule->Priority() : 0.0;
+		entry.first_conjunct = fConjuncts.size();
+		entry.conjunct_count = 0;
+
+		bool canMatch = rule != NULL && rule->InitCheck() == B_OK;
+
+		// the first bytes the rule can match
+		uint32 filter[256 / 32];
+		memset(filter, canMatch ? 0xff : 0, sizeof(filter));
+
+		if (canMatch) {
+			std::vector<DisjList*>::const_iterator i;
+			for (i = rule->fConjList->begin(); i != rule->fConjList->end();
+					i++) {
+				// Rule::Sniff() ignores NULL lists
+				if (*i == NULL)
+					continue;
+
+				conjunct_entry conjunct;
+				conjunct.first_pattern = fPatterns.size();
+				(*i)->Compile(this);
+				conjunct.pattern_count = fPatterns.size()
+					- conjunct.first_pattern;
+				fConjuncts.push_back(conjunct);
+				entry.conjunct_count++;
+
+				// If all patterns of the list are anchored at the start of
+				// the data, the rule can only match the first bytes they
+				// accept.
+				bool anchored = true;
+				uint32 accepted[256 / 32];
+				memset(accepted, 0, sizeof(accepted));
+
+				for (uint32 j = 0; j < conjunct.pattern_count; j++) {
+					const pattern_entry &pattern
+						= fPatterns[conjunct.first_pattern + j];
+					if (pattern.start != 0 || pattern.end != 0) {
+						anchored = false;
+						break;
+					}
+
+					const uint8 *bytes = &fBytes[pattern.offset];
+					uint8 alternative = bytes[pattern.length];
+					uint8 mask = bytes[2 * pattern.length];
+					for (int32 byte = 0; byte < 256; byte++) {
+						if ((byte & mask) == bytes[0]
+							|| (byte & mask) == alternative) {
+							accepted[byte / 32] |= 1UL << (byte % 32);
+						}
+					}
+				}
+
+				if (anchored) {
+					for (int32 j = 0; j < 256 / 32; j++)
+						filter[j] &= accepted[j];
+				}
+			}
+		}
+
+		int32 index = fRules.size();
+		fRules.push_back(entry);
+
+		for (int32 byte = 0; byte < 256; byte++) {
+			if ((filter[byte / 32] & (1UL << (byte % 32))) != 0)
+				fCandidates[byte].push_back(index);
+		}
+
+		// Every pattern needs at least one byte, so only a rule without any
+		// pattern list can match empty data.
+		if (canMatch && entry.conjunct_count == 0)
+			fCandidates[EMPTY_DATA_SLOT].push_back(index);
+	} catch (std::bad_alloc&) {
+		fBytes.resize(byteCount);
+		fPatterns.resize(patternCount);
+		fConjuncts.resize(conjunctCount);
+		fRules.resize(ruleCount);
+		for (int32 i = 0; i < SLOT_COUNT; i++) {
+			while (!fCandidates[i].empty()
+				&& fCandidates[i].back() >= (int32)ruleCount) {
+				fCandidates[i].pop_back();
+			}
+		}
+		return B_NO_MEMORY;
+	}
+
+	return B_OK;
+}
+
+//! Returns the number of rules in the set
+int32
+RuleSet::CountRules() const
+{
+	return fRules.size();
+}
+
+/*! \brief Returns the index of the first rule that matches the given data.
+
+	Only rules with a priority greater than \a minPriority are considered.
+
+	\param data The data to sniff.
+	\param length The length of \a data in bytes.
+	\param minPriority The priority a rule must exceed to be considered.
+	\return The index of the matching rule, or -1, if no rule matches.
+*/
+int32
+RuleSet::Match(const void *_data, size_t length, double minPriority) const
+{
+	const uint8 *data = (const uint8 *)_data;
+	if (data == NULL)
+		length = 0;
+
+	const std::vector<int32> &candidates
+		= fCandidates[length > 0 ? data[0] : EMPTY_DATA_SLOT];
+
+	for (std::vector<int32>::const_iterator i = candidates.begin();
+			i != candidates.end(); i++) {
+		const rule_entry &rule = fRules[*i];
+
+		// the rules are sorted by priority
+		if (rule.priority <= minPriority)
+			break;
+
+		if (_MatchRule(rule, data, length))
+			return *i;
+	}
+
+	return -1;
+}
+
+/*! \brief Adds a pattern to the pattern list currently being compiled.
+
+	To be called by DisjList::Compile() only.
+*/
+void
+RuleSet::AddPattern(Range range, const std::string &string,
+	const std::string &mask, bool caseInsensitive)
+{
+	if (range.InitCheck() != B_OK || string.length() == 0
+		|| string.length() != mask.length()) {
+		return;
+	}
+
+	pattern_entry pattern;
+	pattern.start = range.Start();
+	pattern.end = range.End();
+	pattern.offset = fBytes.size();
+	pattern.length = string.length();
+
+	fBytes.resize(fBytes.size() + 3 * pattern.length);
+	uint8 *bytes = &fBytes[pattern.offset];
+	uint8 *alternatives = bytes + pattern.length;
+	uint8 *masks = alternatives + pattern.length;
+
+	for (uint32 i = 0; i < pattern.length; i++) {
+		uint8 byte = string[i];
+		uint8 alternative = byte;
+		if (caseInsensitive) {
+			if ('A' <= byte && byte <= 'Z')
+				alternative = 'a' + (byte - 'A');
+			else if ('a' <= byte && byte <= 'z')
+				alternative = 'A' + (byte - 'a');
+		}
+
+		masks[i] = mask[i];
+		bytes[i] = byte & masks[i];
+		alternatives[i] = alternative & masks[i];
+	}
+
+	fPatterns.push_back(pattern);
+}
+
+//! Returns whether all pattern lists of \a rule match the data
+bool
+RuleSet::_MatchRule(const rule_entry &rule, const uint8 *data,
+	size_t length) const
+{
+	for (uint32 i = 0; i < rule.conjunct_count; i++) {
+		const conjunct_entry &conjunct = fConjuncts[rule.first_conjunct + i];
+
+		bool matches = false;
+		for (uint32 j = 0; j < conjunct.pattern_count; j++) {
+			if (_MatchPattern(fPatterns[conjunct.first_pattern + j], data,
+					length)) {
+				matches = true;
+				break;
+			}
+		}
+
+		if (!matches)
+			return false;
+	}
+
+	return true;
+}
+
+/*! \brief Returns whether the pattern occurs in the data at any offset of
+	its range.
+
+	Like Pattern::Sniff(), only complete occurrences within the data count.
+*/
+bool
+RuleSet::_MatchPattern(const pattern_entry &pattern, const uint8 *data,
+	size_t length) const
+{
+	if (pattern.length > length)
+		return false;
+
+	// the last offset the whole pattern fits in the data
+	int64 end = length - pattern.length;
+	if (pattern.end < end)
+		end = pattern.end;
+
+	const uint8 *bytes = &fBytes[pattern.offset];
+	const uint8 *alternatives = bytes + pattern.length;
+	const uint8 *masks = alternatives + pattern.length;
+
+	// negative offsets can't be read, and thus never match
+	int64 offset = pattern.start > 0 ? pattern.start : 0;
+	for (; offset <= end; offset++) {
+		const uint8 *current = data + offset;
+
+		uint32 i = 0;
+		for (; i < pattern.length; i++) {
+			uint8 byte = current[i] & masks[i];
+			if (byte != bytes[i] && byte != alternatives[i])
+				break;
+		}
+
+		if (i == pattern.length)
+			return true;
+	}
+
+	return false;
+}
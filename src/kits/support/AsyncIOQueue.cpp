@@ -0,0 +1,189 @@
+/*
+ * Copyright 2011, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include <AsyncIOQueue.h>
+
+#include <new>
+
+#include <pthread.h>
+
+#include <OS.h>
+
+
+namespace BPrivate {
+
+
+static const int32 kMaxWorkers = 4;
+static const bigtime_t kWorkerIdleTimeout = 5000000;
+
+
+struct async_io_request {
+	async_io_request*	next;
+	BDataIO*			io;
+	BPositionIO*		positionIO;
+	off_t				position;
+	void*				buffer;
+	size_t				size;
+	io_completion_hook	hook;
+	void*				cookie;
+};
+
+
+static pthread_mutex_t sLock = PTHREAD_MUTEX_INITIALIZER;
+static sem_id sRequestSem = -1;
+static async_io_request* sFirstRequest;
+static async_io_request* sLastRequest;
+static int32 sWorkerCount;
+static int32 sIdleWorkerCount;
+
+
+static void
+run_request(async_io_request* request)
+{
+	ssize_t result;
+	if (request->positionIO != NULL) {
+		result = request->positionIO->ReadAt(request->position,
+			request->buffer, request->size);
+	} else
+		result = request->io->Read(request->buffer, request->size);
+
+	request->hook(request->cookie, result);
+}
+
+
+static status_t
+worker_thread(void*)
+{
+	pthread_mutex_lock(&sLock);
+
+	while (true) {
+		sIdleWorkerCount++;
+		pthread_mutex_unlock(&sLock);
+
+		status_t status = acquire_sem_etc(sRequestSem, 1, B_RELATIVE_TIMEOUT,
+			kWorkerIdleTimeout);
+
+		pthread_mutex_lock(&sLock);
+		sIdleWorkerCount--;
+
+		if (status != B_OK) {
+			// Only quit if no request came in while we gave up waiting;
+			// its semaphore count is still there for us to pick up then.
+			if (sFirstRequest != NULL
+				&& (status == B_TIMED_OUT || status == B_INTERRUPTED))
+				continue;
+			break;
+		}
+
+		async_io_request* request = sFirstRequest;
+		sFirstRequest = request->next;
+		if (sFirstRequest == NULL)
+			sLastRequest = NULL;
+
+		pthread_mutex_unlock(&sLock);
+
+		run_request(request);
+		delete request;
+
+		pthread_mutex_lock(&sLock);
+	}
+
+	sWorkerCount--;
+	pthread_mutex_unlock(&sLock);
+	return B_OK;
+}
+
+
+static status_t
+queue_request(async_io_request* request)
+{
+	pthread_mutex_lock(&sLock);
+
+	if (sRequestSem < 0) {
+		sRequestSem = create_sem(0, "async i/o requests");
+		if (sRequestSem < 0) {
+			status_t status = sRequestSem;
+			pthread_mutex_unlock(&sLock);
+			delete request;
+			return status;
+		}
+	}
+
+	if (sIdleWorkerCount == 0 && sWorkerCount < kMaxWorkers) {
+		thread_id thread = spawn_thread(&worker_thread, "async i/o worker",
+			B_NORMAL_PRIORITY, NULL);
+		if (thread >= 0) {
+			sWorkerCount++;
+			resume_thread(thread);
+		} else if (sWorkerCount == 0) {
+			// nobody would ever pick this request up
+			pthread_mutex_unlock(&sLock);
+			delete request;
+			return thread;
+		}
+	}
+
+	request->next = NULL;
+	if (sLastRequest != NULL)
+		sLastRequest->next = request;
+	else
+		sFirstRequest = request;
+	sLastRequest = request;
+
+	pthread_mutex_unlock(&sLock);
+
+	release_sem(sRequestSem);
+	return B_OK;
+}
+
+
+/*static*/ status_t
+AsyncIOQueue::QueueRead(BDataIO* io, void* buffer, size_t size,
+	io_completion_hook hook, void* cookie)
+{
+	if (io == NULL || hook == NULL)
+		return B_BAD_VALUE;
+
+	async_io_request* request = new(std::nothrow) async_io_request;
+	if (request == NULL)
+		return B_NO_MEMORY;
+
+	request->io = io;
+	request->positionIO = NULL;
+	request->position = -1;
+	request->buffer = buffer;
+	request->size = size;
+	request->hook = hook;
+	request->cookie = cookie;
+
+	return queue_request(request);
+}
+
+
+/*static*/ status_t
+AsyncIOQueue::QueueReadAt(BPositionIO* io, off_t position, void* buffer,
+	size_t size, io_completion_hook hook, void* cookie)
+{
+	if (io == NULL || hook == NULL)
+		return B_BAD_VALUE;
+
+	async_io_request* request = new(std::nothrow) async_io_request;
+	if (request == NULL)
+		return B_NO_MEMORY;
+
+	request->io = io;
+	request->positionIO = io;
+	request->position = position;
+	request->buffer = buffer;
+	request->size = size;
+	request->hook = hook;
+	request->cookie = cookie;
+
+	return queue_request(request);
+}
+
+
+}	// namespace BPrivate
@@ -11,6 +11,8 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <AsyncIOQueue.h>
+
 
 //#define TRACE_DATA_IO
 #ifdef TRACE_DATA_IO
@@ -214,6 +216,25 @@ BBufferedDataIO::Write(const void* buffer, size_t size)
 }
 
 
+status_t
+BBufferedDataIO::ReadAsync(void* buffer, size_t size, io_completion_hook hook,
+	void* cookie)
+{
+	if (buffer == NULL || hook == NULL)
+		return B_BAD_VALUE;
+
+	if (!fDirty && (size <= fSize || (fPartialReads && fSize > 0))) {
+		// everything we need is in the buffer already
+		hook(cookie, Read(buffer, size));
+		return B_OK;
+	}
+
+	// Let a worker thread wait for the stream; we must not be used until
+	// the hook has been called.
+	return AsyncIOQueue::QueueRead(this, buffer, size, hook, cookie);
+}
+
+
 //	#pragma mark - FBC
 
 
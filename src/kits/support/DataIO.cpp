@@ -12,6 +12,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <sys/uio.h>
 
 
 BDataIO::BDataIO()
@@ -24,6 +25,26 @@ BDataIO::~BDataIO()
 }
 
 
+/*!	Reads \a size bytes into \a buffer, and calls \a hook with the result
+	once the data is there.
+	The default implementation just calls Read(), and the hook before it
+	returns. Subclasses that can do better may return early, and call the
+	hook from another thread later on; the object and the buffer must not be
+	touched until that happened.
+	The hook is only called if B_OK is returned.
+*/
+status_t
+BDataIO::ReadAsync(void* buffer, size_t size, io_completion_hook hook,
+	void* cookie)
+{
+	if (hook == NULL)
+		return B_BAD_VALUE;
+
+	hook(cookie, Read(buffer, size));
+	return B_OK;
+}
+
+
 // Private or Reserved
 
 BDataIO::BDataIO(const BDataIO &)
@@ -41,7 +62,6 @@ BDataIO::operator=(const BDataIO &)
 
 
 // FBC
-void BDataIO::_ReservedDataIO1(){}
 void BDataIO::_ReservedDataIO2(){}
 void BDataIO::_ReservedDataIO3(){}
 void BDataIO::_ReservedDataIO4(){}
@@ -122,11 +142,77 @@ BPositionIO::GetSize(off_t* size) const
 }
 
 
+/*!	Reads into the \a count buffers described by \a vecs, starting at
+	\a position. The default implementation calls ReadAt() for each buffer,
+	and stops at the first one that could not be filled completely.
+	Returns the number of bytes read, or an error if nothing could be read.
+*/
+ssize_t
+BPositionIO::ReadAtV(off_t position, const iovec* vecs, size_t count)
+{
+	if (vecs == NULL || position < 0)
+		return B_BAD_VALUE;
+
+	size_t bytesRead = 0;
+	for (size_t i = 0; i < count; i++) {
+		ssize_t result = ReadAt(position + bytesRead, vecs[i].iov_base,
+			vecs[i].iov_len);
+		if (result < 0)
+			return bytesRead > 0 ? (ssize_t)bytesRead : result;
+
+		bytesRead += result;
+		if ((size_t)result < vecs[i].iov_len)
+			break;
+	}
+
+	return bytesRead;
+}
+
+
+/*!	Writes the \a count buffers described by \a vecs, starting at
+	\a position. The default implementation calls WriteAt() for each buffer.
+	\see ReadAtV()
+*/
+ssize_t
+BPositionIO::WriteAtV(off_t position, const iovec* vecs, size_t count)
+{
+	if (vecs == NULL || position < 0)
+		return B_BAD_VALUE;
+
+	size_t bytesWritten = 0;
+	for (size_t i = 0; i < count; i++) {
+		ssize_t result = WriteAt(position + bytesWritten, vecs[i].iov_base,
+			vecs[i].iov_len);
+		if (result < 0)
+			return bytesWritten > 0 ? (ssize_t)bytesWritten : result;
+
+		bytesWritten += result;
+		if ((size_t)result < vecs[i].iov_len)
+			break;
+	}
+
+	return bytesWritten;
+}
+
+
+/*!	Like BDataIO::ReadAsync(), but reads from \a position, and leaves the
+	current position alone. The default implementation calls ReadAt(), and
+	the hook before it returns.
+*/
+status_t
+BPositionIO::ReadAtAsync(off_t position, void* buffer, size_t size,
+	io_completion_hook hook, void* cookie)
+{
+	if (hook == NULL)
+		return B_BAD_VALUE;
+
+	hook(cookie, ReadAt(position, buffer, size));
+	return B_OK;
+}
+
+
 // FBC
 extern "C" void _ReservedPositionIO1__11BPositionIO() {}
-void BPositionIO::_ReservedPositionIO2(){}
-void BPositionIO::_ReservedPositionIO3(){}
-void BPositionIO::_ReservedPositionIO4(){}
 void BPositionIO::_ReservedPositionIO5(){}
 void BPositionIO::_ReservedPositionIO6(){}
 void BPositionIO::_ReservedPositionIO7(){}
@@ -204,6 +290,47 @@ BMemoryIO::WriteAt(off_t pos, const void *buffer, size_t size)
 }
 
 
+ssize_t
+BMemoryIO::ReadAtV(off_t pos, const iovec* vecs, size_t count)
+{
+	if (vecs == NULL || pos < 0)
+		return B_BAD_VALUE;
+
+	size_t sizeRead = 0;
+	for (size_t i = 0; i < count && pos < (off_t)fLength; i++) {
+		size_t size = min_c((off_t)vecs[i].iov_len, (off_t)fLength - pos);
+		memcpy(vecs[i].iov_base, fBuffer + pos, size);
+		pos += size;
+		sizeRead += size;
+	}
+	return sizeRead;
+}
+
+
+ssize_t
+BMemoryIO::WriteAtV(off_t pos, const iovec* vecs, size_t count)
+{
+	if (fReadOnly)
+		return B_NOT_ALLOWED;
+
+	if (vecs == NULL || pos < 0)
+		return B_BAD_VALUE;
+
+	size_t sizeWritten = 0;
+	for (size_t i = 0; i < count && pos < (off_t)fBufferSize; i++) {
+		size_t size = min_c((off_t)vecs[i].iov_len, (off_t)fBufferSize - pos);
+		memcpy(fBuffer + pos, vecs[i].iov_base, size);
+		pos += size;
+		sizeWritten += size;
+	}
+
+	if (pos > (off_t)fLength)
+		fLength = pos;
+
+	return sizeWritten;
+}
+
+
 off_t
 BMemoryIO::Seek(off_t position, uint32 seek_mode)
 {
@@ -425,3 +552,83 @@ BMallocIO::operator=(const BMallocIO &)
 void BMallocIO::_ReservedMallocIO1() {}
 void BMallocIO::_ReservedMallocIO2() {}
 
+
+// #pragma mark - binary compatibility
+
+
+// The following methods used to be reserved virtuals; applications built
+// against the old headers still refer to them, and get the default
+// implementations this way.
+
+
+#if __GNUC__ == 2
+
+
+extern "C" status_t
+_ReservedDataIO1__7BDataIO(BDataIO* io, void* buffer, size_t size,
+	io_completion_hook hook, void* cookie)
+{
+	return io->BDataIO::ReadAsync(buffer, size, hook, cookie);
+}
+
+
+extern "C" ssize_t
+_ReservedPositionIO2__11BPositionIO(BPositionIO* io, off_t position,
+	const iovec* vecs, size_t count)
+{
+	return io->BPositionIO::ReadAtV(position, vecs, count);
+}
+
+
+extern "C" ssize_t
+_ReservedPositionIO3__11BPositionIO(BPositionIO* io, off_t position,
+	const iovec* vecs, size_t count)
+{
+	return io->BPositionIO::WriteAtV(position, vecs, count);
+}
+
+
+extern "C" status_t
+_ReservedPositionIO4__11BPositionIO(BPositionIO* io, off_t position,
+	void* buffer, size_t size, io_completion_hook hook, void* cookie)
+{
+	return io->BPositionIO::ReadAtAsync(position, buffer, size, hook, cookie);
+}
+
+
+#elif __GNUC__ > 2
+
+
+extern "C" status_t
+_ZN7BDataIO16_ReservedDataIO1Ev(BDataIO* io, void* buffer, size_t size,
+	io_completion_hook hook, void* cookie)
+{
+	return io->BDataIO::ReadAsync(buffer, size, hook, cookie);
+}
+
+
+extern "C" ssize_t
+_ZN11BPositionIO20_ReservedPositionIO2Ev(BPositionIO* io, off_t position,
+	const iovec* vecs, size_t count)
+{
+	return io->BPositionIO::ReadAtV(position, vecs, count);
+}
+
+
+extern "C" ssize_t
+_ZN11BPositionIO20_ReservedPositionIO3Ev(BPositionIO* io, off_t position,
+	const iovec* vecs, size_t count)
+{
+	return io->BPositionIO::WriteAtV(position, vecs, count);
+}
+
+
+extern "C" status_t
+_ZN11BPositionIO20_ReservedPositionIO4Ev(BPositionIO* io, off_t position,
+	void* buffer, size_t size, io_completion_hook hook, void* cookie)
+{
+	return io->BPositionIO::ReadAtAsync(position, buffer, size, hook, cookie);
+}
+
+
+#endif	// __GNUC__ > 2
@@ -0,0 +1,438 @@
+/*
+ * Copyright 2011, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include <SmallString.h>
+
+#include <ctype.h>
+#include <stdlib.h>
+
+
+namespace BPrivate {
+
+
+static inline int32
+min_length(int32 a, int32 b)
+{
+	return a < b ? a : b;
+}
+
+
+// #pragma mark - StringView
+
+
+StringView
+StringView::Substring(int32 fromOffset, int32 length) const
+{
+	if (fromOffset < 0)
+		fromOffset = 0;
+	else if (fromOffset > fLength)
+		fromOffset = fLength;
+
+	if (length < 0 || length > fLength - fromOffset)
+		length = fLength - fromOffset;
+
+	return StringView(fData + fromOffset, length);
+}
+
+
+StringView&
+StringView::Trim()
+{
+	while (fLength > 0 && isspace(fData[0])) {
+		fData++;
+		fLength--;
+	}
+
+	while (fLength > 0 && isspace(fData[fLength - 1]))
+		fLength--;
+
+	return *this;
+}
+
+
+int32
+StringView::FindFirst(char c, int32 fromOffset) const
+{
+	if (fromOffset < 0)
+		return B_ERROR;
+	if (fromOffset >= fLength)
+		return B_ERROR;
+
+	const char* found = (const char*)memchr(fData + fromOffset, c,
+		fLength - fromOffset);
+	return found != NULL ? found - fData : B_ERROR;
+}
+
+
+int32
+StringView::FindFirst(const StringView& string, int32 fromOffset) const
+{
+	if (fromOffset < 0 || fromOffset > fLength)
+		return B_ERROR;
+
+	int32 last = fLength - string.fLength;
+	for (int32 i = fromOffset; i <= last; i++) {
+		if (memcmp(fData + i, string.fData, string.fLength) == 0)
+			return i;
+	}
+
+	return B_ERROR;
+}
+
+
+int
+StringView::Compare(const StringView& string) const
+{
+	int result = memcmp(fData, string.fData,
+		min_length(fLength, string.fLength));
+	if (result != 0)
+		return result;
+
+	return fLength - string.fLength;
+}
+
+
+int
+StringView::ICompare(const StringView& string) const
+{
+	int32 length = min_length(fLength, string.fLength);
+	for (int32 i = 0; i < length; i++) {
+		int difference = tolower((uint8)fData[i])
+			- tolower((uint8)string.fData[i]);
+		if (difference != 0)
+			return difference;
+	}
+
+	return fLength - string.fLength;
+}
+
+
+// #pragma mark - SmallString
+
+
+SmallString::SmallString()
+	:
+	fData(fInlineData),
+	fLength(0),
+	fCapacity(kInlineCapacity)
+{
+	fInlineData[0] = '\0';
+}
+
+
+SmallString::SmallString(const char* string)
+	:
+	fData(fInlineData),
+	fLength(0),
+	fCapacity(kInlineCapacity)
+{
+	fInlineData[0] = '\0';
+	SetTo(string);
+}
+
+
+SmallString::SmallString(const char* string, int32 maxLength)
+	:
+	fData(fInlineData),
+	fLength(0),
+	fCapacity(kInlineCapacity)
+{
+	fInlineData[0] = '\0';
+	SetTo(string, maxLength);
+}
+
+
+SmallString::SmallString(const SmallString& string)
+	:
+	fData(fInlineData),
+	fLength(0),
+	fCapacity(kInlineCapacity)
+{
+	fInlineData[0] = '\0';
+	SetTo(string.View());
+}
+
+
+SmallString::SmallString(const BString& string)
+	:
+	fData(fInlineData),
+	fLength(0),
+	fCapacity(kInlineCapacity)
+{
+	fInlineData[0] = '\0';
+	SetTo(StringView(string));
+}
+
+
+SmallString::SmallString(const StringView& string)
+	:
+	fData(fInlineData),
+	fLength(0),
+	fCapacity(kInlineCapacity)
+{
+	fInlineData[0] = '\0';
+	SetTo(string);
+}
+
+
+SmallString::~SmallString()
+{
+	_Free();
+}
+
+
+SmallString&
+SmallString::operator=(const SmallString& string)
+{
+	if (&string != this)
+		SetTo(string.View());
+	return *this;
+}
+
+
+SmallString&
+SmallString::operator=(const char* string)
+{
+	return SetTo(string);
+}
+
+
+SmallString&
+SmallString::operator=(const BString& string)
+{
+	return SetTo(StringView(string));
+}
+
+
+SmallString&
+SmallString::operator=(const StringView& string)
+{
+	return SetTo(string);
+}
+
+
+SmallString&
+SmallString::SetTo(const char* string)
+{
+	return SetTo(StringView(string));
+}
+
+
+SmallString&
+SmallString::SetTo(const char* string, int32 maxLength)
+{
+	if (string == NULL)
+		return SetTo(StringView());
+
+	if (maxLength < 0)
+		return SetTo(StringView(string));
+
+	const char* end = (const char*)memchr(string, '\0', maxLength);
+	return SetTo(StringView(string, end != NULL ? end - string : maxLength));
+}
+
+
+/*!	\a string may be a view of this string. Since it can't be longer than
+	the string, that never needs a larger buffer.
+*/
+SmallString&
+SmallString::SetTo(const StringView& string)
+{
+	if (!_Reserve(string.Length()))
+		return *this;
+
+	memmove(fData, string.Data(), string.Length());
+	fLength = string.Length();
+	fData[fLength] = '\0';
+	return *this;
+}
+
+
+/*!	Takes over the allocated buffer of \a from, if it has one, and leaves
+	\a from empty.
+*/
+SmallString&
+SmallString::Adopt(SmallString& from)
+{
+	if (&from == this)
+		return *this;
+
+	if (from.IsInline()) {
+		SetTo(from.View());
+	} else {
+		_Free();
+		fData = from.fData;
+		fLength = from.fLength;
+		fCapacity = from.fCapacity;
+
+		from.fData = from.fInlineData;
+		from.fCapacity = kInlineCapacity;
+	}
+
+	from.fLength = 0;
+	from.fData[0] = '\0';
+	return *this;
+}
+
+
+SmallString&
+SmallString::CopyInto(SmallString& into, int32 fromOffset, int32 length) const
+{
+	if (fromOffset < 0 || length < 0)
+		return into;
+
+	return into.SetTo(Substring(fromOffset, length));
+}
+
+
+SmallString&
+SmallString::Append(const char* string, int32 length)
+{
+	if (string == NULL || length <= 0)
+		return *this;
+
+	const char* end = (const char*)memchr(string, '\0', length);
+	return Append(StringView(string, end != NULL ? end - string : length));
+}
+
+
+SmallString&
+SmallString::Append(const StringView& string)
+{
+	if (string.IsEmpty())
+		return *this;
+
+	// the string may be a view of this one, which growing the buffer would
+	// move
+	const char* source = string.Data();
+	int32 sourceOffset = -1;
+	if (source >= fData && source < fData + fLength)
+		sourceOffset = source - fData;
+
+	if (string.Length() > INT32_MAX - 1 - fLength
+		|| !_Reserve(fLength + string.Length())) {
+		return *this;
+	}
+
+	if (sourceOffset >= 0)
+		source = fData + sourceOffset;
+
+	memmove(fData + fLength, source, string.Length());
+	fLength += string.Length();
+	fData[fLength] = '\0';
+	return *this;
+}
+
+
+SmallString&
+SmallString::Append(char c, int32 count)
+{
+	if (count <= 0 || count > INT32_MAX - 1 - fLength
+		|| !_Reserve(fLength + count)) {
+		return *this;
+	}
+
+	memset(fData + fLength, c, count);
+	fLength += count;
+	fData[fLength] = '\0';
+	return *this;
+}
+
+
+SmallString&
+SmallString::operator<<(const char* string)
+{
+	return Append(StringView(string));
+}
+
+
+//!	Keeps the buffer, so that the string can grow again without allocating.
+SmallString&
+SmallString::Truncate(int32 newLength)
+{
+	if (newLength < 0)
+		newLength = 0;
+
+	if (newLength < fLength) {
+		fLength = newLength;
+		fData[fLength] = '\0';
+	}
+
+	return *this;
+}
+
+
+SmallString&
+SmallString::Trim()
+{
+	return SetTo(View().Trim());
+}
+
+
+char*
+SmallString::LockBuffer(int32 maxLength)
+{
+	if (maxLength > fLength && !_Reserve(maxLength))
+		return NULL;
+
+	return fData;
+}
+
+
+SmallString&
+SmallString::UnlockBuffer(int32 length)
+{
+	if (length < 0)
+		length = strnlen(fData, fCapacity);
+	else if (length > fCapacity)
+		length = fCapacity;
+
+	fLength = length;
+	fData[fLength] = '\0';
+	return *this;
+}
+
+
+/*!	Makes sure the buffer can hold \a length bytes plus the terminating null.
+	Returns \c false, if the buffer couldn't be allocated.
+*/
+bool
+SmallString::_Reserve(int32 length)
+{
+	if (length <= fCapacity)
+		return true;
+
+	int32 capacity = fCapacity < INT32_MAX / 2 ? fCapacity * 2 : length;
+	if (capacity < length)
+		capacity = length;
+
+	char* data;
+	if (IsInline()) {
+		data = (char*)malloc(capacity + 1);
+		if (data == NULL)
+			return false;
+		memcpy(data, fInlineData, fLength + 1);
+	} else {
+		data = (char*)realloc(fData, capacity + 1);
+		if (data == NULL)
+			return false;
+	}
+
+	fData = data;
+	fCapacity = capacity;
+	return true;
+}
+
+
+void
+SmallString::_Free()
+{
+	if (!IsInline())
+		free(fData);
+}
+
+
+}	// namespace BPrivate
@@ -40,6 +40,25 @@ static const uint32 kPrivateDataOffset = BString::Private::kPrivateDataOffset;
 const char* B_EMPTY_STRING = "";
 
 
+// The private data shared by all empty strings that have not been written to.
+// Its reference count is too large to ever drop to 1, so it is never written
+// to nor freed: _MakeWritable() will always clone it first.
+static struct {
+	vint32	referenceCount;
+	int32	length;
+	char	data[1];
+} sEmptyStringData = { 0x40000000, 0, { '\0' } };
+
+
+//! Returns a new reference to the shared empty string data.
+static inline char*
+acquire_empty_data()
+{
+	atomic_add(&sEmptyStringData.referenceCount, 1);
+	return sEmptyStringData.data;
+}
+
+
 // helper function, returns minimum of two given values (but clamps to 0):
 static inline int32
 min_clamp0(int32 num1, int32 num2)
@@ -317,6 +336,8 @@ BString::SetTo(const char* string, int32 maxLength)
 		maxLength = INT32_MAX;
 
 	maxLength = strlen_clamp(safestr(string), maxLength);
+	if (maxLength == 0)
+		return Truncate(0, false);
 
 	if (_MakeWritable(maxLength, false) == B_OK)
 		memcpy(fPrivateData, string, maxLength);
@@ -358,7 +379,7 @@ BString&
 BString::Adopt(BString& from)
 {
 	SetTo(from);
-	from.SetTo("");
+	from.Truncate(0);
 
 	return *this;
 }
@@ -369,6 +390,10 @@ BString::SetTo(const BString& string, int32 maxLength)
 {
 	if (maxLength < 0)
 		maxLength = INT32_MAX;
+	if (maxLength >= string.Length()) {
+		// the whole string, which we can share
+		return SetTo(string);
+	}
 	if (fPrivateData != string.fPrivateData
 		// make sure we reassing in case length is different
 		|| (fPrivateData == string.fPrivateData && Length() > maxLength)) {
@@ -384,7 +409,7 @@ BString&
 BString::Adopt(BString& from, int32 maxLength)
 {
 	SetTo(from, maxLength);
-	from.SetTo("");
+	from.Truncate(0);
 
 	return *this;
 }
@@ -461,8 +486,12 @@ BString::SetToFormat(const char* format, ...)
 BString&
 BString::CopyInto(BString& into, int32 fromOffset, int32 length) const
 {
-	if (this != &into)
-		into.SetTo(fPrivateData + fromOffset, length);
+	if (this != &into) {
+		if (fromOffset == 0)
+			into.SetTo(*this, length);
+		else
+			into.SetTo(fPrivateData + fromOffset, length);
+	}
 	return into;
 }
 
@@ -798,10 +827,22 @@ BString::Truncate(int32 newLength, bool lazy)
 	if (newLength < 0)
 		newLength = 0;
 
-	if (newLength < Length()) {
-		// ignore lazy, since we might detach
+	if (newLength >= Length())
+		return *this;
+
+	if (newLength == 0 && atomic_get(&_ReferenceCount()) > 1) {
+		// no need to copy anything, just share the empty string
+		if (atomic_add(&_ReferenceCount(), -1) == 1) {
+			// someone else left, we were the last owner
+			_FreePrivateData();
+		}
+		fPrivateData = acquire_empty_data();
+	} else if (lazy && _ReferenceCount() == 1) {
+		// we own the buffer, so we can just keep it
+		fPrivateData[newLength] = '\0';
+		_SetLength(newLength);
+	} else
 		_MakeWritable(newLength, true);
-	}
 
 	return *this;
 }
@@ -810,7 +851,7 @@ BString::Truncate(int32 newLength, bool lazy)
 BString&
 BString::TruncateChars(int32 newCharCount, bool lazy)
 {
-	return Truncate(UTF8CountBytes(fPrivateData, newCharCount));
+	return Truncate(UTF8CountBytes(fPrivateData, newCharCount), lazy);
 }
 
 
@@ -1820,7 +1861,7 @@ BString::UnlockBuffer(int32 length)
 	else
 		length = fPrivateData == NULL ? 0 : strlen(fPrivateData);
 
-	if (_Resize(length) != NULL) {
+	if (_MakeWritable() == B_OK && _Resize(length) != NULL) {
 		fPrivateData[length] = '\0';
 		_ReferenceCount() = 1;
 			// mark shareable again
@@ -1969,7 +2010,7 @@ BString::Trim()
 	ssize_t length = endIndex + 1 - startCount;
 	ASSERT(length >= 0);
 	if (startCount == 0 || length == 0) {
-		_MakeWritable(length, true);
+		Truncate(length);
 	} else if (_MakeWritable() == B_OK) {
 		memmove(fPrivateData, fPrivateData + startCount, length);
 		fPrivateData[length] = '\0';
@@ -2243,9 +2284,9 @@ BString::_Resize(int32 length)
 void
 BString::_Init(const char* src, int32 length)
 {
-	fPrivateData = _Clone(src, length);
+	fPrivateData = length > 0 ? _Clone(src, length) : NULL;
 	if (fPrivateData == NULL)
-		fPrivateData = _Clone(NULL, 0);
+		fPrivateData = acquire_empty_data();
 }
 
 
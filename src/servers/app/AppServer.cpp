@@ -14,6 +14,7 @@
 
 #include "BitmapManager.h"
 #include "Desktop.h"
+#include "FontCache.h"
 #include "FontManager.h"
 #include "InputManager.h"
 #include "ScreenManager.h"
@@ -90,6 +91,8 @@ AppServer::~AppServer()
 	gScreenManager->Lock();
 	gScreenManager->Quit();
 
+	FontCache::Default()->SavePersistentGlyphs();
+
 	gFontManager->Lock();
 	gFontManager->Quit();
 
@@ -428,6 +428,8 @@ Desktop::Desktop(uid_t userID, const char* targetScreen)
 	fWorkspacesLock("workspaces list"),
 	fWindowLock("window lock"),
 
+	fClippingGeneration(1),
+
 	fMouseEventWindow(NULL),
 	fWindowUnderMouse(NULL),
 	fLockedFocusWindow(NULL),
@@ -3017,6 +3019,15 @@ Desktop::_ChangeWindowWorkspaces(Window* window, uint32 oldWorkspaces,
 	// take care about modals and floating windows
 	_UpdateSubsetWorkspaces(window);
 
+	// the miniatures of the workspaces the window left need to be updated
+	// as well, not only those it is on now
+	fWorkspacesLock.Lock();
+	for (uint32 i = fWorkspacesViews.CountItems(); i-- > 0;) {
+		WorkspacesView* view = fWorkspacesViews.ItemAt(i);
+		view->InvalidateWorkspaces(oldWorkspaces | newWorkspaces);
+	}
+	fWorkspacesLock.Unlock();
+
 	NotifyWindowWorkspacesChanged(window, newWorkspaces);
 
 	UnlockAllWindows();
@@ -3144,6 +3155,7 @@ Desktop::_RebuildClippingForAllWindows(BRegion& stillAvailableOnScreen)
 
 	// figure out what the entire screen area is
 	stillAvailableOnScreen = fScreenRegion;
+	fClippingGeneration++;
 
 	// set clipping of each window
 	for (Window* window = CurrentWindows().LastWindow(); window != NULL;
@@ -3217,6 +3229,7 @@ Desktop::RebuildAndRedrawAfterWindowChange(Window* changedWindow,
 
 	// figure out what the entire screen area is
 	BRegion stillAvailableOnScreen(fScreenRegion);
+	fClippingGeneration++;
 
 	// set clipping of each window
 	for (Window* window = CurrentWindows().LastWindow(); window != NULL;
@@ -3291,6 +3304,10 @@ Desktop::_ScreenChanged(Screen* screen)
 	fScreenRegion.Set(screen->Frame());
 	gInputManager->UpdateScreenBounds(screen->Frame());
 
+	// the frame buffer no longer shows what the windows last saw of it,
+	// so they must not save it into their backing stores
+	fClippingGeneration++;
+
 	BRegion background;
 	_RebuildClippingForAllWindows(background);
 
@@ -54,6 +54,7 @@ DesktopSettingsPrivate::_SetDefaults()
 	fFocusFollowsMouseMode = B_NORMAL_FOCUS_FOLLOWS_MOUSE;
 	fAcceptFirstClick = false;
 	fShowAllDraggers = true;
+	fWindowBackingStores = false;
 
 	// init scrollbar info
 	fScrollBarInfo.proportional = true;
@@ -290,6 +291,12 @@ DesktopSettingsPrivate::_Load()
 				gSubpixelOrderingRGB = subpixelOrdering;
 			}
 
+			bool backingStores;
+			if (settings.FindBool("window backing stores", &backingStores)
+					== B_OK) {
+				fWindowBackingStores = backingStores;
+			}
+
 			// colors
 			for (int32 i = 0; i < kNumColors; i++) {
 				char colorName[12];
@@ -435,6 +442,7 @@ DesktopSettingsPrivate::Save(uint32 mask)
 			settings.AddBool("subpixel antialiasing", gSubpixelAntialiasing);
 			settings.AddInt8("subpixel average weight", gSubpixelAverageWeight);
 			settings.AddBool("subpixel ordering", gSubpixelOrderingRGB);
+			settings.AddBool("window backing stores", fWindowBackingStores);
 
 			for (int32 i = 0; i < kNumColors; i++) {
 				char colorName[12];
@@ -600,6 +608,21 @@ DesktopSettingsPrivate::ShowAllDraggers() const
 }
 
 
+void
+DesktopSettingsPrivate::SetWindowBackingStores(bool enabled)
+{
+	fWindowBackingStores = enabled;
+	Save(kAppearanceSettings);
+}
+
+
+bool
+DesktopSettingsPrivate::WindowBackingStores() const
+{
+	return fWindowBackingStores;
+}
+
+
 void
 DesktopSettingsPrivate::SetWorkspacesLayout(int32 columns, int32 rows)
 {
@@ -683,6 +706,8 @@ void
 DesktopSettingsPrivate::SetSubpixelAntialiasing(bool subpix)
 {
 	gSubpixelAntialiasing = subpix;
+	// clients cache string widths
+	atomic_add(&fShared.font_metrics_revision, 1);
 	Save(kAppearanceSettings);
 }
 
@@ -698,6 +723,8 @@ void
 DesktopSettingsPrivate::SetHinting(uint8 hinting)
 {
 	gDefaultHintingMode = hinting;
+	// clients cache string widths
+	atomic_add(&fShared.font_metrics_revision, 1);
 	Save(kFontSettings);
 }
 
@@ -837,6 +864,13 @@ DesktopSettings::ShowAllDraggers() const
 }
 
 
+bool
+DesktopSettings::WindowBackingStores() const
+{
+	return fSettings->WindowBackingStores();
+}
+
+
 int32
 DesktopSettings::WorkspacesCount() const
 {
@@ -987,6 +1021,13 @@ LockedDesktopSettings::SetShowAllDraggers(bool show)
 }
 
 
+void
+LockedDesktopSettings::SetWindowBackingStores(bool enabled)
+{
+	fSettings->SetWindowBackingStores(enabled);
+}
+
+
 void
 LockedDesktopSettings::SetUIColor(color_which which, const rgb_color color)
 {
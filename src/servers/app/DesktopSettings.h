@@ -50,6 +50,8 @@ class DesktopSettings {
 
 		bool			ShowAllDraggers() const;
 
+		bool			WindowBackingStores() const;
+
 		int32			WorkspacesCount() const;
 		int32			WorkspacesColumns() const;
 		int32			WorkspacesRows() const;
@@ -85,6 +87,8 @@ class LockedDesktopSettings : public DesktopSettings {
 
 		void			SetShowAllDraggers(bool show);
 
+		void			SetWindowBackingStores(bool enabled);
+
 		void			SetUIColor(color_which which, const rgb_color color);
 
 		void			SetSubpixelAntialiasing(bool subpix);
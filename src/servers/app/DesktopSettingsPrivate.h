@@ -55,6 +55,9 @@ public:
 			void				SetShowAllDraggers(bool show);
 			bool				ShowAllDraggers() const;
 
+			void				SetWindowBackingStores(bool enabled);
+			bool				WindowBackingStores() const;
+
 			void				SetWorkspacesLayout(int32 columns, int32 rows);
 			int32				WorkspacesCount() const;
 			int32				WorkspacesColumns() const;
@@ -95,6 +98,7 @@ private:
 			mode_focus_follows_mouse	fFocusFollowsMouseMode;
 			bool				fAcceptFirstClick;
 			bool				fShowAllDraggers;
+			bool				fWindowBackingStores;
 			int32				fWorkspacesColumns;
 			int32				fWorkspacesRows;
 			BMessage			fWorkspaceMessages[kMaxWorkspaces];
@@ -11,6 +11,19 @@
 
 #include <ServerProtocol.h>
 
+#include "FontCacheEntry.h"
+
+
+static void
+append_hit_rate(BString& string, const char* name, int32 hits, int32 misses)
+{
+	int32 total = hits + misses;
+	string << name << ": " << hits << " hits, " << misses << " misses";
+	if (total > 0)
+		string << " (" << (int32)((int64)hits * 100 / total) << "% hit rate)";
+	string << "\n";
+}
+
 
 void
 string_for_message_code(uint32 code, BString& string)
@@ -312,3 +325,13 @@ string_for_message_code(uint32 code, BString& string)
 }
 
 
+void
+string_for_font_cache_statistics(BString& string)
+{
+	string = "";
+
+	append_hit_rate(string, "glyph atlas", gFontCacheStatistics.atlas_hits,
+		gFontCacheStatistics.atlas_misses);
+	append_hit_rate(string, "glyph run cache", gFontCacheStatistics.run_hits,
+		gFontCacheStatistics.run_misses);
+}
@@ -13,6 +13,7 @@
 
 
 void string_for_message_code(uint32 code, BString& string);
+void string_for_font_cache_statistics(BString& string);
 
 
 #endif // PROFILE_MESSAGE_SUPPORT_H
@@ -164,6 +164,9 @@ ServerWindow::ServerWindow(const char* title, ServerApp* app,
 	fClientReplyPort(clientPort),
 	fClientLooperPort(looperPort),
 
+	fRedrawRequested(0),
+	fWorkspacesViewsUpdateRequested(0),
+
 	fClientToken(clientToken),
 
 	fCurrentView(NULL),
@@ -244,6 +247,10 @@ ServerWindow::~ServerWindow()
 			sRedrawProcessingTime.count,
 			sRedrawProcessingTime.time / sRedrawProcessingTime.count);
 	}
+
+	string_for_font_cache_statistics(codeName);
+	printf("%s", codeName.String());
+
 //	if (sNextMessageTime.count > 0) {
 //		printf("average NextMessage() time: %g secs, count: %ld (%lld usecs per call)\n",
 //			sNextMessageTime.time / 1000000.0, sNextMessageTime.count,
@@ -382,6 +389,23 @@ ServerWindow::RequestRedraw()
 }
 
 
+/*!	Lets the window thread bring the dirty workspaces of the WorkspacesViews
+	in this window up to date. This is used instead of redrawing them from
+	whatever thread changed a window, as that one usually holds the
+	desktop lock.
+*/
+void
+ServerWindow::RequestWorkspacesViewsUpdate()
+{
+	if (atomic_or(&fWorkspacesViewsUpdateRequested, 1) != 0) {
+		// an update is already pending, and will catch this change, too
+		return;
+	}
+
+	PostMessage(AS_REDRAW, 0);
+}
+
+
 void
 ServerWindow::SetTitle(const char* newTitle)
 {
@@ -1019,7 +1043,8 @@ ServerWindow::_DispatchMessage(int32 code, BPrivate::LinkReceiver& link)
 
 		case AS_REDRAW:
 			// Nothing to do here - the redraws are actually handled by looking
-			// at the fRedrawRequested member variable in _MessageLooper().
+			// at the fRedrawRequested and fWorkspacesViewsUpdateRequested
+			// member variables in _MessageLooper().
 			break;
 
 		case AS_SYNC:
@@ -2138,6 +2163,11 @@ void
 ServerWindow::_DispatchViewDrawingMessage(int32 code,
 	BPrivate::LinkReceiver &link)
 {
+	if (!fWindow->InUpdate()) {
+		// this might change content that is currently hidden
+		fWindow->InvalidateBackingStore(fCurrentView);
+	}
+
 	if (!fCurrentView->IsVisible() || !fWindow->IsVisible()) {
 		if (link.NeedsReply()) {
 			debug_printf("ServerWindow::DispatchViewDrawingMessage() got "
@@ -3359,9 +3389,12 @@ ServerWindow::_MessageLooper()
 	fLink.Attach<float>((float)maxWidth);
 	fLink.Attach<float>((float)minHeight);
 	fLink.Attach<float>((float)maxHeight);
-	fLink.Flush();
 
+	// Let the client write its messages into a shared ring buffer; our port
+	// is then mostly used to wake us up.
 	BPrivate::LinkReceiver& receiver = fLink.Receiver();
+	fLink.Attach<area_id>(receiver.CreateRing(Title()));
+	fLink.Flush();
 	bool quitLoop = false;
 
 	while (!quitLoop) {
@@ -3455,6 +3488,9 @@ ServerWindow::_MessageLooper()
 #endif
 			}
 
+			if (atomic_and(&fWorkspacesViewsUpdateRequested, 0) != 0)
+				_UpdateWorkspacesViews();
+
 #ifdef PROFILE_MESSAGE_LOOP
 			bigtime_t dispatchStart = system_time();
 #endif
@@ -3480,8 +3516,12 @@ ServerWindow::_MessageLooper()
 				fDesktop->UnlockAllWindows();
 
 			// Only process up to 70 waiting messages at once (we have the
-			// Desktop locked), but don't hold the lock longer than 10 ms
-			if (!receiver.HasMessages() || ++messagesProcessed > 70
+			// Desktop locked), but don't hold the lock longer than 10 ms.
+			// The rest of a batch the client flushed at once (like all
+			// drawing commands of an update) is not subject to the former.
+			if (!receiver.HasMessages()
+				|| (++messagesProcessed > 70
+					&& !receiver.HasBufferedMessages())
 				|| system_time() - processingStart > 10000) {
 				if (lockedDesktopSingleWindow)
 					fDesktop->UnlockSingleWindow();
@@ -3642,6 +3682,20 @@ ServerWindow::_UpdateCurrentDrawingRegion()
 }
 
 
+void
+ServerWindow::_UpdateWorkspacesViews()
+{
+	if (!fWindow->HasWorkspacesViews())
+		return;
+
+	BObjectList<WorkspacesView> views(false);
+	fWindow->FindWorkspacesViews(views);
+
+	for (int32 i = views.CountItems(); i-- > 0;)
+		views.ItemAt(i)->UpdateDirtyWorkspaces();
+}
+
+
 bool
 ServerWindow::_MessageNeedsAllWindowsLocked(uint32 code) const
 {
@@ -100,6 +100,7 @@ public:
 	inline	int32				ServerToken() const { return fServerToken; }
 
 			void				RequestRedraw();
+			void				RequestWorkspacesViewsUpdate();
 
 			void				GetInfo(window_info& info);
 
@@ -136,6 +137,8 @@ private:
 	virtual void				_PrepareQuit();
 	virtual void				_GetLooperName(char* name, size_t size);
 
+			void				_UpdateWorkspacesViews();
+
 			void				_ResizeToFullScreen();
 			status_t			_EnableDirectWindowMode();
 			void				_DirectWindowSetFullScreen(bool set);
@@ -170,6 +173,7 @@ private:
 			::EventTarget		fEventTarget;
 
 			int32				fRedrawRequested;
+			int32				fWorkspacesViewsUpdateRequested;
 
 			int32				fServerToken;
 			int32				fClientToken;
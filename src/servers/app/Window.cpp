@@ -29,11 +29,13 @@
 #include "Decorator.h"
 #include "DecorManager.h"
 #include "Desktop.h"
+#include "DesktopSettings.h"
 #include "DrawingEngine.h"
 #include "HWInterface.h"
 #include "MessagePrivate.h"
 #include "PortLink.h"
 #include "ServerApp.h"
+#include "ServerBitmap.h"
 #include "ServerWindow.h"
 #include "WindowBehaviour.h"
 #include "Workspace.h"
@@ -88,6 +90,11 @@ Window::Window(const BRect& frame, const char *name,
 	fContentRegionValid(false),
 	fEffectiveDrawingRegionValid(false),
 
+	fBackingStore(NULL),
+	fBackingStoreRegion(),
+	fClippingOrigin(frame.LeftTop()),
+	fClippingGeneration(0),
+
 	fRegionPool(),
 
 	fWindowBehaviour(NULL),
@@ -176,6 +183,7 @@ Window::~Window()
 
 	delete fWindowBehaviour;
 	delete fDrawingEngine;
+	delete fBackingStore;
 
 	gDecorManager.CleanupForWindow(this);
 }
@@ -197,6 +205,20 @@ Window::SetClipping(BRegion* stillAvailableOnScreen)
 {
 	// this function is only called from the Desktop thread
 
+	// remember the content that was visible until now, at the position it
+	// was shown at, so that the parts covered from now on can be saved
+	BRegion* previousContent = NULL;
+	if (_CanUpdateBackingStore()) {
+		previousContent = fRegionPool.GetRegion();
+		if (previousContent != NULL) {
+			GetContentRegion(previousContent);
+			previousContent->OffsetBy(
+				(int32)(fClippingOrigin.x - fFrame.left),
+				(int32)(fClippingOrigin.y - fFrame.top));
+			previousContent->IntersectWith(&fVisibleRegion);
+		}
+	}
+
 	// start from full region (as if the window was fully visible)
 	GetFullRegion(&fVisibleRegion);
 	// clip to region still available on screen
@@ -204,6 +226,14 @@ Window::SetClipping(BRegion* stillAvailableOnScreen)
 
 	fVisibleContentRegionValid = false;
 	fEffectiveDrawingRegionValid = false;
+
+	if (previousContent != NULL) {
+		_UpdateBackingStore(*previousContent);
+		fRegionPool.Recycle(previousContent);
+	}
+
+	fClippingOrigin = fFrame.LeftTop();
+	fClippingGeneration = fDesktop->ClippingGeneration();
 }
 
 
@@ -366,6 +396,10 @@ Window::ResizeBy(int32 x, int32 y, BRegion* dirtyRegion, bool resizeStack)
 	fFrame.right += x;
 	fFrame.bottom += y;
 
+	// the views might have moved around, and the next clipping
+	// computation must not save the old content anymore
+	_DeleteBackingStore();
+
 	fContentRegionValid = false;
 	fEffectiveDrawingRegionValid = false;
 
@@ -412,6 +446,10 @@ Window::ScrollViewBy(View* view, int32 dx, int32 dy)
 
 	view->ScrollBy(dx, dy, dirty);
 
+	if (!fContentRegionValid)
+		_UpdateContentRegion();
+	_InvalidateBackingStore(view->ScreenAndUserClipping(&fContentRegion));
+
 //fDrawingEngine->FillRegion(*dirty, (rgb_color){ 255, 0, 255, 255 });
 //snooze(20000);
 
@@ -434,6 +472,13 @@ Window::CopyContents(BRegion* region, int32 xOffset, int32 yOffset)
 
 	BRegion* newDirty = fRegionPool.GetRegion(*region);
 
+	// any hidden parts of the destination are not copied
+	if (newDirty != NULL && fBackingStoreRegion.CountRects() > 0) {
+		newDirty->OffsetBy(xOffset, yOffset);
+		_InvalidateBackingStore(*newDirty);
+		newDirty->OffsetBy(-xOffset, -yOffset);
+	}
+
 	// clip the region to the visible contents at the
 	// source and destination location (note that VisibleContentRegion()
 	// is used once to make sure it is valid, then fVisibleContentRegion
@@ -745,6 +790,7 @@ Window::RedrawDirtyRegion()
 			fRegionPool.GetRegion(VisibleContentRegion());
 		dirtyContentRegion->IntersectWith(&fDirtyRegion);
 
+		_RestoreFromBackingStore(*dirtyContentRegion);
 		_TriggerContentRedraw(*dirtyContentRegion);
 
 		fRegionPool.Recycle(dirtyContentRegion);
@@ -781,6 +827,7 @@ Window::MarkContentDirty(BRegion& regionOnScreen)
 	// since this won't affect other windows, read locking
 	// is sufficient. If there was no dirty region before,
 	// an update message is triggered
+	_InvalidateBackingStore(regionOnScreen);
 	if (fHidden || IsOffscreenWindow())
 		return;
 
@@ -794,6 +841,7 @@ void
 Window::MarkContentDirtyAsync(BRegion& regionOnScreen)
 {
 	// NOTE: see comments in ProcessDirtyRegion()
+	_InvalidateBackingStore(regionOnScreen);
 	if (fHidden || IsOffscreenWindow())
 		return;
 
@@ -811,7 +859,21 @@ Window::MarkContentDirtyAsync(BRegion& regionOnScreen)
 void
 Window::InvalidateView(View* view, BRegion& viewRegion)
 {
-	if (view && IsVisible() && view->IsVisible()) {
+	if (view == NULL)
+		return;
+
+	if (fBackingStoreRegion.CountRects() > 0) {
+		// even if we are not visible, the content is no longer valid
+		BRegion* region = fRegionPool.GetRegion(viewRegion);
+		if (region != NULL) {
+			view->ConvertToScreen(region);
+			_InvalidateBackingStore(*region);
+			fRegionPool.Recycle(region);
+		} else
+			_DeleteBackingStore();
+	}
+
+	if (IsVisible() && view->IsVisible()) {
 		if (!fContentRegionValid)
 			_UpdateContentRegion();
 
@@ -829,6 +891,22 @@ Window::InvalidateView(View* view, BRegion& viewRegion)
 	}
 }
 
+/*!	Called by the ServerWindow when the client draws into \a view outside
+	of an update, since that changes content that may be hidden.
+*/
+void
+Window::InvalidateBackingStore(View* view)
+{
+	if (fBackingStoreRegion.CountRects() == 0)
+		return;
+
+	if (!fContentRegionValid)
+		_UpdateContentRegion();
+
+	_InvalidateBackingStore(view->ScreenAndUserClipping(&fContentRegion));
+}
+
+
 // DisableUpdateRequests
 void
 Window::DisableUpdateRequests()
@@ -1072,6 +1150,9 @@ Window::SetHidden(bool hidden)
 	if (fHidden != hidden) {
 		fHidden = hidden;
 
+		// the screen content will not be ours when we're shown again
+		_DeleteBackingStore();
+
 		fTopView->SetHidden(hidden);
 
 		// TODO: anything else?
@@ -1988,6 +2069,153 @@ Window::_UpdateContentRegion()
 }
 
 
+/*!	Returns whether the content visible until the clipping is recomputed
+	is still on screen, and can be saved into the backing store.
+*/
+bool
+Window::_CanUpdateBackingStore()
+{
+	DesktopSettings settings(fDesktop);
+	if (!settings.WindowBackingStores()) {
+		if (fBackingStore != NULL)
+			_DeleteBackingStore();
+		return false;
+	}
+
+	// We must have been part of the last clipping computation, or the
+	// screen might show anything at our old visible region.
+	// Direct windows and screen windows are drawn without us knowing.
+	return fClippingGeneration + 1 == fDesktop->ClippingGeneration()
+		&& !IsOffscreenWindow()
+		&& (fFlags & kWindowScreenFlag) == 0
+		&& !fWindow->IsDirectlyAccessing()
+		&& TopLayerStackWindow() == this;
+}
+
+
+/*!	Saves the parts of \a hiddenContent that are no longer visible with the
+	new clipping from the screen into the backing store. \a hiddenContent
+	is the previously visible content, on screen at fClippingOrigin.
+	This is only called from the Desktop thread with the clipping write
+	locked, so the screen cannot change meanwhile.
+*/
+void
+Window::_UpdateBackingStore(BRegion& hiddenContent)
+{
+	// never save what is still visible, or has not been drawn yet
+	BRegion* keep = fRegionPool.GetRegion(VisibleContentRegion());
+	if (keep == NULL)
+		return;
+
+	keep->Include(&fDirtyRegion);
+	if (fPendingUpdateSession->IsUsed())
+		keep->Include(&fPendingUpdateSession->DirtyRegion());
+	if (fCurrentUpdateSession->IsUsed())
+		keep->Include(&fCurrentUpdateSession->DirtyRegion());
+
+	keep->OffsetBy((int32)(fClippingOrigin.x - fFrame.left),
+		(int32)(fClippingOrigin.y - fFrame.top));
+	hiddenContent.Exclude(keep);
+	fRegionPool.Recycle(keep);
+
+	if (hiddenContent.CountRects() == 0)
+		return;
+
+	if (fBackingStore == NULL) {
+		fBackingStore = new(std::nothrow) UtilityBitmap(BRect(0, 0,
+			fFrame.IntegerWidth(), fFrame.IntegerHeight()), B_RGB32, 0);
+		if (fBackingStore == NULL)
+			return;
+	}
+
+	if (!fDrawingEngine->LockParallelAccess())
+		return;
+
+	status_t status = fDrawingEngine->ReadRegion(fBackingStore, hiddenContent,
+		fClippingOrigin);
+
+	fDrawingEngine->UnlockParallelAccess();
+
+	if (status == B_OK) {
+		hiddenContent.OffsetBy(-(int32)fClippingOrigin.x,
+			-(int32)fClippingOrigin.y);
+		fBackingStoreRegion.Include(&hiddenContent);
+	}
+}
+
+
+/*!	Draws the parts of \a dirtyContentRegion that are valid in the backing
+	store, and removes them from \a dirtyContentRegion, so that the client
+	doesn't need to redraw them.
+*/
+void
+Window::_RestoreFromBackingStore(BRegion& dirtyContentRegion)
+{
+	if (fBackingStoreRegion.CountRects() == 0
+		|| dirtyContentRegion.CountRects() == 0)
+		return;
+
+	BRegion* restore = fRegionPool.GetRegion(fBackingStoreRegion);
+	if (restore == NULL)
+		return;
+
+	restore->OffsetBy((int32)fFrame.left, (int32)fFrame.top);
+	restore->IntersectWith(&dirtyContentRegion);
+
+	if (restore->CountRects() > 0 && fDrawingEngine->LockParallelAccess()) {
+		fDrawingEngine->ConstrainClippingRegion(restore);
+		fDrawingEngine->SetDrawingMode(B_OP_COPY);
+
+		BRect bounds = fBackingStore->Bounds();
+		fDrawingEngine->DrawBitmap(fBackingStore, bounds,
+			bounds.OffsetToCopy(fFrame.LeftTop()));
+
+		// see _DrawBorder()
+		fWindow->ResyncDrawState();
+
+		fDrawingEngine->UnlockParallelAccess();
+
+		dirtyContentRegion.Exclude(restore);
+
+		// what's on screen now will be saved again once it gets hidden
+		restore->OffsetBy(-(int32)fFrame.left, -(int32)fFrame.top);
+		fBackingStoreRegion.Exclude(restore);
+	}
+
+	fRegionPool.Recycle(restore);
+}
+
+
+void
+Window::_InvalidateBackingStore(const BRegion& regionOnScreen)
+{
+	if (fBackingStoreRegion.CountRects() == 0)
+		return;
+
+	BRegion* region = fRegionPool.GetRegion(regionOnScreen);
+	if (region == NULL) {
+		fBackingStoreRegion.MakeEmpty();
+		return;
+	}
+
+	region->OffsetBy(-(int32)fFrame.left, -(int32)fFrame.top);
+	fBackingStoreRegion.Exclude(region);
+	fRegionPool.Recycle(region);
+}
+
+
+void
+Window::_DeleteBackingStore()
+{
+	delete fBackingStore;
+	fBackingStore = NULL;
+	fBackingStoreRegion.MakeEmpty();
+
+	// the next clipping computation cannot save anything
+	fClippingGeneration = 0;
+}
+
+
 void
 Window::_ObeySizeLimits()
 {
@@ -71,6 +71,7 @@ class Desktop;
 class DrawingEngine;
 class EventDispatcher;
 class Screen;
+class UtilityBitmap;
 class WindowBehaviour;
 class WorkspacesView;
 
@@ -154,6 +155,8 @@ public:
 			void				MarkContentDirtyAsync(BRegion& regionOnScreen);
 			// shortcut for invalidating just one view
 			void				InvalidateView(View* view, BRegion& viewRegion);
+			// the view was drawn into outside of an update
+			void				InvalidateBackingStore(View* view);
 
 			void				DisableUpdateRequests();
 			void				EnableUpdateRequests();
@@ -322,6 +325,15 @@ protected:
 
 			void				_UpdateContentRegion();
 
+			// handling the backing store
+			bool				_CanUpdateBackingStore();
+			void				_UpdateBackingStore(BRegion& hiddenContent);
+			void				_RestoreFromBackingStore(
+									BRegion& dirtyContentRegion);
+			void				_InvalidateBackingStore(
+									const BRegion& regionOnScreen);
+			void				_DeleteBackingStore();
+
 			void				_ObeySizeLimits();
 			void				_PropagatePosition();
 
@@ -354,6 +366,17 @@ protected:
 			bool				fContentRegionValid : 1;
 			bool				fEffectiveDrawingRegionValid : 1;
 
+			// a copy of the content that was covered by other windows, so
+			// that it can be put back on screen without a client redraw.
+			// fBackingStoreRegion holds the valid parts in window coordinates,
+			// fClippingOrigin is where the window was when the visible region
+			// was last computed in Desktop clipping generation
+			// fClippingGeneration
+			UtilityBitmap*		fBackingStore;
+			BRegion				fBackingStoreRegion;
+			BPoint				fClippingOrigin;
+			uint32				fClippingGeneration;
+
 			::RegionPool		fRegionPool;
 
 			BObjectList<Window> fSubsets;
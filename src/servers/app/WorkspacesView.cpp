@@ -23,13 +23,25 @@
 #include <WindowPrivate.h>
 
 
+//#define PROFILE_WORKSPACES_VIEW
+#ifdef PROFILE_WORKSPACES_VIEW
+#	include <stdio.h>
+
+static int32 sChangeCount;
+static int32 sUpdateCount;
+static int32 sDrawCount;
+static bigtime_t sDrawTime;
+#endif
+
+
 WorkspacesView::WorkspacesView(BRect frame, BPoint scrollingOffset,
 		const char* name, int32 token, uint32 resizeMode, uint32 flags)
 	:
 	View(frame, scrollingOffset, name, token, resizeMode, flags),
 	fSelectedWindow(NULL),
 	fSelectedWorkspace(-1),
-	fHasMoved(false)
+	fHasMoved(false),
+	fDirtyWorkspaces(0)
 {
 	fDrawState->SetLowColor((rgb_color){ 255, 255, 255, 255 });
 	fDrawState->SetHighColor((rgb_color){ 0, 0, 0, 255 });
@@ -38,6 +50,11 @@ WorkspacesView::WorkspacesView(BRect frame, BPoint scrollingOffset,
 
 WorkspacesView::~WorkspacesView()
 {
+#ifdef PROFILE_WORKSPACES_VIEW
+	printf("WorkspacesView: %ld window changes, %ld updates, %ld draws, "
+		"%Ld usecs per draw\n", sChangeCount, sUpdateCount, sDrawCount,
+		sDrawCount > 0 ? sDrawTime / sDrawCount : 0);
+#endif
 }
 
 
@@ -372,6 +389,10 @@ WorkspacesView::Draw(DrawingEngine* drawingEngine, BRegion* effectiveClipping,
 	// add the current clipping
 	redraw.IntersectWith(effectiveClipping);
 
+#ifdef PROFILE_WORKSPACES_VIEW
+	bigtime_t start = system_time();
+#endif
+
 	int32 columns, rows;
 	_GetGrid(columns, rows);
 
@@ -414,9 +435,21 @@ WorkspacesView::Draw(DrawingEngine* drawingEngine, BRegion* effectiveClipping,
 	// draw workspaces
 
 	for (int32 i = rows * columns; i-- > 0;) {
-		_DrawWorkspace(drawingEngine, redraw, i);
+		// only the dirty workspaces are part of the clipping when the
+		// update was caused by a window change
+		if (redraw.Intersects(_WorkspaceAt(i)))
+			_DrawWorkspace(drawingEngine, redraw, i);
 	}
 	fWindow->ServerWindow()->ResyncDrawState();
+
+#ifdef PROFILE_WORKSPACES_VIEW
+	atomic_add(&sDrawCount, 1);
+# ifndef HAIKU_TARGET_PLATFORM_LIBBE_TEST
+	atomic_add64(&sDrawTime, system_time() - start);
+# else
+	sDrawTime += system_time() - start;
+# endif
+#endif
 }
 
 
@@ -592,11 +625,23 @@ WorkspacesView::MouseMoved(BMessage* message, BPoint where)
 }
 
 
+/*!	Called by the Desktop whenever \a window changed in a way that affects
+	the workspace miniatures, or with \c NULL if all of them are affected.
+	The caller holds at least the single window lock, and the workspaces
+	lock of the Desktop.
+*/
 void
 WorkspacesView::WindowChanged(::Window* window)
 {
-	// TODO: be smarter about this!
-	_Invalidate();
+	uint32 workspaces = B_ALL_WORKSPACES;
+	if (window != NULL) {
+		workspaces = window->Workspaces();
+
+		// the window might just have been removed from the current workspace
+		workspaces |= 1UL << Window()->Desktop()->CurrentWorkspace();
+	}
+
+	InvalidateWorkspaces(workspaces);
 }
 
 
@@ -607,3 +652,52 @@ WorkspacesView::WindowRemoved(::Window* window)
 		fSelectedWindow = NULL;
 }
 
+
+/*!	Marks the miniatures of the given \a workspaces as dirty. They are not
+	drawn right away, as the caller is usually not the thread of our window,
+	and holds the desktop lock; instead, our window thread is asked to update
+	them via UpdateDirtyWorkspaces(). Any changes that come in until then are
+	coalesced into that single update.
+*/
+void
+WorkspacesView::InvalidateWorkspaces(uint32 workspaces)
+{
+#ifdef PROFILE_WORKSPACES_VIEW
+	atomic_add(&sChangeCount, 1);
+#endif
+
+	if (workspaces == 0)
+		return;
+
+	atomic_or(&fDirtyWorkspaces, workspaces);
+	Window()->ServerWindow()->RequestWorkspacesViewsUpdate();
+}
+
+
+/*!	Redraws the miniatures of all workspaces that have been invalidated
+	since the last call. Must be called from the thread of our window, with
+	the single window lock held.
+*/
+void
+WorkspacesView::UpdateDirtyWorkspaces()
+{
+	uint32 workspaces = atomic_and(&fDirtyWorkspaces, 0);
+	if (workspaces == 0)
+		return;
+
+#ifdef PROFILE_WORKSPACES_VIEW
+	atomic_add(&sUpdateCount, 1);
+#endif
+
+	int32 columns, rows;
+	_GetGrid(columns, rows);
+
+	BRegion region;
+	for (int32 i = 0; i < columns * rows; i++) {
+		if ((workspaces & (1UL << i)) != 0)
+			region.Include(_WorkspaceAt(i));
+	}
+
+	Window()->MarkContentDirty(region);
+}
+
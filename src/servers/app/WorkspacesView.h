@@ -33,6 +33,9 @@ public:
 			void	WindowChanged(::Window* window);
 			void	WindowRemoved(::Window* window);
 
+			void	InvalidateWorkspaces(uint32 workspaces);
+			void	UpdateDirtyWorkspaces();
+
 private:
 			void	_GetGrid(int32& columns, int32& rows);
 			BRect	_ScreenFrame(int32 index);
@@ -58,6 +61,7 @@ private:
 	bool			fHasMoved;
 	BPoint			fClickPoint;
 	BPoint			fLeftTopOffset;
+	int32			fDirtyWorkspaces;
 };
 
 #endif	// WORKSPACES_VIEW_H
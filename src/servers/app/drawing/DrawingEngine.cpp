@@ -1485,6 +1485,41 @@ DrawingEngine::ReadBitmap(ServerBitmap* bitmap, bool drawCursor, BRect bounds)
 }
 
 
+/*!	Copies the parts of the drawing buffer covered by \a region into
+	\a bitmap, which receives the pixel at \a origin at its left top corner.
+	Unlike ReadBitmap(), the cursor is never included.
+*/
+status_t
+DrawingEngine::ReadRegion(ServerBitmap* bitmap, const BRegion& region,
+	BPoint origin)
+{
+	ASSERT_PARALLEL_LOCKED();
+
+	RenderingBuffer* buffer = fGraphicsCard->DrawingBuffer();
+	if (buffer == NULL)
+		return B_ERROR;
+
+	BRect clip(0, 0, buffer->Width() - 1, buffer->Height() - 1);
+	AutoFloatingOverlaysHider _(fGraphicsCard, region.Frame());
+
+	int32 count = region.CountRects();
+	for (int32 i = 0; i < count; i++) {
+		BRect rect = region.RectAt(i) & clip;
+		if (!rect.IsValid())
+			continue;
+
+		status_t result = bitmap->ImportBits(buffer->Bits(),
+			buffer->BitsLength(), buffer->BytesPerRow(), buffer->ColorSpace(),
+			rect.LeftTop(), rect.LeftTop() - origin,
+			rect.IntegerWidth() + 1, rect.IntegerHeight() + 1);
+		if (result != B_OK)
+			return result;
+	}
+
+	return B_OK;
+}
+
+
 // #pragma mark -
 
 
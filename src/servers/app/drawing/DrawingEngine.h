@@ -63,6 +63,9 @@ public:
 			ServerBitmap*	DumpToBitmap();
 	virtual	status_t		ReadBitmap(ServerBitmap *bitmap, bool drawCursor,
 								BRect bounds);
+	// for window backing stores
+			status_t		ReadRegion(ServerBitmap* bitmap,
+								const BRegion& region, BPoint origin);
 
 	// clipping for all drawing functions, passing a NULL region
 	// will remove any clipping (drawing allowed everywhere)
@@ -29,7 +29,8 @@
 #include "IntRect.h"
 
 
-AGGTextRenderer::AGGTextRenderer(renderer_subpix_type& subpixRenderer,
+AGGTextRenderer::AGGTextRenderer(renderer_base& baseRenderer,
+		renderer_subpix_type& subpixRenderer,
 		renderer_type& solidRenderer, renderer_bin_type& binRenderer,
 		scanline_unpacked_type& scanline,
 		scanline_unpacked_subpix_type& subpixScanline,
@@ -45,6 +46,7 @@ AGGTextRenderer::AGGTextRenderer(renderer_subpix_type& subpixRenderer,
 	fCurves(fPathAdaptor),
 	fContour(fCurves),
 
+	fBaseRenderer(baseRenderer),
 	fSolidRenderer(solidRenderer),
 	fBinRenderer(binRenderer),
 	fSubpixRenderer(subpixRenderer),
@@ -133,6 +135,8 @@ public:
 		fVector(false),
 		fBounds(LONG_MAX, LONG_MAX, LONG_MIN, LONG_MIN),
 		fNextCharPos(nextCharPos),
+		fAtlasHits(0),
+		fAtlasMisses(0),
 
 		fTransformedGlyph(transformedGlyph),
 		fTransformedContour(transformedContour),
@@ -164,6 +168,11 @@ public:
 			fNextCharPos->y = y;
 			fTransform.Transform(fNextCharPos);
 		}
+
+		if (fAtlasHits > 0)
+			atomic_add(&gFontCacheStatistics.atlas_hits, fAtlasHits);
+		if (fAtlasMisses > 0)
+			atomic_add(&gFontCacheStatistics.atlas_misses, fAtlasMisses);
 	}
 
 	void ConsumeEmptyGlyph(int32 index, uint32 charCode, double x, double y)
@@ -234,6 +243,16 @@ public:
 						break;
 
 					case glyph_data_gray8:
+#if !ALIASED_DRAWING
+						if (glyph->coverage != NULL) {
+							fRenderer._BlendCoverage(glyph,
+								agg::iround(x + fTransformOffset.x),
+								agg::iround(y + fTransformOffset.y));
+							fAtlasHits++;
+							break;
+						}
+						fAtlasMisses++;
+#endif
 						agg::render_scanlines(fRenderer.fGray8Adaptor,
 							fRenderer.fGray8Scanline, fRenderer.fSolidRenderer);
 						break;
@@ -303,6 +322,8 @@ private:
 	bool				fVector;
 	IntRect				fBounds;
 	BPoint*				fNextCharPos;
+	int32				fAtlasHits;
+	int32				fAtlasMisses;
 
 	FontCacheEntry::TransformedOutline& fTransformedGlyph;
 	FontCacheEntry::TransformedContourOutline& fTransformedContour;
@@ -310,6 +331,46 @@ private:
 };
 
 
+/*!	Blends the coverage mask of \a glyph from the GlyphAtlas with the color
+	of the solid renderer, the glyph origin being at \a x, \a y. Equivalent
+	to rendering the serialized scanlines of the glyph, since those contain
+	exactly the pixels with a non-zero coverage.
+*/
+void
+AGGTextRenderer::_BlendCoverage(const GlyphCache* glyph, int x, int y)
+{
+	const renderer_type::color_type& color = fSolidRenderer.color();
+
+	int32 left = x + glyph->bounds.x1;
+	int32 top = y + glyph->bounds.y1;
+	int32 width = glyph->bounds.x2 - glyph->bounds.x1 + 1;
+	int32 height = glyph->bounds.y2 - glyph->bounds.y1 + 1;
+
+	const agg::rect_i& clip = fBaseRenderer.bounding_clip_box();
+	if (top > clip.y2 || top + height <= clip.y1
+		|| left > clip.x2 || left + width <= clip.x1) {
+		return;
+	}
+
+	const uint8* covers = glyph->coverage;
+	for (int32 row = 0; row < height; row++) {
+		int32 i = 0;
+		while (i < width) {
+			while (i < width && covers[i] == 0)
+				i++;
+			int32 start = i;
+			while (i < width && covers[i] != 0)
+				i++;
+			if (i > start) {
+				fBaseRenderer.blend_solid_hspan(left + start, top + row,
+					i - start, color, covers + start);
+			}
+		}
+		covers += glyph->coverage_bpr;
+	}
+}
+
+
 BRect
 AGGTextRenderer::RenderString(const char* string, uint32 length,
 	const BPoint& baseLine, const BRect& clippingFrame, bool dryRun,
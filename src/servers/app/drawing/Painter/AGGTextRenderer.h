@@ -23,6 +23,7 @@ class FontCacheReference;
 class AGGTextRenderer {
 public:
 								AGGTextRenderer(
+									renderer_base& baseRenderer,
 									renderer_subpix_type& subpixRenderer,
 									renderer_type& solidRenderer,
 									renderer_bin_type& binRenderer,
@@ -65,6 +66,9 @@ private:
 	class StringRenderer;
 	friend class StringRenderer;
 
+			void				_BlendCoverage(const GlyphCache* glyph,
+									int x, int y);
+
 	// Pipeline to process the vectors glyph paths (curves + contour)
 	FontCacheEntry::GlyphPathAdapter	fPathAdaptor;
 	FontCacheEntry::GlyphGray8Adapter	fGray8Adaptor;
@@ -76,6 +80,7 @@ private:
 	FontCacheEntry::CurveConverter		fCurves;
 	FontCacheEntry::ContourConverter	fContour;
 
+	renderer_base&				fBaseRenderer;
 	renderer_type&				fSolidRenderer;
 	renderer_bin_type&			fBinRenderer;
 	renderer_subpix_type&		fSubpixRenderer;
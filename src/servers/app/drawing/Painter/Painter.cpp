@@ -53,6 +53,7 @@
 
 #include "DrawingMode.h"
 #include "GlobalSubpixelSettings.h"
+#include "PainterThreadPool.h"
 #include "PatternHandler.h"
 #include "RenderingBuffer.h"
 #include "ServerBitmap.h"
@@ -83,83 +84,115 @@ using std::nothrow;
 #define CHECK_CLIPPING	if (!fValidClipping) return BRect(0, 0, -1, -1);
 #define CHECK_CLIPPING_NO_RETURN	if (!fValidClipping) return;
 
-// Defines for SIMD support.
-#define APPSERVER_SIMD_MMX	(1 << 0)
-#define APPSERVER_SIMD_SSE	(1 << 1)
 
-// Prototypes for assembler routines
-extern "C" {
-	void bilinear_scale_xloop_mmxsse(const uint8* src, void* dst,
-		void* xWeights, uint32 xmin, uint32 xmax, uint32 wTop, uint32 srcBPR);
-}
+// Primitives covering at least kMinBandArea pixels of the clipping region
+// are split into horizontal bands of at least kMinBandHeight pixel rows,
+// which are rendered in parallel by the PainterThreadPool.
+static const float kMinBandArea = 256 * 256;
+static const int32 kMinBandHeight = 32;
+static const int32 kMaxBands = 8;
 
-static uint32 detect_simd();
 
-static uint32 sSIMDFlags = detect_simd();
+struct Painter::BandPainter {
+	Painter		painter;
+	BRegion		clipping;
+};
 
 
-/*!	Detect SIMD flags for use in AppServer. Checks all CPUs in the system
-	and chooses the minimum supported set of instructions.
-*/
-static uint32
-detect_simd()
-{
-#if __INTEL__
-	// Only scan CPUs for which we are certain the SIMD flags are properly
-	// defined.
-	const char* vendorNames[] = {
-		"GenuineIntel",
-		"AuthenticAMD",
-		"CentaurHauls", // Via CPUs, MMX and SSE support
-		"RiseRiseRise", // should be MMX-only
-		"CyrixInstead", // MMX-only, but custom MMX extensions
-		"GenuineTMx86", // MMX and SSE
-		0
-	};
+namespace {
 
-	system_info systemInfo;
-	if (get_system_info(&systemInfo) != B_OK)
-		return 0;
 
-	// We start out with all flags set and end up with only those flags
-	// supported across all CPUs found.
-	uint32 systemSIMD = 0xffffffff;
+template<class Operation>
+class BandJob : public PainterThreadPool::Job {
+public:
+	BandJob(const Operation& operation, const Painter* const* painters,
+			BRect* touched)
+		:
+		fOperation(operation),
+		fPainters(painters),
+		fTouched(touched)
+	{
+	}
 
-	for (int32 cpu = 0; cpu < systemInfo.cpu_count; cpu++) {
-		cpuid_info cpuInfo;
-		get_cpuid(&cpuInfo, 0, cpu);
+	virtual void RenderBand(int32 index)
+	{
+		fTouched[index] = fOperation(fPainters[index]);
+	}
 
-		// Get the vendor string and terminate it manually
-		char vendor[13];
-		memcpy(vendor, cpuInfo.eax_0.vendor_id, 12);
-		vendor[12] = 0;
+private:
+	const Operation&		fOperation;
+	const Painter* const*	fPainters;
+	BRect*					fTouched;
+};
 
-		bool vendorFound = false;
-		for (uint32 i = 0; vendorNames[i] != 0; i++) {
-			if (strcmp(vendor, vendorNames[i]) == 0)
-				vendorFound = true;
-		}
 
-		uint32 cpuSIMD = 0;
-		uint32 maxStdFunc = cpuInfo.regs.eax;
-		if (vendorFound && maxStdFunc >= 1) {
-			get_cpuid(&cpuInfo, 1, 0);
-			uint32 edx = cpuInfo.regs.edx;
-			if (edx & (1 << 23))
-				cpuSIMD |= APPSERVER_SIMD_MMX;
-			if (edx & (1 << 25))
-				cpuSIMD |= APPSERVER_SIMD_SSE;
-		} else {
-			// no flags can be identified
-			cpuSIMD = 0;
-		}
-		systemSIMD &= cpuSIMD;
-	}
-	return systemSIMD;
-#else	// !__INTEL__
-	return 0;
-#endif
-}
+// The operations repeated for each band. Every band Painter builds its own
+// paths and scanlines from the original arguments, since none of them can
+// be shared between threads.
+
+struct FillRectOperation {
+	FillRectOperation(const BRect& rect)
+		: rect(rect) {}
+
+	BRect operator()(const Painter* painter) const
+		{ return painter->FillRect(rect); }
+
+	const BRect&	rect;
+};
+
+
+struct FillRectGradientOperation {
+	FillRectGradientOperation(const BRect& rect, const BGradient& gradient)
+		: rect(rect), gradient(gradient) {}
+
+	BRect operator()(const Painter* painter) const
+		{ return painter->FillRect(rect, gradient); }
+
+	const BRect&		rect;
+	const BGradient&	gradient;
+};
+
+
+struct FillEllipseOperation {
+	FillEllipseOperation(const BRect& rect)
+		: rect(rect) {}
+
+	BRect operator()(const Painter* painter) const
+		{ return painter->DrawEllipse(rect, true); }
+
+	const BRect&	rect;
+};
+
+
+struct FillEllipseGradientOperation {
+	FillEllipseGradientOperation(const BRect& rect, const BGradient& gradient)
+		: rect(rect), gradient(gradient) {}
+
+	BRect operator()(const Painter* painter) const
+		{ return painter->FillEllipse(rect, gradient); }
+
+	const BRect&		rect;
+	const BGradient&	gradient;
+};
+
+
+struct DrawBitmapOperation {
+	DrawBitmapOperation(const ServerBitmap* bitmap, const BRect& bitmapRect,
+			const BRect& viewRect, uint32 options)
+		: bitmap(bitmap), bitmapRect(bitmapRect), viewRect(viewRect),
+		  options(options) {}
+
+	BRect operator()(const Painter* painter) const
+		{ return painter->DrawBitmap(bitmap, bitmapRect, viewRect, options); }
+
+	const ServerBitmap*	bitmap;
+	const BRect&		bitmapRect;
+	const BRect&		viewRect;
+	uint32				options;
+};
+
+
+}	// namespace
 
 
 // #pragma mark -
@@ -187,6 +220,7 @@ Painter::Painter()
 	fValidClipping(false),
 	fDrawingText(false),
 	fAttached(false),
+	fIsBandPainter(false),
 
 	fPenSize(1.0),
 	fClippingRegion(NULL),
@@ -198,8 +232,11 @@ Painter::Painter()
 	fMiterLimit(B_DEFAULT_MITER_LIMIT),
 
 	fPatternHandler(),
-	fTextRenderer(fSubpixRenderer, fRenderer, fRendererBin, fUnpackedScanline,
-		fSubpixUnpackedScanline, fSubpixRasterizer)
+	fTextRenderer(fBaseRenderer, fSubpixRenderer, fRenderer, fRendererBin,
+		fUnpackedScanline, fSubpixUnpackedScanline, fSubpixRasterizer),
+
+	fBandPainters(NULL),
+	fBandPainterCount(0)
 {
 	fPixelFormat.SetDrawingMode(fDrawingMode, fAlphaSrcMode, fAlphaFncMode,
 		false);
@@ -214,6 +251,9 @@ Painter::Painter()
 // destructor
 Painter::~Painter()
 {
+	for (int32 i = 0; i < fBandPainterCount; i++)
+		delete fBandPainters[i];
+	delete[] fBandPainters;
 }
 
 
@@ -917,6 +957,10 @@ Painter::FillRect(const BRect& r) const
 {
 	CHECK_CLIPPING
 
+	BRect touched;
+	if (_RenderBands(r, FillRectOperation(r), touched))
+		return touched;
+
 	// support invalid rects
 	BPoint a(min_c(r.left, r.right), min_c(r.top, r.bottom));
 	BPoint b(max_c(r.left, r.right), max_c(r.top, r.bottom));
@@ -975,6 +1019,10 @@ Painter::FillRect(const BRect& r, const BGradient& gradient) const
 {
 	CHECK_CLIPPING
 
+	BRect touched;
+	if (_RenderBands(r, FillRectGradientOperation(r, gradient), touched))
+		return touched;
+
 	// support invalid rects
 	BPoint a(min_c(r.left, r.right), min_c(r.top, r.bottom));
 	BPoint b(max_c(r.left, r.right), max_c(r.top, r.bottom));
@@ -1308,6 +1356,12 @@ Painter::DrawEllipse(BRect r, bool fill) const
 {
 	CHECK_CLIPPING
 
+	if (fill) {
+		BRect touched;
+		if (_RenderBands(r, FillEllipseOperation(r), touched))
+			return touched;
+	}
+
 	AlignEllipseRect(&r, fill);
 
 	float xRadius = r.Width() / 2.0;
@@ -1381,6 +1435,10 @@ Painter::FillEllipse(BRect r, const BGradient& gradient) const
 {
 	CHECK_CLIPPING
 
+	BRect touched;
+	if (_RenderBands(r, FillEllipseGradientOperation(r, gradient), touched))
+		return touched;
+
 	AlignEllipseRect(&r, true);
 
 	float xRadius = r.Width() / 2.0;
@@ -1602,6 +1660,20 @@ Painter::DrawBitmap(const ServerBitmap* bitmap, BRect bitmapRect,
 {
 	CHECK_CLIPPING
 
+	// Only formats that don't need a temporary conversion bitmap are drawn
+	// in bands, since each band would convert the whole bitmap otherwise.
+	if (bitmap != NULL && bitmap->IsValid()
+		&& (bitmap->ColorSpace() == B_RGBA32
+			|| (bitmap->ColorSpace() == B_RGB32
+				&& (fDrawingMode == B_OP_COPY
+					|| fDrawingMode == B_OP_ALPHA)))) {
+		BRect touched;
+		if (_RenderBands(viewRect, DrawBitmapOperation(bitmap, bitmapRect,
+				viewRect, options), touched)) {
+			return touched;
+		}
+	}
+
 	BRect touched = _Clipped(viewRect);
 
 	if (bitmap && bitmap->IsValid() && touched.IsValid()) {
@@ -1772,6 +1844,144 @@ Painter::_SetRendererColor(const rgb_color& color) const
 // #pragma mark -
 
 
+/*!	Decides whether a primitive with the given \a bounds is large enough to
+	be rendered in horizontal bands by the PainterThreadPool, and prepares one
+	band Painter per band. Returns the number of bands, or 0 if the primitive
+	should be rendered directly.
+	The bands partition all pixel rows of the clipping region, so that each
+	pixel is rendered by exactly one band Painter no matter how accurate
+	\a bounds is. The split points are chosen so that the rows covered by the
+	primitive are distributed evenly.
+*/
+int32
+Painter::_PrepareBands(const BRect& bounds) const
+{
+	if (fIsBandPainter || !fValidClipping)
+		return 0;
+
+	BRect frame = fClippingRegion->Frame();
+	BRect area = bounds & frame;
+	if (!area.IsValid()
+		|| (area.Width() + 1) * (area.Height() + 1) < kMinBandArea) {
+		return 0;
+	}
+
+	PainterThreadPool* pool = PainterThreadPool::Default();
+	if (pool == NULL)
+		return 0;
+
+	int32 top = (int32)floorf(area.top);
+	int32 height = (int32)ceilf(area.bottom) - top + 1;
+	int32 bandCount = min_c(min_c(pool->CountThreads() + 1, kMaxBands),
+		height / kMinBandHeight);
+	if (bandCount < 2)
+		return 0;
+
+	if (fBandPainters == NULL) {
+		fBandPainters = new(std::nothrow) BandPainter*[kMaxBands];
+		if (fBandPainters == NULL)
+			return 0;
+	}
+
+	while (fBandPainterCount < bandCount) {
+		BandPainter* band = new(std::nothrow) BandPainter;
+		if (band == NULL)
+			return 0;
+
+		band->painter.fIsBandPainter = true;
+		fBandPainters[fBandPainterCount++] = band;
+	}
+
+	clipping_rect frameInt = fClippingRegion->FrameInt();
+	for (int32 i = 0; i < bandCount; i++) {
+		BandPainter* band = fBandPainters[i];
+
+		clipping_rect bandRect = frameInt;
+		if (i > 0)
+			bandRect.top = top + height * i / bandCount;
+		if (i < bandCount - 1)
+			bandRect.bottom = top + height * (i + 1) / bandCount - 1;
+
+		band->clipping.Set(bandRect);
+		band->clipping.IntersectWith(fClippingRegion);
+
+		_SyncBandPainter(&band->painter, &band->clipping);
+	}
+
+	return bandCount;
+}
+
+
+/*!	Transfers the drawing state relevant for rendering primitives to
+	the band \a painter and constrains it to the \a clipping of its band.
+*/
+void
+Painter::_SyncBandPainter(Painter* painter, const BRegion* clipping) const
+{
+	painter->fBuffer.attach(fBuffer.buf(), fBuffer.width(), fBuffer.height(),
+		fBuffer.stride());
+	painter->fAttached = fAttached;
+
+	painter->fSubpixelPrecise = fSubpixelPrecise;
+	painter->fPenSize = fPenSize;
+	painter->fLineCapMode = fLineCapMode;
+	painter->fLineJoinMode = fLineJoinMode;
+	painter->fMiterLimit = fMiterLimit;
+
+	painter->fPatternHandler = fPatternHandler;
+	painter->fDrawingMode = fDrawingMode;
+	painter->fAlphaSrcMode = fAlphaSrcMode;
+	painter->fAlphaFncMode = fAlphaFncMode;
+	painter->fDrawingText = fDrawingText;
+	painter->_UpdateDrawingMode(fDrawingText);
+
+	if (*fPatternHandler.GetR5Pattern() == B_SOLID_LOW)
+		painter->_SetRendererColor(fPatternHandler.LowColor());
+	else
+		painter->_SetRendererColor(fPatternHandler.HighColor());
+
+	painter->ConstrainClipping(clipping);
+}
+
+
+/*!	Renders a primitive covering \a bounds in horizontal bands, by calling
+	\a operation with the band Painters in parallel. Returns \c false when
+	the primitive is too small, or the thread pool is busy, in which case
+	nothing has been rendered. Otherwise, \a touched is set to the union of
+	the areas touched in each band.
+*/
+template<class Operation>
+bool
+Painter::_RenderBands(const BRect& bounds, const Operation& operation,
+	BRect& touched) const
+{
+	int32 bandCount = _PrepareBands(bounds);
+	if (bandCount == 0)
+		return false;
+
+	const Painter* painters[kMaxBands];
+	BRect bandTouched[kMaxBands];
+	for (int32 i = 0; i < bandCount; i++)
+		painters[i] = &fBandPainters[i]->painter;
+
+	BandJob<Operation> job(operation, painters, bandTouched);
+	if (!PainterThreadPool::Default()->Run(&job, bandCount))
+		return false;
+
+	touched = BRect(0, 0, -1, -1);
+	for (int32 i = 0; i < bandCount; i++) {
+		if (!bandTouched[i].IsValid())
+			continue;
+		touched = touched.IsValid() ? touched | bandTouched[i]
+			: bandTouched[i];
+	}
+	return true;
+}
+
+
+// #pragma mark -
+
+
 // _DrawTriangle
 inline BRect
 Painter::_DrawTriangle(BPoint pt1, BPoint pt2, BPoint pt3, bool fill) const
@@ -1857,6 +2067,12 @@ static inline void
 copy_bitmap_row_bgr32_alpha(uint8* dst, const uint8* src, int32 numPixels,
 	const rgb_color* colorMap)
 {
+#ifdef PAINTER_SSE2_KERNELS
+	if (use_sse2_kernels()) {
+		copy_bitmap_row_bgr32_alpha_sse2(dst, src, numPixels);
+		return;
+	}
+#endif
 	uint32* d = (uint32*)dst;
 	int32 bytes = numPixels * 4;
 	uint8 buffer[bytes];
@@ -2395,8 +2611,21 @@ Painter::_DrawBitmapBilinearCopy32(agg::rendering_buffer& srcBuffer,
 
 	int codeSelect = kUseDefaultVersion;
 
+	// the SIMD version of the inner x-loop, the SSE2 one processes two
+	// pixels at once and is preferred
+	void (*scaleXLoop)(const uint8* src, void* dst, void* xWeights,
+		uint32 xmin, uint32 xmax, uint32 wTop, uint32 srcBPR) = NULL;
+#ifdef __INTEL__
 	uint32 neededSIMDFlags = APPSERVER_SIMD_MMX | APPSERVER_SIMD_SSE;
-	if ((sSIMDFlags & neededSIMDFlags) == neededSIMDFlags)
+	if ((gPainterSIMDFlags & neededSIMDFlags) == neededSIMDFlags)
+		scaleXLoop = bilinear_scale_xloop_mmxsse;
+#endif
+#ifdef PAINTER_SSE2_KERNELS
+	if (use_sse2_kernels())
+		scaleXLoop = bilinear_scale_xloop_sse2;
+#endif
+
+	if (scaleXLoop != NULL)
 		codeSelect = kUseSIMDVersion;
 	else {
 		if (xScale == yScale && (xScale == 1.5 || xScale == 2.0
@@ -2605,7 +2834,6 @@ Painter::_DrawBitmapBilinearCopy32(agg::rendering_buffer& srcBuffer,
 				break;
 			}
 
-#ifdef __INTEL__
 			case kUseSIMDVersion:
 			{
 				// Basically the same as the "standard" mode, but we use SIMD
@@ -2630,8 +2858,8 @@ Painter::_DrawBitmapBilinearCopy32(agg::rendering_buffer& srcBuffer,
 					// buffer handle for destination to be incremented per
 					// pixel
 					uint8* d = dst;
-					bilinear_scale_xloop_mmxsse(src, dst, xWeights,	xIndexL,
-						xIndexMax, wTop, srcBPR);
+					scaleXLoop(src, dst, xWeights, xIndexL, xIndexMax, wTop,
+						srcBPR);
 					// increase pointer by processed pixels
 					d += (xIndexMax - xIndexL + 1) * 4;
 
@@ -2673,7 +2901,6 @@ Painter::_DrawBitmapBilinearCopy32(agg::rendering_buffer& srcBuffer,
 				}
 				break;
 			}
-#endif	// __INTEL__
 		}
 	} while (fBaseRenderer.next_clip_box());
 
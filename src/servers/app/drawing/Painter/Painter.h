@@ -233,6 +233,8 @@ public:
 
 
 private:
+			struct BandPainter;
+
 			void				_Transform(BPoint* point,
 									bool centerOffset = true) const;
 			BPoint				_Transform(const BPoint& point,
@@ -244,6 +246,15 @@ private:
 			void				_UpdateDrawingMode(bool drawingText = false);
 			void				_SetRendererColor(const rgb_color& color) const;
 
+								// rendering of large primitives in bands
+			int32				_PrepareBands(const BRect& bounds) const;
+			void				_SyncBandPainter(Painter* painter,
+									const BRegion* clipping) const;
+			template<class Operation>
+			bool				_RenderBands(const BRect& bounds,
+									const Operation& operation,
+									BRect& touched) const;
+
 								// drawing functions stroke/fill
 			BRect				_DrawTriangle(BPoint pt1, BPoint pt2,
 									BPoint pt3, bool fill) const;
@@ -349,6 +360,7 @@ private:
 			bool				fValidClipping : 1;
 			bool				fDrawingText : 1;
 			bool				fAttached : 1;
+			bool				fIsBandPainter : 1;
 
 			float				fPenSize;
 			const BRegion*		fClippingRegion;
@@ -365,6 +377,11 @@ private:
 	// it is setup to load from a specific Freetype supported
 	// font file which it gets from ServerFont
 	mutable	AGGTextRenderer		fTextRenderer;
+
+	// helper Painters for rendering large primitives in parallel, one
+	// per horizontal band, created on demand
+	mutable	BandPainter**		fBandPainters;
+	mutable	int32				fBandPainterCount;
 };
 
 
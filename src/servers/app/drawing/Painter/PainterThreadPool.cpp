@@ -0,0 +1,192 @@
+/*
+ * Copyright 2011, Haiku, Inc.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ *
+ * A pool of worker threads shared by all Painter instances.
+ *
+ */
+
+#include "PainterThreadPool.h"
+
+#include <new>
+
+#include <Autolock.h>
+
+
+static BLocker sDefaultPoolLock("painter thread pool");
+static PainterThreadPool* sDefaultPool = NULL;
+static int32 sDefaultThreadCount = -1;
+
+
+PainterThreadPool::Job::~Job()
+{
+}
+
+
+// #pragma mark -
+
+
+PainterThreadPool::PainterThreadPool(int32 threadCount)
+	:
+	fLock("painter thread pool run"),
+	fStartSem(-1),
+	fDoneSem(-1),
+	fThreadCount(0),
+	fQuitting(false),
+	fJob(NULL),
+	fBandCount(0),
+	fNextBand(0)
+{
+	if (threadCount > MAX_THREADS)
+		threadCount = MAX_THREADS;
+	if (threadCount <= 0)
+		return;
+
+	fStartSem = create_sem(0, "painter band start");
+	fDoneSem = create_sem(0, "painter band done");
+	if (fStartSem < B_OK || fDoneSem < B_OK)
+		return;
+
+	for (int32 i = 0; i < threadCount; i++) {
+		thread_id thread = spawn_thread(_WorkerEntry, "painter band worker",
+			B_DISPLAY_PRIORITY, this);
+		if (thread < B_OK)
+			break;
+
+		fThreads[fThreadCount++] = thread;
+		resume_thread(thread);
+	}
+}
+
+
+PainterThreadPool::~PainterThreadPool()
+{
+	fQuitting = true;
+
+	// deleting the start semaphore wakes up all workers
+	delete_sem(fStartSem);
+	for (int32 i = 0; i < fThreadCount; i++) {
+		status_t result;
+		wait_for_thread(fThreads[i], &result);
+	}
+
+	delete_sem(fDoneSem);
+}
+
+
+status_t
+PainterThreadPool::InitCheck() const
+{
+	if (fStartSem < B_OK)
+		return fStartSem;
+	if (fDoneSem < B_OK)
+		return fDoneSem;
+
+	return fThreadCount > 0 ? B_OK : B_NO_INIT;
+}
+
+
+/*!	Returns the pool shared by all Painters, or \c NULL if band rendering
+	is not available, ie. on single CPU systems. The pool is created on first
+	use with one thread less than there are CPUs in the system, since the
+	calling thread takes part in the rendering.
+*/
+/*static*/ PainterThreadPool*
+PainterThreadPool::Default()
+{
+	BAutolock _(sDefaultPoolLock);
+
+	if (sDefaultPool == NULL && sDefaultThreadCount != 0) {
+		int32 threadCount = sDefaultThreadCount;
+		if (threadCount < 0) {
+			system_info info;
+			if (get_system_info(&info) != B_OK)
+				return NULL;
+			threadCount = info.cpu_count - 1;
+		}
+
+		PainterThreadPool* pool
+			= new(std::nothrow) PainterThreadPool(threadCount);
+		if (pool == NULL || pool->InitCheck() != B_OK) {
+			delete pool;
+			// don't try again
+			sDefaultThreadCount = 0;
+			return NULL;
+		}
+
+		sDefaultPool = pool;
+	}
+
+	return sDefaultPool;
+}
+
+
+/*!	Sets the number of worker threads of the default pool. A \a count of 0
+	disables band rendering, -1 selects the default depending on the number
+	of CPUs. Has no effect once the default pool has been created.
+*/
+/*static*/ void
+PainterThreadPool::SetDefaultThreadCount(int32 count)
+{
+	BAutolock _(sDefaultPoolLock);
+
+	sDefaultThreadCount = count;
+}
+
+
+/*!	Calls Job::RenderBand() for every band index in [0, \a bandCount) and
+	returns when all of them are done. If the pool is currently in use by
+	another thread, \c false is returned without calling the job at all, and
+	the caller is expected to render the primitive itself.
+*/
+bool
+PainterThreadPool::Run(Job* job, int32 bandCount)
+{
+	if (fThreadCount == 0 || bandCount < 2)
+		return false;
+
+	if (fLock.LockWithTimeout(0) != B_OK)
+		return false;
+
+	fJob = job;
+	fBandCount = bandCount;
+	fNextBand = 0;
+
+	int32 workerCount = min_c(fThreadCount, bandCount - 1);
+	release_sem_etc(fStartSem, workerCount, 0);
+
+	_RenderBands();
+
+	acquire_sem_etc(fDoneSem, workerCount, 0, 0);
+
+	fJob = NULL;
+	fLock.Unlock();
+	return true;
+}
+
+
+/*static*/ status_t
+PainterThreadPool::_WorkerEntry(void* data)
+{
+	((PainterThreadPool*)data)->_Worker();
+	return B_OK;
+}
+
+
+void
+PainterThreadPool::_Worker()
+{
+	while (acquire_sem(fStartSem) == B_OK && !fQuitting) {
+		_RenderBands();
+		release_sem(fDoneSem);
+	}
+}
+
+
+void
+PainterThreadPool::_RenderBands()
+{
+	int32 index;
+	while ((index = atomic_add(&fNextBand, 1)) < fBandCount)
+		fJob->RenderBand(index);
+}
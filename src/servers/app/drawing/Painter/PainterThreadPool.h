@@ -0,0 +1,67 @@
+/*
+ * Copyright 2011, Haiku, Inc.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ *
+ * A pool of worker threads shared by all Painter instances. Large primitives
+ * are split into horizontal bands, which are rendered concurrently by the
+ * workers and the calling thread.
+ *
+ */
+#ifndef PAINTER_THREAD_POOL_H
+#define PAINTER_THREAD_POOL_H
+
+
+#include <Locker.h>
+#include <OS.h>
+
+
+class PainterThreadPool {
+public:
+	class Job {
+	public:
+		virtual					~Job();
+
+		// Called once for every band index, concurrently from different
+		// threads. Implementations must not touch state shared between
+		// bands.
+		virtual	void			RenderBand(int32 index) = 0;
+	};
+
+public:
+								PainterThreadPool(int32 threadCount);
+								~PainterThreadPool();
+
+			status_t			InitCheck() const;
+
+	static	PainterThreadPool*	Default();
+	static	void				SetDefaultThreadCount(int32 count);
+
+			int32				CountThreads() const
+									{ return fThreadCount; }
+
+			bool				Run(Job* job, int32 bandCount);
+
+private:
+	static	status_t			_WorkerEntry(void* data);
+			void				_Worker();
+			void				_RenderBands();
+
+private:
+	enum {
+		MAX_THREADS = 7
+	};
+
+			BLocker				fLock;
+			sem_id				fStartSem;
+			sem_id				fDoneSem;
+			thread_id			fThreads[MAX_THREADS];
+			int32				fThreadCount;
+	volatile bool				fQuitting;
+
+			Job*				fJob;
+			int32				fBandCount;
+			vint32				fNextBand;
+};
+
+
+#endif // PAINTER_THREAD_POOL_H
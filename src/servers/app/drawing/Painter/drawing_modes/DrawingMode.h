@@ -12,6 +12,7 @@
 
 #include "drawing_support.h"
 
+#include "PainterSIMD.h"
 #include "PatternHandler.h"
 #include "PixelFormat.h"
 
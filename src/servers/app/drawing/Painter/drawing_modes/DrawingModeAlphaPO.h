@@ -122,6 +122,12 @@ blend_color_hspan_alpha_po(int x, int y, unsigned len,
 	uint8* p = buffer->row_ptr(y) + (x << 2);
 	if (covers) {
 		// non-solid opacity
+#ifdef PAINTER_SSE2_KERNELS
+		if (use_sse2_kernels()) {
+			blend_color_hspan_alpha_po_sse2(p, colors, covers, cover, len);
+			return;
+		}
+#endif
 		do {
 			uint16 alpha = colors->a * *covers;
 			if (alpha) {
@@ -149,6 +149,12 @@ blend_color_hspan_copy(int x, int y, unsigned len, const color_type* colors,
 {
 	uint8* p = buffer->row_ptr(y) + (x << 2);
 	rgb_color l = pattern->LowColor();
+#ifdef PAINTER_SSE2_KERNELS
+	if (use_sse2_kernels()) {
+		blend_color_hspan_copy_sse2(p, colors, covers, cover, l, len);
+		return;
+	}
+#endif
 	if (covers) {
 		// non-solid opacity
 		do {
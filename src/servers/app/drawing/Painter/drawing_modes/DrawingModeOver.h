@@ -135,6 +135,12 @@ blend_color_hspan_over(int x, int y, unsigned len,
 					   agg_buffer* buffer, const PatternHandler* pattern)
 {
 	uint8* p = buffer->row_ptr(y) + (x << 2);
+#ifdef PAINTER_SSE2_KERNELS
+	if (use_sse2_kernels()) {
+		blend_color_hspan_over_sse2(p, colors, covers, cover, len);
+		return;
+	}
+#endif
 	if (covers) {
 		// non-solid opacity
 		do {
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2009, Christian Packmann.
+ * Copyright 2011, Haiku, Inc.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ *
+ * Runtime detection of the SIMD instruction sets available to the Painter.
+ *
+ */
+
+#include "PainterSIMD.h"
+
+#include <string.h>
+
+#include <OS.h>
+
+
+static uint32 detect_simd();
+
+uint32 gPainterSIMDFlags = detect_simd();
+
+
+/*!	Detect SIMD flags for use in AppServer. Checks all CPUs in the system
+	and chooses the minimum supported set of instructions.
+*/
+static uint32
+detect_simd()
+{
+#if __INTEL__
+	// Only scan CPUs for which we are certain the SIMD flags are properly
+	// defined.
+	const char* vendorNames[] = {
+		"GenuineIntel",
+		"AuthenticAMD",
+		"CentaurHauls", // Via CPUs, MMX and SSE support
+		"RiseRiseRise", // should be MMX-only
+		"CyrixInstead", // MMX-only, but custom MMX extensions
+		"GenuineTMx86", // MMX and SSE
+		0
+	};
+
+	system_info systemInfo;
+	if (get_system_info(&systemInfo) != B_OK)
+		return 0;
+
+	// We start out with all flags set and end up with only those flags
+	// supported across all CPUs found.
+	uint32 systemSIMD = 0xffffffff;
+
+	for (int32 cpu = 0; cpu < systemInfo.cpu_count; cpu++) {
+		cpuid_info cpuInfo;
+		get_cpuid(&cpuInfo, 0, cpu);
+
+		// Get the vendor string and terminate it manually
+		char vendor[13];
+		memcpy(vendor, cpuInfo.eax_0.vendor_id, 12);
+		vendor[12] = 0;
+
+		bool vendorFound = false;
+		for (uint32 i = 0; vendorNames[i] != 0; i++) {
+			if (strcmp(vendor, vendorNames[i]) == 0)
+				vendorFound = true;
+		}
+
+		uint32 cpuSIMD = 0;
+		uint32 maxStdFunc = cpuInfo.regs.eax;
+		if (vendorFound && maxStdFunc >= 1) {
+			get_cpuid(&cpuInfo, 1, 0);
+			uint32 edx = cpuInfo.regs.edx;
+			if (edx & (1 << 23))
+				cpuSIMD |= APPSERVER_SIMD_MMX;
+			if (edx & (1 << 25))
+				cpuSIMD |= APPSERVER_SIMD_SSE;
+			if (edx & (1 << 26))
+				cpuSIMD |= APPSERVER_SIMD_SSE2;
+		} else {
+			// no flags can be identified
+			cpuSIMD = 0;
+		}
+		systemSIMD &= cpuSIMD;
+	}
+	return systemSIMD;
+#elif defined(__x86_64__)
+	// SSE2 is part of the x86_64 base instruction set. The MMX/SSE flags are
+	// not reported, since the assembler routines depending on them are only
+	// available on x86.
+	return APPSERVER_SIMD_SSE2;
+#else
+	return 0;
+#endif
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2009, Christian Packmann.
+ * Copyright 2011, Haiku, Inc.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ *
+ * Runtime detection of the SIMD instruction sets available to the Painter
+ * and the span kernels making use of them.
+ *
+ */
+
+#ifndef PAINTER_SIMD_H
+#define PAINTER_SIMD_H
+
+#include <agg_color_rgba.h>
+
+#include <GraphicsDefs.h>
+#include <SupportDefs.h>
+
+
+// Defines for SIMD support.
+#define APPSERVER_SIMD_MMX	(1 << 0)
+#define APPSERVER_SIMD_SSE	(1 << 1)
+#define APPSERVER_SIMD_SSE2	(1 << 2)
+
+
+// The instruction sets supported by all CPUs in the system, a combination
+// of the APPSERVER_SIMD_* flags.
+extern uint32 gPainterSIMDFlags;
+
+
+// Prototypes for assembler routines
+extern "C" {
+	void bilinear_scale_xloop_mmxsse(const uint8* src, void* dst,
+		void* xWeights, uint32 xmin, uint32 xmax, uint32 wTop, uint32 srcBPR);
+}
+
+
+#ifdef PAINTER_SSE2_KERNELS
+
+// The SSE2 kernels are only compiled in when the compiler supports the
+// intrinsics (PAINTER_SSE2_KERNELS), and may only be called when
+// use_sse2_kernels() returns true. All of them operate on B_RGBA32 rows,
+// which are laid out as B, G, R, A in memory.
+
+static inline bool
+use_sse2_kernels()
+{
+	return (gPainterSIMDFlags & APPSERVER_SIMD_SSE2) != 0;
+}
+
+// B_RGBA32 bitmap row onto the destination, using the source pixel alpha.
+// Same results as copy_bitmap_row_bgr32_alpha() in Painter.cpp.
+void copy_bitmap_row_bgr32_alpha_sse2(uint8* dst, const uint8* src,
+	int32 numPixels);
+
+// blend_color_hspan() variants of B_OP_COPY, B_OP_OVER and B_OP_ALPHA in
+// B_PIXEL_ALPHA/B_ALPHA_OVERLAY mode. Same results as the scalar versions in
+// DrawingModeCopy.h, DrawingModeOver.h and DrawingModeAlphaPO.h, except that
+// the B_OP_ALPHA version uses the alpha of each color also when no covers
+// are given, so it is only used with covers.
+void blend_color_hspan_copy_sse2(uint8* p, const agg::rgba8* colors,
+	const uint8* covers, uint8 cover, const rgb_color& low, uint32 len);
+void blend_color_hspan_over_sse2(uint8* p, const agg::rgba8* colors,
+	const uint8* covers, uint8 cover, uint32 len);
+void blend_color_hspan_alpha_po_sse2(uint8* p, const agg::rgba8* colors,
+	const uint8* covers, uint8 cover, uint32 len);
+
+// Inner x-loop of Painter::_DrawBitmapBilinearCopy32(), interface identical
+// to bilinear_scale_xloop_mmxsse().
+void bilinear_scale_xloop_sse2(const uint8* src, void* dst,
+	void* xWeights, uint32 xmin, uint32 xmax, uint32 wTop, uint32 srcBPR);
+
+#endif	// PAINTER_SSE2_KERNELS
+
+
+#endif // PAINTER_SIMD_H
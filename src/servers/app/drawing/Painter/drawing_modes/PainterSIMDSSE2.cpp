@@ -0,0 +1,413 @@
+/*
+ * Copyright 2011, Haiku, Inc.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ *
+ * SSE2 span kernels for the most common drawing modes and bitmap blits.
+ * All kernels produce exactly the same pixels as the scalar code they
+ * replace, they only process four (bilinear scaling: two) pixels at once.
+ * This file has to be compiled with SSE2 code generation enabled, the
+ * kernels may only be called if use_sse2_kernels() returns true.
+ *
+ */
+
+#include "PainterSIMD.h"
+
+#include <emmintrin.h>
+
+#include "DrawingMode.h"
+
+
+struct FilterInfo {
+	uint16 index;	// index into source bitmap row/column
+	uint16 weight;	// weight of the pixel at index [0..255]
+};
+
+
+// select
+static inline __m128i
+select(__m128i mask, __m128i a, __m128i b)
+{
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+
+// swap_red_blue
+//
+// Converts four agg::rgba8 colors (R, G, B, A in memory) into B_RGBA32
+// pixels (B, G, R, A in memory).
+static inline __m128i
+swap_red_blue(__m128i pixels)
+{
+	const __m128i kGreenAlphaMask = _mm_set1_epi32((int32)0xff00ff00);
+	__m128i redBlue = _mm_andnot_si128(kGreenAlphaMask, pixels);
+	return _mm_or_si128(_mm_and_si128(pixels, kGreenAlphaMask),
+		_mm_or_si128(_mm_srli_epi32(redBlue, 16),
+			_mm_slli_epi32(redBlue, 16)));
+}
+
+
+// load_covers
+//
+// Loads four covers into the lower 16 bits of the 32 bit lanes.
+static inline __m128i
+load_covers(const uint8* covers)
+{
+	const __m128i kZero = _mm_setzero_si128();
+	__m128i result = _mm_cvtsi32_si128(*(const int32*)covers);
+	result = _mm_unpacklo_epi8(result, kZero);
+	return _mm_unpacklo_epi16(result, kZero);
+}
+
+
+// expand_weights
+//
+// Takes one 16 bit weight per pixel in the lower half of the 32 bit lanes
+// and replicates it into the four channels of the two pixels held in each
+// of low and high.
+static inline void
+expand_weights(__m128i weights, __m128i& low, __m128i& high)
+{
+	weights = _mm_or_si128(weights, _mm_slli_epi32(weights, 16));
+	low = _mm_unpacklo_epi32(weights, weights);
+	high = _mm_unpackhi_epi32(weights, weights);
+}
+
+
+// blend8
+//
+// Identical to BLEND on 16 bit channels with weights in range 0..255.
+// ((s - d) * a + (d << 8)) >> 8 is rewritten as (s * a + d * (256 - a)) >> 8
+// which does not exceed 255 * 256 and thus fits into unsigned 16 bits.
+static inline __m128i
+blend8(__m128i d, __m128i s, __m128i a)
+{
+	const __m128i k256 = _mm_set1_epi16(256);
+	return _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(s, a),
+		_mm_mullo_epi16(d, _mm_sub_epi16(k256, a))), 8);
+}
+
+
+// blend16
+//
+// Identical to BLEND16 on 16 bit channels with weights in range 0..65025.
+// The result is d + floor((s - d) * a / 65536), computed separately for
+// positive and negative differences, since the latter have to be rounded
+// towards minus infinity like the arithmetic shift in BLEND16 does.
+static inline __m128i
+blend16(__m128i d, __m128i s, __m128i a)
+{
+	const __m128i kZero = _mm_setzero_si128();
+	const __m128i kOne = _mm_set1_epi16(1);
+	__m128i up = _mm_subs_epu16(s, d);
+	__m128i down = _mm_subs_epu16(d, s);
+	__m128i downRemainder = _mm_andnot_si128(
+		_mm_cmpeq_epi16(_mm_mullo_epi16(down, a), kZero), kOne);
+	return _mm_sub_epi16(_mm_add_epi16(d, _mm_mulhi_epu16(up, a)),
+		_mm_add_epi16(_mm_mulhi_epu16(down, a), downRemainder));
+}
+
+
+// #pragma mark -
+
+
+void
+copy_bitmap_row_bgr32_alpha_sse2(uint8* dst, const uint8* src,
+	int32 numPixels)
+{
+	const __m128i kZero = _mm_setzero_si128();
+	const __m128i kAlphaMask = _mm_set1_epi32((int32)0xff000000);
+
+	for (; numPixels >= 4; numPixels -= 4) {
+		__m128i s = _mm_loadu_si128((const __m128i*)src);
+		__m128i d = _mm_loadu_si128((const __m128i*)dst);
+
+		__m128i weightsLow;
+		__m128i weightsHigh;
+		expand_weights(_mm_srli_epi32(s, 24), weightsLow, weightsHigh);
+
+		__m128i result = _mm_packus_epi16(
+			blend8(_mm_unpacklo_epi8(d, kZero), _mm_unpacklo_epi8(s, kZero),
+				weightsLow),
+			blend8(_mm_unpackhi_epi8(d, kZero), _mm_unpackhi_epi8(s, kZero),
+				weightsHigh));
+
+		// blended pixels keep the destination alpha, opaque ones are copied
+		result = select(kAlphaMask, d, result);
+		result = select(_mm_cmpeq_epi32(_mm_and_si128(s, kAlphaMask),
+			kAlphaMask), s, result);
+
+		_mm_storeu_si128((__m128i*)dst, result);
+		src += 16;
+		dst += 16;
+	}
+
+	for (; numPixels > 0; numPixels--) {
+		if (src[3] == 255) {
+			*(uint32*)dst = *(uint32*)src;
+		} else {
+			dst[0] = ((src[0] - dst[0]) * src[3] + (dst[0] << 8)) >> 8;
+			dst[1] = ((src[1] - dst[1]) * src[3] + (dst[1] << 8)) >> 8;
+			dst[2] = ((src[2] - dst[2]) * src[3] + (dst[2] << 8)) >> 8;
+		}
+		src += 4;
+		dst += 4;
+	}
+}
+
+
+void
+blend_color_hspan_copy_sse2(uint8* p, const agg::rgba8* colors,
+	const uint8* covers, uint8 cover, const rgb_color& low, uint32 len)
+{
+	if (covers == NULL && cover == 0)
+		return;
+
+	const __m128i kZero = _mm_setzero_si128();
+	const __m128i kAlphaMask = _mm_set1_epi32((int32)0xff000000);
+	const __m128i k255 = _mm_set1_epi32(255);
+	const __m128i lowColor = _mm_unpacklo_epi8(
+		_mm_set1_epi32(low.blue | (low.green << 8) | (low.red << 16)), kZero);
+	__m128i weights = _mm_set1_epi32(cover);
+
+	for (; len >= 4; len -= 4) {
+		if (covers != NULL) {
+			weights = load_covers(covers);
+			covers += 4;
+		}
+
+		__m128i c = swap_red_blue(_mm_loadu_si128((const __m128i*)colors));
+
+		__m128i weightsLow;
+		__m128i weightsHigh;
+		expand_weights(weights, weightsLow, weightsHigh);
+
+		__m128i result = _mm_packus_epi16(
+			blend8(lowColor, _mm_unpacklo_epi8(c, kZero), weightsLow),
+			blend8(lowColor, _mm_unpackhi_epi8(c, kZero), weightsHigh));
+		result = _mm_or_si128(result, kAlphaMask);
+
+		result = select(_mm_cmpeq_epi32(weights, k255), c, result);
+		result = select(_mm_cmpeq_epi32(weights, kZero),
+			_mm_loadu_si128((const __m128i*)p), result);
+
+		_mm_storeu_si128((__m128i*)p, result);
+		p += 16;
+		colors += 4;
+	}
+
+	for (; len > 0; len--) {
+		uint8 alpha = covers != NULL ? *covers++ : cover;
+		if (alpha == 255) {
+			p[0] = colors->b;
+			p[1] = colors->g;
+			p[2] = colors->r;
+			p[3] = colors->a;
+		} else if (alpha) {
+			BLEND_FROM(p, low.red, low.green, low.blue, colors->r, colors->g,
+				colors->b, alpha);
+		}
+		p += 4;
+		colors++;
+	}
+}
+
+
+void
+blend_color_hspan_over_sse2(uint8* p, const agg::rgba8* colors,
+	const uint8* covers, uint8 cover, uint32 len)
+{
+	if (covers == NULL && cover == 0)
+		return;
+
+	const __m128i kZero = _mm_setzero_si128();
+	const __m128i kAlphaMask = _mm_set1_epi32((int32)0xff000000);
+	const __m128i k255 = _mm_set1_epi32(255);
+	__m128i weights = _mm_set1_epi32(cover);
+
+	for (; len >= 4; len -= 4) {
+		if (covers != NULL) {
+			weights = load_covers(covers);
+			covers += 4;
+		}
+
+		__m128i c = swap_red_blue(_mm_loadu_si128((const __m128i*)colors));
+		__m128i d = _mm_loadu_si128((const __m128i*)p);
+
+		__m128i weightsLow;
+		__m128i weightsHigh;
+		expand_weights(weights, weightsLow, weightsHigh);
+
+		__m128i result = _mm_packus_epi16(
+			blend8(_mm_unpacklo_epi8(d, kZero), _mm_unpacklo_epi8(c, kZero),
+				weightsLow),
+			blend8(_mm_unpackhi_epi8(d, kZero), _mm_unpackhi_epi8(c, kZero),
+				weightsHigh));
+		result = _mm_or_si128(result, kAlphaMask);
+
+		result = select(_mm_cmpeq_epi32(weights, k255),
+			_mm_or_si128(c, kAlphaMask), result);
+		result = select(_mm_or_si128(_mm_cmpeq_epi32(weights, kZero),
+				_mm_cmpeq_epi32(_mm_and_si128(c, kAlphaMask), kZero)),
+			d, result);
+
+		_mm_storeu_si128((__m128i*)p, result);
+		p += 16;
+		colors += 4;
+	}
+
+	for (; len > 0; len--) {
+		uint8 alpha = covers != NULL ? *covers++ : cover;
+		if (alpha && colors->a > 0) {
+			if (alpha == 255) {
+				p[0] = colors->b;
+				p[1] = colors->g;
+				p[2] = colors->r;
+				p[3] = 255;
+			} else {
+				BLEND(p, colors->r, colors->g, colors->b, alpha);
+			}
+		}
+		p += 4;
+		colors++;
+	}
+}
+
+
+void
+blend_color_hspan_alpha_po_sse2(uint8* p, const agg::rgba8* colors,
+	const uint8* covers, uint8 cover, uint32 len)
+{
+	const __m128i kZero = _mm_setzero_si128();
+	const __m128i kAlphaMask = _mm_set1_epi32((int32)0xff000000);
+	const __m128i kOpaque = _mm_set1_epi32(255 * 255);
+	__m128i coverWeights = _mm_set1_epi32(cover);
+
+	for (; len >= 4; len -= 4) {
+		if (covers != NULL) {
+			coverWeights = load_covers(covers);
+			covers += 4;
+		}
+
+		__m128i c = swap_red_blue(_mm_loadu_si128((const __m128i*)colors));
+		__m128i d = _mm_loadu_si128((const __m128i*)p);
+
+		// color alpha * cover, at most 255 * 255
+		__m128i weights = _mm_mullo_epi16(_mm_srli_epi32(c, 24),
+			coverWeights);
+
+		__m128i weightsLow;
+		__m128i weightsHigh;
+		expand_weights(weights, weightsLow, weightsHigh);
+
+		__m128i result = _mm_packus_epi16(
+			blend16(_mm_unpacklo_epi8(d, kZero), _mm_unpacklo_epi8(c, kZero),
+				weightsLow),
+			blend16(_mm_unpackhi_epi8(d, kZero), _mm_unpackhi_epi8(c, kZero),
+				weightsHigh));
+		result = _mm_or_si128(result, kAlphaMask);
+
+		result = select(_mm_cmpeq_epi32(weights, kOpaque),
+			_mm_or_si128(c, kAlphaMask), result);
+		result = select(_mm_cmpeq_epi32(weights, kZero), d, result);
+
+		_mm_storeu_si128((__m128i*)p, result);
+		p += 16;
+		colors += 4;
+	}
+
+	for (; len > 0; len--) {
+		uint16 alpha = colors->a * (covers != NULL ? *covers++ : cover);
+		if (alpha) {
+			if (alpha == 255 * 255) {
+				p[0] = colors->b;
+				p[1] = colors->g;
+				p[2] = colors->r;
+				p[3] = 255;
+			} else {
+				BLEND16(p, colors->r, colors->g, colors->b, alpha);
+			}
+		}
+		p += 4;
+		colors++;
+	}
+}
+
+
+void
+bilinear_scale_xloop_sse2(const uint8* src, void* dst, void* xWeights,
+	uint32 xmin, uint32 xmax, uint32 wTop, uint32 srcBPR)
+{
+	const FilterInfo* weights = (const FilterInfo*)xWeights;
+	uint8* d = (uint8*)dst;
+
+	const __m128i kZero = _mm_setzero_si128();
+	const __m128i k255 = _mm_set1_epi16(255);
+	const __m128i kSignFlip = _mm_set1_epi16((int16)0x8000);
+	const __m128i kColorMask = _mm_set1_epi32(0x00ffffff);
+	const __m128i top = _mm_set1_epi16(wTop);
+	const __m128i bottom = _mm_set1_epi16(255 - wTop);
+
+	int32 x = xmin;
+	for (; x < (int32)xmax; x += 2) {
+		const uint8* s0 = src + weights[x].index;
+		const uint8* s1 = src + weights[x + 1].index;
+
+		// left and right source pixel for both destination pixels,
+		// reordered to left0 left1 right0 right1
+		__m128i topRow = _mm_unpacklo_epi64(
+			_mm_loadl_epi64((const __m128i*)s0),
+			_mm_loadl_epi64((const __m128i*)s1));
+		__m128i bottomRow = _mm_unpacklo_epi64(
+			_mm_loadl_epi64((const __m128i*)(s0 + srcBPR)),
+			_mm_loadl_epi64((const __m128i*)(s1 + srcBPR)));
+		topRow = _mm_shuffle_epi32(topRow, _MM_SHUFFLE(3, 1, 2, 0));
+		bottomRow = _mm_shuffle_epi32(bottomRow, _MM_SHUFFLE(3, 1, 2, 0));
+
+		// vertical interpolation first, at most 255 * 255 per channel
+		__m128i left = _mm_add_epi16(
+			_mm_mullo_epi16(_mm_unpacklo_epi8(topRow, kZero), top),
+			_mm_mullo_epi16(_mm_unpacklo_epi8(bottomRow, kZero), bottom));
+		__m128i right = _mm_add_epi16(
+			_mm_mullo_epi16(_mm_unpackhi_epi8(topRow, kZero), top),
+			_mm_mullo_epi16(_mm_unpackhi_epi8(bottomRow, kZero), bottom));
+
+		const uint16 w0 = weights[x].weight;
+		const uint16 w1 = weights[x + 1].weight;
+		__m128i wLeft = _mm_set_epi16(w1, w1, w1, w1, w0, w0, w0, w0);
+		__m128i wRight = _mm_sub_epi16(k255, wLeft);
+
+		// (left * wLeft + right * wRight) >> 16, the carry of the lower
+		// halves is added to the sum of the upper halves
+		__m128i lowLeft = _mm_mullo_epi16(left, wLeft);
+		__m128i lowSum = _mm_add_epi16(lowLeft, _mm_mullo_epi16(right, wRight));
+		__m128i carry = _mm_cmpgt_epi16(_mm_xor_si128(lowLeft, kSignFlip),
+			_mm_xor_si128(lowSum, kSignFlip));
+		__m128i result = _mm_sub_epi16(
+			_mm_add_epi16(_mm_mulhi_epu16(left, wLeft),
+				_mm_mulhi_epu16(right, wRight)),
+			carry);
+
+		// the destination alpha is left untouched
+		result = select(kColorMask, _mm_packus_epi16(result, kZero),
+			_mm_loadl_epi64((const __m128i*)d));
+		_mm_storel_epi64((__m128i*)d, result);
+		d += 8;
+	}
+
+	if (x == (int32)xmax) {
+		const uint8* s = src + weights[x].index;
+		const uint16 wLeft = weights[x].weight;
+		const uint16 wRight = 255 - wLeft;
+		const uint16 wBottom = 255 - wTop;
+		uint32 t0 = (s[0] * wLeft + s[4] * wRight) * wTop;
+		uint32 t1 = (s[1] * wLeft + s[5] * wRight) * wTop;
+		uint32 t2 = (s[2] * wLeft + s[6] * wRight) * wTop;
+		s += srcBPR;
+		t0 += (s[0] * wLeft + s[4] * wRight) * wBottom;
+		t1 += (s[1] * wLeft + s[5] * wRight) * wBottom;
+		t2 += (s[2] * wLeft + s[6] * wRight) * wBottom;
+		d[0] = t0 >> 16;
+		d[1] = t1 >> 16;
+		d[2] = t2 >> 16;
+	}
+}
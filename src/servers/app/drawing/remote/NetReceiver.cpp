@@ -16,6 +16,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <zlib.h>
+
 #define TRACE(x...)			/*debug_printf("NetReceiver: "x)*/
 #define TRACE_ERROR(x...)	debug_printf("NetReceiver: "x)
 
@@ -26,7 +28,9 @@ NetReceiver::NetReceiver(BNetEndpoint *listener, StreamingRingBuffer *target)
 	fTarget(target),
 	fReceiverThread(-1),
 	fStopThread(false),
-	fEndpoint(NULL)
+	fEndpoint(NULL),
+	fBytesReceived(0),
+	fBytesWritten(0)
 {
 	fReceiverThread = spawn_thread(_NetworkReceiverEntry, "network receiver",
 		B_NORMAL_PRIORITY, this);
@@ -56,6 +60,45 @@ NetReceiver::_NetworkReceiverEntry(void *data)
 }
 
 
+/*!	Inflates the compressed stream the NetSender on the other side produced
+	(see NetSender::_NetworkSender()) into \a target.
+*/
+static status_t
+inflate_to(z_stream& stream, const uint8 *buffer, int32 size,
+	StreamingRingBuffer *target, int64 *bytesWritten)
+{
+	stream.next_in = (Bytef*)buffer;
+	stream.avail_in = size;
+
+	do {
+		uint8 inflated[16384];
+		stream.next_out = inflated;
+		stream.avail_out = sizeof(inflated);
+
+		int zlibResult = inflate(&stream, Z_SYNC_FLUSH);
+		if (zlibResult != Z_OK && zlibResult != Z_BUF_ERROR) {
+			TRACE_ERROR("decompression failed: %d\n", zlibResult);
+			return B_BAD_DATA;
+		}
+
+		size_t inflatedSize = sizeof(inflated) - stream.avail_out;
+		if (inflatedSize == 0)
+			continue;
+
+		status_t result = target->Write(inflated, inflatedSize);
+		if (result != B_OK) {
+			TRACE_ERROR("writing to ring buffer failed: %s\n",
+				strerror(result));
+			return result;
+		}
+
+		atomic_add64(bytesWritten, inflatedSize);
+	} while (stream.avail_out == 0);
+
+	return B_OK;
+}
+
+
 status_t
 NetReceiver::_NetworkReceiver()
 {
@@ -65,11 +108,23 @@ NetReceiver::_NetworkReceiver()
 		return result;
 	}
 
+	z_stream stream;
+	memset(&stream, 0, sizeof(stream));
+
+	int zlibResult = inflateInit(&stream);
+	if (zlibResult != Z_OK) {
+		TRACE_ERROR("failed to initialize decompression: %d\n", zlibResult);
+		return B_NO_MEMORY;
+	}
+
 	while (!fStopThread) {
 		fEndpoint = fListener->Accept(1000);
 		if (fEndpoint == NULL)
 			continue;
 
+		// every connection starts a new compressed stream
+		inflateReset(&stream);
+
 		int32 errorCount = 0;
 		TRACE("new endpoint connection: %p\n", fEndpoint);
 		while (!fStopThread) {
@@ -81,6 +136,7 @@ NetReceiver::_NetworkReceiver()
 				BNetEndpoint *endpoint = fEndpoint;
 				fEndpoint = NULL;
 				delete endpoint;
+				inflateEnd(&stream);
 				return readSize;
 			}
 
@@ -97,14 +153,17 @@ NetReceiver::_NetworkReceiver()
 			}
 
 			errorCount = 0;
-			status_t result = fTarget->Write(buffer, readSize);
+			atomic_add64(&fBytesReceived, readSize);
+
+			status_t result = inflate_to(stream, buffer, readSize, fTarget,
+				&fBytesWritten);
 			if (result != B_OK) {
-				TRACE_ERROR("writing to ring buffer failed: %s\n",
-					strerror(result));
+				inflateEnd(&stream);
 				return result;
 			}
 		}
 	}
 
+	inflateEnd(&stream);
 	return B_OK;
 }
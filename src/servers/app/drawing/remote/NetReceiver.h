@@ -22,6 +22,11 @@ public:
 
 		BNetEndpoint *			Endpoint() { return fEndpoint; }
 
+		int64					BytesReceived() const
+									{ return fBytesReceived; }
+		int64					BytesWritten() const
+									{ return fBytesWritten; }
+
 private:
 static	int32					_NetworkReceiverEntry(void *data);
 		status_t				_NetworkReceiver();
@@ -33,6 +38,9 @@ static	int32					_NetworkReceiverEntry(void *data);
 		bool					fStopThread;
 
 		BNetEndpoint *			fEndpoint;
+
+		int64					fBytesReceived;
+		int64					fBytesWritten;
 };
 
 #endif // NET_RECEIVER_H
@@ -16,6 +16,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <zlib.h>
+
 #define TRACE(x...)			/*debug_printf("NetSender: "x)*/
 #define TRACE_ERROR(x...)	debug_printf("NetSender: "x)
 
@@ -25,7 +27,9 @@ NetSender::NetSender(BNetEndpoint *endpoint, StreamingRingBuffer *source)
 	fEndpoint(endpoint),
 	fSource(source),
 	fSenderThread(-1),
-	fStopThread(false)
+	fStopThread(false),
+	fBytesRead(0),
+	fBytesSent(0)
 {
 	fSenderThread = spawn_thread(_NetworkSenderEntry, "network sender",
 		B_NORMAL_PRIORITY, this);
@@ -48,27 +52,75 @@ NetSender::_NetworkSenderEntry(void *data)
 }
 
 
+/*!	The stream is deflate compressed, and flushed after each chunk read from
+	the source, so that the other side always gets complete messages without
+	delay. Drawing commands compress very well, as do most bitmaps.
+*/
 status_t
 NetSender::_NetworkSender()
 {
-	while (!fStopThread) {
+	z_stream stream;
+	memset(&stream, 0, sizeof(stream));
+
+	int zlibResult = deflateInit(&stream, Z_BEST_SPEED);
+	if (zlibResult != Z_OK) {
+		TRACE_ERROR("failed to initialize compression: %d\n", zlibResult);
+		return B_NO_MEMORY;
+	}
+
+	status_t result = B_OK;
+	while (!fStopThread && result == B_OK) {
 		uint8 buffer[4096];
 		int32 readSize = fSource->Read(buffer, sizeof(buffer), true);
 		if (readSize < 0) {
 			TRACE_ERROR("read failed, stopping sender thread: %s\n",
 				strerror(readSize));
-			return readSize;
+			result = readSize;
+			break;
 		}
 
-		while (readSize > 0) {
-			int32 sendSize = fEndpoint->Send(buffer, readSize);
-			if (sendSize < 0) {
-				TRACE_ERROR("sending data failed: %s\n", strerror(sendSize));
-				return sendSize;
+		if (readSize == 0)
+			continue;
+
+		atomic_add64(&fBytesRead, readSize);
+
+		stream.next_in = buffer;
+		stream.avail_in = readSize;
+
+		do {
+			uint8 compressed[4096];
+			stream.next_out = compressed;
+			stream.avail_out = sizeof(compressed);
+
+			zlibResult = deflate(&stream, Z_SYNC_FLUSH);
+			if (zlibResult != Z_OK && zlibResult != Z_BUF_ERROR) {
+				TRACE_ERROR("compression failed: %d\n", zlibResult);
+				result = B_ERROR;
+				break;
 			}
 
-			readSize -= sendSize;
+			result = _Send(compressed, sizeof(compressed) - stream.avail_out);
+		} while (result == B_OK && stream.avail_out == 0);
+	}
+
+	deflateEnd(&stream);
+	return result;
+}
+
+
+status_t
+NetSender::_Send(const uint8 *buffer, int32 length)
+{
+	while (length > 0) {
+		int32 sendSize = fEndpoint->Send(buffer, length);
+		if (sendSize < 0) {
+			TRACE_ERROR("sending data failed: %s\n", strerror(sendSize));
+			return sendSize;
 		}
+
+		atomic_add64(&fBytesSent, sendSize);
+		buffer += sendSize;
+		length -= sendSize;
 	}
 
 	return B_OK;
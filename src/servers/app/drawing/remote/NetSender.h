@@ -20,15 +20,24 @@ public:
 									StreamingRingBuffer *source);
 								~NetSender();
 
+		int64					BytesRead() const
+									{ return fBytesRead; }
+		int64					BytesSent() const
+									{ return fBytesSent; }
+
 private:
 static	int32					_NetworkSenderEntry(void *data);
 		status_t				_NetworkSender();
+		status_t				_Send(const uint8 *buffer, int32 length);
 
 		BNetEndpoint *			fEndpoint;
 		StreamingRingBuffer *	fSource;
 
 		thread_id				fSenderThread;
 		bool					fStopThread;
+
+		int64					fBytesRead;
+		int64					fBytesSent;
 };
 
 #endif // NET_SENDER_H
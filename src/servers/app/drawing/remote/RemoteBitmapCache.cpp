@@ -0,0 +1,91 @@
+/*
+ * Copyright 2011, Haiku, Inc.
+ * Distributed under the terms of the MIT License.
+ */
+
+#include "RemoteBitmapCache.h"
+
+#include <string.h>
+
+
+static const uint64 kFNVOffsetBasis = 14695981039346656037ULL;
+static const uint64 kFNVPrime = 1099511628211ULL;
+
+
+RemoteBitmapCache::RemoteBitmapCache()
+	:
+	fLock("remote bitmap cache")
+{
+	MakeEmpty();
+}
+
+
+/*!	Returns whether the bitmap with the given \a checksum is already in the
+	client's cache, and in which \a _slot. If it isn't, the slot is assigned
+	to it, and the caller must send the bitmap along, since the client will
+	put it there as well. The cache must be locked across this call and
+	sending the message to keep the order of the lookups and the messages
+	the same.
+*/
+bool
+RemoteBitmapCache::Lookup(uint64 checksum, uint32& _slot)
+{
+	// 0 marks an empty slot
+	if (checksum == 0)
+		checksum = 1;
+
+	_slot = checksum % SLOT_COUNT;
+	if (fChecksums[_slot] == checksum)
+		return true;
+
+	fChecksums[_slot] = checksum;
+	return false;
+}
+
+
+/*!	Empties the \a slot, if it still belongs to the bitmap with the given
+	\a checksum, so that the bitmap is sent along again the next time it is
+	drawn. The client asks for this when it could not keep the bitmap.
+*/
+void
+RemoteBitmapCache::Drop(uint32 slot, uint64 checksum)
+{
+	if (slot < SLOT_COUNT && fChecksums[slot] == checksum)
+		fChecksums[slot] = 0;
+}
+
+
+void
+RemoteBitmapCache::MakeEmpty()
+{
+	memset(fChecksums, 0, sizeof(fChecksums));
+}
+
+
+/*!	Computes a 64 bit FNV-1a hash over the bitmap bits and its layout. It
+	works on 32 bit words for speed, as the rows are usually padded to them
+	anyway.
+*/
+/*static*/ uint64
+RemoteBitmapCache::Checksum(const uint8* bits, uint32 bitsLength, int32 width,
+	int32 height, int32 bytesPerRow, color_space colorSpace)
+{
+	uint64 hash = kFNVOffsetBasis;
+	hash = (hash ^ (uint32)width) * kFNVPrime;
+	hash = (hash ^ (uint32)height) * kFNVPrime;
+	hash = (hash ^ (uint32)bytesPerRow) * kFNVPrime;
+	hash = (hash ^ (uint32)colorSpace) * kFNVPrime;
+
+	const uint32* words = (const uint32*)bits;
+	for (uint32 i = bitsLength / sizeof(uint32); i > 0; i--)
+		hash = (hash ^ *words++) * kFNVPrime;
+
+	const uint8* rest = (const uint8*)words;
+	for (uint32 i = bitsLength % sizeof(uint32); i > 0; i--)
+		hash = (hash ^ *rest++) * kFNVPrime;
+
+	if (hash == 0)
+		hash = 1;
+
+	return hash;
+}
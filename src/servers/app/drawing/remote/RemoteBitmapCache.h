@@ -0,0 +1,47 @@
+/*
+ * Copyright 2011, Haiku, Inc.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef REMOTE_BITMAP_CACHE_H
+#define REMOTE_BITMAP_CACHE_H
+
+#include <GraphicsDefs.h>
+#include <Locker.h>
+#include <SupportDefs.h>
+
+// Mirrors the bitmap cache of the remote client, so that bitmaps that are
+// drawn over and over again (icons, button and scroll bar graphics) only have
+// to be transferred once. The cache is direct mapped by checksum: since both
+// sides see the same sequence of RP_DRAW_CACHED_BITMAP messages, they always
+// agree on what is in which slot. The client only answers if it could not
+// keep a bitmap, with an RP_DROP_CACHED_BITMAP message.
+class RemoteBitmapCache {
+public:
+		enum {
+			SLOT_COUNT		= 64,
+			MIN_BITS_LENGTH	= 1024,
+			MAX_BITS_LENGTH	= 256 * 1024
+		};
+
+								RemoteBitmapCache();
+
+		BLocker&				Locker() { return fLock; }
+
+		bool					Lookup(uint64 checksum, uint32& _slot);
+		void					Drop(uint32 slot, uint64 checksum);
+		void					MakeEmpty();
+
+static	bool					IsCacheable(uint32 bitsLength)
+									{ return bitsLength >= MIN_BITS_LENGTH
+										&& bitsLength <= MAX_BITS_LENGTH; }
+static	uint64					Checksum(const uint8* bits,
+									uint32 bitsLength, int32 width,
+									int32 height, int32 bytesPerRow,
+									color_space colorSpace);
+
+private:
+		BLocker					fLock;
+		uint64					fChecksums[SLOT_COUNT];
+};
+
+#endif // REMOTE_BITMAP_CACHE_H
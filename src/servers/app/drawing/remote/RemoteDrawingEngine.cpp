@@ -12,6 +12,7 @@
 #include "BitmapDrawingEngine.h"
 #include "DrawState.h"
 
+#include <Autolock.h>
 #include <Bitmap.h>
 #include <utf8_functions.h>
 
@@ -357,7 +358,35 @@ RemoteDrawingEngine::DrawBitmap(ServerBitmap* bitmap, const BRect& _bitmapRect,
 		return;
 	}
 
-	// TODO: we may want to cache/checksum bitmaps
+	uint32 bitsLength = bitmap->BitsLength();
+	if (RemoteBitmapCache::IsCacheable(bitsLength)) {
+		uint64 checksum = RemoteBitmapCache::Checksum(bitmap->Bits(),
+			bitsLength, bitmap->Width(), bitmap->Height(),
+			bitmap->BytesPerRow(), bitmap->ColorSpace());
+
+		RemoteBitmapCache& cache = fHWInterface->BitmapCache();
+		BAutolock locker(cache.Locker());
+
+		uint32 slot;
+		bool cached = cache.Lookup(checksum, slot);
+
+		RemoteMessage message(NULL, fHWInterface->SendBuffer());
+		message.Start(RP_DRAW_CACHED_BITMAP);
+		message.Add(fToken);
+		message.Add(bitmapRect);
+		message.Add(viewRect);
+		message.Add(options);
+		message.Add(slot);
+		message.Add(checksum);
+		message.Add(cached);
+		if (!cached)
+			message.AddBitmap(*bitmap);
+
+		// the message needs to go out while we still hold the cache lock
+		message.Flush();
+		return;
+	}
+
 	RemoteMessage message(NULL, fHWInterface->SendBuffer());
 	message.Start(RP_DRAW_BITMAP);
 	message.Add(fToken);
@@ -280,6 +280,18 @@ RemoteHWInterface::_EventThread()
 				break;
 			}
 
+			case RP_DROP_CACHED_BITMAP:
+			{
+				uint32 slot;
+				uint64 checksum;
+				message.Read(slot);
+				if (message.Read(checksum) == B_OK) {
+					BAutolock locker(fBitmapCache.Locker());
+					fBitmapCache.Drop(slot, checksum);
+				}
+				break;
+			}
+
 			default:
 			{
 				uint32 token;
@@ -308,6 +320,9 @@ RemoteHWInterface::_Connect()
 		return result;
 	}
 
+	// a new client starts out with an empty bitmap cache
+	fBitmapCache.MakeEmpty();
+
 	RemoteMessage message(fReceiveBuffer, fSendBuffer);
 	message.Start(RP_INIT_CONNECTION);
 	message.Add(fListenPort);
@@ -9,6 +9,7 @@
 #define REMOTE_HW_INTERFACE_H
 
 #include "HWInterface.h"
+#include "RemoteBitmapCache.h"
 
 #include <Locker.h>
 #include <ObjectList.h>
@@ -78,6 +79,7 @@ virtual	status_t					CopyBackToFront(const BRect& frame);
 		// drawing engine interface
 		StreamingRingBuffer*		ReceiveBuffer() { return fReceiveBuffer; }
 		StreamingRingBuffer*		SendBuffer() { return fSendBuffer; }
+		RemoteBitmapCache&			BitmapCache() { return fBitmapCache; }
 
 typedef bool (*CallbackFunction)(void* cookie, RemoteMessage& message);
 
@@ -117,6 +119,8 @@ static	int32						_EventThreadEntry(void* data);
 		NetSender*					fSender;
 		NetReceiver*				fReceiver;
 
+		RemoteBitmapCache			fBitmapCache;
+
 		thread_id					fEventThread;
 		RemoteEventStream*			fEventStream;
 
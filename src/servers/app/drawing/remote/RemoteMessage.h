@@ -61,6 +61,8 @@ enum {
 	RP_INVERT_RECT,
 	RP_DRAW_BITMAP,
 	RP_DRAW_BITMAP_RECTS,
+	RP_DRAW_CACHED_BITMAP,
+	RP_DROP_CACHED_BITMAP,
 
 	RP_STROKE_ARC = 80,
 	RP_STROKE_BEZIER,
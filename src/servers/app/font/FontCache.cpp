@@ -12,7 +12,11 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <Autolock.h>
+#include <Directory.h>
 #include <Entry.h>
+#include <File.h>
+#include <FindDirectory.h>
 #include <Path.h>
 
 #include "AutoLocker.h"
@@ -21,6 +25,23 @@
 using std::nothrow;
 
 
+static const bigtime_t kGlyphSaveInterval = 2 * 60 * 1000000LL;
+static const size_t kSignatureSize = B_PATH_NAME_LENGTH * 2;
+
+
+struct FontCache::PersistentFont {
+	PersistentFont(const ServerFont& font)
+		:
+		font(font),
+		savedGlyphCount(0)
+	{
+	}
+
+	ServerFont	font;
+	uint32		savedGlyphCount;
+};
+
+
 FontCache
 FontCache::sDefaultInstance;
 
@@ -30,12 +51,23 @@ FontCache::sDefaultInstance;
 FontCache::FontCache()
 	: MultiLocker("FontCache lock")
 	, fFontCacheEntries()
+	, fPersistentFonts(2, true)
+	, fSaveLock("font cache saving")
+	, fSaverSem(-1)
+	, fSaverThread(-1)
 {
 }
 
 // destructor
 FontCache::~FontCache()
 {
+	if (fSaverThread >= 0) {
+		// deleting the semaphore makes the saver thread quit
+		delete_sem(fSaverSem);
+		status_t result;
+		wait_for_thread(fSaverThread, &result);
+	}
+
 	FontMap::Iterator iterator = fFontCacheEntries.GetIterator();
 	while (iterator.HasNext())
 		iterator.Next().value->ReleaseReference();
@@ -85,13 +117,23 @@ FontCache::FontCacheEntryFor(const ServerFont& font)
 		// remove old entries, keep entries below certain count
 		_ConstrainEntryCount();
 		entry = new (nothrow) FontCacheEntry();
-		if (!entry || !entry->Init(font)
-			|| fFontCacheEntries.Put(signature, entry) < B_OK) {
+		if (!entry || !entry->Init(font)) {
 			fprintf(stderr, "FontCache::FontCacheEntryFor() - "
 				"out of memory or no font file\n");
 			delete entry;
 			return NULL;
 		}
+
+		PersistentFont* persistentFont = _PersistentFontFor(signature);
+		if (persistentFont != NULL)
+			_LoadPersistentGlyphs(entry, persistentFont);
+
+		if (fFontCacheEntries.Put(signature, entry) < B_OK) {
+			fprintf(stderr, "FontCache::FontCacheEntryFor() - "
+				"out of memory\n");
+			delete entry;
+			return NULL;
+		}
 	}
 //printf("FontCacheEntryFor(%ld): %p (insert)\n", font.GetFamilyAndStyle(), entry);
 
@@ -110,6 +152,112 @@ FontCache::Recycle(FontCacheEntry* entry)
 	entry->ReleaseReference();
 }
 
+/*!	Marks \a font as one of the fonts whose glyphs are kept in a file, so
+	that they don't need to be rendered again after the server restarted.
+	This is meant for the few fonts used by the user interface.
+*/
+void
+FontCache::AddPersistentFont(const ServerFont& font)
+{
+	PersistentFont* persistentFont = new (nothrow) PersistentFont(font);
+	if (persistentFont == NULL)
+		return;
+
+	AutoWriteLocker locker(this);
+	if (!locker.IsLocked() || !fPersistentFonts.AddItem(persistentFont)) {
+		delete persistentFont;
+		return;
+	}
+
+	if (fSaverThread < 0) {
+		fSaverSem = create_sem(0, "font cache saver");
+		if (fSaverSem < B_OK)
+			return;
+
+		fSaverThread = spawn_thread(_SaverEntry, "font cache saver",
+			B_LOW_PRIORITY, this);
+		if (fSaverThread < B_OK) {
+			delete_sem(fSaverSem);
+			return;
+		}
+
+		resume_thread(fSaverThread);
+	}
+}
+
+
+/*!	Writes the glyphs of the persistent fonts to their files, if any glyphs
+	have been added since they were last written. This is also done
+	periodically by the saver thread; fSaveLock makes sure only one thread
+	at a time writes the files.
+*/
+void
+FontCache::SavePersistentGlyphs()
+{
+	BAutolock saveLocker(fSaveLock);
+
+	if (!ReadLock())
+		return;
+
+	for (int32 i = 0; i < fPersistentFonts.CountItems(); i++) {
+		PersistentFont* persistentFont = fPersistentFonts.ItemAt(i);
+
+		char signature[kSignatureSize];
+		FontCacheEntry::GenerateSignature(signature, sizeof(signature),
+			persistentFont->font);
+
+		FontCacheEntry* entry = fFontCacheEntries.Get(signature);
+		if (entry == NULL)
+			continue;
+
+		// The saved glyph count is also set when the entry is created, so
+		// it's only accessed while holding our lock.
+		uint32 savedGlyphCount = persistentFont->savedGlyphCount;
+		bool saved = false;
+
+		// Don't hold our lock while waiting for the entry lock; a thread
+		// holding the entry lock might need ours to get a fallback entry.
+		entry->AcquireReference();
+		ReadUnlock();
+
+		BString persistentSignature;
+		BPath path;
+		uint32 glyphCount = 0;
+		if (entry->ReadLock()) {
+			glyphCount = entry->CountGlyphs();
+			if (glyphCount != savedGlyphCount
+				&& _GetGlyphFile(persistentFont->font, persistentSignature,
+					path) == B_OK) {
+				// write into a temporary file first, so that an incomplete
+				// file cannot replace a good one
+				BString tempPath = path.Path();
+				tempPath << ".temp";
+
+				BFile file(tempPath.String(),
+					B_CREATE_FILE | B_ERASE_FILE | B_WRITE_ONLY);
+				if (file.InitCheck() == B_OK
+					&& entry->WriteGlyphs(file,
+						persistentSignature.String()) == B_OK) {
+					BEntry tempEntry(tempPath.String());
+					saved = tempEntry.Rename(path.Leaf(), true) == B_OK;
+				}
+			}
+			entry->ReadUnlock();
+		}
+
+		entry->ReleaseReference();
+
+		if (!ReadLock())
+			return;
+
+		if (saved)
+			persistentFont->savedGlyphCount = glyphCount;
+	}
+
+	ReadUnlock();
+}
+
+
 static const int32 kMaxEntryCount = 30;
 
 static inline double
@@ -159,3 +307,90 @@ FontCache::_ConstrainEntryCount()
 		}
 	}
 }
+
+
+FontCache::PersistentFont*
+FontCache::_PersistentFontFor(const char* signature)
+{
+	for (int32 i = 0; i < fPersistentFonts.CountItems(); i++) {
+		PersistentFont* persistentFont = fPersistentFonts.ItemAt(i);
+
+		// the signature depends on the global rendering settings, too,
+		// so it cannot be computed in advance
+		char fontSignature[kSignatureSize];
+		FontCacheEntry::GenerateSignature(fontSignature,
+			sizeof(fontSignature), persistentFont->font);
+		if (!strcmp(signature, fontSignature))
+			return persistentFont;
+	}
+
+	return NULL;
+}
+
+
+/*!	Returns the path of the glyph file of \a font, and the signature that
+	identifies the font file and rendering settings the glyphs are valid for.
+*/
+/*static*/ status_t
+FontCache::_GetGlyphFile(const ServerFont& font, BString& signature,
+	BPath& path)
+{
+	struct stat stat;
+	BEntry fontEntry(font.Path());
+	status_t status = fontEntry.GetStat(&stat);
+	if (status != B_OK)
+		return status;
+
+	char persistentSignature[kSignatureSize];
+	FontCacheEntry::GeneratePersistentSignature(persistentSignature,
+		sizeof(persistentSignature), font, stat);
+	signature = persistentSignature;
+
+	status = find_directory(B_COMMON_CACHE_DIRECTORY, &path, true);
+	if (status == B_OK)
+		status = path.Append("app_server");
+	if (status == B_OK)
+		status = create_directory(path.Path(), 0755);
+	if (status != B_OK)
+		return status;
+
+	char name[B_FILE_NAME_LENGTH];
+	snprintf(name, sizeof(name), "glyphs-%08lx",
+		string_hash(persistentSignature));
+	return path.Append(name);
+}
+
+
+void
+FontCache::_LoadPersistentGlyphs(FontCacheEntry* entry,
+	PersistentFont* persistentFont)
+{
+	// this function is only ever called with the WriteLock held, and
+	// before the entry is available to anyone else
+
+	BString signature;
+	BPath path;
+	if (_GetGlyphFile(persistentFont->font, signature, path) != B_OK)
+		return;
+
+	BFile file(path.Path(), B_READ_ONLY);
+	if (file.InitCheck() != B_OK)
+		return;
+
+	entry->ReadGlyphs(file, signature.String());
+	persistentFont->savedGlyphCount = entry->CountGlyphs();
+}
+
+
+/*static*/ status_t
+FontCache::_SaverEntry(void* data)
+{
+	FontCache* cache = (FontCache*)data;
+
+	while (acquire_sem_etc(cache->fSaverSem, 1, B_RELATIVE_TIMEOUT,
+			kGlyphSaveInterval) == B_TIMED_OUT) {
+		cache->SavePersistentGlyphs();
+	}
+
+	return B_OK;
+}
@@ -9,6 +9,9 @@
 #ifndef FONT_CACHE_H
 #define FONT_CACHE_H
 
+#include <Locker.h>
+#include <ObjectList.h>
+
 #include "FontCacheEntry.h"
 #include "HashMap.h"
 #include "HashString.h"
@@ -16,6 +19,9 @@
 #include "ServerFont.h"
 
 
+class BPath;
+
+
 class FontCache : public MultiLocker {
  public:
 								FontCache();
@@ -27,14 +33,31 @@ class FontCache : public MultiLocker {
 			FontCacheEntry*		FontCacheEntryFor(const ServerFont& font);
 			void				Recycle(FontCacheEntry* entry);
 
+			void				AddPersistentFont(const ServerFont& font);
+			void				SavePersistentGlyphs();
+
  private:
+			struct PersistentFont;
+
 			void				_ConstrainEntryCount();
 
+			PersistentFont*		_PersistentFontFor(const char* signature);
+	static	status_t			_GetGlyphFile(const ServerFont& font,
+									BString& signature, BPath& path);
+			void				_LoadPersistentGlyphs(FontCacheEntry* entry,
+									PersistentFont* font);
+	static	status_t			_SaverEntry(void* data);
+
 	static	FontCache			sDefaultInstance;
 
 	typedef HashMap<HashString, FontCacheEntry*> FontMap;
 
 			FontMap				fFontCacheEntries;
+
+			BObjectList<PersistentFont> fPersistentFonts;
+			BLocker				fSaveLock;
+			sem_id				fSaverSem;
+			thread_id			fSaverThread;
 };
 
 #endif // FONT_CACHE_H
@@ -26,11 +26,14 @@
 
 #include "FontCacheEntry.h"
 
+#include <stdlib.h>
 #include <string.h>
 
 #include <new>
 
 #include <Autolock.h>
+#include <DataIO.h>
+#include <StorageDefs.h>
 
 #include <agg_array.h>
 #include <utf8_functions.h>
@@ -40,6 +43,33 @@
 
 
 BLocker FontCacheEntry::sUsageUpdateLock("FontCacheEntry usage lock");
+font_cache_statistics gFontCacheStatistics;
+
+
+// the file format used by WriteGlyphs() and ReadGlyphs(): the header is
+// followed by the signature, and each glyph by its data
+
+static const uint32 kGlyphFileMagic = 'FCgl';
+static const uint32 kGlyphFileVersion = 1;
+static const uint32 kMaxGlyphDataSize = 1024 * 1024;
+
+struct glyph_file_header {
+	uint32			magic;
+	uint32			version;
+	uint32			signature_length;
+	uint32			glyph_count;
+};
+
+struct glyph_file_entry {
+	uint32			glyph_index;
+	uint32			data_size;
+	uint32			data_type;
+	int32			bounds[4];
+	float			advance_x;
+	float			advance_y;
+	float			inset_left;
+	float			inset_right;
+};
 
 
 class FontCacheEntry::GlyphCachePool {
@@ -70,6 +100,8 @@ class FontCacheEntry::GlyphCachePool {
 		}
 	};
 public:
+	typedef BOpenHashTable<GlyphHashTableDefinition> GlyphTable;
+
 	GlyphCachePool()
 	{
 	}
@@ -117,9 +149,17 @@ public:
 		return glyph;
 	}
 
-private:
-	typedef BOpenHashTable<GlyphHashTableDefinition> GlyphTable;
+	uint32 CountGlyphs() const
+	{
+		return fGlyphTable.CountElements();
+	}
+
+	GlyphTable::Iterator GetIterator() const
+	{
+		return fGlyphTable.GetIterator();
+	}
 
+private:
 	GlyphTable	fGlyphTable;
 };
 
@@ -131,6 +171,8 @@ FontCacheEntry::FontCacheEntry()
 	:
 	MultiLocker("FontCacheEntry lock"),
 	fGlyphCache(new(std::nothrow) GlyphCachePool()),
+	fGlyphAtlas(),
+	fGlyphRunCache(),
 	fEngine(),
 	fLastUsedTime(LONGLONG_MIN),
 	fUseCounter(0)
@@ -168,6 +210,11 @@ FontCacheEntry::Init(const ServerFont& font)
 			"GlyphCache table for font file %s\n", font.Path());
 		return false;
 	}
+	if (fGlyphRunCache.Init() != B_OK) {
+		fprintf(stderr, "FontCacheEntry::Init() - failed to allocate "
+			"GlyphRun table for font file %s\n", font.Path());
+		return false;
+	}
 
 	return true;
 }
@@ -307,13 +354,16 @@ FontCacheEntry::CreateGlyph(uint32 glyphCode, FontCacheEntry* fallbackEntry)
 	}
 
 	if (engine->PrepareGlyph(glyphIndex)) {
-		glyph = fGlyphCache->CacheGlyph(glyphCode,
+		GlyphCache* newGlyph = fGlyphCache->CacheGlyph(glyphCode,
 			engine->DataSize(), engine->DataType(), engine->Bounds(),
 			engine->AdvanceX(), engine->AdvanceY(),
 			engine->InsetLeft(), engine->InsetRight());
 
-		if (glyph != NULL)
-			engine->WriteGlyphTo(glyph->data);
+		if (newGlyph != NULL) {
+			engine->WriteGlyphTo(newGlyph->data);
+			fGlyphAtlas.AddGlyph(newGlyph);
+		}
+		glyph = newGlyph;
 	}
 
 	return glyph;
@@ -352,6 +402,22 @@ FontCacheEntry::InitAdaptors(const GlyphCache* glyph,
 }
 
 
+GlyphRun*
+FontCacheEntry::CachedGlyphRun(const GlyphRunKey& key)
+{
+	// Only requires a read lock, the GlyphRunCache has its own lock.
+	return fGlyphRunCache.Lookup(key);
+}
+
+
+void
+FontCacheEntry::CacheGlyphRun(GlyphRun* run)
+{
+	// Only requires a read lock, the GlyphRunCache has its own lock.
+	fGlyphRunCache.Insert(run);
+}
+
+
 bool
 FontCacheEntry::GetKerning(uint32 glyphCode1, uint32 glyphCode2,
 	double* x, double* y)
@@ -377,6 +443,139 @@ FontCacheEntry::GenerateSignature(char* signature, size_t signatureSize,
 }
 
 
+/*!	Like GenerateSignature(), but identifies the font by its file instead of
+	the family and style IDs, which are only valid until the server quits.
+*/
+/*static*/ void
+FontCacheEntry::GeneratePersistentSignature(char* signature,
+	size_t signatureSize, const ServerFont& font, const struct stat& fileStat)
+{
+	glyph_rendering renderingType = _RenderTypeFor(font);
+
+	FT_Encoding charMap = FT_ENCODING_NONE;
+	bool hinting = font.Hinting();
+	uint8 averageWeight = gSubpixelAverageWeight;
+
+	snprintf(signature, signatureSize, "%s,%Ld,%Ld,%u,%d,%d,%.1f,%d,%d",
+		font.Path(), (int64)fileStat.st_mtime, (int64)fileStat.st_size,
+		charMap, font.Face(), int(renderingType), font.Size(), hinting,
+		averageWeight);
+}
+
+
+uint32
+FontCacheEntry::CountGlyphs() const
+{
+	// Only requires a read lock.
+	return fGlyphCache->CountGlyphs();
+}
+
+
+/*!	Writes all cached glyphs to \a stream, so that ReadGlyphs() can restore
+	them in another FontCacheEntry for the font with the same persistent
+	\a signature. Requires at least a read lock.
+*/
+status_t
+FontCacheEntry::WriteGlyphs(BDataIO& stream, const char* signature) const
+{
+	glyph_file_header header;
+	header.magic = kGlyphFileMagic;
+	header.version = kGlyphFileVersion;
+	header.signature_length = strlen(signature);
+	header.glyph_count = fGlyphCache->CountGlyphs();
+
+	ssize_t written = stream.Write(&header, sizeof(header));
+	if (written == (ssize_t)sizeof(header))
+		written = stream.Write(signature, header.signature_length);
+	if (written != (ssize_t)header.signature_length)
+		return written < 0 ? written : B_IO_ERROR;
+
+	GlyphCachePool::GlyphTable::Iterator iterator
+		= fGlyphCache->GetIterator();
+	while (iterator.HasNext()) {
+		const GlyphCache* glyph = iterator.Next();
+
+		glyph_file_entry entry;
+		entry.glyph_index = glyph->glyph_index;
+		entry.data_size = glyph->data_size;
+		entry.data_type = glyph->data_type;
+		entry.bounds[0] = glyph->bounds.x1;
+		entry.bounds[1] = glyph->bounds.y1;
+		entry.bounds[2] = glyph->bounds.x2;
+		entry.bounds[3] = glyph->bounds.y2;
+		entry.advance_x = glyph->advance_x;
+		entry.advance_y = glyph->advance_y;
+		entry.inset_left = glyph->inset_left;
+		entry.inset_right = glyph->inset_right;
+
+		written = stream.Write(&entry, sizeof(entry));
+		if (written == (ssize_t)sizeof(entry))
+			written = stream.Write(glyph->data, glyph->data_size);
+		if (written != (ssize_t)glyph->data_size)
+			return written < 0 ? written : B_IO_ERROR;
+	}
+
+	return B_OK;
+}
+
+
+/*!	Adds the glyphs that WriteGlyphs() stored in \a stream to the cache, if
+	they have been written for the given persistent \a signature. Requires
+	the write lock, or the entry not to be in use yet.
+*/
+status_t
+FontCacheEntry::ReadGlyphs(BDataIO& stream, const char* signature)
+{
+	glyph_file_header header;
+	if (stream.Read(&header, sizeof(header)) != (ssize_t)sizeof(header)
+		|| header.magic != kGlyphFileMagic
+		|| header.version != kGlyphFileVersion
+		|| header.signature_length != strlen(signature)
+		|| header.signature_length >= B_PATH_NAME_LENGTH * 2)
+		return B_BAD_DATA;
+
+	char fileSignature[B_PATH_NAME_LENGTH * 2];
+	if (stream.Read(fileSignature, header.signature_length)
+			!= (ssize_t)header.signature_length
+		|| memcmp(fileSignature, signature, header.signature_length) != 0)
+		return B_BAD_DATA;
+
+	for (uint32 i = 0; i < header.glyph_count; i++) {
+		glyph_file_entry entry;
+		if (stream.Read(&entry, sizeof(entry)) != (ssize_t)sizeof(entry)
+			|| entry.data_size > kMaxGlyphDataSize
+			|| entry.data_type > glyph_data_subpix)
+			return B_BAD_DATA;
+
+		// read the data first, so that a truncated file cannot leave an
+		// incomplete glyph behind
+		uint8* data = (uint8*)malloc(entry.data_size);
+		if (data == NULL && entry.data_size > 0)
+			return B_NO_MEMORY;
+
+		if (stream.Read(data, entry.data_size) != (ssize_t)entry.data_size) {
+			free(data);
+			return B_BAD_DATA;
+		}
+
+		GlyphCache* glyph = fGlyphCache->CacheGlyph(entry.glyph_index,
+			entry.data_size, (glyph_data_type)entry.data_type,
+			agg::rect_i(entry.bounds[0], entry.bounds[1], entry.bounds[2],
+				entry.bounds[3]),
+			entry.advance_x, entry.advance_y, entry.inset_left,
+			entry.inset_right);
+		if (glyph != NULL) {
+			memcpy(glyph->data, data, entry.data_size);
+			fGlyphAtlas.AddGlyph(glyph);
+		}
+
+		free(data);
+	}
+
+	return B_OK;
+}
+
+
 void
 FontCacheEntry::UpdateUsage()
 {
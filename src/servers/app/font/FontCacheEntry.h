@@ -35,6 +35,8 @@
 
 #include "ServerFont.h"
 #include "FontEngine.h"
+#include "GlyphAtlas.h"
+#include "GlyphRunCache.h"
 #include "MultiLocker.h"
 #include "Referenceable.h"
 #include "Transformable.h"
@@ -54,6 +56,8 @@ struct GlyphCache {
 		advance_y(advanceY),
 		inset_left(insetLeft),
 		inset_right(insetRight),
+		coverage(NULL),
+		coverage_bpr(0),
 		hash_link(NULL)
 	{
 	}
@@ -73,9 +77,26 @@ struct GlyphCache {
 	float			inset_left;
 	float			inset_right;
 
+	// the coverage mask in the GlyphAtlas of the FontCacheEntry, if any
+	const uint8*	coverage;
+	uint32			coverage_bpr;
+
 	GlyphCache*		hash_link;
 };
 
+
+// Hit counters of the glyph atlas and the glyph run cache of all
+// FontCacheEntries, see string_for_font_cache_statistics().
+struct font_cache_statistics {
+	vint32			atlas_hits;
+	vint32			atlas_misses;
+	vint32			run_hits;
+	vint32			run_misses;
+};
+
+extern font_cache_statistics gFontCacheStatistics;
+
+class BDataIO;
 class FontCache;
 
 class FontCacheEntry : public MultiLocker, public BReferenceable {
@@ -115,12 +136,25 @@ class FontCacheEntry : public MultiLocker, public BReferenceable {
 									GlyphPathAdapter& pathAdapter,
 									double scale = 1.0);
 
+			GlyphRun*			CachedGlyphRun(const GlyphRunKey& key);
+			void				CacheGlyphRun(GlyphRun* run);
+
 			bool				GetKerning(uint32 glyphCode1,
 									uint32 glyphCode2, double* x, double* y);
 
 	static	void				GenerateSignature(char* signature,
 									size_t signatureSize,
 									const ServerFont& font);
+	static	void				GeneratePersistentSignature(char* signature,
+									size_t signatureSize,
+									const ServerFont& font,
+									const struct stat& fileStat);
+
+			uint32				CountGlyphs() const;
+			status_t			WriteGlyphs(BDataIO& stream,
+									const char* signature) const;
+			status_t			ReadGlyphs(BDataIO& stream,
+									const char* signature);
 
 	// private to FontCache class:
 			void				UpdateUsage();
@@ -138,6 +172,8 @@ class FontCacheEntry : public MultiLocker, public BReferenceable {
 			class GlyphCachePool;
 
 			GlyphCachePool*		fGlyphCache;
+			GlyphAtlas			fGlyphAtlas;
+			GlyphRunCache		fGlyphRunCache;
 			FontEngine			fEngine;
 
 	static	BLocker				sUsageUpdateLock;
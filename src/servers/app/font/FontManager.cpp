@@ -10,6 +10,7 @@
 /*!	Manages font families and styles */
 
 
+#include "FontCache.h"
 #include "FontFamily.h"
 #include "FontManager.h"
 #include "ServerConfig.h"
@@ -40,6 +41,8 @@
 FT_Library gFreeTypeLibrary;
 FontManager *gFontManager = NULL;
 
+static const int32 kFontIndexVersion = 1;
+
 struct FontManager::font_directory {
 	node_ref	directory;
 	uid_t		user;
@@ -109,11 +112,14 @@ FontManager::FontManager()
 	fDefaultFixedFont(NULL),
 
 	fScanned(false),
-	fNextID(0)
+	fNextID(0),
+
+	fFontIndexChanged(false)
 {
 	fInitStatus = FT_Init_FreeType(&gFreeTypeLibrary) == 0 ? B_OK : B_ERROR;
 
 	if (fInitStatus == B_OK) {
+		_LoadFontIndex();
 		_AddSystemPaths();
 		_LoadRecentFontMappings();
 
@@ -123,6 +129,10 @@ FontManager::FontManager()
 			// Precache the plain and bold fonts
 			_PrecacheFontFile(fDefaultPlainFont);
 			_PrecacheFontFile(fDefaultBoldFont);
+
+			// and keep their glyphs across server restarts
+			FontCache::Default()->AddPersistentFont(*fDefaultPlainFont);
+			FontCache::Default()->AddPersistentFont(*fDefaultBoldFont);
 		}
 	}
 }
@@ -564,13 +574,21 @@ FontManager::_ScanFonts()
 	}
 
 	fScanned = true;
+
+	if (fFontIndexChanged)
+		_SaveFontIndex();
 }
 
 
 /*!	\brief Adds the FontFamily/FontStyle that is represented by this path.
+
+	If \a index is given, the metadata of the style is added to it as well,
+	so that the font file doesn't need to be opened when the directory is
+	scanned the next time.
 */
 status_t
-FontManager::_AddFont(font_directory& directory, BEntry& entry)
+FontManager::_AddFont(font_directory& directory, BEntry& entry,
+	BMessage* index)
 {
 	node_ref nodeRef;
 	status_t status = entry.GetNodeRef(&nodeRef);
@@ -587,28 +605,58 @@ FontManager::_AddFont(font_directory& directory, BEntry& entry)
 	if (error != 0)
 		return B_ERROR;
 
-	FontFamily *family = _FindFamily(face->family_name);
-	if (family != NULL && family->HasStyle(face->style_name)) {
+	// the FontStyle takes over ownership of the FT_Face object
+	FontStyle* style = new (std::nothrow) FontStyle(nodeRef, path.Path(),
+		face);
+	if (style == NULL) {
+		FT_Done_Face(face);
+		return B_NO_MEMORY;
+	}
+
+	BString familyName = face->family_name;
+
+	struct stat stat;
+	if (index != NULL && entry.GetStat(&stat) == B_OK) {
+		BMessage metadata;
+		if (style->GetMetadata(metadata) == B_OK
+			&& metadata.AddString("family", familyName) == B_OK
+			&& metadata.AddString("name", path.Leaf()) == B_OK
+			&& metadata.AddInt64("modified", stat.st_mtime) == B_OK
+			&& metadata.AddInt64("size", stat.st_size) == B_OK)
+			index->AddMessage("font", &metadata);
+	}
+
+	return _AddStyle(directory, familyName.String(), style);
+}
+
+
+/*!	\brief Adds the \a style to the family \a familyName, creating the family
+		if needed. If the style is already known, it is deleted instead.
+*/
+status_t
+FontManager::_AddStyle(font_directory& directory, const char* familyName,
+	FontStyle* style)
+{
+	FontFamily *family = _FindFamily(familyName);
+	if (family != NULL && family->HasStyle(style->Name())) {
 		// prevent adding the same style twice
 		// (this indicates a problem with the installed fonts maybe?)
-		FT_Done_Face(face);
+		delete style;
 		return B_OK;
 	}
 
 	if (family == NULL) {
-		family = new (std::nothrow) FontFamily(face->family_name, fNextID++);
+		family = new (std::nothrow) FontFamily(familyName, fNextID++);
 		if (family == NULL
 			|| !fFamilies.BinaryInsert(family, compare_font_families)) {
 			delete family;
-			FT_Done_Face(face);
+			delete style;
 			return B_NO_MEMORY;
 		}
 	}
 
-	FTRACE(("\tadd style: %s, %s\n", face->family_name, face->style_name));
+	FTRACE(("\tadd style: %s, %s\n", familyName, style->Name()));
 
-	// the FontStyle takes over ownership of the FT_Face object
-	FontStyle *style = new FontStyle(nodeRef, path.Path(), face);
 	if (!family->AddStyle(style)) {
 		delete style;
 		delete family;
@@ -788,6 +836,24 @@ FontManager::_ScanFontDirectory(font_directory& fontDirectory)
 	if (status != B_OK)
 		return status;
 
+	// If the directory hasn't changed since it was put into the font index,
+	// we can add its fonts from there, and don't need to open them at all
+
+	BEntry directoryEntry;
+	BPath path;
+	struct stat stat;
+	bool indexable = directory.GetEntry(&directoryEntry) == B_OK
+		&& path.SetTo(&directoryEntry) == B_OK
+		&& directory.GetStat(&stat) == B_OK;
+	if (indexable
+		&& _ScanIndexedFontDirectory(fontDirectory, path.Path(), stat)
+			== B_OK) {
+		fontDirectory.revision = 1;
+		return B_OK;
+	}
+
+	BMessage index;
+
 	BEntry entry;
 	while (directory.GetNextEntry(&entry) == B_OK) {
 		if (entry.IsDirectory()) {
@@ -796,6 +862,9 @@ FontManager::_ScanFontDirectory(font_directory& fontDirectory)
 			if (_AddPath(entry, &newDirectory) == B_OK && newDirectory != NULL)
 				_ScanFontDirectory(*newDirectory);
 
+			char name[B_FILE_NAME_LENGTH];
+			if (entry.GetName(name) == B_OK)
+				index.AddString("subdirectory", name);
 			continue;
 		}
 
@@ -815,15 +884,173 @@ FontManager::_ScanFontDirectory(font_directory& fontDirectory)
 		face->charmap = charmap;
 #endif
 
-		_AddFont(fontDirectory, entry);
+		_AddFont(fontDirectory, entry, indexable ? &index : NULL);
 			// takes over ownership of the FT_Face object
 	}
 
+	if (indexable) {
+		index.AddString("path", path.Path());
+		index.AddInt64("modified", stat.st_mtime);
+		_UpdateIndexEntry(path.Path(), index);
+	}
+
 	fontDirectory.revision = 1;
 	return B_OK;
 }
 
 
+/*!	\brief Adds the fonts and subdirectories of a directory from the font
+		index, without opening any of the font files.
+
+	Fails if the directory is not in the index, or if it, or any of its
+	fonts, has been modified since it was indexed. Nothing has been added
+	in that case.
+*/
+status_t
+FontManager::_ScanIndexedFontDirectory(font_directory& fontDirectory,
+	const char* path, const struct stat& stat)
+{
+	BMessage index;
+	if (!_FindIndexEntry(path, index))
+		return B_ENTRY_NOT_FOUND;
+
+	if (index.FindInt64("modified") != stat.st_mtime)
+		return B_BAD_DATA;
+
+	// make sure no font file has been replaced in place
+
+	BMessage metadata;
+	for (int32 i = 0; index.FindMessage("font", i, &metadata) == B_OK; i++) {
+		const char* name = metadata.FindString("name");
+		BEntry entry;
+		struct stat fontStat;
+		if (name == NULL || metadata.FindString("family") == NULL
+			|| metadata.FindString("style") == NULL
+			|| set_entry(fontDirectory.directory, name, entry) != B_OK
+			|| entry.GetStat(&fontStat) != B_OK
+			|| fontStat.st_mtime != metadata.FindInt64("modified")
+			|| fontStat.st_size != metadata.FindInt64("size"))
+			return B_BAD_DATA;
+	}
+
+	for (int32 i = 0; index.FindMessage("font", i, &metadata) == B_OK; i++) {
+		BEntry entry;
+		node_ref nodeRef;
+		BPath fontPath;
+		if (set_entry(fontDirectory.directory, metadata.FindString("name"),
+				entry) != B_OK
+			|| entry.GetNodeRef(&nodeRef) != B_OK
+			|| entry.GetPath(&fontPath) != B_OK)
+			continue;
+
+		FontStyle* style = new (std::nothrow) FontStyle(nodeRef,
+			fontPath.Path(), metadata);
+		if (style == NULL)
+			return B_NO_MEMORY;
+
+		_AddStyle(fontDirectory, metadata.FindString("family"), style);
+	}
+
+	const char* name;
+	for (int32 i = 0; index.FindString("subdirectory", i, &name) == B_OK;
+			i++) {
+		BEntry entry;
+		font_directory* newDirectory;
+		if (set_entry(fontDirectory.directory, name, entry) == B_OK
+			&& _AddPath(entry, &newDirectory) == B_OK && newDirectory != NULL)
+			_ScanFontDirectory(*newDirectory);
+	}
+
+	FTRACE(("FontManager: added indexed directory %s\n", path));
+	return B_OK;
+}
+
+
+status_t
+FontManager::_GetFontIndexPath(BPath& path)
+{
+	status_t status = find_directory(B_COMMON_CACHE_DIRECTORY, &path, true);
+	if (status == B_OK)
+		status = path.Append("app_server");
+	if (status == B_OK)
+		status = create_directory(path.Path(), 0755);
+	if (status == B_OK)
+		status = path.Append("font_index");
+
+	return status;
+}
+
+
+/*!	\brief Loads the font index that _SaveFontIndex() wrote when the fonts
+		were scanned the last time.
+
+	The index contains a "directory" message for every scanned font
+	directory, with its path, modification time, the names of its
+	subdirectories, and a "font" message with the metadata of each of its
+	font files.
+*/
+void
+FontManager::_LoadFontIndex()
+{
+	BPath path;
+	BFile file;
+	if (_GetFontIndexPath(path) != B_OK
+		|| file.SetTo(path.Path(), B_READ_ONLY) != B_OK
+		|| fFontIndex.Unflatten(&file) != B_OK
+		|| fFontIndex.FindInt32("version") != kFontIndexVersion) {
+		fFontIndex.MakeEmpty();
+		fFontIndex.AddInt32("version", kFontIndexVersion);
+	}
+}
+
+
+void
+FontManager::_SaveFontIndex()
+{
+	BPath path;
+	BFile file;
+	if (_GetFontIndexPath(path) != B_OK
+		|| file.SetTo(path.Path(), B_CREATE_FILE | B_ERASE_FILE | B_WRITE_ONLY)
+			!= B_OK)
+		return;
+
+	if (fFontIndex.Flatten(&file) == B_OK)
+		fFontIndexChanged = false;
+}
+
+
+bool
+FontManager::_FindIndexEntry(const char* path, BMessage& entry,
+	int32* _index)
+{
+	for (int32 i = 0; fFontIndex.FindMessage("directory", i, &entry) == B_OK;
+			i++) {
+		const char* entryPath = entry.FindString("path");
+		if (entryPath != NULL && !strcmp(entryPath, path)) {
+			if (_index != NULL)
+				*_index = i;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+void
+FontManager::_UpdateIndexEntry(const char* path, const BMessage& entry)
+{
+	BMessage oldEntry;
+	int32 index;
+	if (_FindIndexEntry(path, oldEntry, &index))
+		fFontIndex.ReplaceMessage("directory", index, &entry);
+	else
+		fFontIndex.AddMessage("directory", &entry);
+
+	fFontIndexChanged = true;
+}
+
+
 /*!	\brief Finds and returns the first valid charmap in a font
 
 	\param face Font handle obtained from FT_Load_Face()
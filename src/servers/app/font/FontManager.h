@@ -13,6 +13,7 @@
 #include "HashTable.h"
 
 #include <Looper.h>
+#include <Message.h>
 #include <ObjectList.h>
 
 #include <ft2build.h>
@@ -106,8 +107,22 @@ private:
 			void				_ScanFontsIfNecessary();
 			void				_ScanFonts();
 			status_t			_ScanFontDirectory(font_directory& directory);
+			status_t			_ScanIndexedFontDirectory(
+									font_directory& directory,
+									const char* path,
+									const struct stat& stat);
 			status_t			_AddFont(font_directory& directory,
-									BEntry& entry);
+									BEntry& entry, BMessage* index = NULL);
+			status_t			_AddStyle(font_directory& directory,
+									const char* familyName, FontStyle* style);
+
+			status_t			_GetFontIndexPath(BPath& path);
+			void				_LoadFontIndex();
+			void				_SaveFontIndex();
+			bool				_FindIndexEntry(const char* path,
+									BMessage& entry, int32* _index = NULL);
+			void				_UpdateIndexEntry(const char* path,
+									const BMessage& entry);
 
 			FT_CharMap			_GetSupportedCharmap(const FT_Face& face);
 
@@ -130,6 +145,9 @@ private:
 
 			bool				fScanned;
 			int32				fNextID;
+
+			BMessage			fFontIndex;
+			bool				fFontIndexChanged;
 };
 
 extern FT_Library gFreeTypeLibrary;
@@ -17,9 +17,20 @@
 #include <FontPrivate.h>
 
 #include <Entry.h>
+#include <Message.h>
 
 
 static BLocker sFontLock("font lock");
+static FT_Library sFaceLibrary = NULL;
+	// used for the faces of styles created from the font index - it is only
+	// accessed with sFontLock held, and is kept until the server quits
+
+
+enum {
+	kFixedWidth	= 0x01,
+	kScalable	= 0x02,
+	kKerning	= 0x04
+};
 
 
 /*!
@@ -50,6 +61,43 @@ FontStyle::FontStyle(node_ref& nodeRef, const char* path, FT_Face face)
 	// calculate it because height = ascending + descending + leading
 	fHeight.leading = (double)(face->height - face->ascender + face->descender)
 		/ face->units_per_EM;
+
+	_SetFaceProperties(face);
+}
+
+
+/*!
+	\brief Constructs a style from the \a metadata that GetMetadata() stored
+		in the font index of the FontManager.
+
+	The font file is only opened once FreeTypeFace() is called for the first
+	time, so that a style can be added without FreeType parsing the file.
+*/
+FontStyle::FontStyle(node_ref& nodeRef, const char* path,
+		const BMessage& metadata)
+	:
+	fFreeTypeFace(NULL),
+	fName(metadata.FindString("style")),
+	fPath(path),
+	fNodeRef(nodeRef),
+	fFamily(NULL),
+	fID(0),
+	fBounds(0, 0, 0, 0),
+	fFace(_TranslateStyleToFace(metadata.FindString("style")))
+{
+	fName.Truncate(B_FONT_STYLE_LENGTH);
+
+	fHeight.ascent = metadata.FindDouble("ascent");
+	fHeight.descent = metadata.FindDouble("descent");
+	fHeight.leading = metadata.FindDouble("leading");
+
+	int32 flags = metadata.FindInt32("flags");
+	fFixedWidth = (flags & kFixedWidth) != 0;
+	fScalable = (flags & kScalable) != 0;
+	fHasKerning = (flags & kKerning) != 0;
+	fTunedCount = metadata.FindInt32("tuned");
+	fGlyphCount = metadata.FindInt32("glyphs");
+	fCharMapCount = metadata.FindInt32("charmaps");
 }
 
 
@@ -61,7 +109,8 @@ FontStyle::~FontStyle()
 		gFontManager->Unlock();
 	}
 
-	FT_Done_Face(fFreeTypeFace);
+	if (fFreeTypeFace != NULL)
+		FT_Done_Face(fFreeTypeFace);
 }
 
 
@@ -104,6 +153,30 @@ FontStyle::GetHeight(float size, font_height& height) const
 }
 
 
+/*!
+	\brief Returns the FreeType handle of the font file, opening the file if
+		necessary. The FontStyle needs to be locked.
+*/
+FT_Face
+FontStyle::FreeTypeFace() const
+{
+	if (fFreeTypeFace != NULL)
+		return fFreeTypeFace;
+
+	if (sFaceLibrary == NULL && FT_Init_FreeType(&sFaceLibrary) != 0) {
+		sFaceLibrary = NULL;
+		return NULL;
+	}
+
+	FT_Face face;
+	if (FT_New_Face(sFaceLibrary, fPath.Path(), 0, &face) != 0)
+		return NULL;
+
+	fFreeTypeFace = face;
+	return fFreeTypeFace;
+}
+
+
 /*!
 	\brief Returns the path to the style's font file
 	\return The style's font file path
@@ -190,12 +263,61 @@ FontStyle::UpdateFace(FT_Face face)
 	if (name != fName)
 		return B_BAD_VALUE;
 
-	FT_Done_Face(fFreeTypeFace);
+	if (fFreeTypeFace != NULL)
+		FT_Done_Face(fFreeTypeFace);
 	fFreeTypeFace = face;
+	_SetFaceProperties(face);
 	return B_OK;
 }
 
 
+/*!
+	\brief Stores everything needed to construct this style again without
+		opening its font file in \a metadata.
+*/
+status_t
+FontStyle::GetMetadata(BMessage& metadata) const
+{
+	int32 flags = 0;
+	if (fFixedWidth)
+		flags |= kFixedWidth;
+	if (fScalable)
+		flags |= kScalable;
+	if (fHasKerning)
+		flags |= kKerning;
+
+	status_t status = metadata.AddString("style", fName);
+	if (status == B_OK)
+		status = metadata.AddDouble("ascent", fHeight.ascent);
+	if (status == B_OK)
+		status = metadata.AddDouble("descent", fHeight.descent);
+	if (status == B_OK)
+		status = metadata.AddDouble("leading", fHeight.leading);
+	if (status == B_OK)
+		status = metadata.AddInt32("flags", flags);
+	if (status == B_OK)
+		status = metadata.AddInt32("tuned", fTunedCount);
+	if (status == B_OK)
+		status = metadata.AddInt32("glyphs", fGlyphCount);
+	if (status == B_OK)
+		status = metadata.AddInt32("charmaps", fCharMapCount);
+
+	return status;
+}
+
+
+void
+FontStyle::_SetFaceProperties(FT_Face face)
+{
+	fFixedWidth = FT_IS_FIXED_WIDTH(face);
+	fScalable = FT_IS_SCALABLE(face);
+	fHasKerning = FT_HAS_KERNING(face);
+	fTunedCount = face->num_fixed_sizes;
+	fGlyphCount = face->num_glyphs;
+	fCharMapCount = face->num_charmaps;
+}
+
+
 void
 FontStyle::_SetFontFamily(FontFamily* family, uint16 id)
 {
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2011, Haiku, Inc.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+
+
+#include "GlyphAtlas.h"
+
+#include <new>
+#include <string.h>
+
+#include "FontCacheEntry.h"
+
+
+GlyphAtlas::GlyphAtlas()
+	:
+	fPageCount(0)
+{
+}
+
+
+GlyphAtlas::~GlyphAtlas()
+{
+	for (int32 i = 0; i < fPageCount; i++)
+		delete fPages[i];
+}
+
+
+/*!	Decodes the serialized scanlines of the glyph_data_gray8 \a glyph into
+	a coverage mask in the atlas, and points GlyphCache::coverage to it.
+	Returns \c false if the glyph has no such data, or the atlas is full.
+	Requires the owning FontCacheEntry to be write-locked.
+*/
+bool
+GlyphAtlas::AddGlyph(GlyphCache* glyph)
+{
+	if (glyph->data_type != glyph_data_gray8 || glyph->coverage != NULL)
+		return false;
+
+	FontCacheEntry::GlyphGray8Adapter adapter;
+	adapter.init(glyph->data, glyph->data_size, 0, 0);
+	if (!adapter.rewind_scanlines())
+		return false;
+
+	// the glyph bounds are used for placing the mask when blending it
+	const agg::rect_i& bounds = glyph->bounds;
+	if (adapter.min_x() != bounds.x1 || adapter.min_y() != bounds.y1
+		|| adapter.max_x() != bounds.x2 || adapter.max_y() != bounds.y2) {
+		return false;
+	}
+
+	int32 width = bounds.x2 - bounds.x1 + 1;
+	int32 height = bounds.y2 - bounds.y1 + 1;
+	uint8* mask = _Allocate(width, height);
+	if (mask == NULL)
+		return false;
+
+	for (int32 y = 0; y < height; y++)
+		memset(mask + y * PAGE_SIZE, 0, width);
+
+	FontCacheEntry::GlyphGray8Scanline scanline;
+	while (adapter.sweep_scanline(scanline)) {
+		uint8* row = mask + (scanline.y() - bounds.y1) * PAGE_SIZE
+			- bounds.x1;
+
+		FontCacheEntry::GlyphGray8Scanline::const_iterator span
+			= scanline.begin();
+		for (unsigned count = scanline.num_spans(); count > 0; count--) {
+			if (span->len > 0)
+				memcpy(row + span->x, span->covers, span->len);
+			else
+				memset(row + span->x, *span->covers, -span->len);
+			++span;
+		}
+	}
+
+	glyph->coverage = mask;
+	glyph->coverage_bpr = PAGE_SIZE;
+	return true;
+}
+
+
+/*!	Finds room for a mask of the given size, filling each page shelf by
+	shelf. Glyphs of similar height, like those of one font, waste little
+	space this way.
+*/
+uint8*
+GlyphAtlas::_Allocate(int32 width, int32 height)
+{
+	if (width <= 0 || height <= 0 || width > PAGE_SIZE || height > PAGE_SIZE)
+		return NULL;
+
+	Page* page = fPageCount > 0 ? fPages[fPageCount - 1] : NULL;
+	if (page != NULL && page->shelfX + width > PAGE_SIZE) {
+		// start a new shelf
+		page->shelfTop += page->shelfHeight;
+		page->shelfHeight = 0;
+		page->shelfX = 0;
+	}
+
+	if (page == NULL || page->shelfTop + height > PAGE_SIZE) {
+		if (fPageCount == MAX_PAGES)
+			return NULL;
+
+		page = new(std::nothrow) Page;
+		if (page == NULL)
+			return NULL;
+
+		page->shelfTop = 0;
+		page->shelfHeight = 0;
+		page->shelfX = 0;
+		fPages[fPageCount++] = page;
+	}
+
+	uint8* bits = page->bits + page->shelfTop * PAGE_SIZE + page->shelfX;
+	page->shelfX += width;
+	if (height > page->shelfHeight)
+		page->shelfHeight = height;
+
+	return bits;
+}
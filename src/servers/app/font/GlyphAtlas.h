@@ -0,0 +1,46 @@
+/*
+ * Copyright 2011, Haiku, Inc.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+#ifndef GLYPH_ATLAS_H
+#define GLYPH_ATLAS_H
+
+
+#include <SupportDefs.h>
+
+
+struct GlyphCache;
+
+
+// Keeps the coverage masks of anti-aliased glyph bitmaps, packed into a few
+// pages per FontCacheEntry. A glyph in the atlas can be blended directly
+// from its mask, instead of decoding the serialized AGG scanlines of
+// GlyphCache::data each time the glyph is drawn.
+class GlyphAtlas {
+public:
+								GlyphAtlas();
+								~GlyphAtlas();
+
+			bool				AddGlyph(GlyphCache* glyph);
+
+private:
+	enum {
+		PAGE_SIZE		= 128,
+		MAX_PAGES		= 8
+	};
+
+	struct Page {
+			uint8				bits[PAGE_SIZE * PAGE_SIZE];
+			int32				shelfTop;
+			int32				shelfHeight;
+			int32				shelfX;
+	};
+
+			uint8*				_Allocate(int32 width, int32 height);
+
+			Page*				fPages[MAX_PAGES];
+			int32				fPageCount;
+};
+
+
+#endif // GLYPH_ATLAS_H
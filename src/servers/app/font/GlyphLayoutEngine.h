@@ -19,6 +19,7 @@
 #include <Debug.h>
 
 #include <ctype.h>
+#include <string.h>
 
 class FontCacheReference {
 public:
@@ -97,6 +98,11 @@ public:
 									FontCacheReference* cacheReference = NULL);
 
 private:
+			template<class GlyphConsumer>
+	static	void				_ReplayGlyphRun(GlyphConsumer& consumer,
+									FontCacheEntry* entry,
+									const GlyphRun* run);
+
 	static	bool				_WriteLockAndAcquireFallbackEntry(
 									FontCacheReference& cacheReference,
 									FontCacheEntry* entry,
@@ -199,6 +205,37 @@ GlyphLayoutEngine::LayoutGlyphs(GlyphConsumer& consumer,
 			return false;
 	} // else the entry was already used and is still locked
 
+	// Strings without explicit glyph locations are laid out only once, and
+	// their glyphs and positions are reused from the GlyphRunCache of the
+	// entry until they drop out of it.
+	BReference<GlyphRun> recordedRun;
+	if (offsets == NULL && GlyphRunCache::IsCacheable(length)) {
+		GlyphRunKey key(utf8String, strnlen(utf8String, length), delta,
+			kerning, spacing);
+		if (key.length > 0) {
+			BReference<GlyphRun> cachedRun(entry->CachedGlyphRun(key), true);
+			if (cachedRun.Get() != NULL) {
+				atomic_add(&gFontCacheStatistics.run_hits, 1);
+				_ReplayGlyphRun(consumer, entry, cachedRun.Get());
+
+				if (_cacheReference != NULL
+					&& _cacheReference->Entry() == NULL) {
+					_cacheReference->SetTo(entry,
+						cacheReference.WriteLocked());
+					cacheReference.SetTo(NULL, false);
+				}
+				return true;
+			}
+
+			atomic_add(&gFontCacheStatistics.run_misses, 1);
+			recordedRun.SetTo(new(std::nothrow) GlyphRun(key), true);
+			if (recordedRun.Get() != NULL
+				&& recordedRun.Get()->InitCheck() != B_OK) {
+				recordedRun.Unset();
+			}
+		}
+	}
+
 	consumer.Start();
 
 	double x = 0.0;
@@ -256,10 +293,18 @@ GlyphLayoutEngine::LayoutGlyphs(GlyphConsumer& consumer,
 			consumer.ConsumeEmptyGlyph(index++, charCode, x, y);
 			advanceX = 0;
 			advanceY = 0;
+			// missing glyphs are retried the next time
+			recordedRun.Unset();
 		} else {
+			if (recordedRun.Get() != NULL
+				&& !recordedRun.Get()->AddGlyph(charCode, glyph, x, y)) {
+				recordedRun.Unset();
+			}
+
 			if (!consumer.ConsumeGlyph(index++, charCode, glyph, entry, x, y)) {
 				advanceX = 0;
 				advanceY = 0;
+				recordedRun.Unset();
 				break;
 			}
 
@@ -277,6 +322,14 @@ GlyphLayoutEngine::LayoutGlyphs(GlyphConsumer& consumer,
 	y += advanceY;
 	consumer.Finish(x, y);
 
+	// The layout only depends on the bytes of the key, unless the last
+	// character extended beyond them.
+	if (recordedRun.Get() != NULL
+		&& utf8String - start <= recordedRun.Get()->Key().length) {
+		recordedRun.Get()->SetEnd(x, y);
+		entry->CacheGlyphRun(recordedRun.Get());
+	}
+
 	if (_cacheReference != NULL && _cacheReference->Entry() == NULL) {
 		// The caller passed a FontCacheReference, but this is the first
 		// iteration -> switch the ownership from the stack allocated
@@ -290,6 +343,30 @@ GlyphLayoutEngine::LayoutGlyphs(GlyphConsumer& consumer,
 }
 
 
+/*!	Feeds the glyphs of a cached \a run to the \a consumer, the same way
+	LayoutGlyphs() would have done for the original string.
+*/
+template<class GlyphConsumer>
+inline void
+GlyphLayoutEngine::_ReplayGlyphRun(GlyphConsumer& consumer,
+	FontCacheEntry* entry, const GlyphRun* run)
+{
+	consumer.Start();
+
+	int32 count = run->CountGlyphs();
+	for (int32 i = 0; i < count; i++) {
+		const GlyphRun::Glyph& glyph = run->GlyphAt(i);
+		if (!consumer.ConsumeGlyph(i, glyph.char_code, glyph.glyph, entry,
+				glyph.x, glyph.y)) {
+			consumer.Finish(glyph.x, glyph.y);
+			return;
+		}
+	}
+
+	consumer.Finish(run->EndX(), run->EndY());
+}
+
+
 inline bool
 GlyphLayoutEngine::_WriteLockAndAcquireFallbackEntry(
 	FontCacheReference& cacheReference, FontCacheEntry* entry,
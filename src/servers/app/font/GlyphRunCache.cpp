@@ -0,0 +1,179 @@
+/*
+ * Copyright 2011, Haiku, Inc.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+
+
+#include "GlyphRunCache.h"
+
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+
+#include <Autolock.h>
+
+
+GlyphRunKey::GlyphRunKey(const char* string, int32 length,
+	const escapement_delta* delta, bool kerning, uint8 spacing)
+	:
+	string(string),
+	length(length),
+	space(delta != NULL ? delta->space : 0.0f),
+	nonspace(delta != NULL ? delta->nonspace : 0.0f),
+	kerning(kerning),
+	spacing(spacing)
+{
+	// NOTE: no delta is equivalent to a delta of zero in the layout
+	hash = 0;
+	for (int32 i = 0; i < length; i++)
+		hash = (hash << 5) - hash + (uint8)string[i];
+
+	hash ^= (uint32)(space * 64) * 31 + (uint32)(nonspace * 64);
+	hash ^= ((uint32)spacing << 1) | (kerning ? 1 : 0);
+}
+
+
+bool
+GlyphRunKey::operator==(const GlyphRunKey& other) const
+{
+	return hash == other.hash && length == other.length
+		&& space == other.space && nonspace == other.nonspace
+		&& kerning == other.kerning && spacing == other.spacing
+		&& memcmp(string, other.string, length) == 0;
+}
+
+
+// #pragma mark -
+
+
+GlyphRun::GlyphRun(const GlyphRunKey& key)
+	:
+	fHashLink(NULL),
+	fKey(key),
+	fString((char*)malloc(key.length)),
+	fGlyphs(NULL),
+	fGlyphCount(0),
+	fEndX(0.0),
+	fEndY(0.0)
+{
+	// a string cannot contain more characters than bytes
+	fGlyphs = (Glyph*)malloc(key.length * sizeof(Glyph));
+
+	if (fString != NULL)
+		memcpy(fString, key.string, key.length);
+	fKey.string = fString;
+}
+
+
+GlyphRun::~GlyphRun()
+{
+	free(fString);
+	free(fGlyphs);
+}
+
+
+status_t
+GlyphRun::InitCheck() const
+{
+	return fString != NULL && fGlyphs != NULL ? B_OK : B_NO_MEMORY;
+}
+
+
+bool
+GlyphRun::AddGlyph(uint32 charCode, const GlyphCache* glyph, double x,
+	double y)
+{
+	if (fGlyphCount >= fKey.length)
+		return false;
+
+	Glyph& entry = fGlyphs[fGlyphCount++];
+	entry.char_code = charCode;
+	entry.glyph = glyph;
+	entry.x = x;
+	entry.y = y;
+	return true;
+}
+
+
+void
+GlyphRun::SetEnd(double x, double y)
+{
+	fEndX = x;
+	fEndY = y;
+}
+
+
+// #pragma mark -
+
+
+GlyphRunCache::GlyphRunCache()
+	:
+	fLock("glyph run cache"),
+	fRunCount(0)
+{
+}
+
+
+GlyphRunCache::~GlyphRunCache()
+{
+	fTable.Clear();
+
+	while (GlyphRun* run = fRuns.RemoveHead())
+		run->ReleaseReference();
+}
+
+
+status_t
+GlyphRunCache::Init()
+{
+	return fTable.Init();
+}
+
+
+/*!	Returns the run matching \a key with a reference acquired for the
+	caller, or \c NULL if there is none.
+*/
+GlyphRun*
+GlyphRunCache::Lookup(const GlyphRunKey& key)
+{
+	BAutolock _(fLock);
+
+	GlyphRun* run = fTable.Lookup(key);
+	if (run == NULL)
+		return NULL;
+
+	fRuns.Remove(run);
+	fRuns.Insert(run, false);
+
+	run->AcquireReference();
+	return run;
+}
+
+
+/*!	Adds \a run to the cache, which acquires its own reference to it. The
+	least recently used run is dropped when the cache is full.
+*/
+void
+GlyphRunCache::Insert(GlyphRun* run)
+{
+	BAutolock _(fLock);
+
+	if (fTable.Lookup(run->Key()) != NULL) {
+		// another thread was faster
+		return;
+	}
+
+	if (fTable.Insert(run) != B_OK)
+		return;
+
+	run->AcquireReference();
+	fRuns.Insert(run, false);
+	fRunCount++;
+
+	if (fRunCount > MAX_RUN_COUNT) {
+		GlyphRun* oldest = fRuns.RemoveTail();
+		fTable.Remove(oldest);
+		fRunCount--;
+		oldest->ReleaseReference();
+	}
+}
@@ -0,0 +1,145 @@
+/*
+ * Copyright 2011, Haiku, Inc.
+ * All rights reserved. Distributed under the terms of the MIT License.
+ */
+#ifndef GLYPH_RUN_CACHE_H
+#define GLYPH_RUN_CACHE_H
+
+
+#include <Font.h>
+#include <Locker.h>
+
+#include <Referenceable.h>
+#include <util/DoublyLinkedList.h>
+#include <util/OpenHashTable.h>
+
+
+struct GlyphCache;
+
+
+// Identifies the layout of a string: the UTF-8 bytes and the parameters of
+// GlyphLayoutEngine::LayoutGlyphs() influencing the glyph positions. The
+// font is implied by the FontCacheEntry owning the GlyphRunCache.
+struct GlyphRunKey {
+								GlyphRunKey(const char* string,
+									int32 length,
+									const escapement_delta* delta,
+									bool kerning, uint8 spacing);
+
+			bool				operator==(const GlyphRunKey& other) const;
+
+			const char*			string;
+			int32				length;
+			float				space;
+			float				nonspace;
+			bool				kerning;
+			uint8				spacing;
+			uint32				hash;
+};
+
+
+// The glyphs of a laid out string and their positions, relative to the
+// start of the string.
+class GlyphRun : public BReferenceable,
+	public DoublyLinkedListLinkImpl<GlyphRun> {
+public:
+	struct Glyph {
+		uint32					char_code;
+		const GlyphCache*		glyph;
+		double					x;
+		double					y;
+	};
+
+								GlyphRun(const GlyphRunKey& key);
+	virtual						~GlyphRun();
+
+			status_t			InitCheck() const;
+
+			const GlyphRunKey&	Key() const
+									{ return fKey; }
+
+			bool				AddGlyph(uint32 charCode,
+									const GlyphCache* glyph,
+									double x, double y);
+			void				SetEnd(double x, double y);
+
+			int32				CountGlyphs() const
+									{ return fGlyphCount; }
+			const Glyph&		GlyphAt(int32 index) const
+									{ return fGlyphs[index]; }
+			double				EndX() const
+									{ return fEndX; }
+			double				EndY() const
+									{ return fEndY; }
+
+			GlyphRun*			fHashLink;
+
+private:
+			GlyphRunKey			fKey;
+			char*				fString;
+			Glyph*				fGlyphs;
+			int32				fGlyphCount;
+			double				fEndX;
+			double				fEndY;
+};
+
+
+// A small LRU cache of GlyphRuns, so that strings drawn over and over again
+// (menus, list views, Tracker) don't need to be laid out each time.
+class GlyphRunCache {
+public:
+								GlyphRunCache();
+								~GlyphRunCache();
+
+			status_t			Init();
+
+	static	bool				IsCacheable(int32 length)
+									{ return length > 0
+										&& length <= MAX_RUN_LENGTH; }
+
+			GlyphRun*			Lookup(const GlyphRunKey& key);
+			void				Insert(GlyphRun* run);
+
+private:
+	enum {
+		MAX_RUN_LENGTH	= 128,
+		MAX_RUN_COUNT	= 64
+	};
+
+	struct HashDefinition {
+		typedef GlyphRunKey		KeyType;
+		typedef	GlyphRun		ValueType;
+
+		size_t HashKey(const GlyphRunKey& key) const
+		{
+			return key.hash;
+		}
+
+		size_t Hash(GlyphRun* value) const
+		{
+			return value->Key().hash;
+		}
+
+		bool Compare(const GlyphRunKey& key, GlyphRun* value) const
+		{
+			return value->Key() == key;
+		}
+
+		GlyphRun*& GetLink(GlyphRun* value) const
+		{
+			return value->fHashLink;
+		}
+	};
+
+	typedef BOpenHashTable<HashDefinition> RunTable;
+	typedef DoublyLinkedList<GlyphRun> RunList;
+
+			BLocker				fLock;
+			RunTable			fTable;
+			RunList				fRuns;
+				// most recently used first
+			int32				fRunCount;
+};
+
+
+#endif // GLYPH_RUN_CACHE_H
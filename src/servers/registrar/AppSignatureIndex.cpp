@@ -0,0 +1,308 @@
+/*
+ * Copyright 2011, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	\class AppSignatureIndex
+	\brief Maps application signatures to the executables that have them.
+
+	BRoster::Launch() has to query all volumes for an application's signature
+	if it has no (valid) app hint, which is by far the most expensive part of
+	resolving it. The roster learns the executable of every application that
+	registers with it, so it keeps them in this index and hands them out
+	instead.
+
+	Only executables whose BEOS:APP_SIG attribute matches the signature are
+	added. The index watches their nodes and follows them when they are moved,
+	and drops them when they are removed, moved to the Trash (BRoster won't
+	launch them from there), or their signature changes. The number of
+	entries is limited; the least recently used one is dropped when the index
+	is full.
+*/
+
+
+#include "AppSignatureIndex.h"
+
+#include <ctype.h>
+#include <string.h>
+
+#include <Directory.h>
+#include <FindDirectory.h>
+#include <Message.h>
+#include <Mime.h>
+#include <NodeMonitor.h>
+#include <Path.h>
+#include <Volume.h>
+
+#include "Debug.h"
+
+
+static const int32 kMaxIndexEntries = 128;
+static const char* kAppSignatureAttribute = "BEOS:APP_SIG";
+
+
+//!	Returns whether \a ref is in the Trash of its volume.
+static bool
+is_in_trash(const entry_ref& ref)
+{
+	BEntry entry(&ref);
+	BVolume volume(ref.device);
+	BPath trashPath;
+	BDirectory trash;
+	return entry.InitCheck() == B_OK && volume.InitCheck() == B_OK
+		&& find_directory(B_TRASH_DIRECTORY, &trashPath, false, &volume)
+			== B_OK
+		&& trash.SetTo(trashPath.Path()) == B_OK
+		&& trash.Contains(&entry);
+}
+
+
+/*!	\brief Creates an empty index.
+
+	SetTarget() must be called before anything is added to the index.
+*/
+AppSignatureIndex::AppSignatureIndex()
+	:
+	fEntries(),
+	fTarget()
+{
+}
+
+
+/*!	\brief Frees all resources associated with this object, and stops
+		   watching the nodes of its entries.
+*/
+AppSignatureIndex::~AppSignatureIndex()
+{
+	Clear();
+}
+
+
+/*!	\brief Sets the target for the node monitoring messages.
+
+	The messages must be passed on to HandleNodeMonitorMessage().
+*/
+void
+AppSignatureIndex::SetTarget(const BMessenger& target)
+{
+	fTarget = target;
+}
+
+
+/*!	\brief Returns the executable for the given signature.
+
+	\param signature The application signature.
+	\param ref Set to the executable of the application.
+	\return
+	- \c B_OK: Everything went fine.
+	- \c B_BAD_VALUE: \c NULL \a signature or \a ref.
+	- \c B_ENTRY_NOT_FOUND: The index doesn't know the signature.
+*/
+status_t
+AppSignatureIndex::Get(const char* signature, entry_ref* ref)
+{
+	if (signature == NULL || ref == NULL)
+		return B_BAD_VALUE;
+
+	std::string key;
+	_GetKey(signature, key);
+
+	EntryMap::iterator it = fEntries.find(key);
+	if (it == fEntries.end())
+		return B_ENTRY_NOT_FOUND;
+
+	// We might have missed the removal, if the volume went away.
+	BEntry entry(&it->second.ref);
+	if (!entry.Exists()) {
+		_Remove(it);
+		return B_ENTRY_NOT_FOUND;
+	}
+
+	it->second.last_used = system_time();
+	*ref = it->second.ref;
+	return B_OK;
+}
+
+
+/*!	\brief Adds the executable of an application to the index.
+
+	If the index already has an executable for \a signature, it is replaced.
+	Nothing happens, if the executable doesn't have the signature, or is in
+	the Trash.
+*/
+void
+AppSignatureIndex::Put(const char* signature, const entry_ref& ref)
+{
+	if (signature == NULL || signature[0] == '\0'
+		|| strlen(signature) >= B_MIME_TYPE_LENGTH) {
+		return;
+	}
+
+	std::string key;
+	_GetKey(signature, key);
+
+	EntryMap::iterator it = fEntries.find(key);
+	if (it != fEntries.end() && it->second.ref == ref) {
+		it->second.last_used = system_time();
+		return;
+	}
+
+	BNode node(&ref);
+	char fileSignature[B_MIME_TYPE_LENGTH];
+	ssize_t bytesRead = node.ReadAttr(kAppSignatureAttribute,
+		B_MIME_STRING_TYPE, 0, fileSignature, sizeof(fileSignature) - 1);
+	if (bytesRead <= 0)
+		return;
+	fileSignature[bytesRead] = '\0';
+	if (strcasecmp(fileSignature, signature) != 0 || is_in_trash(ref))
+		return;
+
+	index_entry entry;
+	if (node.GetNodeRef(&entry.node) != B_OK)
+		return;
+	entry.ref = ref;
+	entry.last_used = system_time();
+
+	if (it != fEntries.end())
+		_Remove(it);
+	else if ((int32)fEntries.size() >= kMaxIndexEntries)
+		_RemoveLeastRecentlyUsed();
+
+	// A node may only be in the index once
+	EntryMap::iterator other = _FindNode(entry.node);
+	if (other != fEntries.end())
+		_Remove(other);
+
+	status_t error = watch_node(&entry.node, B_WATCH_NAME | B_WATCH_ATTR,
+		fTarget);
+	if (error != B_OK) {
+		PRINT("AppSignatureIndex::Put(): failed to watch %s: %s\n",
+			ref.name, strerror(error));
+		return;
+	}
+
+	fEntries[key] = entry;
+}
+
+
+/*!	\brief Removes the entry for the given signature from the index.
+*/
+void
+AppSignatureIndex::Remove(const char* signature)
+{
+	if (signature == NULL)
+		return;
+
+	std::string key;
+	_GetKey(signature, key);
+
+	EntryMap::iterator it = fEntries.find(key);
+	if (it != fEntries.end())
+		_Remove(it);
+}
+
+
+/*!	\brief Removes all entries from the index.
+*/
+void
+AppSignatureIndex::Clear()
+{
+	while (!fEntries.empty())
+		_Remove(fEntries.begin());
+}
+
+
+/*!	\brief Updates the index for a change of one of the watched nodes.
+	\param message The B_NODE_MONITOR message.
+*/
+void
+AppSignatureIndex::HandleNodeMonitorMessage(BMessage* message)
+{
+	int32 opcode;
+	node_ref node;
+	if (message->FindInt32("opcode", &opcode) != B_OK
+		|| message->FindInt32("device", &node.device) != B_OK
+		|| message->FindInt64("node", &node.node) != B_OK) {
+		return;
+	}
+
+	EntryMap::iterator it = _FindNode(node);
+	if (it == fEntries.end())
+		return;
+
+	switch (opcode) {
+		case B_ENTRY_MOVED:
+		{
+			entry_ref& ref = it->second.ref;
+			const char* name;
+			if (message->FindInt64("to directory", &ref.directory) != B_OK
+				|| message->FindString("name", &name) != B_OK
+				|| ref.set_name(name) != B_OK || is_in_trash(ref)) {
+				_Remove(it);
+			}
+			break;
+		}
+
+		case B_ENTRY_REMOVED:
+			_Remove(it);
+			break;
+
+		case B_ATTR_CHANGED:
+		{
+			const char* attribute;
+			if (message->FindString("attr", &attribute) == B_OK
+				&& !strcmp(attribute, kAppSignatureAttribute)) {
+				_Remove(it);
+			}
+			break;
+		}
+	}
+}
+
+
+//	#pragma mark - private
+
+
+/*static*/ void
+AppSignatureIndex::_GetKey(const char* signature, std::string& key)
+{
+	key = signature;
+	for (size_t i = 0; i < key.length(); i++)
+		key[i] = tolower(key[i]);
+}
+
+
+AppSignatureIndex::EntryMap::iterator
+AppSignatureIndex::_FindNode(const node_ref& node)
+{
+	EntryMap::iterator it = fEntries.begin();
+	for (; it != fEntries.end(); it++) {
+		if (it->second.node == node)
+			break;
+	}
+	return it;
+}
+
+
+void
+AppSignatureIndex::_Remove(EntryMap::iterator it)
+{
+	watch_node(&it->second.node, B_STOP_WATCHING, fTarget);
+	fEntries.erase(it);
+}
+
+
+void
+AppSignatureIndex::_RemoveLeastRecentlyUsed()
+{
+	EntryMap::iterator oldest = fEntries.begin();
+	for (EntryMap::iterator it = fEntries.begin(); it != fEntries.end();
+			it++) {
+		if (it->second.last_used < oldest->second.last_used)
+			oldest = it;
+	}
+
+	if (oldest != fEntries.end())
+		_Remove(oldest);
+}
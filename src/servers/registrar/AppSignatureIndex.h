@@ -0,0 +1,56 @@
+/*
+ * Copyright 2011, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef APP_SIGNATURE_INDEX_H
+#define APP_SIGNATURE_INDEX_H
+
+
+#include <Entry.h>
+#include <Messenger.h>
+#include <Node.h>
+
+#include <map>
+#include <string>
+
+
+class BMessage;
+
+
+// AppSignatureIndex
+class AppSignatureIndex {
+public:
+	AppSignatureIndex();
+	~AppSignatureIndex();
+
+	void SetTarget(const BMessenger& target);
+
+	status_t Get(const char* signature, entry_ref* ref);
+	void Put(const char* signature, const entry_ref& ref);
+	void Remove(const char* signature);
+	void Clear();
+
+	void HandleNodeMonitorMessage(BMessage* message);
+
+	int32 CountEntries() const	{ return fEntries.size(); }
+
+private:
+	struct index_entry {
+		entry_ref	ref;
+		node_ref	node;
+		bigtime_t	last_used;
+	};
+
+	typedef std::map<std::string, index_entry> EntryMap;
+
+	static void _GetKey(const char* signature, std::string& key);
+
+	EntryMap::iterator _FindNode(const node_ref& node);
+	void _Remove(EntryMap::iterator it);
+	void _RemoveLeastRecentlyUsed();
+
+	EntryMap	fEntries;
+	BMessenger	fTarget;
+};
+
+#endif	// APP_SIGNATURE_INDEX_H
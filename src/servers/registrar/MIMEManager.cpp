@@ -10,9 +10,12 @@
 
 #include "MIMEManager.h"
 
+#include <new>
 #include <stdio.h>
+#include <string.h>
 #include <string>
 
+#include <AutoDeleter.h>
 #include <Bitmap.h>
 #include <Message.h>
 #include <Messenger.h>
@@ -22,6 +25,8 @@
 #include <TypeConstants.h>
 
 #include "CreateAppMetaMimeThread.h"
+#include "EventQueue.h"
+#include "MessageEvent.h"
 #include "MimeSnifferAddonManager.h"
 #include "TextSnifferAddon.h"
 #include "UpdateMimeInfoThread.h"
@@ -31,6 +36,12 @@ using namespace std;
 using namespace BPrivate;
 
 
+// The database snapshot is only rebuilt after the database hasn't been
+// changed for this long, so that a series of changes (as done by mimeset,
+// for example) doesn't cause a rebuild each.
+static const bigtime_t kSnapshotUpdateDelay = 500000;
+
+
 /*!	\class MIMEManager
 	\brief MIMEManager handles communication between BMimeType and the system-wide
 	MimeDatabase object for BMimeType's write and non-atomic read functions.
@@ -39,15 +50,24 @@ using namespace BPrivate;
 
 
 /*!	\brief Creates and initializes a MIMEManager.
+	\param eventQueue The event queue used to schedule the updates of the
+		   database snapshot.
 */
-MIMEManager::MIMEManager()
+MIMEManager::MIMEManager(EventQueue *eventQueue)
 	:
 	BLooper("main_mime"),
 	fDatabase(),
-	fThreadManager()
+	fThreadManager(),
+	fEventQueue(eventQueue),
+	fLastDatabaseChange(0),
+	fSnapshotUpdateScheduled(false)
 {
 	AddHandler(&fThreadManager);
 
+	// publish the initial snapshot of the database, once things have
+	// settled down a bit
+	ScheduleSnapshotUpdate(system_time() + kSnapshotUpdateDelay);
+
 	// prepare the MimeSnifferAddonManager and the built-in add-ons
 	status_t error = MimeSnifferAddonManager::CreateDefault();
 	if (error == B_OK) {
@@ -77,13 +97,19 @@ MIMEManager::MessageReceived(BMessage *message)
 
 	switch (message->what) {
 		case B_REG_MIME_SET_PARAM:
+			DatabaseChanging();
 			HandleSetParam(message);
 			break;
 
 		case B_REG_MIME_DELETE_PARAM:
+			DatabaseChanging();
 			HandleDeleteParam(message);
 			break;
 
+		case B_REG_MIME_UPDATE_SNAPSHOT:
+			HandleUpdateSnapshot();
+			break;
+
 		case B_REG_MIME_START_WATCHING:
 		case B_REG_MIME_STOP_WATCHING:
 		{
@@ -106,6 +132,8 @@ MIMEManager::MessageReceived(BMessage *message)
 		{
 			const char *type;
 			err = message->FindString("type", &type);
+			if (!err)
+				DatabaseChanging();
 			if (!err)
 				err = message->what == B_REG_MIME_INSTALL
 					? fDatabase.Install(type) : fDatabase.Delete(type);
@@ -169,6 +197,14 @@ MIMEManager::MessageReceived(BMessage *message)
 
 		case B_REG_MIME_SNIFF:
 		{
+			type_code type;
+			int32 refCount;
+			if (message->GetInfo("file ref", &type, &refCount) == B_OK
+				&& refCount > 1) {
+				HandleSniffFiles(message);
+				break;
+			}
+
 			BString str;
 			entry_ref ref;
 			const char *filename;
@@ -261,6 +297,13 @@ MIMEManager::MessageReceived(BMessage *message)
 			if (!err)
 				err = threadStatus = thread->InitCheck();
 
+			// Let the sender follow the progress, if it wants to
+			BMessenger progressTarget;
+			if (!err && message->FindMessenger("progress target",
+					&progressTarget) == B_OK) {
+				thread->SetProgressTarget(progressTarget);
+			}
+
 			// Launch the thread
 			if (!err) {
 				err = fThreadManager.LaunchThread(thread);
@@ -528,3 +571,99 @@ MIMEManager::HandleDeleteParam(BMessage *message)
 	message->SendReply(&reply, this);
 }
 
+
+/*!	Handles B_REG_MIME_SNIFF messages with more than one "file ref". The
+	reply contains a "mime type" and a "results" entry for each of them, in
+	the same order.
+*/
+void
+MIMEManager::HandleSniffFiles(BMessage *message)
+{
+	BMessage reply(B_REG_RESULT);
+	type_code type;
+	int32 count = 0;
+	status_t err = message->GetInfo("file ref", &type, &count);
+
+	entry_ref *refs = new(std::nothrow) entry_ref[count];
+	BString *types = new(std::nothrow) BString[count];
+	status_t *results = new(std::nothrow) status_t[count];
+	ArrayDeleter<entry_ref> refsDeleter(refs);
+	ArrayDeleter<BString> typesDeleter(types);
+	ArrayDeleter<status_t> resultsDeleter(results);
+	if (!err && (refs == NULL || types == NULL || results == NULL))
+		err = B_NO_MEMORY;
+
+	for (int32 i = 0; !err && i < count; i++)
+		err = message->FindRef("file ref", i, &refs[i]);
+	if (!err)
+		err = fDatabase.GuessMimeTypes(refs, count, types, results);
+
+	for (int32 i = 0; !err && i < count; i++) {
+		err = reply.AddString("mime type", types[i]);
+		if (!err)
+			err = reply.AddInt32("results", results[i]);
+	}
+
+	if (err) {
+		reply.RemoveName("mime type");
+		reply.RemoveName("results");
+	}
+
+	reply.AddInt32("result", err);
+	message->SendReply(&reply, this);
+}
+
+
+/*!	\brief Must be called before the database is changed.
+
+	Invalidates the database snapshot and schedules its update.
+*/
+void
+MIMEManager::DatabaseChanging()
+{
+	fDatabase.InvalidateSnapshot();
+	fLastDatabaseChange = system_time();
+
+	if (!fSnapshotUpdateScheduled)
+		ScheduleSnapshotUpdate(fLastDatabaseChange + kSnapshotUpdateDelay);
+}
+
+
+//! Handles B_REG_MIME_UPDATE_SNAPSHOT messages
+void
+MIMEManager::HandleUpdateSnapshot()
+{
+	fSnapshotUpdateScheduled = false;
+
+	// wait until the database has been left alone for a while
+	bigtime_t quietTime = fLastDatabaseChange + kSnapshotUpdateDelay;
+	if (quietTime > system_time()) {
+		ScheduleSnapshotUpdate(quietTime);
+		return;
+	}
+
+	status_t error = fDatabase.UpdateSnapshot();
+	if (error != B_OK) {
+		printf("MIMEManager: Failed to update the database snapshot: %s\n",
+			strerror(error));
+	}
+}
+
+
+//! Lets the event queue send a B_REG_MIME_UPDATE_SNAPSHOT at \a time.
+void
+MIMEManager::ScheduleSnapshotUpdate(bigtime_t time)
+{
+	if (fEventQueue == NULL)
+		return;
+
+	MessageEvent *event = new(nothrow) MessageEvent(time, this,
+		B_REG_MIME_UPDATE_SNAPSHOT);
+	if (event == NULL)
+		return;
+
+	if (fEventQueue->AddEvent(event))
+		fSnapshotUpdateScheduled = true;
+	else
+		delete event;
+}
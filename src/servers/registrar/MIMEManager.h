@@ -8,19 +8,29 @@
 #include "Database.h"
 #include "RegistrarThreadManager.h"
 
+class EventQueue;
+
 class MIMEManager : public BLooper {
 public:
-	MIMEManager();
+	MIMEManager(EventQueue *eventQueue);
 	virtual ~MIMEManager();
 
 	virtual void MessageReceived(BMessage *message);
 private:
 	void HandleSetParam(BMessage *message);
 	void HandleDeleteParam(BMessage *message);
+	void HandleSniffFiles(BMessage *message);
+
+	void DatabaseChanging();
+	void HandleUpdateSnapshot();
+	void ScheduleSnapshotUpdate(bigtime_t time);
 	
 	BPrivate::Storage::Mime::Database fDatabase;
 	RegistrarThreadManager fThreadManager;
 	BMessenger fManagerMessenger;
+	EventQueue *fEventQueue;
+	bigtime_t fLastDatabaseChange;
+	bool fSnapshotUpdateScheduled;
 };
 
 #endif	// MIME_MANAGER_H
@@ -33,11 +33,14 @@ using std::nothrow;
 	dispatches the message runner specific request messages.
 
 	Each active message runner (i.e. one that still has messages to be sent)
-	is represented by a RunnerInfo that comprises all necessary information,
-	among these a RunnerEvent added to the event queue. When the event is
-	executed, it calls the _DoEvent() method, which in turn sends the message
-	runner message to the respective target and schedules the event for the
-	next time the message has to be sent (_ScheduleEvent()).
+	is represented by a RunnerInfo that comprises all necessary information.
+	The RunnerInfos are kept in a TimerWheel (\a fTimerWheel), sorted by the
+	next time their message has to be sent (_ScheduleEvent()). Only a single
+	TimerEvent is added to the event queue, for the time the earliest runner
+	is due (_ScheduleTimer()). When the event is executed, it calls the
+	_DoTimer() method, which sends the messages of all runners that are due
+	and reschedules them. Runners due within the wheel's resolution (the
+	timer slack) of each other are handled by the same event.
 
 	A couple of helper methods provide convenient access to the RunnerInfo
 	list (\a fRunnerInfos). A BLocker (\a fLock) and respective locking
@@ -57,6 +60,18 @@ using std::nothrow;
 	\brief Event queue used by the manager.
 */
 
+/*! \var TimerWheel MessageRunnerManager::fTimerWheel
+	\brief Contains the RunnerInfos of all active message runners.
+*/
+
+/*! \var TimerEvent *MessageRunnerManager::fTimerEvent
+	\brief The event added to the event queue for the earliest runner.
+*/
+
+/*! \var bool MessageRunnerManager::fTimerScheduled
+	\brief Whether \a fTimerEvent is in the event queue.
+*/
+
 /*! \var int32 MessageRunnerManager::fNextToken
 	\brief Next unused token for message runners.
 */
@@ -79,47 +94,45 @@ add_time(bigtime_t a, bigtime_t b)
 }
 
 
-// RunnerEvent
+// TimerEvent
 /*!	\brief Event class used to by the message runner manager.
 
-	For each active message runner such an event is used. It invokes
-	MessageRunnerManager::_DoEvent() on execution.
+	A single such event is used for all message runners. It invokes
+	MessageRunnerManager::_DoTimer() on execution.
 */
-class MessageRunnerManager::RunnerEvent : public Event {
+class MessageRunnerManager::TimerEvent : public Event {
 public:
-	/*!	\brief Creates a new RunnerEvent.
+	/*!	\brief Creates a new TimerEvent.
 		\param manager The message runner manager.
-		\param info The RunnerInfo for the message runner.
 	*/
-	RunnerEvent(MessageRunnerManager *manager, RunnerInfo *info)
+	TimerEvent(MessageRunnerManager *manager)
 		: Event(false),
-		  fManager(manager),
-		  fInfo(info)
+		  fManager(manager)
 	{
 	}
 
 	/*!	\brief Hook method invoked when the event is executed.
 
-		Implements Event. Calls MessageRunnerManager::_DoEvent().
-		
+		Implements Event. Calls MessageRunnerManager::_DoTimer().
+
 		\param queue The event queue executing the event.
-		\return \c true, if the object shall be deleted, \c false otherwise.
+		\return \c false, since the manager owns the object.
 	*/
 	virtual bool Do(EventQueue *queue)
 	{
-		return fManager->_DoEvent(fInfo);
+		fManager->_DoTimer();
+		return false;
 	}
 
 private:
 	MessageRunnerManager	*fManager;	//!< The message runner manager.
-	RunnerInfo				*fInfo;		//!< The message runner info.
 };
 
 
 // RunnerInfo
 /*!	\brief Contains all needed information about an active message runner.
 */
-struct MessageRunnerManager::RunnerInfo {
+struct MessageRunnerManager::RunnerInfo : TimerWheelEntry {
 	/*!	\brief Creates a new RunnerInfo.
 		\param team The team owning the message runner.
 		\param token The unique token associated with the message runner.
@@ -138,20 +151,17 @@ struct MessageRunnerManager::RunnerInfo {
 		  interval(interval),
 		  count(count),
 		  replyTarget(replyTarget),
-		  time(0),
-		  event(NULL),
-		  rescheduled(false)
+		  time(0)
 	{
 	}
 
 	/*!	\brief Frees all resources associated with the object.
 
-		The message and the event are delete.
+		The message is deleted.
 	*/
 	~RunnerInfo()
 	{
 		delete message;
-		delete event;
 	}
 
 	/*!	\brief Delivers the message to the respective target.
@@ -200,23 +210,26 @@ struct MessageRunnerManager::RunnerInfo {
 									 message. */
 	bigtime_t	time;			/*!< Time at which the next message will be
 									 sent. */
-	RunnerEvent	*event;			//!< Runner event for the message runner.
-	bool		rescheduled;	/*!< Set to \c true when the event has been
-									 started to be executed while it was
-									 rescheduled. */
 };
 
 
 // constructor
 /*!	\brief Creates a new MessageRunnerManager.
 	\param eventQueue The EventQueue the manager shall use.
+	\param timerSlack The time by which a message may be sent late, so that
+		   it can be sent together with the messages of other runners.
 */
-MessageRunnerManager::MessageRunnerManager(EventQueue *eventQueue)
+MessageRunnerManager::MessageRunnerManager(EventQueue *eventQueue,
+	bigtime_t timerSlack)
 	: fRunnerInfos(),
 	  fLock(),
 	  fEventQueue(eventQueue),
+	  fTimerWheel(timerSlack),
+	  fTimerEvent(NULL),
+	  fTimerScheduled(false),
 	  fNextToken(0)
 {
+	fTimerEvent = new(nothrow) TimerEvent(this);
 }
 
 // destructor
@@ -231,9 +244,12 @@ MessageRunnerManager::~MessageRunnerManager()
 	// If it is still running and an event gets executed after we've locked
 	// ourselves, then it will access an already deleted manager.
 	BAutolock _lock(fLock);
+	if (fTimerEvent != NULL) {
+		fEventQueue->RemoveEvent(fTimerEvent);
+		delete fTimerEvent;
+	}
 	for (int32 i = 0; RunnerInfo *info = _InfoAt(i); i++) {
-		if (!fEventQueue->RemoveEvent(info->event))
-			info->event = NULL;
+		fTimerWheel.Remove(info);
 		delete info;
 	}
 	fRunnerInfos.MakeEmpty();
@@ -259,7 +275,7 @@ MessageRunnerManager::HandleRegisterRunner(BMessage *request)
 	bigtime_t interval;
 	int32 count;
 	BMessenger replyTarget;
-	if (error == B_OK && message == NULL)
+	if (error == B_OK && (message == NULL || fTimerEvent == NULL))
 		error = B_NO_MEMORY;
 	if (error == B_OK && request->FindInt32("team", &team) != B_OK)
 		error = B_BAD_VALUE;
@@ -294,16 +310,10 @@ MessageRunnerManager::HandleRegisterRunner(BMessage *request)
 			error = B_NO_MEMORY;
 	}
 
-	// create a new event
-	RunnerEvent *event = NULL;
+	// schedule the first message
 	if (error == B_OK) {
-		event = new(nothrow) RunnerEvent(this, info);
-		if (event) {
-			info->event = event;
-			if (!_ScheduleEvent(info))
-				error = B_NO_MEMORY;	// TODO: The only possible reason?
-		} else
-			error = B_NO_MEMORY;
+		_ScheduleEvent(info);
+		_ScheduleTimer();
 	}
 
 	// cleanup on error
@@ -347,7 +357,7 @@ MessageRunnerManager::HandleUnregisterRunner(BMessage *request)
 	// find and delete the runner info
 	if (error == B_OK) {
 		if (RunnerInfo *info = _InfoForToken(token))
-			_DeleteInfo(info, false);
+			_DeleteInfo(info);
 		else
 			error = B_BAD_VALUE;
 	}
@@ -406,7 +416,6 @@ MessageRunnerManager::HandleSetRunnerParams(BMessage *request)
 
 	// set the new values
 	if (error == B_OK) {
-		bool eventRemoved = false;
 		bool deleteInfo = false;
 		// count
 		if (setCount) {
@@ -416,19 +425,19 @@ MessageRunnerManager::HandleSetRunnerParams(BMessage *request)
 				info->count = count;
 		}
 		// interval
-		if (setInterval) {
-			eventRemoved = fEventQueue->RemoveEvent(info->event);
-			if (!eventRemoved)
-				info->rescheduled = true;
+		if (setInterval && !deleteInfo) {
+			fTimerWheel.Remove(info);
 			interval = max(interval, kMininalTimeInterval);
 			info->interval = interval;
 			info->time = system_time();
-			if (!_ScheduleEvent(info))
-				error = B_NO_MEMORY;	// TODO: The only possible reason?
+			if (_ScheduleEvent(info))
+				_ScheduleTimer();
+			else
+				deleteInfo = true;
 		}
-		// remove and delete the info on error
-		if (error != B_OK || deleteInfo)
-			_DeleteInfo(info, eventRemoved);
+		// remove and delete the info, if it has nothing left to do
+		if (deleteInfo)
+			_DeleteInfo(info);
 	}
 
 	// reply to the request
@@ -569,19 +578,20 @@ MessageRunnerManager::_RemoveInfoWithToken(int32 token)
 
 	\note The manager must be locked.
 
-	\param index The index of the RunnerInfo to be deleted.
+	The info is removed from the timer wheel as well. The timer event is
+	left alone, if there are no more messages due at its time, it just
+	finds nothing to do.
+
+	\param info The RunnerInfo to be deleted.
 	\return \c true, if removed and deleted successfully, \c false, if the
 			list doesn't contain the supplied info.
 */
 bool
-MessageRunnerManager::_DeleteInfo(RunnerInfo *info, bool eventRemoved)
+MessageRunnerManager::_DeleteInfo(RunnerInfo *info)
 {
 	bool result = _RemoveInfo(info);
 	if (result) {
-		// If the event is not in the event queue and has not been removed
-		// just before, then it is in progress. It will delete itself.
-		if (!eventRemoved && !fEventQueue->RemoveEvent(info->event))
-			info->event = NULL;
+		fTimerWheel.Remove(info);
 		delete info;
 	}
 	return result;
@@ -668,68 +678,61 @@ MessageRunnerManager::_IndexOfToken(int32 token) const
 	return -1;
 }
 
-// _DoEvent
-/*!	\brief Invoked when a message runner's event is executed.
+// _DoTimer
+/*!	\brief Invoked when the timer event is executed.
 
-	If the message runner info is still valid and the event was not just
-	rescheduled, the message is delivered to the message runner's target
-	and the event is rescheduled.
-
-	\param info The message runner's info.
-	\return \c true, if the event object shall be deleted, \c false otherwise.
+	The messages of all message runners that are due are delivered to their
+	targets and the runners are rescheduled. Runners that have fulfilled their
+	job, or whose target is gone, are deleted. Finally the timer event is
+	scheduled for the next runner that becomes due.
 */
-bool
-MessageRunnerManager::_DoEvent(RunnerInfo *info)
+void
+MessageRunnerManager::_DoTimer()
 {
 	FUNCTION_START();
 
 	BAutolock _lock(fLock);
-	bool deleteEvent = false;
-	// first check whether the info does still exist
-	if (_lock.IsLocked() && _IndexOf(info) >= 0) {
-		// If the event has been rescheduled after being removed from the
-		// queue for execution, it needs to be ignored. This may happen, when
-		// the interval is modified.
-		if (info->rescheduled)
-			info->rescheduled = false;
-		else {
-			// send the message
-			bool success = (info->DeliverMessage() == B_OK);
-			// reschedule the event
-			if (success)
-				success = _ScheduleEvent(info);
-
-			// clean up, if the message delivery of the rescheduling failed
-			// (or the runner had already fulfilled its job)
-			if (!success) {
-				deleteEvent = true;
-				info->event = NULL;
-				_RemoveInfo(info);
-				delete info;
-			}
+	if (!_lock.IsLocked())
+		return;
+
+	// the event has been removed from the queue for its execution
+	fTimerScheduled = false;
+
+	TimerWheelEntryList due;
+	fTimerWheel.CollectDue(system_time(), due);
+
+	while (RunnerInfo *info = static_cast<RunnerInfo*>(due.RemoveHead())) {
+		// send the message
+		bool success = (info->DeliverMessage() == B_OK);
+		// reschedule the runner
+		if (success)
+			success = _ScheduleEvent(info);
+
+		// clean up, if the message delivery failed (or the runner had
+		// already fulfilled its job)
+		if (!success) {
+			_RemoveInfo(info);
+			delete info;
 		}
-	} else {
-		// The info is no more. That means it had been removed after the
-		// event was removed from the event queue, but before we could acquire
-		// the lock. Simply delete the event.
-		deleteEvent = true;
 	}
 
-	FUNCTION_END();
+	_ScheduleTimer();
 
-	return deleteEvent;
+	FUNCTION_END();
 }
 
 // _ScheduleEvent
-/*!	\brief Schedules the event for a message runner for the next time a
+/*!	\brief Adds a message runner to the timer wheel for the next time a
 		   message has to be sent.
 
+	The timer event is not updated; _ScheduleTimer() must be invoked
+	afterwards.
+
 	\note The manager must be locked.
 
 	\param info The message runner's info.
-	\return \c true, if the event successfully been rescheduled, \c false,
-			if either all messages have already been sent or the event queue
-			doesn't allow adding the event (e.g. due to insufficient memory).
+	\return \c true, if the runner has successfully been rescheduled,
+			\c false, if all messages have already been sent.
 */
 bool
 MessageRunnerManager::_ScheduleEvent(RunnerInfo *info)
@@ -748,8 +751,8 @@ MessageRunnerManager::_ScheduleEvent(RunnerInfo *info)
 				info->interval - (now - info->time) % info->interval);
 		}
 
-		info->event->SetTime(info->time);
-		scheduled = fEventQueue->AddEvent(info->event);
+		fTimerWheel.Add(info, info->time);
+		scheduled = true;
 
 PRINT("runner %ld (%lld, %ld) rescheduled: %d, time: %lld, now: %lld\n",
 info->token, info->interval, info->count, scheduled, info->time, system_time());
@@ -757,6 +760,31 @@ info->token, info->interval, info->count, scheduled, info->time, system_time());
 	return scheduled;
 }
 
+// _ScheduleTimer
+/*!	\brief Schedules the timer event for the next time a message runner's
+		   message has to be sent.
+
+	\note The manager must be locked.
+*/
+void
+MessageRunnerManager::_ScheduleTimer()
+{
+	bigtime_t time = fTimerWheel.NextTime();
+	if (time == B_INFINITE_TIMEOUT || fTimerEvent == NULL)
+		return;
+
+	if (fTimerScheduled) {
+		// Only ever move the event forward. If it's executed too early, it
+		// reschedules itself.
+		if (time < fTimerEvent->Time())
+			fEventQueue->ModifyEvent(fTimerEvent, time);
+		return;
+	}
+
+	fTimerEvent->SetTime(time);
+	fTimerScheduled = fEventQueue->AddEvent(fTimerEvent);
+}
+
 // _NextToken
 /*!	\brief Returns a new unused message runner token.
 
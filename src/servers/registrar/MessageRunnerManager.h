@@ -30,12 +30,18 @@
 #include <List.h>
 #include <Locker.h>
 
+#include "TimerWheel.h"
+
 class BMessage;
 class EventQueue;
 
+// Messages of runners due within this time of each other are sent together.
+const bigtime_t kDefaultRunnerTimerSlack = 5000;
+
 class MessageRunnerManager {
 public:
-	MessageRunnerManager(EventQueue *eventQueue);
+	MessageRunnerManager(EventQueue *eventQueue,
+		bigtime_t timerSlack = kDefaultRunnerTimerSlack);
 	virtual ~MessageRunnerManager();
 
 	void HandleRegisterRunner(BMessage *request);
@@ -47,16 +53,16 @@ public:
 	void Unlock();
 
 private:
-	class RunnerEvent;
+	class TimerEvent;
 	struct RunnerInfo;
-	friend class RunnerEvent;
+	friend class TimerEvent;
 
 private:
 	bool _AddInfo(RunnerInfo *info);
 	bool _RemoveInfo(RunnerInfo *info);
 	RunnerInfo *_RemoveInfo(int32 index);
 	RunnerInfo *_RemoveInfoWithToken(int32 token);
-	bool _DeleteInfo(RunnerInfo *info, bool eventRemoved);
+	bool _DeleteInfo(RunnerInfo *info);
 
 	int32 _CountInfos() const;
 
@@ -68,8 +74,9 @@ private:
 	int32 _IndexOf(RunnerInfo *info) const;
 	int32 _IndexOfToken(int32 token) const;
 
-	bool _DoEvent(RunnerInfo *info);
+	void _DoTimer();
 	bool _ScheduleEvent(RunnerInfo *info);
+	void _ScheduleTimer();
 
 	int32 _NextToken();
 
@@ -77,6 +84,9 @@ private:
 	BList		fRunnerInfos;
 	BLocker		fLock;
 	EventQueue	*fEventQueue;
+	TimerWheel	fTimerWheel;
+	TimerEvent	*fTimerEvent;
+	bool		fTimerScheduled;
 	int32		fNextToken;
 };
 
@@ -16,6 +16,7 @@
 #include <Application.h>
 #include <Clipboard.h>
 #include <Message.h>
+#include <NodeMonitor.h>
 #include <OS.h>
 #include <RegistrarDefs.h>
 #include <RosterPrivate.h>
@@ -150,7 +151,7 @@ Registrar::ReadyToRun()
 	AddHandler(fClipboardHandler);
 
 	// create MIME manager
-	fMIMEManager = new MIMEManager;
+	fMIMEManager = new MIMEManager(fEventQueue);
 	fMIMEManager->Run();
 
 	// create message runner manager
@@ -321,6 +322,9 @@ Registrar::_MessageReceived(BMessage *message)
 		case B_REG_SAVE_RECENT_LISTS:
 			fRoster->HandleSaveRecentLists(message);
 			break;
+		case B_REG_FIND_APP:
+			fRoster->HandleFindApp(message);
+			break;
 
 		// message runner requests
 		case B_REG_REGISTER_MESSAGE_RUNNER:
@@ -356,6 +360,10 @@ Registrar::_MessageReceived(BMessage *message)
 			break;
 		}
 
+		case B_NODE_MONITOR:
+			fRoster->HandleNodeMonitor(message);
+			break;
+
 		default:
 			BApplication::MessageReceived(message);
 			break;
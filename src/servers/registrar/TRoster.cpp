@@ -66,6 +66,10 @@ using namespace BPrivate;
 	The field \a fActiveApp identifies the currently active application
 	and \a fLastToken is a counter used to generate unique tokens for
 	pre-registered applications.
+
+	The executables of registering applications are remembered by signature
+	in \a fAppSignatureIndex, so that BRoster::Launch() doesn't have to query
+	for them.
 */
 
 //! The maximal period of time an app may be early pre-registered (60 s).
@@ -134,6 +138,7 @@ TRoster::TRoster()
 	fRecentApps(),
 	fRecentDocuments(),
 	fRecentFolders(),
+	fAppSignatureIndex(),
 	fLastToken(0),
 	fShuttingDown(false)
 {
@@ -275,9 +280,10 @@ TRoster::HandleAddApplication(BMessage* request)
 	// reply to the request
 	if (error == B_OK) {
 		// add to recent apps if successful
-		if (signature && signature[0] != '\0')
+		if (signature && signature[0] != '\0') {
 			fRecentApps.Add(signature, flags);
-		else
+			fAppSignatureIndex.Put(signature, ref);
+		} else
 			fRecentApps.Add(&ref, flags);
 
 		BMessage reply(B_REG_SUCCESS);
@@ -622,9 +628,10 @@ TRoster::HandleSetSignature(BMessage* request)
 		error = B_BAD_VALUE;
 	// find the app and set the signature
 	if (error == B_OK) {
-		if (RosterAppInfo* info = fRegisteredApps.InfoFor(team))
+		if (RosterAppInfo* info = fRegisteredApps.InfoFor(team)) {
 			strcpy(info->signature, signature);
-		else
+			fAppSignatureIndex.Put(signature, info->ref);
+		} else
 			SET_ERROR(error, B_REG_APP_NOT_REGISTERED);
 	}
 	// reply to the request
@@ -1140,6 +1147,43 @@ TRoster::HandleSaveRecentLists(BMessage* request)
 }
 
 
+/*!	\brief Handles a request to find the executable for an app signature.
+
+	The executable is looked up in the app signature index only; if it isn't
+	there, the client has to query for it.
+
+	\param request The request message
+*/
+void
+TRoster::HandleFindApp(BMessage* request)
+{
+	FUNCTION_START();
+
+	BAutolock _(fLock);
+
+	status_t error = B_OK;
+	const char* signature;
+	entry_ref ref;
+	if (request->FindString("signature", &signature) != B_OK)
+		SET_ERROR(error, B_BAD_VALUE);
+	if (error == B_OK)
+		error = fAppSignatureIndex.Get(signature, &ref);
+
+	// reply to the request
+	if (error == B_OK) {
+		BMessage reply(B_REG_SUCCESS);
+		reply.AddRef("ref", &ref);
+		request->SendReply(&reply);
+	} else {
+		BMessage reply(B_REG_ERROR);
+		reply.AddInt32("error", error);
+		request->SendReply(&reply);
+	}
+
+	FUNCTION_END();
+}
+
+
 void
 TRoster::HandleRestartAppServer(BMessage* request)
 {
@@ -1179,6 +1223,18 @@ TRoster::HandleRestartAppServer(BMessage* request)
 }
 
 
+/*!	\brief Handles a node monitoring message for the app signature index.
+	\param message The B_NODE_MONITOR message
+*/
+void
+TRoster::HandleNodeMonitor(BMessage* message)
+{
+	BAutolock _(fLock);
+
+	fAppSignatureIndex.HandleNodeMonitorMessage(message);
+}
+
+
 /*!	\brief Clears the current list of recent documents
 */
 void
@@ -1248,8 +1304,10 @@ TRoster::Init()
 		error = AddApp(info);
 	}
 
-	if (error == B_OK)
+	if (error == B_OK) {
+		fAppSignatureIndex.SetTarget(be_app_messenger);
 		_LoadRosterSettings();
+	}
 
 	// cleanup on error
 	if (error != B_OK)
@@ -7,6 +7,7 @@
 
 
 #include "AppInfoList.h"
+#include "AppSignatureIndex.h"
 #include "RecentApps.h"
 #include "RecentEntries.h"
 #include "WatchingService.h"
@@ -58,8 +59,10 @@ public:
 			void			HandleAddToRecentApps(BMessage* request);
 			void			HandleLoadRecentLists(BMessage* request);
 			void			HandleSaveRecentLists(BMessage* request);
+			void			HandleFindApp(BMessage* request);
 
 			void			HandleRestartAppServer(BMessage* request);
+			void			HandleNodeMonitor(BMessage* message);
 
 			void			ClearRecentDocuments();
 			void			ClearRecentFolders();
@@ -124,6 +127,7 @@ private:
 			RecentApps		fRecentApps;
 			RecentEntries	fRecentDocuments;
 			RecentEntries	fRecentFolders;
+			AppSignatureIndex fAppSignatureIndex;
 			uint32			fLastToken;
 			bool			fShuttingDown;
 			BPath			fSystemAppPath;
@@ -0,0 +1,287 @@
+/*
+ * Copyright 2011, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include "TimerWheel.h"
+
+
+/*!	\class TimerWheel
+	\brief A hierarchical timer wheel.
+
+	Entries are sorted into slots by their time, which is rounded up to a
+	multiple of the wheel's resolution (a "tick"). All entries of one tick
+	become due together, so entries whose times are less than a resolution
+	apart are coalesced.
+
+	The first level has a slot for each of the next SLOT_COUNT ticks. Each
+	slot of the next level covers SLOT_COUNT slots of the level before, and so
+	on. Entries too far in the future for the last level are kept in an
+	overflow list. Whenever the current tick reaches the range of a slot in
+	a higher level, the slot is cascaded, ie. its entries are distributed to
+	the lower levels again. Adding and removing an entry therefore always
+	takes constant time, independent of the number of entries.
+
+	The wheel itself does no locking.
+*/
+
+
+TimerWheelEntry::TimerWheelEntry()
+	:
+	fTime(0),
+	fTick(0),
+	fLevel(0),
+	fList(NULL)
+{
+}
+
+
+// #pragma mark -
+
+
+/*!	\brief Creates a new timer wheel.
+	\param resolution The length of a tick, ie. the time within which entries
+		   are coalesced.
+*/
+TimerWheel::TimerWheel(bigtime_t resolution)
+	:
+	fEntryCount(0),
+	fCurrentTick(0),
+	fResolution(resolution > 0 ? resolution : 1)
+{
+	for (int32 i = 0; i <= LEVEL_COUNT; i++)
+		fLevelCounts[i] = 0;
+
+	fCurrentTick = system_time() / fResolution;
+}
+
+
+/*!	\brief Frees all resources associated with the object.
+
+	The entries still in the wheel are not deleted.
+*/
+TimerWheel::~TimerWheel()
+{
+}
+
+
+/*!	\brief Adds an entry to the wheel.
+
+	If the time has already passed, the entry is due with the next
+	CollectDue().
+
+	\param entry The entry. Must not already be in the wheel.
+	\param time The time at which the entry shall become due.
+*/
+void
+TimerWheel::Add(TimerWheelEntry *entry, bigtime_t time)
+{
+	entry->fTime = time;
+
+	// round up, so that an entry never becomes due too early
+	entry->fTick = time / fResolution;
+	if (entry->fTick * fResolution < time)
+		entry->fTick++;
+
+	_Insert(entry);
+	fEntryCount++;
+}
+
+
+/*!	\brief Removes an entry from the wheel.
+
+	Does nothing, if the entry isn't in the wheel.
+
+	\param entry The entry.
+*/
+void
+TimerWheel::Remove(TimerWheelEntry *entry)
+{
+	if (entry->fList == NULL)
+		return;
+
+	entry->fList->Remove(entry);
+	entry->fList = NULL;
+	fLevelCounts[entry->fLevel]--;
+	fEntryCount--;
+}
+
+
+/*!	\brief Removes all entries due at time \a now from the wheel.
+
+	\param now The current time.
+	\param due The list the due entries are appended to, ordered by tick.
+*/
+void
+TimerWheel::CollectDue(bigtime_t now, TimerWheelEntryList &due)
+{
+	int64 nowTick = now / fResolution;
+
+	while (fCurrentTick <= nowTick) {
+		if (fEntryCount == 0) {
+			fCurrentTick = nowTick + 1;
+			break;
+		}
+
+		int64 nextTick = fCurrentTick + 1;
+		if (fLevelCounts[0] > 0) {
+			TimerWheelEntryList &slot = fSlots[0][fCurrentTick & SLOT_MASK];
+			while (TimerWheelEntry *entry = slot.RemoveHead()) {
+				entry->fList = NULL;
+				fLevelCounts[0]--;
+				fEntryCount--;
+				due.Add(entry);
+			}
+		} else {
+			// skip to the next cascade at once
+			nextTick = min_c((fCurrentTick | SLOT_MASK) + 1, nowTick + 1);
+		}
+
+		fCurrentTick = nextTick;
+		if ((fCurrentTick & SLOT_MASK) == 0)
+			_CascadeAll();
+	}
+}
+
+
+/*!	\brief Returns the time at which the next entry becomes due.
+
+	The time is a multiple of the resolution, and never earlier than the
+	time of the entry.
+
+	\return The time, or \c B_INFINITE_TIMEOUT, if the wheel is empty.
+*/
+bigtime_t
+TimerWheel::NextTime() const
+{
+	if (fEntryCount == 0)
+		return B_INFINITE_TIMEOUT;
+
+	int64 nextTick = -1;
+
+	// In each level, the first non-empty slot after the current one holds
+	// the earliest entries of that level. Entries of a higher level may
+	// still become due before those of a lower one, though.
+	for (int32 level = 0; level < LEVEL_COUNT; level++) {
+		if (fLevelCounts[level] == 0)
+			continue;
+
+		int32 shift = level * LEVEL_BITS;
+		int64 current = fCurrentTick >> shift;
+		for (int32 i = level == 0 ? 0 : 1; i <= SLOT_COUNT; i++) {
+			const TimerWheelEntryList &slot
+				= fSlots[level][(current + i) & SLOT_MASK];
+			if (slot.IsEmpty())
+				continue;
+
+			int64 tick = _EarliestTick(slot);
+			if (nextTick < 0 || tick < nextTick)
+				nextTick = tick;
+			break;
+		}
+	}
+
+	if (fLevelCounts[OVERFLOW_LEVEL] > 0) {
+		int64 tick = _EarliestTick(fOverflow);
+		if (nextTick < 0 || tick < nextTick)
+			nextTick = tick;
+	}
+
+	// entries that were already due when added are in the current slot
+	if (nextTick < fCurrentTick)
+		nextTick = fCurrentTick;
+
+	return nextTick * fResolution;
+}
+
+
+/*!	\brief Puts an entry into the slot matching its tick.
+*/
+void
+TimerWheel::_Insert(TimerWheelEntry *entry)
+{
+	int64 tick = max_c(entry->fTick, fCurrentTick);
+	int64 delta = tick - fCurrentTick;
+
+	int32 level = 0;
+	while (level < LEVEL_COUNT
+		&& delta >= (int64)1 << ((level + 1) * LEVEL_BITS)) {
+		level++;
+	}
+
+	TimerWheelEntryList *list;
+	if (level == LEVEL_COUNT)
+		list = &fOverflow;
+	else
+		list = &fSlots[level][(tick >> (level * LEVEL_BITS)) & SLOT_MASK];
+
+	list->Add(entry);
+	entry->fList = list;
+	entry->fLevel = level;
+	fLevelCounts[level]++;
+}
+
+
+/*!	\brief Cascades the slots of all levels whose range starts with the
+		   current tick.
+
+	Called whenever the current tick enters the range of a new slot of the
+	second level, so that the current slot of any level is always empty,
+	except for entries a whole wheel turn ahead.
+*/
+void
+TimerWheel::_CascadeAll()
+{
+	int32 level = 1;
+	while (level < LEVEL_COUNT
+		&& ((fCurrentTick >> (level * LEVEL_BITS)) & SLOT_MASK) == 0) {
+		level++;
+	}
+
+	if (level == LEVEL_COUNT) {
+		// time to look at the overflow entries again -- those that are still
+		// too far ahead go right back into the overflow list
+		TimerWheelEntryList overflow;
+		overflow.MoveFrom(&fOverflow);
+		while (TimerWheelEntry *entry = overflow.RemoveHead()) {
+			fLevelCounts[OVERFLOW_LEVEL]--;
+			_Insert(entry);
+		}
+	}
+
+	for (level = min_c(level, LEVEL_COUNT - 1); level > 0; level--)
+		_Cascade(level);
+}
+
+
+/*!	\brief Distributes the entries of the current slot of \a level to the
+		   lower levels.
+*/
+void
+TimerWheel::_Cascade(int32 level)
+{
+	TimerWheelEntryList &slot
+		= fSlots[level][(fCurrentTick >> (level * LEVEL_BITS)) & SLOT_MASK];
+
+	while (TimerWheelEntry *entry = slot.RemoveHead()) {
+		fLevelCounts[level]--;
+		_Insert(entry);
+	}
+}
+
+
+/*!	\brief Returns the earliest tick of the entries in \a list.
+*/
+int64
+TimerWheel::_EarliestTick(const TimerWheelEntryList &list) const
+{
+	int64 earliest = -1;
+	for (TimerWheelEntryList::ConstIterator it = list.GetIterator();
+			const TimerWheelEntry *entry = it.Next();) {
+		if (earliest < 0 || entry->fTick < earliest)
+			earliest = entry->fTick;
+	}
+
+	return earliest;
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2011, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+
+#include <OS.h>
+
+#include <util/DoublyLinkedList.h>
+
+
+class TimerWheel;
+
+
+// TimerWheelEntry
+class TimerWheelEntry : public DoublyLinkedListLinkImpl<TimerWheelEntry> {
+public:
+	TimerWheelEntry();
+
+	bigtime_t Time() const		{ return fTime; }
+	bool IsScheduled() const	{ return fList != NULL; }
+
+private:
+	friend class TimerWheel;
+
+	bigtime_t							fTime;
+	int64								fTick;
+	int32								fLevel;
+	DoublyLinkedList<TimerWheelEntry>	*fList;
+};
+
+typedef DoublyLinkedList<TimerWheelEntry> TimerWheelEntryList;
+
+
+// TimerWheel
+class TimerWheel {
+public:
+	TimerWheel(bigtime_t resolution);
+	~TimerWheel();
+
+	bigtime_t Resolution() const	{ return fResolution; }
+	int32 CountEntries() const		{ return fEntryCount; }
+
+	void Add(TimerWheelEntry *entry, bigtime_t time);
+	void Remove(TimerWheelEntry *entry);
+
+	void CollectDue(bigtime_t now, TimerWheelEntryList &due);
+	bigtime_t NextTime() const;
+
+private:
+	enum {
+		LEVEL_BITS	= 6,
+		SLOT_COUNT	= 1 << LEVEL_BITS,
+		SLOT_MASK	= SLOT_COUNT - 1,
+		LEVEL_COUNT	= 4,
+		OVERFLOW_LEVEL	= LEVEL_COUNT
+	};
+
+	void _Insert(TimerWheelEntry *entry);
+	void _CascadeAll();
+	void _Cascade(int32 level);
+	int64 _EarliestTick(const TimerWheelEntryList &list) const;
+
+	TimerWheelEntryList		fSlots[LEVEL_COUNT][SLOT_COUNT];
+	TimerWheelEntryList		fOverflow;
+	int32					fLevelCounts[LEVEL_COUNT + 1];
+	int32					fEntryCount;
+	int64					fCurrentTick;
+	bigtime_t				fResolution;
+};
+
+#endif	// TIMER_WHEEL_H
@@ -29,6 +29,7 @@
 #include <String.h>
 #include <TypeConstants.h>
 
+#include <AutoDeleter.h>
 #include <AutoLocker.h>
 #include <mime/database_access.h>
 #include <mime/database_support.h>
@@ -68,6 +69,10 @@ Database::Database()
 	// Do some really minor error checking
 	BEntry entry(get_database_directory().c_str());
 	fStatus = entry.Exists() ? B_OK : B_BAD_VALUE;
+
+	// Without a snapshot, the clients just use the database directly.
+	if (fStatus == B_OK)
+		fSnapshot.Init();
 }
 
 // destructor
@@ -738,46 +743,22 @@ Database::GuessMimeType(const entry_ref *ref, BString *result)
 	if (ref == NULL || result == NULL)
 		return B_BAD_VALUE;
 
-	BNode node;
-	struct stat statData;
-	status_t status = node.SetTo(ref);
-	if (status < B_OK)
+	bool isFile;
+	status_t status = _GuessNodeMimeType(ref, result, &isFile);
+	if (status != B_OK || !isFile)
 		return status;
 
-	attr_info info;
-	if (node.GetAttrInfo(kTypeAttr, &info) == B_OK) {
-		// Check for a META:TYPE attribute
-		result->SetTo(kMetaMimeType);
-		return B_OK;
-	}
+	// Vanilla file: sniff first
+	status = fSnifferRules.GuessMimeType(ref, result);
 
-	// See if we have a directory, a symlink, or a vanilla file
-	status = node.GetStat(&statData);
-	if (status < B_OK)
-		return status;
+	// If that fails, check extensions
+	if (status == kMimeGuessFailureError)
+		status = fAssociatedTypes.GuessMimeType(ref, result);
 
-	if (S_ISDIR(statData.st_mode)) {
-		// Directory
-		result->SetTo(kDirectoryType);
-	} else if (S_ISLNK(statData.st_mode)) {
-		// Symlink
-		result->SetTo(kSymlinkType);
-	} else if (S_ISREG(statData.st_mode)) {
-		// Vanilla file: sniff first
-		status = fSnifferRules.GuessMimeType(ref, result);
-
-		// If that fails, check extensions
-		if (status == kMimeGuessFailureError)
-			status = fAssociatedTypes.GuessMimeType(ref, result);
-
-		// If that fails, return the generic file type
-		if (status == kMimeGuessFailureError) {
-			result->SetTo(kGenericFileType);
-			status = B_OK;
-		}
-	} else {
-		// TODO: we could filter out devices, ...
-		return B_BAD_TYPE;
+	// If that fails, return the generic file type
+	if (status == kMimeGuessFailureError) {
+		result->SetTo(kGenericFileType);
+		status = B_OK;
 	}
 
 	return status;
@@ -841,6 +822,139 @@ Database::GuessMimeType(const char *filename, BString *result)
 	return status;
 }
 
+// GuessMimeTypes
+/*!	\brief Guesses the MIME types of several entries at once.
+
+	The result is the same as that of calling
+	GuessMimeType(const entry_ref*, BString*) for each of the entries, but the
+	data of all regular files is sniffed in one go.
+
+	\param files Array of \a count entry_refs referring to the entries.
+	\param count The number of entries.
+	\param results Array of \a count pre-allocated BStrings which are set to
+		   the resulting MIME types.
+	\param statuses Array of \a count elements, which are set to the status
+		   GuessMimeType() would have returned for the respective entry.
+	\return
+	- \c B_OK: success, the individual results are found in \a statuses
+	- other error code: failure
+*/
+status_t
+Database::GuessMimeTypes(const entry_ref *files, int32 count,
+	BString *results, status_t *statuses)
+{
+	if (files == NULL || results == NULL || statuses == NULL || count < 0)
+		return B_BAD_VALUE;
+
+	entry_ref *fileRefs = new(std::nothrow) entry_ref[count];
+	int32 *fileIndices = new(std::nothrow) int32[count];
+	BString *fileTypes = new(std::nothrow) BString[count];
+	status_t *fileStatuses = new(std::nothrow) status_t[count];
+	ArrayDeleter<entry_ref> refsDeleter(fileRefs);
+	ArrayDeleter<int32> indicesDeleter(fileIndices);
+	ArrayDeleter<BString> typesDeleter(fileTypes);
+	ArrayDeleter<status_t> statusesDeleter(fileStatuses);
+	if (fileRefs == NULL || fileIndices == NULL || fileTypes == NULL
+		|| fileStatuses == NULL) {
+		return B_NO_MEMORY;
+	}
+
+	// Handle everything but the regular files first
+	int32 fileCount = 0;
+	for (int32 i = 0; i < count; i++) {
+		bool isFile;
+		statuses[i] = _GuessNodeMimeType(&files[i], &results[i], &isFile);
+		if (statuses[i] == B_OK && isFile) {
+			fileRefs[fileCount] = files[i];
+			fileIndices[fileCount] = i;
+			fileCount++;
+		}
+	}
+
+	// Sniff all files at once
+	status_t status = fSnifferRules.GuessMimeTypes(fileRefs, fileCount,
+		fileTypes, fileStatuses);
+	if (status != B_OK)
+		return status;
+
+	for (int32 i = 0; i < fileCount; i++) {
+		int32 index = fileIndices[i];
+		status = fileStatuses[i];
+		if (status == B_OK)
+			results[index] = fileTypes[i];
+
+		// If that fails, check extensions
+		if (status == kMimeGuessFailureError)
+			status = fAssociatedTypes.GuessMimeType(&files[index],
+				&results[index]);
+
+		// If that fails, return the generic file type
+		if (status == kMimeGuessFailureError) {
+			results[index].SetTo(kGenericFileType);
+			status = B_OK;
+		}
+
+		statuses[index] = status;
+	}
+
+	return B_OK;
+}
+
+// _GuessNodeMimeType
+/*!	\brief Guesses the MIME type of an entry from its node alone.
+
+	Handles the cases of GuessMimeType(const entry_ref*, BString*) that don't
+	need the data of the entry: meta mime entries, directories, and symlinks.
+
+	\param file The entry.
+	\param result Set to the resulting MIME type, unless the entry turns out
+		   to be a regular file.
+	\param isFile Set to \c true, if the entry is a regular file that needs
+		   to be sniffed, to \c false otherwise.
+	\return
+	- \c B_OK: success
+	- other error code: failure
+*/
+status_t
+Database::_GuessNodeMimeType(const entry_ref *file, BString *result,
+	bool *isFile)
+{
+	*isFile = false;
+
+	BNode node;
+	struct stat statData;
+	status_t status = node.SetTo(file);
+	if (status < B_OK)
+		return status;
+
+	attr_info info;
+	if (node.GetAttrInfo(kTypeAttr, &info) == B_OK) {
+		// Check for a META:TYPE attribute
+		result->SetTo(kMetaMimeType);
+		return B_OK;
+	}
+
+	// See if we have a directory, a symlink, or a vanilla file
+	status = node.GetStat(&statData);
+	if (status < B_OK)
+		return status;
+
+	if (S_ISDIR(statData.st_mode)) {
+		// Directory
+		result->SetTo(kDirectoryType);
+	} else if (S_ISLNK(statData.st_mode)) {
+		// Symlink
+		result->SetTo(kSymlinkType);
+	} else if (S_ISREG(statData.st_mode)) {
+		*isFile = true;
+	} else {
+		// TODO: we could filter out devices, ...
+		return B_BAD_TYPE;
+	}
+
+	return B_OK;
+}
+
 
 /*!	\brief Subscribes the given BMessenger to the MIME monitor service
 
@@ -955,6 +1069,32 @@ Database::StopWatching(BMessenger target)
 }
 
 
+/*!	\brief Withdraws the database snapshot the clients use for reading.
+
+	Must be called before the database is changed; UpdateSnapshot() will
+	publish a new one.
+*/
+void
+Database::InvalidateSnapshot()
+{
+	fSnapshot.Invalidate();
+}
+
+
+/*!	\brief Publishes a new snapshot of the database for the clients to read.
+
+	Reads the whole database, so it should not be called for every change.
+*/
+status_t
+Database::UpdateSnapshot()
+{
+	if (fStatus != B_OK)
+		return fStatus;
+
+	return fSnapshot.Update(fSupportingApps);
+}
+
+
 /*!	\brief Deletes the app hint attribute for the given type
 
 	A \c B_APP_HINT_CHANGED notification is sent to the mime monitor service.
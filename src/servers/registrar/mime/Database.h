@@ -21,6 +21,7 @@
 #include <mime/database_access.h>
 
 #include "AssociatedTypes.h"
+#include "DatabaseSnapshot.h"
 #include "InstalledTypes.h"
 #include "SnifferRules.h"
 #include "SupportingApps.h"
@@ -84,6 +85,8 @@ class Database {
 		status_t GuessMimeType(const entry_ref *file, BString *result);
 		status_t GuessMimeType(const void *buffer, int32 length, BString *result);
 		status_t GuessMimeType(const char *filename, BString *result);
+		status_t GuessMimeTypes(const entry_ref *files, int32 count,
+					BString *results, status_t *statuses);
 
 		// Monitor
 		status_t StartWatching(BMessenger target);
@@ -104,6 +107,10 @@ class Database {
 		status_t DeleteSnifferRule(const char *type);
 		status_t DeleteSupportedTypes(const char *type, bool fullSync);
 
+		// Snapshot
+		void InvalidateSnapshot();
+		status_t UpdateSnapshot();
+
 		// deferred notifications
 		void	DeferInstallNotification(const char* type);
 		void	UndeferInstallNotification(const char* type);
@@ -114,6 +121,9 @@ class Database {
 			bool	notify;
 		};
 
+		status_t _GuessNodeMimeType(const entry_ref *file, BString *result,
+					bool *isFile);
+
 		status_t _SetStringValue(const char *type, int32 what,
 					const char* attribute, type_code attributeType,
 					size_t maxLength, const char *value);
@@ -142,6 +152,7 @@ class Database {
 		InstalledTypes fInstalledTypes;
 		SnifferRules fSnifferRules;
 		SupportingApps fSupportingApps;
+		DatabaseSnapshot fSnapshot;
 
 		BLocker	fDeferredInstallNotificationsLocker;
 		BList	fDeferredInstallNotifications;
@@ -0,0 +1,472 @@
+/*
+ * Copyright 2011, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include "DatabaseSnapshot.h"
+
+#include <algorithm>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <string.h>
+
+#include <Directory.h>
+#include <Entry.h>
+#include <fs_attr.h>
+#include <Node.h>
+
+#include <mime/database_support.h>
+#include <storage_support.h>
+
+#include "SupportingApps.h"
+
+
+namespace BPrivate {
+namespace Storage {
+namespace Mime {
+
+
+/*!	\class DatabaseSnapshot
+	\brief Publishes a read-only snapshot of the MIME database to all teams.
+
+	Most BMimeType getters read an attribute of a type's database file, and
+	BMimeType::GetSupportingApps() even asks the registrar. The snapshot
+	contains all attributes of all types, and the supporting apps table, in a
+	single area that clients clone and search directly (see
+	mime/database_snapshot.h).
+
+	Clients find the current snapshot through a small control area. The
+	Database must Invalidate() the snapshot before changing anything; the
+	clients will then go to the file system until Update() has published a
+	new snapshot.
+*/
+
+
+// Attributes larger than this aren't included in the snapshot, only listed.
+static const size_t kMaxAttributeDataSize = 64 * 1024;
+
+static const uint32 kNoData = ~(uint32)0;
+
+
+static inline size_t
+align_data(size_t offset)
+{
+	return (offset + 7) & ~(size_t)7;
+}
+
+
+class DatabaseSnapshot::Builder {
+public:
+								Builder();
+
+			status_t			AddTypes();
+			void				AddAppLists(
+									const SupportingApps::AppSetMap& apps);
+
+			status_t			Layout(size_t* _size);
+			void				Write(uint8* buffer, int32 generation) const;
+
+private:
+			struct attribute_entry {
+				uint32			name;
+				type_code		type;
+				uint32			size;
+				uint32			data;
+			};
+
+			struct type_entry {
+				std::string		name;
+				uint32			first_attribute;
+				uint32			attribute_count;
+
+				bool operator<(const type_entry& other) const
+					{ return name < other.name; }
+			};
+
+			struct app_list_entry {
+				uint32			type;
+				uint32			first_app;
+				uint32			app_count;
+			};
+
+			void				_AddType(const std::string& name,
+									BNode& node);
+			uint32				_AddString(const std::string& string);
+
+			std::vector<type_entry> fTypes;
+			std::vector<attribute_entry> fAttributes;
+			std::vector<app_list_entry> fAppLists;
+			std::vector<uint32>	fApps;
+
+			// strings and attribute data; offsets are relative to its start
+			std::vector<uint8>	fBlob;
+			std::map<std::string, uint32> fStrings;
+
+			uint32				fTypesOffset;
+			uint32				fAttributesOffset;
+			uint32				fAppListsOffset;
+			uint32				fAppsOffset;
+			uint32				fBlobOffset;
+			uint32				fSize;
+};
+
+
+DatabaseSnapshot::Builder::Builder()
+	:
+	fTypesOffset(0),
+	fAttributesOffset(0),
+	fAppListsOffset(0),
+	fAppsOffset(0),
+	fBlobOffset(0),
+	fSize(0)
+{
+}
+
+
+/*!	\brief Adds all types of the database with all their attributes.
+
+	The database is a directory with a subdirectory per supertype, which
+	contains a file per subtype.
+*/
+status_t
+DatabaseSnapshot::Builder::AddTypes()
+{
+	BDirectory root;
+	status_t status = root.SetTo(get_database_directory().c_str());
+	if (status != B_OK)
+		return status;
+
+	BEntry entry;
+	while (root.GetNextEntry(&entry) == B_OK) {
+		char name[B_FILE_NAME_LENGTH];
+		BNode node(&entry);
+		if (entry.GetName(name) != B_OK || node.InitCheck() != B_OK)
+			continue;
+
+		std::string supertype;
+		to_lower(name, supertype);
+		_AddType(supertype, node);
+
+		if (!entry.IsDirectory())
+			continue;
+
+		BDirectory directory(&entry);
+		BEntry subEntry;
+		while (directory.GetNextEntry(&subEntry) == B_OK) {
+			BNode subNode(&subEntry);
+			if (subEntry.GetName(name) != B_OK
+				|| subNode.InitCheck() != B_OK) {
+				continue;
+			}
+
+			std::string subtype;
+			to_lower(name, subtype);
+			_AddType(supertype + "/" + subtype, subNode);
+		}
+	}
+
+	std::sort(fTypes.begin(), fTypes.end());
+	return B_OK;
+}
+
+
+//! Adds the supporting apps table, leaving out types no app supports.
+void
+DatabaseSnapshot::Builder::AddAppLists(const SupportingApps::AppSetMap& apps)
+{
+	// the map is sorted already, and so are the sets
+	SupportingApps::AppSetMap::const_iterator i;
+	for (i = apps.begin(); i != apps.end(); i++) {
+		if (i->second.empty())
+			continue;
+
+		app_list_entry list;
+		list.type = _AddString(i->first);
+		list.first_app = fApps.size();
+		list.app_count = i->second.size();
+
+		std::set<std::string>::const_iterator app;
+		for (app = i->second.begin(); app != i->second.end(); app++)
+			fApps.push_back(_AddString(*app));
+
+		fAppLists.push_back(list);
+	}
+}
+
+
+/*!	\brief Computes the offsets of the parts of the snapshot, and returns its
+	total size.
+*/
+status_t
+DatabaseSnapshot::Builder::Layout(size_t* _size)
+{
+	uint64 offset = sizeof(mime_snapshot_header);
+	fTypesOffset = offset;
+	offset += (uint64)fTypes.size() * sizeof(mime_snapshot_type);
+	fAttributesOffset = offset;
+	offset += (uint64)fAttributes.size() * sizeof(mime_snapshot_attribute);
+	fAppListsOffset = offset;
+	offset += (uint64)fAppLists.size() * sizeof(mime_snapshot_app_list);
+	fAppsOffset = offset;
+	offset += (uint64)fApps.size() * sizeof(uint32);
+	offset = align_data(offset);
+	fBlobOffset = offset;
+	offset += fBlob.size();
+
+	// all offsets are 32 bit
+	if (offset > (uint64)~(uint32)0)
+		return B_BUFFER_OVERFLOW;
+
+	fSize = offset;
+	*_size = fSize;
+	return B_OK;
+}
+
+
+//! Writes the snapshot into \a buffer, which must be at least Layout() large.
+void
+DatabaseSnapshot::Builder::Write(uint8* buffer, int32 generation) const
+{
+	mime_snapshot_header* header = (mime_snapshot_header*)buffer;
+	header->magic = MIME_SNAPSHOT_MAGIC;
+	header->version = MIME_SNAPSHOT_VERSION;
+	header->generation = generation;
+	header->size = fSize;
+	header->type_count = fTypes.size();
+	header->types = fTypesOffset;
+	header->app_list_count = fAppLists.size();
+	header->app_lists = fAppListsOffset;
+
+	mime_snapshot_type* types = (mime_snapshot_type*)(buffer + fTypesOffset);
+	for (size_t i = 0; i < fTypes.size(); i++) {
+		const type_entry& type = fTypes[i];
+		types[i].name = fBlobOffset + fStrings.find(type.name)->second;
+		types[i].attributes = fAttributesOffset
+			+ type.first_attribute * sizeof(mime_snapshot_attribute);
+		types[i].attribute_count = type.attribute_count;
+	}
+
+	mime_snapshot_attribute* attributes
+		= (mime_snapshot_attribute*)(buffer + fAttributesOffset);
+	for (size_t i = 0; i < fAttributes.size(); i++) {
+		const attribute_entry& attribute = fAttributes[i];
+		attributes[i].name = fBlobOffset + attribute.name;
+		attributes[i].type = attribute.type;
+		attributes[i].size = attribute.size;
+		attributes[i].data = attribute.data != kNoData
+			? fBlobOffset + attribute.data : 0;
+	}
+
+	mime_snapshot_app_list* lists
+		= (mime_snapshot_app_list*)(buffer + fAppListsOffset);
+	for (size_t i = 0; i < fAppLists.size(); i++) {
+		const app_list_entry& list = fAppLists[i];
+		lists[i].type = fBlobOffset + list.type;
+		lists[i].apps = fAppsOffset + list.first_app * sizeof(uint32);
+		lists[i].app_count = list.app_count;
+	}
+
+	uint32* apps = (uint32*)(buffer + fAppsOffset);
+	for (size_t i = 0; i < fApps.size(); i++)
+		apps[i] = fBlobOffset + fApps[i];
+
+	if (!fBlob.empty())
+		memcpy(buffer + fBlobOffset, &fBlob[0], fBlob.size());
+}
+
+
+void
+DatabaseSnapshot::Builder::_AddType(const std::string& name, BNode& node)
+{
+	type_entry type;
+	type.name = name;
+	type.first_attribute = fAttributes.size();
+	type.attribute_count = 0;
+	_AddString(name);
+
+	char attributeName[B_ATTR_NAME_LENGTH];
+	node.RewindAttrs();
+	while (node.GetNextAttrName(attributeName) == B_OK) {
+		attr_info info;
+		if (node.GetAttrInfo(attributeName, &info) != B_OK)
+			continue;
+
+		attribute_entry attribute;
+		attribute.name = _AddString(attributeName);
+		attribute.type = info.type;
+		attribute.size = info.size;
+		attribute.data = kNoData;
+
+		if ((size_t)info.size <= kMaxAttributeDataSize) {
+			size_t offset = align_data(fBlob.size());
+			fBlob.resize(offset + info.size);
+
+			ssize_t bytesRead = info.size > 0
+				? node.ReadAttr(attributeName, info.type, 0, &fBlob[offset],
+					info.size)
+				: 0;
+			if (bytesRead == info.size)
+				attribute.data = offset;
+			else
+				fBlob.resize(offset);
+		}
+
+		fAttributes.push_back(attribute);
+		type.attribute_count++;
+	}
+
+	fTypes.push_back(type);
+}
+
+
+//! Adds a null terminated string to the blob, unless it's already there.
+uint32
+DatabaseSnapshot::Builder::_AddString(const std::string& string)
+{
+	std::map<std::string, uint32>::iterator found = fStrings.find(string);
+	if (found != fStrings.end())
+		return found->second;
+
+	uint32 offset = fBlob.size();
+	fBlob.insert(fBlob.end(), string.c_str(),
+		string.c_str() + string.length() + 1);
+	fStrings[string] = offset;
+
+	return offset;
+}
+
+
+// #pragma mark -
+
+
+DatabaseSnapshot::DatabaseSnapshot()
+	:
+	fControlArea(-1),
+	fControl(NULL),
+	fSnapshotArea(-1)
+{
+}
+
+
+DatabaseSnapshot::~DatabaseSnapshot()
+{
+	// Clients keep their clone of the control area; leave it in a state that
+	// makes them go to the file system.
+	Invalidate();
+
+	if (fControlArea >= 0)
+		delete_area(fControlArea);
+}
+
+
+//! Creates the control area. There is no snapshot until Update() is called.
+status_t
+DatabaseSnapshot::Init()
+{
+	void* address;
+	area_id area = create_area(MIME_SNAPSHOT_CONTROL_AREA_NAME, &address,
+		B_ANY_ADDRESS, B_PAGE_SIZE, B_NO_LOCK, B_READ_AREA | B_WRITE_AREA);
+	if (area < 0)
+		return area;
+
+	fControlArea = area;
+	fControl = (mime_snapshot_control*)address;
+	fControl->snapshot = -1;
+	fControl->generation = 0;
+	fControl->magic = MIME_SNAPSHOT_MAGIC;
+
+	return B_OK;
+}
+
+
+/*!	\brief Withdraws the current snapshot.
+
+	Must be called before the database is changed. Clients that already
+	look at the snapshot may still finish doing so, but any new lookup will
+	go to the file system.
+*/
+void
+DatabaseSnapshot::Invalidate()
+{
+	if (fControl == NULL || fSnapshotArea < 0)
+		return;
+
+	fControl->snapshot = -1;
+	atomic_add(&fControl->generation, 1);
+
+	_DeleteSnapshot();
+}
+
+
+/*!	\brief Creates a snapshot of the current state of the database and
+	publishes it.
+
+	\param supportingApps The registrar's supporting apps table, which is
+		included in the snapshot as well.
+*/
+status_t
+DatabaseSnapshot::Update(SupportingApps& supportingApps)
+{
+	if (fControl == NULL)
+		return B_NO_INIT;
+
+	const SupportingApps::AppSetMap* apps;
+	status_t status = supportingApps.GetAllSupportingApps(&apps);
+	if (status != B_OK)
+		return status;
+
+	Builder builder;
+	size_t size;
+	try {
+		status = builder.AddTypes();
+		if (status == B_OK) {
+			builder.AddAppLists(*apps);
+			status = builder.Layout(&size);
+		}
+	} catch (std::bad_alloc&) {
+		status = B_NO_MEMORY;
+	}
+	if (status != B_OK)
+		return status;
+
+	size_t areaSize = (size + B_PAGE_SIZE - 1) / B_PAGE_SIZE * B_PAGE_SIZE;
+	void* address;
+	area_id area = create_area(MIME_SNAPSHOT_AREA_NAME, &address,
+		B_ANY_ADDRESS, areaSize, B_NO_LOCK, B_READ_AREA | B_WRITE_AREA);
+	if (area < 0)
+		return area;
+
+	int32 generation = fControl->generation + 1;
+	builder.Write((uint8*)address, generation);
+	set_area_protection(area, B_READ_AREA);
+
+	// Publish the snapshot before the generation, so that clients seeing the
+	// new generation will find it. Clients that still see the old one will
+	// reject the snapshot, since its generation doesn't match.
+	fControl->snapshot = area;
+	atomic_set(&fControl->generation, generation);
+
+	_DeleteSnapshot();
+	fSnapshotArea = area;
+
+	return B_OK;
+}
+
+
+void
+DatabaseSnapshot::_DeleteSnapshot()
+{
+	if (fSnapshotArea >= 0) {
+		delete_area(fSnapshotArea);
+		fSnapshotArea = -1;
+	}
+}
+
+
+} // namespace Mime
+} // namespace Storage
+} // namespace BPrivate
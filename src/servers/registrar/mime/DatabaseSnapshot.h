@@ -0,0 +1,52 @@
+/*
+ * Copyright 2011, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _MIME_REGISTRAR_DATABASE_SNAPSHOT_H
+#define _MIME_REGISTRAR_DATABASE_SNAPSHOT_H
+
+
+#include <OS.h>
+
+#include <mime/database_snapshot.h>
+
+
+namespace BPrivate {
+namespace Storage {
+namespace Mime {
+
+
+class SupportingApps;
+
+
+class DatabaseSnapshot {
+public:
+								DatabaseSnapshot();
+								~DatabaseSnapshot();
+
+			status_t			Init();
+
+			void				Invalidate();
+			status_t			Update(SupportingApps& supportingApps);
+
+			bool				IsValid() const
+									{ return fSnapshotArea >= 0; }
+
+private:
+			class Builder;
+
+			void				_DeleteSnapshot();
+
+private:
+			area_id				fControlArea;
+			mime_snapshot_control* fControl;
+			area_id				fSnapshotArea;
+};
+
+
+} // namespace Mime
+} // namespace Storage
+} // namespace BPrivate
+
+
+#endif	// _MIME_REGISTRAR_DATABASE_SNAPSHOT_H
@@ -16,6 +16,7 @@
 
 #include <stdio.h>
 
+#include <AutoLocker.h>
 #include <Directory.h>
 #include <Message.h>
 #include <Path.h>
@@ -35,8 +36,24 @@ namespace Mime {
 /*!	\class MimeUpdateThread
 	\brief RegistrarThread class implementing the common functionality of
 	update_mime_info() and create_app_meta_mime()
+
+	When updating a directory tree, the directories are queued and processed
+	by a pool of up to MaxWorkerCount() threads, the MimeUpdateThread's own
+	thread being one of them. Each worker takes a directory from the queue,
+	updates its entries, and queues its subdirectories in turn. To avoid
+	thrashing a disk with concurrent requests, at most
+	\c kMaxWorkersPerVolume workers process directories of the same volume
+	at a time; the others turn to directories of other volumes meanwhile, or
+	wait.
 */
 
+//! The maximum number of worker threads of a tree update
+static const int32 kMaxWorkerThreads = 8;
+//! The maximum number of workers processing directories of the same volume
+static const int32 kMaxWorkersPerVolume = 3;
+//! The minimal interval between two progress notifications
+static const bigtime_t kProgressInterval = 500000;
+
 
 /*! \brief Creates a new MimeUpdateThread object.
 
@@ -58,6 +75,13 @@ MimeUpdateThread::MimeUpdateThread(const char *name, int32 priority,
 	fRecursive(recursive),
 	fForce(force),
 	fReplyee(replyee),
+	fLock("mime update thread"),
+	fWorkSem(-1),
+	fBusyWorkers(0),
+	fWaitingWorkers(0),
+	fWalkStatus(B_OK),
+	fEntryCount(0),
+	fLastProgressTime(0),
 	fStatus(root ? B_OK : B_BAD_VALUE)
 {
 }
@@ -89,6 +113,20 @@ MimeUpdateThread::InitCheck()
 }
 
 
+/*!	\brief Sets the target progress notifications shall be sent to.
+
+	While the thread is running, a \c B_REG_MIME_UPDATE_PROGRESS message
+	with an \c "entries" field holding the number of entries updated so far,
+	and an \c "entry" field holding the root entry, is sent to \a target
+	every now and then. Must be called before the thread is run.
+*/
+void
+MimeUpdateThread::SetProgressTarget(BMessenger target)
+{
+	fProgressTarget = target;
+}
+
+
 /*! \brief Implements the common functionality of update_mime_info() and
 	create_app_meta_mime(), namely iterating through the filesystem and
 	updating entries.
@@ -102,8 +140,11 @@ MimeUpdateThread::ThreadFunction()
 	// don't run into troubles
 	try {
 		// Do the updates
+		bool rootIsDir = false;
 		if (!err)
-			err = UpdateEntry(&fRoot);
+			err = UpdateEntry(&fRoot, &rootIsDir);
+		if (!err && fRecursive && rootIsDir)
+			err = UpdateTree();
 	} catch (...) {
 		err = B_ERROR;
 	}
@@ -112,6 +153,8 @@ MimeUpdateThread::ThreadFunction()
 	if (fReplyee) {
 		BMessage reply(B_REG_RESULT);
 		status_t error = reply.AddInt32("result", err);
+		if (!error)
+			error = reply.AddInt64("entries", fEntryCount);
 		err = error;
 		if (!err)
 			err = fReplyee->SendReply(&reply);
@@ -149,6 +192,8 @@ MimeUpdateThread::ThreadFunction()
 bool
 MimeUpdateThread::DeviceSupportsAttributes(dev_t device)
 {
+	AutoLocker<BLocker> locker(fLock);
+
 	// See if an entry for this device already exists
 	std::list< std::pair<dev_t,bool> >::iterator i;
 	for (i = fAttributeSupportList.begin();
@@ -179,59 +224,264 @@ MimeUpdateThread::DeviceSupportsAttributes(dev_t device)
 	return result;		
 }
 
+
+/*!	\brief Returns the maximum number of threads updating a directory tree
+	concurrently.
+
+	The default implementation returns 1, ie. the tree is walked by the
+	MimeUpdateThread's thread alone. Derived classes whose DoMimeUpdate() is
+	safe to be called from several threads at once may return more.
+*/
+int32
+MimeUpdateThread::MaxWorkerCount() const
+{
+	return 1;
+}
+
+
+/*!	\brief Entry function of the worker threads.
+
+	Also run by the MimeUpdateThread's own thread, to take part in the work.
+	Any exception terminates the whole tree walk.
+*/
+int32
+MimeUpdateThread::WorkerEntry(void *data)
+{
+	MimeUpdateThread *thread = (MimeUpdateThread*)data;
+	try {
+		thread->Work();
+	} catch (...) {
+		AutoLocker<BLocker> locker(thread->fLock);
+		if (thread->fWalkStatus == B_OK)
+			thread->fWalkStatus = B_ERROR;
+		thread->WakeUpWorkers(thread->fWaitingWorkers);
+	}
+	return 0;
+}
+
 // UpdateEntry
-/*! \brief Updates the given entry and then recursively updates all the entry's child
-	entries	if the entry is a directory and \c fRecursive is true.
+/*! \brief Updates the given entry.
+
+	The entry is skipped, if it doesn't live on a device that supports
+	attributes (no error is signalled, however).
+
+	\param ref The entry.
+	\param entryIsDir Set to \c true, if the entry was updated and is a
+		   directory, \c false otherwise.
 */
 status_t
-MimeUpdateThread::UpdateEntry(const entry_ref *ref)
+MimeUpdateThread::UpdateEntry(const entry_ref *ref, bool *entryIsDir)
 {
-	status_t err = ref ? B_OK : B_BAD_VALUE;
-	bool entryIsDir = false;
-	
+	*entryIsDir = false;
+
+	if (ref == NULL)
+		return B_BAD_VALUE;
+
 	// Look to see if we're being terminated
-	if (!err && fShouldExit)
-		err = B_CANCELED;
-		
-	// Before we update, make sure this entry lives on a device that supports
-	// attributes. If not, we skip it and any of its children for
-	// updates (we don't signal an error, however).
-
-//BPath path(ref);
-//printf("Updating '%s' (%s)... \n", path.Path(),
-//	(DeviceSupportsAttributes(ref->device) ? "yes" : "no"));
-
-	if (!err && (device_is_root_device(ref->device)
-				|| DeviceSupportsAttributes(ref->device))) {	
-		// Update this entry
-		if (!err) {
-			// R5 appears to ignore whether or not the update succeeds.
-			DoMimeUpdate(ref, &entryIsDir);
+	if (fShouldExit)
+		return B_CANCELED;
+
+	if (!device_is_root_device(ref->device)
+		&& !DeviceSupportsAttributes(ref->device)) {
+		return B_OK;
+	}
+
+	// R5 appears to ignore whether or not the update succeeds.
+	DoMimeUpdate(ref, entryIsDir);
+
+	EntryUpdated();
+	return B_OK;
+}
+
+
+/*!	\brief Updates all entries below the (already updated) root directory.
+
+	Spawns the additional worker threads and joins the work itself.
+
+	\return The first error that occurred while walking the tree.
+*/
+status_t
+MimeUpdateThread::UpdateTree()
+{
+	fWorkSem = create_sem(0, "mime update work");
+	if (fWorkSem < 0)
+		return fWorkSem;
+
+	QueueDirectory(&fRoot);
+
+	int32 workerCount = max_c(1, min_c(MaxWorkerCount(), kMaxWorkerThreads));
+
+	thread_info info;
+	int32 priority = B_NORMAL_PRIORITY;
+	if (get_thread_info(find_thread(NULL), &info) == B_OK)
+		priority = info.priority;
+
+	// If we can't spawn all workers, we just make do with fewer.
+	thread_id workers[kMaxWorkerThreads];
+	int32 spawnedCount = 0;
+	for (int32 i = 1; i < workerCount; i++) {
+		thread_id worker = spawn_thread(&WorkerEntry, "mime update worker",
+			priority, this);
+		if (worker < 0 || resume_thread(worker) != B_OK)
+			break;
+		workers[spawnedCount++] = worker;
+	}
+
+	WorkerEntry(this);
+
+	for (int32 i = 0; i < spawnedCount; i++) {
+		status_t result;
+		wait_for_thread(workers[i], &result);
+	}
+
+	delete_sem(fWorkSem);
+	fWorkSem = -1;
+
+	return fWalkStatus;
+}
+
+
+/*!	\brief Processes queued directories until the tree is done.
+
+	Executed by each of the worker threads. A worker waits, if all queued
+	directories live on volumes that already have the maximum number of
+	workers; it leaves, when the queue is empty and no other worker could
+	add to it anymore, or when an error occurred.
+*/
+void
+MimeUpdateThread::Work()
+{
+	AutoLocker<BLocker> locker(fLock);
+
+	while (true) {
+		if (fShouldExit && fWalkStatus == B_OK)
+			fWalkStatus = B_CANCELED;
+
+		if (fWalkStatus != B_OK
+			|| (fQueuedDirectories.empty() && fBusyWorkers == 0)) {
+			// we're done -- let the others know
+			WakeUpWorkers(fWaitingWorkers);
+			return;
+		}
+
+		// find a directory on a volume that isn't busy yet
+		std::list<entry_ref>::iterator it = fQueuedDirectories.begin();
+		for (; it != fQueuedDirectories.end(); it++) {
+			if (fVolumeWorkers[it->device] < kMaxWorkersPerVolume)
+				break;
 		}
 
-		// If we're recursing and this is a directory, update
-		// each of the directory's children as well
-		if (!err && fRecursive && entryIsDir) {		
-			BDirectory dir;		
-			err = dir.SetTo(ref);
-			if (!err) {
-				entry_ref childRef;
-				while (!err) {
-					err = dir.GetNextRef(&childRef);
-					if (err) {
-						// If we've come to the end of the directory listing,
-						// it's not an error.
-						if (err == B_ENTRY_NOT_FOUND)
-						 	err = B_OK;
-						break;
-					} else {
-						err = UpdateEntry(&childRef);				
-					}			
-				}		
-			}			
+		if (it == fQueuedDirectories.end()) {
+			fWaitingWorkers++;
+			locker.Unlock();
+			acquire_sem(fWorkSem);
+			locker.Lock();
+			continue;
 		}
+
+		entry_ref ref(*it);
+		fQueuedDirectories.erase(it);
+		fVolumeWorkers[ref.device]++;
+		fBusyWorkers++;
+		locker.Unlock();
+
+		status_t error = UpdateDirectory(&ref);
+
+		locker.Lock();
+		fVolumeWorkers[ref.device]--;
+		fBusyWorkers--;
+		if (error != B_OK && fWalkStatus == B_OK)
+			fWalkStatus = error;
+
+		// a slot for the volume has become free
+		WakeUpWorkers(1);
+	}
+}
+
+
+/*!	\brief Updates all entries of the given directory, and queues its
+	subdirectories.
+*/
+status_t
+MimeUpdateThread::UpdateDirectory(const entry_ref *ref)
+{
+	BDirectory dir;
+	status_t err = dir.SetTo(ref);
+
+	entry_ref childRef;
+	while (!err) {
+		err = dir.GetNextRef(&childRef);
+		if (err) {
+			// If we've come to the end of the directory listing,
+			// it's not an error.
+			if (err == B_ENTRY_NOT_FOUND)
+			 	err = B_OK;
+			break;
+		}
+
+		bool childIsDir;
+		err = UpdateEntry(&childRef, &childIsDir);
+		if (!err && childIsDir)
+			QueueDirectory(&childRef);
+	}
+
+	return err;
+}
+
+
+/*!	\brief Adds a directory to the queue, and wakes up a worker to process
+	it.
+*/
+void
+MimeUpdateThread::QueueDirectory(const entry_ref *ref)
+{
+	AutoLocker<BLocker> locker(fLock);
+
+	fQueuedDirectories.push_back(*ref);
+	WakeUpWorkers(1);
+}
+
+
+/*!	\brief Wakes up to \a count waiting workers.
+
+	The caller must hold \c fLock.
+*/
+void
+MimeUpdateThread::WakeUpWorkers(int32 count)
+{
+	count = min_c(count, fWaitingWorkers);
+	if (count <= 0)
+		return;
+
+	fWaitingWorkers -= count;
+	release_sem_etc(fWorkSem, count, 0);
+}
+
+
+/*!	\brief Counts an updated entry, and notifies the progress target, if
+	it's time to.
+*/
+void
+MimeUpdateThread::EntryUpdated()
+{
+	AutoLocker<BLocker> locker(fLock);
+
+	fEntryCount++;
+
+	if (!fProgressTarget.IsValid())
+		return;
+
+	bigtime_t now = system_time();
+	if (now - fLastProgressTime < kProgressInterval)
+		return;
+	fLastProgressTime = now;
+
+	// Don't let a slow target hold up the update
+	BMessage progress(B_REG_MIME_UPDATE_PROGRESS);
+	if (progress.AddRef("entry", &fRoot) == B_OK
+		&& progress.AddInt64("entries", fEntryCount) == B_OK) {
+		fProgressTarget.SendMessage(&progress, (BHandler*)NULL, 0);
 	}
-	return err;			  
 }
 
 }	// namespace Mime
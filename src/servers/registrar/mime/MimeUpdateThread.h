@@ -11,9 +11,12 @@
 #define _MIME_UPDATE_THREAD_H
 
 #include <Entry.h>
+#include <Locker.h>
+#include <Messenger.h>
 #include <SupportDefs.h>
 
 #include <list>
+#include <map>
 #include <utility>
 
 #include "RegistrarThread.h"
@@ -35,10 +38,13 @@ public:
 	virtual ~MimeUpdateThread();
 	
 	virtual status_t InitCheck();	
+
+	void SetProgressTarget(BMessenger target);
 	
 protected:
 	virtual status_t ThreadFunction();
 	virtual status_t DoMimeUpdate(const entry_ref *entry, bool *entryIsDir) = 0;
+	virtual int32 MaxWorkerCount() const;
 
 	Database* fDatabase;
 	const entry_ref fRoot;
@@ -49,9 +55,30 @@ protected:
 	bool DeviceSupportsAttributes(dev_t device);
 
 private:
+	static int32 WorkerEntry(void *data);
+
+	status_t UpdateEntry(const entry_ref *ref, bool *entryIsDir);
+	status_t UpdateTree();
+	void Work();
+	status_t UpdateDirectory(const entry_ref *ref);
+	void QueueDirectory(const entry_ref *ref);
+	void WakeUpWorkers(int32 count);
+	void EntryUpdated();
+
 	std::list< std::pair<dev_t, bool> > fAttributeSupportList;
 
-	status_t UpdateEntry(const entry_ref *ref);
+	// state of the tree walk, shared by the worker threads
+	BLocker fLock;
+	sem_id fWorkSem;
+	std::list<entry_ref> fQueuedDirectories;
+	std::map<dev_t, int32> fVolumeWorkers;
+	int32 fBusyWorkers;
+	int32 fWaitingWorkers;
+	status_t fWalkStatus;
+	int64 fEntryCount;
+
+	BMessenger fProgressTarget;
+	bigtime_t fLastProgressTime;
 	
 	status_t fStatus;
 };
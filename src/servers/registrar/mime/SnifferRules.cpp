@@ -17,6 +17,7 @@
 #include <stdio.h>
 #include <sys/stat.h>
 
+#include <AutoDeleter.h>
 #include <Directory.h>
 #include <Entry.h>
 #include <File.h>
@@ -107,12 +108,17 @@ bool operator<(SnifferRules::sniffer_rule &left, SnifferRules::sniffer_rule &rig
 /*!
 	\class SnifferRules
 	\brief Manages the sniffer rules for the entire database
+
+	Besides the sorted list of parsed rules, a Sniffer::RuleSet compiled from
+	that list is kept. It is used for the actual sniffing, and is recompiled
+	on the next sniff whenever the list changes.
 */
 
 // Constructor
 //! Constructs a new SnifferRules object
 SnifferRules::SnifferRules()
-	: fHaveDoneFullBuild(false)
+	: fHaveDoneFullBuild(false),
+	  fRuleSetValid(false)
 {
 }
 
@@ -210,6 +216,54 @@ SnifferRules::GuessMimeType(const void *buffer, int32 length, BString *type)
 	return GuessMimeType(NULL, buffer, length, type);
 }
 
+// GuessMimeTypes
+/*!	\brief Guesses the MIME types of several entries at once.
+
+	Works like calling GuessMimeType(const entry_ref*, BString*) for each of
+	the entries, but reuses the buffer the file data is read into.
+
+	\param refs The entries to sniff.
+	\param count The number of elements in \a refs.
+	\param types Array of \a count pre-allocated BStrings which are set to
+		   the resulting MIME types.
+	\param results Array of \a count elements, which are set to the result of
+		   sniffing the respective entry, like GuessMimeType() returns it.
+	\return
+	- \c B_OK: success, the individual results are found in \a results
+	- error code: failure, \a results is not set
+*/
+status_t
+SnifferRules::GuessMimeTypes(const entry_ref *refs, int32 count,
+	BString *types, status_t *results)
+{
+	if (refs == NULL || types == NULL || results == NULL || count < 0)
+		return B_BAD_VALUE;
+
+	ssize_t bytes = MaxBytesNeeded();
+	if (bytes < 0)
+		return bytes;
+
+	char *buffer = new(std::nothrow) char[bytes];
+	if (buffer == NULL)
+		return B_NO_MEMORY;
+	ArrayDeleter<char> _(buffer);
+
+	for (int32 i = 0; i < count; i++) {
+		BFile file;
+		status_t err = file.SetTo(&refs[i], B_READ_ONLY);
+		if (!err) {
+			ssize_t bytesRead = file.Read(buffer, bytes);
+			if (bytesRead < 0)
+				err = bytesRead;
+			else
+				err = GuessMimeType(&file, buffer, bytesRead, &types[i]);
+		}
+		results[i] = err;
+	}
+
+	return B_OK;
+}
+
 // SetSnifferRule
 /*! Updates the sniffer rule for the given type
 
@@ -231,6 +285,8 @@ SnifferRules::SetSnifferRule(const char *type, const char *rule)
 	if (!err && !fHaveDoneFullBuild)
 		return B_OK;
 
+	fRuleSetValid = false;
+
 	sniffer_rule item(new Sniffer::Rule());
 	BString parseError;
 
@@ -283,6 +339,8 @@ SnifferRules::DeleteSnifferRule(const char *type)
 	if (!err && !fHaveDoneFullBuild)
 		return B_OK;
 
+	fRuleSetValid = false;
+
 	// Find the rule in the list and remove it
 	for (std::list<sniffer_rule>::iterator i = fRuleList.begin();
 		   i != fRuleList.end();
@@ -329,6 +387,7 @@ status_t
 SnifferRules::BuildRuleList()
 {
 	fRuleList.clear();
+	fRuleSetValid = false;
 
 	ssize_t maxBytesNeeded = 0;
 	ssize_t bytesNeeded = 0;
@@ -413,6 +472,41 @@ SnifferRules::BuildRuleList()
 	return err;
 }
 
+// CompileRuleList
+/*! \brief Compiles the rule list into the rule set used for sniffing.
+
+	The rule set keeps the order of the list.
+*/
+status_t
+SnifferRules::CompileRuleList()
+{
+	fRuleSet.MakeEmpty();
+	fRuleSetRules.clear();
+
+	for (std::list<sniffer_rule>::const_iterator i = fRuleList.begin();
+		   i != fRuleList.end();
+		     i++)
+	{
+		if (!i->rule) {
+			DBG(OUT("WARNING: Mime::SnifferRules::CompileRuleList(): "
+				"NULL sniffer_rule::rule member found in rule list for type == '%s', "
+				"rule_string == '%s'\n",
+				i->type.c_str(), i->rule_string.c_str()));
+		}
+
+		status_t err = fRuleSet.AddRule(i->rule);
+		if (err) {
+			fRuleSet.MakeEmpty();
+			fRuleSetRules.clear();
+			return err;
+		}
+		fRuleSetRules.push_back(&*i);
+	}
+
+	fRuleSetValid = true;
+	return B_OK;
+}
+
 // GuessMimeType
 /*!	\brief Guesses a MIME type for the supplied chunk of data.
 
@@ -441,11 +535,10 @@ SnifferRules::GuessMimeType(BFile* file, const void *buffer, int32 length,
 	if (err)
 		return err;
 
-	// wrap the buffer by a BMemoryIO
-	BMemoryIO data(buffer, length);
-
 	if (!err && !fHaveDoneFullBuild)
 		err = BuildRuleList();
+	if (!err && !fRuleSetValid)
+		err = CompileRuleList();
 
 	// first ask the MimeSnifferAddonManager for a suitable type
 	float addonPriority = -1;
@@ -459,32 +552,16 @@ SnifferRules::GuessMimeType(BFile* file, const void *buffer, int32 length,
 	}
 
 	if (!err) {
-		// Run through our rule list, which is sorted in order of
-		// descreasing priority, and see if one of the rules sniffs
-		// out a match
-		for (std::list<sniffer_rule>::const_iterator i = fRuleList.begin();
-			   i != fRuleList.end();
-			     i++)
-		{
-			if (i->rule) {
-				// If an add-on identified the type with a priority at least
-				// as great as the remaining rules, we can stop further
-				// processing and return the type found by the add-on.
-				if (i->rule->Priority() <= addonPriority) {
-					*type = mimeType.Type();
-					return B_OK;
-				}
-
-				if (i->rule->Sniff(&data)) {
-					type->SetTo(i->type.c_str());
-					return B_OK;
-				}
-			} else {
-				DBG(OUT("WARNING: Mime::SnifferRules::GuessMimeType(BPositionIO*,BString*): "
-					"NULL sniffer_rule::rule member found in rule list for type == '%s', "
-					"rule_string == '%s'\n",
-					i->type.c_str(), i->rule_string.c_str()));
-			}
+		// Find the first rule in our rule set, which is sorted in order of
+		// descreasing priority, that sniffs out a match. If an add-on
+		// identified the type with a priority at least as great as the
+		// remaining rules, we can stop further processing and return the
+		// type found by the add-on.
+		int32 index = fRuleSet.Match(buffer, max_c(length, 0),
+			addonPriority);
+		if (index >= 0) {
+			type->SetTo(fRuleSetRules[index]->type.c_str());
+			return B_OK;
 		}
 
 		// The sniffer add-on manager might have returned a low priority
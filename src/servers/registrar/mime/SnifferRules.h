@@ -8,8 +8,11 @@
 
 #include <SupportDefs.h>
 
+#include <sniffer/RuleSet.h>
+
 #include <list>
 #include <string>
+#include <vector>
 
 class BFile;
 class BString;
@@ -19,10 +22,6 @@ struct entry_ref;
 namespace BPrivate {
 namespace Storage {
 
-namespace Sniffer {
-	class Rule;
-}
-
 namespace Mime {
 
 class SnifferRules {
@@ -32,6 +31,8 @@ public:
 	
 	status_t GuessMimeType(const entry_ref *ref, BString *type);
 	status_t GuessMimeType(const void *buffer, int32 length, BString *type);
+	status_t GuessMimeTypes(const entry_ref *refs, int32 count,
+		BString *types, status_t *results);
 	
 	status_t SetSnifferRule(const char *type, const char *rule);
 	status_t DeleteSnifferRule(const char *type);
@@ -48,14 +49,18 @@ public:
 	};		
 private:
 	status_t BuildRuleList();
+	status_t CompileRuleList();
 	status_t GuessMimeType(BFile* file, const void *buffer, int32 length,
 		BString *type);
 	ssize_t MaxBytesNeeded();
 	status_t ProcessType(const char *type, ssize_t *bytesNeeded);
 
 	std::list<sniffer_rule> fRuleList;
+	Sniffer::RuleSet fRuleSet;
+	std::vector<const sniffer_rule*> fRuleSetRules;
 	ssize_t fMaxBytesNeeded;
 	bool fHaveDoneFullBuild;
+	bool fRuleSetValid;
 };
 
 } // namespace Mime
@@ -118,6 +118,29 @@ SupportingApps::GetSupportingApps(const char *type, BMessage *apps)
 	return err;
 }
 
+// GetAllSupportingApps
+/*! \brief Returns the supporting apps table, a mapping from mime types to
+	the set of signatures of the applications supporting them.
+
+	The table is built first, if that hasn't been done yet. The returned
+	object is only valid until the next change to the table.
+*/
+status_t
+SupportingApps::GetAllSupportingApps(const AppSetMap **_apps)
+{
+	if (_apps == NULL)
+		return B_BAD_VALUE;
+
+	if (!fHaveDoneFullBuild) {
+		status_t error = BuildSupportingAppsTable();
+		if (error != B_OK)
+			return error;
+	}
+
+	*_apps = &fSupportingApps;
+	return B_OK;
+}
+
 // SetSupportedTypes
 /*! \brief Sets the list of supported types for the given application and
 	updates the supporting apps mappings.
@@ -24,10 +24,13 @@ namespace Mime {
 
 class SupportingApps {
 public:
+	typedef std::map<std::string, std::set<std::string> > AppSetMap;
+
 	SupportingApps();
 	~SupportingApps();
 		
 	status_t GetSupportingApps(const char *type, BMessage *apps);	
+	status_t GetAllSupportingApps(const AppSetMap **_apps);
 
 	status_t SetSupportedTypes(const char *app, const BMessage *types, bool fullSync);
 	status_t DeleteSupportedTypes(const char *app, bool fullSync);
@@ -25,6 +25,7 @@ namespace Storage {
 namespace Mime {
 
 static const char *kAppFlagsAttribute			= "BEOS:APP_FLAGS";
+static const int32 kWorkerCount					= 4;
 
 // update_icon
 static status_t
@@ -253,6 +254,18 @@ UpdateMimeInfoThread::DoMimeUpdate(const entry_ref *entry, bool *entryIsDir)
 	return err;
 }
 
+// MaxWorkerCount
+/*!	\brief Returns the number of threads updating a directory tree.
+
+	DoMimeUpdate() only touches the given entry, and leaves sniffing to the
+	MIME manager, so several entries can safely be updated at the same time.
+*/
+int32
+UpdateMimeInfoThread::MaxWorkerCount() const
+{
+	return kWorkerCount;
+}
+
 }	// namespace Mime
 }	// namespace Storage
 }	// namespace BPrivate
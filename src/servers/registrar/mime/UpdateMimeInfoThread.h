@@ -22,6 +22,9 @@ public:
 		BMessenger managerMessenger, const entry_ref *root, bool recursive,
 		int32 force, BMessage *replyee);
 	status_t DoMimeUpdate(const entry_ref *entry, bool *entryIsDir);
+
+protected:
+	virtual int32 MaxWorkerCount() const;
 };
 	
 }	// namespace Mime
@@ -14,6 +14,7 @@
 #include "LooperSizeTest.h"
 #include "SetCommonFilterListTest.h"
 #include "QuitTest.h"
+#include "PostMessageTest.h"
 
 Test* LooperTestSuite()
 {
@@ -33,6 +34,7 @@ Test* LooperTestSuite()
 	tests->addTest(TLooperSizeTest::Suite());
 	tests->addTest(TSetCommonFilterListTest::Suite());
 	tests->addTest(TQuitTest::Suite());
+	tests->addTest(TPostMessageTest::Suite());
 
 	return tests;
 }
@@ -0,0 +1,138 @@
+//------------------------------------------------------------------------------
+//	PostMessageTest.cpp
+//
+//------------------------------------------------------------------------------
+
+// Standard Includes -----------------------------------------------------------
+
+// System Includes -------------------------------------------------------------
+#include <Looper.h>
+#include <Message.h>
+#include <OS.h>
+
+// Project Includes ------------------------------------------------------------
+
+// Local Includes --------------------------------------------------------------
+#include "PostMessageTest.h"
+
+// Local Defines ---------------------------------------------------------------
+const uint32 kTestMessage = 'tmsg';
+const int32 kPosterCount = 4;
+const int32 kRounds = 1000;
+const bigtime_t kTimeout = 5000000;
+
+// Globals ---------------------------------------------------------------------
+
+class TCountingLooper : public BLooper
+{
+	public:
+		TCountingLooper(sem_id doneSem, int32 expected)
+			: BLooper("counting looper"),
+			  fDoneSem(doneSem),
+			  fExpected(expected),
+			  fReceived(0)
+		{
+		}
+
+		virtual void MessageReceived(BMessage* message)
+		{
+			if (message->what != kTestMessage) {
+				BLooper::MessageReceived(message);
+				return;
+			}
+
+			if (++fReceived == fExpected) {
+				fReceived = 0;
+				release_sem(fDoneSem);
+			}
+		}
+
+	private:
+		sem_id	fDoneSem;
+		int32	fExpected;
+		int32	fReceived;
+};
+
+struct poster_args {
+	BLooper*	looper;
+	sem_id		startSem;
+};
+
+static status_t
+poster_thread(void* data)
+{
+	poster_args* args = (poster_args*)data;
+	for (int32 i = 0; i < kRounds; i++) {
+		if (acquire_sem(args->startSem) != B_OK)
+			break;
+		args->looper->PostMessage(kTestMessage);
+	}
+	return B_OK;
+}
+
+//------------------------------------------------------------------------------
+/**
+	PostMessage()
+	@case		Several threads post a message each to a looper that is
+				waiting for messages
+	@results	The looper is woken up, and handles all messages
+ */
+void TPostMessageTest::PostMessageTest1()
+{
+	sem_id startSem = create_sem(0, "start posting");
+	sem_id doneSem = create_sem(0, "all received");
+	CPPUNIT_ASSERT(startSem >= 0 && doneSem >= 0);
+
+	TCountingLooper* looper = new TCountingLooper(doneSem, kPosterCount);
+	looper->Run();
+
+	poster_args args;
+	args.looper = looper;
+	args.startSem = startSem;
+
+	thread_id threads[kPosterCount];
+	for (int32 i = 0; i < kPosterCount; i++) {
+		threads[i] = spawn_thread(&poster_thread, "poster", B_NORMAL_PRIORITY,
+			&args);
+		CPPUNIT_ASSERT(threads[i] >= 0);
+		resume_thread(threads[i]);
+	}
+
+	status_t status = B_OK;
+	for (int32 round = 0; round < kRounds && status == B_OK; round++) {
+		// The looper has handled all previous messages, and is waiting on
+		// its port again; let all posters hit the empty queue at once.
+		snooze(100);
+		release_sem_etc(startSem, kPosterCount, 0);
+
+		status = acquire_sem_etc(doneSem, 1, B_RELATIVE_TIMEOUT, kTimeout);
+	}
+
+	// let the posters go, should we have given up early
+	delete_sem(startSem);
+	for (int32 i = 0; i < kPosterCount; i++) {
+		status_t returnValue;
+		wait_for_thread(threads[i], &returnValue);
+	}
+
+	looper->Lock();
+	looper->Quit();
+	delete_sem(doneSem);
+
+	CPPUNIT_ASSERT(status == B_OK);
+}
+//------------------------------------------------------------------------------
+TestSuite* TPostMessageTest::Suite()
+{
+	TestSuite* suite = new TestSuite("BLooper::PostMessage()");
+	ADD_TEST4(BLooper, suite, TPostMessageTest, PostMessageTest1);
+	return suite;
+}
+//------------------------------------------------------------------------------
+
+/*
+ * $Log $
+ *
+ * $Id  $
+ *
+ */
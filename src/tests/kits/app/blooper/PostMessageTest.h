@@ -0,0 +1,40 @@
+//------------------------------------------------------------------------------
+//	PostMessageTest.h
+//
+//------------------------------------------------------------------------------
+
+#ifndef POSTMESSAGETEST_H
+#define POSTMESSAGETEST_H
+
+// Standard Includes -----------------------------------------------------------
+
+// System Includes -------------------------------------------------------------
+
+// Project Includes ------------------------------------------------------------
+
+// Local Includes --------------------------------------------------------------
+#include "../common.h"
+
+// Local Defines ---------------------------------------------------------------
+
+// Globals ---------------------------------------------------------------------
+
+class TPostMessageTest : public TestCase
+{
+	public:
+		TPostMessageTest() {;}
+		TPostMessageTest(std::string name) : TestCase(name) {;}
+
+		void PostMessageTest1();
+
+		static TestSuite* Suite();
+};
+
+#endif	//POSTMESSAGETEST_H
+
+/*
+ * $Log $
+ *
+ * $Id  $
+ *
+ */
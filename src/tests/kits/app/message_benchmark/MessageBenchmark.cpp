@@ -0,0 +1,433 @@
+/*
+ * Copyright 2011, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Measures the throughput of the BMessage operations that are used for
+	every message sent between applications and the app_server: building a
+	message, looking up its fields, flattening and unflattening it, passing
+	it through a port, and between two loopers of the same team. The
+	BMessageQueue is also tested with several threads adding messages at
+	once. The checksums reflect the field values the tests read back.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <Looper.h>
+#include <Message.h>
+#include <MessageQueue.h>
+#include <Messenger.h>
+#include <OS.h>
+#include <Rect.h>
+#include <View.h>
+
+#include <MessagePrivate.h>
+#include <TokenSpace.h>
+
+#include <Benchmark.h>
+
+
+static const uint32 kTestWhat = 'tEST';
+static const uint32 kPingWhat = 'ping';
+static const uint32 kEchoWhat = 'echo';
+static const int32 kPortCapacity = 16;
+static const int32 kRoundTrips = 100;
+static const int32 kProducerCount = 4;
+static const int32 kMessagesPerProducer = 500;
+
+
+class PingPongLooper : public BLooper {
+public:
+	PingPongLooper(const char* name)
+		:
+		BLooper(name)
+	{
+	}
+
+	void SetPeer(BLooper* peer)
+	{
+		fPeer = BMessenger(peer);
+	}
+
+	virtual void MessageReceived(BMessage* message)
+	{
+		switch (message->what) {
+			case kPingWhat:
+			{
+				// pass the message back and forth until the count is used up
+				int32 count;
+				if (message->FindInt32("count", &count) != B_OK || count <= 0) {
+					release_sem(sDoneSemaphore);
+					break;
+				}
+
+				message->ReplaceInt32("count", count - 1);
+				fPeer.SendMessage(message);
+				break;
+			}
+
+			case kEchoWhat:
+			{
+				BMessage reply(*message);
+				reply.what = B_REPLY;
+				message->SendReply(&reply);
+				break;
+			}
+
+			default:
+				BLooper::MessageReceived(message);
+				break;
+		}
+	}
+
+	static sem_id		sDoneSemaphore;
+
+private:
+	BMessenger			fPeer;
+};
+
+
+sem_id PingPongLooper::sDoneSemaphore = -1;
+
+
+static port_id sPort = -1;
+static PingPongLooper* sPingLooper;
+static PingPongLooper* sPongLooper;
+static BMessageQueue sQueue;
+static BMessage sQueueMessages[kProducerCount][kMessagesPerProducer];
+static char sBuffer[65536];
+
+
+static void
+build_small_message(BMessage& message, int32 iteration)
+{
+	// like a B_MOUSE_MOVED message
+	message.what = B_MOUSE_MOVED;
+	message.AddInt64("when", iteration);
+	message.AddPoint("where", BPoint(iteration % 1000, iteration % 800));
+	message.AddInt32("buttons", 0);
+	message.AddInt32("modifiers", 0);
+	message.AddInt32("be:transit", B_INSIDE_VIEW);
+}
+
+
+static void
+build_large_message(BMessage& message, int32 iteration)
+{
+	// like a typical scripting or settings message
+	message.what = kTestWhat;
+	message.AddString("name", "Some name that is not too short");
+	message.AddRect("frame", BRect(0, 0, iteration % 640, 480));
+	for (int32 i = 0; i < 20; i++)
+		message.AddInt32("index", i + iteration);
+	for (int32 i = 0; i < 8; i++) {
+		char name[16];
+		snprintf(name, sizeof(name), "field %ld", (long)i);
+		message.AddString(name, name);
+	}
+	message.AddData("data", B_RAW_TYPE, sBuffer, 2048);
+}
+
+
+static uint32
+checksum(const BMessage& message)
+{
+	uint32 sum = message.what + message.CountNames(B_ANY_TYPE);
+
+	int32 value;
+	for (int32 i = 0; message.FindInt32("index", i, &value) == B_OK; i++)
+		sum = sum * 31 + value;
+	if (message.FindInt32("buttons", &value) == B_OK)
+		sum = sum * 31 + value;
+
+	return sum;
+}
+
+
+// #pragma mark - tests
+
+
+static uint32
+test_add_small(int32 iteration)
+{
+	BMessage message;
+	build_small_message(message, iteration);
+	return message.what;
+}
+
+
+static uint32
+test_add_large(int32 iteration)
+{
+	BMessage message;
+	build_large_message(message, iteration);
+	return message.what;
+}
+
+
+static uint32
+test_find(int32 iteration)
+{
+	BMessage message;
+	build_large_message(message, iteration);
+
+	uint32 sum = 0;
+	for (int32 i = 0; i < 20; i++) {
+		const char* string;
+		if (message.FindString("name", &string) == B_OK)
+			sum += string[i % 8];
+
+		BRect frame;
+		if (message.FindRect("frame", &frame) == B_OK)
+			sum += (uint32)frame.right;
+
+		sum += checksum(message);
+	}
+
+	return sum;
+}
+
+
+static uint32
+test_flatten(int32 iteration)
+{
+	BMessage message;
+	build_large_message(message, iteration);
+
+	uint32 sum = 0;
+	for (int32 i = 0; i < 10; i++) {
+		ssize_t size = message.FlattenedSize();
+		if (size > (ssize_t)sizeof(sBuffer)
+			|| message.Flatten(sBuffer, size) != B_OK)
+			return 0;
+		sum += size;
+	}
+
+	return sum;
+}
+
+
+static uint32
+test_unflatten(int32 iteration)
+{
+	BMessage message;
+	build_small_message(message, iteration);
+
+	char buffer[1024];
+	ssize_t size = message.FlattenedSize();
+	if (size > (ssize_t)sizeof(buffer) || message.Flatten(buffer, size) != B_OK)
+		return 0;
+
+	uint32 sum = 0;
+	for (int32 i = 0; i < 10; i++) {
+		BMessage copy;
+		if (copy.Unflatten(buffer) != B_OK)
+			return 0;
+		sum += checksum(copy);
+	}
+
+	return sum;
+}
+
+
+static uint32
+test_copy(int32 iteration)
+{
+	BMessage message;
+	build_large_message(message, iteration);
+
+	uint32 sum = 0;
+	for (int32 i = 0; i < 10; i++) {
+		BMessage copy(message);
+		sum += checksum(copy);
+	}
+
+	return sum;
+}
+
+
+static uint32
+test_port(int32 iteration)
+{
+	// send the message like BMessenger does, and receive it like BLooper
+	BMessage message;
+	build_small_message(message, iteration);
+
+	BMessenger replyTo;
+	BMessage::Private messagePrivate(message);
+
+	uint32 sum = 0;
+	for (int32 i = 0; i < kPortCapacity; i++) {
+		if (messagePrivate.SendMessage(sPort, -1, B_NULL_TOKEN, 0, false,
+				replyTo) != B_OK)
+			return 0;
+	}
+
+	for (int32 i = 0; i < kPortCapacity; i++) {
+		int32 code;
+		ssize_t size = read_port(sPort, &code, sBuffer, sizeof(sBuffer));
+		if (size < B_OK)
+			return 0;
+
+		BMessage received;
+		if (received.Unflatten(sBuffer) != B_OK)
+			return 0;
+		sum += checksum(received);
+	}
+
+	return sum;
+}
+
+
+static uint32
+test_ping_pong(int32 iteration)
+{
+	// asynchronous messages between two loopers of the same team
+	BMessage message(kPingWhat);
+	message.AddInt32("count", kRoundTrips * 2);
+	message.AddInt32("iteration", iteration);
+
+	if (sPingLooper->PostMessage(&message) != B_OK
+		|| acquire_sem(PingPongLooper::sDoneSemaphore) != B_OK)
+		return 0;
+
+	return kRoundTrips;
+}
+
+
+static uint32
+test_send_reply(int32 iteration)
+{
+	// synchronous messages to a looper of the same team
+	BMessenger messenger(sPongLooper);
+	BMessage message(kEchoWhat);
+	message.AddInt32("iteration", iteration);
+
+	uint32 sum = 0;
+	for (int32 i = 0; i < kRoundTrips; i++) {
+		BMessage reply;
+		if (messenger.SendMessage(&message, &reply) != B_OK)
+			return 0;
+
+		int32 value;
+		if (reply.FindInt32("iteration", &value) == B_OK)
+			sum += value;
+	}
+
+	return sum;
+}
+
+
+static status_t
+queue_producer(void* data)
+{
+	BMessage* messages = (BMessage*)data;
+	for (int32 i = 0; i < kMessagesPerProducer; i++)
+		sQueue.AddMessage(&messages[i]);
+
+	return B_OK;
+}
+
+
+static uint32
+test_queue_contention(int32 /*iteration*/)
+{
+	// several threads post to a queue while it is being emptied, like the
+	// windows of an application sending to the same looper
+	thread_id threads[kProducerCount];
+	for (int32 i = 0; i < kProducerCount; i++) {
+		threads[i] = spawn_thread(&queue_producer, "queue producer",
+			B_NORMAL_PRIORITY, sQueueMessages[i]);
+		resume_thread(threads[i]);
+	}
+
+	uint32 sum = 0;
+	int32 received = 0;
+	bool ordered = true;
+	int32 lastIndex[kProducerCount];
+	for (int32 i = 0; i < kProducerCount; i++)
+		lastIndex[i] = -1;
+
+	while (received < kProducerCount * kMessagesPerProducer) {
+		BMessage* message = sQueue.NextMessage();
+		if (message == NULL) {
+			snooze(0);
+			continue;
+		}
+
+		// messages from one thread must keep their order
+		int32 producer = (message - &sQueueMessages[0][0])
+			/ kMessagesPerProducer;
+		int32 index = (message - &sQueueMessages[0][0])
+			% kMessagesPerProducer;
+		if (index != lastIndex[producer] + 1)
+			ordered = false;
+
+		lastIndex[producer] = index;
+		sum += index;
+		received++;
+	}
+
+	for (int32 i = 0; i < kProducerCount; i++) {
+		status_t result;
+		wait_for_thread(threads[i], &result);
+	}
+
+	return ordered ? sum : 0;
+}
+
+
+// #pragma mark -
+
+
+static const benchmark_test kTests[] = {
+	{"add small", &test_add_small, 100000},
+	{"add large", &test_add_large, 10000},
+	{"find", &test_find, 5000},
+	{"flatten", &test_flatten, 5000},
+	{"unflatten", &test_unflatten, 20000},
+	{"copy", &test_copy, 5000},
+	{"port", &test_port, 5000},
+	{"ping pong", &test_ping_pong, 1000},
+	{"send reply", &test_send_reply, 1000},
+	{"queue contention", &test_queue_contention, 200},
+	{NULL, NULL, 0}
+};
+
+
+int
+main(int argc, char** argv)
+{
+	Benchmark benchmark("message_benchmark", kTests, argc, argv);
+
+	sPort = create_port(kPortCapacity, "message benchmark");
+	if (sPort < B_OK) {
+		fprintf(stderr, "Could not create port: %s\n", strerror(sPort));
+		return 1;
+	}
+
+	memset(sBuffer, 0x55, sizeof(sBuffer));
+
+	PingPongLooper::sDoneSemaphore = create_sem(0, "ping pong done");
+	sPingLooper = new PingPongLooper("ping");
+	sPongLooper = new PingPongLooper("pong");
+	sPingLooper->SetPeer(sPongLooper);
+	sPongLooper->SetPeer(sPingLooper);
+	sPingLooper->Run();
+	sPongLooper->Run();
+
+	benchmark.Run();
+
+	sPingLooper->Lock();
+	sPingLooper->Quit();
+	sPongLooper->Lock();
+	sPongLooper->Quit();
+
+	delete_sem(PingPongLooper::sDoneSemaphore);
+	delete_port(sPort);
+	return 0;
+}
@@ -0,0 +1,367 @@
+/*
+ * Copyright 2011, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include <LinkReceiver.h>
+#include <LinkSender.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "link_message.h"
+#include "LinkRing.h"
+
+
+using BPrivate::LinkReceiver;
+using BPrivate::LinkRing;
+using BPrivate::LinkSender;
+
+
+// the layout of the ring's shared header
+struct ring_header {
+	vint32	read;
+	vint32	write;
+	vint32	reader_waiting;
+	uint32	size;
+};
+
+
+#define CHECK(condition)												\
+	do {																\
+		if (!(condition)) {												\
+			fprintf(stderr, "%s:%d: check \"%s\" failed!\n", __FILE__,	\
+				__LINE__, #condition);									\
+			exit(1);													\
+		}																\
+	} while (false)
+
+
+static ring_header*
+map_header(area_id area, area_id& _clone)
+{
+	void* address;
+	_clone = clone_area("ring header", &address, B_ANY_ADDRESS,
+		B_READ_AREA | B_WRITE_AREA, area);
+	CHECK(_clone >= B_OK);
+	return (ring_header*)address;
+}
+
+
+static void
+fill(uint8* buffer, size_t size, uint32 seed)
+{
+	for (size_t i = 0; i < size; i++)
+		buffer[i] = (uint8)(seed + i * 7);
+}
+
+
+static void
+get_next_message(LinkReceiver& receiver, int32 expectedCode,
+	bigtime_t timeout = B_INFINITE_TIMEOUT)
+{
+	int32 code;
+	status_t status = receiver.GetNextMessage(code, timeout);
+	if (status != B_OK) {
+		fprintf(stderr, "getting message '%.4s' failed: %s\n",
+			(char*)&expectedCode, strerror(status));
+		exit(1);
+	}
+	if (code != expectedCode) {
+		fprintf(stderr, "got message %lx instead of '%.4s'\n", code,
+			(char*)&expectedCode);
+		exit(1);
+	}
+}
+
+
+static void
+send_message(LinkSender& sender, int32 code, size_t size, uint32 seed)
+{
+	uint8* data = (uint8*)malloc(size);
+	CHECK(data != NULL);
+	fill(data, size, seed);
+
+	CHECK(sender.StartMessage(code, size) == B_OK);
+	CHECK(sender.Attach<int32>(size) == B_OK);
+	CHECK(sender.Attach(data, size) == B_OK);
+	CHECK(sender.Flush() == B_OK);
+
+	free(data);
+}
+
+
+static void
+check_message(LinkReceiver& receiver, int32 code, uint32 seed)
+{
+	get_next_message(receiver, code);
+
+	int32 size;
+	CHECK(receiver.Read<int32>(&size) == B_OK);
+
+	uint8* data = (uint8*)malloc(size);
+	uint8* expected = (uint8*)malloc(size);
+	CHECK(data != NULL && expected != NULL);
+	fill(expected, size, seed);
+
+	CHECK(receiver.Read(data, size) == B_OK);
+	CHECK(memcmp(data, expected, size) == 0);
+
+	free(data);
+	free(expected);
+}
+
+
+/*!	Writes and reads records of all sizes, so that they wrap around the end
+	of the buffer, and the positions wrap around the 32 bit range.
+*/
+static void
+test_wraparound()
+{
+	LinkRing ring;
+	CHECK(ring.Create("test ring", B_PAGE_SIZE) == B_OK);
+
+	area_id clone;
+	ring_header* header = map_header(ring.Area(), clone);
+	header->read = header->write = (int32)0xffffff00;
+
+	uint8 data[1024];
+	uint8 buffer[1024];
+	for (uint32 i = 0; i < 10000; i++) {
+		size_t size = 1 + (i * 37) % sizeof(data);
+		fill(data, size, i);
+
+		bool wakeUp;
+		CHECK(ring.Write(data, size, wakeUp) == B_OK);
+		CHECK(!wakeUp);
+
+		size_t recordSize;
+		CHECK(ring.PeekRecord(recordSize) == B_OK);
+		CHECK(recordSize == size);
+		ring.ReadRecord(buffer, size);
+		CHECK(memcmp(buffer, data, size) == 0);
+		CHECK(ring.IsEmpty());
+	}
+
+	delete_area(clone);
+}
+
+
+/*!	Fills the ring completely, and checks that neither records nor markers
+	are accepted anymore until the reader made room.
+*/
+static void
+test_full_ring()
+{
+	LinkRing ring;
+	CHECK(ring.Create("test ring", B_PAGE_SIZE) == B_OK);
+
+	// a single record with its size field fills the whole ring
+	uint8 data[B_PAGE_SIZE - sizeof(int32)];
+	fill(data, sizeof(data), 0);
+
+	bool wakeUp;
+	CHECK(ring.HasSpaceFor(sizeof(data)));
+	CHECK(ring.Write(data, sizeof(data), wakeUp) == B_OK);
+	CHECK(!ring.HasSpaceFor(0));
+	CHECK(ring.Write(data, 1, wakeUp) == B_WOULD_BLOCK);
+	CHECK(ring.WriteMarker(wakeUp) == B_WOULD_BLOCK);
+
+	size_t size;
+	CHECK(ring.PeekRecord(size) == B_OK);
+	CHECK(size == sizeof(data));
+	ring.ReadRecord(data, size);
+
+	// the reader waits, and wants to be woken up by the next write only
+	CHECK(ring.PrepareToWait());
+	CHECK(ring.WriteMarker(wakeUp) == B_OK);
+	CHECK(wakeUp);
+	CHECK(ring.Write(data, 1, wakeUp) == B_OK);
+	CHECK(!wakeUp);
+
+	// a wake up that could not be sent is asked for again
+	ring.SetReaderWaiting();
+	CHECK(ring.Write(data, 1, wakeUp) == B_OK);
+	CHECK(wakeUp);
+
+	CHECK(ring.PeekRecord(size) == B_OK);
+	CHECK(size == 0);
+}
+
+
+/*!	Sends a flush that doesn't fit into the ring between two that do, and
+	checks that the receiver gets them in order.
+*/
+static void
+test_overflow()
+{
+	port_id port = create_port(100, "link ring test");
+	CHECK(port >= B_OK);
+
+	LinkReceiver receiver(port);
+	area_id area = receiver.CreateRing("test ring");
+	CHECK(area >= B_OK);
+
+	LinkSender sender(port);
+	CHECK(sender.SetRing(area) == B_OK);
+
+	send_message(sender, 'tst1', 40000, 1);
+	CHECK(port_count(port) == 0);
+
+	send_message(sender, 'tst2', 40000, 2);
+	CHECK(port_count(port) == 1);
+
+	send_message(sender, 'tst3', 100, 3);
+
+	check_message(receiver, 'tst1', 1);
+	check_message(receiver, 'tst2', 2);
+	check_message(receiver, 'tst3', 3);
+
+	int32 code;
+	CHECK(receiver.GetNextMessage(code, 0) == B_WOULD_BLOCK);
+
+	delete_port(port);
+}
+
+
+/*!	A flush into a completely full ring must time out without sending
+	anything, and succeed once there is room again.
+*/
+static void
+test_full_ring_timeout()
+{
+	port_id port = create_port(100, "link ring test");
+	CHECK(port >= B_OK);
+
+	LinkReceiver receiver(port);
+	area_id area = receiver.CreateRing("test ring");
+	CHECK(area >= B_OK);
+
+	LinkSender sender(port);
+	CHECK(sender.SetRing(area) == B_OK);
+
+	// fill the ring through another mapping
+	LinkRing filler;
+	CHECK(filler.Clone(area) == B_OK);
+
+	static uint8 data[kLinkRingSize - sizeof(int32)];
+	bool wakeUp;
+	CHECK(filler.Write(data, sizeof(data), wakeUp) == B_OK);
+	CHECK(!filler.HasSpaceFor(0));
+
+	CHECK(sender.StartMessage('tst1') == B_OK);
+	CHECK(sender.Attach<int32>(42) == B_OK);
+	CHECK(sender.Flush(10000) == B_TIMED_OUT);
+	CHECK(port_count(port) == 0);
+
+	size_t size;
+	CHECK(filler.PeekRecord(size) == B_OK);
+	filler.ReadRecord(data, size);
+
+	CHECK(sender.Flush(10000) == B_OK);
+
+	get_next_message(receiver, 'tst1', 0);
+	int32 value;
+	CHECK(receiver.Read<int32>(&value) == B_OK);
+	CHECK(value == 42);
+
+	delete_port(port);
+}
+
+
+static status_t
+receive_thread(void* data)
+{
+	check_message(*(LinkReceiver*)data, 'tst1', 1);
+	return B_OK;
+}
+
+
+/*!	A receiver waiting on the port must be woken up by a write to the ring.
+*/
+static void
+test_wake_up()
+{
+	port_id port = create_port(100, "link ring test");
+	CHECK(port >= B_OK);
+
+	LinkReceiver receiver(port);
+	area_id area = receiver.CreateRing("test ring");
+	CHECK(area >= B_OK);
+
+	LinkSender sender(port);
+	CHECK(sender.SetRing(area) == B_OK);
+
+	thread_id thread = spawn_thread(&receive_thread, "receiver",
+		B_NORMAL_PRIORITY, &receiver);
+	CHECK(thread >= B_OK);
+	resume_thread(thread);
+
+	// give the receiver time to start waiting
+	snooze(100000);
+	send_message(sender, 'tst1', 100, 1);
+
+	status_t result;
+	CHECK(wait_for_thread(thread, &result) == B_OK);
+
+	delete_port(port);
+}
+
+
+/*!	When the sender corrupted the ring, the receiver must not trust it
+	anymore, and use the port only.
+*/
+static void
+test_corrupted_ring()
+{
+	port_id port = create_port(100, "link ring test");
+	CHECK(port >= B_OK);
+
+	LinkReceiver receiver(port);
+	area_id area = receiver.CreateRing("test ring");
+	CHECK(area >= B_OK);
+
+	area_id clone;
+	ring_header* header = map_header(area, clone);
+
+	// an unaligned record
+	header->write = header->read + 3;
+
+	LinkSender sender(port);
+	send_message(sender, 'tst1', 100, 1);
+	check_message(receiver, 'tst1', 1);
+
+	// a record larger than the ring
+	area = receiver.CreateRing("test ring");
+	CHECK(area >= B_OK);
+	delete_area(clone);
+	header = map_header(area, clone);
+
+	LinkSender ringSender(port);
+	CHECK(ringSender.SetRing(area) == B_OK);
+	send_message(ringSender, 'tst2', 100, 2);
+	*(int32*)(header + 1) = kLinkRingSize * 2;
+
+	send_message(sender, 'tst3', 100, 3);
+	check_message(receiver, 'tst3', 3);
+
+	delete_area(clone);
+	delete_port(port);
+}
+
+
+int
+main()
+{
+	test_wraparound();
+	test_full_ring();
+	test_overflow();
+	test_full_ring_timeout();
+	test_wake_up();
+	test_corrupted_ring();
+
+	puts("All OK!");
+	return 0;
+}
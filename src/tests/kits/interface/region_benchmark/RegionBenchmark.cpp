@@ -0,0 +1,225 @@
+/*
+ * Copyright 2011, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Measures the BRegion operations as they are used by the app_server when
+	computing the clipping of windows and views, and when collecting dirty
+	regions. All regions are built from a fixed pseudo random sequence, so
+	the checksums stay the same as long as BRegion computes the same
+	results.
+*/
+
+
+#include <OS.h>
+#include <Region.h>
+
+#include <Benchmark.h>
+
+
+static const int32 kScreenWidth = 1920;
+static const int32 kScreenHeight = 1200;
+
+
+static uint32 sRandomSeed;
+
+
+static void
+reset_random()
+{
+	sRandomSeed = 0x2011;
+}
+
+
+static int32
+random_value(int32 max)
+{
+	sRandomSeed = sRandomSeed * 1103515245 + 12345;
+	return (sRandomSeed >> 8) % max;
+}
+
+
+static BRect
+random_rect(int32 maxWidth, int32 maxHeight)
+{
+	int32 left = random_value(kScreenWidth) - 50;
+	int32 top = random_value(kScreenHeight) - 50;
+	return BRect(left, top, left + 1 + random_value(maxWidth),
+		top + 1 + random_value(maxHeight));
+}
+
+
+static uint32
+checksum(const BRegion& region)
+{
+	uint32 sum = region.CountRects();
+	for (int32 i = 0; i < region.CountRects(); i++) {
+		clipping_rect rect = region.RectAtInt(i);
+		sum = sum * 31 + rect.left;
+		sum = sum * 31 + rect.top;
+		sum = sum * 31 + rect.right;
+		sum = sum * 31 + rect.bottom;
+	}
+	return sum;
+}
+
+
+static void
+build_window_clipping(BRegion& region, int32 windowCount)
+{
+	// like Desktop::_RebuildClippingForAllWindows(), from front to back
+	BRegion stillAvailable(BRect(0, 0, kScreenWidth - 1, kScreenHeight - 1));
+	region.MakeEmpty();
+
+	for (int32 i = 0; i < windowCount; i++) {
+		BRect frame = random_rect(800, 600);
+
+		BRegion visible(frame);
+		visible.IntersectWith(&stillAvailable);
+		stillAvailable.Exclude(frame);
+
+		region.Include(&visible);
+	}
+}
+
+
+// #pragma mark - tests
+
+
+static uint32
+test_window_clipping(int32 /*iteration*/)
+{
+	BRegion region;
+	build_window_clipping(region, 40);
+	return checksum(region);
+}
+
+
+static uint32
+test_view_clipping(int32 /*iteration*/)
+{
+	// like View::_ClippingRegion(): a view excludes all of its children
+	BRegion region(BRect(0, 0, 999, 799));
+	for (int32 i = 0; i < 100; i++) {
+		int32 left = (i % 10) * 100 + 4;
+		int32 top = (i / 10) * 80 + 4;
+		region.Exclude(BRect(left, top, left + 91, top + 71));
+	}
+
+	// children outside of the parent's bounds
+	for (int32 i = 0; i < 50; i++)
+		region.Exclude(BRect(1100 + i * 10, 0, 1105 + i * 10, 10));
+
+	return checksum(region);
+}
+
+
+static uint32
+test_dirty_region(int32 /*iteration*/)
+{
+	// like Window::ProcessDirtyRegion() collecting invalidated views
+	BRegion region;
+	for (int32 i = 0; i < 200; i++)
+		region.Include(random_rect(120, 40));
+
+	return checksum(region);
+}
+
+
+static uint32
+test_intersect(int32 /*iteration*/)
+{
+	BRegion a;
+	BRegion b;
+	build_window_clipping(a, 30);
+	build_window_clipping(b, 30);
+
+	uint32 sum = 0;
+	for (int32 i = 0; i < 20; i++) {
+		BRegion region(a);
+		region.IntersectWith(&b);
+		sum += checksum(region);
+
+		region = b;
+		region.IntersectWith(&a);
+		sum += checksum(region);
+	}
+
+	return sum;
+}
+
+
+static uint32
+test_exclusive_include(int32 /*iteration*/)
+{
+	BRegion a;
+	BRegion b;
+	build_window_clipping(a, 20);
+	build_window_clipping(b, 20);
+
+	a.ExclusiveInclude(&b);
+	return checksum(a);
+}
+
+
+static uint32
+test_queries(int32 /*iteration*/)
+{
+	BRegion region;
+	build_window_clipping(region, 40);
+
+	uint32 hits = 0;
+	for (int32 i = 0; i < 2000; i++) {
+		if (region.Contains(random_value(kScreenWidth),
+				random_value(kScreenHeight))) {
+			hits++;
+		}
+		if (region.Intersects(random_rect(50, 50)))
+			hits += 3;
+	}
+
+	return hits;
+}
+
+
+static uint32
+test_copy_offset(int32 /*iteration*/)
+{
+	BRegion region;
+	build_window_clipping(region, 40);
+
+	uint32 sum = 0;
+	for (int32 i = 0; i < 100; i++) {
+		BRegion copy(region);
+		copy.OffsetBy(i, -i);
+		sum += copy.FrameInt().left;
+	}
+
+	return sum;
+}
+
+
+// #pragma mark -
+
+
+static const benchmark_test kTests[] = {
+	{"window clipping", &test_window_clipping, 2000},
+	{"view clipping", &test_view_clipping, 2000},
+	{"dirty region", &test_dirty_region, 2000},
+	{"intersect", &test_intersect, 500},
+	{"exclusive include", &test_exclusive_include, 1000},
+	{"queries", &test_queries, 500},
+	{"copy and offset", &test_copy_offset, 1000},
+	{NULL, NULL, 0}
+};
+
+
+int
+main(int argc, char** argv)
+{
+	Benchmark benchmark("region_benchmark", kTests, argc, argv);
+	benchmark.SetPrepareHook(&reset_random);
+	benchmark.Run();
+	return 0;
+}
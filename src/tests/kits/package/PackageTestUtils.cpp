@@ -0,0 +1,167 @@
+/*
+ * Copyright 2011, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include "PackageTestUtils.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <Directory.h>
+
+#include <package/hpkg/HPKGDefs.h>
+
+
+using namespace BPackageKit::BHPKG;
+
+
+// #pragma mark - TestPackageWriterListener
+
+
+void
+TestPackageWriterListener::PrintErrorVarArgs(const char* format, va_list args)
+{
+	vfprintf(stderr, format, args);
+}
+
+
+void
+TestPackageWriterListener::OnEntryAdded(const char* path)
+{
+}
+
+
+void
+TestPackageWriterListener::OnTOCSizeInfo(uint64 uncompressedStringsSize,
+	uint64 uncompressedMainSize, uint64 uncompressedTOCSize)
+{
+}
+
+
+void
+TestPackageWriterListener::OnPackageAttributesSizeInfo(uint32 stringCount,
+	uint32 uncompressedSize)
+{
+}
+
+
+void
+TestPackageWriterListener::OnPackageSizeInfo(uint32 headerSize,
+	uint64 heapSize, uint64 tocSize, uint32 packageAttributesSize,
+	uint64 totalSize)
+{
+}
+
+
+// #pragma mark -
+
+
+void
+reset_test_directory(const char* path)
+{
+	remove_test_directory(path);
+	CHECK(create_directory(path, 0755) == B_OK);
+}
+
+
+void
+remove_test_directory(const char* path)
+{
+	char command[B_PATH_NAME_LENGTH + 16];
+	snprintf(command, sizeof(command), "rm -rf %s", path);
+	system(command);
+}
+
+
+/*!	Creates a file of \a size bytes, whose contents only depend on \a seed
+	and the offset, so that files created with the same seed share their
+	data.
+*/
+void
+create_test_file(const char* path, size_t size, uint32 seed)
+{
+	int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	CHECK(fd >= 0);
+
+	char buffer[4096];
+	for (size_t offset = 0; offset < size; offset += sizeof(buffer)) {
+		size_t toWrite = size - offset < sizeof(buffer)
+			? size - offset : sizeof(buffer);
+		for (size_t i = 0; i < toWrite; i++) {
+			uint32 value = (uint32)(offset + i) / 64 * 2654435761u + seed;
+			buffer[i] = 'a' + value % 26;
+		}
+		CHECK(write(fd, buffer, toWrite) == (ssize_t)toWrite);
+	}
+
+	close(fd);
+}
+
+
+/*!	Writes a package containing all entries of \a contentDirectory, with a
+	package info generated from \a name and \a version. The package provides
+	itself, and the resolvables in \a provides, if given, and requires the
+	ones in \a requirements.
+*/
+void
+create_test_package(const char* packagePath, const char* contentDirectory,
+	const char* name, const char* version, uint32 flags, const char* provides,
+	const char* requirements)
+{
+	// write the package info next to the content
+	char packageInfoPath[B_PATH_NAME_LENGTH];
+	snprintf(packageInfoPath, sizeof(packageInfoPath), "%s.PackageInfo",
+		packagePath);
+
+	FILE* packageInfo = fopen(packageInfoPath, "w");
+	CHECK(packageInfo != NULL);
+	fprintf(packageInfo,
+		"name %s\n"
+		"version %s\n"
+		"architecture any\n"
+		"summary \"A test package\"\n"
+		"description \"A package created by a test.\"\n"
+		"vendor \"Haiku Project\"\n"
+		"packager \"Haiku Project\"\n"
+		"copyrights { \"2011 Haiku, Inc.\" }\n"
+		"licenses { \"MIT\" }\n"
+		"provides { %s = %s; %s }\n"
+		"requires { %s }\n",
+		name, version, name, version, provides != NULL ? provides : "",
+		requirements != NULL ? requirements : "");
+	fclose(packageInfo);
+
+	int packageInfoFD = open(packageInfoPath, O_RDONLY);
+	CHECK(packageInfoFD >= 0);
+
+	// the writer adds the entries relative to the current directory
+	char currentDirectory[B_PATH_NAME_LENGTH];
+	CHECK(getcwd(currentDirectory, sizeof(currentDirectory)) != NULL);
+	CHECK(chdir(contentDirectory) == 0);
+
+	TestPackageWriterListener listener;
+	BPackageWriter writer(&listener);
+	CHECK(writer.Init(packagePath, flags) == B_OK);
+	writer.SetCheckLicenses(false);
+
+	DIR* dir = opendir(".");
+	CHECK(dir != NULL);
+	while (dirent* entry = readdir(dir)) {
+		if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+			continue;
+		CHECK(writer.AddEntry(entry->d_name) == B_OK);
+	}
+	closedir(dir);
+
+	CHECK(writer.AddEntry(B_HPKG_PACKAGE_INFO_FILE_NAME, packageInfoFD)
+		== B_OK);
+	CHECK(writer.Finish() == B_OK);
+
+	close(packageInfoFD);
+	unlink(packageInfoPath);
+	CHECK(chdir(currentDirectory) == 0);
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright 2011, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef PACKAGE_TEST_UTILS_H
+#define PACKAGE_TEST_UTILS_H
+
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <package/hpkg/PackageWriter.h>
+
+
+#define CHECK(condition)												\
+	do {																\
+		if (!(condition)) {												\
+			printf("%s:%d: check \"%s\" failed!\n", __FILE__, __LINE__,	\
+				#condition);											\
+			exit(1);													\
+		}																\
+	} while (false)
+
+
+// TestPackageWriterListener
+class TestPackageWriterListener
+	: public BPackageKit::BHPKG::BPackageWriterListener {
+public:
+	virtual	void				PrintErrorVarArgs(const char* format,
+									va_list args);
+
+	virtual	void				OnEntryAdded(const char* path);
+	virtual void				OnTOCSizeInfo(uint64 uncompressedStringsSize,
+									uint64 uncompressedMainSize,
+									uint64 uncompressedTOCSize);
+	virtual void				OnPackageAttributesSizeInfo(uint32 stringCount,
+									uint32 uncompressedSize);
+	virtual void				OnPackageSizeInfo(uint32 headerSize,
+									uint64 heapSize, uint64 tocSize,
+									uint32 packageAttributesSize,
+									uint64 totalSize);
+};
+
+
+void		reset_test_directory(const char* path);
+void		remove_test_directory(const char* path);
+void		create_test_file(const char* path, size_t size, uint32 seed);
+void		create_test_package(const char* packagePath,
+				const char* contentDirectory, const char* name,
+				const char* version, uint32 flags = 0,
+				const char* provides = NULL, const char* requirements = NULL);
+				// adds all entries of contentDirectory; provides and
+				// requirements are ';' separated resolvables
+
+
+#endif	// PACKAGE_TEST_UTILS_H
@@ -0,0 +1,486 @@
+/*
+ * Copyright 2011, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+// Runs jobs with dependencies through the job queue with several workers, and
+// checks that dependencies are respected, that no further jobs are started
+// after a failure, and that the state listeners are notified in order and in
+// the thread running the queue. Finally fetches and validates files from local
+// file:// "repositories" with the kit's own jobs.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include <Directory.h>
+#include <Entry.h>
+#include <File.h>
+#include <OS.h>
+#include <String.h>
+
+#include <package/ChecksumAccessors.h>
+#include <package/Context.h>
+#include <package/FetchFileJob.h>
+#include <package/Job.h>
+#include <package/JobQueue.h>
+#include <package/ValidateChecksumJob.h>
+
+#include "PackageTestUtils.h"
+
+
+using namespace BPackageKit;
+using namespace BPackageKit::BPrivate;
+
+
+static const char* kTestDirectory = "/tmp/job_queue_test";
+static const int32 kMaxJobs = 16;
+static const int32 kRepositoryCount = 6;
+
+
+struct JobRecord {
+	bool		executed;
+	bool		deleted;
+	int32		started;
+	int32		finished;
+};
+
+
+static vint32 sSequence;
+static vint32 sRunningJobs;
+static vint32 sMaxRunningJobs;
+static JobRecord sRecords[kMaxJobs];
+
+
+static int32
+next_sequence()
+{
+	return atomic_add(&sSequence, 1);
+}
+
+
+static void
+reset_records()
+{
+	sSequence = 0;
+	sRunningJobs = 0;
+	sMaxRunningJobs = 0;
+	memset(sRecords, 0, sizeof(sRecords));
+}
+
+
+// #pragma mark - TestJob
+
+
+class TestJob : public BJob {
+public:
+	TestJob(const BContext& context, int32 index, status_t result,
+		bigtime_t duration)
+		:
+		BJob(context, BString("job ") << index),
+		fIndex(index),
+		fResultToReturn(result),
+		fDuration(duration)
+	{
+	}
+
+	virtual ~TestJob()
+	{
+		sRecords[fIndex].deleted = true;
+	}
+
+protected:
+	virtual status_t Execute()
+	{
+		JobRecord& record = sRecords[fIndex];
+		CHECK(!record.executed);
+		record.executed = true;
+		record.started = next_sequence();
+
+		int32 running = atomic_add(&sRunningJobs, 1) + 1;
+		int32 maxRunning;
+		while ((maxRunning = atomic_get(&sMaxRunningJobs)) < running) {
+			if (atomic_test_and_set(&sMaxRunningJobs, running, maxRunning)
+					== maxRunning) {
+				break;
+			}
+		}
+
+		snooze(fDuration);
+
+		atomic_add(&sRunningJobs, -1);
+		record.finished = next_sequence();
+		return fResultToReturn;
+	}
+
+private:
+	int32		fIndex;
+	status_t	fResultToReturn;
+	bigtime_t	fDuration;
+};
+
+
+// #pragma mark - TestListener
+
+
+class TestListener : public BJobStateListener {
+public:
+	struct Event {
+		BString		title;
+		BJobState	state;
+		int32		sequence;
+	};
+
+public:
+	TestListener()
+		:
+		fThread(find_thread(NULL)),
+		fNotifying(0)
+	{
+	}
+
+	virtual void JobStarted(BJob* job)
+	{
+		_Add(job, JOB_STATE_RUNNING);
+	}
+
+	virtual void JobSucceeded(BJob* job)
+	{
+		_Add(job, JOB_STATE_SUCCEEDED);
+	}
+
+	virtual void JobFailed(BJob* job)
+	{
+		_Add(job, JOB_STATE_FAILED);
+	}
+
+	virtual void JobAborted(BJob* job)
+	{
+		_Add(job, JOB_STATE_ABORTED);
+	}
+
+	void Reset()
+	{
+		fEvents.clear();
+	}
+
+	const std::vector<Event>& Events() const
+	{
+		return fEvents;
+	}
+
+	//!	Returns the sequence number of the event, or -1 if there was none.
+	int32 EventSequence(int32 index, BJobState state) const
+	{
+		BString title = BString("job ") << index;
+		for (size_t i = 0; i < fEvents.size(); i++) {
+			if (fEvents[i].title == title && fEvents[i].state == state)
+				return fEvents[i].sequence;
+		}
+		return -1;
+	}
+
+	int32 CountEvents(int32 index) const
+	{
+		BString title = BString("job ") << index;
+		int32 count = 0;
+		for (size_t i = 0; i < fEvents.size(); i++) {
+			if (fEvents[i].title == title)
+				count++;
+		}
+		return count;
+	}
+
+private:
+	void _Add(BJob* job, BJobState state)
+	{
+		// all notifications come from the thread running the queue, one
+		// after the other
+		CHECK(find_thread(NULL) == fThread);
+		CHECK(atomic_add(&fNotifying, 1) == 0);
+
+		Event event;
+		event.title = job->Title();
+		event.state = state;
+		event.sequence = next_sequence();
+		fEvents.push_back(event);
+
+		atomic_add(&fNotifying, -1);
+	}
+
+private:
+	thread_id			fThread;
+	vint32				fNotifying;
+	std::vector<Event>	fEvents;
+};
+
+
+// #pragma mark - TestDecisionProvider
+
+
+struct TestDecisionProvider : BDecisionProvider {
+	virtual bool YesNoDecisionNeeded(const BString& description,
+		const BString& question, const BString& yes, const BString& no,
+		const BString& defaultChoice)
+	{
+		return true;
+	}
+};
+
+
+// #pragma mark -
+
+
+static TestJob*
+create_job(TestListener& listener, const BContext& context, int32 index,
+	status_t result = B_OK, bigtime_t duration = 20000)
+{
+	TestJob* job = new TestJob(context, index, result, duration);
+	CHECK(job->InitCheck() == B_OK);
+	CHECK(job->AddStateListener(&listener) == B_OK);
+	return job;
+}
+
+
+//!	The dependencies must be set up before, as the queue sorts by them.
+static void
+queue_jobs(JobQueue& queue, TestJob** jobs, int32 count)
+{
+	for (int32 i = 0; i < count; i++)
+		CHECK(queue.AddJob(jobs[i]) == B_OK);
+}
+
+
+static void
+check_after(TestListener& listener, int32 index, int32 dependency)
+{
+	CHECK(sRecords[index].started > sRecords[dependency].finished);
+	CHECK(listener.EventSequence(index, JOB_STATE_RUNNING)
+		> listener.EventSequence(dependency, JOB_STATE_SUCCEEDED));
+}
+
+
+static void
+test_dependencies(const BContext& context, TestListener& listener)
+{
+	reset_records();
+	listener.Reset();
+
+	JobQueue* queue = new JobQueue;
+	CHECK(queue->InitCheck() == B_OK);
+
+	// 0 -> 1, 2 -> 3 -> 7 and 4, 5, 6 -> 7
+	TestJob* jobs[8];
+	for (int32 i = 0; i < 8; i++)
+		jobs[i] = create_job(listener, context, i);
+
+	CHECK(jobs[1]->AddDependency(jobs[0]) == B_OK);
+	CHECK(jobs[2]->AddDependency(jobs[0]) == B_OK);
+	CHECK(jobs[3]->AddDependency(jobs[1]) == B_OK);
+	CHECK(jobs[3]->AddDependency(jobs[2]) == B_OK);
+	CHECK(jobs[7]->AddDependency(jobs[3]) == B_OK);
+	CHECK(jobs[7]->AddDependency(jobs[6]) == B_OK);
+	queue_jobs(*queue, jobs, 8);
+
+	CHECK(queue->RunJobs(4) == B_OK);
+
+	for (int32 i = 0; i < 8; i++) {
+		CHECK(sRecords[i].executed);
+		CHECK(sRecords[i].deleted);
+
+		// started before executing, succeeded after
+		int32 started = listener.EventSequence(i, JOB_STATE_RUNNING);
+		int32 succeeded = listener.EventSequence(i, JOB_STATE_SUCCEEDED);
+		CHECK(started >= 0 && started < sRecords[i].started);
+		CHECK(succeeded > sRecords[i].finished);
+		CHECK(listener.CountEvents(i) == 2);
+	}
+
+	check_after(listener, 1, 0);
+	check_after(listener, 2, 0);
+	check_after(listener, 3, 1);
+	check_after(listener, 3, 2);
+	check_after(listener, 7, 3);
+	check_after(listener, 7, 6);
+
+	// the independent jobs ran alongside each other
+	CHECK(sMaxRunningJobs > 1);
+	CHECK(sMaxRunningJobs <= 4);
+
+	delete queue;
+	printf("dependencies: ok (up to %ld jobs at once)\n",
+		(long)sMaxRunningJobs);
+}
+
+
+static void
+test_failure(const BContext& context, TestListener& listener,
+	int32 maxParallelJobs, status_t failure)
+{
+	reset_records();
+	listener.Reset();
+
+	JobQueue* queue = new JobQueue;
+	CHECK(queue->InitCheck() == B_OK);
+
+	// 0 runs longer than 1, which fails; 2 and 3 depend on 1; 4 and 5 are
+	// independent, but queued after the failing job
+	TestJob* jobs[6];
+	jobs[0] = create_job(listener, context, 0, B_OK, 100000);
+	jobs[1] = create_job(listener, context, 1, failure, 5000);
+	for (int32 i = 2; i < 6; i++)
+		jobs[i] = create_job(listener, context, i);
+	CHECK(jobs[2]->AddDependency(jobs[1]) == B_OK);
+	CHECK(jobs[3]->AddDependency(jobs[2]) == B_OK);
+	queue_jobs(*queue, jobs, 6);
+
+	CHECK(queue->RunJobs(maxParallelJobs) == failure);
+
+	// the job running alongside the failing one has been waited for
+	CHECK(sRecords[0].executed && sRecords[0].deleted);
+	CHECK(listener.EventSequence(0, JOB_STATE_SUCCEEDED)
+		> sRecords[0].finished);
+
+	CHECK(sRecords[1].executed && sRecords[1].deleted);
+	BJobState failedState = failure == B_CANCELED
+		? JOB_STATE_ABORTED : JOB_STATE_FAILED;
+	CHECK(listener.EventSequence(1, failedState) > sRecords[1].finished);
+	CHECK(listener.CountEvents(1) == 2);
+
+	// the dependants of the failed job have been dropped
+	for (int32 i = 2; i < 4; i++) {
+		CHECK(!sRecords[i].executed);
+		CHECK(sRecords[i].deleted);
+		CHECK(listener.CountEvents(i) == 0);
+	}
+
+	// and nothing was started after the failure
+	for (int32 i = 4; i < 6; i++) {
+		CHECK(!sRecords[i].executed);
+		CHECK(listener.CountEvents(i) == 0);
+	}
+
+	delete queue;
+	for (int32 i = 4; i < 6; i++)
+		CHECK(sRecords[i].deleted);
+
+	printf("failure with %ld workers (%s): ok\n", (long)maxParallelJobs,
+		strerror(failure));
+}
+
+
+/*!	Serves files from local directories via file:// URLs: each "repository"
+	has a file and a checksum file, which are fetched concurrently, and then
+	validated. The last repository's checksum doesn't match.
+*/
+static void
+test_file_repositories(const BContext& context, TestListener& listener)
+{
+	listener.Reset();
+	reset_test_directory(kTestDirectory);
+
+	JobQueue* queue = new JobQueue;
+	CHECK(queue->InitCheck() == B_OK);
+
+	for (int32 i = 0; i < kRepositoryCount; i++) {
+		BString directory = BString(kTestDirectory) << "/repo" << i;
+		CHECK(create_directory(directory.String(), 0755) == B_OK);
+		BString file = BString(directory) << "/repo";
+		create_test_file(file.String(), 100000 + i * 1000, i);
+
+		BString checksum;
+		GeneralFileChecksumAccessor accessor(BEntry(file.String()));
+		CHECK(accessor.GetChecksum(checksum) == B_OK);
+		if (i == kRepositoryCount - 1) {
+			checksum = BString(checksum[0] == '0' ? "1" : "0")
+				<< checksum.String() + 1;
+		}
+
+		BFile checksumFile((BString(file) << ".sha256").String(),
+			B_WRITE_ONLY | B_CREATE_FILE | B_ERASE_FILE);
+		CHECK(checksumFile.Write(checksum.String(), checksum.Length())
+			== checksum.Length());
+
+		BEntry fetchedFile((BString(directory) << "/fetched").String());
+		BEntry fetchedChecksum(
+			(BString(directory) << "/fetched.sha256").String());
+
+		BJob* fetchFile = new FetchFileJob(context,
+			BString("fetch repo ") << i, BString("file://") << file,
+			fetchedFile);
+		BJob* fetchChecksum = new FetchFileJob(context,
+			BString("fetch checksum ") << i,
+			BString("file://") << file << ".sha256", fetchedChecksum);
+		BJob* validate = new ValidateChecksumJob(context,
+			BString("validate repo ") << i,
+			new ChecksumFileChecksumAccessor(fetchedChecksum),
+			new GeneralFileChecksumAccessor(fetchedFile));
+
+		CHECK(validate->AddDependency(fetchFile) == B_OK);
+		CHECK(validate->AddDependency(fetchChecksum) == B_OK);
+
+		BJob* jobs[] = { fetchFile, fetchChecksum, validate };
+		for (int32 k = 0; k < 3; k++) {
+			CHECK(jobs[k]->AddStateListener(&listener) == B_OK);
+			CHECK(queue->AddJob(jobs[k]) == B_OK);
+		}
+	}
+
+	CHECK(queue->RunJobs(4) == B_BAD_DATA);
+	delete queue;
+
+	// each repository that got validated was fetched completely first
+	const std::vector<TestListener::Event>& events = listener.Events();
+	int32 failedCount = 0;
+	for (size_t i = 0; i < events.size(); i++) {
+		const TestListener::Event& event = events[i];
+		if (event.state == JOB_STATE_FAILED) {
+			CHECK(event.title
+				== (BString("validate repo ") << kRepositoryCount - 1));
+			failedCount++;
+			continue;
+		}
+
+		if (event.title.FindFirst("validate") != 0
+			|| event.state != JOB_STATE_RUNNING) {
+			continue;
+		}
+
+		int32 index = atoi(event.title.String() + strlen("validate repo "));
+		int32 fetched = 0;
+		for (size_t k = 0; k < i; k++) {
+			if (events[k].state == JOB_STATE_SUCCEEDED
+				&& (events[k].title == (BString("fetch repo ") << index)
+					|| events[k].title
+						== (BString("fetch checksum ") << index))) {
+				fetched++;
+			}
+		}
+		CHECK(fetched == 2);
+	}
+	CHECK(failedCount == 1);
+
+	remove_test_directory(kTestDirectory);
+	printf("file:// repositories: ok\n");
+}
+
+
+int
+main()
+{
+	TestDecisionProvider decisionProvider;
+	TestListener listener;
+	BContext context(decisionProvider, listener);
+	CHECK(context.InitCheck() == B_OK);
+
+	test_dependencies(context, listener);
+	test_failure(context, listener, 1, B_IO_ERROR);
+	test_failure(context, listener, 2, B_IO_ERROR);
+	test_failure(context, listener, 2, B_CANCELED);
+	test_file_repositories(context, listener);
+
+	printf("All tests passed.\n");
+	return 0;
+}
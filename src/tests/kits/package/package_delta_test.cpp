@@ -0,0 +1,298 @@
+/*
+ * Copyright 2011, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+// Builds a delta between two versions of a package, applies it to the old
+// version, and checks that the result is identical to the new version. Also
+// checks that corrupt deltas are rejected and that a delta applied to the
+// wrong package is detected.
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <string>
+
+#include <ByteOrder.h>
+#include <Entry.h>
+#include <String.h>
+
+#include <package/ChecksumAccessors.h>
+#include <package/PackageDeltaReader.h>
+#include <package/PackageDeltaWriter.h>
+#include <package/hpkg/HPKGDefsPrivate.h>
+
+#include "PackageTestUtils.h"
+
+
+using namespace BPackageKit::BHPKG::BPrivate;
+using namespace BPackageKit::BPrivate;
+
+
+static const char* kTestDirectory = "/tmp/package_delta_test";
+static const int32 kFileCount = 40;
+
+
+static std::string
+test_path(const char* name)
+{
+	return std::string(kTestDirectory) + "/" + name;
+}
+
+
+static std::string
+read_file(const std::string& path)
+{
+	int fd = open(path.c_str(), O_RDONLY);
+	CHECK(fd >= 0);
+
+	struct stat st;
+	CHECK(fstat(fd, &st) == 0);
+
+	std::string data(st.st_size, '\0');
+	CHECK(read(fd, &data[0], st.st_size) == st.st_size);
+	close(fd);
+
+	return data;
+}
+
+
+static void
+write_file(const std::string& path, const std::string& data)
+{
+	int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	CHECK(fd >= 0);
+	CHECK(write(fd, data.data(), data.size()) == (ssize_t)data.size());
+	close(fd);
+}
+
+
+static BString
+file_checksum(const std::string& path)
+{
+	BString checksum;
+	GeneralFileChecksumAccessor accessor(BEntry(path.c_str()));
+	CHECK(accessor.GetChecksum(checksum) == B_OK);
+	return checksum;
+}
+
+
+/*!	Creates the content of the old or new version of the package. The new one
+	differs in a few changed, removed, and added files only, so that most of
+	the package can be copied from the old one.
+*/
+static void
+create_content(const std::string& directory, bool newVersion)
+{
+	reset_test_directory(directory.c_str());
+
+	for (int32 i = 0; i < kFileCount; i++) {
+		if (newVersion && i == 7)
+			continue;
+
+		char name[32];
+		snprintf(name, sizeof(name), "/file%02ld", (long)i);
+		uint32 seed = newVersion && i % 10 == 3 ? 1000 + i : i;
+		create_test_file((directory + name).c_str(), 20000 + i * 3000, seed);
+	}
+
+	if (newVersion)
+		create_test_file((directory + "/added").c_str(), 50000, 4711);
+}
+
+
+static status_t
+apply_delta(const std::string& deltaPath, const std::string& basePath,
+	const std::string& targetPath)
+{
+	PackageDeltaReader reader;
+	status_t initError = reader.Init(deltaPath.c_str());
+
+	int baseFD = open(basePath.c_str(), O_RDONLY);
+	CHECK(baseFD >= 0);
+	int targetFD = open(targetPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC,
+		0644);
+	CHECK(targetFD >= 0);
+
+	status_t error = reader.Apply(baseFD, targetFD);
+
+	close(targetFD);
+	close(baseFD);
+
+	// a reader that failed to initialize must not apply anything
+	if (initError != B_OK)
+		CHECK(error == initError);
+
+	return error;
+}
+
+
+static void
+test_round_trip(const std::string& oldPackage, const std::string& newPackage,
+	const std::string& deltaPath)
+{
+	TestPackageWriterListener errorOutput;
+	PackageDeltaWriter writer(&errorOutput);
+	CHECK(writer.Write(oldPackage.c_str(), newPackage.c_str(),
+		deltaPath.c_str()) == B_OK);
+	CHECK(writer.CopiedSize() > 0);
+	CHECK(writer.DataSize() > 0);
+
+	struct stat st;
+	CHECK(stat(newPackage.c_str(), &st) == 0);
+	CHECK(writer.CopiedSize() + writer.DataSize() == (uint64)st.st_size);
+
+	PackageDeltaReader reader;
+	CHECK(reader.Init(deltaPath.c_str()) == B_OK);
+	CHECK(reader.NewPackageSize() == (uint64)st.st_size);
+
+	BString checksum;
+	CHECK(reader.GetOldPackageChecksum(checksum) == B_OK);
+	CHECK(checksum == file_checksum(oldPackage));
+	CHECK(reader.GetNewPackageChecksum(checksum) == B_OK);
+	CHECK(checksum == file_checksum(newPackage));
+
+	std::string targetPath = test_path("applied.hpkg");
+	// pre-fill the target, so that the truncation is tested as well
+	write_file(targetPath, std::string(st.st_size + 12345, 'x'));
+
+	CHECK(apply_delta(deltaPath, oldPackage, targetPath) == B_OK);
+	CHECK(read_file(targetPath) == read_file(newPackage));
+	CHECK(file_checksum(targetPath) == checksum);
+
+	printf("round trip: ok (%llu bytes copied, %llu bytes of data)\n",
+		(unsigned long long)writer.CopiedSize(),
+		(unsigned long long)writer.DataSize());
+}
+
+
+static void
+test_corrupt_delta(const std::string& oldPackage,
+	const std::string& deltaPath)
+{
+	std::string delta = read_file(deltaPath);
+	std::string corruptPath = test_path("corrupt.hpkd");
+	std::string targetPath = test_path("corrupt.hpkg");
+
+	// not initialized at all
+	{
+		PackageDeltaReader reader;
+		BString checksum;
+		CHECK(reader.GetNewPackageChecksum(checksum) == B_NO_INIT);
+		CHECK(reader.Apply(-1, -1) == B_NO_INIT);
+	}
+
+	// bad magic
+	std::string corrupt = delta;
+	corrupt[0] ^= 0xff;
+	write_file(corruptPath, corrupt);
+	CHECK(apply_delta(corruptPath, oldPackage, targetPath) == B_BAD_DATA);
+
+	// truncated
+	corrupt = delta.substr(0, delta.size() - 1);
+	write_file(corruptPath, corrupt);
+	CHECK(apply_delta(corruptPath, oldPackage, targetPath) == B_BAD_DATA);
+
+	// truncated header
+	corrupt = delta.substr(0, sizeof(hpkg_delta_header) / 2);
+	write_file(corruptPath, corrupt);
+	CHECK(apply_delta(corruptPath, oldPackage, targetPath) == B_BAD_DATA);
+
+	// unknown command type
+	hpkg_delta_header header;
+	memcpy(&header, delta.data(), sizeof(header));
+	size_t headerSize = B_BENDIAN_TO_HOST_INT16(header.header_size);
+	CHECK(B_BENDIAN_TO_HOST_INT32(header.command_count) > 0);
+
+	hpkg_delta_command command;
+	corrupt = delta;
+	memcpy(&command, corrupt.data() + headerSize, sizeof(command));
+	command.type = B_HOST_TO_BENDIAN_INT32(42);
+	memcpy(&corrupt[headerSize], &command, sizeof(command));
+	write_file(corruptPath, corrupt);
+	CHECK(apply_delta(corruptPath, oldPackage, targetPath) == B_BAD_DATA);
+
+	// command range beyond the end of the old package
+	corrupt = delta;
+	memcpy(&command, corrupt.data() + headerSize, sizeof(command));
+	command.offset = B_HOST_TO_BENDIAN_INT64(
+		B_BENDIAN_TO_HOST_INT64(header.old_package_size)
+			+ B_BENDIAN_TO_HOST_INT64(header.total_size));
+	memcpy(&corrupt[headerSize], &command, sizeof(command));
+	write_file(corruptPath, corrupt);
+	CHECK(apply_delta(corruptPath, oldPackage, targetPath) == B_BAD_DATA);
+
+	// the intact delta still applies with a reader that was re-initialized
+	// after a failure
+	{
+		PackageDeltaReader reader;
+		CHECK(reader.Init(corruptPath.c_str()) == B_BAD_DATA);
+		CHECK(reader.Init(deltaPath.c_str()) == B_OK);
+	}
+
+	printf("corrupt delta: ok\n");
+}
+
+
+static void
+test_mismatched_base(const std::string& oldPackage,
+	const std::string& newPackage, const std::string& deltaPath)
+{
+	std::string targetPath = test_path("mismatched.hpkg");
+
+	// a base of a different size is rejected outright
+	std::string base = read_file(oldPackage);
+	std::string basePath = test_path("base.hpkg");
+	write_file(basePath, base + "x");
+	CHECK(apply_delta(deltaPath, basePath, targetPath)
+		== B_MISMATCHED_VALUES);
+
+	// A base of the same size can only be told apart by its checksum, which
+	// is up to the caller to verify. The result doesn't match either.
+	for (size_t i = 0; i < base.size(); i++)
+		base[i] ^= 0x5a;
+	write_file(basePath, base);
+
+	PackageDeltaReader reader;
+	CHECK(reader.Init(deltaPath.c_str()) == B_OK);
+	BString checksum;
+	CHECK(reader.GetOldPackageChecksum(checksum) == B_OK);
+	CHECK(checksum != file_checksum(basePath));
+
+	CHECK(apply_delta(deltaPath, basePath, targetPath) == B_OK);
+	CHECK(reader.GetNewPackageChecksum(checksum) == B_OK);
+	CHECK(checksum != file_checksum(targetPath));
+	CHECK(read_file(targetPath) != read_file(newPackage));
+
+	printf("mismatched base: ok\n");
+}
+
+
+int
+main()
+{
+	std::string oldContent = test_path("old");
+	std::string newContent = test_path("new");
+	std::string oldPackage = test_path("old.hpkg");
+	std::string newPackage = test_path("new.hpkg");
+	std::string deltaPath = test_path("delta.hpkd");
+
+	reset_test_directory(kTestDirectory);
+	create_content(oldContent, false);
+	create_content(newContent, true);
+	create_test_package(oldPackage.c_str(), oldContent.c_str(),
+		"package_delta_test", "1.0-1");
+	create_test_package(newPackage.c_str(), newContent.c_str(),
+		"package_delta_test", "1.1-1");
+
+	test_round_trip(oldPackage, newPackage, deltaPath);
+	test_corrupt_delta(oldPackage, deltaPath);
+	test_mismatched_base(oldPackage, newPackage, deltaPath);
+
+	remove_test_directory(kTestDirectory);
+	printf("All tests passed.\n");
+	return 0;
+}
@@ -0,0 +1,354 @@
+/*
+ * Copyright 2011, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+// Writes a repository file, which always gets an index, and a copy of it whose
+// index header is cleared, and checks that the lookups of a repository cache
+// using the index yield the same results as the ones parsing all packages.
+// Also checks the index entries against the parsed package infos.
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <ByteOrder.h>
+#include <Entry.h>
+#include <StringList.h>
+
+#include <package/PackageInfo.h>
+#include <package/RepositoryCache.h>
+#include <package/RepositoryInfo.h>
+#include <package/hpkg/HPKGDefsPrivate.h>
+#include <package/hpkg/RepositoryIndex.h>
+#include <package/hpkg/RepositoryWriter.h>
+
+#include "PackageTestUtils.h"
+
+
+using namespace BPackageKit;
+using namespace BPackageKit::BHPKG;
+using BPackageKit::BHPKG::BPrivate::RepositoryIndex;
+
+
+static const char* kTestDirectory = "/tmp/repository_index_test";
+static const int32 kPackageCount = 24;
+
+
+typedef std::multiset<std::string> StringSet;
+
+
+// TestRepositoryWriterListener
+class TestRepositoryWriterListener : public BRepositoryWriterListener {
+public:
+	virtual void PrintErrorVarArgs(const char* format, va_list args)
+	{
+		vfprintf(stderr, format, args);
+	}
+
+	virtual void OnPackageAdded(const BPackageInfo& packageInfo)
+	{
+	}
+
+	virtual void OnRepositoryInfoSectionDone(uint32 uncompressedSize)
+	{
+	}
+
+	virtual void OnPackageAttributesSectionDone(uint32 stringCount,
+		uint32 uncompressedSize)
+	{
+	}
+
+	virtual void OnRepositoryDone(uint32 headerSize,
+		uint32 repositoryInfoLength, uint32 licenseCount, uint32 packageCount,
+		uint32 packageAttributesSize, uint64 totalSize)
+	{
+	}
+};
+
+
+/*!	Creates packages providing and requiring overlapping sets of resolvables.
+	Some packages provide or require the same resolvable more than once, and
+	some resolvables are provided by many packages.
+*/
+static void
+create_packages(const std::string& directory, std::vector<std::string>& paths)
+{
+	std::string contentDirectory = directory + "/content";
+	reset_test_directory(contentDirectory.c_str());
+	create_test_file((contentDirectory + "/file").c_str(), 1000, 0);
+
+	for (int32 i = 0; i < kPackageCount; i++) {
+		char name[32];
+		snprintf(name, sizeof(name), "pkg%02ld", (long)i);
+		char version[32];
+		snprintf(version, sizeof(version), "1.%ld-%ld", (long)i % 5,
+			(long)i % 3 + 1);
+
+		char provides[256];
+		snprintf(provides, sizeof(provides),
+			"lib%s = 1.%ld compat >= 1; cmd:tool%ld; shared = %ld%s",
+			name, (long)i % 5, (long)i % 4, (long)i,
+			i % 6 == 0 ? "; shared = 99" : "");
+
+		std::string requirements;
+		if (i > 0) {
+			char buffer[256];
+			snprintf(buffer, sizeof(buffer),
+				"pkg%02ld >= 1.0; libpkg00 < 2; cmd:tool%ld", (long)i - 1,
+				(long)(i + 1) % 4);
+			requirements = buffer;
+		}
+		if (i % 5 == 0)
+			requirements += "; libpkg03 >= 1.3; libpkg03 != 1.1";
+		if (i % 7 == 3)
+			requirements += "; missing == 1";
+
+		std::string path = directory + "/" + name + ".hpkg";
+		create_test_package(path.c_str(), contentDirectory.c_str(), name,
+			version, 0, provides, requirements.c_str());
+		paths.push_back(path);
+	}
+}
+
+
+static void
+write_repository(const std::string& path,
+	const std::vector<std::string>& packagePaths)
+{
+	BRepositoryInfo repositoryInfo;
+	repositoryInfo.SetName("repository_index_test");
+	repositoryInfo.SetOriginalBaseURL("file:///tmp/repository_index_test");
+	repositoryInfo.SetVendor("Haiku Project");
+	repositoryInfo.SetSummary("A repository created by a test");
+	repositoryInfo.SetPriority(1);
+	repositoryInfo.SetArchitecture(B_PACKAGE_ARCHITECTURE_ANY);
+
+	TestRepositoryWriterListener listener;
+	BRepositoryWriter writer(&listener, &repositoryInfo);
+	CHECK(writer.Init(path.c_str()) == B_OK);
+	for (size_t i = 0; i < packagePaths.size(); i++)
+		CHECK(writer.AddPackage(BEntry(packagePaths[i].c_str())) == B_OK);
+	CHECK(writer.Finish() == B_OK);
+}
+
+
+//!	Copies the repository file, with an index header announcing no index.
+static void
+copy_without_index(const std::string& path, const std::string& copyPath)
+{
+	int fd = open(path.c_str(), O_RDONLY);
+	CHECK(fd >= 0);
+	std::string data;
+	char buffer[4096];
+	ssize_t bytesRead;
+	while ((bytesRead = read(fd, buffer, sizeof(buffer))) > 0)
+		data.append(buffer, bytesRead);
+	CHECK(bytesRead == 0);
+	close(fd);
+
+	BHPKG::BPrivate::hpkg_repo_header header;
+	CHECK(data.size() > sizeof(header));
+	memcpy(&header, data.data(), sizeof(header));
+	CHECK(B_BENDIAN_TO_HOST_INT16(header.header_size) >= sizeof(header)
+		+ sizeof(BHPKG::BPrivate::hpkg_repo_index_header));
+
+	BHPKG::BPrivate::hpkg_repo_index_header indexHeader;
+	memcpy(&indexHeader, data.data() + sizeof(header), sizeof(indexHeader));
+	CHECK(indexHeader.index_length != 0);
+	indexHeader.index_length = 0;
+	memcpy(&data[sizeof(header)], &indexHeader, sizeof(indexHeader));
+
+	fd = open(copyPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	CHECK(fd >= 0);
+	CHECK(write(fd, data.data(), data.size()) == (ssize_t)data.size());
+	close(fd);
+}
+
+
+static std::vector<std::string>
+sorted(const BStringList& list)
+{
+	std::vector<std::string> strings;
+	for (int32 i = 0; i < list.CountStrings(); i++)
+		strings.push_back(list.StringAt(i).String());
+	std::sort(strings.begin(), strings.end());
+	return strings;
+}
+
+
+static void
+check_lookups(const BRepositoryCache& indexed, const BRepositoryCache& plain,
+	const std::set<std::string>& names)
+{
+	for (std::set<std::string>::const_iterator it = names.begin();
+			it != names.end(); ++it) {
+		BStringList indexedNames;
+		BStringList plainNames;
+		CHECK(indexed.GetPackagesProviding(it->c_str(), indexedNames)
+			== B_OK);
+		CHECK(plain.GetPackagesProviding(it->c_str(), plainNames) == B_OK);
+		if (sorted(indexedNames) != sorted(plainNames)) {
+			printf("providing \"%s\": %ld vs. %ld packages\n", it->c_str(),
+				(long)indexedNames.CountStrings(),
+				(long)plainNames.CountStrings());
+			CHECK(false);
+		}
+
+		indexedNames.MakeEmpty();
+		plainNames.MakeEmpty();
+		CHECK(indexed.GetPackagesRequiring(it->c_str(), indexedNames)
+			== B_OK);
+		CHECK(plain.GetPackagesRequiring(it->c_str(), plainNames) == B_OK);
+		if (sorted(indexedNames) != sorted(plainNames)) {
+			printf("requiring \"%s\": %ld vs. %ld packages\n", it->c_str(),
+				(long)indexedNames.CountStrings(),
+				(long)plainNames.CountStrings());
+			CHECK(false);
+		}
+	}
+}
+
+
+/*!	Checks the index entries against the package infos, and collects the
+	names of all resolvables.
+*/
+static void
+check_index(const RepositoryIndex& index, const BRepositoryCache& plain,
+	std::set<std::string>& _names)
+{
+	CHECK(index.CountPackages() == plain.CountPackages());
+
+	StringSet expectedProvides;
+	StringSet expectedRequires;
+	BRepositoryCache::Iterator it;
+	CHECK(plain.GetIterator(it) == B_OK);
+	while (it.HasNext()) {
+		const BPackageInfo* info = it.Next();
+		int32 packageIndex = index.FindPackage(info->Name());
+		CHECK(packageIndex >= 0);
+		CHECK(info->Name() == index.PackageNameAt(packageIndex));
+		CHECK(info->Checksum() == index.PackageChecksumAt(packageIndex));
+		CHECK(info->Architecture()
+			== index.PackageArchitectureAt(packageIndex));
+		BPackageVersion version;
+		index.GetPackageVersionAt(packageIndex, version);
+		CHECK(version.Compare(info->Version()) == 0);
+
+		const BObjectList<BPackageResolvable>& providesList
+			= info->ProvidesList();
+		for (int32 i = 0; i < providesList.CountItems(); i++) {
+			const BPackageResolvable* resolvable = providesList.ItemAt(i);
+			expectedProvides.insert(std::string(info->Name().String()) + ": "
+				+ resolvable->ToString().String());
+			_names.insert(resolvable->Name().String());
+		}
+
+		const BObjectList<BPackageResolvableExpression>& requiresList
+			= info->RequiresList();
+		for (int32 i = 0; i < requiresList.CountItems(); i++) {
+			const BPackageResolvableExpression* expression
+				= requiresList.ItemAt(i);
+			expectedRequires.insert(std::string(info->Name().String()) + ": "
+				+ expression->ToString().String());
+			_names.insert(expression->Name().String());
+		}
+	}
+
+	// look up each name, the index entries must match the package infos
+	StringSet provides;
+	StringSet requirements;
+	for (std::set<std::string>::const_iterator it = _names.begin();
+			it != _names.end(); ++it) {
+		uint32 count;
+		uint32 first = index.FindProvides(it->c_str(), count);
+		for (uint32 i = first; i < first + count; i++) {
+			BPackageResolvable resolvable;
+			uint32 packageIndex;
+			CHECK(index.GetProvidesAt(i, resolvable, packageIndex) == B_OK);
+			CHECK(resolvable.Name() == it->c_str());
+			provides.insert(std::string(index.PackageNameAt(packageIndex))
+				+ ": " + resolvable.ToString().String());
+		}
+
+		first = index.FindRequires(it->c_str(), count);
+		for (uint32 i = first; i < first + count; i++) {
+			BPackageResolvableExpression expression;
+			uint32 packageIndex;
+			CHECK(index.GetRequiresAt(i, expression, packageIndex) == B_OK);
+			CHECK(expression.Name() == it->c_str());
+			requirements.insert(std::string(index.PackageNameAt(packageIndex))
+				+ ": " + expression.ToString().String());
+		}
+	}
+
+	CHECK(provides == expectedProvides);
+	CHECK(requirements == expectedRequires);
+
+	// entries beyond the tables are rejected
+	BPackageResolvableExpression expression;
+	uint32 packageIndex;
+	CHECK(index.GetRequiresAt(requirements.size(), expression, packageIndex)
+		== B_BAD_INDEX);
+	CHECK(index.FindPackage("nonexistent") < 0);
+}
+
+
+int
+main()
+{
+	std::string directory = kTestDirectory;
+	std::string repositoryPath = directory + "/repo";
+	std::string plainRepositoryPath = directory + "/repo.plain";
+
+	reset_test_directory(kTestDirectory);
+	std::vector<std::string> packagePaths;
+	create_packages(directory, packagePaths);
+	write_repository(repositoryPath, packagePaths);
+	copy_without_index(repositoryPath, plainRepositoryPath);
+
+	BRepositoryCache indexed;
+	CHECK(indexed.SetTo(BEntry(repositoryPath.c_str())) == B_OK);
+	CHECK(indexed.HasIndex());
+	BRepositoryCache plain;
+	CHECK(plain.SetTo(BEntry(plainRepositoryPath.c_str())) == B_OK);
+	CHECK(!plain.HasIndex());
+
+	CHECK(indexed.Info().Name() == plain.Info().Name());
+	CHECK(indexed.CountPackages() == (uint32)kPackageCount);
+	CHECK(plain.CountPackages() == (uint32)kPackageCount);
+
+	RepositoryIndex missingIndex;
+	CHECK(missingIndex.Init(plainRepositoryPath.c_str()) == B_ENTRY_NOT_FOUND);
+	RepositoryIndex index;
+	CHECK(index.Init(repositoryPath.c_str()) == B_OK);
+
+	std::set<std::string> names;
+	check_index(index, plain, names);
+	printf("index entries: ok\n");
+
+	names.insert("nonexistent");
+	names.insert("");
+	names.insert("zzz");
+	check_lookups(indexed, plain, names);
+	printf("lookups: ok (%ld names)\n", (long)names.size());
+
+	// iterating works either way, the indexed cache loads the packages then
+	int32 count = 0;
+	for (BRepositoryCache::Iterator it = indexed.GetIterator(); it.HasNext();
+			it.Next()) {
+		count++;
+	}
+	CHECK(count == kPackageCount);
+	printf("iteration: ok\n");
+
+	remove_test_directory(kTestDirectory);
+	printf("All tests passed.\n");
+	return 0;
+}
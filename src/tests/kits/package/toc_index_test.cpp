@@ -0,0 +1,325 @@
+/*
+ * Copyright 2011, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+// Writes the same directory tree into a package with and without a TOC index,
+// and checks that reading the packages yields the same entries, both when
+// parsing the complete TOC and when parsing a single directory only.
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <map>
+#include <string>
+
+#include <fs_attr.h>
+
+#include <package/hpkg/HPKGDefs.h>
+#include <package/hpkg/PackageContentHandler.h>
+#include <package/hpkg/PackageEntry.h>
+#include <package/hpkg/PackageEntryAttribute.h>
+#include <package/hpkg/PackageReader.h>
+
+#include "PackageTestUtils.h"
+
+
+using namespace BPackageKit::BHPKG;
+
+
+static const char* kTestDirectory = "/tmp/toc_index_test";
+static const int32 kDirectoryCount = 12;
+static const int32 kSubDirectoryCount = 3;
+static const int32 kFileCount = 60;
+	// enough entries for the TOC to span several index blocks
+
+
+typedef std::map<std::string, std::string> EntryMap;
+
+
+// EntryCollector
+class EntryCollector : public BPackageContentHandler {
+public:
+	EntryCollector(bool withDataOffsets)
+		:
+		fWithDataOffsets(withDataOffsets)
+	{
+	}
+
+	const EntryMap& Entries() const
+	{
+		return fEntries;
+	}
+
+	virtual status_t HandleEntry(BPackageEntry* entry)
+	{
+		BPackageData& data = entry->Data();
+
+		char description[512];
+		snprintf(description, sizeof(description),
+			"mode %o, modified %ld, size %llu, link \"%s\"",
+			(unsigned)entry->Mode(), (long)entry->ModifiedTime().tv_sec,
+			(unsigned long long)data.UncompressedSize(),
+			entry->SymlinkPath() != NULL ? entry->SymlinkPath() : "");
+		std::string& value = fEntries[_Path(entry)];
+		CHECK(value.empty());
+		value = description;
+
+		if (fWithDataOffsets)
+			_AppendData(value, data);
+
+		return B_OK;
+	}
+
+	virtual status_t HandleEntryAttribute(BPackageEntry* entry,
+		BPackageEntryAttribute* attribute)
+	{
+		char description[512];
+		snprintf(description, sizeof(description),
+			", attribute \"%s\" %08lx %llu", attribute->Name(),
+			(unsigned long)attribute->Type(),
+			(unsigned long long)attribute->Data().UncompressedSize());
+		std::string& value = fEntries[_Path(entry)];
+		value += description;
+
+		if (fWithDataOffsets)
+			_AppendData(value, attribute->Data());
+
+		return B_OK;
+	}
+
+	virtual status_t HandleEntryDone(BPackageEntry* entry)
+	{
+		return B_OK;
+	}
+
+	virtual status_t HandlePackageAttribute(
+		const BPackageInfoAttributeValue& value)
+	{
+		return B_OK;
+	}
+
+	virtual void HandleErrorOccurred()
+	{
+	}
+
+private:
+	static std::string _Path(const BPackageEntry* entry)
+	{
+		if (entry->Parent() == NULL)
+			return entry->Name();
+		return _Path(entry->Parent()) + "/" + entry->Name();
+	}
+
+	static void _AppendData(std::string& value, BPackageData& data)
+	{
+		char description[64];
+		if (data.IsEncodedInline()) {
+			snprintf(description, sizeof(description), " inline");
+		} else {
+			snprintf(description, sizeof(description), " at %llu",
+				(unsigned long long)data.Offset());
+		}
+		value += description;
+	}
+
+private:
+	bool		fWithDataOffsets;
+	EntryMap	fEntries;
+};
+
+
+static void
+create_content(const char* contentDirectory)
+{
+	reset_test_directory(contentDirectory);
+
+	char path[B_PATH_NAME_LENGTH];
+	for (int32 i = 0; i < kDirectoryCount; i++) {
+		snprintf(path, sizeof(path), "%s/dir%02ld", contentDirectory, (long)i);
+		CHECK(mkdir(path, 0755) == 0);
+
+		for (int32 j = 0; j < kSubDirectoryCount; j++) {
+			snprintf(path, sizeof(path), "%s/dir%02ld/sub%ld", contentDirectory,
+				(long)i, (long)j);
+			CHECK(mkdir(path, 0755) == 0);
+
+			for (int32 k = 0; k < kFileCount; k++) {
+				snprintf(path, sizeof(path), "%s/dir%02ld/sub%ld/file%03ld",
+					contentDirectory, (long)i, (long)j, (long)k);
+				create_test_file(path, (k * 37) % 300, i * 1000 + j * 100 + k);
+
+				// add an attribute to some of the files
+				if (k % 3 == 0) {
+					int fd = open(path, O_WRONLY);
+					CHECK(fd >= 0);
+					int32 value = i * 10000 + k;
+					CHECK(fs_write_attr(fd, "test:value", B_INT32_TYPE, 0,
+						&value, sizeof(value)) == sizeof(value));
+					close(fd);
+				}
+			}
+
+			snprintf(path, sizeof(path), "%s/dir%02ld/sub%ld/link",
+				contentDirectory, (long)i, (long)j);
+			CHECK(symlink("file000", path) == 0);
+		}
+	}
+}
+
+
+static EntryMap
+parse(BPackageReader& reader, const char* subPath, bool withDataOffsets)
+{
+	EntryCollector collector(withDataOffsets);
+	status_t error = subPath != NULL
+		? reader.ParseContent(&collector, subPath)
+		: reader.ParseContent(&collector);
+	CHECK(error == B_OK);
+	return collector.Entries();
+}
+
+
+//!	Returns the entries of \a subPath and its descendants.
+static EntryMap
+filter(const EntryMap& entries, const std::string& subPath)
+{
+	EntryMap filtered;
+	for (EntryMap::const_iterator it = entries.begin(); it != entries.end();
+			++it) {
+		if (it->first == subPath
+			|| it->first.compare(0, subPath.length() + 1, subPath + "/")
+				== 0) {
+			filtered.insert(*it);
+		}
+	}
+
+	return filtered;
+}
+
+
+static void
+check_equal(const EntryMap& entries, const EntryMap& expectedEntries)
+{
+	EntryMap::const_iterator it = entries.begin();
+	EntryMap::const_iterator expectedIt = expectedEntries.begin();
+	for (; it != entries.end() && expectedIt != expectedEntries.end();
+			++it, ++expectedIt) {
+		if (it->first != expectedIt->first
+			|| it->second != expectedIt->second) {
+			printf("got \"%s\": %s\nexpected \"%s\": %s\n", it->first.c_str(),
+				it->second.c_str(), expectedIt->first.c_str(),
+				expectedIt->second.c_str());
+			CHECK(false);
+		}
+	}
+
+	CHECK(entries.size() == expectedEntries.size());
+}
+
+
+/*!	Checks that parsing \a subPath via the index yields the same entries in
+	the sub path as parsing the complete TOC, and nothing but the sub path's
+	ancestors besides.
+*/
+static void
+test_sub_path(BPackageReader& reader, const EntryMap& allEntries,
+	const char* subPath, bool indexed)
+{
+	std::string normalizedPath = subPath;
+	while (normalizedPath[0] == '/')
+		normalizedPath.erase(0, 1);
+	while (normalizedPath[normalizedPath.length() - 1] == '/')
+		normalizedPath.erase(normalizedPath.length() - 1);
+
+	EntryMap entries = parse(reader, subPath, true);
+	EntryMap expectedEntries = filter(allEntries, normalizedPath);
+	CHECK(!expectedEntries.empty());
+	check_equal(filter(entries, normalizedPath), expectedEntries);
+
+	if (!indexed) {
+		// without an index, the complete TOC is parsed
+		CHECK(entries.size() == allEntries.size());
+		return;
+	}
+
+	for (EntryMap::const_iterator it = entries.begin(); it != entries.end();
+			++it) {
+		if (expectedEntries.find(it->first) != expectedEntries.end())
+			continue;
+
+		// not in the sub path, must be an ancestor
+		std::string prefix = it->first + "/";
+		if (normalizedPath.compare(0, prefix.length(), prefix) != 0) {
+			printf("unexpected entry \"%s\" for sub path \"%s\"\n",
+				it->first.c_str(), subPath);
+			CHECK(false);
+		}
+	}
+}
+
+
+int
+main()
+{
+	char contentDirectory[B_PATH_NAME_LENGTH];
+	snprintf(contentDirectory, sizeof(contentDirectory), "%s/content",
+		kTestDirectory);
+	char plainPackage[B_PATH_NAME_LENGTH];
+	snprintf(plainPackage, sizeof(plainPackage), "%s/plain.hpkg",
+		kTestDirectory);
+	char indexedPackage[B_PATH_NAME_LENGTH];
+	snprintf(indexedPackage, sizeof(indexedPackage), "%s/indexed.hpkg",
+		kTestDirectory);
+
+	reset_test_directory(kTestDirectory);
+	create_content(contentDirectory);
+	create_test_package(plainPackage, contentDirectory, "toc_index_test",
+		"1.0-1");
+	create_test_package(indexedPackage, contentDirectory, "toc_index_test",
+		"1.0-1", B_HPKG_WRITER_TOC_INDEX);
+
+	TestPackageWriterListener errorOutput;
+	BPackageReader plainReader(&errorOutput);
+	CHECK(plainReader.Init(plainPackage) == B_OK);
+	BPackageReader indexedReader(&errorOutput);
+	CHECK(indexedReader.Init(indexedPackage) == B_OK);
+
+	// Both packages contain the same entries. The data offsets may differ,
+	// since the index is stored in the heap, too.
+	EntryMap allEntries = parse(plainReader, NULL, false);
+	CHECK(allEntries.size() == (size_t)(kDirectoryCount
+		* (1 + kSubDirectoryCount * (kFileCount + 2)) + 1));
+	check_equal(parse(indexedReader, NULL, false), allEntries);
+	printf("complete TOC: ok\n");
+
+	// parse sub directories -- compare with the complete TOC of the same
+	// package, including the data offsets
+	EntryMap allIndexedEntries = parse(indexedReader, NULL, true);
+	EntryMap allPlainEntries = parse(plainReader, NULL, true);
+	const char* subPaths[] = {
+		"dir00",
+		"dir07/sub1",
+		"/dir11/sub2",
+		"dir03/sub0/",
+		NULL
+	};
+	for (int32 i = 0; subPaths[i] != NULL; i++) {
+		test_sub_path(indexedReader, allIndexedEntries, subPaths[i], true);
+		test_sub_path(plainReader, allPlainEntries, subPaths[i], false);
+	}
+	printf("sub paths: ok\n");
+
+	// a path that doesn't exist falls back to parsing everything
+	CHECK(parse(indexedReader, "dir99/sub0", true).size()
+		== allIndexedEntries.size());
+	printf("missing sub path: ok\n");
+
+	remove_test_directory(kTestDirectory);
+	printf("All tests passed.\n");
+	return 0;
+}
@@ -5,6 +5,9 @@
 #include <File.h>
 #include <Path.h>
 
+#include <string.h>
+#include <sys/uio.h>
+
 #include <cppunit/TestCaller.h>
 #include <cppunit/TestSuite.h>
 #include <TestShell.h>
@@ -25,6 +28,8 @@ FileTest::Suite()
 	suite->addTest( new TC("BFile::IsRead-/IsWriteable Test",
 						   &FileTest::RWAbleTest) );
 	suite->addTest( new TC("BFile::Read/Write Test", &FileTest::RWTest) );
+	suite->addTest( new TC("BFile::ReadAtV/WriteAtV Test",
+						   &FileTest::RWVTest) );
 	suite->addTest( new TC("BFile::Position Test", &FileTest::PositionTest) );
 	suite->addTest( new TC("BFile::Size Test", &FileTest::SizeTest) );
 	suite->addTest( new TC("BFile::Assignment Test",
@@ -501,6 +506,77 @@ FileTest::RWTest()
 	execCommand(string("rm -f ") + testFilename1);
 }
 
+// RWVTest
+void
+FileTest::RWVTest()
+{
+#if !TEST_R5
+	char buffer1[64];
+	char buffer2[64];
+	iovec vecs[2] = {
+		{ buffer1, sizeof(buffer1) },
+		{ buffer2, sizeof(buffer2) }
+	};
+	// read/write an uninitialized BFile
+	NextSubTest();
+	BFile file;
+	CPPUNIT_ASSERT( file.ReadAtV(0, vecs, 2) < 0 );
+	CPPUNIT_ASSERT( file.WriteAtV(0, vecs, 2) < 0 );
+	// write some data into a new file in one go, and check it
+	NextSubTest();
+	file.SetTo(testFilename1, B_READ_WRITE | B_CREATE_FILE | B_ERASE_FILE);
+	CPPUNIT_ASSERT( file.InitCheck() == B_OK );
+	for (int32 i = 0; i < 64; i++) {
+		buffer1[i] = (char)i;
+		buffer2[i] = (char)(i + 64);
+	}
+	CPPUNIT_ASSERT( file.WriteAtV(10, vecs, 2) == 128 );
+	CPPUNIT_ASSERT( file.Position() == 0 );
+	off_t size;
+	CPPUNIT_ASSERT( file.GetSize(&size) == B_OK );
+	CPPUNIT_ASSERT( size == 138 );
+	char readBuffer[128];
+	CPPUNIT_ASSERT( file.ReadAt(10, readBuffer, 128) == 128 );
+	for (int32 i = 0; i < 128; i++)
+		CPPUNIT_ASSERT( readBuffer[i] == (char)i );
+	// read it back in one go
+	NextSubTest();
+	memset(buffer1, 0, sizeof(buffer1));
+	memset(buffer2, 0, sizeof(buffer2));
+	CPPUNIT_ASSERT( file.ReadAtV(10, vecs, 2) == 128 );
+	CPPUNIT_ASSERT( file.Position() == 0 );
+	for (int32 i = 0; i < 64; i++) {
+		CPPUNIT_ASSERT( buffer1[i] == (char)i );
+		CPPUNIT_ASSERT( buffer2[i] == (char)(i + 64) );
+	}
+	// read across the end of the file
+	NextSubTest();
+	memset(buffer2, 0, sizeof(buffer2));
+	CPPUNIT_ASSERT( file.ReadAtV(50, vecs, 2) == 88 );
+	for (int32 i = 0; i < 64; i++)
+		CPPUNIT_ASSERT( buffer1[i] == (char)(i + 40) );
+	for (int32 i = 0; i < 24; i++)
+		CPPUNIT_ASSERT( buffer2[i] == (char)(i + 104) );
+	CPPUNIT_ASSERT( file.ReadAtV(200, vecs, 2) == 0 );
+	// bad arguments
+	NextSubTest();
+	CPPUNIT_ASSERT( file.ReadAtV(-1, vecs, 2) == B_BAD_VALUE );
+	CPPUNIT_ASSERT( file.WriteAtV(-1, vecs, 2) == B_BAD_VALUE );
+	file.Unset();
+	// read/write a file opened for writing/reading only
+	NextSubTest();
+	file.SetTo(testFilename1, B_WRITE_ONLY);
+	CPPUNIT_ASSERT( file.InitCheck() == B_OK );
+	CPPUNIT_ASSERT( file.ReadAtV(0, vecs, 2) < 0 );
+	file.SetTo(testFilename1, B_READ_ONLY);
+	CPPUNIT_ASSERT( file.InitCheck() == B_OK );
+	CPPUNIT_ASSERT( file.WriteAtV(0, vecs, 2) < 0 );
+	file.Unset();
+
+	execCommand(string("rm -f ") + testFilename1);
+#endif	// !TEST_R5
+}
+
 // PositionTest
 void
 FileTest::PositionTest()
@@ -26,6 +26,7 @@ public:
 	void InitTest2();
 	void RWAbleTest();
 	void RWTest();
+	void RWVTest();
 	void PositionTest();
 	void SizeTest();
 	void AssignmentTest();
@@ -20,7 +20,10 @@
 #include <Message.h>
 #include <Mime.h>
 #if !TEST_R5
+	#include <mime/database_snapshot.h>
 	#include <mime/database_support.h>
+	#include <RegistrarDefs.h>
+	#include <RosterPrivate.h>
 #endif
 #include <Path.h>			// Only needed for entry_ref dumps
 #include <StorageKit.h>
@@ -222,6 +225,8 @@ MimeTypeTest::Suite() {
 						   &MimeTypeTest::SnifferRuleTest) );
 	suite->addTest( new TC("BMimeType::Sniffing Test",
 						   &MimeTypeTest::SniffingTest) );
+	suite->addTest( new TC("BMimeType::Database Snapshot Test",
+						   &MimeTypeTest::SnapshotTest) );
 		
 						   
 	return suite;
@@ -4828,6 +4833,245 @@ printf("type: %s, should be: %s (file == '%s')\n", type.Type(), realType, filena
 }
 
 
+#if !TEST_R5
+
+using namespace BPrivate::Storage::Mime;
+
+// Returns the generation of the registrar's MIME database snapshot.
+static int32
+snapshot_generation()
+{
+	area_id source = find_area(MIME_SNAPSHOT_CONTROL_AREA_NAME);
+	CHK(source >= 0);
+
+	void *address;
+	area_id area = clone_area("mime snapshot test control", &address,
+		B_ANY_ADDRESS, B_READ_AREA, source);
+	CHK(area >= 0);
+
+	int32 generation = ((const mime_snapshot_control*)address)->generation;
+	delete_area(area);
+	return generation;
+}
+
+// Waits until the registrar has published a new snapshot of the database.
+static void
+wait_for_snapshot()
+{
+	bool installed;
+	for (int32 i = 0; i < 100; i++) {
+		if (snapshot_is_installed(applicationSupertype, &installed) == B_OK)
+			return;
+		snooze(50000);
+	}
+	CHK(false);
+}
+
+// Asks the registrar for the apps supporting a type, bypassing the snapshot.
+static status_t
+registrar_supporting_apps(const char *type, BMessage *apps)
+{
+	BMessage request(BPrivate::B_REG_MIME_GET_SUPPORTING_APPS);
+	status_t error = request.AddString("type", type);
+	if (error == B_OK)
+		error = BRoster::Private().SendTo(&request, apps, true);
+	return error;
+}
+
+// Reads an attribute from a type's database file, bypassing the snapshot.
+static ssize_t
+read_database_attr(const char *type, const char *attr, void *data,
+	size_t length)
+{
+	BNode node((mimeDatabaseDir + "/" + to_lower(type)).c_str());
+	status_t error = node.InitCheck();
+	if (error != B_OK)
+		return error;
+	return node.ReadAttr(attr, B_ANY_TYPE, 0, data, length);
+}
+
+#endif	// !TEST_R5
+
+// SnapshotTest
+void
+MimeTypeTest::SnapshotTest()
+{
+#if !TEST_R5
+	// The answers of the registrar's snapshot of the database must match
+	// those of the file system and the registrar itself.
+	const size_t largeSize = 70 * 1024;
+	char *largeData = new char[largeSize];
+	char *buffer = new char[largeSize];
+	for (size_t i = 0; i < largeSize; i++)
+		largeData[i] = (char)i;
+
+	// install a type with a mixed case name, and an app supporting it
+	NextSubTest();
+	BMimeType type(testType);
+	CHK(type.InitCheck() == B_OK);
+	CHK(type.Install() == B_OK);
+	{
+		// The snapshot only holds attributes up to 64 KB. These are written
+		// directly, the registrar picks them up with the changes below.
+		BNode node((mimeDatabaseDir + "/" + to_lower(testType)).c_str());
+		CHK(node.InitCheck() == B_OK);
+		CHK(node.WriteAttr("test:large", B_RAW_TYPE, 0, largeData, largeSize)
+			== (ssize_t)largeSize);
+		CHK(node.WriteAttr("test:small", B_RAW_TYPE, 0, largeData, 100)
+			== 100);
+	}
+	CHK(type.SetShortDescription(testDescr) == B_OK);
+	BMessage extensions;
+	CHK(extensions.AddString(fileExtField, "snapshot") == B_OK);
+	CHK(type.SetFileExtensions(&extensions) == B_OK);
+
+	BMimeType app(testTypeApp);
+	CHK(app.InitCheck() == B_OK);
+	CHK(app.Install() == B_OK);
+	BMessage supportedTypes;
+	CHK(supportedTypes.AddString(typesField, testType) == B_OK);
+	CHK(supportedTypes.AddString(typesField, "text") == B_OK);
+	CHK(app.SetSupportedTypes(&supportedTypes) == B_OK);
+
+	wait_for_snapshot();
+
+	// lookups with any spelling of the type
+	NextSubTest();
+	std::string lowerType = to_lower(testType);
+	std::string upperType = testType;
+	for (uint32 i = 0; i < upperType.length(); i++)
+		upperType[i] = toupper(upperType[i]);
+	const char * const spellings[] = {
+		testType, lowerType.c_str(), upperType.c_str()
+	};
+	for (uint32 i = 0; i < sizeof(spellings) / sizeof(const char*); i++) {
+		const char *spelling = spellings[i];
+
+		bool installed;
+		CHK(snapshot_is_installed(spelling, &installed) == B_OK);
+		CHK(installed);
+		CHK(installed == type_exists(spelling));
+
+		char expected[B_MIME_TYPE_LENGTH];
+		ssize_t size = read_database_attr(testType, kShortDescriptionAttr, expected,
+			sizeof(expected));
+		CHK(size > 0);
+		CHK(read_snapshot_attr(spelling, kShortDescriptionAttr, buffer,
+			B_MIME_TYPE_LENGTH) == size);
+		CHK(memcmp(buffer, expected, size) == 0);
+
+		BString string;
+		CHK(read_snapshot_attr_string(spelling, kShortDescriptionAttr, &string)
+			== B_OK);
+		CHK(string == testDescr);
+
+		size = read_database_attr(testType, kFileExtensionsAttr, buffer, largeSize);
+		CHK(size > 0);
+		BMessage fileMessage;
+		CHK(fileMessage.Unflatten(buffer) == B_OK);
+		BMessage snapshotMessage;
+		CHK(read_snapshot_attr_message(spelling, kFileExtensionsAttr,
+			&snapshotMessage) == B_OK);
+		CHK(snapshotMessage == fileMessage);
+
+		CHK(read_snapshot_attr(spelling, "test:small", buffer, largeSize)
+			== 100);
+		CHK(memcmp(buffer, largeData, 100) == 0);
+
+		CHK(read_snapshot_attr(spelling, "test:missing", buffer, largeSize)
+			== read_database_attr(testType, "test:missing", buffer,
+				largeSize));
+	}
+
+	// types that are not installed
+	NextSubTest();
+	{
+		bool installed = true;
+		CHK(!type_exists(testType1));
+		CHK(snapshot_is_installed(testType1, &installed) == B_OK);
+		CHK(!installed);
+		CHK(read_snapshot_attr(testType1, kShortDescriptionAttr, buffer, largeSize)
+			== B_ENTRY_NOT_FOUND);
+	}
+
+	// attributes larger than 64 KB must be read from the file system
+	NextSubTest();
+	CHK(read_snapshot_attr(testType, "test:large", buffer, largeSize)
+		== kMimeSnapshotMissError);
+	memset(buffer, 0, largeSize);
+	CHK(read_mime_attr(testType, "test:large", buffer, largeSize, B_RAW_TYPE)
+		== (ssize_t)largeSize);
+	CHK(memcmp(buffer, largeData, largeSize) == 0);
+
+	// supporting apps
+	NextSubTest();
+	const char * const appTypes[] = {
+		testType, lowerType.c_str(), testType1, "text", "text/plain",
+		wildcardType, applicationSupertype
+	};
+	for (uint32 i = 0; i < sizeof(appTypes) / sizeof(const char*); i++) {
+		BMessage snapshotApps;
+		BMessage registrarApps;
+		CHK(get_snapshot_supporting_apps(appTypes[i], &snapshotApps) == B_OK);
+		CHK(registrar_supporting_apps(appTypes[i], &registrarApps) == B_OK);
+		CHK(snapshotApps == registrarApps);
+	}
+	{
+		BMessage apps;
+		CHK(get_snapshot_supporting_apps(testType, &apps) == B_OK);
+		bool found = false;
+		const char *signature;
+		for (int32 i = 0; apps.FindString(applicationsField, i, &signature)
+				== B_OK; i++) {
+			if (strcasecmp(signature, testTypeApp) == 0)
+				found = true;
+		}
+		CHK(found);
+	}
+
+	// changes invalidate the snapshot right away
+	NextSubTest();
+	int32 generation = snapshot_generation();
+	CHK(type.SetShortDescription(testDescr2) == B_OK);
+	CHK(snapshot_generation() != generation);
+	{
+		BString string;
+		CHK(read_snapshot_attr_string(testType, kShortDescriptionAttr, &string)
+			== kMimeSnapshotMissError);
+		char description[B_MIME_TYPE_LENGTH];
+		CHK(type.GetShortDescription(description) == B_OK);
+		CHK(strcmp(description, testDescr2) == 0);
+	}
+
+	// ... and a new one with a new generation shows them
+	NextSubTest();
+	generation = snapshot_generation();
+	wait_for_snapshot();
+	CHK(snapshot_generation() != generation);
+	{
+		BString string;
+		CHK(read_snapshot_attr_string(testType, kShortDescriptionAttr, &string)
+			== B_OK);
+		CHK(string == testDescr2);
+	}
+
+	// deleting the type is seen as well
+	NextSubTest();
+	CHK(type.Delete() == B_OK);
+	wait_for_snapshot();
+	{
+		bool installed = true;
+		CHK(snapshot_is_installed(testType, &installed) == B_OK);
+		CHK(installed == type_exists(testType));
+		CHK(!installed);
+	}
+
+	delete[] largeData;
+	delete[] buffer;
+#endif	// !TEST_R5
+}
+
+
 /* KEY:
    + == Tests implemented
    * == Function implemented
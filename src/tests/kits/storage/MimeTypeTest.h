@@ -57,6 +57,7 @@ public:
 	void GetDeviceIconTest();
 	void SnifferRuleTest();
 	void SniffingTest();
+	void SnapshotTest();
 
 	//------------------------------------------------------------
 	// Helper functions
@@ -0,0 +1,361 @@
+/*
+ * Copyright 2011, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Measures how fast the MIME sniffer finds the type of a file, the way the
+	registrar does for every file mimeset is run on: the rules of the MIME
+	database are tried in order of priority on the first bytes of the file,
+	either one by one (Sniffer::Rule), or all at once (Sniffer::RuleSet).
+	The sample files are built from a fixed pseudo random sequence, and the
+	rule that matched each of them goes into the checksum; "rule list" and
+	"rule set" must agree on it.
+*/
+
+
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include <DataIO.h>
+#include <OS.h>
+#include <String.h>
+
+#include <Benchmark.h>
+
+#include <sniffer/Parser.h>
+#include <sniffer/Rule.h>
+#include <sniffer/RuleSet.h>
+
+
+using namespace BPrivate::Storage::Sniffer;
+
+
+struct rule_source {
+	const char*	type;
+	const char*	rule;
+};
+
+// The sniffer rules of the MIME database in src/data/beos_mime
+static const rule_source kRules[] = {
+	{"application/msword",
+		"0.50 (\"\\320\\317\\021\\340\\241\\261\\032\\341\")"},
+	{"application/ogg",
+		"0.50 (\"OggS\")"},
+	{"application/pdf",
+		"0.50          (\"%PDF\")"},
+	{"application/postscript",
+		"0.50 (\"%!PS\")"},
+	{"application/x-7z-compressed",
+		"0.40 (\"\\037\\213\")"},
+	{"application/x-bfs-image",
+		"0.60 [544](\"1SFBEGIB\"|\"1SFBBIGE\")"},
+	{"application/x-bittorrent",
+		"0.50 (\"d8:announce\")"},
+	{"application/x-font-ttf",
+		"0.50 (0x00010000|0x74727565|0x74746366)"},
+	{"application/x-gzip",
+		"0.40 (\"\\037\\213\")"},
+	{"application/x-lharc",
+		"0.40 (\"\\037\\213\")"},
+	{"application/x-rar",
+		"0.50 (\"Rar!\")"},
+	{"application/x-scode-upkg",
+		"0.40 (\"AlB\\032\")"},
+	{"application/x-tar",
+		"0.40 (\"\\037\\213\")"},
+	{"application/x-vnd.be-elfexecutable",
+		"0.90 (0x7f454c46)"},
+	{"application/x-xz",
+		"0.60 (0xfd377a585a00)"},
+	{"application/zip",
+		"0.40 (\"PK\\003\\004\")"},
+	{"audio/ac3",
+		"0.50 (0x0b77)"},
+	{"audio/basic",
+		"0.50 (\".snd\")"},
+	{"audio/ogg",
+		"0.50 (\"OggS\")"},
+	{"audio/x-aiff",
+		"0.50 (\"AIFF\" | \"AIFC\")"},
+	{"audio/x-flac",
+		"0.50 (\"fLaC\")"},
+	{"audio/x-matroska",
+		"0.50 (0x1A45DFA3)"},
+	{"audio/x-musepack",
+		"0.50 (\"MP+\\007\")"},
+	{"audio/x-wav",
+		"0.50 [8] (\"WAV\")"},
+	{"image/bmp",
+		"0.50 (\"BM\")"},
+	{"image/gif",
+		"0.70 (\"GIF8\")"},
+	{"image/jpeg",
+		"0.50 (\"\\377\\330\\377\")"},
+	{"image/png",
+		"0.70 (\"\\211PNG\\015\\012\\032\\012\")"},
+	{"image/sgi",
+		"0.50 (\"\\001\\332\")"},
+	{"image/tiff",
+		"0.50 (\"MM\\000\\052\" | \"II\\052\\000\" | \"IIN1\")"},
+	{"image/vnd.microsoft.icon",
+		"0.50 (\"\\000\\000\\001\\000\" | \"\\000\\000\\002\\000\")"},
+	{"image/webp",
+		"0.50 (\"RIFF????WEBP\" & 0xffffffff00000000ffffffff)"},
+	{"image/x-pcx",
+		"0.5 (\"\\012\\005\\001\") [3](0x01 | 0x04 | 0x08)"},
+	{"image/x-portable-pixmap",
+		"0.50 (\"P6\")"},
+	{"text/calendar",
+		"0.50          ([0]\"BEGIN:VCALENDAR\")"},
+	{"text/html",
+		"0.40  [0:64]( -i \"<HTML\" | \"<HEAD\" | \"<TITLE\" | \"<BODY\" | "
+		"\"<TABLE\" | \"<!--\" | \"<META\" | \"<CENTER\")"},
+	{"text/rtf",
+		"0.50 (\"\\173\\134rtf\")"},
+	{"text/x-patch",
+		"0.30          ([0:100]\"Index: \" | [0:100]\"--- \" | "
+		"[0:100]\"+++ \" | [0:100]\"@@ -\")"},
+	{"text/x-source-code",
+		"0.20          ([0]\"//\" | [0]\"/*\" | [0:32]\"#include\" | "
+		"[0:32]\"#ifndef\" | [0:32]\"#ifdef\")"},
+	{"text/x-url",
+		"0.80 (\"[InternetShortcut]\")"},
+	{"text/x-vcard",
+		"0.50          ([0]\"BEGIN:VCARD\")"},
+	{"text/x-vnd.be.resourcedef",
+		"0.20          ([0]\"//\" | [0]\"/*\" | [0:32]\"#include\" | "
+		"[0:32]\"#ifndef\" | [0:32]\"#ifdef\")"},
+	{"video/dv",
+		"0.50 (0x1f0700)"},
+	{"video/mp2t",
+		"0.30 (0x47)"},
+	{"video/mpeg",
+		"0.50 (\"\\000\\000\\001\\272\" | \"\\000\\000\\001\\263\")"},
+	{"video/ogg",
+		"0.50 (\"OggS\")"},
+	{"video/quicktime",
+		"0.50 ([4]\"mdat\" | [4]\"moov\")"},
+	{"video/x-flv",
+		"0.50 (\"FLV\")"},
+	{"video/x-matroska",
+		"0.50 (0x1A45DFA3)"},
+	{"video/x-ms-asf",
+		"0.50 (\"\\060\\046\\262\\165\")"},
+	{"video/x-msvideo",
+		"0.50 (\"RIFF????AVI \" & 0xffffffff00000000ffffffff)"},
+	{"video/x-rmvb",
+		"0.50 (\".RMF\")"},
+	{NULL, NULL}
+};
+
+// Beginnings of files of common types
+static const struct {
+	const char*	data;
+	size_t		size;
+} kHeaders[] = {
+	{"GIF89a", 6},
+	{"\211PNG\r\n\032\n", 8},
+	{"\377\330\377\340\000\020JFIF", 10},
+	{"%PDF-1.4\n", 9},
+	{"PK\003\004\024\000", 6},
+	{"\177ELF\001\001\001", 7},
+	{"<html>\n<head>\n<title>", 21},
+	{"#!/bin/sh\n", 10},
+	{"/*\n * Copyright", 15},
+	{"#include <stdio.h>\n", 19},
+	{"{\\rtf1\\ansi", 11},
+	{"RIFF\044\010\000\000WAVEfmt ", 16},
+	{"OggS\000\002", 6},
+	{"ID3\003\000", 5},
+	{"Index: src/kits", 15},
+	{"\037\213\010\000", 4},
+};
+
+static const int32 kSampleCount = 256;
+static const size_t kSampleSize = 1024;
+
+
+struct rule_entry {
+	const char*	type;
+	Rule*		rule;
+};
+
+
+static uint32 sRandomSeed;
+static std::vector<rule_entry> sRules;
+static RuleSet sRuleSet;
+static char sSamples[kSampleCount][kSampleSize];
+static size_t sSampleSizes[kSampleCount];
+
+
+static int32
+random_value(int32 max)
+{
+	sRandomSeed = sRandomSeed * 1103515245 + 12345;
+	return (sRandomSeed >> 8) % max;
+}
+
+
+static bool
+compare_rules(const rule_entry& left, const rule_entry& right)
+{
+	// like the registrar's SnifferRules
+	if (left.rule->Priority() != right.rule->Priority())
+		return left.rule->Priority() > right.rule->Priority();
+	return strcmp(left.type, right.type) > 0;
+}
+
+
+static status_t
+parse_rules(std::vector<rule_entry>& rules)
+{
+	for (int32 i = 0; kRules[i].type != NULL; i++) {
+		rule_entry entry;
+		entry.type = kRules[i].type;
+		entry.rule = new Rule;
+
+		BString error;
+		if (parse(kRules[i].rule, entry.rule, &error) != B_OK) {
+			fprintf(stderr, "Could not parse rule of %s:\n%s\n", entry.type,
+				error.String());
+			delete entry.rule;
+			return B_BAD_VALUE;
+		}
+
+		rules.push_back(entry);
+	}
+
+	std::stable_sort(rules.begin(), rules.end(), &compare_rules);
+	return B_OK;
+}
+
+
+static void
+delete_rules(std::vector<rule_entry>& rules)
+{
+	for (size_t i = 0; i < rules.size(); i++)
+		delete rules[i].rule;
+	rules.clear();
+}
+
+
+static void
+build_samples()
+{
+	sRandomSeed = 0x2011;
+
+	for (int32 i = 0; i < kSampleCount; i++) {
+		char* sample = sSamples[i];
+		size_t size = 1 + random_value(kSampleSize);
+
+		// binary or text data
+		bool text = random_value(2) == 0;
+		for (size_t j = 0; j < size; j++) {
+			sample[j] = text
+				? "etaoin shrdlu\n"[random_value(14)] : random_value(256);
+		}
+
+		// most files start with a known header
+		if (random_value(4) != 0) {
+			int32 index = random_value(sizeof(kHeaders) / sizeof(kHeaders[0]));
+			size_t headerSize = std::min(kHeaders[index].size, size);
+			memcpy(sample, kHeaders[index].data, headerSize);
+		}
+
+		sSampleSizes[i] = size;
+	}
+}
+
+
+// #pragma mark - tests
+
+
+static uint32
+test_parse(int32 /*iteration*/)
+{
+	std::vector<rule_entry> rules;
+	if (parse_rules(rules) != B_OK)
+		return 0;
+
+	uint32 count = rules.size();
+	delete_rules(rules);
+	return count;
+}
+
+
+static uint32
+test_compile(int32 /*iteration*/)
+{
+	RuleSet ruleSet;
+	for (size_t i = 0; i < sRules.size(); i++) {
+		if (ruleSet.AddRule(sRules[i].rule) != B_OK)
+			return 0;
+	}
+
+	return ruleSet.CountRules();
+}
+
+
+static uint32
+test_rule_list(int32 iteration)
+{
+	int32 sample = iteration % kSampleCount;
+	BMemoryIO data(sSamples[sample], sSampleSizes[sample]);
+
+	for (size_t i = 0; i < sRules.size(); i++) {
+		if (sRules[i].rule->Sniff(&data))
+			return i + 1;
+	}
+
+	return 0;
+}
+
+
+static uint32
+test_rule_set(int32 iteration)
+{
+	int32 sample = iteration % kSampleCount;
+	return sRuleSet.Match(sSamples[sample], sSampleSizes[sample]) + 1;
+}
+
+
+// #pragma mark -
+
+
+static const benchmark_test kTests[] = {
+	{"parse", &test_parse, 200},
+	{"compile", &test_compile, 200},
+	{"rule list", &test_rule_list, 20000},
+	{"rule set", &test_rule_set, 200000},
+	{NULL, NULL, 0}
+};
+
+
+int
+main(int argc, char** argv)
+{
+	Benchmark benchmark("sniffer_benchmark", kTests, argc, argv);
+
+	if (parse_rules(sRules) != B_OK)
+		return 1;
+	for (size_t i = 0; i < sRules.size(); i++) {
+		if (sRuleSet.AddRule(sRules[i].rule) != B_OK) {
+			fprintf(stderr, "Could not compile the rules\n");
+			return 1;
+		}
+	}
+
+	build_samples();
+
+	// only the first pass over the samples counts, so that the checksum
+	// doesn't depend on the number of iterations
+	benchmark.SetChecksumIterations(kSampleCount);
+	benchmark.Run();
+
+	delete_rules(sRules);
+	return 0;
+}
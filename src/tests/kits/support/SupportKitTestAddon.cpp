@@ -4,6 +4,7 @@
 // ##### Include headers for your tests here #####
 #include "barchivable/ArchivableTest.h"
 #include "bautolock/AutolockTest.h"
+#include "bdataio/DataIOTest.h"
 #include "blocker/LockerTest.h"
 #include "bmemoryio/MemoryIOTest.h"
 #include "bmemoryio/MallocIOTest.h"
@@ -20,6 +21,7 @@ getTestSuite()
 	// ##### Add test suites here #####
 	suite->addTest("BArchivable", ArchivableTestSuite());
 	suite->addTest("BAutolock", AutolockTestSuite());
+	suite->addTest("BDataIO", DataIOTestSuite());
 	suite->addTest("BLocker", LockerTestSuite());
 	suite->addTest("BMemoryIO", MemoryIOTestSuite());
 	suite->addTest("BMallocIO", MallocIOTestSuite());
@@ -0,0 +1,213 @@
+#include "AsyncReadTest.h"
+#include "cppunit/TestCaller.h"
+#include "cppunit/TestSuite.h"
+#include <AsyncIOQueue.h>
+#include <BufferedDataIO.h>
+#include <DataIO.h>
+#include <OS.h>
+#include <string.h>
+
+
+// AsyncIOQueue lets its workers go after they have been idle for this long
+static const bigtime_t kWorkerIdleTimeout = 5000000;
+static const bigtime_t kCompletionTimeout = 5000000;
+
+
+// A stream that takes its time, so that reads pile up in the queue.
+class SlowDataIO : public BDataIO {
+public:
+	virtual ssize_t Read(void *buffer, size_t size)
+	{
+		snooze(50000);
+		memset(buffer, 'x', size);
+		return size;
+	}
+
+	virtual ssize_t Write(const void *buffer, size_t size)
+	{
+		return B_NOT_SUPPORTED;
+	}
+};
+
+
+struct async_read {
+	sem_id		done;
+	thread_id	thread;
+	ssize_t		result;
+};
+
+
+static void
+completion_hook(void *cookie, ssize_t result)
+{
+	async_read *read = (async_read *)cookie;
+	read->thread = find_thread(NULL);
+	read->result = result;
+	release_sem(read->done);
+}
+
+
+static status_t
+wait_for_completion(async_read &read)
+{
+	return acquire_sem_etc(read.done, 1, B_RELATIVE_TIMEOUT,
+		kCompletionTimeout);
+}
+
+
+static int32
+count_workers()
+{
+	int32 count = 0;
+	int32 cookie = 0;
+	thread_info info;
+	while (get_next_thread_info(0, &cookie, &info) == B_OK) {
+		if (strcmp(info.name, "async i/o worker") == 0)
+			count++;
+	}
+	return count;
+}
+
+
+AsyncReadTest::AsyncReadTest(std::string name) :
+		BTestCase(name)
+{
+}
+
+
+AsyncReadTest::~AsyncReadTest()
+{
+}
+
+
+void
+AsyncReadTest::BufferedReadTest(void)
+{
+	char data[2048];
+	for (int32 i = 0; i < (int32)sizeof(data); i++)
+		data[i] = (char)i;
+
+	BMemoryIO stream(data, sizeof(data));
+	BBufferedDataIO buffered(stream, 512, false);
+	CPPUNIT_ASSERT(buffered.InitCheck() == B_OK);
+
+	char buffer[512];
+	async_read read;
+	read.done = create_sem(0, "async read");
+	CPPUNIT_ASSERT(read.done >= B_OK);
+
+	// fill the buffer
+	NextSubTest();
+	CPPUNIT_ASSERT(buffered.Read(buffer, 10) == 10);
+	CPPUNIT_ASSERT(memcmp(buffer, data, 10) == 0);
+
+	// the data is in the buffer, the read completes right away
+	NextSubTest();
+	read.thread = -1;
+	CPPUNIT_ASSERT(buffered.ReadAsync(buffer, 100, &completion_hook, &read)
+		== B_OK);
+	CPPUNIT_ASSERT(read.thread == find_thread(NULL));
+	CPPUNIT_ASSERT(acquire_sem_etc(read.done, 1, B_RELATIVE_TIMEOUT, 0)
+		== B_OK);
+	CPPUNIT_ASSERT(read.result == 100);
+	CPPUNIT_ASSERT(memcmp(buffer, data + 10, 100) == 0);
+
+	// the buffer has to be refilled, a worker does that
+	NextSubTest();
+	read.thread = -1;
+	CPPUNIT_ASSERT(buffered.ReadAsync(buffer, 450, &completion_hook, &read)
+		== B_OK);
+	CPPUNIT_ASSERT(wait_for_completion(read) == B_OK);
+	CPPUNIT_ASSERT(read.thread >= 0);
+	CPPUNIT_ASSERT(read.thread != find_thread(NULL));
+	CPPUNIT_ASSERT(read.result == 450);
+	CPPUNIT_ASSERT(memcmp(buffer, data + 110, 450) == 0);
+
+	// the stream is where it should be afterwards
+	NextSubTest();
+	CPPUNIT_ASSERT(buffered.Read(buffer, 10) == 10);
+	CPPUNIT_ASSERT(memcmp(buffer, data + 560, 10) == 0);
+
+	// bad arguments
+	NextSubTest();
+	CPPUNIT_ASSERT(buffered.ReadAsync(NULL, 10, &completion_hook, &read)
+		== B_BAD_VALUE);
+	CPPUNIT_ASSERT(buffered.ReadAsync(buffer, 10, NULL, NULL) == B_BAD_VALUE);
+
+	delete_sem(read.done);
+}
+
+
+void
+AsyncReadTest::WorkerTest(void)
+{
+	SlowDataIO stream;
+	char buffer[16];
+	async_read read;
+	read.done = create_sem(0, "async read");
+	CPPUNIT_ASSERT(read.done >= B_OK);
+
+	// a worker is spawned for the first read
+	NextSubTest();
+	CPPUNIT_ASSERT(AsyncIOQueue::QueueRead(&stream, buffer, sizeof(buffer),
+		&completion_hook, &read) == B_OK);
+	CPPUNIT_ASSERT(wait_for_completion(read) == B_OK);
+	CPPUNIT_ASSERT(read.result == sizeof(buffer));
+	CPPUNIT_ASSERT(count_workers() >= 1);
+
+	// and goes away when there is nothing to do
+	NextSubTest();
+	snooze(kWorkerIdleTimeout + 1000000);
+	CPPUNIT_ASSERT(count_workers() == 0);
+
+	// a new one is spawned for the next read
+	NextSubTest();
+	read.result = 0;
+	CPPUNIT_ASSERT(AsyncIOQueue::QueueRead(&stream, buffer, sizeof(buffer),
+		&completion_hook, &read) == B_OK);
+	CPPUNIT_ASSERT(wait_for_completion(read) == B_OK);
+	CPPUNIT_ASSERT(read.result == sizeof(buffer));
+	CPPUNIT_ASSERT(read.thread != find_thread(NULL));
+	CPPUNIT_ASSERT(count_workers() == 1);
+
+	// many reads share a few workers, and all of them complete
+	NextSubTest();
+	const int32 kReadCount = 16;
+	char buffers[kReadCount][16];
+	async_read reads[kReadCount];
+	for (int32 i = 0; i < kReadCount; i++) {
+		reads[i].done = read.done;
+		reads[i].result = 0;
+		CPPUNIT_ASSERT(AsyncIOQueue::QueueRead(&stream, buffers[i],
+			sizeof(buffers[i]), &completion_hook, &reads[i]) == B_OK);
+	}
+	CPPUNIT_ASSERT(count_workers() <= 4);
+	for (int32 i = 0; i < kReadCount; i++)
+		CPPUNIT_ASSERT(wait_for_completion(read) == B_OK);
+	for (int32 i = 0; i < kReadCount; i++)
+		CPPUNIT_ASSERT(reads[i].result == sizeof(buffers[i]));
+	CPPUNIT_ASSERT(count_workers() <= 4);
+
+	// bad arguments
+	NextSubTest();
+	CPPUNIT_ASSERT(AsyncIOQueue::QueueRead(NULL, buffer, sizeof(buffer),
+		&completion_hook, &read) == B_BAD_VALUE);
+	CPPUNIT_ASSERT(AsyncIOQueue::QueueRead(&stream, buffer, sizeof(buffer),
+		NULL, NULL) == B_BAD_VALUE);
+
+	delete_sem(read.done);
+}
+
+
+CppUnit::Test *AsyncReadTest::suite(void)
+{
+	CppUnit::TestSuite *suite = new CppUnit::TestSuite();
+	typedef CppUnit::TestCaller<AsyncReadTest> TC;
+
+	suite->addTest(new TC("BBufferedDataIO::ReadAsync Test",
+		&AsyncReadTest::BufferedReadTest));
+	suite->addTest(new TC("AsyncIOQueue::Worker Test",
+		&AsyncReadTest::WorkerTest));
+
+	return suite;
+}
@@ -0,0 +1,18 @@
+#ifndef AsyncReadTest_H
+#define AsyncReadTest_H
+
+#include "TestCase.h"
+#include <DataIO.h>
+
+
+class AsyncReadTest : public BTestCase
+{
+public:
+	static Test *suite(void);
+	void BufferedReadTest(void);
+	void WorkerTest(void);
+	AsyncReadTest(std::string name = "");
+	virtual ~AsyncReadTest();
+};
+
+#endif
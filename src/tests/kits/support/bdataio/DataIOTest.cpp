@@ -0,0 +1,15 @@
+#include "cppunit/Test.h"
+#include "cppunit/TestSuite.h"
+#include "DataIOTest.h"
+#include "PositionIOTest.h"
+#include "AsyncReadTest.h"
+
+CppUnit::Test *DataIOTestSuite()
+{
+	CppUnit::TestSuite *testSuite = new CppUnit::TestSuite();
+
+	testSuite->addTest(PositionIOTest::suite());
+	testSuite->addTest(AsyncReadTest::suite());
+
+	return(testSuite);
+}
@@ -0,0 +1,8 @@
+#ifndef _dataio_test_h_
+#define _dataio_test_h_
+
+class CppUnit::Test;
+
+CppUnit::Test *DataIOTestSuite();
+
+#endif	// _dataio_test_h_
@@ -0,0 +1,215 @@
+#include "PositionIOTest.h"
+#include "cppunit/TestCaller.h"
+#include <DataIO.h>
+#include <OS.h>
+#include <string.h>
+#include <sys/uio.h>
+
+
+// A BPositionIO that only implements the required methods, so that it
+// gets the default implementations of all others. Reads and writes at or
+// beyond kErrorPosition fail.
+class PlainPositionIO : public BPositionIO {
+public:
+	static const off_t kErrorPosition = 48;
+
+	PlainPositionIO()
+		:
+		fPosition(0),
+		fLength(32),
+		fReadCount(0)
+	{
+		for (int32 i = 0; i < (int32)sizeof(fData); i++)
+			fData[i] = 'a' + i % 26;
+	}
+
+	virtual ssize_t ReadAt(off_t position, void *buffer, size_t size)
+	{
+		fReadCount++;
+		if (position >= kErrorPosition)
+			return B_IO_ERROR;
+		if (position >= fLength)
+			return 0;
+		if (position + (off_t)size > fLength)
+			size = fLength - position;
+		memcpy(buffer, fData + position, size);
+		return size;
+	}
+
+	virtual ssize_t WriteAt(off_t position, const void *buffer, size_t size)
+	{
+		if (position >= kErrorPosition)
+			return B_IO_ERROR;
+		if (position + (off_t)size > kErrorPosition)
+			size = kErrorPosition - position;
+		memcpy(fData + position, buffer, size);
+		if (position + (off_t)size > fLength)
+			fLength = position + size;
+		return size;
+	}
+
+	virtual off_t Seek(off_t position, uint32 seekMode)
+	{
+		if (seekMode == SEEK_SET)
+			fPosition = position;
+		else if (seekMode == SEEK_CUR)
+			fPosition += position;
+		else
+			fPosition = fLength + position;
+		return fPosition;
+	}
+
+	virtual off_t Position() const
+	{
+		return fPosition;
+	}
+
+	char	fData[kErrorPosition];
+	off_t	fPosition;
+	off_t	fLength;
+	int32	fReadCount;
+};
+
+
+struct hook_result {
+	int32		calls;
+	thread_id	thread;
+	ssize_t		result;
+};
+
+
+static void
+completion_hook(void *cookie, ssize_t result)
+{
+	hook_result *hookResult = (hook_result *)cookie;
+	hookResult->calls++;
+	hookResult->thread = find_thread(NULL);
+	hookResult->result = result;
+}
+
+
+PositionIOTest::PositionIOTest(std::string name) :
+		BTestCase(name)
+{
+}
+
+
+PositionIOTest::~PositionIOTest()
+{
+}
+
+
+void
+PositionIOTest::PerformTest(void)
+{
+	PlainPositionIO io;
+	char buf1[8];
+	char buf2[8];
+	char buf3[8];
+	iovec vecs[3] = {
+		{ buf1, sizeof(buf1) },
+		{ buf2, sizeof(buf2) },
+		{ buf3, sizeof(buf3) }
+	};
+	ssize_t err;
+
+	// ReadAtV() fills all buffers
+	NextSubTest();
+	io.Seek(5, SEEK_SET);
+	err = io.ReadAtV(2, vecs, 3);
+	CPPUNIT_ASSERT(err == 24);
+	CPPUNIT_ASSERT(memcmp(buf1, io.fData + 2, 8) == 0);
+	CPPUNIT_ASSERT(memcmp(buf2, io.fData + 10, 8) == 0);
+	CPPUNIT_ASSERT(memcmp(buf3, io.fData + 18, 8) == 0);
+	CPPUNIT_ASSERT(io.Position() == 5);
+
+	// ReadAtV() stops at the first buffer that could not be filled
+	NextSubTest();
+	io.fReadCount = 0;
+	memset(buf3, 0, sizeof(buf3));
+	err = io.ReadAtV(20, vecs, 3);
+	CPPUNIT_ASSERT(err == 12);
+	CPPUNIT_ASSERT(memcmp(buf1, io.fData + 20, 8) == 0);
+	CPPUNIT_ASSERT(memcmp(buf2, io.fData + 28, 4) == 0);
+	CPPUNIT_ASSERT(io.fReadCount == 2);
+	CPPUNIT_ASSERT(buf3[0] == 0);
+
+	// ReadAtV() returns an error only if nothing could be read
+	NextSubTest();
+	io.fLength = PlainPositionIO::kErrorPosition;
+	err = io.ReadAtV(PlainPositionIO::kErrorPosition, vecs, 3);
+	CPPUNIT_ASSERT(err == B_IO_ERROR);
+	err = io.ReadAtV(PlainPositionIO::kErrorPosition - 8, vecs, 3);
+	CPPUNIT_ASSERT(err == 8);
+	io.fLength = 32;
+
+	// WriteAtV() writes all buffers in order
+	NextSubTest();
+	memcpy(buf1, "ABCDEFGH", 8);
+	memcpy(buf2, "IJKLMNOP", 8);
+	memcpy(buf3, "QRSTUVWX", 8);
+	err = io.WriteAtV(4, vecs, 3);
+	CPPUNIT_ASSERT(err == 24);
+	CPPUNIT_ASSERT(memcmp(io.fData + 4, "ABCDEFGHIJKLMNOPQRSTUVWX", 24) == 0);
+	CPPUNIT_ASSERT(io.Position() == 5);
+
+	// WriteAtV() stops at a short write, and fails only if nothing could
+	// be written
+	NextSubTest();
+	err = io.WriteAtV(PlainPositionIO::kErrorPosition - 12, vecs, 3);
+	CPPUNIT_ASSERT(err == 12);
+	CPPUNIT_ASSERT(memcmp(io.fData + PlainPositionIO::kErrorPosition - 12,
+		"ABCDEFGHIJKL", 12) == 0);
+	err = io.WriteAtV(PlainPositionIO::kErrorPosition, vecs, 3);
+	CPPUNIT_ASSERT(err == B_IO_ERROR);
+
+	// bad arguments
+	NextSubTest();
+	CPPUNIT_ASSERT(io.ReadAtV(0, NULL, 3) == B_BAD_VALUE);
+	CPPUNIT_ASSERT(io.ReadAtV(-1, vecs, 3) == B_BAD_VALUE);
+	CPPUNIT_ASSERT(io.WriteAtV(0, NULL, 3) == B_BAD_VALUE);
+	CPPUNIT_ASSERT(io.WriteAtV(-1, vecs, 3) == B_BAD_VALUE);
+	CPPUNIT_ASSERT(io.ReadAtV(0, vecs, 0) == 0);
+
+	// ReadAtAsync() completes before it returns, in the calling thread
+	NextSubTest();
+	hook_result hookResult = { 0, -1, 0 };
+	CPPUNIT_ASSERT(io.ReadAtAsync(10, buf1, 8, &completion_hook, &hookResult)
+		== B_OK);
+	CPPUNIT_ASSERT(hookResult.calls == 1);
+	CPPUNIT_ASSERT(hookResult.thread == find_thread(NULL));
+	CPPUNIT_ASSERT(hookResult.result == 8);
+	CPPUNIT_ASSERT(memcmp(buf1, io.fData + 10, 8) == 0);
+	CPPUNIT_ASSERT(io.Position() == 5);
+
+	// the hook gets errors, too
+	NextSubTest();
+	hookResult.calls = 0;
+	CPPUNIT_ASSERT(io.ReadAtAsync(PlainPositionIO::kErrorPosition, buf1, 8,
+		&completion_hook, &hookResult) == B_OK);
+	CPPUNIT_ASSERT(hookResult.calls == 1);
+	CPPUNIT_ASSERT(hookResult.result == B_IO_ERROR);
+	CPPUNIT_ASSERT(io.ReadAtAsync(0, buf1, 8, NULL, NULL) == B_BAD_VALUE);
+
+	// BDataIO::ReadAsync() reads at the current position the same way
+	NextSubTest();
+	hookResult.calls = 0;
+	CPPUNIT_ASSERT(io.ReadAsync(buf1, 8, &completion_hook, &hookResult)
+		== B_OK);
+	CPPUNIT_ASSERT(hookResult.calls == 1);
+	CPPUNIT_ASSERT(hookResult.thread == find_thread(NULL));
+	CPPUNIT_ASSERT(hookResult.result == 8);
+	CPPUNIT_ASSERT(memcmp(buf1, io.fData + 5, 8) == 0);
+	CPPUNIT_ASSERT(io.Position() == 13);
+	CPPUNIT_ASSERT(io.ReadAsync(buf1, 8, NULL, NULL) == B_BAD_VALUE);
+}
+
+
+CppUnit::Test *PositionIOTest::suite(void)
+{
+	typedef CppUnit::TestCaller<PositionIOTest>
+		PositionIOTestCaller;
+
+	return(new PositionIOTestCaller("BPositionIO::Default Implementations Test",
+		&PositionIOTest::PerformTest));
+}
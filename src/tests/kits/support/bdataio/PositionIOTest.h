@@ -0,0 +1,17 @@
+#ifndef PositionIOTest_H
+#define PositionIOTest_H
+
+#include "TestCase.h"
+#include <DataIO.h>
+
+
+class PositionIOTest : public BTestCase
+{
+public:
+	static Test *suite(void);
+	void PerformTest(void);
+	PositionIOTest(std::string name = "");
+	virtual ~PositionIOTest();
+};
+
+#endif
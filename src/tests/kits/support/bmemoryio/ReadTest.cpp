@@ -3,6 +3,7 @@
 #include <DataIO.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/uio.h>
 
 ReadTest::ReadTest(std::string name) :
 		BTestCase(name)
@@ -46,7 +47,19 @@ ReadTest::PerformTest(void)
 	err = mem.Read(readBuf, 10);
 	CPPUNIT_ASSERT(err == 0);
 	CPPUNIT_ASSERT(mem.Position() == pos);
-	
+
+	NextSubTest();
+	char vecBuf[6];
+	iovec vecs[2] = {
+		{ readBuf, 4 },
+		{ vecBuf, 6 }
+	};
+	pos = mem.Position();
+	err = mem.ReadAtV(12, vecs, 2);
+	CPPUNIT_ASSERT(err == 8);
+	CPPUNIT_ASSERT(strncmp(readBuf, buf + 12, 4) == 0);
+	CPPUNIT_ASSERT(strncmp(vecBuf, buf + 16, 4) == 0);
+	CPPUNIT_ASSERT(mem.Position() == pos);
 }
 
 
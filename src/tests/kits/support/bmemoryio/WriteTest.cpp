@@ -3,6 +3,7 @@
 #include <DataIO.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/uio.h>
 
 WriteTest::WriteTest(std::string name) :
 		BTestCase(name)
@@ -50,6 +51,24 @@ WriteTest::PerformTest(void)
 	CPPUNIT_ASSERT(strncmp(buf + 9, writeBuf, 1) == 0);
 	CPPUNIT_ASSERT(mem.Position() == pos);
 
+	NextSubTest();
+	memset(buf, 0, 10);
+	pos = mem.Position();
+	iovec vecs[2] = {
+		{ (void*)writeBuf, 3 },
+		{ (void*)(writeBuf + 4), 3 }
+	};
+	err = mem.WriteAtV(1, vecs, 2);
+	CPPUNIT_ASSERT(err == 6);
+	CPPUNIT_ASSERT(strcmp(buf + 1, "ABCEFG") == 0);
+	CPPUNIT_ASSERT(mem.Position() == pos);
+
+	NextSubTest();
+	memset(buf, 0, 10);
+	err = mem.WriteAtV(6, vecs, 2);
+	CPPUNIT_ASSERT(err == 4);
+	CPPUNIT_ASSERT(strncmp(buf + 6, "ABCE", 4) == 0);
+
 	NextSubTest();
 	memset(buf, 0, 10);
 	pos = mem.Position();
@@ -64,7 +64,31 @@ StringRemoveTest::PerformTest(void)
 	CPPUNIT_ASSERT(strcmp(string1->String(), "") == 0);
 	CPPUNIT_ASSERT(string1->Length() == 0);
 	delete string1;
-	
+
+#ifndef TEST_R5
+	//growing again after a lazy truncation
+	NextSubTest();
+	string1 = new BString("This is a long string");
+	string1->Truncate(4, true);
+	string1->Append(" is longer than before");
+	CPPUNIT_ASSERT(strcmp(string1->String(), "This is longer than before") == 0);
+	CPPUNIT_ASSERT(string1->Length() == 26);
+	delete string1;
+
+	//truncating a shared string
+	NextSubTest();
+	string1 = new BString("This is a long string");
+	string2 = new BString(*string1);
+	string2->Truncate(4);
+	CPPUNIT_ASSERT(strcmp(string2->String(), "This") == 0);
+	string2->Truncate(0);
+	CPPUNIT_ASSERT(strcmp(string2->String(), "") == 0);
+	CPPUNIT_ASSERT(string2->Length() == 0);
+	CPPUNIT_ASSERT(strcmp(string1->String(), "This is a long string") == 0);
+	delete string1;
+	delete string2;
+#endif
+
 	//Remove(int32 from, int32 length)
 	NextSubTest();
 	string1 = new BString("a String");
@@ -0,0 +1,172 @@
+/*
+ * Copyright 2011, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+// Checks that SmallString and StringView behave like the BString methods they
+// mirror, in particular when a string moves out of its inline buffer, or is
+// changed through a view of itself.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <String.h>
+
+#include <SmallString.h>
+
+
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, \
+				__LINE__, #condition); \
+			exit(1); \
+		} \
+	} while (false)
+
+
+static void
+expect(const SmallString& string, const char* expected)
+{
+	CHECK(string.Length() == (int32)strlen(expected));
+	CHECK(strcmp(string.String(), expected) == 0);
+}
+
+
+static void
+test_inline_and_heap()
+{
+	SmallString string;
+	expect(string, "");
+	CHECK(string.IsInline());
+
+	string = "short";
+	expect(string, "short");
+	CHECK(string.IsInline());
+
+	// grows out of the inline buffer
+	string << " and then a lot longer than that";
+	expect(string, "short and then a lot longer than that");
+	CHECK(!string.IsInline());
+
+	// keeps its buffer when cut back
+	const char* buffer = string.String();
+	string.Truncate(5);
+	expect(string, "short");
+	string << '!';
+	expect(string, "short!");
+	CHECK(string.String() == buffer);
+
+	SmallString copy(string);
+	expect(copy, "short!");
+	CHECK(copy.IsInline());
+
+	SmallString target;
+	SmallString source("a string that is too long to be inline");
+	buffer = source.String();
+	target.Adopt(source);
+	expect(target, "a string that is too long to be inline");
+	CHECK(target.String() == buffer);
+	expect(source, "");
+	CHECK(source.IsInline());
+
+	source = "inline";
+	target.Adopt(source);
+	expect(target, "inline");
+	expect(source, "");
+
+	printf("inline and heap: ok\n");
+}
+
+
+static void
+test_self_views()
+{
+	SmallString string("abcdefghij");
+
+	// appending a view of itself that makes it leave the inline buffer
+	string.Append(string.View());
+	expect(string, "abcdefghijabcdefghij");
+	string.Append(string.Substring(5, 10));
+	expect(string, "abcdefghijabcdefghijfghijabcde");
+
+	string.SetTo(string.Substring(10, 5));
+	expect(string, "abcde");
+
+	string = "  padded  ";
+	string.Trim();
+	expect(string, "padded");
+
+	char* data = string.LockBuffer(40);
+	CHECK(data != NULL);
+	strcpy(data, "written through the buffer, and long");
+	string.UnlockBuffer();
+	expect(string, "written through the buffer, and long");
+
+	printf("self views: ok\n");
+}
+
+
+static void
+test_like_bstring()
+{
+	const char* kStrings[] = {
+		"", "a", "Subject: Hello", "  spaces  ", "Content-Type: text/plain",
+		"a string that is too long to fit into the inline buffer"
+	};
+	const int32 kStringCount = sizeof(kStrings) / sizeof(kStrings[0]);
+
+	for (int32 i = 0; i < kStringCount; i++) {
+		BString bstring(kStrings[i]);
+		SmallString string(kStrings[i]);
+		StringView view(bstring);
+
+		CHECK(string == view);
+		CHECK(string.FindFirst(':') == bstring.FindFirst(':'));
+		CHECK(string.FindFirst("t") == bstring.FindFirst("t"));
+		CHECK(string.FindFirst("t", 3) == bstring.FindFirst("t", 3));
+		CHECK(view.FindFirst("zz") == B_ERROR);
+
+		for (int32 j = 0; j < kStringCount; j++) {
+			BString other(kStrings[j]);
+			CHECK((string.Compare(other) < 0) == (bstring.Compare(other) < 0));
+			CHECK((string.Compare(other) == 0)
+				== (bstring.Compare(other) == 0));
+			CHECK((string.ICompare(other) == 0)
+				== (bstring.ICompare(other) == 0));
+		}
+
+		// BString expects the offset to be within the string
+		int32 offset = bstring.Length() / 2;
+		BString bcopy;
+		SmallString copy;
+		bstring.CopyInto(bcopy, offset, 7);
+		string.CopyInto(copy, offset, 7);
+		expect(copy, bcopy.String());
+
+		bstring.Trim();
+		string.Trim();
+		expect(string, bstring.String());
+		CHECK(StringView(kStrings[i]).Trim() == bstring);
+	}
+
+	CHECK(StringView("SUBJECT").ICompare("subject") == 0);
+	CHECK(StringView("abc").Substring(1) == "bc");
+	CHECK(StringView("abc").Substring(5).IsEmpty());
+	CHECK(StringView(NULL).IsEmpty());
+
+	printf("like BString: ok\n");
+}
+
+
+int
+main()
+{
+	test_inline_and_heap();
+	test_self_views();
+	test_like_bstring();
+
+	printf("All tests passed.\n");
+	return 0;
+}
@@ -0,0 +1,355 @@
+/*
+ * Copyright 2011, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+// Runs BString through some operations typical for Tracker and Mail, and
+// prints how long they took and how many heap allocations they needed. Each
+// test is repeated with SmallString and StringView, which must compute the
+// same checksum.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <image.h>
+#include <OS.h>
+#include <String.h>
+
+#include <SmallString.h>
+
+#include <Benchmark.h>
+
+
+// #pragma mark - allocation counting
+
+
+typedef void* (*malloc_function)(size_t size);
+typedef void* (*realloc_function)(void* address, size_t size);
+typedef void* (*calloc_function)(size_t count, size_t size);
+
+static malloc_function sMalloc;
+static realloc_function sRealloc;
+static calloc_function sCalloc;
+
+static int64 sAllocations = 0;
+
+
+#ifdef __HAIKU__
+
+static void
+resolve_allocator()
+{
+	image_info info;
+	int32 cookie = 0;
+	while (get_next_image_info(B_CURRENT_TEAM, &cookie, &info) == B_OK) {
+		if (strstr(info.name, "libroot.so") == NULL)
+			continue;
+
+		get_image_symbol(info.id, "malloc", B_SYMBOL_TYPE_TEXT,
+			(void**)&sMalloc);
+		get_image_symbol(info.id, "realloc", B_SYMBOL_TYPE_TEXT,
+			(void**)&sRealloc);
+		get_image_symbol(info.id, "calloc", B_SYMBOL_TYPE_TEXT,
+			(void**)&sCalloc);
+		break;
+	}
+
+	if (sMalloc == NULL || sRealloc == NULL || sCalloc == NULL)
+		debugger("string_benchmark: could not find libroot's allocator");
+}
+
+#else	// !__HAIKU__
+
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_realloc(void* address, size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+
+static void
+resolve_allocator()
+{
+	sMalloc = &__libc_malloc;
+	sRealloc = &__libc_realloc;
+	sCalloc = &__libc_calloc;
+}
+
+#endif	// !__HAIKU__
+
+
+extern "C" void*
+malloc(size_t size)
+{
+	if (sMalloc == NULL)
+		resolve_allocator();
+	sAllocations++;
+	return sMalloc(size);
+}
+
+
+extern "C" void*
+realloc(void* address, size_t size)
+{
+	if (sRealloc == NULL)
+		resolve_allocator();
+	sAllocations++;
+	return sRealloc(address, size);
+}
+
+
+extern "C" void*
+calloc(size_t count, size_t size)
+{
+	if (sCalloc == NULL)
+		resolve_allocator();
+	sAllocations++;
+	return sCalloc(count, size);
+}
+
+
+static int64
+allocation_count()
+{
+	return sAllocations;
+}
+
+
+// #pragma mark - test data
+
+
+static const char* kNames[] = {
+	"Desktop", "home", "config", "settings", "Tracker", "Mail", "mail",
+	"in", "out", "draft", "README", "ReadMe.txt", "a", "", "Makefile",
+	"DSC_0001.JPG", "Haiku-R1-alpha3.iso", "very long file name that most "
+		"certainly won't fit into any small buffer.txt"
+};
+static const int32 kNameCount = sizeof(kNames) / sizeof(kNames[0]);
+
+static const char* kHeaders[] = {
+	"From: Someone <someone@example.com>",
+	"To: haiku-development@freelists.org",
+	"Subject:    Re: [haiku-development] BString performance   ",
+	"Date: Mon, 14 Nov 2011 20:41:03 +0100",
+	"Message-ID: <4EC16F7F.3010708@example.com>",
+	"MIME-Version: 1.0",
+	"Content-Type: text/plain; charset=UTF-8",
+	"Content-Transfer-Encoding: 8bit",
+	"X-Mailer: Haiku Mail",
+	"Reply-To:",
+};
+static const int32 kHeaderCount = sizeof(kHeaders) / sizeof(kHeaders[0]);
+
+static const char* kDirectory = "/boot/home/config/settings";
+
+// the strings that are reused from one iteration to the next
+static BString sField;
+static BString sValue;
+static BString sCopy;
+static BString sTarget;
+static SmallString sSmallCopy;
+static SmallString sSmallTarget;
+
+
+// #pragma mark - BString
+
+
+// Default constructed strings, and strings set to empty ones, like the
+// members of Tracker's Models and Mail's message objects.
+static uint32
+test_empty(int32 iteration)
+{
+	BString name;
+	BString type("");
+	BString copy(name);
+	return name.Length() + type.Length() + copy.Length();
+}
+
+
+// Builds the paths of the entries of a directory in one string, cutting it
+// back to the directory for each entry.
+static uint32
+test_paths(int32 iteration)
+{
+	uint32 result = 0;
+	BString path(kDirectory);
+	int32 directoryLength = path.Length();
+
+	for (int32 i = 0; i < kNameCount; i++) {
+		path.Truncate(directoryLength);
+		path << '/' << kNames[i];
+		result += path.Length();
+	}
+	return result;
+}
+
+
+// Splits mail header lines into trimmed fields and values.
+static uint32
+test_headers(int32 iteration)
+{
+	uint32 result = 0;
+	for (int32 i = 0; i < kHeaderCount; i++) {
+		BString line(kHeaders[i]);
+		int32 colon = line.FindFirst(':');
+		if (colon < 0)
+			continue;
+
+		line.CopyInto(sField, 0, colon);
+		line.CopyInto(sValue, colon + 1, line.Length() - colon - 1);
+		sValue.Trim();
+
+		if (sField.ICompare("subject") == 0)
+			result += sValue.Length();
+		result += sField.Length();
+	}
+	return result;
+}
+
+
+// Copies of whole strings, through the substring methods.
+static uint32
+test_copies(int32 iteration)
+{
+	uint32 result = 0;
+	for (int32 i = 0; i < kNameCount; i++) {
+		BString name(kNames[i]);
+		name.CopyInto(sCopy, 0, name.Length());
+		result += sCopy.Length();
+
+		sCopy.SetTo(name, name.Length() + 10);
+		result += sCopy.Length();
+	}
+	return result;
+}
+
+
+// Hands strings over, and clears copies of shared strings.
+static uint32
+test_adopt(int32 iteration)
+{
+	uint32 result = 0;
+	for (int32 i = 0; i < kNameCount; i++) {
+		BString source(kNames[i]);
+		sTarget.Adopt(source);
+		result += sTarget.Length() + source.Length();
+
+		BString copy(sTarget);
+		copy.Truncate(0);
+		copy = "";
+		result += copy.Length();
+	}
+	return result;
+}
+
+
+// #pragma mark - SmallString and StringView
+
+
+static uint32
+test_empty_small(int32 iteration)
+{
+	SmallString name;
+	SmallString type("");
+	SmallString copy(name);
+	return name.Length() + type.Length() + copy.Length();
+}
+
+
+static uint32
+test_paths_small(int32 iteration)
+{
+	uint32 result = 0;
+	SmallString path(kDirectory);
+	int32 directoryLength = path.Length();
+
+	for (int32 i = 0; i < kNameCount; i++) {
+		path.Truncate(directoryLength);
+		path << '/' << kNames[i];
+		result += path.Length();
+	}
+	return result;
+}
+
+
+// The fields and values are views of the line, so nothing is copied.
+static uint32
+test_headers_view(int32 iteration)
+{
+	uint32 result = 0;
+	for (int32 i = 0; i < kHeaderCount; i++) {
+		StringView line(kHeaders[i]);
+		int32 colon = line.FindFirst(':');
+		if (colon < 0)
+			continue;
+
+		StringView field = line.Substring(0, colon);
+		StringView value = line.Substring(colon + 1).Trim();
+
+		if (field.ICompare("subject") == 0)
+			result += value.Length();
+		result += field.Length();
+	}
+	return result;
+}
+
+
+static uint32
+test_copies_small(int32 iteration)
+{
+	uint32 result = 0;
+	for (int32 i = 0; i < kNameCount; i++) {
+		SmallString name(kNames[i]);
+		name.CopyInto(sSmallCopy, 0, name.Length());
+		result += sSmallCopy.Length();
+
+		sSmallCopy.SetTo(name.Substring(0, name.Length() + 10));
+		result += sSmallCopy.Length();
+	}
+	return result;
+}
+
+
+static uint32
+test_adopt_small(int32 iteration)
+{
+	uint32 result = 0;
+	for (int32 i = 0; i < kNameCount; i++) {
+		SmallString source(kNames[i]);
+		sSmallTarget.Adopt(source);
+		result += sSmallTarget.Length() + source.Length();
+
+		SmallString copy(sSmallTarget);
+		copy.Truncate(0);
+		copy = "";
+		result += copy.Length();
+	}
+	return result;
+}
+
+
+// #pragma mark -
+
+
+static const benchmark_test kTests[] = {
+	{"empty", &test_empty, 200000},
+	{"empty small", &test_empty_small, 200000},
+	{"paths", &test_paths, 20000},
+	{"paths small", &test_paths_small, 20000},
+	{"headers", &test_headers, 20000},
+	{"headers view", &test_headers_view, 20000},
+	{"copies", &test_copies, 20000},
+	{"copies small", &test_copies_small, 20000},
+	{"adopt", &test_adopt, 20000},
+	{"adopt small", &test_adopt_small, 20000},
+	{NULL, NULL, 0}
+};
+
+
+int
+main(int argc, char** argv)
+{
+	Benchmark benchmark("string_benchmark", kTests, argc, argv);
+	benchmark.SetCounter("allocs", &allocation_count);
+	benchmark.Run();
+
+	return 0;
+}
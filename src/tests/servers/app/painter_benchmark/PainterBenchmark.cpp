@@ -0,0 +1,229 @@
+/*
+ * Copyright 2011, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Renders fills, gradients and bitmaps with the app_server Painter into a
+	MallocBuffer and reports the throughput of each drawing mode in
+	MPixels/s. No app_server is needed, which makes it easy to compare the
+	scalar and the SIMD code paths of the drawing modes (see --no-simd), and
+	the speedup of rendering large primitives in parallel bands (see
+	--threads).
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <new>
+
+#include <GradientLinear.h>
+#include <InterfaceDefs.h>
+#include <OS.h>
+#include <Region.h>
+
+#include "MallocBuffer.h"
+#include "Painter.h"
+#include "PainterSIMD.h"
+#include "PainterThreadPool.h"
+#include "ServerBitmap.h"
+
+
+static const uint32 kWidth = 1024;
+static const uint32 kHeight = 768;
+static const int32 kDefaultIterations = 50;
+
+
+enum {
+	TEST_FILL_RECT,
+	TEST_FILL_ELLIPSE,
+	TEST_FILL_GRADIENT,
+	TEST_DRAW_BITMAP,
+	TEST_DRAW_BITMAP_SCALED,
+	TEST_DRAW_BITMAP_BILINEAR
+};
+
+
+struct TestInfo {
+	const char*	name;
+	int32		test;
+};
+
+
+static const TestInfo kTests[] = {
+	{ "FillRect",				TEST_FILL_RECT },
+	{ "FillEllipse",			TEST_FILL_ELLIPSE },
+	{ "FillRect (gradient)",	TEST_FILL_GRADIENT },
+	{ "DrawBitmap",				TEST_DRAW_BITMAP },
+	{ "DrawBitmap (scaled)",	TEST_DRAW_BITMAP_SCALED },
+	{ "DrawBitmap (bilinear)",	TEST_DRAW_BITMAP_BILINEAR },
+};
+
+
+struct ModeInfo {
+	const char*		name;
+	drawing_mode	mode;
+};
+
+
+static const ModeInfo kModes[] = {
+	{ "B_OP_COPY",	B_OP_COPY },
+	{ "B_OP_OVER",	B_OP_OVER },
+	{ "B_OP_ALPHA",	B_OP_ALPHA },
+};
+
+
+static UtilityBitmap*
+create_test_bitmap(uint32 width, uint32 height)
+{
+	UtilityBitmap* bitmap = new(std::nothrow) UtilityBitmap(
+		BRect(0, 0, width - 1, height - 1), B_RGBA32, 0);
+	if (bitmap == NULL || bitmap->Bits() == NULL) {
+		if (bitmap != NULL)
+			bitmap->ReleaseReference();
+		return NULL;
+	}
+
+	// a color ramp with an alpha gradient that contains fully transparent,
+	// translucent and opaque pixels
+	for (uint32 y = 0; y < height; y++) {
+		uint8* bits = bitmap->Bits() + y * bitmap->BytesPerRow();
+		for (uint32 x = 0; x < width; x++) {
+			bits[0] = x * 255 / width;
+			bits[1] = y * 255 / height;
+			bits[2] = (x + y) & 0xff;
+			bits[3] = x < width / 4 ? 255 : (x * 7 + y) & 0xff;
+			bits += 4;
+		}
+	}
+
+	return bitmap;
+}
+
+
+static void
+run_test(Painter& painter, int32 test, const ServerBitmap* bitmap,
+	const BRect& bounds)
+{
+	switch (test) {
+		case TEST_FILL_RECT:
+			painter.FillRect(bounds);
+			break;
+		case TEST_FILL_ELLIPSE:
+			painter.DrawEllipse(bounds, true);
+			break;
+		case TEST_FILL_GRADIENT:
+		{
+			BGradientLinear gradient(bounds.LeftTop(), bounds.RightBottom());
+			gradient.AddColor((rgb_color){ 255, 0, 0, 255 }, 0);
+			gradient.AddColor((rgb_color){ 0, 0, 255, 64 }, 255);
+			painter.FillRect(bounds, gradient);
+			break;
+		}
+		case TEST_DRAW_BITMAP:
+			painter.DrawBitmap(bitmap, bitmap->Bounds(), bounds, 0);
+			break;
+		case TEST_DRAW_BITMAP_SCALED:
+			painter.DrawBitmap(bitmap, bitmap->Bounds().InsetByCopy(
+				bitmap->Width() / 4, bitmap->Height() / 4), bounds, 0);
+			break;
+		case TEST_DRAW_BITMAP_BILINEAR:
+			painter.DrawBitmap(bitmap, bitmap->Bounds().InsetByCopy(
+				bitmap->Width() / 4, bitmap->Height() / 4), bounds,
+				B_FILTER_BITMAP_BILINEAR);
+			break;
+	}
+}
+
+
+static void
+print_usage_and_exit(bool error)
+{
+	fprintf(error ? stderr : stdout,
+		"Usage: painter_benchmark [ --no-simd ] [ --threads <count> ]\n"
+		"           [ <iterations> ]\n"
+		"Renders into a %lux%lu B_RGBA32 buffer and prints the throughput of\n"
+		"the Painter drawing modes in MPixels/s.\n"
+		"  --no-simd            - Disable the SIMD code paths.\n"
+		"  --threads <count>    - Use <count> worker threads for rendering\n"
+		"                         large primitives in bands, 0 disables band\n"
+		"                         rendering. Defaults to one less than the\n"
+		"                         number of CPUs.\n",
+		kWidth, kHeight);
+	exit(error ? 1 : 0);
+}
+
+
+int
+main(int argc, const char* const* argv)
+{
+	int32 iterations = kDefaultIterations;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--no-simd") == 0) {
+			gPainterSIMDFlags = 0;
+		} else if (strcmp(argv[i], "--threads") == 0) {
+			if (++i >= argc || atol(argv[i]) < 0)
+				print_usage_and_exit(true);
+			PainterThreadPool::SetDefaultThreadCount(atol(argv[i]));
+		} else if (strcmp(argv[i], "-h") == 0
+			|| strcmp(argv[i], "--help") == 0) {
+			print_usage_and_exit(false);
+		} else if ((iterations = atol(argv[i])) <= 0) {
+			print_usage_and_exit(true);
+		}
+	}
+
+	MallocBuffer buffer(kWidth, kHeight);
+	UtilityBitmap* bitmap = create_test_bitmap(kWidth, kHeight);
+	if (buffer.InitCheck() != B_OK || bitmap == NULL) {
+		fprintf(stderr, "Failed to allocate the buffers\n");
+		return 1;
+	}
+
+	BRect bounds(0, 0, kWidth - 1, kHeight - 1);
+	BRegion clipping(bounds);
+
+	Painter painter;
+	painter.AttachToBuffer(&buffer);
+	painter.ConstrainClipping(&clipping);
+	painter.SetBlendingMode(B_PIXEL_ALPHA, B_ALPHA_OVERLAY);
+	painter.SetHighColor((rgb_color){ 50, 100, 200, 128 });
+	painter.SetLowColor((rgb_color){ 255, 255, 255, 255 });
+
+	PainterThreadPool* pool = PainterThreadPool::Default();
+	printf("SIMD flags: 0x%lx, %ld band threads, %ld iterations\n\n",
+		gPainterSIMDFlags, pool != NULL ? pool->CountThreads() : 0L,
+		iterations);
+	printf("%-24s", "");
+	for (size_t i = 0; i < sizeof(kModes) / sizeof(kModes[0]); i++)
+		printf("%14s", kModes[i].name);
+	printf("\n");
+
+	uint64 pixels = (uint64)kWidth * kHeight * iterations;
+
+	for (size_t i = 0; i < sizeof(kTests) / sizeof(kTests[0]); i++) {
+		printf("%-24s", kTests[i].name);
+		for (size_t j = 0; j < sizeof(kModes) / sizeof(kModes[0]); j++) {
+			painter.SetDrawingMode(kModes[j].mode);
+			memset(buffer.Bits(), 0x80, buffer.BytesPerRow() * kHeight);
+
+			// warm up caches and lazily initialized state
+			run_test(painter, kTests[i].test, bitmap, bounds);
+
+			bigtime_t startTime = system_time();
+			for (int32 k = 0; k < iterations; k++)
+				run_test(painter, kTests[i].test, bitmap, bounds);
+			bigtime_t elapsed = max_c(system_time() - startTime, 1);
+
+			printf("%14.1f", (double)pixels / elapsed);
+		}
+		printf("\n");
+	}
+
+	painter.DetachFromBuffer();
+	bitmap->ReleaseReference();
+	return 0;
+}
@@ -0,0 +1,437 @@
+/*
+ * Copyright 2011, Haiku, Inc.
+ * Distributed under the terms of the MIT License.
+ */
+
+// Draws a typical window update (background, text, some icons, and a bitmap
+// that changes every frame) with the RemoteDrawingEngine over a loopback
+// connection, and prints how many bytes each frame takes before and after
+// compression. The other end of the connection plays the part of RemoteView:
+// it keeps the bitmap cache, and checks that it stays in sync with the one of
+// the RemoteHWInterface. In the first run, it drops every bitmap right after
+// drawing it, like a client that fails to keep them, so that the bitmaps
+// have to be sent again for every frame.
+
+
+#include "NetReceiver.h"
+#include "NetSender.h"
+#include "RemoteBitmapCache.h"
+#include "RemoteDrawingEngine.h"
+#include "RemoteHWInterface.h"
+#include "RemoteMessage.h"
+#include "ServerBitmap.h"
+#include "StreamingRingBuffer.h"
+
+#include <Bitmap.h>
+#include <NetEndpoint.h>
+#include <OS.h>
+#include <Region.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+static const uint16 kClientPort = 10910;
+static const char* kClientTarget = "127.0.0.1:10910";
+static const int32 kWidth = 640;
+static const int32 kHeight = 480;
+static const int32 kFrameCount = 100;
+static const int32 kIconCount = 8;
+static const int32 kLineCount = 30;
+
+
+// TestClient
+class TestClient {
+public:
+								TestClient();
+								~TestClient();
+
+		status_t				Init();
+
+		void					SetDropBitmaps(bool drop)
+									{ fDropBitmaps = drop; }
+		void					ResetCounters();
+
+		int64					BytesReceived() const
+									{ return fReceiver->BytesReceived(); }
+		int64					BytesInflated() const
+									{ return fReceiver->BytesWritten(); }
+		int32					BitmapsSent() const
+									{ return fBitmapsSent; }
+		int32					BitmapsCached() const
+									{ return fBitmapsCached; }
+		int32					Errors() const
+									{ return fErrors; }
+
+private:
+static	status_t				_ThreadEntry(void* data);
+		status_t				_Thread();
+		void					_DrawCachedBitmap(RemoteMessage& message,
+									RemoteMessage& reply);
+
+		BNetEndpoint*			fListenEndpoint;
+		BNetEndpoint*			fSendEndpoint;
+		StreamingRingBuffer*	fReceiveBuffer;
+		StreamingRingBuffer*	fSendBuffer;
+		NetReceiver*			fReceiver;
+		NetSender*				fSender;
+		thread_id				fThread;
+
+		bool					fDropBitmaps;
+		BBitmap*				fBitmaps[RemoteBitmapCache::SLOT_COUNT];
+		uint64					fChecksums[RemoteBitmapCache::SLOT_COUNT];
+
+		int32					fBitmapsSent;
+		int32					fBitmapsCached;
+		int32					fErrors;
+};
+
+
+TestClient::TestClient()
+	:
+	fListenEndpoint(NULL),
+	fSendEndpoint(NULL),
+	fReceiveBuffer(NULL),
+	fSendBuffer(NULL),
+	fReceiver(NULL),
+	fSender(NULL),
+	fThread(-1),
+	fDropBitmaps(false),
+	fBitmapsSent(0),
+	fBitmapsCached(0),
+	fErrors(0)
+{
+	memset(fBitmaps, 0, sizeof(fBitmaps));
+	memset(fChecksums, 0, sizeof(fChecksums));
+}
+
+
+TestClient::~TestClient()
+{
+	// deleting the buffers lets the threads waiting on them quit
+	delete fReceiveBuffer;
+	delete fSendBuffer;
+	delete fReceiver;
+	delete fSender;
+
+	if (fThread >= 0) {
+		status_t result;
+		wait_for_thread(fThread, &result);
+	}
+
+	delete fListenEndpoint;
+	delete fSendEndpoint;
+
+	for (int32 i = 0; i < RemoteBitmapCache::SLOT_COUNT; i++)
+		delete fBitmaps[i];
+}
+
+
+status_t
+TestClient::Init()
+{
+	fReceiveBuffer = new StreamingRingBuffer(16 * 1024);
+	fSendBuffer = new StreamingRingBuffer(16 * 1024);
+	if (fReceiveBuffer->InitCheck() != B_OK
+		|| fSendBuffer->InitCheck() != B_OK) {
+		return B_NO_MEMORY;
+	}
+
+	fListenEndpoint = new BNetEndpoint();
+	status_t status = fListenEndpoint->Bind(kClientPort);
+	if (status != B_OK)
+		return status;
+
+	fSendEndpoint = new BNetEndpoint();
+	fReceiver = new NetReceiver(fListenEndpoint, fReceiveBuffer);
+	fSender = new NetSender(fSendEndpoint, fSendBuffer);
+
+	fThread = spawn_thread(&_ThreadEntry, "test client", B_NORMAL_PRIORITY,
+		this);
+	if (fThread < 0)
+		return fThread;
+
+	return resume_thread(fThread);
+}
+
+
+void
+TestClient::ResetCounters()
+{
+	fBitmapsSent = 0;
+	fBitmapsCached = 0;
+	fErrors = 0;
+}
+
+
+/*static*/ status_t
+TestClient::_ThreadEntry(void* data)
+{
+	return ((TestClient*)data)->_Thread();
+}
+
+
+status_t
+TestClient::_Thread()
+{
+	RemoteMessage reply(NULL, fSendBuffer);
+	RemoteMessage message(fReceiveBuffer, NULL);
+
+	while (true) {
+		uint16 code;
+		if (message.NextMessage(code) != B_OK)
+			break;
+
+		switch (code) {
+			case RP_INIT_CONNECTION:
+			{
+				uint16 port;
+				status_t status = message.Read(port);
+				if (status == B_OK)
+					status = fSendEndpoint->Connect("127.0.0.1", port);
+				if (status != B_OK) {
+					fprintf(stderr, "Could not connect to the server: %s\n",
+						strerror(status));
+					return status;
+				}
+
+				reply.Start(RP_UPDATE_DISPLAY_MODE);
+				reply.Add(kWidth);
+				reply.Add(kHeight);
+				reply.Flush();
+				break;
+			}
+
+			case RP_DRAW_STRING:
+			{
+				// the drawing engine waits for the pen location
+				uint32 token;
+				BPoint point;
+				message.Read(token);
+				if (message.Read(point) != B_OK) {
+					fErrors++;
+					break;
+				}
+
+				reply.Start(RP_DRAW_STRING_RESULT);
+				reply.Add(token);
+				reply.Add(point);
+				reply.Flush();
+				break;
+			}
+
+			case RP_DRAW_CACHED_BITMAP:
+				_DrawCachedBitmap(message, reply);
+				break;
+		}
+	}
+
+	return B_OK;
+}
+
+
+/*!	Does what RemoteView does with the message, but instead of drawing the
+	bitmap, it only checks that it has the right one.
+*/
+void
+TestClient::_DrawCachedBitmap(RemoteMessage& message, RemoteMessage& reply)
+{
+	uint32 token, options, slot;
+	BRect bitmapRect, viewRect;
+	uint64 checksum;
+	bool cached;
+
+	message.Read(token);
+	message.Read(bitmapRect);
+	message.Read(viewRect);
+	message.Read(options);
+	message.Read(slot);
+	message.Read(checksum);
+	if (message.Read(cached) != B_OK
+		|| slot >= RemoteBitmapCache::SLOT_COUNT) {
+		fErrors++;
+		return;
+	}
+
+	if (cached)
+		fBitmapsCached++;
+	else {
+		fBitmapsSent++;
+
+		delete fBitmaps[slot];
+		fBitmaps[slot] = NULL;
+		fChecksums[slot] = 0;
+
+		BBitmap* bitmap;
+		if (message.ReadBitmap(&bitmap) == B_OK && bitmap != NULL) {
+			fBitmaps[slot] = bitmap;
+			fChecksums[slot] = checksum;
+		}
+	}
+
+	if (fBitmaps[slot] == NULL || fChecksums[slot] != checksum) {
+		fErrors++;
+		return;
+	}
+
+	if (fDropBitmaps) {
+		delete fBitmaps[slot];
+		fBitmaps[slot] = NULL;
+		fChecksums[slot] = 0;
+
+		reply.Start(RP_DROP_CACHED_BITMAP);
+		reply.Add(slot);
+		reply.Add(checksum);
+		reply.Flush();
+	}
+}
+
+
+// #pragma mark -
+
+
+static UtilityBitmap*
+create_bitmap(int32 size, uint32 seed)
+{
+	UtilityBitmap* bitmap = new UtilityBitmap(
+		BRect(0, 0, size - 1, size - 1), B_RGBA32, 0);
+
+	uint32* bits = (uint32*)bitmap->Bits();
+	for (int32 y = 0; y < size; y++) {
+		for (int32 x = 0; x < size; x++) {
+			// some smooth shapes, like real icons
+			uint8 value = (uint8)((x * seed + y * 3) & 0xf0);
+			bits[y * size + x] = 0xff000000 | (value << 16) | (seed << 8)
+				| (255 - value);
+		}
+	}
+
+	return bitmap;
+}
+
+
+static void
+draw_bitmap(DrawingEngine* engine, UtilityBitmap* bitmap, BPoint where)
+{
+	BRect bounds = bitmap->Bounds();
+	engine->DrawBitmap(bitmap, bounds, bounds.OffsetToCopy(where), 0);
+}
+
+
+static void
+draw_frame(DrawingEngine* engine, UtilityBitmap** icons, int32 frame)
+{
+	engine->FillRect(BRect(0, 0, kWidth - 1, kHeight - 1),
+		make_color(216, 216, 216, 255));
+
+	for (int32 i = 0; i < kLineCount; i++) {
+		char line[64];
+		int32 length = snprintf(line, sizeof(line),
+			"Line %ld of the document, frame %ld", i, frame);
+		engine->DrawString(line, length, BPoint(10, 20 + i * 15), NULL);
+	}
+
+	for (int32 i = 0; i < kIconCount; i++)
+		draw_bitmap(engine, icons[i], BPoint(600, i * 40));
+
+	UtilityBitmap* changing = create_bitmap(64, frame + 100);
+	draw_bitmap(engine, changing, BPoint(500, 400));
+	delete changing;
+
+	// DrawString() waits for the client to answer, so once it returns, the
+	// client has seen the whole frame
+	engine->DrawString("done", 4, BPoint(10, kHeight - 10), NULL);
+}
+
+
+static bool
+run(const char* name, TestClient& client, bool dropBitmaps,
+	DrawingEngine* engine, UtilityBitmap** icons)
+{
+	client.SetDropBitmaps(dropBitmaps);
+	client.ResetCounters();
+
+	int64 bytesReceived = client.BytesReceived();
+	int64 bytesInflated = client.BytesInflated();
+
+	bigtime_t start = system_time();
+
+	for (int32 frame = 0; frame < kFrameCount; frame++)
+		draw_frame(engine, icons, frame);
+
+	bigtime_t time = system_time() - start;
+	bytesReceived = client.BytesReceived() - bytesReceived;
+	bytesInflated = client.BytesInflated() - bytesInflated;
+
+	printf("%-16s %8Ld bytes/frame raw, %8Ld on the wire (%.1f%%), "
+		"%Ld usecs/frame, %ld bitmaps sent, %ld cached, %ld cache errors\n",
+		name, bytesInflated / kFrameCount, bytesReceived / kFrameCount,
+		bytesInflated > 0 ? 100.0 * bytesReceived / bytesInflated : 0.0,
+		time / kFrameCount, client.BitmapsSent(), client.BitmapsCached(),
+		client.Errors());
+
+	if (client.Errors() != 0)
+		return false;
+
+	// a dropped bitmap must be sent again, a kept one must not
+	if (dropBitmaps)
+		return client.BitmapsCached() == 0;
+	return client.BitmapsCached() > 0;
+}
+
+
+int
+main(int argc, char** argv)
+{
+	TestClient client;
+	status_t status = client.Init();
+	if (status != B_OK) {
+		fprintf(stderr, "Could not start the client: %s\n", strerror(status));
+		return 1;
+	}
+
+	RemoteHWInterface* interface = new RemoteHWInterface(kClientTarget);
+	status = interface->Initialize();
+	if (status != B_OK) {
+		fprintf(stderr, "Could not connect to the client: %s\n",
+			strerror(status));
+		return 1;
+	}
+
+	DrawingEngine* engine = interface->CreateDrawingEngine();
+	if (engine == NULL) {
+		fprintf(stderr, "Could not create the drawing engine\n");
+		return 1;
+	}
+
+	UtilityBitmap* icons[kIconCount];
+	for (int32 i = 0; i < kIconCount; i++)
+		icons[i] = create_bitmap(32, i + 1);
+
+	bool passed = false;
+	if (engine->LockParallelAccess()) {
+		BRegion clipping(BRect(0, 0, kWidth - 1, kHeight - 1));
+		engine->ConstrainClippingRegion(&clipping);
+
+		passed = run("dropping client", client, true, engine, icons);
+		passed = run("caching client", client, false, engine, icons) && passed;
+
+		engine->UnlockParallelAccess();
+	}
+
+	for (int32 i = 0; i < kIconCount; i++)
+		delete icons[i];
+
+	delete engine;
+	interface->Shutdown();
+		// The interface is not deleted, as its event thread would not quit
+		// before the process exits.
+
+	if (!passed) {
+		fprintf(stderr, "The bitmap caches went out of sync\n");
+		return 1;
+	}
+
+	return 0;
+}
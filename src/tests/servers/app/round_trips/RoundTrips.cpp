@@ -0,0 +1,185 @@
+/*
+ * Copyright 2011, Haiku Inc.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+/*!	Redraws a view that draws like a typical list view (measuring, aligning
+	and drawing strings) a number of times, and prints how many times the
+	links to the app_server were flushed, and how many of these flushes were
+	round-trips waiting for a reply, per frame.
+*/
+
+
+#include <Application.h>
+#include <String.h>
+#include <View.h>
+#include <Window.h>
+
+#include <LinkSender.h>
+
+#include <math.h>
+#include <stdio.h>
+
+
+static const int32 kFrameCount = 200;
+static const int32 kRowCount = 40;
+
+
+class View : public BView {
+public:
+							View(BRect rect);
+
+	virtual void			Draw(BRect updateRect);
+
+private:
+			void			_PrintStatistics();
+
+			int32			fFrame;
+			bigtime_t		fStartTime;
+			int32			fStartFlushCount;
+			int32			fStartReplyCount;
+};
+
+
+class Window : public BWindow {
+public:
+							Window();
+
+	virtual bool			QuitRequested();
+};
+
+
+class Application : public BApplication {
+public:
+							Application();
+
+	virtual void			ReadyToRun();
+};
+
+
+View::View(BRect rect)
+	:
+	BView(rect, "round trips", B_FOLLOW_ALL, B_WILL_DRAW),
+	fFrame(0),
+	fStartTime(0),
+	fStartFlushCount(0),
+	fStartReplyCount(0)
+{
+}
+
+
+void
+View::Draw(BRect updateRect)
+{
+	if (fFrame == 0) {
+		fStartTime = system_time();
+		BPrivate::LinkSender::GetStatistics(&fStartFlushCount,
+			&fStartReplyCount);
+	}
+
+	BRect bounds = Bounds();
+	font_height fontHeight;
+	GetFontHeight(&fontHeight);
+	float rowHeight = ceilf(fontHeight.ascent + fontHeight.descent
+		+ fontHeight.leading) + 2;
+
+	for (int32 row = 0; row < kRowCount; row++) {
+		BRect rowFrame(bounds.left, row * rowHeight, bounds.right,
+			(row + 1) * rowHeight - 1);
+		if (!rowFrame.Intersects(updateRect))
+			continue;
+
+		SetHighColor(row % 2 == 0 ? 255 : 240, 255, 255);
+		FillRect(rowFrame);
+
+		BString label;
+		label << "Item " << row;
+		BString value;
+		value << (row * 1234 + fFrame) % 10000 << " KiB";
+
+		SetHighColor(0, 0, 0);
+		float baseline = rowFrame.bottom - fontHeight.descent - 1;
+		DrawString(label.String(), BPoint(rowFrame.left + 4, baseline));
+
+		// right aligned column
+		DrawString(value.String(), BPoint(rowFrame.right - 4
+			- StringWidth(value.String()), baseline));
+	}
+
+	if (++fFrame < kFrameCount)
+		Invalidate();
+	else if (fFrame == kFrameCount)
+		_PrintStatistics();
+}
+
+
+void
+View::_PrintStatistics()
+{
+	bigtime_t time = system_time() - fStartTime;
+	int32 flushCount;
+	int32 replyCount;
+	BPrivate::LinkSender::GetStatistics(&flushCount, &replyCount);
+
+	flushCount -= fStartFlushCount;
+	replyCount -= fStartReplyCount;
+
+	printf("%ld frames in %lld usecs (%.1f frames/s)\n", kFrameCount, time,
+		kFrameCount * 1000000.0 / time);
+	printf("  flushes per frame:     %.2f\n", (float)flushCount / kFrameCount);
+	printf("  round-trips per frame: %.2f\n", (float)replyCount / kFrameCount);
+
+	Window()->PostMessage(B_QUIT_REQUESTED);
+}
+
+
+//	#pragma mark -
+
+
+Window::Window()
+	:
+	BWindow(BRect(100, 100, 400, 100 + 40 * 16), "RoundTrips-Test",
+		B_TITLED_WINDOW, B_ASYNCHRONOUS_CONTROLS)
+{
+	AddChild(new View(Bounds()));
+}
+
+
+bool
+Window::QuitRequested()
+{
+	be_app->PostMessage(B_QUIT_REQUESTED);
+	return true;
+}
+
+
+//	#pragma mark -
+
+
+Application::Application()
+	:
+	BApplication("application/x-vnd.haiku-round_trips")
+{
+}
+
+
+void
+Application::ReadyToRun()
+{
+	Window* window = new Window();
+	window->Show();
+}
+
+
+//	#pragma mark -
+
+
+int
+main(int argc, char** argv)
+{
+	Application app;
+	app.Run();
+
+	return 0;
+}
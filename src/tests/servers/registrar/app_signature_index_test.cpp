@@ -0,0 +1,406 @@
+/*
+ * Copyright 2011, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+// Tests the registrar's AppSignatureIndex: lookups, eviction of the least
+// recently used entry, following the executables through node monitoring
+// messages, and dropping them when they are moved to the Trash.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <Autolock.h>
+#include <Directory.h>
+#include <Entry.h>
+#include <File.h>
+#include <FindDirectory.h>
+#include <Handler.h>
+#include <Looper.h>
+#include <Mime.h>
+#include <NodeMonitor.h>
+#include <OS.h>
+#include <Path.h>
+#include <Volume.h>
+
+#include "AppSignatureIndex.h"
+
+
+static const char* kTestDirectory = "/tmp/app_signature_index_test";
+static const char* kSignatureAttribute = "BEOS:APP_SIG";
+static const int32 kMaxIndexEntries = 128;
+	// the size of the index, as defined in AppSignatureIndex.cpp
+static const bigtime_t kMonitoringTimeout = 2000000;
+
+
+#define CHECK(condition)												\
+	do {																\
+		if (!(condition)) {												\
+			printf("%s:%d: check \"%s\" failed!\n", __FILE__, __LINE__,	\
+				#condition);											\
+			exit(1);													\
+		}																\
+	} while (false)
+
+
+// IndexHandler
+class IndexHandler : public BHandler {
+public:
+	IndexHandler(AppSignatureIndex& index, bool forward)
+		: BHandler("app signature index"),
+		  fIndex(index),
+		  fForward(forward)
+	{
+	}
+
+	virtual void MessageReceived(BMessage* message)
+	{
+		if (message->what == B_NODE_MONITOR) {
+			if (fForward)
+				fIndex.HandleNodeMonitorMessage(message);
+			return;
+		}
+
+		BHandler::MessageReceived(message);
+	}
+
+private:
+	AppSignatureIndex&	fIndex;
+	bool				fForward;
+};
+
+
+// create_app
+static
+entry_ref
+create_app(const char* name, const char* signature)
+{
+	BPath path(kTestDirectory, name);
+	BFile file(path.Path(), B_READ_WRITE | B_CREATE_FILE | B_ERASE_FILE);
+	CHECK(file.InitCheck() == B_OK);
+	CHECK(file.WriteAttr(kSignatureAttribute, B_MIME_STRING_TYPE, 0,
+		signature, strlen(signature) + 1) == (ssize_t)strlen(signature) + 1);
+
+	entry_ref ref;
+	CHECK(get_ref_for_path(path.Path(), &ref) == B_OK);
+	return ref;
+}
+
+
+// app_signature
+static
+const char*
+app_signature(int32 index)
+{
+	static char signature[B_MIME_TYPE_LENGTH];
+	snprintf(signature, sizeof(signature),
+		"application/x-vnd.haiku-index-test-%ld", index);
+	return signature;
+}
+
+
+// wait_for_lookup
+//! Waits for the node monitoring to change what \a signature resolves to.
+static
+status_t
+wait_for_lookup(BLooper* looper, AppSignatureIndex& index,
+	const char* signature, const entry_ref& previous, entry_ref* _ref)
+{
+	bigtime_t timeout = system_time() + kMonitoringTimeout;
+	status_t status;
+	do {
+		snooze(10000);
+		BAutolock _(looper);
+		status = index.Get(signature, _ref);
+		if (status != B_OK || *_ref != previous)
+			return status;
+	} while (system_time() < timeout);
+
+	return status;
+}
+
+
+// test_lookup
+static
+void
+test_lookup(BLooper* looper, AppSignatureIndex& index)
+{
+	BAutolock _(looper);
+	index.Clear();
+
+	entry_ref ref = create_app("app", "application/x-vnd.Haiku-Index-Test");
+	index.Put("application/x-vnd.Haiku-Index-Test", ref);
+	CHECK(index.CountEntries() == 1);
+
+	// signatures are case insensitive
+	entry_ref found;
+	CHECK(index.Get("application/x-vnd.Haiku-Index-Test", &found) == B_OK);
+	CHECK(found == ref);
+	CHECK(index.Get("APPLICATION/X-VND.HAIKU-INDEX-TEST", &found) == B_OK);
+	CHECK(found == ref);
+	CHECK(index.Get("application/x-vnd.haiku-other", &found)
+		== B_ENTRY_NOT_FOUND);
+	CHECK(index.Get(NULL, &found) == B_BAD_VALUE);
+
+	// an executable with another signature is not added
+	entry_ref other = create_app("other", "application/x-vnd.haiku-other");
+	index.Put("application/x-vnd.haiku-not-other", other);
+	CHECK(index.Get("application/x-vnd.haiku-not-other", &found)
+		== B_ENTRY_NOT_FOUND);
+	CHECK(index.CountEntries() == 1);
+
+	// another executable replaces the entry for the signature
+	index.Put("application/x-vnd.haiku-other", other);
+	CHECK(index.CountEntries() == 2);
+	entry_ref copy = create_app("copy", "application/x-vnd.Haiku-Index-Test");
+	index.Put("application/x-vnd.haiku-index-test", copy);
+	CHECK(index.Get("application/x-vnd.Haiku-Index-Test", &found) == B_OK);
+	CHECK(found == copy);
+	CHECK(index.CountEntries() == 2);
+
+	index.Remove("application/x-vnd.HAIKU-index-test");
+	CHECK(index.Get("application/x-vnd.haiku-index-test", &found)
+		== B_ENTRY_NOT_FOUND);
+	CHECK(index.CountEntries() == 1);
+
+	printf("Lookups work\n");
+}
+
+
+// test_eviction
+static
+void
+test_eviction(BLooper* looper, AppSignatureIndex& index)
+{
+	BAutolock _(looper);
+	index.Clear();
+
+	entry_ref refs[kMaxIndexEntries + 1];
+	for (int32 i = 0; i <= kMaxIndexEntries; i++) {
+		char name[32];
+		snprintf(name, sizeof(name), "app%ld", i);
+		refs[i] = create_app(name, app_signature(i));
+	}
+
+	for (int32 i = 0; i < kMaxIndexEntries; i++) {
+		index.Put(app_signature(i), refs[i]);
+		snooze(100);
+	}
+	CHECK(index.CountEntries() == kMaxIndexEntries);
+
+	// use the oldest entry, so that the second one is evicted instead
+	entry_ref found;
+	CHECK(index.Get(app_signature(0), &found) == B_OK);
+	snooze(100);
+
+	index.Put(app_signature(kMaxIndexEntries), refs[kMaxIndexEntries]);
+	CHECK(index.CountEntries() == kMaxIndexEntries);
+	CHECK(index.Get(app_signature(kMaxIndexEntries), &found) == B_OK);
+	CHECK(index.Get(app_signature(0), &found) == B_OK);
+	CHECK(index.Get(app_signature(1), &found) == B_ENTRY_NOT_FOUND);
+	CHECK(index.Get(app_signature(2), &found) == B_OK);
+
+	index.Clear();
+	CHECK(index.CountEntries() == 0);
+
+	printf("The least recently used entry is evicted\n");
+}
+
+
+// test_monitoring
+static
+void
+test_monitoring(BLooper* looper, AppSignatureIndex& index)
+{
+	const char* signature = "application/x-vnd.haiku-index-test-monitoring";
+	entry_ref ref;
+	entry_ref found;
+
+	// moves are followed
+	{
+		BAutolock _(looper);
+		index.Clear();
+		ref = create_app("monitored", signature);
+		index.Put(signature, ref);
+		CHECK(index.CountEntries() == 1);
+	}
+
+	BEntry entry(&ref);
+	CHECK(entry.Rename("moved") == B_OK);
+	CHECK(wait_for_lookup(looper, index, signature, ref, &found) == B_OK);
+	CHECK(strcmp(found.name, "moved") == 0);
+	CHECK(found.directory == ref.directory);
+	ref = found;
+
+	// so are moves to other directories
+	BPath subPath(kTestDirectory, "sub");
+	CHECK(create_directory(subPath.Path(), 0755) == B_OK);
+	BDirectory subDirectory(subPath.Path());
+	CHECK(subDirectory.InitCheck() == B_OK);
+	CHECK(entry.MoveTo(&subDirectory) == B_OK);
+	CHECK(wait_for_lookup(looper, index, signature, ref, &found) == B_OK);
+	CHECK(strcmp(found.name, "moved") == 0);
+	CHECK(found.directory != ref.directory);
+	ref = found;
+
+	// other attributes don't matter, changing the signature does
+	{
+		BNode node(&ref);
+		CHECK(node.WriteAttr("test:other", B_STRING_TYPE, 0, "x", 2) == 2);
+	}
+	snooze(100000);
+	{
+		BAutolock _(looper);
+		CHECK(index.Get(signature, &found) == B_OK);
+	}
+	{
+		BNode node(&ref);
+		const char* newSignature = "application/x-vnd.haiku-index-test-new";
+		CHECK(node.WriteAttr(kSignatureAttribute, B_MIME_STRING_TYPE, 0,
+			newSignature, strlen(newSignature) + 1)
+				== (ssize_t)strlen(newSignature) + 1);
+	}
+	CHECK(wait_for_lookup(looper, index, signature, ref, &found)
+		== B_ENTRY_NOT_FOUND);
+
+	// removing the executable removes the entry
+	{
+		BAutolock _(looper);
+		ref = create_app("removed", signature);
+		index.Put(signature, ref);
+		CHECK(index.Get(signature, &found) == B_OK);
+	}
+	entry.SetTo(&ref);
+	CHECK(entry.Remove() == B_OK);
+	CHECK(wait_for_lookup(looper, index, signature, ref, &found)
+		== B_ENTRY_NOT_FOUND);
+	{
+		BAutolock _(looper);
+		CHECK(index.CountEntries() == 0);
+	}
+
+	printf("Moved, removed, and changed executables are followed\n");
+}
+
+
+// test_trash
+static
+void
+test_trash(BLooper* looper, AppSignatureIndex& index)
+{
+	const char* signature = "application/x-vnd.haiku-index-test-trash";
+	entry_ref ref;
+	entry_ref found;
+
+	{
+		BAutolock _(looper);
+		index.Clear();
+		ref = create_app("trashed", signature);
+		index.Put(signature, ref);
+		CHECK(index.Get(signature, &found) == B_OK);
+	}
+
+	BVolume volume(ref.device);
+	BPath trashPath;
+	CHECK(find_directory(B_TRASH_DIRECTORY, &trashPath, true, &volume)
+		== B_OK);
+	BDirectory trash(trashPath.Path());
+	CHECK(trash.InitCheck() == B_OK);
+
+	// moving the executable to the Trash drops it, as BRoster wouldn't
+	// launch it from there
+	BEntry entry(&ref);
+	CHECK(entry.MoveTo(&trash, "app_signature_index_test trashed", true)
+		== B_OK);
+	CHECK(wait_for_lookup(looper, index, signature, ref, &found)
+		== B_ENTRY_NOT_FOUND);
+
+	// and it isn't added again while it is in there
+	CHECK(entry.GetRef(&ref) == B_OK);
+	{
+		BAutolock _(looper);
+		CHECK(index.CountEntries() == 0);
+		index.Put(signature, ref);
+		CHECK(index.Get(signature, &found) == B_ENTRY_NOT_FOUND);
+		CHECK(index.CountEntries() == 0);
+	}
+
+	CHECK(entry.Remove() == B_OK);
+
+	printf("Executables in the Trash are dropped\n");
+}
+
+
+// test_stale_entries
+static
+void
+test_stale_entries(BLooper* looper, AppSignatureIndex& index)
+{
+	// The index doesn't get to see the node monitoring messages here, like
+	// when it misses the removal, because the volume went away.
+	BAutolock _(looper);
+	index.Clear();
+
+	const char* signature = "application/x-vnd.haiku-index-test-stale";
+	entry_ref ref = create_app("stale", signature);
+	index.Put(signature, ref);
+	CHECK(index.CountEntries() == 1);
+
+	BEntry entry(&ref);
+	CHECK(entry.Remove() == B_OK);
+
+	entry_ref found;
+	CHECK(index.Get(signature, &found) == B_ENTRY_NOT_FOUND);
+	CHECK(index.CountEntries() == 0);
+
+	printf("Stale entries are dropped\n");
+}
+
+
+int
+main()
+{
+	BPath path(kTestDirectory);
+	BEntry directory(path.Path());
+	if (directory.Exists()) {
+		char command[B_PATH_NAME_LENGTH + 16];
+		snprintf(command, sizeof(command), "rm -rf %s", kTestDirectory);
+		system(command);
+	}
+	CHECK(create_directory(kTestDirectory, 0755) == B_OK);
+
+	BLooper* looper = new BLooper("app signature index test");
+	AppSignatureIndex index;
+	IndexHandler* handler = new IndexHandler(index, true);
+	looper->AddHandler(handler);
+	looper->Run();
+
+	AppSignatureIndex staleIndex;
+	IndexHandler* staleHandler = new IndexHandler(staleIndex, false);
+
+	{
+		BAutolock _(looper);
+		looper->AddHandler(staleHandler);
+		index.SetTarget(BMessenger(handler));
+		staleIndex.SetTarget(BMessenger(staleHandler));
+	}
+
+	test_lookup(looper, index);
+	test_eviction(looper, index);
+	test_monitoring(looper, index);
+	test_trash(looper, index);
+	test_stale_entries(looper, staleIndex);
+
+	looper->Lock();
+	index.Clear();
+	staleIndex.Clear();
+	looper->Quit();
+
+	char command[B_PATH_NAME_LENGTH + 16];
+	snprintf(command, sizeof(command), "rm -rf %s", kTestDirectory);
+	system(command);
+
+	printf("All tests passed\n");
+	return 0;
+}
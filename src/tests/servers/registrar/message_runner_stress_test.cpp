@@ -0,0 +1,230 @@
+/*
+ * Copyright 2011, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+// Creates many message runners at once and checks how many of their messages
+// arrive, to test the registrar's MessageRunnerManager under load. Before that,
+// it runs the registrar's TimerWheel over a few simulated days.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <Application.h>
+#include <Message.h>
+#include <MessageRunner.h>
+#include <OS.h>
+
+#include "TimerWheel.h"
+
+
+static const uint32 kRunnerMessage = 'runn';
+static const uint32 kQuitMessage = 'quit';
+static const int32 kDefaultRunnerCount = 2000;
+static const bigtime_t kDefaultDuration = 5000000;
+static const bigtime_t kMinInterval = 50000;
+static const bigtime_t kMaxInterval = 1000000;
+
+
+// registrar_cpu_time
+static
+bigtime_t
+registrar_cpu_time()
+{
+	team_info teamInfo;
+	int32 teamCookie = 0;
+	while (get_next_team_info(&teamCookie, &teamInfo) == B_OK) {
+		if (strstr(teamInfo.args, "registrar") == NULL)
+			continue;
+
+		bigtime_t time = 0;
+		thread_info threadInfo;
+		int32 threadCookie = 0;
+		while (get_next_thread_info(teamInfo.team, &threadCookie, &threadInfo)
+				== B_OK) {
+			if (strcmp(threadInfo.name, "timer_thread") == 0)
+				time += threadInfo.user_time + threadInfo.kernel_time;
+		}
+		return time;
+	}
+
+	return -1;
+}
+
+
+// check_timer_wheel_overflow
+static
+bool
+check_timer_wheel_overflow()
+{
+	// the resolution the registrar uses by default
+	const bigtime_t resolution = 5000;
+	TimerWheel wheel(resolution);
+
+	// this is beyond the range of the wheel's levels, so it lands in the
+	// overflow list
+	bigtime_t start = system_time();
+	TimerWheelEntry entry;
+	wheel.Add(&entry, start + 48LL * 3600 * 1000000);
+
+	// pass the point where the overflow list is looked at again
+	TimerWheelEntryList due;
+	wheel.CollectDue(start + ((1LL << 24) + 10) * resolution, due);
+	if (!due.IsEmpty() || !entry.IsScheduled()) {
+		printf("Timer wheel: entry became due too early\n");
+		return false;
+	}
+
+	bigtime_t nextTime = wheel.NextTime();
+	if (nextTime < entry.Time() || nextTime >= entry.Time() + resolution) {
+		printf("Timer wheel: wrong next time %lld, expected %lld\n", nextTime,
+			entry.Time());
+		return false;
+	}
+
+	wheel.CollectDue(nextTime, due);
+	if (due.Head() != &entry || entry.IsScheduled()
+		|| wheel.CountEntries() != 0) {
+		printf("Timer wheel: entry did not become due\n");
+		return false;
+	}
+
+	printf("Timer wheel: overflow entries are due in time\n");
+	return true;
+}
+
+
+// TestApp
+class TestApp : public BApplication {
+public:
+	TestApp(int32 runnerCount, bigtime_t duration)
+		: BApplication("application/x-vnd.haiku.message_runner_stress_test"),
+		  fRunners(NULL),
+		  fRunnerCount(runnerCount),
+		  fDuration(duration),
+		  fStartTime(0),
+		  fStartCPUTime(0),
+		  fExpected(0),
+		  fReceived(0)
+	{
+	}
+
+	~TestApp()
+	{
+		if (fRunners != NULL) {
+			for (int32 i = 0; i < fRunnerCount; i++)
+				delete fRunners[i];
+			delete[] fRunners;
+		}
+	}
+
+	virtual void ReadyToRun()
+	{
+		fRunners = new BMessageRunner*[fRunnerCount];
+		fStartCPUTime = registrar_cpu_time();
+		fStartTime = system_time();
+
+		for (int32 i = 0; i < fRunnerCount; i++) {
+			// spread the intervals, so that the runners are rarely due at
+			// exactly the same time
+			bigtime_t interval = kMinInterval
+				+ (kMaxInterval - kMinInterval) * i / fRunnerCount;
+			BMessage message(kRunnerMessage);
+			message.AddInt64("interval", interval);
+
+			fRunners[i] = new BMessageRunner(be_app_messenger, &message,
+				interval);
+			if (fRunners[i]->InitCheck() != B_OK) {
+				printf("Failed to create runner %ld: %s\n", i,
+					strerror(fRunners[i]->InitCheck()));
+				exit(1);
+			}
+
+			fExpected += fDuration / interval;
+		}
+
+		printf("Created %ld runners in %lld usecs\n", fRunnerCount,
+			system_time() - fStartTime);
+
+		BMessage quit(kQuitMessage);
+		BMessageRunner::StartSending(be_app_messenger, &quit, fDuration, 1);
+	}
+
+	virtual void MessageReceived(BMessage *message)
+	{
+		switch (message->what) {
+			case kRunnerMessage:
+			{
+				fReceived++;
+				break;
+			}
+
+			case kQuitMessage:
+			{
+				bigtime_t cpuTime = registrar_cpu_time();
+
+				// delete the runners before looking at the counts, so that
+				// the deletion is measured as well
+				bigtime_t deleteStart = system_time();
+				for (int32 i = 0; i < fRunnerCount; i++) {
+					delete fRunners[i];
+					fRunners[i] = NULL;
+				}
+				bigtime_t deleteTime = system_time() - deleteStart;
+
+				printf("Received %lld of about %lld messages in %lld usecs\n",
+					fReceived, fExpected, system_time() - fStartTime);
+				printf("Deleted %ld runners in %lld usecs\n", fRunnerCount,
+					deleteTime);
+				if (cpuTime >= 0 && fStartCPUTime >= 0) {
+					printf("Registrar timer thread CPU time: %lld usecs\n",
+						cpuTime - fStartCPUTime);
+				}
+
+				Quit();
+				break;
+			}
+
+			default:
+				BApplication::MessageReceived(message);
+				break;
+		}
+	}
+
+private:
+	BMessageRunner	**fRunners;
+	int32			fRunnerCount;
+	bigtime_t		fDuration;
+	bigtime_t		fStartTime;
+	bigtime_t		fStartCPUTime;
+	int64			fExpected;
+	int64			fReceived;
+};
+
+
+// main
+int
+main(int argc, const char *const *argv)
+{
+	int32 runnerCount = kDefaultRunnerCount;
+	bigtime_t duration = kDefaultDuration;
+	if (argc > 1)
+		runnerCount = atol(argv[1]);
+	if (argc > 2)
+		duration = atoll(argv[2]) * 1000000LL;
+
+	if (runnerCount <= 0 || duration <= 0) {
+		fprintf(stderr, "Usage: %s [ <runner count> [ <seconds> ] ]\n",
+			argv[0]);
+		return 1;
+	}
+
+	if (!check_timer_wheel_overflow())
+		return 1;
+
+	TestApp app(runnerCount, duration);
+	app.Run();
+
+	return 0;
+}